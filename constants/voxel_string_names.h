@@ -78,7 +78,7 @@ public:
 #endif
 
 	StringName _rpc_receive_blocks;
-	StringName _rpc_receive_area;
+	StringName _rpc_receive_block_diffs;
 
 	StringName unnamed;
 	StringName air;
@@ -104,6 +104,8 @@ public:
 
 	StringName _on_async_search_completed;
 	StringName async_search_completed;
+	StringName _on_async_batch_search_completed;
+	StringName async_batch_search_completed;
 
 	StringName file_selected;
 };
@@ -1,13 +1,18 @@
 #include "funcs.h"
+#include "../engine/parallel_for.h"
 #include "../meshers/blocky/voxel_blocky_library_base.h"
 #include "../storage/voxel_data.h"
 #include "../util/containers/dynamic_bitset.h"
 #include "../util/containers/span.h"
 #include "../util/containers/std_vector.h"
+#include "../util/godot/core/packed_arrays.h"
 #include "../util/godot/core/random_pcg.h"
+#include "../util/hash_funcs.h"
 #include "../util/profiling.h"
 #include "../util/string/format.h"
 
+#include <algorithm>
+
 #ifdef ZN_GODOT_EXTENSION
 using namespace godot;
 #endif
@@ -196,7 +201,7 @@ void run_blocky_random_tick(
 					const uint64_t v = voxels.get_voxel(0, 0, 0, channel);
 					if (lib_data.has_model(v)) {
 						const VoxelBlockyModel::BakedData &vt = lib_data.models[v];
-						if (vt.is_random_tickable) {
+						if (!vt.is_random_tickable) {
 							// Skip whole block
 							continue;
 						}
@@ -285,6 +290,183 @@ void run_blocky_random_tick(
 	);
 }
 
+void run_blocky_random_tick_per_block(
+		const VoxelData &data,
+		Box3i voxel_box,
+		const VoxelBlockyLibraryBase &lib,
+		const uint64_t seed,
+		const unsigned int voxels_per_block,
+		StdVector<Vector3i> &out_positions,
+		StdVector<uint32_t> &out_values
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(math::is_valid_size(voxel_box.size));
+
+	voxel_box.clip(data.get_bounds());
+	if (voxels_per_block == 0 || voxel_box.is_empty()) {
+		return;
+	}
+
+	const VoxelBlockyLibraryBase::BakedData &lib_data = lib.get_baked_data();
+
+	// Summary bits of all tickable models, to compare with summaries of blocks
+	uint64_t tickable_summary = 0;
+	for (unsigned int model_index = 0; model_index < lib_data.models.size(); ++model_index) {
+		if (lib_data.models[model_index].is_random_tickable) {
+			tickable_summary |= uint64_t(1) << (model_index & 63);
+		}
+	}
+	if (tickable_summary == 0) {
+		return;
+	}
+
+	const unsigned int block_size_po2 = data.get_block_size_po2();
+	const int block_size = 1 << block_size_po2;
+	const Box3i blocks_box = voxel_box.downscaled(block_size);
+	const float block_volume = math::cubed(block_size);
+
+	// Only loaded blocks can have something to tick. The box can be much larger than what is loaded (or even span the
+	// whole world), so we don't allocate anything per block of the box.
+	StdVector<Vector3i> block_positions;
+	data.get_loaded_blocks(blocks_box, 0, block_positions);
+	if (block_positions.size() == 0) {
+		return;
+	}
+	// Loaded blocks may come in no particular order, sort them (ZXY) so results are deterministic
+	std::sort(block_positions.begin(), block_positions.end(), [](const Vector3i &a, const Vector3i &b) {
+		if (a.z != b.z) {
+			return a.z < b.z;
+		}
+		if (a.x != b.x) {
+			return a.x < b.x;
+		}
+		return a.y < b.y;
+	});
+	const size_t block_count = block_positions.size();
+
+	struct Pick {
+		Vector3i position;
+		uint32_t value;
+	};
+
+	// Each block writes its picks in its own slot, so results are the same regardless of which thread processed which
+	// block
+	StdVector<Pick> picks;
+	picks.resize(block_count * static_cast<size_t>(voxels_per_block));
+	StdVector<unsigned int> pick_counts;
+	pick_counts.resize(block_count, 0);
+
+	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_TYPE;
+	SpatialLock3D &spatial_lock = data.get_spatial_lock(0);
+
+	auto process_blocks = [&](const unsigned int begin, const unsigned int end) {
+		ZN_PROFILE_SCOPE_NAMED("Blocks");
+
+		for (unsigned int block_index = begin; block_index < end; ++block_index) {
+			const Vector3i block_pos = block_positions[block_index];
+
+			SpatialLock3D::Read srlock(spatial_lock, BoxBounds3i::from_position(block_pos));
+
+			uint64_t type_summary;
+			std::shared_ptr<VoxelBuffer> voxels_ptr =
+					data.try_get_block_voxels_and_type_summary(block_pos, type_summary);
+
+			// Blocks may have been unloaded since we listed them, and most loaded blocks (air, stone...) contain no
+			// tickable models, so they get skipped without sampling
+			if (voxels_ptr == nullptr || (type_summary & tickable_summary) == 0) {
+				continue;
+			}
+			const VoxelBuffer &voxels = *voxels_ptr;
+
+			const Vector3i block_origin = block_pos << block_size_po2;
+			const Box3i local_voxel_box = voxel_box.clipped(Box3i(block_origin, Vector3iUtil::create(block_size)));
+			const Vector3i local_size = local_voxel_box.size;
+			const float volume_ratio = Vector3iUtil::get_volume(local_size) / block_volume;
+			const unsigned int sample_count = Math::ceil(voxels_per_block * volume_ratio);
+
+			// Seeded per block so the outcome doesn't depend on the order blocks are processed in
+			RandomPCG random(hash_djb2_one_64(Vector3iHasher::hash(block_pos), seed));
+
+			Pick *block_picks = &picks[block_index * static_cast<size_t>(voxels_per_block)];
+			unsigned int pick_count = 0;
+
+			for (unsigned int i = 0; i < sample_count; ++i) {
+				const Vector3i pos = local_voxel_box.position +
+						Vector3i(random.rand(local_size.x), random.rand(local_size.y), random.rand(local_size.z));
+				const uint64_t v = voxels.get_voxel(pos - block_origin, channel);
+
+				if (lib_data.has_model(v) && lib_data.models[v].is_random_tickable) {
+					block_picks[pick_count] = Pick{ pos, static_cast<uint32_t>(v) };
+					++pick_count;
+				}
+			}
+
+			pick_counts[block_index] = pick_count;
+		}
+	};
+
+	parallel_for_ranges(static_cast<unsigned int>(block_count), 4, process_blocks);
+
+	ZN_PROFILE_SCOPE_NAMED("Collect");
+
+	for (size_t block_index = 0; block_index < block_count; ++block_index) {
+		const unsigned int pick_count = pick_counts[block_index];
+		const Pick *block_picks = &picks[block_index * static_cast<size_t>(voxels_per_block)];
+
+		for (unsigned int i = 0; i < pick_count; ++i) {
+			const Pick &pick = block_picks[i];
+			out_positions.push_back(pick.position);
+			out_values.push_back(pick.value);
+		}
+	}
+}
+
+void run_blocky_random_tick_per_block(
+		const VoxelData &data,
+		AABB voxel_box_f,
+		const VoxelBlockyLibraryBase &lib,
+		const uint64_t seed,
+		const unsigned int voxels_per_block,
+		const Callable &callback
+) {
+	const Box3i voxel_box(math::floor_to_int(voxel_box_f.position), math::floor_to_int(voxel_box_f.size));
+
+	StdVector<Vector3i> positions;
+	StdVector<uint32_t> values;
+	run_blocky_random_tick_per_block(data, voxel_box, lib, seed, voxels_per_block, positions, values);
+
+	if (positions.size() == 0) {
+		return;
+	}
+
+	PackedVector3Array positions_array;
+	PackedInt32Array values_array;
+	positions_array.resize(positions.size());
+	values_array.resize(values.size());
+	{
+		Vector3 *positions_w = positions_array.ptrw();
+		int32_t *values_w = values_array.ptrw();
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			positions_w[i] = positions[i];
+			values_w[i] = values[i];
+		}
+	}
+
+	// Scripts get all picks in a single call, which is much cheaper than one call per voxel
+#ifdef ZN_GODOT
+	const Variant positions_v = positions_array;
+	const Variant values_v = values_array;
+	const Variant *args[2] = { &positions_v, &values_v };
+	Callable::CallError error;
+	Variant retval; // We don't care about the return value, Callable API requires it
+	callback.callp(args, 2, retval, error);
+	ERR_FAIL_COND(error.error != Callable::CallError::CALL_OK);
+#elif ZN_GODOT_EXTENSION
+	// TODO GDX: No way to detect or report errors when calling a Callable. Do I need to?
+	callback.call(positions_array, values_array);
+#endif
+}
+
 bool indices_to_bitarray_u16(Span<const int32_t> indices, DynamicBitset &bitarray) {
 #ifdef DEBUG_ENABLED
 	const int32_t max_supported_value = 65535;
@@ -394,15 +576,18 @@ void box_blur_slow_ref(const VoxelBuffer &src, VoxelBuffer &dst, int radius, Vec
 
 #endif
 
-void box_blur(const VoxelBuffer &src, VoxelBuffer &dst, int radius, Vector3f sphere_pos, float sphere_radius) {
-	ZN_PROFILE_SCOPE();
-	ZN_ASSERT_RETURN(radius >= 1);
+namespace {
 
-	const Vector3i dst_size = src.get_size() - Vector3i(radius, radius, radius) * 2;
-
-	ZN_ASSERT_RETURN(dst_size.x >= 0);
-	ZN_ASSERT_RETURN(dst_size.y >= 0);
-	ZN_ASSERT_RETURN(dst_size.z >= 0);
+// Works with any depth, but converts every voxel to float.
+void box_blur_generic(
+		const VoxelBuffer &src,
+		VoxelBuffer &dst,
+		const Vector3i dst_size,
+		const int radius,
+		const Vector3f sphere_pos,
+		const float sphere_radius
+) {
+	ZN_PROFILE_SCOPE();
 
 	dst.create(dst_size);
 
@@ -596,15 +781,199 @@ void box_blur(const VoxelBuffer &src, VoxelBuffer &dst, int radius, Vector3f sph
 	}
 }
 
-void grow_sphere(VoxelBuffer &src, float strength, Vector3f sphere_pos, float sphere_radius) {
+// Raw 16-bit SDF values are proportional to distances, so they can be averaged without decoding them.
+// -32768 decodes to the same value as -32767, so it gets clamped to not bias sums.
+inline int16_t get_clamped_s16(const int16_t v) {
+	return math::max(v, static_cast<int16_t>(-32767));
+}
+
+// Specialized version for 16-bit SDF. Sums are computed in three 1-D passes, each moving a window by one voxel at a
+// time. The Y pass runs along contiguous columns. The X and Z passes process whole rows or planes at once, which the
+// compiler can vectorize. Sums are integers, so they are exact and don't drift as windows move. They are 64-bit
+// because a 3D window of the largest radius can exceed 32-bit. Voxels outside of the sphere keep their original value.
+void box_blur_sdf16(
+		const VoxelBuffer &src,
+		VoxelBuffer &dst,
+		const Vector3i dst_size,
+		const int radius,
+		const Vector3f sphere_pos,
+		const float sphere_radius,
+		Box3i &out_changed_box
+) {
 	ZN_PROFILE_SCOPE();
-	ZN_ASSERT_RETURN(sphere_radius > 0.001f);
 
+	const unsigned int channel = VoxelBuffer::CHANNEL_SDF;
 	const Vector3i src_size = src.get_size();
 
-	ZN_ASSERT_RETURN(src_size.x >= 0);
-	ZN_ASSERT_RETURN(src_size.y >= 0);
-	ZN_ASSERT_RETURN(src_size.z >= 0);
+	out_changed_box = Box3i();
+
+	dst.create(dst_size);
+	dst.set_channel_depth(channel, VoxelBuffer::DEPTH_16_BIT);
+
+	if (src.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_UNIFORM) {
+		// Averaging a single value gives the same value
+		dst.fill(src.get_voxel(Vector3i(), channel), channel);
+		return;
+	}
+
+	Span<const int16_t> src_sd;
+	ZN_ASSERT_RETURN(src.get_channel_data_read_only(channel, src_sd));
+
+	dst.decompress_channel(channel);
+	Span<int16_t> dst_sd;
+	ZN_ASSERT_RETURN(dst.get_channel_data(channel, dst_sd));
+
+	const int box_size = radius * 2 + 1;
+
+	// Sums along Y, covering the source in X and Z
+	const Vector3i sum_y_size(src_size.x, dst_size.y, src_size.z);
+	StdVector<int64_t> sum_y;
+	sum_y.resize(Vector3iUtil::get_volume(sum_y_size));
+	{
+		ZN_PROFILE_SCOPE_NAMED("Y blur");
+		const unsigned int column_count = src_size.x * src_size.z;
+		for (unsigned int column_index = 0; column_index < column_count; ++column_index) {
+			const int16_t *src_column = src_sd.data() + column_index * src_size.y;
+			int64_t *sum_column = sum_y.data() + column_index * sum_y_size.y;
+
+			int64_t sum = 0;
+			for (int y = 0; y < box_size; ++y) {
+				sum += get_clamped_s16(src_column[y]);
+			}
+			sum_column[0] = sum;
+
+			for (int y = 1; y < sum_y_size.y; ++y) {
+				sum += get_clamped_s16(src_column[y + 2 * radius]) - get_clamped_s16(src_column[y - 1]);
+				sum_column[y] = sum;
+			}
+		}
+	}
+
+	// Sums along X and Y, covering the source in Z
+	const Vector3i sum_xy_size(dst_size.x, dst_size.y, src_size.z);
+	StdVector<int64_t> sum_xy;
+	sum_xy.resize(Vector3iUtil::get_volume(sum_xy_size));
+	{
+		ZN_PROFILE_SCOPE_NAMED("X blur");
+		const unsigned int row_size = dst_size.y;
+
+		for (int z = 0; z < sum_xy_size.z; ++z) {
+			const int64_t *src_plane = sum_y.data() + z * sum_y_size.x * row_size;
+			int64_t *dst_plane = sum_xy.data() + z * sum_xy_size.x * row_size;
+
+			for (unsigned int y = 0; y < row_size; ++y) {
+				dst_plane[y] = 0;
+			}
+			for (int x = 0; x < box_size; ++x) {
+				const int64_t *src_row = src_plane + x * row_size;
+				for (unsigned int y = 0; y < row_size; ++y) {
+					dst_plane[y] += src_row[y];
+				}
+			}
+
+			for (int x = 1; x < sum_xy_size.x; ++x) {
+				const int64_t *prev_row = dst_plane + (x - 1) * row_size;
+				const int64_t *entering_row = src_plane + (x + 2 * radius) * row_size;
+				const int64_t *exiting_row = src_plane + (x - 1) * row_size;
+				int64_t *dst_row = dst_plane + x * row_size;
+				for (unsigned int y = 0; y < row_size; ++y) {
+					dst_row[y] = prev_row[y] + entering_row[y] - exiting_row[y];
+				}
+			}
+		}
+	}
+
+	// Sums along all axes
+	StdVector<int64_t> sum_xyz;
+	sum_xyz.resize(Vector3iUtil::get_volume(dst_size));
+	{
+		ZN_PROFILE_SCOPE_NAMED("Z blur");
+		// Planes have the same size in both buffers
+		const unsigned int plane_size = dst_size.x * dst_size.y;
+
+		for (unsigned int i = 0; i < plane_size; ++i) {
+			sum_xyz[i] = 0;
+		}
+		for (int z = 0; z < box_size; ++z) {
+			const int64_t *src_plane = sum_xy.data() + z * plane_size;
+			for (unsigned int i = 0; i < plane_size; ++i) {
+				sum_xyz[i] += src_plane[i];
+			}
+		}
+
+		for (int z = 1; z < dst_size.z; ++z) {
+			const int64_t *prev_plane = sum_xyz.data() + (z - 1) * plane_size;
+			const int64_t *entering_plane = sum_xy.data() + (z + 2 * radius) * plane_size;
+			const int64_t *exiting_plane = sum_xy.data() + (z - 1) * plane_size;
+			int64_t *dst_plane = sum_xyz.data() + z * plane_size;
+			for (unsigned int i = 0; i < plane_size; ++i) {
+				dst_plane[i] = prev_plane[i] + entering_plane[i] - exiting_plane[i];
+			}
+		}
+	}
+
+	// Blend using shape
+	{
+		ZN_PROFILE_SCOPE_NAMED("Blend");
+
+		const double inv_box_volume = 1.0 / static_cast<double>(box_size * box_size * box_size);
+		const float sphere_radius_s = sphere_radius * sphere_radius;
+		const float inv_sphere_radius_s = 1.f / sphere_radius_s;
+
+		Vector3i changed_min = dst_size;
+		Vector3i changed_max(-1, -1, -1);
+
+		for (int z = 0; z < dst_size.z; ++z) {
+			for (int x = 0; x < dst_size.x; ++x) {
+				const unsigned int dst_row_index = Vector3iUtil::get_zxy_index(Vector3i(x, 0, z), dst_size);
+				const unsigned int src_row_index =
+						Vector3iUtil::get_zxy_index(Vector3i(x + radius, radius, z + radius), src_size);
+
+				const int16_t *src_row = src_sd.data() + src_row_index;
+				const int64_t *avg_row = sum_xyz.data() + dst_row_index;
+				int16_t *dst_row = dst_sd.data() + dst_row_index;
+
+				const float dx = x - sphere_pos.x;
+				const float dz = z - sphere_pos.z;
+				const float dxz_s = dx * dx + dz * dz;
+
+				if (dxz_s > sphere_radius_s) {
+					// Row is outside of brush
+					for (int y = 0; y < dst_size.y; ++y) {
+						dst_row[y] = src_row[y];
+					}
+					continue;
+				}
+
+				// Brush factor is zero outside of the sphere, which leaves the source value untouched
+				for (int y = 0; y < dst_size.y; ++y) {
+					const float dy = y - sphere_pos.y;
+					const float factor = math::max(1.f - (dxz_s + dy * dy) * inv_sphere_radius_s, 0.f);
+					const float src_v = get_clamped_s16(src_row[y]);
+					const float avg_v = static_cast<float>(static_cast<double>(avg_row[y]) * inv_box_volume);
+					dst_row[y] = static_cast<int16_t>(src_v + (avg_v - src_v) * factor);
+				}
+
+				for (int y = 0; y < dst_size.y; ++y) {
+					if (dst_row[y] != get_clamped_s16(src_row[y])) {
+						changed_min = math::min(changed_min, Vector3i(x, y, z));
+						changed_max = math::max(changed_max, Vector3i(x, y, z));
+					}
+				}
+			}
+		}
+
+		if (changed_max.x >= 0) {
+			out_changed_box = Box3i::from_min_max(changed_min, changed_max + Vector3i(1, 1, 1));
+		}
+	}
+}
+
+// Works with any depth, but converts every voxel to float.
+void grow_sphere_generic(VoxelBuffer &src, const float strength, const Vector3f sphere_pos, const float sphere_radius) {
+	ZN_PROFILE_SCOPE();
+
+	const Vector3i src_size = src.get_size();
 
 	const float sphere_radius_squared = sphere_radius * sphere_radius;
 	const float inv_sphere_radius = 1.f / sphere_radius;
@@ -632,4 +1001,123 @@ void grow_sphere(VoxelBuffer &src, float strength, Vector3f sphere_pos, float sp
 	}
 }
 
+// Specialized version for 16-bit SDF, which only processes voxels within the sphere.
+void grow_sphere_sdf16(
+		VoxelBuffer &src,
+		const float strength,
+		const Vector3f sphere_pos,
+		const float sphere_radius,
+		Box3i &out_changed_box
+) {
+	ZN_PROFILE_SCOPE();
+
+	const unsigned int channel = VoxelBuffer::CHANNEL_SDF;
+	const Vector3i src_size = src.get_size();
+
+	out_changed_box = Box3i();
+
+	src.decompress_channel(channel);
+	Span<int16_t> src_sd;
+	ZN_ASSERT_RETURN(src.get_channel_data(channel, src_sd));
+
+	// Offset at the center of the sphere, in raw units
+	const float raw_strength = strength * constants::QUANTIZED_SDF_16_BITS_SCALE * 32767.f;
+	const float sphere_radius_squared = sphere_radius * sphere_radius;
+	const float inv_sphere_radius = 1.f / sphere_radius;
+
+	Vector3i changed_min = src_size;
+	Vector3i changed_max(-1, -1, -1);
+
+	for (int z = 0; z < src_size.z; ++z) {
+		for (int x = 0; x < src_size.x; ++x) {
+			const float dx = x - sphere_pos.x;
+			const float dz = z - sphere_pos.z;
+			const float dxz_s = dx * dx + dz * dz;
+
+			if (dxz_s > sphere_radius_squared) {
+				// Row is outside of brush
+				continue;
+			}
+
+			// Only process the part of the column that crosses the sphere
+			const float half_chord = Math::sqrt(sphere_radius_squared - dxz_s);
+			const int min_y = math::max(static_cast<int>(Math::ceil(sphere_pos.y - half_chord)), 0);
+			const int max_y = math::min(static_cast<int>(Math::floor(sphere_pos.y + half_chord)), src_size.y - 1);
+
+			int16_t *row = src_sd.data() + Vector3iUtil::get_zxy_index(Vector3i(x, 0, z), src_size);
+
+			for (int y = min_y; y <= max_y; ++y) {
+				const float dy = y - sphere_pos.y;
+				const float distance = Math::sqrt(dxz_s + dy * dy);
+				const float offset = raw_strength * (sphere_radius - distance) * inv_sphere_radius;
+
+				// With signed distance fields, subtracting "grows" the shape.
+				// Negative strength is allowed so it can also be used to "shrink".
+				const int16_t prev_v = row[y];
+				const int16_t v =
+						static_cast<int16_t>(math::clamp(get_clamped_s16(prev_v) - offset, -32767.f, 32767.f));
+				row[y] = v;
+
+				if (v != prev_v) {
+					changed_min = math::min(changed_min, Vector3i(x, y, z));
+					changed_max = math::max(changed_max, Vector3i(x, y, z));
+				}
+			}
+		}
+	}
+
+	if (changed_max.x >= 0) {
+		out_changed_box = Box3i::from_min_max(changed_min, changed_max + Vector3i(1, 1, 1));
+	}
+}
+
+} // namespace
+
+void box_blur(
+		const VoxelBuffer &src,
+		VoxelBuffer &dst,
+		int radius,
+		Vector3f sphere_pos,
+		float sphere_radius,
+		Box3i &out_changed_box
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(radius >= 1);
+
+	const Vector3i dst_size = src.get_size() - Vector3i(radius, radius, radius) * 2;
+
+	ZN_ASSERT_RETURN(dst_size.x >= 0);
+	ZN_ASSERT_RETURN(dst_size.y >= 0);
+	ZN_ASSERT_RETURN(dst_size.z >= 0);
+
+	if (src.get_channel_depth(VoxelBuffer::CHANNEL_SDF) == VoxelBuffer::DEPTH_16_BIT) {
+		box_blur_sdf16(src, dst, dst_size, radius, sphere_pos, sphere_radius, out_changed_box);
+	} else {
+		box_blur_generic(src, dst, dst_size, radius, sphere_pos, sphere_radius);
+		out_changed_box = Box3i(Vector3i(), dst_size);
+	}
+}
+
+void box_blur(const VoxelBuffer &src, VoxelBuffer &dst, int radius, Vector3f sphere_pos, float sphere_radius) {
+	Box3i changed_box;
+	box_blur(src, dst, radius, sphere_pos, sphere_radius, changed_box);
+}
+
+void grow_sphere(VoxelBuffer &src, float strength, Vector3f sphere_pos, float sphere_radius, Box3i &out_changed_box) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(sphere_radius > 0.001f);
+
+	if (src.get_channel_depth(VoxelBuffer::CHANNEL_SDF) == VoxelBuffer::DEPTH_16_BIT) {
+		grow_sphere_sdf16(src, strength, sphere_pos, sphere_radius, out_changed_box);
+	} else {
+		grow_sphere_generic(src, strength, sphere_pos, sphere_radius);
+		out_changed_box = Box3i(Vector3i(), src.get_size());
+	}
+}
+
+void grow_sphere(VoxelBuffer &src, float strength, Vector3f sphere_pos, float sphere_radius) {
+	Box3i changed_box;
+	grow_sphere(src, strength, sphere_pos, sphere_radius, changed_box);
+}
+
 } // namespace zylann::voxel::ops
@@ -244,6 +244,31 @@ void run_blocky_random_tick(
 		const Callable &callback
 );
 
+// Picks `voxels_per_block` random voxels in every loaded block of LOD0 intersecting the box (fewer if the block is
+// partially inside), and outputs those whose model is random-tickable, ordered by block.
+// Blocks containing no tickable models are skipped without sampling, using a summary of their values cached per block.
+// Blocks are processed in parallel, and the result only depends on the seed and the voxels.
+void run_blocky_random_tick_per_block(
+		const VoxelData &data,
+		Box3i voxel_box,
+		const VoxelBlockyLibraryBase &lib,
+		uint64_t seed,
+		unsigned int voxels_per_block,
+		StdVector<Vector3i> &out_positions,
+		StdVector<uint32_t> &out_values
+);
+
+// Calls the callback once with all picks, as `(positions: PackedVector3Array, values: PackedInt32Array)`. It isn't
+// called if there are none.
+void run_blocky_random_tick_per_block(
+		const VoxelData &data,
+		AABB voxel_box_f,
+		const VoxelBlockyLibraryBase &lib,
+		uint64_t seed,
+		unsigned int voxels_per_block,
+		const Callable &callback
+);
+
 } // namespace zylann::voxel
 
 // Library of templates for executing per-voxel operations.
@@ -785,9 +810,22 @@ struct DoShapeSingleBuffer {
 void box_blur_slow_ref(const VoxelBuffer &src, VoxelBuffer &dst, int radius, Vector3f sphere_pos, float sphere_radius);
 #endif
 
+// Blurs SDF within a sphere using a box kernel of size `radius * 2 + 1`. `dst` is smaller than `src` by `radius` on
+// each side, and the sphere position is relative to `dst`.
 void box_blur(const VoxelBuffer &src, VoxelBuffer &dst, int radius, Vector3f sphere_pos, float sphere_radius);
+// Also outputs the box of voxels of `dst` that differ from `src`, relative to `dst`. It is empty if none changed.
+void box_blur(
+		const VoxelBuffer &src,
+		VoxelBuffer &dst,
+		int radius,
+		Vector3f sphere_pos,
+		float sphere_radius,
+		Box3i &out_changed_box
+);
 
 void grow_sphere(VoxelBuffer &src, float strength, Vector3f sphere_pos, float sphere_radius);
+// Also outputs the box of voxels that changed. It is empty if none changed.
+void grow_sphere(VoxelBuffer &src, float strength, Vector3f sphere_pos, float sphere_radius, Box3i &out_changed_box);
 
 } // namespace zylann::voxel::ops
 
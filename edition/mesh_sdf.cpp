@@ -1,4 +1,6 @@
 #include "mesh_sdf.h"
+#include "../engine/parallel_for.h"
+#include "../util/containers/fixed_array.h"
 #include "../util/math/box3i.h"
 #include "../util/math/conv.h"
 #include "../util/math/triangle.h"
@@ -6,6 +8,7 @@
 #include "../util/profiling.h"
 #include "../util/string/format.h" // Debug
 #include "../util/voxel_raycast.h"
+#include <algorithm>
 
 // Debug
 // #define ZN_MESH_SDF_DEBUG_SLICES
@@ -1595,4 +1598,581 @@ void generate_mesh_sdf_approx_floodfill(
 	}
 }
 
+// BVH
+
+namespace {
+
+inline void set_packet_lane(TriangleBVH::Vector3fPacket &packet, const unsigned int lane, const Vector3f v) {
+	packet.x[lane] = v.x;
+	packet.y[lane] = v.y;
+	packet.z[lane] = v.z;
+}
+
+inline float dot_lane(const TriangleBVH::Vector3fPacket &a, const unsigned int lane, float x, float y, float z) {
+	return a.x[lane] * x + a.y[lane] * y + a.z[lane] * z;
+}
+
+void fill_triangle_packet(
+		TriangleBVH::TrianglePacket &packet,
+		Span<const Triangle> triangles,
+		Span<const uint32_t> triangle_indices
+) {
+	ZN_ASSERT(triangle_indices.size() > 0 && triangle_indices.size() <= TriangleBVH::PACKET_SIZE);
+	packet.triangle_count = triangle_indices.size();
+
+	for (unsigned int lane = 0; lane < TriangleBVH::PACKET_SIZE; ++lane) {
+		const uint32_t triangle_index = triangle_indices[math::min<unsigned int>(lane, triangle_indices.size() - 1)];
+		const Triangle &t = triangles[triangle_index];
+
+		set_packet_lane(packet.v1, lane, t.v1);
+		set_packet_lane(packet.v2, lane, t.v2);
+		set_packet_lane(packet.v3, lane, t.v3);
+		set_packet_lane(packet.v21, lane, t.v21);
+		set_packet_lane(packet.v32, lane, t.v32);
+		set_packet_lane(packet.v13, lane, t.v13);
+		set_packet_lane(packet.nor, lane, t.nor);
+		set_packet_lane(packet.v21_cross_nor, lane, t.v21_cross_nor);
+		set_packet_lane(packet.v32_cross_nor, lane, t.v32_cross_nor);
+		set_packet_lane(packet.v13_cross_nor, lane, t.v13_cross_nor);
+		packet.inv_v21_length_squared[lane] = t.inv_v21_length_squared;
+		packet.inv_v32_length_squared[lane] = t.inv_v32_length_squared;
+		packet.inv_v13_length_squared[lane] = t.inv_v13_length_squared;
+		packet.inv_nor_length_squared[lane] = t.inv_nor_length_squared;
+		packet.triangle_indices[lane] = triangle_index;
+	}
+}
+
+// Same as `get_distance_to_triangle_squared_precalc`, for every triangle of a packet. It has no branches and reads
+// components from separate arrays, so compilers can vectorize it.
+void get_distances_to_triangles_squared(
+		const TriangleBVH::TrianglePacket &t,
+		const Vector3f p,
+		float out_distances_squared[TriangleBVH::PACKET_SIZE]
+) {
+	using namespace math;
+
+	for (unsigned int i = 0; i < TriangleBVH::PACKET_SIZE; ++i) {
+		const float p1x = p.x - t.v1.x[i];
+		const float p1y = p.y - t.v1.y[i];
+		const float p1z = p.z - t.v1.z[i];
+		const float p2x = p.x - t.v2.x[i];
+		const float p2y = p.y - t.v2.y[i];
+		const float p2z = p.z - t.v2.z[i];
+		const float p3x = p.x - t.v3.x[i];
+		const float p3y = p.y - t.v3.y[i];
+		const float p3z = p.z - t.v3.z[i];
+
+		const float det = //
+				sign_nonzero(dot_lane(t.v21_cross_nor, i, p1x, p1y, p1z)) + //
+				sign_nonzero(dot_lane(t.v32_cross_nor, i, p2x, p2y, p2z)) + //
+				sign_nonzero(dot_lane(t.v13_cross_nor, i, p3x, p3y, p3z));
+
+		const float k21 = clamp(dot_lane(t.v21, i, p1x, p1y, p1z) * t.inv_v21_length_squared[i], 0.f, 1.f);
+		const float k32 = clamp(dot_lane(t.v32, i, p2x, p2y, p2z) * t.inv_v32_length_squared[i], 0.f, 1.f);
+		const float k13 = clamp(dot_lane(t.v13, i, p3x, p3y, p3z) * t.inv_v13_length_squared[i], 0.f, 1.f);
+
+		const float d21 = squared(t.v21.x[i] * k21 - p1x) + squared(t.v21.y[i] * k21 - p1y) +
+				squared(t.v21.z[i] * k21 - p1z);
+		const float d32 = squared(t.v32.x[i] * k32 - p2x) + squared(t.v32.y[i] * k32 - p2y) +
+				squared(t.v32.z[i] * k32 - p2z);
+		const float d13 = squared(t.v13.x[i] * k13 - p3x) + squared(t.v13.y[i] * k13 - p3y) +
+				squared(t.v13.z[i] * k13 - p3z);
+
+		// Outside of the prism: distance to closest edge. Inside: distance to plane.
+		const float edge_distance_squared = min(d21, min(d32, d13));
+		const float plane_distance_squared = squared(dot_lane(t.nor, i, p1x, p1y, p1z)) * t.inv_nor_length_squared[i];
+
+		out_distances_squared[i] = det < 2.f ? edge_distance_squared : plane_distance_squared;
+	}
+}
+
+inline float get_distance_to_box_squared(const Vector3f p, const Vector3f min_pos, const Vector3f max_pos) {
+	return math::length_squared(math::max(math::max(min_pos - p, p - max_pos), Vector3f()));
+}
+
+// Same as `get_distance_to_triangle_squared_precalc`, but returns the closest point.
+Vector3f get_closest_point_on_triangle_precalc(const Triangle &t, const Vector3f p) {
+	using namespace math;
+
+	const Vector3f p1 = p - t.v1;
+	const Vector3f p2 = p - t.v2;
+	const Vector3f p3 = p - t.v3;
+
+	const float det = //
+			sign_nonzero(dot(t.v21_cross_nor, p1)) + //
+			sign_nonzero(dot(t.v32_cross_nor, p2)) + //
+			sign_nonzero(dot(t.v13_cross_nor, p3));
+
+	if (det < 2.f) {
+		// Outside of the prism: closest point on the closest edge
+		const Vector3f e21 = t.v21 * clamp(dot(t.v21, p1) * t.inv_v21_length_squared, 0.f, 1.f);
+		const Vector3f e32 = t.v32 * clamp(dot(t.v32, p2) * t.inv_v32_length_squared, 0.f, 1.f);
+		const Vector3f e13 = t.v13 * clamp(dot(t.v13, p3) * t.inv_v13_length_squared, 0.f, 1.f);
+		const float d21 = length_squared(e21 - p1);
+		const float d32 = length_squared(e32 - p2);
+		const float d13 = length_squared(e13 - p3);
+		if (d21 <= d32 && d21 <= d13) {
+			return t.v1 + e21;
+		} else if (d32 <= d13) {
+			return t.v2 + e32;
+		} else {
+			return t.v3 + e13;
+		}
+	} else {
+		// Inside the prism: projection on the plane
+		return p - t.nor * (dot(t.nor, p1) * t.inv_nor_length_squared);
+	}
+}
+
+// Solid angle of a triangle seen from the origin (Van Oosterom and Strackee).
+// Positive when the triangle is clockwise seen from the origin.
+inline float get_triangle_solid_angle(const Vector3f a, const Vector3f b, const Vector3f c) {
+	const float la = math::length(a);
+	const float lb = math::length(b);
+	const float lc = math::length(c);
+	const float numerator = math::dot(a, math::cross(b, c));
+	const float denominator = la * lb * lc + math::dot(a, b) * lc + math::dot(b, c) * la + math::dot(c, a) * lb;
+	return 2.f * math::atan2(numerator, denominator);
+}
+
+// Median splits keep the tree balanced, so its depth is logarithmic. Traversals push at most two nodes per level.
+static const unsigned int BVH_MAX_STACK_SIZE = 128;
+
+} // namespace
+
+void TriangleBVH::build(Span<const Triangle> triangles) {
+	ZN_PROFILE_SCOPE();
+
+	nodes.clear();
+	packets.clear();
+
+	if (triangles.size() == 0) {
+		return;
+	}
+
+	StdVector<uint32_t> triangle_indices;
+	triangle_indices.resize(triangles.size());
+	StdVector<Vector3f> centroids;
+	centroids.resize(triangles.size());
+	for (uint32_t i = 0; i < triangles.size(); ++i) {
+		const Triangle &t = triangles[i];
+		triangle_indices[i] = i;
+		centroids[i] = (t.v1 + t.v2 + t.v3) / 3.f;
+	}
+
+	struct BuildItem {
+		uint32_t node_index;
+		uint32_t begin;
+		uint32_t end;
+	};
+	StdVector<BuildItem> build_stack;
+
+	nodes.push_back(Node());
+	build_stack.push_back(BuildItem{ 0, 0, static_cast<uint32_t>(triangles.size()) });
+
+	// Top-down, splitting triangles at the median of their centroids along the longest axis. Children are always
+	// created after their parent.
+	while (build_stack.size() > 0) {
+		const BuildItem item = build_stack.back();
+		build_stack.pop_back();
+
+		Vector3f min_pos = triangles[triangle_indices[item.begin]].v1;
+		Vector3f max_pos = min_pos;
+		Vector3f min_centroid = centroids[triangle_indices[item.begin]];
+		Vector3f max_centroid = min_centroid;
+
+		for (uint32_t i = item.begin; i < item.end; ++i) {
+			const uint32_t triangle_index = triangle_indices[i];
+			const Triangle &t = triangles[triangle_index];
+			min_pos = math::min(min_pos, math::min(t.v1, math::min(t.v2, t.v3)));
+			max_pos = math::max(max_pos, math::max(t.v1, math::max(t.v2, t.v3)));
+			min_centroid = math::min(min_centroid, centroids[triangle_index]);
+			max_centroid = math::max(max_centroid, centroids[triangle_index]);
+		}
+
+		{
+			Node &node = nodes[item.node_index];
+			node.min_pos = min_pos;
+			node.max_pos = max_pos;
+		}
+
+		const uint32_t count = item.end - item.begin;
+
+		if (count <= PACKET_SIZE) {
+			TrianglePacket packet;
+			Span<const uint32_t> leaf_triangle_indices =
+					to_span_from_position_and_size(triangle_indices, item.begin, count);
+			fill_triangle_packet(packet, triangles, leaf_triangle_indices);
+			Node &node = nodes[item.node_index];
+			node.is_leaf = true;
+			node.child_or_packet_index = packets.size();
+			packets.push_back(packet);
+			continue;
+		}
+
+		const unsigned int axis = math::get_longest_axis(max_centroid - min_centroid);
+		const uint32_t mid = item.begin + count / 2;
+		std::nth_element(
+				triangle_indices.begin() + item.begin,
+				triangle_indices.begin() + mid,
+				triangle_indices.begin() + item.end,
+				[&centroids, axis](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; }
+		);
+
+		const uint32_t first_child_index = nodes.size();
+		{
+			Node &node = nodes[item.node_index];
+			node.is_leaf = false;
+			node.child_or_packet_index = first_child_index;
+		}
+		nodes.push_back(Node());
+		nodes.push_back(Node());
+		build_stack.push_back(BuildItem{ first_child_index, item.begin, mid });
+		build_stack.push_back(BuildItem{ first_child_index + 1, mid, item.end });
+	}
+
+	// Approximations for winding numbers, bottom-up
+	for (int node_index = static_cast<int>(nodes.size()) - 1; node_index >= 0; --node_index) {
+		Node &node = nodes[node_index];
+		const Vector3f box_center = (node.min_pos + node.max_pos) * 0.5f;
+
+		if (node.is_leaf) {
+			const TrianglePacket &packet = packets[node.child_or_packet_index];
+			node.area_normal = Vector3f();
+			node.area = 0.f;
+			Vector3f weighted_center;
+
+			for (unsigned int lane = 0; lane < packet.triangle_count; ++lane) {
+				const Triangle &t = triangles[packet.triangle_indices[lane]];
+				const Vector3f area_normal = 0.5f * math::cross(t.v2 - t.v1, t.v3 - t.v1);
+				const float area = math::length(area_normal);
+				node.area_normal += area_normal;
+				node.area += area;
+				weighted_center += area * centroids[packet.triangle_indices[lane]];
+			}
+
+			node.center = node.area > 0.f ? weighted_center / node.area : box_center;
+			node.radius = 0.f;
+
+			for (unsigned int lane = 0; lane < packet.triangle_count; ++lane) {
+				const Triangle &t = triangles[packet.triangle_indices[lane]];
+				node.radius = math::max(node.radius, math::distance(node.center, t.v1));
+				node.radius = math::max(node.radius, math::distance(node.center, t.v2));
+				node.radius = math::max(node.radius, math::distance(node.center, t.v3));
+			}
+
+		} else {
+			const Node &child0 = nodes[node.child_or_packet_index];
+			const Node &child1 = nodes[node.child_or_packet_index + 1];
+			node.area_normal = child0.area_normal + child1.area_normal;
+			node.area = child0.area + child1.area;
+			node.center = node.area > 0.f ? (child0.center * child0.area + child1.center * child1.area) / node.area
+										  : box_center;
+			node.radius = math::max(
+					math::distance(node.center, child0.center) + child0.radius,
+					math::distance(node.center, child1.center) + child1.radius
+			);
+		}
+	}
+}
+
+uint32_t TriangleBVH::find_closest_triangle(const Vector3f pos, float &io_distance_squared) const {
+	if (nodes.size() == 0) {
+		return NO_TRIANGLE;
+	}
+
+	uint32_t closest_triangle_index = NO_TRIANGLE;
+	float closest_distance_squared = io_distance_squared;
+
+	FixedArray<uint32_t, BVH_MAX_STACK_SIZE> stack;
+	unsigned int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0) {
+		const Node &node = nodes[stack[--stack_size]];
+
+		// The node may have been pushed before a closer triangle was found
+		if (get_distance_to_box_squared(pos, node.min_pos, node.max_pos) >= closest_distance_squared) {
+			continue;
+		}
+
+		if (node.is_leaf) {
+			const TrianglePacket &packet = packets[node.child_or_packet_index];
+			float distances_squared[PACKET_SIZE];
+			get_distances_to_triangles_squared(packet, pos, distances_squared);
+
+			for (unsigned int lane = 0; lane < PACKET_SIZE; ++lane) {
+				if (distances_squared[lane] < closest_distance_squared) {
+					closest_distance_squared = distances_squared[lane];
+					closest_triangle_index = packet.triangle_indices[lane];
+				}
+			}
+			continue;
+		}
+
+		const uint32_t child0_index = node.child_or_packet_index;
+		const uint32_t child1_index = child0_index + 1;
+		const Node &child0 = nodes[child0_index];
+		const Node &child1 = nodes[child1_index];
+		const float d0 = get_distance_to_box_squared(pos, child0.min_pos, child0.max_pos);
+		const float d1 = get_distance_to_box_squared(pos, child1.min_pos, child1.max_pos);
+
+		ZN_ASSERT(stack_size + 2 <= stack.size());
+
+		// Visit the closest child first, so the other is more likely to be skipped
+		if (d0 < d1) {
+			if (d1 < closest_distance_squared) {
+				stack[stack_size++] = child1_index;
+			}
+			if (d0 < closest_distance_squared) {
+				stack[stack_size++] = child0_index;
+			}
+		} else {
+			if (d0 < closest_distance_squared) {
+				stack[stack_size++] = child0_index;
+			}
+			if (d1 < closest_distance_squared) {
+				stack[stack_size++] = child1_index;
+			}
+		}
+	}
+
+	io_distance_squared = closest_distance_squared;
+	return closest_triangle_index;
+}
+
+float TriangleBVH::get_winding_number(const Vector3f pos) const {
+	if (nodes.size() == 0) {
+		return 0.f;
+	}
+
+	float solid_angle = 0.f;
+
+	FixedArray<uint32_t, BVH_MAX_STACK_SIZE> stack;
+	unsigned int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0) {
+		const Node &node = nodes[stack[--stack_size]];
+
+		const Vector3f to_center = node.center - pos;
+		const float distance = math::length(to_center);
+
+		if (distance > 2.f * node.radius) {
+			// Far enough to approximate triangles of the node as a single dipole
+			solid_angle += math::dot(to_center, node.area_normal) / (distance * distance * distance);
+			continue;
+		}
+
+		if (node.is_leaf) {
+			const TrianglePacket &packet = packets[node.child_or_packet_index];
+			for (unsigned int lane = 0; lane < packet.triangle_count; ++lane) {
+				const Vector3f v1(packet.v1.x[lane], packet.v1.y[lane], packet.v1.z[lane]);
+				const Vector3f v2(packet.v2.x[lane], packet.v2.y[lane], packet.v2.z[lane]);
+				const Vector3f v3(packet.v3.x[lane], packet.v3.y[lane], packet.v3.z[lane]);
+				solid_angle += get_triangle_solid_angle(v1 - pos, v2 - pos, v3 - pos);
+			}
+			continue;
+		}
+
+		ZN_ASSERT(stack_size + 2 <= stack.size());
+		stack[stack_size++] = node.child_or_packet_index;
+		stack[stack_size++] = node.child_or_packet_index + 1;
+	}
+
+	return solid_angle / (4.f * math::PI_32);
+}
+
+void generate_mesh_sdf_bvh(
+		Span<float> sdf_grid,
+		const Vector3i res,
+		Span<const Triangle> triangles,
+		const Vector3f min_pos,
+		const Vector3f max_pos
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(int64_t(sdf_grid.size()) == Vector3iUtil::get_volume(res));
+
+	if (sdf_grid.size() == 0) {
+		return;
+	}
+	if (triangles.size() == 0) {
+		sdf_grid.fill(FAR_SD);
+		return;
+	}
+
+	TriangleBVH bvh;
+	bvh.build(triangles);
+
+	const Vector3f mesh_size = max_pos - min_pos;
+	const Vector3f cell_size = mesh_size / to_vec3f(res);
+	const GridToSpaceConverter grid_to_space(res, min_pos, mesh_size, cell_size * 0.5f);
+
+	// Cells closer than this to the surface get exact distances. There is always at least one of them, since the grid
+	// covers the mesh.
+	const float near_distance = 2.f * math::max(cell_size.x, math::max(cell_size.y, cell_size.z));
+
+	static const uint32_t NO_SEED = std::numeric_limits<uint32_t>::max();
+
+	// Near cells are seeds of the far field. They store the closest triangle and the closest point on it.
+	StdVector<uint32_t> closest_triangles;
+	closest_triangles.resize(sdf_grid.size());
+	StdVector<Vector3f> closest_points;
+	closest_points.resize(sdf_grid.size());
+	// Index of the seed cell each cell got its distance from
+	StdVector<uint32_t> seeds;
+	seeds.resize(sdf_grid.size());
+
+	// Slices along Z are processed in parallel. Rows along Y are contiguous.
+
+	{
+		ZN_PROFILE_SCOPE_NAMED("Near field");
+
+		parallel_for_ranges(res.z, 1, [&](const unsigned int z_begin, const unsigned int z_end) {
+			Vector3i grid_pos;
+			for (grid_pos.z = z_begin; grid_pos.z < static_cast<int>(z_end); ++grid_pos.z) {
+				for (grid_pos.x = 0; grid_pos.x < res.x; ++grid_pos.x) {
+					grid_pos.y = 0;
+					size_t grid_index = Vector3iUtil::get_zxy_index(grid_pos, res);
+
+					for (; grid_pos.y < res.y; ++grid_pos.y) {
+						const Vector3f pos = grid_to_space(grid_pos);
+						float distance_squared = math::squared(near_distance);
+						const uint32_t ti = bvh.find_closest_triangle(pos, distance_squared);
+
+						if (ti == TriangleBVH::NO_TRIANGLE) {
+							sdf_grid[grid_index] = FAR_SD;
+							seeds[grid_index] = NO_SEED;
+						} else {
+							sdf_grid[grid_index] = Math::sqrt(distance_squared);
+							closest_triangles[grid_index] = ti;
+							closest_points[grid_index] = get_closest_point_on_triangle_precalc(triangles[ti], pos);
+							seeds[grid_index] = grid_index;
+						}
+
+						++grid_index;
+					}
+				}
+			}
+		});
+	}
+
+	{
+		ZN_PROFILE_SCOPE_NAMED("Far field");
+
+		// Jump flood: far cells pick the closest seed point among those found by cells at decreasing distances. Then
+		// they get the exact distance to the triangle of that seed, which is almost always the closest triangle. An
+		// extra pass with the smallest step fixes most of the remaining errors.
+		const int max_res = math::max(res.x, math::max(res.y, res.z));
+		StdVector<int> steps;
+		int first_step = 1;
+		while (first_step * 2 < max_res) {
+			first_step *= 2;
+		}
+		for (int step = first_step; step > 0; step /= 2) {
+			steps.push_back(step);
+		}
+		steps.push_back(1);
+
+		StdVector<uint32_t> next_seeds;
+		next_seeds.resize(seeds.size());
+
+		for (const int step : steps) {
+			parallel_for_ranges(res.z, 1, [&](const unsigned int z_begin, const unsigned int z_end) {
+				Vector3i grid_pos;
+				for (grid_pos.z = z_begin; grid_pos.z < static_cast<int>(z_end); ++grid_pos.z) {
+					for (grid_pos.x = 0; grid_pos.x < res.x; ++grid_pos.x) {
+						grid_pos.y = 0;
+						size_t grid_index = Vector3iUtil::get_zxy_index(grid_pos, res);
+
+						for (; grid_pos.y < res.y; ++grid_pos.y) {
+							uint32_t seed = seeds[grid_index];
+
+							// Seeds never change
+							if (seed != grid_index) {
+								const Vector3f pos = grid_to_space(grid_pos);
+								float seed_distance_squared = seed == NO_SEED
+										? std::numeric_limits<float>::max()
+										: math::distance_squared(pos, closest_points[seed]);
+
+								Vector3i offset;
+								for (offset.z = -step; offset.z <= step; offset.z += step) {
+									for (offset.x = -step; offset.x <= step; offset.x += step) {
+										for (offset.y = -step; offset.y <= step; offset.y += step) {
+											const Vector3i npos = grid_pos + offset;
+											if (!is_valid_grid_position(npos, res)) {
+												continue;
+											}
+											const uint32_t nseed = seeds[Vector3iUtil::get_zxy_index(npos, res)];
+											if (nseed == NO_SEED || nseed == seed) {
+												continue;
+											}
+											const float d = math::distance_squared(pos, closest_points[nseed]);
+											if (d < seed_distance_squared) {
+												seed_distance_squared = d;
+												seed = nseed;
+											}
+										}
+									}
+								}
+							}
+
+							next_seeds[grid_index] = seed;
+							++grid_index;
+						}
+					}
+				}
+			});
+
+			std::swap(seeds, next_seeds);
+		}
+
+		parallel_for_ranges(res.z, 1, [&](const unsigned int z_begin, const unsigned int z_end) {
+			const size_t begin_index = z_begin * res.x * res.y;
+			const size_t end_index = z_end * res.x * res.y;
+			for (size_t grid_index = begin_index; grid_index < end_index; ++grid_index) {
+				const uint32_t seed = seeds[grid_index];
+				if (seed == grid_index || seed == NO_SEED) {
+					continue;
+				}
+				const Vector3f pos = grid_to_space(Vector3iUtil::from_zxy_index(grid_index, res));
+				const Triangle &t = triangles[closest_triangles[seed]];
+				sdf_grid[grid_index] = Math::sqrt(get_distance_to_triangle_squared_precalc(t, pos));
+			}
+		});
+	}
+
+	{
+		ZN_PROFILE_SCOPE_NAMED("Signs");
+
+		// Winding numbers are expensive, but the sign can only change between two cells if the surface passes between
+		// them. If a cell is further from the surface than from the previous cell of its row, they have the same sign.
+		// Triangles are clockwise seen from outside, so winding numbers are negative inside. The absolute value is
+		// used so the other convention works too.
+		const float row_step = cell_size.y;
+
+		parallel_for_ranges(res.z, 1, [&](const unsigned int z_begin, const unsigned int z_end) {
+			Vector3i grid_pos;
+			for (grid_pos.z = z_begin; grid_pos.z < static_cast<int>(z_end); ++grid_pos.z) {
+				for (grid_pos.x = 0; grid_pos.x < res.x; ++grid_pos.x) {
+					grid_pos.y = 0;
+					size_t grid_index = Vector3iUtil::get_zxy_index(grid_pos, res);
+					bool inside = false;
+
+					for (; grid_pos.y < res.y; ++grid_pos.y) {
+						const float distance = sdf_grid[grid_index];
+						if (grid_pos.y == 0 || distance <= row_step) {
+							inside = Math::abs(bvh.get_winding_number(grid_to_space(grid_pos))) > 0.5f;
+						}
+						if (inside) {
+							sdf_grid[grid_index] = -distance;
+						}
+						++grid_index;
+					}
+				}
+			}
+		});
+	}
+}
+
 } // namespace zylann::voxel::mesh_sdf
@@ -9,6 +9,7 @@
 #include "../util/tasks/threaded_task.h"
 
 #include <atomic>
+#include <limits>
 #include <memory>
 
 namespace zylann::voxel::mesh_sdf {
@@ -48,6 +49,71 @@ struct ChunkGrid {
 	float chunk_size; // Size of a cubic cell in space units
 };
 
+// Bounding volume hierarchy of triangles. Used to find the closest triangle to a point without checking every triangle,
+// and to compute winding numbers.
+struct TriangleBVH {
+	static const uint32_t NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+	static const unsigned int PACKET_SIZE = 4;
+
+	struct Vector3fPacket {
+		float x[PACKET_SIZE];
+		float y[PACKET_SIZE];
+		float z[PACKET_SIZE];
+	};
+
+	// Triangles of a leaf, with the same precomputed values as `Triangle` but laid out so distances to all of them can
+	// be computed at once with SIMD. Unused lanes repeat the last triangle.
+	struct TrianglePacket {
+		Vector3fPacket v1;
+		Vector3fPacket v2;
+		Vector3fPacket v3;
+		Vector3fPacket v21;
+		Vector3fPacket v32;
+		Vector3fPacket v13;
+		Vector3fPacket nor;
+		Vector3fPacket v21_cross_nor;
+		Vector3fPacket v32_cross_nor;
+		Vector3fPacket v13_cross_nor;
+		float inv_v21_length_squared[PACKET_SIZE];
+		float inv_v32_length_squared[PACKET_SIZE];
+		float inv_v13_length_squared[PACKET_SIZE];
+		float inv_nor_length_squared[PACKET_SIZE];
+		uint32_t triangle_indices[PACKET_SIZE];
+		uint32_t triangle_count;
+	};
+
+	struct Node {
+		Vector3f min_pos;
+		Vector3f max_pos;
+		// Index of the first child (the second one follows it), or index of the packet if the node is a leaf
+		uint32_t child_or_packet_index;
+		bool is_leaf;
+
+		// Approximation of the node's triangles used by winding numbers far from them
+		// Sum of triangle normals scaled by their area
+		Vector3f area_normal;
+		// Centroid of triangles weighted by their area
+		Vector3f center;
+		float area;
+		// Distance from the center to the furthest vertex
+		float radius;
+	};
+
+	StdVector<Node> nodes;
+	StdVector<TrianglePacket> packets;
+
+	// Triangles must have been prepared with `prepare_triangles()`.
+	void build(Span<const Triangle> triangles);
+
+	// Finds the closest triangle strictly closer than the given squared distance, and updates that distance.
+	// Returns `NO_TRIANGLE` if none was found.
+	uint32_t find_closest_triangle(Vector3f pos, float &io_distance_squared) const;
+
+	// Gets how many times the mesh winds around the given position. Its absolute value is close to 1 inside a closed
+	// mesh and close to 0 outside, and remains meaningful if the mesh has small holes or intersections.
+	float get_winding_number(Vector3f pos) const;
+};
+
 class GenMeshSDFSubBoxTask : public IThreadedTask {
 public:
 	struct SharedData {
@@ -181,6 +247,19 @@ void generate_mesh_sdf_approx_floodfill(
 		bool boundary_sign_fix
 );
 
+// Computes an accurate SDF using a bounding volume hierarchy of triangles.
+// Cells near the surface get exact distances from the closest triangle. Far cells find their closest triangle with a
+// jump flood seeded from near cells. Signs come from winding numbers, which don't depend on which triangle is
+// the closest, so they remain correct where other methods are ambiguous. The mesh doesn't have to be perfectly closed.
+// It is the fastest accurate method with meshes having a lot of triangles.
+void generate_mesh_sdf_bvh(
+		Span<float> sdf_grid,
+		const Vector3i res,
+		Span<const Triangle> triangles,
+		const Vector3f min_pos,
+		const Vector3f max_pos
+);
+
 } // namespace zylann::voxel::mesh_sdf
 
 #endif // VOXEL_MESH_SDF_H
@@ -0,0 +1,65 @@
+#ifndef VOXEL_DATA_RAYCAST_H
+#define VOXEL_DATA_RAYCAST_H
+
+#include "../storage/voxel_data.h"
+#include "../util/voxel_raycast.h"
+
+namespace zylann::voxel {
+
+struct VoxelDataRaycastHit {
+	Vector3i position;
+	Vector3i previous_position;
+	float distance_along_ray;
+	float distance_along_ray_prev;
+};
+
+// Casts a ray through voxels of LOD0, reading them one block at a time instead of going through `get_voxel`.
+// Blocks are skipped at once if the range of values they contain can't be hit.
+// `can_hit_f(VoxelSingleValue min, VoxelSingleValue max) -> bool` tells if any voxel with a value in the given range
+// could stop the ray.
+// `hit_f(VoxelSingleValue value, const VoxelRaycastState &rs) -> bool` tells if the ray stops at a voxel.
+// Thread-safe.
+template <typename CanHit_F, typename Hit_F>
+bool raycast_voxel_data(
+		const VoxelData &data,
+		const unsigned int channel,
+		const VoxelSingleValue defval,
+		const Vector3 ray_origin,
+		const Vector3 ray_direction,
+		const float max_distance,
+		CanHit_F can_hit_f,
+		Hit_F hit_f,
+		VoxelDataRaycastHit &out_hit
+) {
+	VoxelData::BlockReader reader(data, channel, defval);
+
+	auto block_predicate = [&reader, &can_hit_f](const Vector3i block_position) {
+		VoxelSingleValue min_value;
+		VoxelSingleValue max_value;
+		if (reader.enter_block(block_position, min_value, max_value)) {
+			return can_hit_f(min_value, max_value);
+		}
+		return true;
+	};
+
+	auto cell_predicate = [&reader, &hit_f](const VoxelRaycastState &rs) {
+		return hit_f(reader.get_voxel(rs.hit_position), rs);
+	};
+
+	return voxel_raycast_hierarchical(
+			ray_origin,
+			ray_direction,
+			data.get_block_size_po2(),
+			block_predicate,
+			cell_predicate,
+			max_distance,
+			out_hit.position,
+			out_hit.previous_position,
+			out_hit.distance_along_ray,
+			out_hit.distance_along_ray_prev
+	);
+}
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_DATA_RAYCAST_H
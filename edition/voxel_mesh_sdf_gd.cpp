@@ -153,11 +153,15 @@ void VoxelMeshSDF::bake() {
 					sdf_grid, res, to_span(triangles), chunk_grid, box_min_pos, box_max_pos, _boundary_sign_fix
 			);
 		} break;
+		case BAKE_MODE_ACCURATE_BVH:
+			mesh_sdf::generate_mesh_sdf_bvh(sdf_grid, res, to_span(triangles), box_min_pos, box_max_pos);
+			break;
 		default:
 			ZN_CRASH();
 	}
 
-	if (_boundary_sign_fix && _bake_mode != BAKE_MODE_APPROX_FLOODFILL) {
+	// Signs from winding numbers are already reliable
+	if (_boundary_sign_fix && _bake_mode != BAKE_MODE_APPROX_FLOODFILL && _bake_mode != BAKE_MODE_ACCURATE_BVH) {
 		mesh_sdf::fix_sdf_sign_from_boundary(sdf_grid, res, min_pos, max_pos);
 	}
 
@@ -325,6 +329,19 @@ void VoxelMeshSDF::bake_async(SceneTree *scene_tree) {
 					L::notify_on_complete(**obj_to_notify, *shared_data);
 				} break;
 
+				case BAKE_MODE_ACCURATE_BVH: {
+					VoxelBuffer &buffer = shared_data->buffer;
+					Span<float> sdf_grid;
+					ZN_ASSERT(buffer.get_channel_data(channel, sdf_grid));
+
+					// Runs in parallel on its own
+					mesh_sdf::generate_mesh_sdf_bvh(
+							sdf_grid, res, to_span(shared_data->triangles), box_min_pos, box_max_pos
+					);
+
+					L::notify_on_complete(**obj_to_notify, *shared_data);
+				} break;
+
 				default:
 					ZN_PRINT_ERROR(format("Invalid bake mode {}", bake_mode));
 					report_error();
@@ -559,7 +576,7 @@ void VoxelMeshSDF::_bind_methods() {
 					Variant::INT,
 					"bake_mode",
 					PROPERTY_HINT_ENUM,
-					"AccurateNaive,AccuratePartitioned,ApproxInterp,FloodFill"
+					"AccurateNaive,AccuratePartitioned,ApproxInterp,FloodFill,AccurateBVH"
 			),
 			"set_bake_mode",
 			"get_bake_mode"
@@ -595,6 +612,7 @@ void VoxelMeshSDF::_bind_methods() {
 	BIND_ENUM_CONSTANT(BAKE_MODE_ACCURATE_PARTITIONED);
 	BIND_ENUM_CONSTANT(BAKE_MODE_APPROX_INTERP);
 	BIND_ENUM_CONSTANT(BAKE_MODE_APPROX_FLOODFILL);
+	BIND_ENUM_CONSTANT(BAKE_MODE_ACCURATE_BVH);
 	BIND_ENUM_CONSTANT(BAKE_MODE_COUNT);
 }
 
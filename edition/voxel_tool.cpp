@@ -1,10 +1,14 @@
 #include "voxel_tool.h"
+#include "../engine/parallel_for.h"
 #include "../storage/voxel_buffer_gd.h"
+#include "../util/containers/std_vector.h"
+#include "../util/godot/core/array.h"
 #include "../util/godot/core/packed_arrays.h"
 #include "../util/io/log.h"
 #include "../util/math/color8.h"
 #include "../util/math/conv.h"
 #include "../util/profiling.h"
+#include "voxel_data_raycast.h"
 
 namespace zylann::voxel {
 
@@ -91,6 +95,74 @@ Ref<VoxelRaycastResult> VoxelTool::raycast(Vector3 pos, Vector3 dir, float max_d
 	// See derived classes for implementations
 }
 
+void VoxelTool::raycast_batch(
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		float max_distance,
+		uint32_t collision_mask,
+		bool use_threads,
+		Span<Ref<VoxelRaycastResult>> out_results
+) {
+	ZN_ASSERT_RETURN(origins.size() == directions.size());
+	ZN_ASSERT_RETURN(out_results.size() == origins.size());
+	// Default implementation, see derived classes for faster ones
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		out_results[i] = raycast(origins[i], directions[i], max_distance, collision_mask);
+	}
+}
+
+void VoxelTool::run_raycast_batch(
+		const IRayCaster &caster,
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		float max_distance,
+		bool use_threads,
+		Span<Ref<VoxelRaycastResult>> out_results
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(origins.size() == directions.size());
+	ZN_ASSERT_RETURN(out_results.size() == origins.size());
+
+	StdVector<VoxelDataRaycastHit> hits;
+	hits.resize(origins.size());
+	// Not using `bool`, because `std::vector<bool>` elements can't be written from different threads
+	StdVector<uint8_t> hit_flags;
+	hit_flags.resize(origins.size(), 0);
+
+	auto cast_rays = [&caster, origins, directions, max_distance, &hits, &hit_flags](
+							 unsigned int begin, unsigned int end
+					 ) {
+		for (unsigned int i = begin; i < end; ++i) {
+			hit_flags[i] = caster.cast(origins[i], directions[i], max_distance, hits[i]);
+		}
+	};
+
+	if (use_threads) {
+		// Rays are cheap individually, so they are distributed in groups
+		parallel_for_ranges(origins.size(), 64, cast_rays);
+	} else {
+		cast_rays(0, origins.size());
+	}
+
+	// Results are reference-counted Godot objects, so they are created on the calling thread
+	for (unsigned int i = 0; i < hits.size(); ++i) {
+		if (hit_flags[i] != 0) {
+			out_results[i] = make_raycast_result(hits[i]);
+		} else {
+			out_results[i] = Ref<VoxelRaycastResult>();
+		}
+	}
+}
+
+Ref<VoxelRaycastResult> VoxelTool::make_raycast_result(const VoxelDataRaycastHit &hit) {
+	Ref<VoxelRaycastResult> res;
+	res.instantiate();
+	res->position = hit.position;
+	res->previous_position = hit.previous_position;
+	res->distance_along_ray = hit.distance_along_ray;
+	return res;
+}
+
 uint64_t VoxelTool::get_voxel(Vector3i pos) const {
 	return _get_voxel(pos);
 }
@@ -105,6 +177,7 @@ void VoxelTool::set_voxel(Vector3i pos, uint64_t v) {
 		ZN_PRINT_WARNING("Area not editable");
 		return;
 	}
+	_pre_edit(box);
 	_set_voxel(pos, v);
 	_post_edit(box);
 }
@@ -115,6 +188,7 @@ void VoxelTool::set_voxel_f(Vector3i pos, float v) {
 		ZN_PRINT_WARNING("Area not editable");
 		return;
 	}
+	_pre_edit(box);
 	_set_voxel_f(pos, v);
 	_post_edit(box);
 }
@@ -124,6 +198,7 @@ void VoxelTool::do_point(Vector3i pos) {
 	if (!is_area_editable(box)) {
 		return;
 	}
+	_pre_edit(box);
 	if (_channel == VoxelBuffer::CHANNEL_SDF) {
 		// Not consistent SDF, but should work
 		_set_voxel_f(pos, _mode == MODE_REMOVE ? constants::SDF_FAR_OUTSIDE : constants::SDF_FAR_INSIDE);
@@ -169,6 +244,8 @@ void VoxelTool::do_sphere(Vector3 p_center, float radius) {
 		return;
 	}
 
+	_pre_edit(box);
+
 	if (_channel == VoxelBuffer::CHANNEL_SDF) {
 		const Vector3f center = to_vec3f(p_center);
 		box.for_each_cell([this, center, radius](Vector3i pos) {
@@ -206,6 +283,8 @@ void VoxelTool::sdf_stamp_erase(const VoxelBuffer &stamp, Vector3i pos) {
 		return;
 	}
 
+	_pre_edit(box);
+
 	box.for_each_cell_zxy([this, &stamp, pos](Vector3i pos_in_volume) {
 		const Vector3i pos_in_stamp = pos_in_volume - pos;
 		const float dst_sdf =
@@ -231,6 +310,8 @@ void VoxelTool::do_box(Vector3i begin, Vector3i end) {
 		return;
 	}
 
+	_pre_edit(box);
+
 	if (_channel == VoxelBuffer::CHANNEL_SDF) {
 		// TODO Better quality
 		// Not consistent SDF, but should work ok
@@ -331,9 +412,10 @@ void VoxelTool::smooth_sphere(Vector3 sphere_center, float sphere_radius, int bl
 
 		VoxelBuffer smooth_buffer(VoxelBuffer::ALLOCATOR_POOL);
 		const Vector3f relative_sphere_center = to_vec3f(sphere_center - to_vec3(voxel_box.position));
-		ops::box_blur(buffer, smooth_buffer, blur_radius, relative_sphere_center, sphere_radius);
+		Box3i changed_box;
+		ops::box_blur(buffer, smooth_buffer, blur_radius, relative_sphere_center, sphere_radius, changed_box);
 
-		paste(voxel_box.position, smooth_buffer, (1 << VoxelBuffer::CHANNEL_SDF));
+		paste_sdf_area(voxel_box.position, smooth_buffer, changed_box);
 
 	} else {
 		ERR_PRINT("Not implemented");
@@ -367,24 +449,67 @@ void VoxelTool::grow_sphere(Vector3 sphere_center, float sphere_radius, float st
 		const Vector3f relative_sphere_center = to_vec3f(sphere_center - to_vec3(voxel_box.position));
 		const float signed_strength = _mode == VoxelTool::MODE_REMOVE ? -strength : strength;
 
-		ops::grow_sphere(buffer, _sdf_scale * signed_strength, relative_sphere_center, sphere_radius);
+		Box3i changed_box;
+		ops::grow_sphere(buffer, _sdf_scale * signed_strength, relative_sphere_center, sphere_radius, changed_box);
 
-		paste(voxel_box.position, buffer, (1 << VoxelBuffer::CHANNEL_SDF));
+		paste_sdf_area(voxel_box.position, buffer, changed_box);
 
 	} else {
 		ERR_PRINT("Not implemented");
 	}
 }
 
+void VoxelTool::paste_sdf_area(Vector3i pos, const VoxelBuffer &voxels, const Box3i &changed_box) {
+	if (changed_box.is_empty()) {
+		// Don't trigger an edit if nothing changed, which can happen when smoothing an already smooth area
+		return;
+	}
+	if (changed_box.size == voxels.get_size()) {
+		paste(pos, voxels, (1 << VoxelBuffer::CHANNEL_SDF));
+		return;
+	}
+	VoxelBuffer changed_voxels(VoxelBuffer::ALLOCATOR_POOL);
+	changed_voxels.set_channel_depth(VoxelBuffer::CHANNEL_SDF, voxels.get_channel_depth(VoxelBuffer::CHANNEL_SDF));
+	changed_voxels.create(changed_box.size);
+	changed_voxels.copy_channel_from(
+			voxels, changed_box.position, changed_box.position + changed_box.size, Vector3i(), VoxelBuffer::CHANNEL_SDF
+	);
+	paste(pos + changed_box.position, changed_voxels, (1 << VoxelBuffer::CHANNEL_SDF));
+}
+
 bool VoxelTool::is_area_editable(const Box3i &box) const {
 	ERR_PRINT("Not implemented");
 	return false;
 }
 
+void VoxelTool::_pre_edit(const Box3i &box) {
+	// Optional
+}
+
 void VoxelTool::_post_edit(const Box3i &box) {
 	ERR_PRINT("Not implemented");
 }
 
+bool VoxelTool::undo_edit() {
+	ERR_PRINT("Not implemented");
+	return false;
+}
+
+bool VoxelTool::redo_edit() {
+	ERR_PRINT("Not implemented");
+	return false;
+}
+
+uint32_t VoxelTool::get_edit_tick() const {
+	ERR_PRINT("Not implemented");
+	return 0;
+}
+
+bool VoxelTool::seek_edit_tick(uint32_t tick) {
+	ERR_PRINT("Not implemented");
+	return false;
+}
+
 void VoxelTool::set_voxel_metadata(Vector3i pos, Variant meta) {
 	ERR_PRINT("Not implemented");
 }
@@ -416,6 +541,28 @@ Ref<VoxelRaycastResult> VoxelTool::_b_raycast(Vector3 pos, Vector3 dir, float ma
 	return raycast(pos, dir, max_distance, collision_mask);
 }
 
+Array VoxelTool::_b_raycast_batch(
+		PackedVector3Array origins,
+		PackedVector3Array directions,
+		float max_distance,
+		uint32_t collision_mask,
+		bool use_threads
+) {
+	ERR_FAIL_COND_V(origins.size() != directions.size(), Array());
+
+	StdVector<Ref<VoxelRaycastResult>> results;
+	results.resize(origins.size());
+
+	raycast_batch(to_span(origins), to_span(directions), max_distance, collision_mask, use_threads, to_span(results));
+
+	Array array;
+	array.resize(results.size());
+	for (unsigned int i = 0; i < results.size(); ++i) {
+		array[i] = results[i];
+	}
+	return array;
+}
+
 void VoxelTool::_b_do_point(Vector3i pos) {
 	do_point(pos);
 }
@@ -550,6 +697,11 @@ void VoxelTool::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_voxel_metadata", "pos", "meta"), &VoxelTool::_b_set_voxel_metadata);
 	ClassDB::bind_method(D_METHOD("get_voxel_metadata", "pos"), &VoxelTool::_b_get_voxel_metadata);
 
+	ClassDB::bind_method(D_METHOD("undo_edit"), &VoxelTool::undo_edit);
+	ClassDB::bind_method(D_METHOD("redo_edit"), &VoxelTool::redo_edit);
+	ClassDB::bind_method(D_METHOD("get_edit_tick"), &VoxelTool::get_edit_tick);
+	ClassDB::bind_method(D_METHOD("seek_edit_tick", "tick"), &VoxelTool::seek_edit_tick);
+
 	ClassDB::bind_method(D_METHOD("copy", "src_pos", "dst_buffer", "channels_mask"), &VoxelTool::_b_copy);
 	ClassDB::bind_method(D_METHOD("paste", "dst_pos", "src_buffer", "channels_mask"), &VoxelTool::_b_paste);
 	ClassDB::bind_method(
@@ -577,6 +729,14 @@ void VoxelTool::_bind_methods() {
 			DEFVAL(0xffffffff)
 	);
 
+	ClassDB::bind_method(
+			D_METHOD("raycast_batch", "origins", "directions", "max_distance", "collision_mask", "use_threads"),
+			&VoxelTool::_b_raycast_batch,
+			DEFVAL(10.0),
+			DEFVAL(0xffffffff),
+			DEFVAL(false)
+	);
+
 	ClassDB::bind_method(D_METHOD("is_area_editable", "box"), &VoxelTool::_b_is_area_editable);
 
 	// Encoding helpers
@@ -12,6 +12,8 @@
 
 namespace zylann::voxel {
 
+struct VoxelDataRaycastHit;
+
 // High-level voxel editing interface.
 // It's not a class to instantiate alone, get it from the voxel objects you want to work with.
 // There might be some overhead, so if a specific case needs optimization, it may be implemented with the underlying
@@ -102,12 +104,33 @@ public:
 
 	virtual Ref<VoxelRaycastResult> raycast(Vector3 pos, Vector3 dir, float max_distance, uint32_t collision_mask);
 
+	// Casts many rays at once. Results are in the same order as rays, and are null where nothing was hit.
+	// Implementations may be faster than calling `raycast` for each ray, and may use multiple threads.
+	virtual void raycast_batch(
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			float max_distance,
+			uint32_t collision_mask,
+			bool use_threads,
+			Span<Ref<VoxelRaycastResult>> out_results
+	);
+
 	// Checks if an edit affecting the given box can be applied, fully or partially
 	virtual bool is_area_editable(const Box3i &box) const;
 
 	virtual void set_voxel_metadata(Vector3i pos, Variant meta);
 	virtual Variant get_voxel_metadata(Vector3i pos) const;
 
+	// Edit journal of the edited volume, if it has one and it is enabled.
+	// Undoes the latest edit. Returns false if there is nothing to undo.
+	virtual bool undo_edit();
+	// Applies again the latest undone edit. Returns false if there is nothing to redo.
+	virtual bool redo_edit();
+	// Identifies the current state of edits. It is incremented by edits and redos, and decremented by undos.
+	virtual uint32_t get_edit_tick() const;
+	// Undoes or redoes edits until the given tick is reached. Returns false if the journal doesn't go that far.
+	virtual bool seek_edit_tick(uint32_t tick);
+
 protected:
 	static void _bind_methods();
 
@@ -117,9 +140,34 @@ protected:
 	virtual float _get_voxel_f(Vector3i pos) const;
 	virtual void _set_voxel(Vector3i pos, uint64_t v);
 	virtual void _set_voxel_f(Vector3i pos, float v);
+	// Called before voxels are modified by an edit, and `_post_edit` is called after.
+	virtual void _pre_edit(const Box3i &box);
 	virtual void _post_edit(const Box3i &box);
 
+	// Casts a single ray for `run_raycast_batch`. Must be thread-safe when the batch uses threads.
+	class IRayCaster {
+	public:
+		virtual ~IRayCaster() {}
+		virtual bool cast(Vector3 origin, Vector3 direction, float max_distance, VoxelDataRaycastHit &out_hit)
+				const = 0;
+	};
+
+	// Common implementation of `raycast_batch` for tools casting rays with `VoxelDataRaycastHit`.
+	static void run_raycast_batch(
+			const IRayCaster &caster,
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			float max_distance,
+			bool use_threads,
+			Span<Ref<VoxelRaycastResult>> out_results
+	);
+
+	static Ref<VoxelRaycastResult> make_raycast_result(const VoxelDataRaycastHit &hit);
+
 private:
+	// Pastes only the SDF of voxels within `changed_box`, a box relative to `voxels`.
+	void paste_sdf_area(Vector3i pos, const VoxelBuffer &voxels, const Box3i &changed_box);
+
 	// Bindings to convert to more specialized C++ types and handle virtuality,
 	// cuz I don't know if it works by binding straight
 
@@ -128,6 +176,13 @@ private:
 	void _b_set_voxel(Vector3i pos, uint64_t v);
 	void _b_set_voxel_f(Vector3i pos, float v);
 	Ref<VoxelRaycastResult> _b_raycast(Vector3 pos, Vector3 dir, float max_distance, uint32_t collision_mask);
+	Array _b_raycast_batch(
+			PackedVector3Array origins,
+			PackedVector3Array directions,
+			float max_distance,
+			uint32_t collision_mask,
+			bool use_threads
+	);
 	void _b_do_point(Vector3i pos);
 	void _b_do_sphere(Vector3 pos, float radius);
 	void _b_do_box(Vector3i begin, Vector3i end);
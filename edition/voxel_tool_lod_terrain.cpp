@@ -1,5 +1,6 @@
 #include "voxel_tool_lod_terrain.h"
 #include "../constants/voxel_string_names.h"
+#include "../engine/parallel_for.h"
 #include "../generators/graph/voxel_generator_graph.h"
 #include "../meshers/blocky/voxel_mesher_blocky.h"
 #include "../storage/voxel_buffer_gd.h"
@@ -17,8 +18,8 @@
 #include "../util/math/conv.h"
 #include "../util/string/format.h"
 #include "../util/tasks/async_dependency_tracker.h"
-#include "../util/voxel_raycast.h"
 #include "funcs.h"
+#include "voxel_data_raycast.h"
 #include "voxel_mesh_sdf_gd.h"
 
 namespace zylann::voxel {
@@ -85,41 +86,33 @@ float approximate_distance_to_isosurface_binary_search(
 	}
 }
 
-Ref<VoxelRaycastResult> VoxelToolLodTerrain::raycast(
+namespace {
+
+// Thread-safe.
+bool raycast_lod_terrain(
+		const VoxelData &data,
 		Vector3 pos,
 		Vector3 dir,
 		float max_distance,
-		uint32_t collision_mask
+		int binary_search_iterations,
+		VoxelDataRaycastHit &out_hit
 ) {
 	// TODO Transform input if the terrain is rotated
 	// TODO Implement reverse raycast? (going from inside ground to air, could be useful for undigging)
 
-	// TODO Optimization: voxel raycast uses `get_voxel` which is the slowest, but could be made faster.
-	// Instead, do a broad-phase on blocks. If a block's voxels need to be parsed, get all positions the ray could go
-	// through in that block, then query them all at once (better for bulk processing without going again through
-	// locking and data structures, and allows SIMD). Then check results in order.
-	// If no hit is found, carry on with next blocks.
-
-	struct RaycastPredicate {
-		VoxelData &data;
-
-		bool operator()(const VoxelRaycastState &rs) {
-			// This is not particularly optimized, but runs fast enough for player raycasts
-			VoxelSingleValue defval;
-			defval.f = constants::SDF_FAR_OUTSIDE;
-			const VoxelSingleValue v = data.get_voxel(rs.hit_position, VoxelBuffer::CHANNEL_SDF, defval);
-			return v.f < 0;
-		}
+	// We use grid-raycast as a middle-phase to roughly detect where the hit will be.
+	// Voxels are read one block at a time, and blocks where all SDF values are outside of matter are skipped, so long
+	// rays cost mostly in proportion to the number of blocks they cross. Where LOD0 is not loaded, ranges of lower LOD
+	// blocks are used.
+	auto can_hit = [](VoxelSingleValue min_value, VoxelSingleValue max_value) { //
+		return min_value.f < 0;
 	};
+	auto hit_f = [](VoxelSingleValue v, const VoxelRaycastState &rs) { //
+		return v.f < 0;
+	};
+	VoxelSingleValue defval;
+	defval.f = constants::SDF_FAR_OUTSIDE;
 
-	Ref<VoxelRaycastResult> res;
-
-	// We use grid-raycast as a middle-phase to roughly detect where the hit will be
-	RaycastPredicate predicate = { _terrain->get_storage() };
-	Vector3i hit_pos;
-	Vector3i prev_pos;
-	float hit_distance;
-	float hit_distance_prev;
 	// Voxels polygonized using marching cubes influence a region centered on their lower corner,
 	// and extend up to 0.5 units in all directions.
 	//
@@ -136,42 +129,91 @@ Ref<VoxelRaycastResult> VoxelToolLodTerrain::raycast(
 	// `voxel_raycast` operates on a discrete grid of cubic voxels, so to account for the smooth interpolation,
 	// we may offset the ray so that cubes act as if they were centered on the filtered result.
 	const Vector3 offset(0.5, 0.5, 0.5);
-	if (voxel_raycast(pos + offset, dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev)) {
-		// Approximate surface
+	if (!raycast_voxel_data(
+				data, VoxelBuffer::CHANNEL_SDF, defval, pos + offset, dir, max_distance, can_hit, hit_f, out_hit
+		)) {
+		return false;
+	}
 
-		float d = hit_distance;
+	// Approximate surface
 
-		if (_raycast_binary_search_iterations > 0) {
-			// This is not particularly optimized, but runs fast enough for player raycasts
-			struct VolumeSampler {
-				VoxelData &data;
+	if (binary_search_iterations > 0) {
+		// This is not particularly optimized, but runs fast enough for player raycasts
+		struct VolumeSampler {
+			const VoxelData &data;
 
-				inline float operator()(const Vector3i &pos) const {
-					VoxelSingleValue defval;
-					defval.f = constants::SDF_FAR_OUTSIDE;
-					const VoxelSingleValue value = data.get_voxel(pos, VoxelBuffer::CHANNEL_SDF, defval);
-					return value.f;
-				}
-			};
-
-			VolumeSampler sampler{ _terrain->get_storage() };
-			d = hit_distance_prev +
-					approximate_distance_to_isosurface_binary_search(
-							sampler,
-							pos + dir * hit_distance_prev,
-							dir,
-							hit_distance - hit_distance_prev,
-							_raycast_binary_search_iterations
-					);
-		}
+			inline float operator()(const Vector3i &pos) const {
+				VoxelSingleValue defval;
+				defval.f = constants::SDF_FAR_OUTSIDE;
+				const VoxelSingleValue value = data.get_voxel(pos, VoxelBuffer::CHANNEL_SDF, defval);
+				return value.f;
+			}
+		};
+
+		VolumeSampler sampler{ data };
+		out_hit.distance_along_ray = out_hit.distance_along_ray_prev +
+				approximate_distance_to_isosurface_binary_search(
+						sampler,
+						pos + dir * out_hit.distance_along_ray_prev,
+						dir,
+						out_hit.distance_along_ray - out_hit.distance_along_ray_prev,
+						binary_search_iterations
+				);
+	}
 
-		res.instantiate();
-		res->position = hit_pos;
-		res->previous_position = prev_pos;
-		res->distance_along_ray = d;
+	return true;
+}
+
+} // namespace
+
+Ref<VoxelRaycastResult> VoxelToolLodTerrain::raycast(
+		Vector3 pos,
+		Vector3 dir,
+		float max_distance,
+		uint32_t collision_mask
+) {
+	ERR_FAIL_COND_V(_terrain == nullptr, Ref<VoxelRaycastResult>());
+
+	VoxelDataRaycastHit hit;
+	if (raycast_lod_terrain(
+				_terrain->get_storage(), pos, dir, max_distance, _raycast_binary_search_iterations, hit
+		)) {
+		return make_raycast_result(hit);
 	}
+	return Ref<VoxelRaycastResult>();
+}
+
+void VoxelToolLodTerrain::raycast_batch(
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		float max_distance,
+		uint32_t collision_mask,
+		bool use_threads,
+		Span<Ref<VoxelRaycastResult>> out_results
+) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
 
-	return res;
+	struct LodTerrainRayCaster : IRayCaster {
+		const VoxelData &data;
+		const int binary_search_iterations;
+
+		LodTerrainRayCaster(const VoxelData &p_data, int p_binary_search_iterations) :
+				data(p_data), binary_search_iterations(p_binary_search_iterations) {}
+
+		bool cast(Vector3 origin, Vector3 direction, float max_distance, VoxelDataRaycastHit &out_hit) const override {
+			return raycast_lod_terrain(data, origin, direction, max_distance, binary_search_iterations, out_hit);
+		}
+	};
+
+	run_raycast_batch(
+			LodTerrainRayCaster(_terrain->get_storage(), _raycast_binary_search_iterations),
+			origins,
+			directions,
+			max_distance,
+			use_threads,
+			out_results
+	);
 }
 
 void VoxelToolLodTerrain::do_box(Vector3i begin, Vector3i end) {
@@ -197,6 +239,7 @@ void VoxelToolLodTerrain::do_box(Vector3i begin, Vector3i end) {
 	VoxelData &data = _terrain->get_storage();
 
 	data.pre_generate_box(op.box);
+	_pre_edit(op.box);
 
 	VoxelDataGrid grid;
 	data.get_blocks_grid(grid, op.box, 0);
@@ -235,6 +278,7 @@ void VoxelToolLodTerrain::do_sphere(Vector3 center, float radius) {
 	VoxelData &data = _terrain->get_storage();
 
 	data.pre_generate_box(world_box);
+	_pre_edit(world_box);
 	data.get_blocks_grid(op.blocks, world_box, 0);
 
 	// We can use floats by doing the operation in local space
@@ -274,6 +318,7 @@ void VoxelToolLodTerrain::do_hemisphere(Vector3 center, float radius, Vector3 fl
 	VoxelData &data = _terrain->get_storage();
 
 	data.pre_generate_box(op.box);
+	_pre_edit(op.box);
 
 	VoxelDataGrid grid;
 	data.get_blocks_grid(grid, op.box, 0);
@@ -366,6 +411,7 @@ void VoxelToolLodTerrain::paste(Vector3i pos, const VoxelBuffer &src, uint8_t ch
 	VoxelData &data = _terrain->get_storage();
 
 	data.pre_generate_box(box);
+	_pre_edit(box);
 	data.paste(pos, src, channels_mask, false);
 
 	_post_edit(box);
@@ -415,9 +461,50 @@ void VoxelToolLodTerrain::_set_voxel_f(Vector3i pos, float v) {
 	// No post_update, the parent class does it, it's a generic slow implementation.
 }
 
+void VoxelToolLodTerrain::_pre_edit(const Box3i &box) {
+	ERR_FAIL_COND(_terrain == nullptr);
+	_terrain->get_storage().begin_journaled_edit(box, _journal_snapshot);
+}
+
 void VoxelToolLodTerrain::_post_edit(const Box3i &box) {
 	ERR_FAIL_COND(_terrain == nullptr);
+	_terrain->get_storage().end_journaled_edit(_journal_snapshot);
+	_terrain->post_edit_area(box, true);
+}
+
+bool VoxelToolLodTerrain::undo_edit() {
+	ERR_FAIL_COND_V(_terrain == nullptr, false);
+	Box3i box;
+	if (!_terrain->get_storage().undo_edit(box)) {
+		return false;
+	}
 	_terrain->post_edit_area(box, true);
+	return true;
+}
+
+bool VoxelToolLodTerrain::redo_edit() {
+	ERR_FAIL_COND_V(_terrain == nullptr, false);
+	Box3i box;
+	if (!_terrain->get_storage().redo_edit(box)) {
+		return false;
+	}
+	_terrain->post_edit_area(box, true);
+	return true;
+}
+
+uint32_t VoxelToolLodTerrain::get_edit_tick() const {
+	ERR_FAIL_COND_V(_terrain == nullptr, 0);
+	return _terrain->get_storage().get_edit_tick();
+}
+
+bool VoxelToolLodTerrain::seek_edit_tick(uint32_t tick) {
+	ERR_FAIL_COND_V(_terrain == nullptr, false);
+	Box3i box;
+	const bool reached = _terrain->get_storage().seek_edit_tick(tick, box);
+	if (!box.is_empty()) {
+		_terrain->post_edit_area(box, true);
+	}
+	return reached;
 }
 
 int VoxelToolLodTerrain::get_raycast_binary_search_iterations() const {
@@ -428,7 +515,7 @@ void VoxelToolLodTerrain::set_raycast_binary_search_iterations(int iterations) {
 	_raycast_binary_search_iterations = math::clamp(iterations, 0, 16);
 }
 
-void box_propagate_ccl(Span<uint8_t> cells, const Vector3i size) {
+void box_propagate_ccl(Span<uint32_t> cells, const Vector3i size) {
 	ZN_PROFILE_SCOPE();
 
 	// Propagate non-zero cells towards zero cells in a 3x3x3 pattern.
@@ -447,7 +534,7 @@ void box_propagate_ccl(Span<uint8_t> cells, const Vector3i size) {
 				pos.z = 2;
 				i = Vector3iUtil::get_zxy_index(pos, size);
 				for (; pos.z < size.z - 2; ++pos.z, i += dz) {
-					const uint8_t c = cells[i];
+					const uint32_t c = cells[i];
 					if (c != 0) {
 						if (cells[i - dz] == 0) {
 							cells[i - dz] = c;
@@ -475,7 +562,7 @@ void box_propagate_ccl(Span<uint8_t> cells, const Vector3i size) {
 				pos.x = 2;
 				i = Vector3iUtil::get_zxy_index(pos, size);
 				for (; pos.x < size.x - 2; ++pos.x, i += dx) {
-					const uint8_t c = cells[i];
+					const uint32_t c = cells[i];
 					if (c != 0) {
 						if (cells[i - dx] == 0) {
 							cells[i - dx] = c;
@@ -502,7 +589,7 @@ void box_propagate_ccl(Span<uint8_t> cells, const Vector3i size) {
 				pos.y = 2;
 				i = Vector3iUtil::get_zxy_index(pos, size);
 				for (; pos.y < size.y - 2; ++pos.y, i += dy) {
-					const uint8_t c = cells[i];
+					const uint32_t c = cells[i];
 					if (c != 0) {
 						if (cells[i - dy] == 0) {
 							cells[i - dy] = c;
@@ -553,7 +640,7 @@ Array separate_floating_chunks(
 
 	// Label distinct voxel groups
 
-	static thread_local StdVector<uint8_t> ccl_output;
+	static thread_local StdVector<uint32_t> ccl_output;
 	ccl_output.resize(Vector3iUtil::get_volume(world_box.size));
 
 	unsigned int label_count = 0;
@@ -561,16 +648,19 @@ Array separate_floating_chunks(
 	{
 		// TODO Allow to run the algorithm at a different LOD, to trade precision for speed
 		ZN_PROFILE_SCOPE_NAMED("CCL scan");
-		IslandFinder island_finder;
-		island_finder.scan_3d(
-				Box3i(Vector3i(), world_box.size),
-				[&source_copy_buffer](Vector3i pos) {
+		BlockIslandFinder island_finder;
+		island_finder.begin(world_box.size, 16, to_span(ccl_output));
+		// Blocks are scanned in parallel, the source buffer is only read
+		auto scan_blocks = [&island_finder, &source_copy_buffer](unsigned int begin, unsigned int end) {
+			for (unsigned int block_index = begin; block_index < end; ++block_index) {
+				island_finder.scan_block(block_index, [&source_copy_buffer](Vector3i pos) {
 					// TODO Can be optimized further with direct access
 					return source_copy_buffer.get_voxel_f(pos.x, pos.y, pos.z, main_channel) < 0.f;
-				},
-				to_span(ccl_output),
-				&label_count
-		);
+				});
+			}
+		};
+		parallel_for_ranges(island_finder.get_block_count(), 4, scan_blocks);
+		label_count = island_finder.finish();
 	}
 
 	struct Bounds {
@@ -600,7 +690,7 @@ Array separate_floating_chunks(
 			for (int x = 0; x < world_box.size.x; ++x) {
 				for (int y = 0; y < world_box.size.y; ++y) {
 					CRASH_COND(ccl_index >= ccl_output.size());
-					const uint8_t label = ccl_output[ccl_index];
+					const uint32_t label = ccl_output[ccl_index];
 					++ccl_index;
 
 					if (label == 0) {
@@ -710,7 +800,7 @@ Array separate_floating_chunks(
 					for (int y = local_bounds.min_pos.y; y <= local_bounds.max_pos.y; ++y) {
 						const unsigned int ccl_index = Vector3iUtil::get_zxy_index(Vector3i(x, y, z), world_box.size);
 						CRASH_COND(ccl_index >= ccl_output.size());
-						const uint8_t label2 = ccl_output[ccl_index];
+						const uint32_t label2 = ccl_output[ccl_index];
 
 						if (label2 != 0 && label != label2) {
 							buffer.set_voxel_f(
@@ -975,6 +1065,7 @@ void VoxelToolLodTerrain::stamp_sdf(
 	VoxelData &data = _terrain->get_storage();
 
 	data.pre_generate_box(voxel_box);
+	_pre_edit(voxel_box);
 
 	// TODO Maybe more efficient to "rasterize" the box? We're going to iterate voxels the box doesn't intersect.
 	// TODO Maybe we should scale SDF values based on the scale of the transform too
@@ -1027,6 +1118,7 @@ void VoxelToolLodTerrain::do_graph(Ref<VoxelGeneratorGraph> graph, Transform3D t
 	VoxelData &data = _terrain->get_storage();
 
 	data.pre_generate_box(box);
+	_pre_edit(box);
 
 	const unsigned int channel_index = VoxelBuffer::CHANNEL_SDF;
 
@@ -1158,6 +1250,37 @@ void VoxelToolLodTerrain::run_blocky_random_tick(
 	);
 }
 
+void VoxelToolLodTerrain::run_blocky_random_tick_per_block(
+		const AABB voxel_area,
+		const int voxels_per_block,
+		const Callable &callback
+) {
+	ZN_PROFILE_SCOPE();
+
+	ZN_ASSERT_RETURN(_terrain != nullptr);
+
+	Ref<VoxelMesherBlocky> mesher = _terrain->get_mesher();
+	ZN_ASSERT_RETURN_MSG(
+			mesher.is_valid(),
+			format("This function requires a volume using {} with a valid library", ZN_CLASS_NAME_C(VoxelMesherBlocky))
+	);
+	Ref<VoxelBlockyLibraryBase> library = mesher->get_library();
+	ZN_ASSERT_RETURN_MSG(library.is_valid(), format("{} has no library assigned", ZN_CLASS_NAME_C(VoxelMesherBlocky)));
+
+	ZN_ASSERT_RETURN(callback.is_valid());
+	ZN_ASSERT_RETURN(voxels_per_block >= 0);
+	ZN_ASSERT_RETURN(math::is_valid_size(voxel_area.size));
+
+	if (voxels_per_block == 0) {
+		return;
+	}
+
+	const VoxelData &data = _terrain->get_storage();
+	const uint64_t seed = (uint64_t(_random.rand()) << 32) | _random.rand();
+
+	zylann::voxel::run_blocky_random_tick_per_block(data, voxel_area, **library, seed, voxels_per_block, callback);
+}
+
 void VoxelToolLodTerrain::_bind_methods() {
 	using Self = VoxelToolLodTerrain;
 
@@ -1180,6 +1303,10 @@ void VoxelToolLodTerrain::_bind_methods() {
 			&Self::run_blocky_random_tick,
 			DEFVAL(16)
 	);
+	ClassDB::bind_method(
+			D_METHOD("run_blocky_random_tick_per_block", "area", "voxels_per_block", "callback"),
+			&Self::run_blocky_random_tick_per_block
+	);
 }
 
 } // namespace zylann::voxel
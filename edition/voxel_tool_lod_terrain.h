@@ -1,6 +1,7 @@
 #ifndef VOXEL_TOOL_LOD_TERRAIN_H
 #define VOXEL_TOOL_LOD_TERRAIN_H
 
+#include "../storage/voxel_edit_journal.h"
 #include "../util/godot/core/random_pcg.h"
 #include "../util/macros.h"
 #include "voxel_tool.h"
@@ -22,11 +23,24 @@ public:
 
 	bool is_area_editable(const Box3i &box) const override;
 	Ref<VoxelRaycastResult> raycast(Vector3 pos, Vector3 dir, float max_distance, uint32_t collision_mask) override;
+	void raycast_batch(
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			float max_distance,
+			uint32_t collision_mask,
+			bool use_threads,
+			Span<Ref<VoxelRaycastResult>> out_results
+	) override;
 	void do_box(Vector3i begin, Vector3i end) override;
 	void do_sphere(Vector3 center, float radius) override;
 	void copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const override;
 	void paste(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask) override;
 
+	bool undo_edit() override;
+	bool redo_edit() override;
+	uint32_t get_edit_tick() const override;
+	bool seek_edit_tick(uint32_t tick) override;
+
 	// Specialized API
 
 	int get_raycast_binary_search_iterations() const;
@@ -52,11 +66,14 @@ public:
 			const int block_batch_count
 	);
 
+	void run_blocky_random_tick_per_block(const AABB voxel_area, const int voxels_per_block, const Callable &callback);
+
 protected:
 	uint64_t _get_voxel(Vector3i pos) const override;
 	float _get_voxel_f(Vector3i pos) const override;
 	void _set_voxel(Vector3i pos, uint64_t v) override;
 	void _set_voxel_f(Vector3i pos, float v) override;
+	void _pre_edit(const Box3i &box) override;
 	void _post_edit(const Box3i &box) override;
 
 private:
@@ -65,6 +82,8 @@ private:
 	VoxelLodTerrain *_terrain = nullptr;
 	int _raycast_binary_search_iterations = 0;
 	RandomPCG _random;
+	// Voxels before the current edit, if the terrain has an edit journal
+	VoxelEditJournal::Snapshot _journal_snapshot;
 };
 
 } // namespace zylann::voxel
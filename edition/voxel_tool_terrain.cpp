@@ -1,4 +1,5 @@
 #include "voxel_tool_terrain.h"
+#include "../constants/voxel_constants.h"
 #include "../meshers/blocky/voxel_mesher_blocky.h"
 #include "../meshers/cubes/voxel_mesher_cubes.h"
 #include "../storage/metadata/voxel_metadata_variant.h"
@@ -9,7 +10,8 @@
 #include "../util/godot/core/array.h"
 #include "../util/godot/core/packed_arrays.h"
 #include "../util/math/conv.h"
-#include "../util/voxel_raycast.h"
+#include "../util/profiling.h"
+#include "voxel_data_raycast.h"
 
 using namespace zylann::godot;
 
@@ -31,132 +33,239 @@ bool VoxelToolTerrain::is_area_editable(const Box3i &box) const {
 	return _terrain->get_storage().is_area_loaded(box);
 }
 
-Ref<VoxelRaycastResult> VoxelToolTerrain::raycast(
+namespace {
+
+// Terrain-space raycast parameters, shared by rays of a batch
+struct RaycastParams {
+	enum Mode { MODE_BLOCKY, MODE_COLOR, MODE_SDF };
+
+	const VoxelData &data;
+	Mode mode;
+	// Only used in blocky mode
+	const VoxelBlockyLibraryBase::BakedData *baked_data;
+	uint32_t collision_mask;
+	Transform3D to_local;
+	float to_world_scale;
+};
+
+bool raycast_terrain(
+		const RaycastParams &params,
 		Vector3 p_pos,
 		Vector3 p_dir,
 		float p_max_distance,
-		uint32_t p_collision_mask
+		VoxelDataRaycastHit &out_hit
 ) {
-	// TODO Implement broad-phase on blocks to minimize locking and increase performance
-
-	// TODO Optimization: voxel raycast uses `get_voxel` which is the slowest, but could be made faster.
-	// See `VoxelToolLodTerrain` for information about how to implement improvements.
-
-	struct RaycastPredicateColor {
-		const VoxelData &data;
+	const Vector3 local_pos = params.to_local.xform(p_pos);
+	const Vector3 local_dir = params.to_local.basis.xform(p_dir).normalized();
+	const float max_distance = p_max_distance / params.to_world_scale;
+
+	bool hit = false;
+
+	switch (params.mode) {
+		case RaycastParams::MODE_BLOCKY: {
+			const VoxelBlockyLibraryBase::BakedData &baked_data = *params.baked_data;
+			const uint32_t collision_mask = params.collision_mask;
+			const Vector3 p_from = local_pos;
+			const Vector3 p_to = local_pos + local_dir * max_distance;
+
+			auto can_model_hit = [&baked_data, collision_mask](VoxelSingleValue v) {
+				if (!baked_data.has_model(v.i)) {
+					return false;
+				}
+				const VoxelBlockyModel::BakedData &model = baked_data.models[v.i];
+				return (model.box_collision_mask & collision_mask) != 0 && model.box_collision_aabbs.size() > 0;
+			};
+
+			auto can_hit = [&can_model_hit](VoxelSingleValue min_value, VoxelSingleValue max_value) {
+				// Model IDs are not ordered, so only uniform blocks can be skipped
+				return min_value.i != max_value.i || can_model_hit(min_value);
+			};
+
+			auto hit_f = [&baked_data, &can_model_hit, p_from, p_to](VoxelSingleValue v, const VoxelRaycastState &rs) {
+				if (!can_model_hit(v)) {
+					return false;
+				}
+				const VoxelBlockyModel::BakedData &model = baked_data.models[v.i];
+				for (const AABB &aabb : model.box_collision_aabbs) {
+					if (AABB(aabb.position + rs.hit_position, aabb.size).intersects_segment(p_from, p_to)) {
+						return true;
+					}
+				}
+				return false;
+			};
 
-		bool operator()(const VoxelRaycastState &rs) const {
 			VoxelSingleValue defval;
 			defval.i = 0;
-			const uint64_t v = data.get_voxel(rs.hit_position, VoxelBuffer::CHANNEL_COLOR, defval).i;
-			return v != 0;
-		}
-	};
+			hit = raycast_voxel_data(
+					params.data,
+					VoxelBuffer::CHANNEL_TYPE,
+					defval,
+					local_pos,
+					local_dir,
+					max_distance,
+					can_hit,
+					hit_f,
+					out_hit
+			);
+		} break;
+
+		case RaycastParams::MODE_COLOR: {
+			auto can_hit = [](VoxelSingleValue min_value, VoxelSingleValue max_value) { //
+				return min_value.i != 0 || max_value.i != 0;
+			};
+			auto hit_f = [](VoxelSingleValue v, const VoxelRaycastState &rs) { //
+				return v.i != 0;
+			};
+			VoxelSingleValue defval;
+			defval.i = 0;
+			hit = raycast_voxel_data(
+					params.data,
+					VoxelBuffer::CHANNEL_COLOR,
+					defval,
+					local_pos,
+					local_dir,
+					max_distance,
+					can_hit,
+					hit_f,
+					out_hit
+			);
+		} break;
+
+		case RaycastParams::MODE_SDF: {
+			auto can_hit = [](VoxelSingleValue min_value, VoxelSingleValue max_value) { //
+				return min_value.f < 0;
+			};
+			auto hit_f = [](VoxelSingleValue v, const VoxelRaycastState &rs) { //
+				return v.f < 0;
+			};
+			VoxelSingleValue defval;
+			defval.f = constants::SDF_FAR_OUTSIDE;
+			hit = raycast_voxel_data(
+					params.data,
+					VoxelBuffer::CHANNEL_SDF,
+					defval,
+					local_pos,
+					local_dir,
+					max_distance,
+					can_hit,
+					hit_f,
+					out_hit
+			);
+		} break;
+
+		default:
+			ZN_PRINT_ERROR("Unhandled raycast mode");
+			break;
+	}
 
-	struct RaycastPredicateSDF {
-		const VoxelData &data;
+	if (hit) {
+		out_hit.distance_along_ray *= params.to_world_scale;
+	}
+	return hit;
+}
 
-		bool operator()(const VoxelRaycastState &rs) const {
-			const float v = data.get_voxel_f(rs.hit_position, VoxelBuffer::CHANNEL_SDF);
-			return v < 0;
+} // namespace
+
+bool VoxelToolTerrain::get_raycast_mode(int &out_mode, Ref<VoxelBlockyLibraryBase> &out_library) const {
+	Ref<VoxelMesherBlocky> mesher_blocky;
+	Ref<VoxelMesherCubes> mesher_cubes;
+
+	if (try_get_as(_terrain->get_mesher(), mesher_blocky)) {
+		out_library = mesher_blocky->get_library();
+		if (out_library.is_null()) {
+			return false;
 		}
-	};
+		out_mode = RaycastParams::MODE_BLOCKY;
 
-	struct RaycastPredicateBlocky {
-		const VoxelData &data;
-		const VoxelBlockyLibraryBase::BakedData &baked_data;
-		const uint32_t collision_mask;
-		const Vector3 p_from;
-		const Vector3 p_to;
+	} else if (try_get_as(_terrain->get_mesher(), mesher_cubes)) {
+		out_mode = RaycastParams::MODE_COLOR;
 
-		bool operator()(const VoxelRaycastState &rs) const {
-			VoxelSingleValue defval;
-			defval.i = 0;
-			const int v = data.get_voxel(rs.hit_position, VoxelBuffer::CHANNEL_TYPE, defval).i;
+	} else {
+		out_mode = RaycastParams::MODE_SDF;
+	}
 
-			if (baked_data.has_model(v) == false) {
-				return false;
-			}
+	return true;
+}
 
-			const VoxelBlockyModel::BakedData &model = baked_data.models[v];
-			if ((model.box_collision_mask & collision_mask) == 0) {
-				return false;
-			}
+Ref<VoxelRaycastResult> VoxelToolTerrain::raycast(
+		Vector3 p_pos,
+		Vector3 p_dir,
+		float p_max_distance,
+		uint32_t p_collision_mask
+) {
+	ERR_FAIL_COND_V(_terrain == nullptr, Ref<VoxelRaycastResult>());
 
-			for (const AABB &aabb : model.box_collision_aabbs) {
-				if (AABB(aabb.position + rs.hit_position, aabb.size).intersects_segment(p_from, p_to)) {
-					return true;
-				}
-			}
+	// Voxels are read one block at a time, and blocks that can't be hit are skipped
 
-			return false;
-		}
-	};
+	int mode;
+	Ref<VoxelBlockyLibraryBase> library;
+	if (!get_raycast_mode(mode, library)) {
+		return Ref<VoxelRaycastResult>();
+	}
 
-	Ref<VoxelRaycastResult> res;
+	const Transform3D to_world = _terrain->get_global_transform();
 
-	Ref<VoxelMesherBlocky> mesher_blocky;
-	Ref<VoxelMesherCubes> mesher_cubes;
+	RaycastParams params{ _terrain->get_storage(),
+						  static_cast<RaycastParams::Mode>(mode),
+						  library.is_valid() ? &library->get_baked_data() : nullptr,
+						  p_collision_mask,
+						  to_world.affine_inverse(),
+						  static_cast<float>(to_world.basis.get_column(Vector3::AXIS_X).length()) };
 
-	Vector3i hit_pos;
-	Vector3i prev_pos;
+	VoxelDataRaycastHit hit;
+	if (raycast_terrain(params, p_pos, p_dir, p_max_distance, hit)) {
+		return make_raycast_result(hit);
+	}
+	return Ref<VoxelRaycastResult>();
+}
+
+void VoxelToolTerrain::raycast_batch(
+		Span<const Vector3> origins,
+		Span<const Vector3> directions,
+		float max_distance,
+		uint32_t collision_mask,
+		bool use_threads,
+		Span<Ref<VoxelRaycastResult>> out_results
+) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+
+	int mode;
+	Ref<VoxelBlockyLibraryBase> library;
+	if (!get_raycast_mode(mode, library)) {
+		return;
+	}
+
+	// Models must not change while rays are cast
+	const RWLock *baked_data_lock = library.is_valid() ? &library->get_baked_data_rw_lock() : nullptr;
+	if (baked_data_lock != nullptr) {
+		baked_data_lock->read_lock();
+	}
 
 	const Transform3D to_world = _terrain->get_global_transform();
-	const Transform3D to_local = to_world.affine_inverse();
-	const Vector3 local_pos = to_local.xform(p_pos);
-	const Vector3 local_dir = to_local.basis.xform(p_dir).normalized();
-	const float to_world_scale = to_world.basis.get_column(Vector3::AXIS_X).length();
-	const float max_distance = p_max_distance / to_world_scale;
 
-	if (try_get_as(_terrain->get_mesher(), mesher_blocky)) {
-		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
-		if (library_ref.is_null()) {
-			return res;
-		}
-		RaycastPredicateBlocky predicate{ _terrain->get_storage(),
-										  library_ref->get_baked_data(),
-										  p_collision_mask,
-										  local_pos,
-										  local_pos + local_dir * max_distance };
-		float hit_distance;
-		float hit_distance_prev;
-		if (zylann::voxel_raycast(
-					local_pos, local_dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev
-			)) {
-			res.instantiate();
-			res->position = hit_pos;
-			res->previous_position = prev_pos;
-			res->distance_along_ray = hit_distance * to_world_scale;
-		}
+	const RaycastParams params{ _terrain->get_storage(),
+								static_cast<RaycastParams::Mode>(mode),
+								library.is_valid() ? &library->get_baked_data() : nullptr,
+								collision_mask,
+								to_world.affine_inverse(),
+								static_cast<float>(to_world.basis.get_column(Vector3::AXIS_X).length()) };
 
-	} else if (try_get_as(_terrain->get_mesher(), mesher_cubes)) {
-		RaycastPredicateColor predicate{ _terrain->get_storage() };
-		float hit_distance;
-		float hit_distance_prev;
-		if (zylann::voxel_raycast(
-					local_pos, local_dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev
-			)) {
-			res.instantiate();
-			res->position = hit_pos;
-			res->previous_position = prev_pos;
-			res->distance_along_ray = hit_distance * to_world_scale;
-		}
+	struct TerrainRayCaster : IRayCaster {
+		const RaycastParams &params;
 
-	} else {
-		RaycastPredicateSDF predicate{ _terrain->get_storage() };
-		float hit_distance;
-		float hit_distance_prev;
-		if (zylann::voxel_raycast(
-					local_pos, local_dir, predicate, max_distance, hit_pos, prev_pos, hit_distance, hit_distance_prev
-			)) {
-			res.instantiate();
-			res->position = hit_pos;
-			res->previous_position = prev_pos;
-			res->distance_along_ray = hit_distance * to_world_scale;
+		TerrainRayCaster(const RaycastParams &p_params) : params(p_params) {}
+
+		bool cast(Vector3 origin, Vector3 direction, float max_distance, VoxelDataRaycastHit &out_hit) const override {
+			return raycast_terrain(params, origin, direction, max_distance, out_hit);
 		}
-	}
+	};
 
-	return res;
+	run_raycast_batch(TerrainRayCaster(params), origins, directions, max_distance, use_threads, out_results);
+
+	if (baked_data_lock != nullptr) {
+		baked_data_lock->read_unlock();
+	}
 }
 
 void VoxelToolTerrain::copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const {
@@ -172,6 +281,7 @@ void VoxelToolTerrain::paste(Vector3i pos, const VoxelBuffer &src, uint8_t chann
 	if (channels_mask == 0) {
 		channels_mask = (1 << _channel);
 	}
+	_pre_edit(Box3i(pos, src.get_size()));
 	_terrain->get_storage().paste(pos, src, channels_mask, false);
 	_post_edit(Box3i(pos, src.get_size()));
 }
@@ -188,6 +298,7 @@ void VoxelToolTerrain::paste_masked(
 	if (channels_mask == 0) {
 		channels_mask = (1 << _channel);
 	}
+	_pre_edit(Box3i(pos, p_voxels->get_buffer().get_size()));
 	_terrain->get_storage().paste_masked(pos, p_voxels->get_buffer(), channels_mask, mask_channel, mask_value, false);
 	_post_edit(Box3i(pos, p_voxels->get_buffer().get_size()));
 }
@@ -206,6 +317,7 @@ void VoxelToolTerrain::paste_masked_writable_list( //
 	if (channels_mask == 0) {
 		channels_mask = (1 << _channel);
 	}
+	_pre_edit(Box3i(pos, p_voxels->get_buffer().get_size()));
 	_terrain->get_storage().paste_masked_writable_list( //
 			pos, //
 			p_voxels->get_buffer(), //
@@ -247,6 +359,8 @@ void VoxelToolTerrain::do_box(Vector3i begin, Vector3i end) {
 		return;
 	}
 
+	_pre_edit(op.box);
+
 	VoxelData &data = _terrain->get_storage();
 
 	VoxelDataGrid grid;
@@ -281,6 +395,8 @@ void VoxelToolTerrain::do_sphere(Vector3 center, float radius) {
 		return;
 	}
 
+	_pre_edit(op.box);
+
 	VoxelData &data = _terrain->get_storage();
 
 	data.get_blocks_grid(op.blocks, op.box, 0);
@@ -312,6 +428,8 @@ void VoxelToolTerrain::do_hemisphere(Vector3 center, float radius, Vector3 flat_
 		return;
 	}
 
+	_pre_edit(op.box);
+
 	VoxelData &data = _terrain->get_storage();
 
 	VoxelDataGrid grid;
@@ -348,16 +466,61 @@ void VoxelToolTerrain::_set_voxel_f(Vector3i pos, float v) {
 	_terrain->get_storage().try_set_voxel_f(v, pos, _channel);
 }
 
+void VoxelToolTerrain::_pre_edit(const Box3i &box) {
+	ERR_FAIL_COND(_terrain == nullptr);
+	_terrain->get_storage().begin_journaled_edit(box, _journal_snapshot);
+}
+
 void VoxelToolTerrain::_post_edit(const Box3i &box) {
 	ERR_FAIL_COND(_terrain == nullptr);
+	_terrain->get_storage().end_journaled_edit(_journal_snapshot);
+	_terrain->post_edit_area(box, true);
+}
+
+bool VoxelToolTerrain::undo_edit() {
+	ERR_FAIL_COND_V(_terrain == nullptr, false);
+	Box3i box;
+	if (!_terrain->get_storage().undo_edit(box)) {
+		return false;
+	}
+	_terrain->post_edit_area(box, true);
+	return true;
+}
+
+bool VoxelToolTerrain::redo_edit() {
+	ERR_FAIL_COND_V(_terrain == nullptr, false);
+	Box3i box;
+	if (!_terrain->get_storage().redo_edit(box)) {
+		return false;
+	}
 	_terrain->post_edit_area(box, true);
+	return true;
+}
+
+uint32_t VoxelToolTerrain::get_edit_tick() const {
+	ERR_FAIL_COND_V(_terrain == nullptr, 0);
+	return _terrain->get_storage().get_edit_tick();
+}
+
+bool VoxelToolTerrain::seek_edit_tick(uint32_t tick) {
+	ERR_FAIL_COND_V(_terrain == nullptr, false);
+	Box3i box;
+	const bool reached = _terrain->get_storage().seek_edit_tick(tick, box);
+	if (!box.is_empty()) {
+		_terrain->post_edit_area(box, true);
+	}
+	return reached;
 }
 
 void VoxelToolTerrain::set_voxel_metadata(Vector3i pos, Variant meta) {
 	ERR_FAIL_COND(_terrain == nullptr);
 	VoxelData &data = _terrain->get_storage();
+	const Box3i box(pos, Vector3i(1, 1, 1));
+	// Not using `_pre_edit` and `_post_edit`, metadata doesn't need the terrain to update meshes
+	data.begin_journaled_edit(box, _journal_snapshot);
 	data.set_voxel_metadata(pos, meta);
-	_terrain->post_edit_area(Box3i(pos, Vector3i(1, 1, 1)), false);
+	data.end_journaled_edit(_journal_snapshot);
+	_terrain->post_edit_area(box, false);
 }
 
 Variant VoxelToolTerrain::get_voxel_metadata(Vector3i pos) const {
@@ -408,6 +571,36 @@ void VoxelToolTerrain::run_blocky_random_tick(
 	zylann::voxel::run_blocky_random_tick(data, voxel_area, lib, _random, voxel_count, batch_count, callback);
 }
 
+// Same as `run_blocky_random_tick`, but picks a fixed amount of voxels in every loaded block of the area instead of
+// picking blocks at random. Blocks are processed on the thread pool, and results are sent in a single call.
+void VoxelToolTerrain::run_blocky_random_tick_per_block(
+		AABB voxel_area,
+		int voxels_per_block,
+		const Callable &callback
+) {
+	ZN_PROFILE_SCOPE();
+
+	ERR_FAIL_COND(_terrain == nullptr);
+	ERR_FAIL_COND_MSG(
+			get_voxel_library(*_terrain).is_null(),
+			String("This function requires a volume using {0} with a valid library")
+					.format(varray(VoxelMesherBlocky::get_class_static()))
+	);
+	ERR_FAIL_COND(callback.is_null());
+	ERR_FAIL_COND(voxels_per_block < 0);
+	ERR_FAIL_COND(!math::is_valid_size(voxel_area.size));
+
+	if (voxels_per_block == 0) {
+		return;
+	}
+
+	const VoxelBlockyLibraryBase &lib = **get_voxel_library(*_terrain);
+	const VoxelData &data = _terrain->get_storage();
+	const uint64_t seed = (uint64_t(_random.rand()) << 32) | _random.rand();
+
+	zylann::voxel::run_blocky_random_tick_per_block(data, voxel_area, lib, seed, voxels_per_block, callback);
+}
+
 void VoxelToolTerrain::for_each_voxel_metadata_in_area(AABB voxel_area, const Callable &callback) {
 	ERR_FAIL_COND(_terrain == nullptr);
 	ERR_FAIL_COND(callback.is_null());
@@ -471,6 +664,8 @@ void VoxelToolTerrain::do_path(Span<const Vector3> positions, Span<const float>
 	const AABB total_aabb = get_path_aabb(positions, radii).grow(margin);
 	const Box3i total_voxel_box(to_vec3i(math::floor(total_aabb.position)), to_vec3i(math::ceil(total_aabb.size)));
 
+	_pre_edit(total_voxel_box);
+
 	VoxelDataGrid grid;
 
 	VoxelData &data = _terrain->get_storage();
@@ -534,12 +729,217 @@ void VoxelToolTerrain::do_path(Span<const Vector3> positions, Span<const float>
 	_post_edit(total_voxel_box);
 }
 
+namespace {
+
+template <typename TShape>
+class ShapeAsyncEdit : public IVoxelTerrainAsyncEdit {
+public:
+	ops::DoShapeChunked<TShape, ops::VoxelDataGridAccess> op;
+
+	Box3i get_box() const override {
+		return op.box;
+	}
+
+	void apply(VoxelDataGrid &grid) override {
+		op.block_access.grid = &grid;
+		op();
+	}
+};
+
+// Fills a box with a single value, like the generic `do_box` does with non-SDF channels
+class FillBoxAsyncEdit : public IVoxelTerrainAsyncEdit {
+public:
+	Box3i box;
+	uint64_t value;
+	VoxelBuffer::ChannelId channel;
+
+	Box3i get_box() const override {
+		return box;
+	}
+
+	void apply(VoxelDataGrid &grid) override {
+		ZN_PROFILE_SCOPE();
+		ops::VoxelDataGridAccess block_access;
+		block_access.grid = &grid;
+		ops::process_chunked_storage(
+				box,
+				block_access,
+				[this](VoxelBuffer &voxels, const Box3i local_box, Vector3i origin) {
+					voxels.fill_area(value, local_box.position, local_box.position + local_box.size, channel);
+				}
+		);
+	}
+};
+
+class PasteAsyncEdit : public IVoxelTerrainAsyncEdit {
+public:
+	Vector3i position;
+	// Copy of the source, so the caller can keep modifying theirs
+	std::shared_ptr<VoxelBuffer> voxels;
+	uint8_t channels_mask;
+
+	Box3i get_box() const override {
+		return Box3i(position, voxels->get_size());
+	}
+
+	void apply(VoxelDataGrid &grid) override {
+		ZN_PROFILE_SCOPE();
+		const SmallVector<uint8_t, VoxelBuffer::MAX_CHANNELS> channels =
+				VoxelBuffer::mask_to_channels_list(channels_mask);
+		ops::VoxelDataGridAccess block_access;
+		block_access.grid = &grid;
+		ops::process_chunked_storage(
+				get_box(),
+				block_access,
+				[this, &channels](VoxelBuffer &dst, const Box3i local_box, Vector3i origin) {
+					paste(to_span(channels), *voxels, dst, position - origin, true);
+				}
+		);
+	}
+};
+
+} // namespace
+
+void VoxelToolTerrain::do_sphere_async(Vector3 center, float radius) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+
+	ShapeAsyncEdit<ops::SdfSphere> *edit = ZN_NEW(ShapeAsyncEdit<ops::SdfSphere>);
+	ops::DoShapeChunked<ops::SdfSphere, ops::VoxelDataGridAccess> &op = edit->op;
+	op.shape.center = to_vec3f(center);
+	op.shape.radius = radius;
+	op.shape.sdf_scale = get_sdf_scale();
+	op.box = op.shape.get_box().clipped(_terrain->get_bounds());
+	op.mode = ops::Mode(get_mode());
+	op.texture_params = _texture_params;
+	op.blocky_value = _value;
+	op.channel = get_channel();
+	op.strength = get_sdf_strength();
+
+	if (!is_area_editable(op.box)) {
+		ZN_PRINT_WARNING("Area not editable");
+		ZN_DELETE(edit);
+		return;
+	}
+
+	_terrain->push_async_edit(edit);
+}
+
+void VoxelToolTerrain::do_box_async(Vector3i begin, Vector3i end) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+
+	IVoxelTerrainAsyncEdit *edit = nullptr;
+
+	if (get_channel() == VoxelBuffer::CHANNEL_SDF) {
+		ShapeAsyncEdit<ops::SdfAxisAlignedBox> *shape_edit = ZN_NEW(ShapeAsyncEdit<ops::SdfAxisAlignedBox>);
+		ops::DoShapeChunked<ops::SdfAxisAlignedBox, ops::VoxelDataGridAccess> &op = shape_edit->op;
+		op.shape.center = to_vec3f(begin + end) * 0.5f;
+		op.shape.half_size = to_vec3f(end - begin) * 0.5f;
+		op.shape.sdf_scale = get_sdf_scale();
+		op.box = op.shape.get_box().clipped(_terrain->get_bounds());
+		op.mode = ops::Mode(get_mode());
+		op.texture_params = _texture_params;
+		op.blocky_value = _value;
+		op.channel = get_channel();
+		op.strength = get_sdf_strength();
+		edit = shape_edit;
+
+	} else {
+		Vector3iUtil::sort_min_max(begin, end);
+		FillBoxAsyncEdit *fill_edit = ZN_NEW(FillBoxAsyncEdit);
+		fill_edit->box = Box3i::from_min_max(begin, end + Vector3i(1, 1, 1)).clipped(_terrain->get_bounds());
+		fill_edit->value = get_mode() == MODE_REMOVE ? _eraser_value : _value;
+		fill_edit->channel = get_channel();
+		edit = fill_edit;
+	}
+
+	if (!is_area_editable(edit->get_box())) {
+		ZN_PRINT_WARNING("Area not editable");
+		ZN_DELETE(edit);
+		return;
+	}
+
+	_terrain->push_async_edit(edit);
+}
+
+void VoxelToolTerrain::do_path_async(Span<const Vector3> positions, Span<const float> radii) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+	ZN_ASSERT_RETURN(positions.size() >= 2);
+	ZN_ASSERT_RETURN(positions.size() == radii.size());
+
+	const int margin = 1;
+
+	const AABB total_aabb = get_path_aabb(positions, radii).grow(margin);
+	const Box3i total_voxel_box(to_vec3i(math::floor(total_aabb.position)), to_vec3i(math::ceil(total_aabb.size)));
+
+	if (!is_area_editable(total_voxel_box.clipped(_terrain->get_bounds()))) {
+		ZN_PRINT_WARNING("Area not editable");
+		return;
+	}
+
+	// One edit per segment. They overlap, so they will run in order in the same task.
+	for (unsigned int point_index = 1; point_index < positions.size(); ++point_index) {
+		ShapeAsyncEdit<ops::SdfRoundCone> *edit = ZN_NEW(ShapeAsyncEdit<ops::SdfRoundCone>);
+		ops::DoShapeChunked<ops::SdfRoundCone, ops::VoxelDataGridAccess> &op = edit->op;
+		op.shape.cone.a = to_vec3f(positions[point_index - 1]);
+		op.shape.cone.b = to_vec3f(positions[point_index]);
+		op.shape.cone.r1 = radii[point_index - 1];
+		op.shape.cone.r2 = radii[point_index];
+		op.shape.cone.update();
+		op.shape.sdf_scale = get_sdf_scale();
+		op.box = op.shape.get_box().padded(margin).clipped(_terrain->get_bounds());
+		op.mode = ops::Mode(get_mode());
+		op.texture_params = _texture_params;
+		op.blocky_value = _value;
+		op.channel = get_channel();
+		op.strength = get_sdf_strength();
+
+		_terrain->push_async_edit(edit);
+	}
+}
+
+void VoxelToolTerrain::paste_async(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(_terrain == nullptr);
+	if (channels_mask == 0) {
+		channels_mask = (1 << _channel);
+	}
+
+	if (!is_area_editable(Box3i(pos, src.get_size()))) {
+		ZN_PRINT_WARNING("Area not editable");
+		return;
+	}
+
+	PasteAsyncEdit *edit = ZN_NEW(PasteAsyncEdit);
+	edit->position = pos;
+	edit->voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+	src.copy_to(*edit->voxels, true);
+	edit->channels_mask = channels_mask;
+
+	_terrain->push_async_edit(edit);
+}
+
+void VoxelToolTerrain::_b_do_path_async(PackedVector3Array positions, PackedFloat32Array radii) {
+	do_path_async(to_span(positions), to_span(radii));
+}
+
+void VoxelToolTerrain::_b_paste_async(Vector3i pos, Ref<godot::VoxelBuffer> voxels, int channels_mask) {
+	ERR_FAIL_COND(voxels.is_null());
+	paste_async(pos, voxels->get_buffer(), channels_mask);
+}
+
 void VoxelToolTerrain::_bind_methods() {
 	ClassDB::bind_method(
 			D_METHOD("run_blocky_random_tick", "area", "voxel_count", "callback", "batch_count"),
 			&VoxelToolTerrain::run_blocky_random_tick,
 			DEFVAL(16)
 	);
+	ClassDB::bind_method(
+			D_METHOD("run_blocky_random_tick_per_block", "area", "voxels_per_block", "callback"),
+			&VoxelToolTerrain::run_blocky_random_tick_per_block
+	);
 	ClassDB::bind_method(
 			D_METHOD("for_each_voxel_metadata_in_area", "voxel_area", "callback"),
 			&VoxelToolTerrain::for_each_voxel_metadata_in_area
@@ -549,6 +949,12 @@ void VoxelToolTerrain::_bind_methods() {
 			&VoxelToolTerrain::do_hemisphere,
 			DEFVAL(0.0)
 	);
+	ClassDB::bind_method(D_METHOD("do_sphere_async", "center", "radius"), &VoxelToolTerrain::do_sphere_async);
+	ClassDB::bind_method(D_METHOD("do_box_async", "begin", "end"), &VoxelToolTerrain::do_box_async);
+	ClassDB::bind_method(D_METHOD("do_path_async", "points", "radii"), &VoxelToolTerrain::_b_do_path_async);
+	ClassDB::bind_method(
+			D_METHOD("paste_async", "dst_pos", "src_buffer", "channels_mask"), &VoxelToolTerrain::_b_paste_async
+	);
 }
 
 } // namespace zylann::voxel
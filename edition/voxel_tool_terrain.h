@@ -1,6 +1,7 @@
 #ifndef VOXEL_TOOL_TERRAIN_H
 #define VOXEL_TOOL_TERRAIN_H
 
+#include "../storage/voxel_edit_journal.h"
 #include "../util/godot/core/random_pcg.h"
 #include "voxel_tool.h"
 
@@ -19,10 +20,23 @@ public:
 	bool is_area_editable(const Box3i &box) const override;
 	Ref<VoxelRaycastResult> raycast(Vector3 p_pos, Vector3 p_dir, float p_max_distance, uint32_t p_collision_mask)
 			override;
+	void raycast_batch(
+			Span<const Vector3> origins,
+			Span<const Vector3> directions,
+			float max_distance,
+			uint32_t collision_mask,
+			bool use_threads,
+			Span<Ref<VoxelRaycastResult>> out_results
+	) override;
 
 	void set_voxel_metadata(Vector3i pos, Variant meta) override;
 	Variant get_voxel_metadata(Vector3i pos) const override;
 
+	bool undo_edit() override;
+	bool redo_edit() override;
+	uint32_t get_edit_tick() const override;
+	bool seek_edit_tick(uint32_t tick) override;
+
 	void copy(Vector3i pos, VoxelBuffer &dst, uint8_t channels_mask) const override;
 	void paste(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask) override;
 	void paste_masked(
@@ -51,7 +65,16 @@ public:
 
 	void do_hemisphere(Vector3 center, float radius, Vector3 flat_direction, float smoothness);
 
+	// Asynchronous versions of edits. They run on the thread pool, and meshes update once the batch they are part of
+	// completes. Edits of the same area run in the order they were requested. They are not recorded in the edit
+	// journal.
+	void do_sphere_async(Vector3 center, float radius);
+	void do_box_async(Vector3i begin, Vector3i end);
+	void do_path_async(Span<const Vector3> positions, Span<const float> radii);
+	void paste_async(Vector3i pos, const VoxelBuffer &src, uint8_t channels_mask);
+
 	void run_blocky_random_tick(AABB voxel_area, int voxel_count, const Callable &callback, int block_batch_count);
+	void run_blocky_random_tick_per_block(AABB voxel_area, int voxels_per_block, const Callable &callback);
 
 	void for_each_voxel_metadata_in_area(AABB voxel_area, const Callable &callback);
 
@@ -60,13 +83,21 @@ protected:
 	float _get_voxel_f(Vector3i pos) const override;
 	void _set_voxel(Vector3i pos, uint64_t v) override;
 	void _set_voxel_f(Vector3i pos, float v) override;
+	void _pre_edit(const Box3i &box) override;
 	void _post_edit(const Box3i &box) override;
 
 private:
 	static void _bind_methods();
 
+	void _b_do_path_async(PackedVector3Array positions, PackedFloat32Array radii);
+	void _b_paste_async(Vector3i pos, Ref<godot::VoxelBuffer> voxels, int channels_mask);
+
+	bool get_raycast_mode(int &out_mode, Ref<VoxelBlockyLibraryBase> &out_library) const;
+
 	VoxelTerrain *_terrain = nullptr;
 	RandomPCG _random;
+	// Voxels before the current edit, if the terrain has an edit journal
+	VoxelEditJournal::Snapshot _journal_snapshot;
 };
 
 } // namespace zylann::voxel
@@ -16,7 +16,16 @@ Ref<Mesh> build_mesh(
 	VoxelMesher::Output output;
 	VoxelMesher::Input input{ voxels, nullptr, Vector3i(), 0, false };
 	mesher.build(output, input);
+	return build_mesh(output, surface_index_to_material, out_atlas, p_scale, p_offset);
+}
 
+Ref<Mesh> build_mesh(
+		VoxelMesher::Output &output,
+		StdVector<unsigned int> &surface_index_to_material,
+		Ref<Image> &out_atlas,
+		float p_scale,
+		Vector3 p_offset
+) {
 	if (output.surfaces.size() == 0) {
 		return Ref<ArrayMesh>();
 	}
@@ -17,6 +17,15 @@ Ref<Mesh> build_mesh(
 		Vector3 p_offset
 );
 
+// Same as above, with voxels already meshed. Meshing is thread-safe, so it can be done in parallel beforehand.
+Ref<Mesh> build_mesh(
+		VoxelMesher::Output &output,
+		StdVector<unsigned int> &surface_index_to_material,
+		Ref<Image> &out_atlas,
+		float p_scale,
+		Vector3 p_offset
+);
+
 } // namespace zylann::voxel::magica
 
 #endif // VOX_IMPORT_FUNCS_H
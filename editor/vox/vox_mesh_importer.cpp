@@ -4,14 +4,12 @@
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_memory_pool.h"
 #include "../../streams/vox/vox_data.h"
-#include "../../util/dstack.h"
+#include "../../streams/vox/vox_model_instances.h"
 #include "../../util/godot/classes/image_texture.h"
 #include "../../util/godot/classes/resource_saver.h"
 #include "../../util/godot/classes/standard_material_3d.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/macros.h"
-#include "../../util/math/conv.h"
-#include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
 #include "vox_import_funcs.h"
 
@@ -75,168 +73,6 @@ bool VoxelVoxMeshImporter::_zn_get_option_visibility(
 	return true;
 }
 
-struct ForEachModelInstanceArgs {
-	const Model *model;
-	// Pivot position, which turns out to be at the center in MagicaVoxel
-	Vector3i position;
-	Basis basis;
-};
-
-template <typename F>
-Error for_each_model_instance_in_scene_graph(const Data &data, int node_id, Transform3D transform, int depth, F f) {
-	//
-	ERR_FAIL_COND_V(depth > 10, ERR_INVALID_DATA);
-	const Node *vox_node = data.get_node(node_id);
-
-	switch (vox_node->type) {
-		case Node::TYPE_TRANSFORM: {
-			const TransformNode *vox_transform_node = reinterpret_cast<const TransformNode *>(vox_node);
-			// Calculate global transform of the child
-			const Transform3D child_trans(
-					transform.basis * vox_transform_node->rotation.basis, transform.xform(vox_transform_node->position)
-			);
-			for_each_model_instance_in_scene_graph(data, vox_transform_node->child_node_id, child_trans, depth + 1, f);
-		} break;
-
-		case Node::TYPE_GROUP: {
-			const GroupNode *vox_group_node = reinterpret_cast<const GroupNode *>(vox_node);
-			for (unsigned int i = 0; i < vox_group_node->child_node_ids.size(); ++i) {
-				const int child_node_id = vox_group_node->child_node_ids[i];
-				for_each_model_instance_in_scene_graph(data, child_node_id, transform, depth + 1, f);
-			}
-		} break;
-
-		case Node::TYPE_SHAPE: {
-			const ShapeNode *vox_shape_node = reinterpret_cast<const ShapeNode *>(vox_node);
-			ForEachModelInstanceArgs args;
-			args.model = &data.get_model(vox_shape_node->model_id);
-			args.position = math::round_to_int(transform.origin);
-			args.basis = transform.basis;
-			f(args);
-		} break;
-
-		default:
-			ERR_FAIL_V(ERR_INVALID_DATA);
-			break;
-	}
-
-	return OK;
-}
-
-template <typename F>
-void for_each_model_instance(const Data &vox_data, F f) {
-	if (vox_data.get_model_count() == 0) {
-		return;
-	}
-	if (vox_data.get_root_node_id() == -1) {
-		// No scene graph
-		ForEachModelInstanceArgs args;
-		args.model = &vox_data.get_model(0);
-		// Put at center to match what MagicaVoxel would do
-		args.position = args.model->size / 2;
-		args.basis = Basis();
-		f(args);
-		return;
-	}
-	for_each_model_instance_in_scene_graph(vox_data, vox_data.get_root_node_id(), Transform3D(), 0, f);
-}
-
-// Find intersecting or touching models, merge their voxels into the same grid, mesh the result, then combine meshes.
-
-struct ModelInstance {
-	// Model with baked rotation
-	UniquePtr<VoxelBuffer> voxels;
-	// Lowest corner position
-	Vector3i position;
-};
-
-void extract_model_instances(const Data &vox_data, StdVector<ModelInstance> &out_instances) {
-	ZN_DSTACK();
-	// Gather all models and bake their rotations
-	for_each_model_instance(vox_data, [&out_instances](ForEachModelInstanceArgs args) {
-		ERR_FAIL_COND(args.model == nullptr);
-		const Model &model = *args.model;
-
-		Span<const uint8_t> src_color_indices;
-		Vector3i dst_size = model.size;
-
-		// Using temporary copy to rotate the data
-		StdVector<uint8_t> temp_voxels;
-
-		if (args.basis == Basis()) {
-			// No transformation
-			src_color_indices = to_span_const(model.color_indexes);
-		} else {
-			IntBasis basis;
-			basis.x = to_vec3i(args.basis.get_column(Vector3::AXIS_X));
-			basis.y = to_vec3i(args.basis.get_column(Vector3::AXIS_Y));
-			basis.z = to_vec3i(args.basis.get_column(Vector3::AXIS_Z));
-			temp_voxels.resize(model.color_indexes.size());
-			dst_size =
-					transform_3d_array_zxy(to_span_const(model.color_indexes), to_span(temp_voxels), model.size, basis);
-			src_color_indices = to_span_const(temp_voxels);
-		}
-
-		// TODO Optimization: implement transformation for VoxelBuffers so we can avoid using a temporary copy.
-		// Didn't do it yet because VoxelBuffers also have metadata and the `transform_3d_array_zxy` function only works
-		// on arrays.
-		UniquePtr<VoxelBuffer> voxels = make_unique_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
-		voxels->create(dst_size);
-		voxels->decompress_channel(VoxelBuffer::CHANNEL_COLOR);
-
-		Span<uint8_t> dst_color_indices;
-		ERR_FAIL_COND(!voxels->get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices));
-
-		CRASH_COND(src_color_indices.size() != dst_color_indices.size());
-		memcpy(dst_color_indices.data(), src_color_indices.data(), dst_color_indices.size() * sizeof(uint8_t));
-
-		ModelInstance mi;
-		mi.voxels = std::move(voxels);
-		mi.position = args.position - mi.voxels->get_size() / 2;
-		out_instances.push_back(std::move(mi));
-	});
-}
-
-bool make_single_voxel_grid(Span<const ModelInstance> instances, Vector3i &out_origin, VoxelBuffer &out_voxels) {
-	// Determine total size
-	const ModelInstance &first_instance = instances[0];
-	Box3i bounding_box(first_instance.position, first_instance.voxels->get_size());
-	for (unsigned int instance_index = 1; instance_index < instances.size(); ++instance_index) {
-		const ModelInstance &mi = instances[instance_index];
-		bounding_box.merge_with(Box3i(mi.position, mi.voxels->get_size()));
-	}
-
-	// Extra sanity check
-	// 3 gigabytes
-	const size_t limit = 3'000'000'000ull;
-	const size_t volume = Vector3iUtil::get_volume(bounding_box.size);
-	ERR_FAIL_COND_V_MSG(
-			volume > limit,
-			false,
-			String("Vox data is too big to be meshed as a single mesh ({0}: {0} bytes)")
-					.format(varray(bounding_box.size, ZN_SIZE_T_TO_VARIANT(volume)))
-	);
-
-	out_voxels.create(bounding_box.size + Vector3iUtil::create(VoxelMesherCubes::PADDING * 2));
-	out_voxels.set_channel_depth(VoxelBuffer::CHANNEL_COLOR, VoxelBuffer::DEPTH_8_BIT);
-	out_voxels.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
-
-	for (unsigned int instance_index = 0; instance_index < instances.size(); ++instance_index) {
-		const ModelInstance &mi = instances[instance_index];
-		ERR_FAIL_COND_V(mi.voxels == nullptr, false);
-		out_voxels.copy_channel_from(
-				*mi.voxels,
-				Vector3i(),
-				mi.voxels->get_size(),
-				mi.position - bounding_box.position + Vector3iUtil::create(VoxelMesherCubes::PADDING),
-				VoxelBuffer::CHANNEL_COLOR
-		);
-	}
-
-	out_origin = bounding_box.position;
-	return true;
-}
-
 Error VoxelVoxMeshImporter::_zn_import(
 		const String &p_source_file,
 		const String &p_save_path,
@@ -282,8 +118,9 @@ Error VoxelVoxMeshImporter::_zn_import(
 		// One workaround would be to mesh the scene incrementally in chunks, giving up greedy meshing beyond 256 or so.
 		Vector3i bounding_box_origin;
 		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
-		const bool single_grid_succeeded =
-				make_single_voxel_grid(to_span_const(model_instances), bounding_box_origin, voxels);
+		const bool single_grid_succeeded = make_single_voxel_grid(
+				to_span_const(model_instances), VoxelMesherCubes::PADDING, bounding_box_origin, voxels
+		);
 		ERR_FAIL_COND_V(!single_grid_succeeded, ERR_CANT_CREATE);
 
 		// We no longer need these
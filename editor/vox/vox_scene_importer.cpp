@@ -1,5 +1,6 @@
 #include "vox_scene_importer.h"
 #include "../../constants/voxel_string_names.h"
+#include "../../engine/parallel_for.h"
 #include "../../meshers/cubes/voxel_mesher_cubes.h"
 #include "../../storage/voxel_buffer_gd.h"
 #include "../../streams/vox/vox_data.h"
@@ -320,30 +321,51 @@ Error VoxelVoxSceneImporter::_zn_import(
 	}
 	materials[1]->set_transparency(StandardMaterial3D::TRANSPARENCY_ALPHA);
 
-	// Build meshes from voxel models
-	for (unsigned int model_index = 0; model_index < data.get_model_count(); ++model_index) {
-		const magica::Model &model = data.get_model(model_index);
-
-		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
-		voxels.create(model.size + Vector3iUtil::create(VoxelMesherCubes::PADDING * 2));
-		voxels.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
-
-		Span<uint8_t> dst_color_indices;
-		ERR_FAIL_COND_V(!voxels.get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices), ERR_BUG);
-		Span<const uint8_t> src_color_indices = to_span_const(model.color_indexes);
-		copy_3d_region_zxy(
-				dst_color_indices,
-				voxels.get_size(),
-				Vector3iUtil::create(VoxelMesherCubes::PADDING),
-				src_color_indices,
-				model.size,
-				Vector3i(),
-				model.size
-		);
+	// Mesh voxel models. This is the most expensive part and only uses the mesher, so it can run on threads.
+	StdVector<VoxelMesher::Output> mesher_outputs;
+	mesher_outputs.resize(data.get_model_count());
+	StdVector<Vector3i> padded_model_sizes;
+	padded_model_sizes.resize(data.get_model_count());
+
+	auto mesh_models = [&data, &mesher, &mesher_outputs, &padded_model_sizes](unsigned int begin, unsigned int end) {
+		for (unsigned int model_index = begin; model_index < end; ++model_index) {
+			ZN_PROFILE_SCOPE_NAMED("Mesh model");
+			const magica::Model &model = data.get_model(model_index);
+
+			VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+			voxels.create(model.size + Vector3iUtil::create(VoxelMesherCubes::PADDING * 2));
+			voxels.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
+			padded_model_sizes[model_index] = voxels.get_size();
+
+			Span<uint8_t> dst_color_indices;
+			ERR_FAIL_COND(!voxels.get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices));
+			Span<const uint8_t> src_color_indices = to_span_const(model.color_indexes);
+			copy_3d_region_zxy(
+					dst_color_indices,
+					voxels.get_size(),
+					Vector3iUtil::create(VoxelMesherCubes::PADDING),
+					src_color_indices,
+					model.size,
+					Vector3i(),
+					model.size
+			);
+
+			VoxelMesher::Input input{ voxels, nullptr, Vector3i(), 0, false };
+			mesher->build(mesher_outputs[model_index], input);
+		}
+	};
+
+	parallel_for_ranges(data.get_model_count(), 1, mesh_models);
 
+	// Build mesh resources
+	for (unsigned int model_index = 0; model_index < data.get_model_count(); ++model_index) {
 		StdVector<unsigned int> surface_index_to_material;
 		Ref<Image> atlas;
-		Ref<Mesh> mesh = magica::build_mesh(voxels, **mesher, surface_index_to_material, atlas, p_scale, Vector3());
+		Ref<Mesh> mesh = magica::build_mesh(
+				mesher_outputs[model_index], surface_index_to_material, atlas, p_scale, Vector3()
+		);
+		// Free memory as we go
+		mesher_outputs[model_index] = VoxelMesher::Output();
 
 		if (mesh.is_null()) {
 			continue;
@@ -396,7 +418,7 @@ Error VoxelVoxSceneImporter::_zn_import(
 		// In MagicaVoxel scene graph, pivots are at the center of models, not at the lower corner.
 		// TODO I don't know if this is correct, but I could not find a reference saying how that pivot should be
 		// calculated
-		mesh_info.pivot = (voxels.get_size() / 2 - Vector3iUtil::create(1));
+		mesh_info.pivot = (padded_model_sizes[model_index] / 2 - Vector3iUtil::create(1));
 		meshes[model_index] = mesh_info;
 	}
 
@@ -393,6 +393,38 @@ inline void query_sdf(
 #endif
 }
 
+// Each texel needs this many SDF samples to compute a gradient
+static const unsigned int GRADIENT_SAMPLE_COUNT = 4;
+
+typedef FixedArray<Vector3f, GRADIENT_SAMPLE_COUNT> GradientSampleOffsets;
+
+// Forward differences sample (0,0,0), (s,0,0), (0,s,0) and (0,0,s), like GPU shaders do.
+// Central differences sample corners of a tetrahedron centered on the texel. They are more accurate for the same
+// number of samples, and are not biased towards positive axes.
+void get_gradient_sample_offsets(float step, bool central, GradientSampleOffsets &offsets) {
+	if (central) {
+		const float h = 0.5f * step;
+		offsets[0] = Vector3f(h, -h, -h);
+		offsets[1] = Vector3f(-h, -h, h);
+		offsets[2] = Vector3f(-h, h, -h);
+		offsets[3] = Vector3f(h, h, h);
+	} else {
+		offsets[0] = Vector3f();
+		offsets[1] = Vector3f(step, 0.f, 0.f);
+		offsets[2] = Vector3f(0.f, step, 0.f);
+		offsets[3] = Vector3f(0.f, 0.f, step);
+	}
+}
+
+// Gets a non-normalized gradient from samples taken at offsets given by `get_gradient_sample_offsets`
+inline Vector3f get_gradient(float sd0, float sd1, float sd2, float sd3, bool central) {
+	if (central) {
+		return Vector3f(sd0 - sd1 - sd2 + sd3, -sd0 - sd1 + sd2 + sd3, -sd0 + sd1 - sd2 + sd3);
+	} else {
+		return Vector3f(sd1 - sd0, sd2 - sd0, sd3 - sd0);
+	}
+}
+
 // For each non-empty cell of the mesh, choose an axis-aligned projection based on triangle normals in the cell.
 // Sample voxels inside the cell to compute a tile of world space normals from the SDF.
 void compute_detail_texture_data(
@@ -441,6 +473,52 @@ void compute_detail_texture_data(
 
 	uint32_t skipped_count_due_to_high_volume = 0;
 
+	// Tiles rendered on the CPU to complement tiles rendered on the GPU must use the same differences as shaders,
+	// otherwise lighting would not match between them.
+	const bool central_differences = !edited_tiles_only;
+	GradientSampleOffsets gradient_offsets;
+	get_gradient_sample_offsets(step, central_differences, gradient_offsets);
+
+	const VoxelModifierStack *modifiers = voxel_data != nullptr ? &voxel_data->get_modifiers() : nullptr;
+
+	struct CellSamples {
+		// Range of texels in `tls_texel_indices`. Each texel has `GRADIENT_SAMPLE_COUNT` samples in query buffers.
+		uint32_t texels_begin;
+		uint32_t texels_end;
+		Vector3f origin_world;
+		bool has_edits;
+	};
+
+	// Texels of all cells are gathered first, so those without edits can be queried in large series. Generators are
+	// much faster when evaluating many positions at once.
+	static thread_local StdVector<CellSamples> tls_cells;
+	// Index of each texel within its tile
+	static thread_local StdVector<uint32_t> tls_texel_indices;
+	// Normal of the triangle each texel was projected on
+	static thread_local StdVector<Vector3f> tls_texel_triangle_normals;
+	static thread_local StdVector<float> tls_sdf_buffer;
+	static thread_local StdVector<float> tls_x_buffer;
+	static thread_local StdVector<float> tls_y_buffer;
+	static thread_local StdVector<float> tls_z_buffer;
+	tls_cells.clear();
+	tls_texel_indices.clear();
+	tls_texel_triangle_normals.clear();
+	tls_sdf_buffer.clear();
+	tls_x_buffer.clear();
+	tls_y_buffer.clear();
+	tls_z_buffer.clear();
+
+	if (!edited_tiles_only) {
+		const unsigned int max_texel_count = math::squared(tile_resolution) * cell_iterator.get_count();
+		const unsigned int max_sample_count = max_texel_count * GRADIENT_SAMPLE_COUNT;
+		tls_texel_indices.reserve(max_texel_count);
+		tls_texel_triangle_normals.reserve(max_texel_count);
+		tls_sdf_buffer.reserve(max_sample_count);
+		tls_x_buffer.reserve(max_sample_count);
+		tls_y_buffer.reserve(max_sample_count);
+		tls_z_buffer.reserve(max_sample_count);
+	}
+
 	CurrentCellInfo cell_info;
 	for (unsigned int cell_index = 0; cell_iterator.next(cell_info); ++cell_index) {
 		// Re-use memory because it will be used a lot
@@ -477,34 +555,6 @@ void compute_detail_texture_data(
 		Vector3f direction;
 		direction[az] = 1.f;
 
-		static thread_local StdVector<Vector2i> tls_tile_sample_positions;
-		tls_tile_sample_positions.clear();
-		tls_tile_sample_positions.reserve(math::squared(tile_resolution));
-
-		static thread_local StdVector<uint8_t> tls_tile_sample_triangle_index;
-		tls_tile_sample_triangle_index.clear();
-		tls_tile_sample_triangle_index.reserve(math::squared(tile_resolution));
-
-		// Each normal needs 4 samples:
-		// (x,   y,   z  )
-		// (x+s, y,   z  )
-		// (x,   y+s, z  )
-		// (x,   y,   z+s)
-		const unsigned int max_buffer_size = math::squared(tile_resolution) * 4;
-
-		static thread_local StdVector<float> tls_sdf_buffer;
-		static thread_local StdVector<float> tls_x_buffer;
-		static thread_local StdVector<float> tls_y_buffer;
-		static thread_local StdVector<float> tls_z_buffer;
-		tls_sdf_buffer.clear();
-		tls_x_buffer.clear();
-		tls_y_buffer.clear();
-		tls_z_buffer.clear();
-		tls_sdf_buffer.reserve(max_buffer_size);
-		tls_x_buffer.reserve(max_buffer_size);
-		tls_y_buffer.reserve(max_buffer_size);
-		tls_z_buffer.reserve(max_buffer_size);
-
 		// Optimize triangles
 		CellTriangles baked_triangles;
 		unsigned int triangle_count =
@@ -518,12 +568,16 @@ void compute_detail_texture_data(
 			triangle_normals[i] = tri_normal;
 		}
 
+		CellSamples cell;
+		cell.texels_begin = tls_texel_indices.size();
+		cell.origin_world = cell_origin_world;
+		cell.has_edits = cell_has_edits;
+
 		// Fill query buffers
 		{
 			ZN_PROFILE_SCOPE_NAMED("Compute positions");
 			for (unsigned int yi = 0; yi < tile_resolution; ++yi) {
 				for (unsigned int xi = 0; xi < tile_resolution; ++xi) {
-					// TODO Add bias to center differences when calculating the normals?
 					Vector3f pos000 = quad_origin_world;
 					// Casting to `int` here because even if the target is float, temporaries can be negative uints
 					pos000[ax] += int(xi) * step;
@@ -550,92 +604,113 @@ void compute_detail_texture_data(
 					}
 
 					pos000 = ray_origin_world + direction * nearest_hit_distance;
-					tls_tile_sample_positions.push_back(Vector2i(xi, yi));
-					tls_tile_sample_triangle_index.push_back(hit_triangle_index);
-
-					tls_x_buffer.push_back(pos000.x);
-					tls_y_buffer.push_back(pos000.y);
-					tls_z_buffer.push_back(pos000.z);
-
-					Vector3f pos100 = pos000;
-					pos100.x += step;
-					tls_x_buffer.push_back(pos100.x);
-					tls_y_buffer.push_back(pos100.y);
-					tls_z_buffer.push_back(pos100.z);
-
-					Vector3f pos010 = pos000;
-					pos010.y += step;
-					tls_x_buffer.push_back(pos010.x);
-					tls_y_buffer.push_back(pos010.y);
-					tls_z_buffer.push_back(pos010.z);
-
-					Vector3f pos001 = pos000;
-					pos001.z += step;
-					tls_x_buffer.push_back(pos001.x);
-					tls_y_buffer.push_back(pos001.y);
-					tls_z_buffer.push_back(pos001.z);
+					tls_texel_indices.push_back(xi + yi * tile_resolution);
+					tls_texel_triangle_normals.push_back(triangle_normals[hit_triangle_index]);
+
+					for (const Vector3f offset : gradient_offsets) {
+						const Vector3f pos = pos000 + offset;
+						tls_x_buffer.push_back(pos.x);
+						tls_y_buffer.push_back(pos.y);
+						tls_z_buffer.push_back(pos.z);
+					}
 				}
 			}
 		}
 
-		tls_sdf_buffer.resize(tls_x_buffer.size());
+		cell.texels_end = tls_texel_indices.size();
+		tls_cells.push_back(cell);
 
-		{
-			const VoxelDataGrid *edits_grid = cell_has_edits ? &tls_voxel_data_grid : nullptr;
-			const VoxelModifierStack *modifiers = voxel_data != nullptr ? &voxel_data->get_modifiers() : nullptr;
+		if (cell_has_edits) {
+			// Edited voxels are only referenced by the grid during this iteration, so they have to be queried now
+			const unsigned int samples_begin = cell.texels_begin * GRADIENT_SAMPLE_COUNT;
+			const unsigned int sample_count = (cell.texels_end - cell.texels_begin) * GRADIENT_SAMPLE_COUNT;
+			tls_sdf_buffer.resize(tls_x_buffer.size());
 
-			// Query voxel data
 			query_sdf(
 					generator,
-					edits_grid,
+					&tls_voxel_data_grid,
 					modifiers,
-					to_span(tls_x_buffer),
-					to_span(tls_y_buffer),
-					to_span(tls_z_buffer),
-					to_span(tls_sdf_buffer),
+					to_span(tls_x_buffer).sub(samples_begin, sample_count),
+					to_span(tls_y_buffer).sub(samples_begin, sample_count),
+					to_span(tls_z_buffer).sub(samples_begin, sample_count),
+					to_span(tls_sdf_buffer).sub(samples_begin, sample_count),
 					cell_origin_world,
 					cell_origin_world + Vector3f(cell_size)
 			);
 		}
+	}
+
+	tls_sdf_buffer.resize(tls_x_buffer.size());
+
+	// Query all remaining samples with as few series as possible. Cells with edits split them, because their samples
+	// were already queried.
+	{
+		ZN_PROFILE_SCOPE_NAMED("Query generator");
+
+		unsigned int cell_index = 0;
+		while (cell_index < tls_cells.size()) {
+			if (tls_cells[cell_index].has_edits) {
+				++cell_index;
+				continue;
+			}
+
+			const CellSamples &first_cell = tls_cells[cell_index];
+			const unsigned int samples_begin = first_cell.texels_begin * GRADIENT_SAMPLE_COUNT;
+			unsigned int samples_end = samples_begin;
+			Vector3f min_pos = first_cell.origin_world;
+			Vector3f max_pos = first_cell.origin_world;
+
+			for (; cell_index < tls_cells.size() && !tls_cells[cell_index].has_edits; ++cell_index) {
+				const CellSamples &cell = tls_cells[cell_index];
+				samples_end = cell.texels_end * GRADIENT_SAMPLE_COUNT;
+				min_pos = math::min(min_pos, cell.origin_world);
+				max_pos = math::max(max_pos, cell.origin_world);
+			}
+
+			if (samples_end == samples_begin) {
+				continue;
+			}
+
+			const unsigned int sample_count = samples_end - samples_begin;
+
+			query_sdf(
+					generator,
+					nullptr,
+					modifiers,
+					to_span(tls_x_buffer).sub(samples_begin, sample_count),
+					to_span(tls_y_buffer).sub(samples_begin, sample_count),
+					to_span(tls_z_buffer).sub(samples_begin, sample_count),
+					to_span(tls_sdf_buffer).sub(samples_begin, sample_count),
+					min_pos,
+					max_pos + Vector3f(cell_size)
+			);
+		}
+	}
+
+	static thread_local StdVector<Vector3f> tls_tile_normals;
 
-		static thread_local StdVector<Vector3f> tls_tile_normals;
+	for (const CellSamples &cell : tls_cells) {
 		tls_tile_normals.clear();
 		tls_tile_normals.resize(math::squared(tile_resolution));
 
 		// Compute normals from SDF results
 		{
 			ZN_PROFILE_SCOPE_NAMED("Compute normals");
-			ZN_ASSERT(tls_tile_sample_positions.size() == tls_tile_sample_triangle_index.size());
-
-			unsigned int bi = 0;
 
-			for (unsigned int si = 0; si < tls_tile_sample_positions.size(); ++si) {
-				const Vector2i sample_position = tls_tile_sample_positions[si];
-				const uint8_t sample_tri_index = tls_tile_sample_triangle_index[si];
-
-				const unsigned int bi000 = bi;
-				const unsigned int bi100 = bi + 1;
-				const unsigned int bi010 = bi + 2;
-				const unsigned int bi001 = bi + 3;
-				bi += 4;
-				// TODO I wish this was solved https://github.com/godotengine/godot/issues/31608
+			for (unsigned int ti = cell.texels_begin; ti < cell.texels_end; ++ti) {
+				const unsigned int bi = ti * GRADIENT_SAMPLE_COUNT;
 #ifdef DEBUG_ENABLED
-				ZN_ASSERT(bi000 < tls_sdf_buffer.size());
-				ZN_ASSERT(bi100 < tls_sdf_buffer.size());
-				ZN_ASSERT(bi010 < tls_sdf_buffer.size());
-				ZN_ASSERT(bi001 < tls_sdf_buffer.size());
+				ZN_ASSERT(bi + GRADIENT_SAMPLE_COUNT <= tls_sdf_buffer.size());
 #endif
-				const float sd000 = tls_sdf_buffer[bi000];
-				const float sd100 = tls_sdf_buffer[bi100];
-				const float sd010 = tls_sdf_buffer[bi010];
-				const float sd001 = tls_sdf_buffer[bi001];
-
-				Vector3f normal = math::normalized(Vector3f(sd100 - sd000, sd010 - sd000, sd001 - sd000));
+				Vector3f normal = math::normalized(get_gradient(
+						tls_sdf_buffer[bi], tls_sdf_buffer[bi + 1], tls_sdf_buffer[bi + 2], tls_sdf_buffer[bi + 3],
+						central_differences
+				));
 
 				// Clamp normals if their dot product with triangle normal is higher than a threshold.
 				// This helps avoiding flipped normals on very low LODs because bias is very high. In the
 				// SolarSystem demo it can pick up caves from the surface which results in black spots.
-				const Vector3f &tri_normal = triangle_normals[sample_tri_index];
+				const Vector3f &tri_normal = tls_texel_triangle_normals[ti];
 				const float tdot = math::dot(normal, tri_normal);
 				if (tdot < max_deviation_cosine) {
 					if (tdot < -0.999) {
@@ -646,7 +721,7 @@ void compute_detail_texture_data(
 					}
 				}
 
-				const unsigned int normal_index = sample_position.x + sample_position.y * tile_resolution;
+				const unsigned int normal_index = tls_texel_indices[ti];
 #ifdef DEBUG_ENABLED
 				ZN_ASSERT(normal_index < tls_tile_normals.size());
 #endif
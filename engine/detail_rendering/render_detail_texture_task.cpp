@@ -6,6 +6,7 @@
 #include "../../modifiers/voxel_modifier_stack.h"
 #include "../../storage/voxel_data.h"
 #include "../../util/math/conv.h"
+#include "../../util/profiling_clock.h"
 #include "render_detail_texture_gpu_task.h"
 
 namespace zylann::voxel {
@@ -58,6 +59,8 @@ void RenderDetailTextureTask::run(ThreadedTaskContext &ctx) {
 }
 
 void RenderDetailTextureTask::run_on_cpu() {
+	ProfilingClock profiling_clock;
+
 	DetailTextureData &normalmap_data = get_tls_normalmap_data();
 	normalmap_data.clear();
 
@@ -84,6 +87,11 @@ void RenderDetailTextureTask::run_on_cpu() {
 			false
 	);
 
+	VoxelEngine &engine = VoxelEngine::get_singleton();
+	engine.debug_add_detail_texture_cpu_stats(
+			normalmap_data.tiles.size() * math::squared(tile_resolution), profiling_clock.get_elapsed_microseconds()
+	);
+
 	DetailImages images = store_normalmap_data_to_images(
 			normalmap_data, tile_resolution, mesh_block_size, detail_texture_settings.octahedral_encoding_enabled
 	);
@@ -104,7 +112,7 @@ void RenderDetailTextureTask::run_on_cpu() {
 	// 											mesh_block_position.z, lod_index)));
 	// }
 
-	if (VoxelEngine::get_singleton().is_threaded_graphics_resource_building_enabled()) {
+	if (engine.is_threaded_graphics_resource_building_enabled()) {
 		DetailTextures textures = store_normalmap_data_to_textures(images);
 		output_textures->textures = textures;
 	} else {
@@ -384,7 +392,8 @@ void RenderDetailTexturePass2Task::run(ThreadedTaskContext &ctx) {
 
 	images.lookup = store_lookup_to_image(tile_data, mesh_block_size);
 
-	if (VoxelEngine::get_singleton().is_threaded_graphics_resource_building_enabled()) {
+	VoxelEngine &engine = VoxelEngine::get_singleton();
+	if (engine.is_threaded_graphics_resource_building_enabled()) {
 		DetailTextures textures = store_normalmap_data_to_textures(images);
 		output_textures->textures = textures;
 	} else {
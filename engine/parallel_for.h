@@ -0,0 +1,106 @@
+#ifndef VOXEL_PARALLEL_FOR_H
+#define VOXEL_PARALLEL_FOR_H
+
+#include "../util/containers/std_vector.h"
+#include "../util/math/funcs.h"
+#include "../util/memory/memory.h"
+#include "../util/tasks/threaded_task.h"
+#include "../util/thread/thread.h"
+#include "voxel_engine.h"
+
+#include <atomic>
+#include <memory>
+
+namespace zylann::voxel {
+
+namespace parallel_for_detail {
+
+template <typename F>
+struct SharedState {
+	F f;
+	unsigned int item_count;
+	unsigned int range_size;
+	unsigned int range_count;
+	std::atomic_uint next_range_index = { 0 };
+	std::atomic_uint completed_range_count = { 0 };
+
+	SharedState(F p_f, unsigned int p_item_count, unsigned int p_range_size) :
+			f(p_f),
+			item_count(p_item_count),
+			range_size(p_range_size),
+			range_count((p_item_count + p_range_size - 1) / p_range_size) {}
+
+	// Returns `false` when there are no ranges left to pick.
+	bool process_next_range() {
+		const unsigned int range_index = next_range_index.fetch_add(1);
+		if (range_index >= range_count) {
+			return false;
+		}
+		const unsigned int begin = range_index * range_size;
+		const unsigned int end = math::min(begin + range_size, item_count);
+		f(begin, end);
+		++completed_range_count;
+		return true;
+	}
+};
+
+template <typename F>
+class Task : public IThreadedTask {
+public:
+	Task(std::shared_ptr<SharedState<F>> state) : _state(state) {}
+
+	const char *get_debug_name() const override {
+		return "ParallelFor";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		while (_state->process_next_range()) {
+		}
+	}
+
+private:
+	std::shared_ptr<SharedState<F>> _state;
+};
+
+} // namespace parallel_for_detail
+
+// Calls `f(begin, end)` on consecutive ranges of items covering `[0, item_count)`, using threads of `VoxelEngine` in
+// addition to the calling thread. Returns when all items have been processed.
+// The calling thread processes ranges too, so this still makes progress if all threads are busy. It only loses
+// parallelism.
+// `f` must be safe to call from multiple threads at once.
+template <typename F>
+void parallel_for_ranges(const unsigned int item_count, const unsigned int range_size, F f) {
+	ZN_ASSERT_RETURN(range_size > 0);
+	if (item_count == 0) {
+		return;
+	}
+
+	std::shared_ptr<parallel_for_detail::SharedState<F>> state =
+			make_shared_instance<parallel_for_detail::SharedState<F>>(f, item_count, range_size);
+
+	VoxelEngine &engine = VoxelEngine::get_singleton();
+	// The calling thread takes one range, no need to spawn tasks for it
+	const unsigned int task_count = math::min(state->range_count - 1, engine.get_thread_count());
+
+	if (task_count > 0) {
+		StdVector<IThreadedTask *> tasks;
+		tasks.reserve(task_count);
+		for (unsigned int i = 0; i < task_count; ++i) {
+			tasks.push_back(ZN_NEW(parallel_for_detail::Task<F>(state)));
+		}
+		engine.push_async_tasks(to_span(tasks));
+	}
+
+	while (state->process_next_range()) {
+	}
+
+	// Wait for ranges other threads picked. Tasks that start after this only find there is nothing left to do.
+	while (state->completed_range_count < state->range_count) {
+		Thread::sleep_usec(10);
+	}
+}
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_PARALLEL_FOR_H
@@ -50,7 +50,10 @@ VoxelEngine::VoxelEngine(Config config) {
 
 	const int maximum_thread_count =
 			math::max(hw_threads_hint - config.thread_count_margin_below_max, config.thread_count_minimum);
-	const int thread_count_by_ratio = int(Math::round(float(config.thread_count_ratio_over_max) * hw_threads_hint));
+	// In headless mode there is no rendering to share the CPU with, so we use as many threads as we are allowed to.
+	const int thread_count_by_ratio = config.headless
+			? maximum_thread_count
+			: int(Math::round(float(config.thread_count_ratio_over_max) * hw_threads_hint));
 	const int thread_count = math::clamp(thread_count_by_ratio, config.thread_count_minimum, maximum_thread_count);
 	ZN_PRINT_VERBOSE(format("Voxel: automatic thread count set to {}", thread_count));
 
@@ -71,7 +74,13 @@ VoxelEngine::VoxelEngine(Config config) {
 	ZN_PRINT_VERBOSE(format("Size of SaveBlockDataTask: {}", sizeof(SaveBlockDataTask)));
 	ZN_PRINT_VERBOSE(format("Size of MeshBlockTask: {}", sizeof(MeshBlockTask)));
 
-	if (RenderingServer::get_singleton() != nullptr) {
+	_headless = config.headless;
+
+	if (_headless) {
+		// Never touching rendering in headless mode, so GPU features are not available.
+		ZN_PRINT_VERBOSE("Voxel: running in headless mode, GPU functionality won't be supported.");
+
+	} else if (RenderingServer::get_singleton() != nullptr) {
 		_rendering_device = RenderingServer::get_singleton()->create_local_rendering_device();
 	} else {
 		// Sadly, that happens. This is a problem in GDExtension...
@@ -98,6 +107,7 @@ VoxelEngine::VoxelEngine(Config config) {
 	}
 
 	set_main_thread_time_budget_usec(config.main_thread_budget_usec);
+	set_threaded_collision_shape_building_enabled(config.threaded_collision_shape_building);
 }
 
 void VoxelEngine::load_shaders() {
@@ -183,6 +193,15 @@ void VoxelEngine::wait_and_clear_all_tasks(bool warn) {
 	});
 }
 
+void VoxelEngine::set_thread_count(unsigned int count) {
+	ZN_ASSERT_RETURN(count >= 1);
+	_general_thread_pool.set_thread_count(count);
+}
+
+unsigned int VoxelEngine::get_thread_count() const {
+	return _general_thread_pool.get_thread_count();
+}
+
 VolumeID VoxelEngine::add_volume(VolumeCallbacks callbacks) {
 	ZN_ASSERT(callbacks.check_callbacks());
 	Volume volume;
@@ -211,7 +230,9 @@ bool VoxelEngine::is_volume_valid(VolumeID volume_id) const {
 }
 
 ViewerID VoxelEngine::add_viewer() {
-	return _world.viewers.add(Viewer());
+	Viewer viewer;
+	viewer.require_visuals = !_headless;
+	return _world.viewers.add(viewer);
 }
 
 void VoxelEngine::remove_viewer(ViewerID viewer_id) {
@@ -235,7 +256,8 @@ VoxelEngine::Viewer::Distances VoxelEngine::get_viewer_distances(ViewerID viewer
 
 void VoxelEngine::set_viewer_requires_visuals(ViewerID viewer_id, bool enabled) {
 	Viewer &viewer = _world.viewers.get(viewer_id);
-	viewer.require_visuals = enabled;
+	// Viewers never require visuals in headless mode, so terrains don't allocate mesh state for them
+	viewer.require_visuals = enabled && !_headless;
 }
 
 bool VoxelEngine::is_viewer_requiring_visuals(ViewerID viewer_id) const {
@@ -304,6 +326,14 @@ bool VoxelEngine::is_threaded_graphics_resource_building_enabled() const {
 	return _threaded_graphics_resource_building_enabled;
 }
 
+void VoxelEngine::set_threaded_collision_shape_building_enabled(bool enable) {
+	_threaded_collision_shape_building_enabled = enable;
+}
+
+bool VoxelEngine::is_threaded_collision_shape_building_enabled() const {
+	return _threaded_collision_shape_building_enabled;
+}
+
 void VoxelEngine::push_async_task(zylann::IThreadedTask *task) {
 	_general_thread_pool.enqueue(task, false);
 }
@@ -427,6 +457,12 @@ VoxelEngine::Stats VoxelEngine::get_stats() const {
 	s.meshing_tasks = MeshBlockTask::debug_get_running_count();
 	s.streaming_tasks = LoadBlockDataTask::debug_get_running_count() + SaveBlockDataTask::debug_get_running_count();
 	s.main_thread_tasks = _time_spread_task_runner.get_pending_count() + _progressive_task_runner.get_pending_count();
+
+	s.detail_texture_cpu_texels = _debug_detail_texture_cpu_texel_count;
+	const uint64_t detail_texture_cpu_time_usec = _debug_detail_texture_cpu_time_usec;
+	s.detail_texture_cpu_texels_per_second = detail_texture_cpu_time_usec == 0
+			? 0.f
+			: double(s.detail_texture_cpu_texels) * 1000000.0 / double(detail_texture_cpu_time_usec);
 	return s;
 }
 
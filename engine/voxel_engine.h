@@ -6,6 +6,7 @@
 #include "../util/containers/slot_map.h"
 #include "../util/containers/std_vector.h"
 #include "../util/godot/classes/rendering_device.h"
+#include "../util/godot/classes/shape_3d.h"
 #include "../util/io/file_locker.h"
 #include "../util/memory/memory.h"
 #include "../util/string/std_string.h"
@@ -56,6 +57,11 @@ public:
 		bool has_mesh_resource;
 		// Tells if the meshing task was required to build a rendering mesh if possible.
 		bool visual_was_required;
+		// Tells if the collision shape was built as part of the task. If not, you need to build it on the main thread
+		// from `surfaces` if it is needed.
+		bool has_collision_shape_resource = false;
+		// Only used if `has_collision_shape_resource` is true. Can be null if the mesh had no collidable surface.
+		Ref<Shape3D> collision_shape;
 		// Can be null. Attached to meshing output so it is tracked more easily, because it is baked asynchronously
 		// starting from the mesh task, and it might complete earlier or later than the mesh.
 		std::shared_ptr<DetailTextureOutput> detail_textures;
@@ -138,6 +144,10 @@ public:
 		// Portion of available CPU threads to attempt using
 		float thread_count_ratio_over_max = 0.5;
 		unsigned int main_thread_budget_usec = DEFAULT_MAIN_THREAD_BUDGET_USEC;
+		bool threaded_collision_shape_building = true;
+		// When enabled, terrains only stream voxel data and collisions. Nothing is sent to the RenderingServer, and
+		// the thread pool is sized for throughput since there are no frames to render. Intended for dedicated servers.
+		bool headless = false;
 	};
 
 	static VoxelEngine &get_singleton();
@@ -189,6 +199,18 @@ public:
 	// This should be fast and safe to access from multiple threads.
 	bool is_threaded_graphics_resource_building_enabled() const;
 
+	// Allows/disallows building collision shapes from inside threads. This includes the acceleration structure the
+	// physics engine builds from triangles, which can be expensive.
+	void set_threaded_collision_shape_building_enabled(bool enable);
+	// This should be fast and safe to access from multiple threads.
+	bool is_threaded_collision_shape_building_enabled() const;
+
+	// Headless mode is decided at startup and cannot be changed afterward.
+	// Thread-safe.
+	inline bool is_headless() const {
+		return _headless;
+	}
+
 	void push_main_thread_progressive_task(IProgressiveTask *task);
 
 	// Thread-safe.
@@ -204,6 +226,11 @@ public:
 	void process();
 	void wait_and_clear_all_tasks(bool warn);
 
+	// Changes the number of threads of the general pool. Tasks already queued are not dropped.
+	// This is slow, it should not be used often. It is mostly useful for benchmarks.
+	void set_thread_count(unsigned int count);
+	unsigned int get_thread_count() const;
+
 	inline FileLocker &get_file_locker() {
 		return _file_locker;
 	}
@@ -228,6 +255,10 @@ public:
 		int streaming_tasks;
 		int meshing_tasks;
 		int main_thread_tasks;
+		// Texels of detail textures rendered on the CPU since startup
+		uint64_t detail_texture_cpu_texels;
+		// Texels rendered per second of time spent rendering detail textures on the CPU, per thread
+		float detail_texture_cpu_texels_per_second;
 	};
 
 	Stats get_stats() const;
@@ -276,6 +307,11 @@ public:
 	// TODO Should be private, but can't because `memdelete<T>` would be unable to call it otherwise...
 	~VoxelEngine();
 
+	inline void debug_add_detail_texture_cpu_stats(uint64_t texel_count, uint64_t time_spent_usec) {
+		_debug_detail_texture_cpu_texel_count += texel_count;
+		_debug_detail_texture_cpu_time_usec += time_spent_usec;
+	}
+
 	inline void debug_increment_generate_block_task_counter() {
 		// Need to conditionally do this to avoid "unused variable" warnings in non-profiling builds
 #ifdef ZN_PROFILER_ENABLED
@@ -338,6 +374,8 @@ private:
 	FileLocker _file_locker;
 
 	bool _threaded_graphics_resource_building_enabled = false;
+	bool _threaded_collision_shape_building_enabled = true;
+	bool _headless = false;
 
 	// Rendering device used for compute shaders. May not be available depending on the chosen renderer.
 	RenderingDevice *_rendering_device = nullptr;
@@ -359,6 +397,9 @@ private:
 
 	// There can be multiple types of generation tasks, so we count them with a common counter.
 	std::atomic_int _debug_generate_block_task_count = { 0 };
+
+	std::atomic_uint64_t _debug_detail_texture_cpu_texel_count = { 0 };
+	std::atomic_uint64_t _debug_detail_texture_cpu_time_usec = { 0 };
 };
 
 struct VoxelFileLockerRead {
@@ -2,6 +2,7 @@
 #include "../constants/version.gen.h"
 #include "../constants/voxel_string_names.h"
 #include "../storage/voxel_memory_pool.h"
+#include "../util/godot/classes/display_server.h"
 #include "../util/godot/classes/project_settings.h"
 #include "../util/godot/classes/rendering_server.h"
 #include "../util/godot/core/packed_arrays.h"
@@ -50,6 +51,12 @@ VoxelEngine::Config VoxelEngine::get_config_from_godot() {
 			Variant::INT, "voxel/threads/main/time_budget_ms", PROPERTY_HINT_RANGE, "0,1000", 8, true
 	);
 
+	add_custom_project_setting(
+			Variant::BOOL, "voxel/threads/collision/threaded_shape_building", PROPERTY_HINT_NONE, "", true, true
+	);
+
+	add_custom_project_setting(Variant::BOOL, "voxel/headless", PROPERTY_HINT_NONE, "", false, true);
+
 	add_custom_project_setting(Variant::BOOL, "voxel/ownership_checks", PROPERTY_HINT_NONE, "", true, true);
 
 	config.inner.main_thread_budget_usec = 1000 * int(ps.get("voxel/threads/main/time_budget_ms"));
@@ -63,6 +70,14 @@ VoxelEngine::Config VoxelEngine::get_config_from_godot() {
 	config.inner.thread_count_ratio_over_max =
 			math::clamp(float(ps.get("voxel/threads/count/ratio_over_max")), 0.f, 1.f);
 
+	// Building collision shapes involves the physics server building a BVH of triangles, which can be done in
+	// threads. This may be turned off if the physics engine in use doesn't support it.
+	config.inner.threaded_collision_shape_building = ps.get("voxel/threads/collision/threaded_shape_building");
+
+	// Headless mode is also enabled automatically when Godot runs with `--headless` (dedicated servers)
+	config.inner.headless = bool(ps.get("voxel/headless")) ||
+			(DisplayServer::get_singleton() != nullptr && DisplayServer::get_singleton()->get_name() == "headless");
+
 	config.ownership_checks = ps.get("voxel/ownership_checks");
 
 	return config;
@@ -140,13 +155,22 @@ Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats &stats) {
 	mem["std_current"] = -1;
 #endif
 
+	Dictionary detail_rendering;
+	detail_rendering["cpu_texels"] = static_cast<int64_t>(stats.detail_texture_cpu_texels);
+	detail_rendering["cpu_texels_per_second"] = stats.detail_texture_cpu_texels_per_second;
+
 	Dictionary d;
 	d["thread_pools"] = pools;
 	d["tasks"] = tasks;
 	d["memory_pools"] = mem;
+	d["detail_rendering"] = detail_rendering;
 	return d;
 }
 
+bool VoxelEngine::is_headless() const {
+	return zylann::voxel::VoxelEngine::get_singleton().is_headless();
+}
+
 Dictionary VoxelEngine::get_stats() const {
 	ZN_PROFILE_SCOPE();
 	return to_dict(zylann::voxel::VoxelEngine::get_singleton().get_stats());
@@ -186,6 +210,7 @@ void VoxelEngine::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_version_minor"), &VoxelEngine::get_version_minor);
 	ClassDB::bind_method(D_METHOD("get_version_patch"), &VoxelEngine::get_version_patch);
 	ClassDB::bind_method(D_METHOD("get_stats"), &VoxelEngine::get_stats);
+	ClassDB::bind_method(D_METHOD("is_headless"), &VoxelEngine::is_headless);
 }
 
 } // namespace zylann::voxel::godot
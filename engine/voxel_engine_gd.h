@@ -32,6 +32,7 @@ public:
 	int get_version_patch() const;
 
 	Dictionary get_stats() const;
+	bool is_headless() const;
 	void schedule_task(Ref<ZN_ThreadedTask> task);
 
 #ifdef TOOLS_ENABLED
@@ -66,7 +66,7 @@ void GenerateBlockMultipassCBTask::run(zylann::ThreadedTaskContext &ctx) {
 		SpatialLock2D::Read srlock(map.spatial_lock, BoxBounds2i::from_position(column_position));
 		VoxelGeneratorMultipassCBStructs::Column *column = nullptr;
 		{
-			MutexLock mlock(map.mutex);
+			RWLockRead rlock(map.columns_lock);
 			auto column_it = map.columns.find(column_position);
 			if (column_it == map.columns.end()) {
 				// Drop, for some reason it wasn't available
@@ -2,6 +2,7 @@
 #include "../../engine/buffered_task_scheduler.h"
 #include "../../engine/voxel_engine.h"
 #include "../../storage/voxel_data.h"
+#include "../../util/containers/container_funcs.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/dstack.h"
 #include "../../util/godot/classes/time.h"
@@ -98,16 +99,23 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 					map.spatial_lock, BoxBounds2i::from_position(_column_position)
 			);
 
-			MutexLock mlock(map.mutex);
-			auto column_it = map.columns.find(_column_position);
-			if (column_it != map.columns.end()) {
+			Column *column = nullptr;
+			{
+				RWLockRead rlock(map.columns_lock);
+				auto column_it = map.columns.find(_column_position);
+				if (column_it != map.columns.end()) {
+					column = &column_it->second;
+				}
+			}
+			if (column != nullptr) {
 				// Unregister task from the column
-				Column &column = column_it->second;
-				column.pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+				column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+				// Tasks waiting on this one will have to look for another way
+				schedule_dependents(*column, _subpass_index, task_scheduler);
 
 				if (_subpass_index == final_subpass_index) {
 					// Schedule pending block requests to make them handle cancellation
-					schedule_final_block_tasks(column, task_scheduler);
+					schedule_final_block_tasks(*column, task_scheduler);
 				}
 			}
 		}
@@ -158,8 +166,8 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		{
 			ZN_PROFILE_SCOPE_NAMED("Fetch columns");
 
-			// TODO We don't create new columns from here, could use a shared lock?
-			MutexLock mlock(map.mutex);
+			// We don't create new columns from here, so other tasks can do lookups at the same time
+			RWLockRead rlock(map.columns_lock);
 
 			Vector2i bpos;
 			// Coordinate order matters (note, Y in Vector2i corresponds to Z in 3D here).
@@ -178,7 +186,8 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 		Column *main_column = columns[central_block_index];
 
-		bool spawned_subtasks = false;
+		// Set when the task registered itself to be scheduled back when dependencies are ready
+		bool waiting_on_dependencies = false;
 		bool postpone = false;
 
 		// Check loading levels
@@ -198,6 +207,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 					if (main_column != nullptr) {
 						main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+						schedule_dependents(*main_column, _subpass_index, task_scheduler);
 
 						if (_subpass_index == final_subpass_index) {
 							// Schedule pending block requests to make them handle cancellation
@@ -219,6 +229,12 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 					Column *column = columns[i];
 					ZN_ASSERT(column != nullptr);
 
+					if (column->subpass_index >= 0 && !column->loading && column->blocks.size() > 0 &&
+						column->blocks[0].voxels.get_size() != Vector3iUtil::create(_block_size)) {
+						// Loaded from the persistent cache, but was generated with a different block size. Start over.
+						column->subpass_index = -1;
+					}
+
 					// We want all blocks in the neighborhood to be at least at the previous subpass before we can
 					// run the current subpass
 					if (prev_subpass_index >= 0 && column->subpass_index < prev_subpass_index) {
@@ -232,12 +248,20 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 							postpone = true;
 
 						} else if ((column->pending_subpass_tasks_mask & (1 << prev_subpass_index)) != 0) {
-							// A task is pending to work on the dependency, so we wait.
-							// TODO Ideally we should subscribe to the completion of that task.
-							// We can do that
-							// println(format("O {} {} {} {} {}", int(_subpass_index), _column_position.x, 0,
-							// 		_column_position.y, Time::get_singleton()->get_ticks_usec()));
-							postpone = true;
+							// A task is pending to work on the dependency. Subscribe to its completion, so we get
+							// scheduled as soon as the neighborhood is ready, instead of polling it. That task
+							// can't complete before we are done here, because it needs to lock that column too.
+
+							if (dependency_counter == nullptr) {
+								dependency_counter = make_shared_instance<std::atomic_int>();
+							}
+							++(*dependency_counter);
+
+							column->dependents.push_back(
+									ColumnDependent{ this, dependency_counter, int8_t(prev_subpass_index) }
+							);
+
+							waiting_on_dependencies = true;
 
 						} else {
 							// No task is pending to work on the dependency, spawn one.
@@ -262,7 +286,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 							column->pending_subpass_tasks_mask |= (1 << prev_subpass_index);
 
-							spawned_subtasks = true;
+							waiting_on_dependencies = true;
 						}
 						// TODO If a column got deallocated after it was returned once, restart its generation process.
 						// This would be to cover cases where blocks of a column get requested more than once. In the
@@ -271,6 +295,10 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 						// - Saving could have failed
 						// - Files could have been deleted
 						// - The game could simply want to reset an area
+
+					} else if (column->loading) {
+						// The column is being loaded from the persistent cache, which may change its subpass
+						postpone = true;
 					}
 
 					++i;
@@ -278,7 +306,8 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			}
 		}
 
-		if (spawned_subtasks) {
+		if (waiting_on_dependencies) {
+			// Subtasks or pending tasks now own the current task, and will schedule it back
 			ctx.status = ThreadedTaskContext::STATUS_TAKEN_OUT;
 
 		} else if (postpone) {
@@ -354,6 +383,9 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 			main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
 
+			// Columns around may now be able to run their next subpass
+			schedule_dependents(*main_column, _subpass_index, task_scheduler);
+
 			if (main_column->subpass_index == final_subpass_index) {
 				// All tasks that were waiting for this column to be complete (and did not spawn column subtasks
 				// themselves) may now resume
@@ -379,6 +411,24 @@ void GenerateColumnMultipassTask::schedule_final_block_tasks(Column &column, Buf
 	}
 }
 
+void GenerateColumnMultipassTask::schedule_dependents(
+		Column &column,
+		int subpass_index,
+		BufferedTaskScheduler &task_scheduler
+) {
+	unordered_remove_if(column.dependents, [subpass_index, &task_scheduler](const ColumnDependent &dependent) {
+		if (subpass_index != -1 && dependent.subpass_index != subpass_index) {
+			return false;
+		}
+		const int counter = --(*dependent.dependency_counter);
+		ZN_ASSERT(counter >= 0);
+		if (counter == 0) {
+			task_scheduler.push_main_task(dependent.task);
+		}
+		return true;
+	});
+}
+
 void GenerateColumnMultipassTask::return_to_caller(bool success) {
 	ZN_ASSERT(_caller_task != nullptr);
 	ZN_ASSERT(_caller_task_dependency_counter != nullptr);
@@ -13,7 +13,8 @@ class BufferedTaskScheduler;
 // If at least one column isn't found in the map, the task is cancelled, and so should be all its callers.
 // Otherwise:
 // If a column doesn't fulfills dependency requirements:
-//     - If another task is working on that column, the current task is postponed to run later.
+//     - If another task is working on that column, the current task registers itself as a dependent of that column,
+//       and will be scheduled back as soon as that task completes (or cancels).
 //     - Otherwise, a subtask is spawned to work on the dependency.
 //       The current task is queued after every subtask spawned this way.
 // Otherwise, the task runs the pass, re-schedules its caller, and returns.
@@ -48,6 +49,15 @@ public:
 		return _priority;
 	}
 
+	// Schedules tasks that were waiting for the given column to be processed by the given subpass, if all their other
+	// dependencies are also met. If `subpass_index` is -1, all waiting tasks are considered.
+	// The column must be locked for writing.
+	static void schedule_dependents(
+			VoxelGeneratorMultipassCBStructs::Column &column,
+			int subpass_index,
+			BufferedTaskScheduler &task_scheduler
+	);
+
 	// Cancellation cannot use this API for now (it would prevent the task from running) because the task must run in
 	// order to re-schedule its caller. Eventually we may find a way to integrate this pattern into the framework.
 	// bool is_cancelled() {}
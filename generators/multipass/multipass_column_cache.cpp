@@ -0,0 +1,330 @@
+#include "multipass_column_cache.h"
+#include "../../engine/voxel_engine.h"
+#include "../../streams/region/file_utils.h"
+#include "../../streams/voxel_block_serializer.h"
+#include "../../util/containers/fixed_array.h"
+#include "../../util/godot/classes/file_access.h"
+#include "../../util/hash_funcs.h"
+#include "../../util/io/log.h"
+#include "../../util/profiling.h"
+#include "../../util/string/format.h"
+#include "../../util/tasks/threaded_task.h"
+
+#include <cstring>
+
+namespace zylann::voxel {
+
+using namespace VoxelGeneratorMultipassCBStructs;
+
+namespace {
+
+const uint8_t FORMAT_VERSION = 1;
+const char *FILE_MAGIC = "VXMC";
+
+} // namespace
+
+uint64_t MultipassColumnCache::get_params_hash(const Internal &internal) {
+	uint64_t h = hash_djb2_one_64(FORMAT_VERSION);
+	h = hash_djb2_one_64(internal.passes.size(), h);
+	for (const Pass &pass : internal.passes) {
+		h = hash_djb2_one_64(pass.dependency_extents, h);
+	}
+	h = hash_djb2_one_64(static_cast<int64_t>(internal.column_base_y_blocks), h);
+	h = hash_djb2_one_64(internal.column_height_blocks, h);
+	h = hash_djb2_one_64(static_cast<int64_t>(internal.persistent_cache_version), h);
+	return h;
+}
+
+MultipassColumnCache::MultipassColumnCache(String root_directory, uint64_t params_hash) {
+	_directory = root_directory.path_join(String::num_uint64(params_hash, 16));
+}
+
+String MultipassColumnCache::get_column_file_path(Vector2i cpos) const {
+	return _directory.path_join(String("{0}_{1}.vxmc").format(varray(cpos.x, cpos.y)));
+}
+
+void MultipassColumnCache::add_pending_save(Vector2i cpos, std::shared_ptr<ColumnData> data) {
+	ZN_ASSERT(data != nullptr);
+	MutexLock mlock(_pending_saves_mutex);
+	// Overwrites any previous pending save, which will then be skipped
+	_pending_saves[cpos] = data;
+}
+
+void MultipassColumnCache::save_pending(Vector2i cpos, const std::shared_ptr<ColumnData> &data) {
+	const String fpath = get_column_file_path(cpos);
+	// Lock the file before removing from pending saves, so loading can't read the file before it is written
+	VoxelFileLockerWrite file_wlock(zylann::godot::to_std_string(fpath));
+	{
+		MutexLock mlock(_pending_saves_mutex);
+		auto it = _pending_saves.find(cpos);
+		if (it == _pending_saves.end() || it->second != data) {
+			// The column was loaded again, or a more recent version is pending
+			return;
+		}
+		_pending_saves.erase(it);
+	}
+	// From here we are the only owner of the data
+	save_without_file_lock(fpath, *data);
+}
+
+void MultipassColumnCache::save(Vector2i cpos, const ColumnData &data) {
+	const String fpath = get_column_file_path(cpos);
+	VoxelFileLockerWrite file_wlock(zylann::godot::to_std_string(fpath));
+	save_without_file_lock(fpath, data);
+}
+
+void MultipassColumnCache::save_without_file_lock(const String &fpath, const ColumnData &data) {
+	ZN_PROFILE_SCOPE();
+
+	if (!_directory_created) {
+		const Error err = check_directory_created_with_file_locker(_directory);
+		ERR_FAIL_COND_MSG(
+				err != OK, String("Could not create multipass cache directory {0}").format(varray(_directory))
+		);
+		_directory_created = true;
+	}
+
+	Error err;
+	Ref<FileAccess> f = zylann::godot::open_file(fpath, FileAccess::WRITE, err);
+	ERR_FAIL_COND_MSG(f.is_null(), String("Could not save {0}").format(varray(fpath)));
+
+	zylann::godot::store_buffer(**f, Span<const uint8_t>(reinterpret_cast<const uint8_t *>(FILE_MAGIC), 4));
+	f->store_8(FORMAT_VERSION);
+	f->store_8(static_cast<uint8_t>(data.subpass_index));
+	f->store_8(data.blocks.size());
+
+	for (const Block &block : data.blocks) {
+		BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(block.voxels);
+		ERR_FAIL_COND(!result.success);
+		f->store_32(result.data.size());
+		zylann::godot::store_buffer(**f, to_span(result.data));
+	}
+}
+
+bool MultipassColumnCache::take_pending(Vector2i cpos, ColumnData &out_data) {
+	std::shared_ptr<ColumnData> data;
+	{
+		MutexLock mlock(_pending_saves_mutex);
+		auto it = _pending_saves.find(cpos);
+		if (it == _pending_saves.end()) {
+			return false;
+		}
+		// Not written yet, take it back. Its save task will skip it.
+		data = it->second;
+		_pending_saves.erase(it);
+	}
+	out_data = std::move(*data);
+	return true;
+}
+
+bool MultipassColumnCache::load(Vector2i cpos, unsigned int column_height_blocks, ColumnData &out_data) {
+	ZN_PROFILE_SCOPE();
+
+	const String fpath = get_column_file_path(cpos);
+	VoxelFileLockerRead file_rlock(zylann::godot::to_std_string(fpath));
+
+	Error err;
+	Ref<FileAccess> f = zylann::godot::open_file(fpath, FileAccess::READ, err);
+	if (f.is_null()) {
+		// Not in the cache
+		return false;
+	}
+
+	FixedArray<uint8_t, 4> magic;
+	if (zylann::godot::get_buffer(**f, to_span(magic)) != magic.size() || memcmp(magic.data(), FILE_MAGIC, 4) != 0) {
+		ZN_PRINT_ERROR(format("Invalid multipass cache file {}", zylann::godot::to_std_string(fpath)));
+		return false;
+	}
+
+	const uint8_t version = f->get_8();
+	if (version != FORMAT_VERSION) {
+		ZN_PRINT_VERBOSE(format("Ignoring multipass cache file with format version {}", int(version)));
+		return false;
+	}
+
+	const int8_t subpass_index = static_cast<int8_t>(f->get_8());
+	const unsigned int block_count = f->get_8();
+	if (block_count != column_height_blocks) {
+		// Shouldn't happen since column height is part of the directory hash, but the file could have been moved
+		ZN_PRINT_ERROR(
+				format("Unexpected block count in multipass cache file {}", zylann::godot::to_std_string(fpath))
+		);
+		return false;
+	}
+
+	out_data.subpass_index = subpass_index;
+	out_data.blocks.resize(block_count);
+
+	for (Block &block : out_data.blocks) {
+		const unsigned int size = f->get_32();
+		if (!BlockSerializer::decompress_and_deserialize(**f, size, block.voxels)) {
+			ZN_PRINT_ERROR(
+					format("Failed to read block in multipass cache file {}", zylann::godot::to_std_string(fpath))
+			);
+			out_data.blocks.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+namespace {
+
+class LoadMultipassColumnsTask : public IThreadedTask {
+public:
+	LoadMultipassColumnsTask(std::shared_ptr<Internal> internal, StdVector<Vector2i> &&positions) :
+			_internal(internal), _positions(std::move(positions)) {}
+
+	const char *get_debug_name() const override {
+		return "LoadMultipassColumns";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		ZN_PROFILE_SCOPE();
+		ZN_ASSERT(_internal != nullptr);
+
+		Internal &internal = *_internal;
+		Map &map = internal.map;
+
+		for (const Vector2i cpos : _positions) {
+			ZN_ASSERT(internal.persistent_cache != nullptr);
+			MultipassColumnCache &cache = *internal.persistent_cache;
+
+			MultipassColumnCache::ColumnData data;
+			const bool taken_from_pending = cache.take_pending(cpos, data);
+			const bool found = taken_from_pending || cache.load(cpos, internal.column_height_blocks, data);
+
+			SpatialLock2D::Write swlock(map.spatial_lock, BoxBounds2i::from_position(cpos));
+
+			Column *column = nullptr;
+			{
+				RWLockRead rlock(map.columns_lock);
+				auto it = map.columns.find(cpos);
+				if (it != map.columns.end()) {
+					column = &it->second;
+				}
+			}
+
+			if (column == nullptr || !column->loading) {
+				// Unloaded in the meantime, or was already loaded by another task
+				if (taken_from_pending) {
+					// Was never written, don't lose it
+					cache.save(cpos, data);
+				}
+				continue;
+			}
+
+			if (found && data.blocks.size() == column->blocks.size()) {
+				// Move voxels only, because blocks may have tasks waiting on them
+				for (unsigned int i = 0; i < data.blocks.size(); ++i) {
+					column->blocks[i].voxels = std::move(data.blocks[i].voxels);
+				}
+				column->subpass_index = data.subpass_index;
+			}
+
+			// Tasks that were postponed because of loading can proceed
+			column->loading = false;
+		}
+	}
+
+private:
+	std::shared_ptr<Internal> _internal;
+	StdVector<Vector2i> _positions;
+};
+
+class SaveMultipassColumnsTask : public IThreadedTask {
+public:
+	SaveMultipassColumnsTask(
+			std::shared_ptr<MultipassColumnCache> cache,
+			StdVector<std::pair<Vector2i, std::shared_ptr<MultipassColumnCache::ColumnData>>> &&columns
+	) :
+			_cache(cache), _columns(std::move(columns)) {}
+
+	const char *get_debug_name() const override {
+		return "SaveMultipassColumns";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		ZN_PROFILE_SCOPE();
+		ZN_ASSERT(_cache != nullptr);
+		for (const auto &item : _columns) {
+			_cache->save_pending(item.first, item.second);
+		}
+	}
+
+private:
+	std::shared_ptr<MultipassColumnCache> _cache;
+	StdVector<std::pair<Vector2i, std::shared_ptr<MultipassColumnCache::ColumnData>>> _columns;
+};
+
+} // namespace
+
+void schedule_multipass_column_loads(std::shared_ptr<Internal> internal, StdVector<Vector2i> &&positions) {
+	if (positions.size() == 0) {
+		return;
+	}
+	VoxelEngine::get_singleton().push_async_io_task(ZN_NEW(LoadMultipassColumnsTask(internal, std::move(positions))));
+}
+
+void schedule_multipass_column_saves(
+		std::shared_ptr<MultipassColumnCache> cache,
+		StdVector<std::pair<Vector2i, std::shared_ptr<MultipassColumnCache::ColumnData>>> &&columns
+) {
+	if (columns.size() == 0) {
+		return;
+	}
+	VoxelEngine::get_singleton().push_async_io_task(ZN_NEW(SaveMultipassColumnsTask(cache, std::move(columns))));
+}
+
+void schedule_multipass_loaded_column_saves(Internal &internal) {
+	if (internal.persistent_cache == nullptr) {
+		return;
+	}
+	ZN_PROFILE_SCOPE();
+
+	Map &map = internal.map;
+
+	StdVector<Vector2i> positions;
+	{
+		RWLockRead rlock(map.columns_lock);
+		positions.reserve(map.columns.size());
+		for (auto it = map.columns.begin(); it != map.columns.end(); ++it) {
+			positions.push_back(it->first);
+		}
+	}
+
+	StdVector<std::pair<Vector2i, std::shared_ptr<MultipassColumnCache::ColumnData>>> columns;
+
+	for (const Vector2i cpos : positions) {
+		// Same locking order as generation tasks: spatial lock first, then the map
+		SpatialLock2D::Read srlock(map.spatial_lock, BoxBounds2i::from_position(cpos));
+		RWLockRead rlock(map.columns_lock);
+
+		auto it = map.columns.find(cpos);
+		if (it == map.columns.end()) {
+			// Unloaded in the meantime, in which case it got saved already
+			continue;
+		}
+		const Column &column = it->second;
+		if (column.subpass_index < 0 || column.loading) {
+			continue;
+		}
+
+		// Columns remain loaded, so their voxels are copied
+		std::shared_ptr<MultipassColumnCache::ColumnData> data =
+				make_shared_instance<MultipassColumnCache::ColumnData>();
+		data->subpass_index = column.subpass_index;
+		data->blocks.resize(column.blocks.size());
+		for (unsigned int i = 0; i < column.blocks.size(); ++i) {
+			column.blocks[i].voxels.copy_to(data->blocks[i].voxels, true);
+		}
+
+		internal.persistent_cache->add_pending_save(cpos, data);
+		columns.push_back({ cpos, data });
+	}
+
+	schedule_multipass_column_saves(internal.persistent_cache, std::move(columns));
+}
+
+} // namespace zylann::voxel
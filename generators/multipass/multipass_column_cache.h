@@ -0,0 +1,89 @@
+#ifndef VOXEL_MULTIPASS_COLUMN_CACHE_H
+#define VOXEL_MULTIPASS_COLUMN_CACHE_H
+
+#include "../../util/containers/std_unordered_map.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/string.h"
+#include "../../util/math/vector2i.h"
+#include "../../util/thread/mutex.h"
+#include "voxel_generator_multipass_cb_structs.h"
+
+#include <atomic>
+#include <memory>
+
+namespace zylann::voxel {
+
+// Optional persistent storage of partially generated columns, used by `VoxelGeneratorMultipassCB`.
+// When a column gets unloaded from the generator's in-memory cache, its blocks and progress are written to disk. If it
+// gets requested again, in the same session or a later one, passes that already ran on it are not run again.
+// Files are stored in a sub-directory named after a hash of the generator's parameters, so changing them doesn't load
+// incompatible data.
+// There is one file per column, so this is not designed to be shipped with a game, it's only a cache.
+class MultipassColumnCache {
+public:
+	struct ColumnData {
+		int8_t subpass_index = -1;
+		StdVector<VoxelGeneratorMultipassCBStructs::Block> blocks;
+	};
+
+	static uint64_t get_params_hash(const VoxelGeneratorMultipassCBStructs::Internal &internal);
+
+	MultipassColumnCache(String root_directory, uint64_t params_hash);
+
+	// Registers a column to be written later with `save_pending`. If it gets loaded again before that, it will be
+	// taken from memory instead.
+	// Thread-safe.
+	void add_pending_save(Vector2i cpos, std::shared_ptr<ColumnData> data);
+
+	// Writes a column previously given to `add_pending_save`, unless it was loaded again in the meantime.
+	// Thread-safe.
+	void save_pending(Vector2i cpos, const std::shared_ptr<ColumnData> &data);
+
+	// Writes a column immediately.
+	// Thread-safe.
+	void save(Vector2i cpos, const ColumnData &data);
+
+	// Takes back a column that was not written yet. Returns `false` if there is none.
+	// Thread-safe.
+	bool take_pending(Vector2i cpos, ColumnData &out_data);
+
+	// Reads a column from disk.
+	// Returns `false` if the column is not in the cache, or is not compatible.
+	// Thread-safe.
+	bool load(Vector2i cpos, unsigned int column_height_blocks, ColumnData &out_data);
+
+	const String &get_directory() const {
+		return _directory;
+	}
+
+private:
+	String get_column_file_path(Vector2i cpos) const;
+	void save_without_file_lock(const String &fpath, const ColumnData &data);
+
+	String _directory;
+	std::atomic_bool _directory_created = { false };
+
+	StdUnorderedMap<Vector2i, std::shared_ptr<ColumnData>> _pending_saves;
+	Mutex _pending_saves_mutex;
+};
+
+// Loads columns from the persistent cache in an I/O task. Columns must have been flagged as `loading`.
+// If a column is not found in the cache, its flag is simply cleared so generation can proceed.
+void schedule_multipass_column_loads(
+		std::shared_ptr<VoxelGeneratorMultipassCBStructs::Internal> internal,
+		StdVector<Vector2i> &&positions
+);
+
+// Writes columns to the persistent cache in an I/O task. Columns must have been given to `add_pending_save` first.
+void schedule_multipass_column_saves(
+		std::shared_ptr<MultipassColumnCache> cache,
+		StdVector<std::pair<Vector2i, std::shared_ptr<MultipassColumnCache::ColumnData>>> &&columns
+);
+
+// Writes columns still loaded in the generator's map to the persistent cache in an I/O task, if the cache is enabled.
+// Columns stay loaded, so their voxels get copied.
+void schedule_multipass_loaded_column_saves(VoxelGeneratorMultipassCBStructs::Internal &internal);
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_MULTIPASS_COLUMN_CACHE_H
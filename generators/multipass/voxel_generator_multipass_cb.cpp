@@ -8,6 +8,8 @@
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "generate_block_multipass_cb_task.h"
+#include "generate_column_multipass_task.h"
+#include "multipass_column_cache.h"
 
 namespace zylann::voxel {
 
@@ -19,7 +21,10 @@ VoxelGeneratorMultipassCB::VoxelGeneratorMultipassCB() {
 	_internal = internal;
 }
 
-VoxelGeneratorMultipassCB::~VoxelGeneratorMultipassCB() {}
+VoxelGeneratorMultipassCB::~VoxelGeneratorMultipassCB() {
+	// Terrains usually unload their columns before, but if some remain, they should not be lost
+	save_persistent_cache();
+}
 
 VoxelGenerator::Result VoxelGeneratorMultipassCB::generate_block(VoxelQueryData &input) {
 	if (input.lod > 0) {
@@ -156,8 +161,51 @@ void VoxelGeneratorMultipassCB::set_pass_extent_blocks(int pass_index, int new_e
 	re_initialize_column_refcounts();
 }
 
+String VoxelGeneratorMultipassCB::get_persistent_cache_directory() const {
+	return get_internal()->persistent_cache_directory;
+}
+
+void VoxelGeneratorMultipassCB::set_persistent_cache_directory(String directory) {
+	if (get_persistent_cache_directory() == directory) {
+		return;
+	}
+	reset_internal([directory](Internal &internal) { //
+		internal.persistent_cache_directory = directory;
+	});
+	re_initialize_column_refcounts();
+}
+
+int VoxelGeneratorMultipassCB::get_persistent_cache_version() const {
+	return get_internal()->persistent_cache_version;
+}
+
+void VoxelGeneratorMultipassCB::set_persistent_cache_version(int version) {
+	if (get_persistent_cache_version() == version) {
+		return;
+	}
+	reset_internal([version](Internal &internal) { //
+		internal.persistent_cache_version = version;
+	});
+	re_initialize_column_refcounts();
+}
+
+void VoxelGeneratorMultipassCB::save_persistent_cache() {
+	std::shared_ptr<Internal> internal = get_internal();
+	schedule_multipass_loaded_column_saves(*internal);
+}
+
 // Internal
 
+void VoxelGeneratorMultipassCB::update_persistent_cache(Internal &internal) {
+	if (internal.persistent_cache_directory.is_empty()) {
+		internal.persistent_cache = nullptr;
+	} else {
+		internal.persistent_cache = make_shared_instance<MultipassColumnCache>(
+				internal.persistent_cache_directory, MultipassColumnCache::get_params_hash(internal)
+		);
+	}
+}
+
 std::shared_ptr<Internal> VoxelGeneratorMultipassCB::get_internal() const {
 	MutexLock mlock(_internal_mutex);
 	ZN_ASSERT(_internal != nullptr);
@@ -283,65 +331,92 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 
 	BufferedTaskScheduler &task_scheduler = BufferedTaskScheduler::get_for_current_thread();
 
+	const bool use_persistent_cache = internal->persistent_cache != nullptr;
+	StdVector<Vector2i> columns_to_load;
+	StdVector<std::pair<Vector2i, std::shared_ptr<MultipassColumnCache::ColumnData>>> columns_to_save;
+
 	// Blocks to view
 	const int column_height = internal->column_height_blocks;
-	load_requested_box.difference(prev_load_requested_box, [&map, column_height](Box2i new_box) {
-		{
-			SpatialLock2D::Write swlock(map.spatial_lock, new_box);
-			MutexLock mlock(map.mutex);
-
-			new_box.for_each_cell_yx([&map, column_height](Vector2i bpos) {
-				Column &column = map.columns[bpos];
-				if (column.blocks.size() == 0) {
-					column.blocks.resize(column_height);
-				}
-				// if (block == nullptr) {
-				// 	block = make_unique_instance<Block>();
-				// 	// block->loading = true;
-				// }
-				column.viewers.add();
-			});
-
-			// TODO Implement loading tasks
-		}
-	});
-
-	// Blocks to unview
-	prev_load_requested_box.difference(load_requested_box, [&map, &task_scheduler](Box2i old_box) {
-		{
-			SpatialLock2D::Write swlock(map.spatial_lock, old_box);
-			MutexLock mlock(map.mutex);
-
-			old_box.for_each_cell_yx([&map, &task_scheduler](Vector2i cpos) {
-				auto it = map.columns.find(cpos);
-
-				// The block must be found because last time the block was in the loading area of the viewer.
-				ZN_ASSERT(it != map.columns.end());
-				Column &column = it->second;
-
-				column.viewers.remove();
-				if (column.viewers.get() == 0) {
-					for (Block &block : column.blocks) {
-						if (block.final_pending_task != nullptr) {
-							// There was a pending generate task, resume it, but it should basically return a drop.
-							// (also because we are locking the map, that task must not run until we're done
-							// removing its target column)
-							task_scheduler.push_main_task(block.final_pending_task);
-							block.final_pending_task = nullptr;
+	load_requested_box.difference(
+			prev_load_requested_box,
+			[&map, column_height, use_persistent_cache, &columns_to_load](Box2i new_box) {
+				SpatialLock2D::Write swlock(map.spatial_lock, new_box);
+				RWLockWrite wlock(map.columns_lock);
+
+				new_box.for_each_cell_yx([&map, column_height, use_persistent_cache, &columns_to_load](Vector2i bpos) {
+					Column &column = map.columns[bpos];
+					if (column.blocks.size() == 0) {
+						column.blocks.resize(column_height);
+						if (use_persistent_cache) {
+							// Generation tasks will wait until the column is loaded
+							column.loading = true;
+							columns_to_load.push_back(bpos);
 						}
 					}
+					// if (block == nullptr) {
+					// 	block = make_unique_instance<Block>();
+					// 	// block->loading = true;
+					// }
+					column.viewers.add();
+				});
+			}
+	);
+
+	// Blocks to unview
+	prev_load_requested_box.difference(
+			load_requested_box,
+			[&map, &task_scheduler, &internal, &columns_to_save](Box2i old_box) {
+				{
+					SpatialLock2D::Write swlock(map.spatial_lock, old_box);
+					RWLockWrite wlock(map.columns_lock);
+
+					old_box.for_each_cell_yx([&map, &task_scheduler, &internal, &columns_to_save](Vector2i cpos) {
+						auto it = map.columns.find(cpos);
+
+						// The block must be found because last time the block was in the loading area of the viewer.
+						ZN_ASSERT(it != map.columns.end());
+						Column &column = it->second;
+
+						column.viewers.remove();
+						if (column.viewers.get() == 0) {
+							for (Block &block : column.blocks) {
+								if (block.final_pending_task != nullptr) {
+									// There was a pending generate task, resume it, but it should basically return a
+									// drop. (also because we are locking the map, that task must not run until we're
+									// done removing its target column)
+									task_scheduler.push_main_task(block.final_pending_task);
+									block.final_pending_task = nullptr;
+								}
+							}
+
+							// Resume tasks that were waiting on this column. They will find it missing and cancel.
+							GenerateColumnMultipassTask::schedule_dependents(column, -1, task_scheduler);
+
+							if (internal->persistent_cache != nullptr && column.subpass_index >= 0 && !column.loading) {
+								std::shared_ptr<MultipassColumnCache::ColumnData> data =
+										make_shared_instance<MultipassColumnCache::ColumnData>();
+								data->subpass_index = column.subpass_index;
+								data->blocks = std::move(column.blocks);
+								// If it gets requested again before being written, it will be taken back from memory
+								internal->persistent_cache->add_pending_save(cpos, data);
+								columns_to_save.push_back({ cpos, data });
+							}
 
-					// TODO Implement saving tasks
-					// We remove immediately for now
-					map.columns.erase(it);
-					// println(format("U {} {} {} {} {}", 0, cpos.x, 0, cpos.y,
-					// Time::get_singleton()->get_ticks_usec()));
+							map.columns.erase(it);
+							// println(format("U {} {} {} {} {}", 0, cpos.x, 0, cpos.y,
+							// Time::get_singleton()->get_ticks_usec()));
+						}
+					});
 				}
-			});
-		}
-	});
+			}
+	);
 
 	task_scheduler.flush();
+
+	if (use_persistent_cache) {
+		schedule_multipass_column_loads(internal, std::move(columns_to_load));
+		schedule_multipass_column_saves(internal->persistent_cache, std::move(columns_to_save));
+	}
 }
 
 void VoxelGeneratorMultipassCB::clear_cache() {
@@ -355,7 +430,7 @@ void VoxelGeneratorMultipassCB::clear_cache() {
 	/*
 	Map &map = old_internal->map;
 	SpatialLock2D::Write swlock(map.spatial_lock, BoxBounds2i::from_everywhere());
-	MutexLock mlock(map.mutex);
+	RWLockWrite wlock(map.columns_lock);
 
 	BufferedTaskScheduler &task_scheduler = BufferedTaskScheduler::get_for_current_thread();
 
@@ -385,7 +460,7 @@ bool VoxelGeneratorMultipassCB::debug_try_get_column_states(StdVector<DebugColum
 	{
 		unsigned int size = 0;
 		{
-			MutexLock mlock(map.mutex);
+			RWLockRead rlock(map.columns_lock);
 			size = map.columns.size();
 		}
 		out_states.reserve(size);
@@ -398,7 +473,7 @@ bool VoxelGeneratorMultipassCB::debug_try_get_column_states(StdVector<DebugColum
 	}
 	SpatialLock2D::UnlockReadOnScopeExit srlock(map.spatial_lock, BoxBounds2i::from_everywhere());
 
-	MutexLock mlock(map.mutex);
+	RWLockRead rlock(map.columns_lock);
 
 	for (auto it = map.columns.begin(); it != map.columns.end(); ++it) {
 		Column &column = it->second;
@@ -630,6 +705,24 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			D_METHOD("set_column_height_blocks", "y"), &VoxelGeneratorMultipassCB::set_column_height_blocks
 	);
 
+	ClassDB::bind_method(
+			D_METHOD("get_persistent_cache_directory"), &VoxelGeneratorMultipassCB::get_persistent_cache_directory
+	);
+	ClassDB::bind_method(
+			D_METHOD("set_persistent_cache_directory", "directory"),
+			&VoxelGeneratorMultipassCB::set_persistent_cache_directory
+	);
+
+	ClassDB::bind_method(
+			D_METHOD("get_persistent_cache_version"), &VoxelGeneratorMultipassCB::get_persistent_cache_version
+	);
+	ClassDB::bind_method(
+			D_METHOD("set_persistent_cache_version", "version"),
+			&VoxelGeneratorMultipassCB::set_persistent_cache_version
+	);
+
+	ClassDB::bind_method(D_METHOD("save_persistent_cache"), &VoxelGeneratorMultipassCB::save_persistent_cache);
+
 	ClassDB::bind_method(
 			D_METHOD("debug_generate_test_column", "column_position_blocks"),
 			&VoxelGeneratorMultipassCB::debug_generate_test_column
@@ -658,6 +751,18 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			"get_pass_count"
 	);
 
+	ADD_PROPERTY(
+			PropertyInfo(Variant::STRING, "persistent_cache_directory", PROPERTY_HINT_DIR),
+			"set_persistent_cache_directory",
+			"get_persistent_cache_directory"
+	);
+
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "persistent_cache_version"),
+			"set_persistent_cache_version",
+			"get_persistent_cache_version"
+	);
+
 	BIND_CONSTANT(MAX_PASSES);
 	BIND_CONSTANT(MAX_PASS_EXTENT);
 }
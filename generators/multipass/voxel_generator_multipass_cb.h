@@ -84,6 +84,20 @@ public:
 	int get_pass_extent_blocks(int pass_index) const;
 	void set_pass_extent_blocks(int pass_index, int new_extent);
 
+	// Optional directory where partially generated columns are stored when they get unloaded, so they can resume
+	// generation later (including in a later session) instead of starting over.
+	String get_persistent_cache_directory() const;
+	void set_persistent_cache_directory(String directory);
+
+	// Part of the persistent cache key, to be changed when generation logic changes without changing other
+	// parameters (such as the script).
+	int get_persistent_cache_version() const;
+	void set_persistent_cache_version(int version);
+
+	// Writes columns that are currently loaded to the persistent cache, in a background I/O task. Columns are otherwise
+	// only written when they get unloaded. This is also done when the generator is destroyed or its parameters change.
+	void save_persistent_cache();
+
 	// Run the generator to get a particular column from scratch, using a single thread for better script debugging
 	// (since Godot 4 still doesn't support debugging scripts in different threads, at time of writing). This doesn't
 	// use the internal cache and can be extremely slow.
@@ -131,6 +145,7 @@ private:
 	void process_viewer_diff_internal(Box3i p_requested_box, Box3i p_prev_requested_box);
 	void re_initialize_column_refcounts();
 	void generate_block_fallback_script(VoxelQueryData &input);
+	static void update_persistent_cache(VoxelGeneratorMultipassCBStructs::Internal &internal);
 
 	// This must be called each time the structure of passes changes (number of passes, extents)
 	template <typename F>
@@ -144,6 +159,11 @@ private:
 
 		f(*new_internal);
 
+		update_persistent_cache(*new_internal);
+
+		// Columns of the old instance are not going to be unloaded normally
+		save_persistent_cache();
+
 		{
 			MutexLock mlock(_internal_mutex);
 			_internal = new_internal;
@@ -6,12 +6,15 @@
 #include "../../util/containers/span.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/string.h"
 #include "../../util/math/vector2i.h"
 #include "../../util/math/vector3i.h"
 #include "../../util/ref_count.h"
-#include "../../util/thread/mutex.h"
+#include "../../util/thread/rw_lock.h"
 #include "../../util/thread/spatial_lock_2d.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
 
 // Data structures used internally in multipass generation.
@@ -25,6 +28,9 @@ namespace zylann {
 class IThreadedTask;
 
 namespace voxel {
+
+class MultipassColumnCache;
+
 namespace VoxelGeneratorMultipassCBStructs {
 
 // Pass limit is pretty low because in practice not that many should be needed, and it gets expensive really quick
@@ -66,6 +72,15 @@ struct Block {
 	}
 };
 
+// Task waiting for a column to be processed by a given subpass.
+struct ColumnDependent {
+	// Only a non-scheduled, non-running task can be referenced here (same rules as `Block::final_pending_task`).
+	IThreadedTask *task = nullptr;
+	// Shared by all dependencies of the task. The task gets scheduled when it reaches zero.
+	std::shared_ptr<std::atomic_int> dependency_counter;
+	int8_t subpass_index = 0;
+};
+
 struct Column {
 	RefCount viewers;
 	// Index of the last subpass that was executed directly on this chunk.
@@ -77,6 +92,10 @@ struct Column {
 	// Each bit is set to 1 when a task is pending to process this block at a given subpass.
 	uint8_t pending_subpass_tasks_mask = 0;
 
+	// Tasks waiting for pending subpasses of this column to complete. They get scheduled when the pending task
+	// finishes or cancels, instead of polling the column repeatedly.
+	StdVector<ColumnDependent> dependents;
+
 	// Currently unused, because if chunks get removed from the cache or don't get saved for any reason,
 	// it can become out of sync and we wouldn't know. It would be a nice optimization tho...
 	//
@@ -97,8 +116,9 @@ struct Column {
 
 struct Map {
 	StdUnorderedMap<Vector2i, Column> columns;
-	// Protects the hashmap itself
-	Mutex mutex;
+	// Protects the hashmap itself. Tasks only look up columns, so they can do it concurrently. Columns are only
+	// inserted or removed when viewers change.
+	RWLock columns_lock;
 	// Protects columns
 	mutable SpatialLock2D spatial_lock;
 
@@ -138,11 +158,19 @@ struct Internal {
 	int column_base_y_blocks = -4;
 	int column_height_blocks = 8;
 
+	// Where to store columns in between sessions. Empty means disabled.
+	String persistent_cache_directory;
+	// Allows users to invalidate the persistent cache when they change their generation logic
+	int persistent_cache_version = 0;
+
 	// Set to `true` if the generator's configuration changed. Means a new instance of Internal has been made.
 	// Existing tasks may still finish their work using the old instance, but results will be thrown away. Such
 	// tasks can end faster if they check this boolean.
 	bool expired = false;
 
+	// Made from params. Null if disabled.
+	std::shared_ptr<MultipassColumnCache> persistent_cache;
+
 	Internal() {
 		// 1 pass minimum
 		passes.push_back(Pass());
@@ -152,6 +180,8 @@ struct Internal {
 		passes = other.passes;
 		column_base_y_blocks = other.column_base_y_blocks;
 		column_height_blocks = other.column_height_blocks;
+		persistent_cache_directory = other.persistent_cache_directory;
+		persistent_cache_version = other.persistent_cache_version;
 	}
 };
 
@@ -0,0 +1,318 @@
+#include "blocky_library_cache.h"
+#include "../../util/godot/classes/file_access.h"
+#include "../../util/hash_funcs.h"
+#include "../../util/io/log.h"
+#include "../../util/io/serialization.h"
+#include "../../util/profiling.h"
+#include "../../util/string/format.h"
+
+#include <cstring>
+
+namespace zylann::voxel::BlockyLibraryCache {
+
+namespace {
+
+const uint8_t FORMAT_VERSION = 1;
+const char *FILE_MAGIC = "VXBL";
+
+// Arrays are copied as raw memory, so data can only be read back by a build with the same layout
+uint64_t get_layout_hash() {
+	uint64_t h = hash_djb2_one_64(get_platform_endianness());
+	h = hash_djb2_one_64(sizeof(real_t), h);
+	h = hash_djb2_one_64(sizeof(AABB), h);
+	h = hash_djb2_one_64(sizeof(Vector3f), h);
+	h = hash_djb2_one_64(sizeof(Vector2f), h);
+	h = hash_djb2_one_64(sizeof(VoxelBlockyLibraryBase::SidePattern), h);
+	return h;
+}
+
+template <typename T>
+void store_array(MemoryWriter &w, const StdVector<T> &src) {
+	w.store_32(src.size());
+	w.store_buffer(Span<const uint8_t>(reinterpret_cast<const uint8_t *>(src.data()), src.size() * sizeof(T)));
+}
+
+// The reader doesn't check bounds, so reads are validated here
+inline bool can_read(const MemoryReader &r, size_t byte_count) {
+	return byte_count <= r.data.size() - r.pos;
+}
+
+template <typename T>
+bool read_array(MemoryReader &r, StdVector<T> &dst) {
+	if (!can_read(r, sizeof(uint32_t))) {
+		return false;
+	}
+	const size_t count = r.get_32();
+	if (!can_read(r, count * sizeof(T))) {
+		return false;
+	}
+	dst.resize(count);
+	memcpy(dst.data(), r.data.data() + r.pos, count * sizeof(T));
+	r.pos += count * sizeof(T);
+	return true;
+}
+
+// Fixed-size fields of a model, copied as a whole
+struct ModelHeader {
+	float color[4];
+	uint32_t box_collision_mask;
+	uint32_t side_pattern_indices[Cube::SIDE_COUNT];
+	uint8_t surface_count;
+	uint8_t empty_sides_mask;
+	uint8_t full_sides_mask;
+	uint8_t transparency_index;
+	uint8_t flags;
+};
+
+enum ModelFlags {
+	MODEL_FLAG_CULLS_NEIGHBORS = 1 << 0,
+	MODEL_FLAG_CONTRIBUTES_TO_AO = 1 << 1,
+	MODEL_FLAG_EMPTY = 1 << 2,
+	MODEL_FLAG_RANDOM_TICKABLE = 1 << 3,
+	MODEL_FLAG_TRANSPARENT = 1 << 4,
+	MODEL_FLAG_FULL_CUBE_COLLISION = 1 << 5
+};
+
+void serialize_model(MemoryWriter &w, const VoxelBlockyModel::BakedData &model_data) {
+	const VoxelBlockyModel::BakedData::Model &model = model_data.model;
+
+	ModelHeader header;
+	// Zero padding bytes too, so files are the same for the same data
+	memset(&header, 0, sizeof(header));
+	header.color[0] = model_data.color.r;
+	header.color[1] = model_data.color.g;
+	header.color[2] = model_data.color.b;
+	header.color[3] = model_data.color.a;
+	header.box_collision_mask = model_data.box_collision_mask;
+	for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+		header.side_pattern_indices[side] = model.side_pattern_indices[side];
+	}
+	header.surface_count = model.surface_count;
+	header.empty_sides_mask = model.empty_sides_mask;
+	header.full_sides_mask = model.full_sides_mask;
+	header.transparency_index = model_data.transparency_index;
+	header.flags = (model_data.culls_neighbors ? MODEL_FLAG_CULLS_NEIGHBORS : 0) //
+			| (model_data.contributes_to_ao ? MODEL_FLAG_CONTRIBUTES_TO_AO : 0) //
+			| (model_data.empty ? MODEL_FLAG_EMPTY : 0) //
+			| (model_data.is_random_tickable ? MODEL_FLAG_RANDOM_TICKABLE : 0) //
+			| (model_data.is_transparent ? MODEL_FLAG_TRANSPARENT : 0) //
+			| (model_data.box_collision_is_full_cube ? MODEL_FLAG_FULL_CUBE_COLLISION : 0);
+
+	w.store_buffer(Span<const uint8_t>(reinterpret_cast<const uint8_t *>(&header), sizeof(header)));
+	store_array(w, model_data.box_collision_aabbs);
+
+	for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+		const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+		w.store_8(surface.collision_enabled ? 1 : 0);
+		store_array(w, surface.positions);
+		store_array(w, surface.normals);
+		store_array(w, surface.uvs);
+		store_array(w, surface.indices);
+		store_array(w, surface.tangents);
+		for (const VoxelBlockyModel::BakedData::SideSurface &side_surface : surface.sides) {
+			store_array(w, side_surface.positions);
+			store_array(w, side_surface.uvs);
+			store_array(w, side_surface.indices);
+			store_array(w, side_surface.tangents);
+		}
+	}
+}
+
+bool deserialize_model(MemoryReader &r, VoxelBlockyModel::BakedData &model_data) {
+	VoxelBlockyModel::BakedData::Model &model = model_data.model;
+
+	ModelHeader header;
+	if (!can_read(r, sizeof(header))) {
+		return false;
+	}
+	memcpy(&header, r.data.data() + r.pos, sizeof(header));
+	r.pos += sizeof(header);
+
+	if (header.surface_count > VoxelBlockyModel::BakedData::Model::MAX_SURFACES) {
+		return false;
+	}
+
+	model_data.color = Color(header.color[0], header.color[1], header.color[2], header.color[3]);
+	model_data.box_collision_mask = header.box_collision_mask;
+	for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+		model.side_pattern_indices[side] = header.side_pattern_indices[side];
+	}
+	model.surface_count = header.surface_count;
+	model.empty_sides_mask = header.empty_sides_mask;
+	model.full_sides_mask = header.full_sides_mask;
+	model_data.transparency_index = header.transparency_index;
+	model_data.culls_neighbors = header.flags & MODEL_FLAG_CULLS_NEIGHBORS;
+	model_data.contributes_to_ao = header.flags & MODEL_FLAG_CONTRIBUTES_TO_AO;
+	model_data.empty = header.flags & MODEL_FLAG_EMPTY;
+	model_data.is_random_tickable = header.flags & MODEL_FLAG_RANDOM_TICKABLE;
+	model_data.is_transparent = header.flags & MODEL_FLAG_TRANSPARENT;
+	model_data.box_collision_is_full_cube = header.flags & MODEL_FLAG_FULL_CUBE_COLLISION;
+
+	if (!read_array(r, model_data.box_collision_aabbs)) {
+		return false;
+	}
+
+	model.clear();
+
+	for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+		VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+		if (!can_read(r, 1)) {
+			return false;
+		}
+		surface.collision_enabled = r.get_8() != 0;
+		// Assigned by the library after loading
+		surface.material_id = 0;
+		bool ok = read_array(r, surface.positions) //
+				&& read_array(r, surface.normals) //
+				&& read_array(r, surface.uvs) //
+				&& read_array(r, surface.indices) //
+				&& read_array(r, surface.tangents);
+		for (VoxelBlockyModel::BakedData::SideSurface &side_surface : surface.sides) {
+			ok = ok //
+					&& read_array(r, side_surface.positions) //
+					&& read_array(r, side_surface.uvs) //
+					&& read_array(r, side_surface.indices) //
+					&& read_array(r, side_surface.tangents);
+		}
+		if (!ok) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+void serialize(const VoxelBlockyLibraryBase::BakedData &baked_data, uint64_t content_hash, StdVector<uint8_t> &dst) {
+	ZN_PROFILE_SCOPE();
+	MemoryWriter w(dst, get_platform_endianness());
+
+	w.store_buffer(Span<const uint8_t>(reinterpret_cast<const uint8_t *>(FILE_MAGIC), 4));
+	w.store_8(FORMAT_VERSION);
+	w.store_64(get_layout_hash());
+	w.store_64(content_hash);
+
+	w.store_32(baked_data.side_pattern_count);
+	w.store_32(baked_data.side_pattern_culling.size());
+	Span<const uint64_t> culling_words = baked_data.side_pattern_culling.get_words();
+	w.store_buffer(Span<const uint8_t>(
+			reinterpret_cast<const uint8_t *>(culling_words.data()), culling_words.size() * sizeof(uint64_t)
+	));
+	store_array(w, baked_data.side_patterns);
+
+	w.store_32(baked_data.models.size());
+	for (const VoxelBlockyModel::BakedData &model_data : baked_data.models) {
+		serialize_model(w, model_data);
+	}
+}
+
+bool deserialize(Span<const uint8_t> src, uint64_t content_hash, VoxelBlockyLibraryBase::BakedData &out_baked_data) {
+	ZN_PROFILE_SCOPE();
+	MemoryReader r(src, get_platform_endianness());
+
+	// Magic, version, layout hash, content hash
+	if (!can_read(r, 4 + 1 + 8 + 8)) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	if (memcmp(src.data(), FILE_MAGIC, 4) != 0) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	r.pos += 4;
+
+	const uint8_t version = r.get_8();
+	if (version != FORMAT_VERSION) {
+		ZN_PRINT_VERBOSE(format("Ignoring blocky library cache with format version {}", int(version)));
+		return false;
+	}
+	if (r.get_64() != get_layout_hash()) {
+		ZN_PRINT_VERBOSE("Ignoring blocky library cache written by a different kind of build");
+		return false;
+	}
+	if (r.get_64() != content_hash) {
+		// The library changed since the cache was written
+		return false;
+	}
+
+	if (!can_read(r, 2 * sizeof(uint32_t))) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	out_baked_data.side_pattern_count = r.get_32();
+	const unsigned int culling_bit_count = r.get_32();
+	if (culling_bit_count != out_baked_data.side_pattern_count * out_baked_data.side_pattern_count) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	out_baked_data.side_pattern_culling.resize_no_init(culling_bit_count);
+	Span<uint64_t> culling_words = out_baked_data.side_pattern_culling.get_words();
+	if (!can_read(r, culling_words.size() * sizeof(uint64_t))) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	memcpy(culling_words.data(), src.data() + r.pos, culling_words.size() * sizeof(uint64_t));
+	r.pos += culling_words.size() * sizeof(uint64_t);
+
+	if (!read_array(r, out_baked_data.side_patterns) ||
+		out_baked_data.side_patterns.size() != out_baked_data.side_pattern_count) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+
+	if (!can_read(r, sizeof(uint32_t))) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	const unsigned int model_count = r.get_32();
+	if (model_count > VoxelBlockyLibraryBase::MAX_MODELS) {
+		ZN_PRINT_ERROR("Invalid blocky library cache");
+		return false;
+	}
+	out_baked_data.models.resize(model_count);
+	for (VoxelBlockyModel::BakedData &model_data : out_baked_data.models) {
+		if (!deserialize_model(r, model_data)) {
+			ZN_PRINT_ERROR("Invalid blocky library cache");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool save(const String &fpath, const VoxelBlockyLibraryBase::BakedData &baked_data, uint64_t content_hash) {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<uint8_t> data;
+	serialize(baked_data, content_hash, data);
+
+	Error err;
+	Ref<FileAccess> f = zylann::godot::open_file(fpath, FileAccess::WRITE, err);
+	ERR_FAIL_COND_V_MSG(f.is_null(), false, String("Could not save blocky library cache {0}").format(varray(fpath)));
+	zylann::godot::store_buffer(**f, to_span(data));
+	return true;
+}
+
+bool load(const String &fpath, uint64_t content_hash, VoxelBlockyLibraryBase::BakedData &out_baked_data) {
+	ZN_PROFILE_SCOPE();
+
+	Error err;
+	Ref<FileAccess> f = zylann::godot::open_file(fpath, FileAccess::READ, err);
+	if (f.is_null()) {
+		// Not in the cache
+		return false;
+	}
+
+	// Read everything at once, the file is parsed from memory
+	StdVector<uint8_t> data;
+	data.resize(f->get_length());
+	if (zylann::godot::get_buffer(**f, to_span(data)) != data.size()) {
+		ZN_PRINT_ERROR(format("Could not read blocky library cache {}", zylann::godot::to_std_string(fpath)));
+		return false;
+	}
+
+	return deserialize(to_span_const(data), content_hash, out_baked_data);
+}
+
+} // namespace zylann::voxel::BlockyLibraryCache
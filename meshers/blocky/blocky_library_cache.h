@@ -0,0 +1,29 @@
+#ifndef VOXEL_BLOCKY_LIBRARY_CACHE_H
+#define VOXEL_BLOCKY_LIBRARY_CACHE_H
+
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/string.h"
+#include "voxel_blocky_library_base.h"
+
+namespace zylann::voxel {
+
+// Binary snapshot of baked library data, so libraries with many models don't have to be baked again every time a
+// project starts. Arrays are stored as raw memory, so the format only works on the same kind of machine and build that
+// wrote it. It is meant to be a local cache, not to be shipped with a game.
+// Material indices are not stored, they have to be assigned again after loading, because materials are resources that
+// can't be identified across runs.
+namespace BlockyLibraryCache {
+
+// `content_hash` identifies the configuration the data was baked from. Loading only succeeds if it matches.
+void serialize(const VoxelBlockyLibraryBase::BakedData &baked_data, uint64_t content_hash, StdVector<uint8_t> &dst);
+bool deserialize(Span<const uint8_t> src, uint64_t content_hash, VoxelBlockyLibraryBase::BakedData &out_baked_data);
+
+bool save(const String &fpath, const VoxelBlockyLibraryBase::BakedData &baked_data, uint64_t content_hash);
+// Returns `false` if the file doesn't exist, is invalid, or was baked from a different configuration.
+bool load(const String &fpath, uint64_t content_hash, VoxelBlockyLibraryBase::BakedData &out_baked_data);
+
+} // namespace BlockyLibraryCache
+} // namespace zylann::voxel
+
+#endif // VOXEL_BLOCKY_LIBRARY_CACHE_H
@@ -2,6 +2,7 @@
 #include "../../../constants/voxel_string_names.h"
 #include "../../../util/containers/container_funcs.h"
 #include "../../../util/godot/core/array.h"
+#include "../../../util/hash_funcs.h"
 #include "../../../util/io/log.h"
 #include "../../../util/math/funcs.h"
 #include "../../../util/math/ortho_basis.h"
@@ -53,6 +54,25 @@ bool VoxelBlockyAttribute::is_value_used(int v) const {
 	return false;
 }
 
+uint64_t VoxelBlockyAttribute::get_bake_hash() const {
+	uint64_t h = hash_djb2_one_64(String(get_attribute_name()).hash());
+	h = hash_djb2_one_64(_default_value, h);
+	h = hash_djb2_one_64(_is_rotation, h);
+	h = hash_djb2_one_64(_value_names.size(), h);
+	for (const StringName &value_name : _value_names) {
+		h = hash_djb2_one_64(String(value_name).hash(), h);
+	}
+	h = hash_djb2_one_64(_ortho_rotations.size(), h);
+	for (const uint8_t rotation : _ortho_rotations) {
+		h = hash_djb2_one_64(rotation, h);
+	}
+	h = hash_djb2_one_64(_used_values.size(), h);
+	for (const uint8_t value : _used_values) {
+		h = hash_djb2_one_64(value, h);
+	}
+	return h;
+}
+
 bool VoxelBlockyAttribute::is_equivalent(const VoxelBlockyAttribute &other) const {
 	if (_name != other._name) {
 		return false;
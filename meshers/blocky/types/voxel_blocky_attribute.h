@@ -39,6 +39,9 @@ public:
 
 	bool is_equivalent(const VoxelBlockyAttribute &other) const;
 
+	// Hash of the properties baking depends on
+	uint64_t get_bake_hash() const;
+
 #ifdef TOOLS_ENABLED
 	virtual void get_configuration_warnings(PackedStringArray &out_warnings) const;
 #endif
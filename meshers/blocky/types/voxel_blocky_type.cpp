@@ -10,6 +10,7 @@
 // For `MAKE_RESOURCE_TYPE_HINT`
 #include "../../../util/godot/classes/object.h"
 #endif
+#include "../../../util/hash_funcs.h"
 #include "../../../util/math/ortho_basis.h"
 #include "../../../util/profiling.h"
 #include "../../../util/string/format.h"
@@ -314,6 +315,39 @@ math::OrthoBasis get_baking_rotation_ortho_basis(
 
 } // namespace
 
+namespace {
+
+uint64_t hash_model(const VoxelBlockyModel *model, uint64_t h) {
+	if (model == nullptr) {
+		return hash_djb2_one_64(0, h);
+	}
+	h = hash_djb2_one_64(model->get_bake_hash(), h);
+	// Materials are indexed while baking types, so they are part of the result
+	for (unsigned int surface_index = 0; surface_index < model->get_surface_count(); ++surface_index) {
+		const Ref<Material> material = model->get_surface_baked_material(surface_index);
+		h = hash_djb2_one_64(material.is_valid() ? uint64_t(material->get_instance_id()) : 0, h);
+	}
+	return h;
+}
+
+} // namespace
+
+uint64_t VoxelBlockyType::get_bake_hash() const {
+	uint64_t h = hash_djb2_one_64(String(_name).hash());
+	h = hash_djb2_one_64(_automatic_rotations, h);
+	h = hash_model(_base_model.ptr(), h);
+	h = hash_djb2_one_64(_attributes.size(), h);
+	for (const Ref<VoxelBlockyAttribute> &attribute : _attributes) {
+		h = hash_djb2_one_64(attribute.is_valid() ? attribute->get_bake_hash() : 0, h);
+	}
+	h = hash_djb2_one_64(_variants.size(), h);
+	for (const VariantData &vd : _variants) {
+		h = hash_djb2_one_64(vd.key.to_string().hash(), h);
+		h = hash_model(vd.model.ptr(), h);
+	}
+	return h;
+}
+
 void VoxelBlockyType::bake(
 		StdVector<VoxelBlockyModel::BakedData> &out_models,
 		StdVector<VariantKey> &out_keys,
@@ -66,6 +66,10 @@ public:
 			VoxelBlockyModel::MaterialIndexer &material_indexer, const VariantKey *specific_key,
 			bool bake_tangents) const;
 
+	// Hash of everything `bake` depends on, including materials of models. Types with the same hash produce the same
+	// baked models.
+	uint64_t get_bake_hash() const;
+
 #ifdef TOOLS_ENABLED
 	void get_configuration_warnings(PackedStringArray &out_warnings) const;
 #endif
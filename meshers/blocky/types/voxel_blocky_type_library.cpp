@@ -7,6 +7,7 @@
 #include "../../../util/godot/core/array.h"
 #include "../../../util/godot/core/string.h"
 #include "../../../util/godot/core/typed_array.h"
+#include "../../../util/hash_funcs.h"
 #include "../../../util/profiling.h"
 #include "../../../util/string/format.h"
 #include "../voxel_blocky_model_cube.h"
@@ -38,11 +39,36 @@ void VoxelBlockyTypeLibrary::load_default() {
 	_needs_baking = true;
 }
 
+uint64_t VoxelBlockyTypeLibrary::get_content_hash() const {
+	uint64_t h = hash_djb2_one_64(get_bake_tangents());
+	h = hash_djb2_one_64(_types.size(), h);
+	for (const Ref<VoxelBlockyType> &type : _types) {
+		h = hash_djb2_one_64(type.is_valid() ? type->get_bake_hash() : 0, h);
+	}
+	// Model indices depend on the ID map
+	h = hash_djb2_one_64(_id_map.size(), h);
+	for (const VoxelID &id : _id_map) {
+		h = hash_djb2_one_64(String(id.type_name).hash(), h);
+		h = hash_djb2_one_64(id.variant_key.to_string().hash(), h);
+	}
+	return h;
+}
+
 void VoxelBlockyTypeLibrary::bake() {
 	ZN_PROFILE_SCOPE();
 
 	RWLockWrite lock(_baked_data_rw_lock);
 
+	// Types produce many models each and index materials while baking, so unlike VoxelBlockyLibrary, they are not
+	// rebaked individually. But when nothing changed since the last bake (for example after editing properties that
+	// don't affect models), the whole bake can be skipped.
+	// TODO Rebake only types that changed, and support a bake cache file like VoxelBlockyLibrary
+	const uint64_t content_hash = get_content_hash();
+	if (_has_baked && content_hash == _baked_content_hash) {
+		ZN_PRINT_VERBOSE("VoxelBlockyTypeLibrary didn't change since last bake, skipped");
+		return;
+	}
+
 	const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
 
 	// This is the only place we modify the data.
@@ -103,6 +129,11 @@ void VoxelBlockyTypeLibrary::bake() {
 	_baked_data.indexed_materials_count = _indexed_materials.size();
 
 	generate_side_culling_matrix(_baked_data);
+	build_flat_baked_data(_baked_data);
+
+	// Baking can add entries to the ID map
+	_baked_content_hash = get_content_hash();
+	_has_baked = true;
 
 	const uint64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
 	ZN_PRINT_VERBOSE(
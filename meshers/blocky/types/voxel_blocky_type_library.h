@@ -78,6 +78,7 @@ private:
 	};
 
 	void update_id_map();
+	uint64_t get_content_hash() const;
 	void update_id_map(StdVector<VoxelID> &id_map, StdVector<uint16_t> *used_ids) const;
 	static PackedStringArray serialize_id_map_to_string_array(const StdVector<VoxelID> &id_map);
 
@@ -102,6 +103,10 @@ private:
 	// Can refer to types that no longer exist.
 	// Indices and size match `_baked_data.models`.
 	StdVector<VoxelID> _id_map;
+
+	// Hash of types, ID map and settings as they were after the last bake, so baking can be skipped if nothing changed
+	uint64_t _baked_content_hash = 0;
+	bool _has_baked = false;
 };
 
 } // namespace zylann::voxel
@@ -7,10 +7,12 @@
 #include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/godot/core/string.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/io/log.h"
 #include "../../util/math/conv.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
+#include "blocky_library_cache.h"
 #include "voxel_blocky_model_cube.h"
 #include "voxel_blocky_model_empty.h"
 #include "voxel_blocky_model_mesh.h"
@@ -44,6 +46,19 @@ void VoxelBlockyLibrary::load_default() {
 	_needs_baking = true;
 }
 
+namespace {
+
+uint64_t get_content_hash(Span<const uint64_t> model_hashes, bool bake_tangents) {
+	uint64_t h = hash_djb2_one_64(bake_tangents);
+	h = hash_djb2_one_64(model_hashes.size(), h);
+	for (const uint64_t model_hash : model_hashes) {
+		h = hash_djb2_one_64(model_hash, h);
+	}
+	return h;
+}
+
+} // namespace
+
 void VoxelBlockyLibrary::bake() {
 	ZN_PROFILE_SCOPE();
 
@@ -53,27 +68,101 @@ void VoxelBlockyLibrary::bake() {
 
 	// This is the only place we modify the data.
 
+	// Models are identified by a hash of their properties, so those that didn't change since the last bake can be kept
+	StdVector<uint64_t> model_hashes;
+	model_hashes.resize(_voxel_models.size());
+	for (size_t i = 0; i < _voxel_models.size(); ++i) {
+		const Ref<VoxelBlockyModel> &config = _voxel_models[i];
+		model_hashes[i] = config.is_valid() ? config->get_bake_hash() : 0;
+	}
+	const uint64_t content_hash = get_content_hash(to_span(model_hashes), _bake_tangents);
+
+	if (content_hash != _baked_content_hash) {
+		_bake_cache_up_to_date = false;
+	}
+
+	bool loaded_from_cache = false;
+	if (!_bake_cache_path.is_empty() && !_bake_cache_up_to_date) {
+		// Loaded separately, because baked data must remain intact if loading fails
+		BakedData cached_data;
+		if (BlockyLibraryCache::load(_bake_cache_path, content_hash, cached_data)) {
+			_baked_data.models = std::move(cached_data.models);
+			_baked_data.side_pattern_culling = std::move(cached_data.side_pattern_culling);
+			_baked_data.side_pattern_count = cached_data.side_pattern_count;
+			_baked_data.side_patterns = std::move(cached_data.side_patterns);
+			loaded_from_cache = true;
+			_bake_cache_up_to_date = true;
+		}
+	}
+
+	unsigned int baked_model_count = 0;
+
+	if (!loaded_from_cache) {
+		const bool tangents_changed = _bake_tangents != _baked_with_tangents;
+
+		DynamicBitset changed_models;
+		changed_models.resize_no_init(_voxel_models.size());
+
+		// Materials are indexed afterwards for all models, so those indexed here are thrown away
+		StdVector<Ref<Material>> scratch_materials;
+
+		_baked_data.models.resize(_voxel_models.size());
+		for (size_t i = 0; i < _voxel_models.size(); ++i) {
+			const bool changed =
+					tangents_changed || i >= _baked_model_hashes.size() || _baked_model_hashes[i] != model_hashes[i];
+			changed_models.set(i, changed);
+			if (!changed) {
+				continue;
+			}
+			Ref<VoxelBlockyModel> config = _voxel_models[i];
+			if (config.is_valid()) {
+				scratch_materials.clear();
+				VoxelBlockyModel::MaterialIndexer scratch_indexer{ scratch_materials };
+				config->bake(_baked_data.models[i], _bake_tangents, scratch_indexer);
+			} else {
+				_baked_data.models[i].clear();
+			}
+			++baked_model_count;
+		}
+
+		generate_side_culling_matrix(_baked_data, &changed_models);
+	}
+
+	// Materials are resources, so they are indexed every time. This is cheap compared to baking geometry.
 	_indexed_materials.clear();
 	VoxelBlockyModel::MaterialIndexer materials{ _indexed_materials };
-
-	_baked_data.models.resize(_voxel_models.size());
 	for (size_t i = 0; i < _voxel_models.size(); ++i) {
-		Ref<VoxelBlockyModel> config = _voxel_models[i];
-		if (config.is_valid()) {
-			config->bake(_baked_data.models[i], _bake_tangents, materials);
-		} else {
-			_baked_data.models[i].clear();
+		const Ref<VoxelBlockyModel> &config = _voxel_models[i];
+		if (config.is_null()) {
+			continue;
+		}
+		VoxelBlockyModel::BakedData::Model &model = _baked_data.models[i].model;
+		for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+			// Note, an empty material counts as "The default material".
+			model.surfaces[surface_index].material_id =
+					materials.get_or_create_index(config->get_surface_baked_material(surface_index));
 		}
 	}
 
 	_baked_data.indexed_materials_count = _indexed_materials.size();
+	build_flat_baked_data(_baked_data);
+
+	if (!_bake_cache_path.is_empty() && !_bake_cache_up_to_date) {
+		_bake_cache_up_to_date = BlockyLibraryCache::save(_bake_cache_path, _baked_data, content_hash);
+	}
 
-	generate_side_culling_matrix(_baked_data);
+	_baked_model_hashes = std::move(model_hashes);
+	_baked_content_hash = content_hash;
+	_baked_with_tangents = _bake_tangents;
 
 	uint64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
-	ZN_PRINT_VERBOSE(
-			format("Took {} us to bake VoxelLibrary, indexed {} materials", time_spent, _indexed_materials.size())
-	);
+	ZN_PRINT_VERBOSE(format(
+			"Took {} us to bake VoxelLibrary, baked {} models{}, indexed {} materials",
+			time_spent,
+			baked_model_count,
+			loaded_from_cache ? " (loaded from cache)" : "",
+			_indexed_materials.size()
+	));
 
 	_needs_baking = false;
 }
@@ -96,6 +185,17 @@ int VoxelBlockyLibrary::add_model(Ref<VoxelBlockyModel> model) {
 	return index;
 }
 
+void VoxelBlockyLibrary::set_bake_cache_path(String path) {
+	if (path != _bake_cache_path) {
+		_bake_cache_up_to_date = false;
+	}
+	_bake_cache_path = path;
+}
+
+String VoxelBlockyLibrary::get_bake_cache_path() const {
+	return _bake_cache_path;
+}
+
 // unsigned int VoxelBlockyLibrary::get_model_count() const {
 // 	return _voxel_models.size();
 // }
@@ -240,6 +340,9 @@ void VoxelBlockyLibrary::_bind_methods() {
 			&VoxelBlockyLibrary::get_model_index_from_resource_name
 	);
 
+	ClassDB::bind_method(D_METHOD("set_bake_cache_path", "path"), &VoxelBlockyLibrary::set_bake_cache_path);
+	ClassDB::bind_method(D_METHOD("get_bake_cache_path"), &VoxelBlockyLibrary::get_bake_cache_path);
+
 	ADD_PROPERTY(
 			PropertyInfo(
 					Variant::ARRAY,
@@ -250,6 +353,11 @@ void VoxelBlockyLibrary::_bind_methods() {
 			"set_models",
 			"get_models"
 	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::STRING, "bake_cache_path", PROPERTY_HINT_SAVE_FILE),
+			"set_bake_cache_path",
+			"get_bake_cache_path"
+	);
 }
 
 } // namespace zylann::voxel
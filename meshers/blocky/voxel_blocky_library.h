@@ -29,6 +29,9 @@ public:
 	// Convenience method that returns the index of the added model
 	int add_model(Ref<VoxelBlockyModel> model);
 
+	void set_bake_cache_path(String path);
+	String get_bake_cache_path() const;
+
 	//-------------------------
 	// Internal use
 
@@ -61,6 +64,16 @@ private:
 private:
 	// Indices matter, they correspond to voxel data
 	StdVector<Ref<VoxelBlockyModel>> _voxel_models;
+
+	// Optional file where baked data is saved, so it can be loaded instead of baking again next time
+	String _bake_cache_path;
+	// True if the cache file contains the same data as the last bake
+	bool _bake_cache_up_to_date = false;
+
+	// State of the last bake, so models that didn't change can be skipped when baking again
+	StdVector<uint64_t> _baked_model_hashes;
+	uint64_t _baked_content_hash = 0;
+	bool _baked_with_tangents = false;
 };
 
 } // namespace zylann::voxel
@@ -101,7 +101,7 @@ void rasterize_triangle_barycentric(Vector2f a, Vector2f b, Vector2f c, F output
 }
 
 namespace {
-static const unsigned int RASTER_SIZE = 32;
+static const unsigned int RASTER_SIZE = VoxelBlockyLibraryBase::SIDE_PATTERN_RESOLUTION;
 } // namespace
 
 void rasterize_side( //
@@ -174,7 +174,7 @@ void rasterize_side_all_surfaces( //
 	}
 }
 
-void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data) {
+void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data, const DynamicBitset *changed_models) {
 	ZN_PROFILE_SCOPE();
 	// When two blocky voxels are next to each other, they share a side.
 	// Geometry of either side can be culled away if covered by the other,
@@ -197,15 +197,31 @@ void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data)
 	StdVector<Pattern> patterns;
 	uint32_t full_side_pattern_index = VoxelBlockyLibraryBase::NULL_INDEX;
 
+	// Patterns of the previous bake, referenced by models that didn't change
+	StdVector<VoxelBlockyLibraryBase::SidePattern> previous_patterns = std::move(baked_data.side_patterns);
+	baked_data.side_patterns.clear();
+	if (changed_models != nullptr) {
+		ZN_ASSERT_RETURN(changed_models->size() == baked_data.models.size());
+	}
+
 	// Gather patterns for each model
-	for (uint16_t type_id = 0; type_id < baked_data.models.size(); ++type_id) {
+	for (unsigned int type_id = 0; type_id < baked_data.models.size(); ++type_id) {
 		VoxelBlockyModel::BakedData &model_data = baked_data.models[type_id];
 		model_data.contributes_to_ao = true;
+		// Recomputed entirely here, because models may have been kept from a previous bake
+		model_data.model.full_sides_mask = 0;
+
+		const bool rasterize = changed_models == nullptr || changed_models->get(type_id);
 
 		// For each side
 		for (uint16_t side = 0; side < Cube::SIDE_COUNT; ++side) {
 			std::bitset<RASTER_SIZE * RASTER_SIZE> bitmap;
-			rasterize_side_all_surfaces(model_data, side, bitmap);
+			const uint32_t previous_pattern_index = model_data.model.side_pattern_indices[side];
+			if (rasterize || previous_pattern_index >= previous_patterns.size()) {
+				rasterize_side_all_surfaces(model_data, side, bitmap);
+			} else {
+				bitmap = previous_patterns[previous_pattern_index];
+			}
 
 			{
 				std::bitset<RASTER_SIZE * RASTER_SIZE> full_bitmap;
@@ -255,6 +271,10 @@ void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data)
 	// Find which pattern occludes which
 
 	baked_data.side_pattern_count = patterns.size();
+	baked_data.side_patterns.resize(patterns.size());
+	for (unsigned int i = 0; i < patterns.size(); ++i) {
+		baked_data.side_patterns[i] = patterns[i].bitmap;
+	}
 	baked_data.side_pattern_culling.resize_no_init(baked_data.side_pattern_count * baked_data.side_pattern_count);
 	baked_data.side_pattern_culling.fill(false);
 
@@ -337,4 +357,97 @@ void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data)
 	print_line("");*/
 }
 
+void build_flat_baked_data(VoxelBlockyLibraryBase::BakedData &baked_data) {
+	ZN_PROFILE_SCOPE();
+	typedef VoxelBlockyLibraryBase::FlatBakedData FlatBakedData;
+	FlatBakedData &flat = baked_data.flat;
+	const unsigned int model_count = baked_data.models.size();
+
+	flat.models.resize(model_count);
+	flat.side_pattern_indices.resize(model_count * Cube::SIDE_COUNT);
+	flat.side_surfaces.clear();
+	flat.side_surfaces.resize(model_count * Cube::SIDE_COUNT * FlatBakedData::MAX_SURFACES);
+	flat.positions.clear();
+	flat.uvs.clear();
+	flat.tangents.clear();
+	flat.indices.clear();
+
+	// Count first so the pool is allocated once
+	unsigned int vertex_count = 0;
+	unsigned int index_count = 0;
+	bool has_tangents = false;
+	for (const VoxelBlockyModel::BakedData &model_data : baked_data.models) {
+		const VoxelBlockyModel::BakedData::Model &model = model_data.model;
+		for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+			for (const VoxelBlockyModel::BakedData::SideSurface &side_surface : model.surfaces[surface_index].sides) {
+				vertex_count += side_surface.positions.size();
+				index_count += side_surface.indices.size();
+				has_tangents |= side_surface.tangents.size() > 0;
+			}
+		}
+	}
+	flat.positions.reserve(vertex_count);
+	flat.uvs.reserve(vertex_count);
+	if (has_tangents) {
+		flat.tangents.reserve(vertex_count * 4);
+	}
+	flat.indices.reserve(index_count);
+
+	for (unsigned int model_index = 0; model_index < model_count; ++model_index) {
+		const VoxelBlockyModel::BakedData &model_data = baked_data.models[model_index];
+		const VoxelBlockyModel::BakedData::Model &model = model_data.model;
+
+		FlatBakedData::Model &flat_model = flat.models[model_index];
+		flat_model.color = model_data.color;
+		flat_model.empty_sides_mask = model.empty_sides_mask;
+		flat_model.transparency_index = model_data.transparency_index;
+		flat_model.surface_count = model.surface_count;
+		flat_model.culls_neighbors = model_data.culls_neighbors && !model_data.empty;
+		flat_model.contributes_to_ao = model_data.contributes_to_ao;
+		flat_model.has_inside_geometry = false;
+
+		for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+			if (model.surfaces[surface_index].positions.size() > 0) {
+				flat_model.has_inside_geometry = true;
+			}
+		}
+
+		for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+			const unsigned int side_index = flat.get_side_index(model_index, side);
+			flat.side_pattern_indices[side_index] = model.side_pattern_indices[side];
+
+			for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+				const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+				const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
+
+				FlatBakedData::SideSurface &flat_side_surface =
+						flat.side_surfaces[side_index * FlatBakedData::MAX_SURFACES + surface_index];
+				flat_side_surface.vertex_begin = flat.positions.size();
+				flat_side_surface.index_begin = flat.indices.size();
+				flat_side_surface.vertex_count = side_surface.positions.size();
+				flat_side_surface.index_count = side_surface.indices.size();
+				flat_side_surface.material_id = surface.material_id;
+				flat_side_surface.collision_enabled = surface.collision_enabled;
+				flat_side_surface.has_tangents = side_surface.tangents.size() > 0;
+
+				flat.positions.insert(
+						flat.positions.end(), side_surface.positions.begin(), side_surface.positions.end()
+				);
+				flat.uvs.insert(flat.uvs.end(), side_surface.uvs.begin(), side_surface.uvs.end());
+				flat.indices.insert(flat.indices.end(), side_surface.indices.begin(), side_surface.indices.end());
+				if (has_tangents) {
+					// Keep tangents aligned with vertices, sides without tangents are padded
+					if (flat_side_surface.has_tangents) {
+						flat.tangents.insert(
+								flat.tangents.end(), side_surface.tangents.begin(), side_surface.tangents.end()
+						);
+					} else {
+						flat.tangents.resize(flat.tangents.size() + side_surface.positions.size() * 4, 0.f);
+					}
+				}
+			}
+		}
+	}
+}
+
 } // namespace zylann::voxel
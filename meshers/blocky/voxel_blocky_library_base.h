@@ -6,6 +6,7 @@
 #include "../../util/godot/classes/resource.h"
 #include "../../util/thread/rw_lock.h"
 #include "voxel_blocky_model.h"
+#include <bitset>
 
 namespace zylann::voxel {
 
@@ -29,11 +30,73 @@ public:
 
 	static constexpr uint32_t NULL_INDEX = 0xFFFFFFFF;
 
+	// Sides of models are rasterized at this resolution to find which ones occlude others
+	static constexpr unsigned int SIDE_PATTERN_RESOLUTION = 32;
+	typedef std::bitset<SIDE_PATTERN_RESOLUTION * SIDE_PATTERN_RESOLUTION> SidePattern;
+
+	// Copy of baked models laid out for the mesher's hot loop. Properties and side geometry of all models are packed in
+	// a few contiguous arrays, instead of being spread in vectors owned by each model, so meshing a voxel side doesn't
+	// chase pointers. Inside geometry is not part of it, it is read from models when `has_inside_geometry` is true.
+	struct FlatBakedData {
+		static constexpr unsigned int MAX_SURFACES = VoxelBlockyModel::BakedData::Model::MAX_SURFACES;
+
+		struct Model {
+			Color color;
+			uint8_t empty_sides_mask = 0xff;
+			uint8_t transparency_index = 0;
+			uint8_t surface_count = 0;
+			// False if the model is empty, so neighbors never have to check it
+			bool culls_neighbors = false;
+			bool contributes_to_ao = false;
+			bool has_inside_geometry = false;
+		};
+
+		// Range of the vertex pool used by one surface of one model side
+		struct SideSurface {
+			uint32_t vertex_begin = 0;
+			uint32_t index_begin = 0;
+			uint32_t vertex_count = 0;
+			uint32_t index_count = 0;
+			uint32_t material_id = 0;
+			bool collision_enabled = false;
+			bool has_tangents = false;
+		};
+
+		StdVector<Model> models;
+		// Indexed with `model_index * Cube::SIDE_COUNT + side`
+		StdVector<uint32_t> side_pattern_indices;
+		// Indexed with `(model_index * Cube::SIDE_COUNT + side) * MAX_SURFACES + surface_index`
+		StdVector<SideSurface> side_surfaces;
+
+		// Vertex pool
+		StdVector<Vector3f> positions;
+		StdVector<Vector2f> uvs;
+		// 4 per vertex, only allocated if at least one side has tangents
+		StdVector<float> tangents;
+		// Relative to the first vertex of their side surface
+		StdVector<int32_t> indices;
+
+		inline unsigned int get_side_index(uint32_t model_index, unsigned int side) const {
+			return model_index * Cube::SIDE_COUNT + side;
+		}
+
+		inline const SideSurface &get_side_surface(
+				uint32_t model_index,
+				unsigned int side,
+				unsigned int surface_index
+		) const {
+			return side_surfaces[get_side_index(model_index, side) * MAX_SURFACES + surface_index];
+		}
+	};
+
 	struct BakedData {
 		// 2D array: { X : pattern A, Y : pattern B } => Does A occlude B
 		// Where index is X + Y * pattern count
 		DynamicBitset side_pattern_culling;
 		unsigned int side_pattern_count = 0;
+		// Shape of each pattern. Not used by the mesher, only kept so models that didn't change don't have to be
+		// rasterized again when baking.
+		StdVector<SidePattern> side_patterns;
 		// Lots of data can get moved but it's only on load.
 		StdVector<VoxelBlockyModel::BakedData> models;
 
@@ -46,6 +109,9 @@ public:
 
 		unsigned int indexed_materials_count = 0;
 
+		// Built from `models` at the end of baking, after materials are indexed
+		FlatBakedData flat;
+
 		inline bool has_model(uint32_t i) const {
 			return i < models.size();
 		}
@@ -109,7 +175,16 @@ protected:
 	StdVector<Ref<Material>> _indexed_materials;
 };
 
-void generate_side_culling_matrix(VoxelBlockyLibraryBase::BakedData &baked_data);
+// Fills `baked_data.flat` from baked models. Must be called after side patterns and material indices are assigned.
+void build_flat_baked_data(VoxelBlockyLibraryBase::BakedData &baked_data);
+
+// Finds side patterns of all models and which patterns occlude others.
+// If `changed_models` is provided, only models flagged in it are rasterized. Others must be unchanged since the
+// previous call, so their patterns are taken from those stored in `baked_data`.
+void generate_side_culling_matrix(
+		VoxelBlockyLibraryBase::BakedData &baked_data,
+		const DynamicBitset *changed_models = nullptr
+);
 
 } // namespace zylann::voxel
 
@@ -5,6 +5,7 @@
 #include "../../util/godot/classes/shader_material.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/godot/core/string.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/math/conv.h"
 #include "../../util/string/format.h"
 #include "voxel_blocky_library.h"
@@ -241,6 +242,8 @@ void VoxelBlockyModel::bake(BakedData &baked_data, bool bake_tangents, MaterialI
 	baked_data.is_random_tickable = _random_tickable;
 	baked_data.box_collision_mask = _collision_mask;
 	baked_data.box_collision_aabbs = _collision_aabbs;
+	baked_data.box_collision_is_full_cube =
+			_collision_aabbs.size() == 1 && _collision_aabbs[0] == AABB(Vector3(0, 0, 0), Vector3(1, 1, 1));
 
 	BakedData::Model &model = baked_data.model;
 
@@ -276,6 +279,39 @@ void VoxelBlockyModel::bake(BakedData &baked_data, bool bake_tangents, MaterialI
 	}
 }
 
+uint64_t VoxelBlockyModel::get_bake_hash() const {
+	uint64_t h = hash_djb2_one_64(get_class().hash());
+	h = hash_djb2_one_64(_transparency_index, h);
+	h = hash_djb2_one_64(_culls_neighbors, h);
+	h = hash_djb2_one_64(_random_tickable, h);
+	h = hash_djb2_one_64(_mesh_ortho_rotation, h);
+	h = hash_djb2_one_64(_collision_mask, h);
+	h = hash_djb2_one_float(_color.r, h);
+	h = hash_djb2_one_float(_color.g, h);
+	h = hash_djb2_one_float(_color.b, h);
+	h = hash_djb2_one_float(_color.a, h);
+	h = hash_djb2_one_64(_collision_aabbs.size(), h);
+	for (const AABB &aabb : _collision_aabbs) {
+		for (unsigned int i = 0; i < 3; ++i) {
+			h = hash_djb2_one_float(aabb.position[i], h);
+			h = hash_djb2_one_float(aabb.size[i], h);
+		}
+	}
+	h = hash_djb2_one_64(_surface_count, h);
+	for (const SurfaceParams &surface_params : _surface_params) {
+		h = hash_djb2_one_64(surface_params.collision_enabled, h);
+	}
+	return h;
+}
+
+Ref<Material> VoxelBlockyModel::get_surface_baked_material(unsigned int surface_index) const {
+	// Same logic as `bake`
+	if (surface_index < _surface_count && surface_index < _surface_params.size()) {
+		return _surface_params[surface_index].material_override;
+	}
+	return Ref<Material>();
+}
+
 TypedArray<AABB> VoxelBlockyModel::_b_get_collision_aabbs() const {
 	TypedArray<AABB> array;
 	array.resize(_collision_aabbs.size());
@@ -113,6 +113,8 @@ public:
 
 		uint32_t box_collision_mask;
 		StdVector<AABB> box_collision_aabbs;
+		// True if collision boxes are exactly one unit cube, which allows faster collision checks
+		bool box_collision_is_full_cube;
 
 		inline void clear() {
 			model.clear();
@@ -184,6 +186,17 @@ public:
 
 	virtual void bake(BakedData &baked_data, bool bake_tangents, MaterialIndexer &materials) const;
 
+	// Hash of the properties `bake` depends on, excluding materials. Models with the same hash produce the same baked
+	// data, apart from material indices. It is stable across runs, so it can be used to identify cached data.
+	virtual uint64_t get_bake_hash() const;
+
+	// Material that baked data of the given surface will use, after overrides are applied.
+	virtual Ref<Material> get_surface_baked_material(unsigned int surface_index) const;
+
+	unsigned int get_surface_count() const {
+		return _surface_count;
+	}
+
 	Span<const AABB> get_collision_aabbs() const {
 		return to_span(_collision_aabbs);
 	}
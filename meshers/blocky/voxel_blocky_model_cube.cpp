@@ -1,5 +1,6 @@
 #include "voxel_blocky_model_cube.h"
 #include "../../util/containers/container_funcs.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/math/conv.h"
 #include "voxel_blocky_model_mesh.h"
 
@@ -251,6 +252,18 @@ void VoxelBlockyModelCube::bake(BakedData &baked_data, bool bake_tangents, Mater
 	VoxelBlockyModel::bake(baked_data, bake_tangents, materials);
 }
 
+uint64_t VoxelBlockyModelCube::get_bake_hash() const {
+	uint64_t h = VoxelBlockyModel::get_bake_hash();
+	for (const Vector2i tile : _tiles) {
+		h = hash_djb2_one_64(tile.x, h);
+		h = hash_djb2_one_64(tile.y, h);
+	}
+	h = hash_djb2_one_64(_atlas_size_in_tiles.x, h);
+	h = hash_djb2_one_64(_atlas_size_in_tiles.y, h);
+	h = hash_djb2_one_float(_height, h);
+	return h;
+}
+
 bool VoxelBlockyModelCube::is_empty() const {
 	return false;
 }
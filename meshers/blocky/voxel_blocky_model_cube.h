@@ -27,6 +27,7 @@ public:
 	Vector2i get_atlas_size_in_tiles() const;
 
 	void bake(BakedData &baked_data, bool bake_tangents, MaterialIndexer &materials) const override;
+	uint64_t get_bake_hash() const override;
 	bool is_empty() const override;
 
 	Ref<Mesh> get_preview_mesh() const override;
@@ -1,4 +1,5 @@
 #include "voxel_blocky_model_mesh.h"
+#include "../../constants/voxel_string_names.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/array_mesh.h"
@@ -8,6 +9,7 @@
 #include "../../util/godot/core/array.h"
 #include "../../util/godot/core/packed_arrays.h"
 #include "../../util/godot/core/string.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/math/conv.h"
 #include "../../util/math/ortho_basis.h"
 #include "../../util/string/format.h"
@@ -24,8 +26,18 @@ void VoxelBlockyModelMesh::set_mesh(Ref<Mesh> mesh) {
 			return;
 		}
 	}
+	if (mesh == _mesh) {
+		return;
+	}
+	// Meshes can be modified after being assigned (in the editor, re-imported, or from scripts)
+	Callable change_handler = callable_mp(this, &VoxelBlockyModelMesh::_on_mesh_changed);
+	if (_mesh.is_valid()) {
+		_mesh->disconnect(VoxelStringNames::get_singleton().changed, change_handler);
+	}
 	_mesh = mesh;
+	_mesh_hash_valid = false;
 	if (_mesh.is_valid()) {
+		_mesh->connect(VoxelStringNames::get_singleton().changed, change_handler);
 		set_surface_count(_mesh->get_surface_count());
 	} else {
 		set_surface_count(0);
@@ -33,6 +45,14 @@ void VoxelBlockyModelMesh::set_mesh(Ref<Mesh> mesh) {
 	emit_changed();
 }
 
+void VoxelBlockyModelMesh::_on_mesh_changed() {
+	_mesh_hash_valid = false;
+	if (_mesh.is_valid()) {
+		set_surface_count(_mesh->get_surface_count());
+	}
+	emit_changed();
+}
+
 namespace {
 
 #ifdef TOOLS_ENABLED
@@ -492,6 +512,55 @@ void VoxelBlockyModelMesh::bake(BakedData &baked_data, bool bake_tangents, Mater
 	VoxelBlockyModel::bake(baked_data, bake_tangents, materials);
 }
 
+uint64_t VoxelBlockyModelMesh::get_bake_hash() const {
+	uint64_t h = VoxelBlockyModel::get_bake_hash();
+	h = hash_djb2_one_float(_side_vertex_tolerance, h);
+	if (_mesh.is_valid()) {
+		if (!_mesh_hash_valid) {
+			// Hashing contents rather than identifying the resource, because imported data can change without the
+			// source file changing (import settings), and meshes can be edited in memory without being saved.
+			// Materials are left out, they don't change baked geometry.
+			uint64_t mh = 5381;
+			const unsigned int surface_count =
+					math::min(static_cast<unsigned int>(_mesh->get_surface_count()), BakedData::Model::MAX_SURFACES);
+			mh = hash_djb2_one_64(surface_count, mh);
+			for (unsigned int surface_index = 0; surface_index < surface_count; ++surface_index) {
+				const Array arrays = _mesh->surface_get_arrays(surface_index);
+				if (arrays.size() < Mesh::ARRAY_MAX) {
+					mh = hash_djb2_one_64(0, mh);
+					continue;
+				}
+				const PackedVector3Array positions = arrays[Mesh::ARRAY_VERTEX];
+				const PackedVector3Array normals = arrays[Mesh::ARRAY_NORMAL];
+				const PackedVector2Array uvs = arrays[Mesh::ARRAY_TEX_UV];
+				const PackedFloat32Array tangents = arrays[Mesh::ARRAY_TANGENT];
+				const PackedInt32Array indices = arrays[Mesh::ARRAY_INDEX];
+				mh = hash_djb2_buffer_64(positions.ptr(), positions.size() * sizeof(Vector3), mh);
+				mh = hash_djb2_buffer_64(normals.ptr(), normals.size() * sizeof(Vector3), mh);
+				mh = hash_djb2_buffer_64(uvs.ptr(), uvs.size() * sizeof(Vector2), mh);
+				mh = hash_djb2_buffer_64(tangents.ptr(), tangents.size() * sizeof(float), mh);
+				mh = hash_djb2_buffer_64(indices.ptr(), indices.size() * sizeof(int32_t), mh);
+			}
+			_mesh_hash = mh;
+			_mesh_hash_valid = true;
+		}
+		h = hash_djb2_one_64(_mesh_hash, h);
+	}
+	return h;
+}
+
+Ref<Material> VoxelBlockyModelMesh::get_surface_baked_material(unsigned int surface_index) const {
+	// Overrides take precedence over materials of the mesh
+	Ref<Material> material = VoxelBlockyModel::get_surface_baked_material(surface_index);
+	if (material.is_valid() || _mesh.is_null()) {
+		return material;
+	}
+	if (surface_index < static_cast<unsigned int>(_mesh->get_surface_count())) {
+		material = _mesh->surface_get_material(surface_index);
+	}
+	return material;
+}
+
 bool VoxelBlockyModelMesh::is_empty() const {
 	if (_mesh.is_null()) {
 		return true;
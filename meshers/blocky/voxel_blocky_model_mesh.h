@@ -15,6 +15,8 @@ public:
 	}
 
 	void bake(BakedData &baked_data, bool bake_tangents, MaterialIndexer &materials) const override;
+	uint64_t get_bake_hash() const override;
+	Ref<Material> get_surface_baked_material(unsigned int surface_index) const override;
 	bool is_empty() const override;
 
 	Ref<Mesh> get_preview_mesh() const override;
@@ -23,9 +25,15 @@ public:
 	float get_side_vertex_tolerance() const;
 
 private:
+	void _on_mesh_changed();
+
 	static void _bind_methods();
 
 	Ref<Mesh> _mesh;
+	// Hash of the mesh arrays used for baking. Fetching arrays is slow, so it is only computed again after the mesh
+	// emits `changed`.
+	mutable uint64_t _mesh_hash = 0;
+	mutable bool _mesh_hash_valid = false;
 	// Margin near sides of the voxel where triangles will be considered to be "on the side". Those triangles will
 	// be processed by the neighbor side culling system.
 	float _side_vertex_tolerance = 0.001f;
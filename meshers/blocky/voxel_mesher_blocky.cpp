@@ -27,18 +27,20 @@ const int g_opposite_side[6] = {
 
 inline bool is_face_visible(
 		const VoxelBlockyLibraryBase::BakedData &lib,
-		const VoxelBlockyModel::BakedData &vt,
+		const VoxelBlockyLibraryBase::FlatBakedData::Model &model,
+		uint32_t voxel_id,
 		uint32_t other_voxel_id,
 		int side
 ) {
-	if (other_voxel_id < lib.models.size()) {
-		const VoxelBlockyModel::BakedData &other_vt = lib.models[other_voxel_id];
-		// TODO Maybe we could get rid of `empty` here and instead set `culls_neighbors` to false during baking
-		if (other_vt.empty || (other_vt.transparency_index > vt.transparency_index) || !other_vt.culls_neighbors) {
+	const VoxelBlockyLibraryBase::FlatBakedData &flat = lib.flat;
+	if (other_voxel_id < flat.models.size()) {
+		const VoxelBlockyLibraryBase::FlatBakedData::Model &other_model = flat.models[other_voxel_id];
+		if (!other_model.culls_neighbors || (other_model.transparency_index > model.transparency_index)) {
 			return true;
 		} else {
-			const unsigned int ai = vt.model.side_pattern_indices[side];
-			const unsigned int bi = other_vt.model.side_pattern_indices[g_opposite_side[side]];
+			const unsigned int ai = flat.side_pattern_indices[flat.get_side_index(voxel_id, side)];
+			const unsigned int bi =
+					flat.side_pattern_indices[flat.get_side_index(other_voxel_id, g_opposite_side[side])];
 			// Patterns are not the same, and B does not occlude A
 			return (ai != bi) && !lib.get_side_pattern_occlusion(bi, ai);
 		}
@@ -46,10 +48,9 @@ inline bool is_face_visible(
 	return true;
 }
 
-inline bool contributes_to_ao(const VoxelBlockyLibraryBase::BakedData &lib, uint32_t voxel_id) {
-	if (voxel_id < lib.models.size()) {
-		const VoxelBlockyModel::BakedData &t = lib.models[voxel_id];
-		return t.contributes_to_ao;
+inline bool contributes_to_ao(const VoxelBlockyLibraryBase::FlatBakedData &flat, uint32_t voxel_id) {
+	if (voxel_id < flat.models.size()) {
+		return flat.models[voxel_id].contributes_to_ao;
 	}
 	return true;
 }
@@ -150,6 +151,9 @@ void generate_blocky_mesh( //
 	corner_neighbor_lut[Cube::CORNER_TOP_FRONT_LEFT] = side_neighbor_lut[Cube::SIDE_TOP] +
 			side_neighbor_lut[Cube::SIDE_FRONT] + side_neighbor_lut[Cube::SIDE_LEFT];
 
+	// Side geometry is read from the flat layout, which keeps the per-voxel working set small
+	const VoxelBlockyLibraryBase::FlatBakedData &flat = library.flat;
+
 	// uint64_t time_prep = Time::get_singleton()->get_ticks_usec() - time_before;
 	// time_before = Time::get_singleton()->get_ticks_usec();
 
@@ -162,26 +166,25 @@ void generate_blocky_mesh( //
 				const int voxel_index = y + x * row_size + z * deck_size;
 				const int voxel_id = type_buffer[voxel_index];
 
-				if (voxel_id == VoxelBlockyModel::AIR_ID || !library.has_model(voxel_id)) {
+				if (voxel_id == VoxelBlockyModel::AIR_ID || voxel_id >= static_cast<int>(flat.models.size())) {
 					continue;
 				}
 
-				const VoxelBlockyModel::BakedData &voxel = library.models[voxel_id];
-				const VoxelBlockyModel::BakedData::Model &model = voxel.model;
+				const VoxelBlockyLibraryBase::FlatBakedData::Model &flat_model = flat.models[voxel_id];
 
 				// Hybrid approach: extract cube faces and decimate those that aren't visible,
 				// and still allow voxels to have geometry that is not a cube.
 
 				// Sides
 				for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
-					if ((model.empty_sides_mask & (1 << side)) != 0) {
+					if ((flat_model.empty_sides_mask & (1 << side)) != 0) {
 						// This side is empty
 						continue;
 					}
 
 					const uint32_t neighbor_voxel_id = type_buffer[voxel_index + side_neighbor_lut[side]];
 
-					if (!is_face_visible(library, voxel, neighbor_voxel_id, side)) {
+					if (!is_face_visible(library, flat_model, voxel_id, neighbor_voxel_id, side)) {
 						continue;
 					}
 
@@ -202,7 +205,7 @@ void generate_blocky_mesh( //
 						for (unsigned int j = 0; j < 4; ++j) {
 							const unsigned int edge = Cube::g_side_edges[side][j];
 							const int edge_neighbor_id = type_buffer[voxel_index + edge_neighbor_lut[edge]];
-							if (contributes_to_ao(library, edge_neighbor_id)) {
+							if (contributes_to_ao(flat, edge_neighbor_id)) {
 								++shaded_corner[Cube::g_edge_corners[edge][0]];
 								++shaded_corner[Cube::g_edge_corners[edge][1]];
 							}
@@ -213,7 +216,7 @@ void generate_blocky_mesh( //
 								shaded_corner[corner] = 3;
 							} else {
 								const int corner_neigbor_id = type_buffer[voxel_index + corner_neighbor_lut[corner]];
-								if (contributes_to_ao(library, corner_neigbor_id)) {
+								if (contributes_to_ao(flat, corner_neigbor_id)) {
 									++shaded_corner[corner];
 								}
 							}
@@ -223,21 +226,21 @@ void generate_blocky_mesh( //
 					// Subtracting 1 because the data is padded
 					const Vector3f pos(x - 1, y - 1, z - 1);
 
-					for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
-						const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
-
-						VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[surface.material_id];
-
-						ZN_ASSERT(surface.material_id >= 0 && surface.material_id < index_offsets.size());
-						int &index_offset = index_offsets[surface.material_id];
+					for (unsigned int surface_index = 0; surface_index < flat_model.surface_count; ++surface_index) {
+						const VoxelBlockyLibraryBase::FlatBakedData::SideSurface &side_surface =
+								flat.get_side_surface(voxel_id, side, surface_index);
+						const unsigned int vertex_count = side_surface.vertex_count;
+						if (vertex_count == 0) {
+							continue;
+						}
 
-						const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
+						VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[side_surface.material_id];
 
-						const StdVector<Vector3f> &side_positions = side_surface.positions;
-						const unsigned int vertex_count = side_surface.positions.size();
+						ZN_ASSERT(side_surface.material_id < index_offsets.size());
+						int &index_offset = index_offsets[side_surface.material_id];
 
-						const StdVector<Vector2f> &side_uvs = side_surface.uvs;
-						const StdVector<float> &side_tangents = side_surface.tangents;
+						const Vector3f *side_positions = flat.positions.data() + side_surface.vertex_begin;
+						const Vector2f *side_uvs = flat.uvs.data() + side_surface.vertex_begin;
 
 						// Append vertices of the faces in one go, don't use push_back
 
@@ -253,14 +256,14 @@ void generate_blocky_mesh( //
 						{
 							const int append_index = arrays.uvs.size();
 							arrays.uvs.resize(arrays.uvs.size() + vertex_count);
-							memcpy(arrays.uvs.data() + append_index, side_uvs.data(), vertex_count * sizeof(Vector2f));
+							memcpy(arrays.uvs.data() + append_index, side_uvs, vertex_count * sizeof(Vector2f));
 						}
 
-						if (side_tangents.size() > 0) {
+						if (side_surface.has_tangents) {
 							const int append_index = arrays.tangents.size();
 							arrays.tangents.resize(arrays.tangents.size() + vertex_count * 4);
 							memcpy(arrays.tangents.data() + append_index,
-								   side_tangents.data(),
+								   flat.tangents.data() + side_surface.vertex_begin * 4,
 								   (vertex_count * 4) * sizeof(float));
 						}
 
@@ -277,7 +280,7 @@ void generate_blocky_mesh( //
 							const int append_index = arrays.colors.size();
 							arrays.colors.resize(arrays.colors.size() + vertex_count);
 							Color *w = arrays.colors.data() + append_index;
-							const Color modulate_color = voxel.color;
+							const Color modulate_color = flat_model.color;
 
 							if (bake_occlusion) {
 								for (unsigned int i = 0; i < vertex_count; ++i) {
@@ -316,8 +319,8 @@ void generate_blocky_mesh( //
 							}
 						}
 
-						const StdVector<int> &side_indices = side_surface.indices;
-						const unsigned int index_count = side_indices.size();
+						const int32_t *side_indices = flat.indices.data() + side_surface.index_begin;
+						const unsigned int index_count = side_surface.index_count;
 
 						{
 							int i = arrays.indices.size();
@@ -328,7 +331,7 @@ void generate_blocky_mesh( //
 							}
 						}
 
-						if (collision_surface != nullptr && surface.collision_enabled) {
+						if (collision_surface != nullptr && side_surface.collision_enabled) {
 							StdVector<Vector3f> &dst_positions = collision_surface->positions;
 							StdVector<int> &dst_indices = collision_surface->indices;
 
@@ -357,6 +360,13 @@ void generate_blocky_mesh( //
 					}
 				}
 
+				if (!flat_model.has_inside_geometry) {
+					continue;
+				}
+
+				const VoxelBlockyModel::BakedData &voxel = library.models[voxel_id];
+				const VoxelBlockyModel::BakedData::Model &model = voxel.model;
+
 				// Inside
 				for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
 					const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
@@ -891,6 +901,7 @@ void append_side_seams(
 
 	const int z_base = z * jump.z;
 	const int side_sign = get_side_sign(side);
+	const VoxelBlockyLibraryBase::FlatBakedData &flat = library.flat;
 
 	// Buffers sent to chunk meshing have outer and inner voxels.
 	// Inner voxels are those that are actually being meshed.
@@ -930,15 +941,15 @@ void append_side_seams(
 
 			const Vector3f pos = side_to_block_coordinates(Vector3f(x - pad, y - pad, z - (side_sign + 1)), side);
 
-			const VoxelBlockyModel::BakedData &voxel = library.models[nv4];
-			const VoxelBlockyModel::BakedData::Model &model = voxel.model;
+			const VoxelBlockyLibraryBase::FlatBakedData::Model &flat_model = flat.models[nv4];
 
-			for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
-				const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
-				const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
-				const unsigned int vertex_count = side_surface.positions.size();
+			for (unsigned int surface_index = 0; surface_index < flat_model.surface_count; ++surface_index) {
+				const VoxelBlockyLibraryBase::FlatBakedData::SideSurface &side_surface =
+						flat.get_side_surface(nv4, side, surface_index);
+				const unsigned int vertex_count = side_surface.vertex_count;
+				const Vector3f *side_positions = flat.positions.data() + side_surface.vertex_begin;
 
-				VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[surface.material_id];
+				VoxelMesherBlocky::Arrays &arrays = out_arrays_per_material[side_surface.material_id];
 
 				// TODO The following code is pretty much the same as the main meshing function.
 				// We should put it in common once blocky mesher features are merged (blocky fluids, shadows occluders).
@@ -952,21 +963,23 @@ void append_side_seams(
 					arrays.positions.resize(arrays.positions.size() + vertex_count);
 					Vector3f *w = arrays.positions.data() + append_index;
 					for (unsigned int i = 0; i < vertex_count; ++i) {
-						w[i] = side_surface.positions[i] + pos;
+						w[i] = side_positions[i] + pos;
 					}
 				}
 
 				{
 					const unsigned int append_index = arrays.uvs.size();
 					arrays.uvs.resize(arrays.uvs.size() + vertex_count);
-					memcpy(arrays.uvs.data() + append_index, side_surface.uvs.data(), vertex_count * sizeof(Vector2f));
+					memcpy(arrays.uvs.data() + append_index,
+						   flat.uvs.data() + side_surface.vertex_begin,
+						   vertex_count * sizeof(Vector2f));
 				}
 
-				if (side_surface.tangents.size() > 0) {
+				if (side_surface.has_tangents) {
 					const unsigned int append_index = arrays.tangents.size();
 					arrays.tangents.resize(arrays.tangents.size() + vertex_count * 4);
 					memcpy(arrays.tangents.data() + append_index,
-						   side_surface.tangents.data(),
+						   flat.tangents.data() + side_surface.vertex_begin * 4,
 						   (vertex_count * 4) * sizeof(float));
 				}
 
@@ -983,7 +996,7 @@ void append_side_seams(
 					const int append_index = arrays.colors.size();
 					arrays.colors.resize(arrays.colors.size() + vertex_count);
 					Color *w = arrays.colors.data() + append_index;
-					const Color modulate_color = voxel.color;
+					const Color modulate_color = flat_model.color;
 
 					for (unsigned int i = 0; i < vertex_count; ++i) {
 						w[i] = modulate_color;
@@ -991,12 +1004,13 @@ void append_side_seams(
 				}
 
 				{
-					const unsigned int index_count = side_surface.indices.size();
+					const unsigned int index_count = side_surface.index_count;
+					const int32_t *side_indices = flat.indices.data() + side_surface.index_begin;
 					unsigned int i = arrays.indices.size();
 					arrays.indices.resize(arrays.indices.size() + index_count);
 					int *w = arrays.indices.data();
 					for (unsigned int j = 0; j < index_count; ++j) {
-						w[i++] = index_offset + side_surface.indices[j];
+						w[i++] = index_offset + side_indices[j];
 					}
 				}
 			}
@@ -2,7 +2,6 @@
 #include "../../storage/voxel_buffer.h"
 #include "../../util/godot/classes/array_mesh.h"
 #include "../../util/godot/classes/base_material_3d.h"
-#include "../../util/godot/classes/geometry_2d.h"
 #include "../../util/godot/classes/image.h"
 #include "../../util/godot/classes/shader_material.h"
 #include "../../util/godot/core/packed_arrays.h"
@@ -11,6 +10,8 @@
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 
+#include <algorithm>
+
 // TODO Binary greedy mesher optimization
 // https://www.youtube.com/watch?v=qnGoGq7DWMc
 
@@ -209,200 +210,304 @@ void build_voxel_mesh_as_simple_cubes(
 	}
 }
 
-template <typename Voxel_T, typename Color_F>
-void build_voxel_mesh_as_greedy_cubes(
-		FixedArray<VoxelMesherCubes::Arrays, VoxelMesherCubes::MATERIAL_COUNT> &out_arrays_per_material,
-		const Span<const Voxel_T> voxel_buffer,
-		const Vector3i block_size,
-		StdVector<uint8_t> &mask_memory_pool,
-		Color_F color_func
-) {
-	//
-	ERR_FAIL_COND(
-			block_size.x < static_cast<int>(2 * VoxelMesherCubes::PADDING) ||
-			block_size.y < static_cast<int>(2 * VoxelMesherCubes::PADDING) ||
-			block_size.z < static_cast<int>(2 * VoxelMesherCubes::PADDING)
-	);
+// Greedy meshing works on one deck of faces at a time. Each row of the deck is stored as a bitmask telling where faces
+// are, so empty areas are skipped quickly, and next to it a packed key per face telling which faces can be merged.
 
-	struct MaskValue {
-		Voxel_T color;
-		uint8_t side;
+inline unsigned int get_greedy_mask_words_per_row(unsigned int size_x) {
+	return (size_x + 63) / 64;
+}
 
-		inline bool operator==(const MaskValue &other) const {
-			return color == other.color && side == other.side;
-		}
+inline bool is_bit_set(const uint64_t *words, unsigned int i) {
+	return (words[i >> 6] & (uint64_t(1) << (i & 63))) != 0;
+}
 
-		inline bool operator!=(const MaskValue &other) const {
-			return color != other.color || side != other.side;
-		}
-	};
+// Returns a word with bits set in `[begin, end)`, where `begin < 64` and `end <= 64`.
+inline uint64_t get_bit_range_mask(unsigned int begin, unsigned int end) {
+	const uint64_t below_end = end == 64 ? ~uint64_t(0) : (uint64_t(1) << end) - 1;
+	return below_end & ~((uint64_t(1) << begin) - 1);
+}
 
-	const Vector3i min_pos = Vector3iUtil::create(VoxelMesherCubes::PADDING);
-	const Vector3i max_pos = block_size - Vector3iUtil::create(VoxelMesherCubes::PADDING);
-	const unsigned int row_size = block_size.y;
-	const unsigned int deck_size = block_size.x * row_size;
+inline bool are_all_bits_set(const uint64_t *words, unsigned int begin, unsigned int end) {
+	while (begin < end) {
+		const unsigned int word_index = begin >> 6;
+		const unsigned int word_begin = word_index << 6;
+		const unsigned int word_end = math::min(word_begin + 64, end);
+		const uint64_t m = get_bit_range_mask(begin - word_begin, word_end - word_begin);
+		if ((words[word_index] & m) != m) {
+			return false;
+		}
+		begin = word_end;
+	}
+	return true;
+}
 
-	// Note: voxel buffers are indexed in ZXY order
-	FixedArray<uint32_t, Vector3iUtil::AXIS_COUNT> neighbor_offset_d_lut;
-	neighbor_offset_d_lut[Vector3i::AXIS_X] = block_size.y;
-	neighbor_offset_d_lut[Vector3i::AXIS_Y] = 1;
-	neighbor_offset_d_lut[Vector3i::AXIS_Z] = block_size.x * block_size.y;
+inline void clear_bits(uint64_t *words, unsigned int begin, unsigned int end) {
+	while (begin < end) {
+		const unsigned int word_index = begin >> 6;
+		const unsigned int word_begin = word_index << 6;
+		const unsigned int word_end = math::min(word_begin + 64, end);
+		words[word_index] &= ~get_bit_range_mask(begin - word_begin, word_end - word_begin);
+		begin = word_end;
+	}
+}
 
-	FixedArray<uint32_t, VoxelMesherCubes::MATERIAL_COUNT> index_offsets;
-	fill(index_offsets, uint32_t(0));
+// Resolves colors of the whole block once, instead of doing it for both voxels of every cell of every axis.
+template <typename Voxel_T, typename Color_F>
+void compute_alpha_indices(
+		const Span<const Voxel_T> voxel_buffer,
+		StdVector<uint8_t> &alpha_indices,
+		Color_F color_func
+) {
+	ZN_PROFILE_SCOPE();
+	alpha_indices.resize(voxel_buffer.size());
+	for (unsigned int i = 0; i < voxel_buffer.size(); ++i) {
+		alpha_indices[i] = get_alpha_index(color_func(voxel_buffer[i]));
+	}
+}
 
-	// For each axis
-	for (unsigned int za = 0; za < Vector3iUtil::AXIS_COUNT; ++za) {
-		const unsigned int xa = g_face_axes_lut[za][0];
-		const unsigned int ya = g_face_axes_lut[za][1];
+// Finds faces between deck `d` and the next deck along axis `za`, and stores them in the mask.
+// `get_key(voxel_index, side, mask_index)` is called for each face, with the index of the voxel the face belongs to.
+// It returns the key of the face.
+template <typename Key_F>
+void fill_greedy_mask(
+		VoxelMesherCubes::GreedyMask &mask,
+		const Vector3i block_size,
+		const unsigned int za,
+		const unsigned int d,
+		Key_F get_key
+) {
+	const unsigned int xa = g_face_axes_lut[za][0];
+	const unsigned int ya = g_face_axes_lut[za][1];
+	const unsigned int mask_size_x = block_size[xa] - 2 * VoxelMesherCubes::PADDING;
+	const unsigned int mask_size_y = block_size[ya] - 2 * VoxelMesherCubes::PADDING;
+	const unsigned int words_per_row = get_greedy_mask_words_per_row(mask_size_x);
 
-		const unsigned int mask_size_x = (max_pos[xa] - min_pos[xa]);
-		const unsigned int mask_size_y = (max_pos[ya] - min_pos[ya]);
-		const unsigned int mask_area = mask_size_x * mask_size_y;
-		// Using the vector as memory pool
-		mask_memory_pool.resize(mask_area * sizeof(MaskValue));
-		Span<MaskValue> mask(reinterpret_cast<MaskValue *>(mask_memory_pool.data()), 0, mask_area);
+	// Note: voxel buffers are indexed in ZXY order
+	FixedArray<uint32_t, Vector3iUtil::AXIS_COUNT> stride_lut;
+	stride_lut[Vector3i::AXIS_X] = block_size.y;
+	stride_lut[Vector3i::AXIS_Y] = 1;
+	stride_lut[Vector3i::AXIS_Z] = block_size.x * block_size.y;
+	const uint32_t stride_x = stride_lut[xa];
+	const uint32_t stride_y = stride_lut[ya];
+	const uint32_t stride_d = stride_lut[za];
+
+	const Span<const uint8_t> alpha_indices = to_span(mask.alpha_indices);
+
+	for (unsigned int my = 0; my < mask_size_y; ++my) {
+		uint64_t *row_bits = mask.bits.data() + my * words_per_row;
+		for (unsigned int wi = 0; wi < words_per_row; ++wi) {
+			row_bits[wi] = 0;
+		}
 
-		// For each deck
-		for (unsigned int d = min_pos[za] - VoxelMesherCubes::PADDING; d < (unsigned int)max_pos[za]; ++d) {
-			// For each cell of the deck, gather face info
-			for (unsigned int fy = min_pos[ya]; fy < (unsigned int)max_pos[ya]; ++fy) {
-				for (unsigned int fx = min_pos[xa]; fx < (unsigned int)max_pos[xa]; ++fx) {
-					FixedArray<unsigned int, Vector3iUtil::AXIS_COUNT> pos;
-					pos[xa] = fx;
-					pos[ya] = fy;
-					pos[za] = d;
+		unsigned int voxel_index = VoxelMesherCubes::PADDING * stride_x +
+				(my + VoxelMesherCubes::PADDING) * stride_y + d * stride_d;
 
-					const unsigned int voxel_index = pos[Vector3i::AXIS_Y] + pos[Vector3i::AXIS_X] * row_size +
-							pos[Vector3i::AXIS_Z] * deck_size;
+		for (unsigned int mx = 0; mx < mask_size_x; ++mx, voxel_index += stride_x) {
+			const uint8_t ai0 = alpha_indices[voxel_index];
+			const uint8_t ai1 = alpha_indices[voxel_index + stride_d];
 
-					const Voxel_T raw_color0 = voxel_buffer[voxel_index];
-					const Voxel_T raw_color1 = voxel_buffer[voxel_index + neighbor_offset_d_lut[za]];
+			if (ai0 == ai1) {
+				continue;
+			}
 
-					const Color8 color0 = color_func(raw_color0);
-					const Color8 color1 = color_func(raw_color1);
+			const unsigned int mask_index = mx + my * mask_size_x;
+			if (ai0 > ai1) {
+				mask.keys[mask_index] = get_key(voxel_index, FACE_SIDE_BACK, mask_index);
+			} else {
+				mask.keys[mask_index] = get_key(voxel_index + stride_d, FACE_SIDE_FRONT, mask_index);
+			}
+			row_bits[mx >> 6] |= uint64_t(1) << (mx & 63);
+		}
+	}
+}
 
-					const uint8_t ai0 = get_alpha_index(color0);
-					const uint8_t ai1 = get_alpha_index(color1);
+// Merges faces of the mask into rectangles of faces having the same key, and consumes them.
+// Calls `f(x0, y0, x1, y1, key)` for each rectangle, where the max coordinates are exclusive.
+template <typename F>
+void for_each_greedy_quad(
+		VoxelMesherCubes::GreedyMask &mask,
+		const unsigned int mask_size_x,
+		const unsigned int mask_size_y,
+		F f
+) {
+	const unsigned int words_per_row = get_greedy_mask_words_per_row(mask_size_x);
 
-					MaskValue mv;
-					if (ai0 == ai1) {
-						mv.side = FACE_SIDE_NONE;
-					} else if (ai0 > ai1) {
-						mv.color = raw_color0;
-						mv.side = FACE_SIDE_BACK;
-					} else {
-						mv.color = raw_color1;
-						mv.side = FACE_SIDE_FRONT;
-					}
+	for (unsigned int y0 = 0; y0 < mask_size_y; ++y0) {
+		uint64_t *row_bits = mask.bits.data() + y0 * words_per_row;
+		const uint64_t *row_keys = mask.keys.data() + y0 * mask_size_x;
 
-					mask[(fx - VoxelMesherCubes::PADDING) + (fy - VoxelMesherCubes::PADDING) * mask_size_x] = mv;
-				}
-			}
+		for (unsigned int wi = 0; wi < words_per_row; ++wi) {
+			while (row_bits[wi] != 0) {
+				const unsigned int x0 = (wi << 6) + math::get_lowest_set_bit_index_64(row_bits[wi]);
+				const uint64_t key = row_keys[x0];
 
-			struct L {
-				static inline bool is_range_equal(
-						const Span<MaskValue> &mask,
-						unsigned int xmin,
-						unsigned int xmax,
-						MaskValue v
-				) {
-					for (unsigned int x = xmin; x < xmax; ++x) {
-						if (mask[x] != v) {
-							return false;
-						}
-					}
-					return true;
+				// Check if the next faces are the same along X
+				unsigned int x1 = x0 + 1;
+				while (x1 < mask_size_x && is_bit_set(row_bits, x1) && row_keys[x1] == key) {
+					++x1;
 				}
-			};
-
-			// Greedy quads
-			for (unsigned int fy = 0; fy < mask_size_y; ++fy) {
-				for (unsigned int fx = 0; fx < mask_size_x; ++fx) {
-					const unsigned int mask_index = fx + fy * mask_size_x;
-					const MaskValue m = mask[mask_index];
 
-					if (m.side == FACE_SIDE_NONE) {
-						continue;
+				// Check if the next rows of faces are the same along Y. Bits are tested first, which quickly rejects
+				// rows with holes or faces already consumed.
+				unsigned int y1 = y0 + 1;
+				while (y1 < mask_size_y) {
+					if (!are_all_bits_set(mask.bits.data() + y1 * words_per_row, x0, x1)) {
+						break;
 					}
-
-					// Check if the next faces are the same along X
-					unsigned int rx = fx + 1;
-					while (rx < mask_size_x && mask[rx + fy * mask_size_x] == m) {
-						++rx;
+					const uint64_t *keys = mask.keys.data() + y1 * mask_size_x;
+					unsigned int x = x0;
+					while (x < x1 && keys[x] == key) {
+						++x;
 					}
-
-					// Check if the next rows of faces are the same along Y
-					unsigned int ry = fy + 1;
-					while (ry < mask_size_y && L::is_range_equal(mask, fx + ry * mask_size_x, rx + ry * mask_size_x, m)
-					) {
-						++ry;
+					if (x != x1) {
+						break;
 					}
+					++y1;
+				}
 
-					// Commit face to the mesh
+				for (unsigned int y = y0; y < y1; ++y) {
+					clear_bits(mask.bits.data() + y * words_per_row, x0, x1);
+				}
 
-					const Color colorf = color_func(m.color);
-					const uint8_t material_index = colorf.a < 0.999f;
-					VoxelMesherCubes::Arrays &arrays = out_arrays_per_material[material_index];
+				f(x0, y0, x1, y1, key);
+			}
+		}
+	}
+}
 
-					Vector3f v0;
-					v0[xa] = fx;
-					v0[ya] = fy;
-					v0[za] = d;
+void prepare_greedy_mask(VoxelMesherCubes::GreedyMask &mask, unsigned int mask_size_x, unsigned int mask_size_y) {
+	mask.bits.resize(get_greedy_mask_words_per_row(mask_size_x) * mask_size_y);
+	mask.keys.resize(mask_size_x * mask_size_y);
+}
 
-					Vector3f v1;
-					v1[xa] = rx;
-					v1[ya] = fy;
-					v1[za] = d;
+// Adds positions, normals and indices of a greedy quad. Returns the index of its first vertex.
+unsigned int add_greedy_quad(
+		VoxelMesherCubes::Arrays &arrays,
+		const unsigned int za,
+		const unsigned int d,
+		const unsigned int x0,
+		const unsigned int y0,
+		const unsigned int x1,
+		const unsigned int y1,
+		const uint8_t side,
+		uint32_t &index_offset
+) {
+	const unsigned int xa = g_face_axes_lut[za][0];
+	const unsigned int ya = g_face_axes_lut[za][1];
+
+	Vector3f v0;
+	v0[xa] = x0;
+	v0[ya] = y0;
+	v0[za] = d;
+
+	Vector3f v1;
+	v1[xa] = x1;
+	v1[ya] = y0;
+	v1[za] = d;
+
+	Vector3f v2;
+	v2[xa] = x0;
+	v2[ya] = y1;
+	v2[za] = d;
+
+	Vector3f v3;
+	v3[xa] = x1;
+	v3[ya] = y1;
+	v3[za] = d;
+
+	Vector3f n;
+	n[za] = side == FACE_SIDE_FRONT ? -1 : 1;
+
+	// 2-----3
+	// |     |
+	// |     |
+	// 0-----1
+
+	const unsigned int first_vertex_index = arrays.positions.size();
+
+	arrays.positions.push_back(v0);
+	arrays.positions.push_back(v1);
+	arrays.positions.push_back(v2);
+	arrays.positions.push_back(v3);
+
+	arrays.normals.push_back(n);
+	arrays.normals.push_back(n);
+	arrays.normals.push_back(n);
+	arrays.normals.push_back(n);
+
+	CRASH_COND(za >= 3 || side >= 2);
+	const uint8_t *lut = g_indices_lut[za][side];
+	for (unsigned int i = 0; i < 6; ++i) {
+		arrays.indices.push_back(index_offset + lut[i]);
+	}
+	index_offset += 4;
 
-					Vector3f v2;
-					v2[xa] = fx;
-					v2[ya] = ry;
-					v2[za] = d;
+	return first_vertex_index;
+}
 
-					Vector3f v3;
-					v3[xa] = rx;
-					v3[ya] = ry;
-					v3[za] = d;
+template <typename Voxel_T, typename Color_F>
+void build_voxel_mesh_as_greedy_cubes(
+		FixedArray<VoxelMesherCubes::Arrays, VoxelMesherCubes::MATERIAL_COUNT> &out_arrays_per_material,
+		const Span<const Voxel_T> voxel_buffer,
+		const Vector3i block_size,
+		VoxelMesherCubes::GreedyMask &mask,
+		Color_F color_func
+) {
+	//
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND(
+			block_size.x < static_cast<int>(2 * VoxelMesherCubes::PADDING) ||
+			block_size.y < static_cast<int>(2 * VoxelMesherCubes::PADDING) ||
+			block_size.z < static_cast<int>(2 * VoxelMesherCubes::PADDING)
+	);
 
-					Vector3f n;
-					n[za] = m.side == FACE_SIDE_FRONT ? -1 : 1;
+	compute_alpha_indices(voxel_buffer, mask.alpha_indices, color_func);
 
-					// 2-----3
-					// |     |
-					// |     |
-					// 0-----1
+	const Vector3i min_pos = Vector3iUtil::create(VoxelMesherCubes::PADDING);
+	const Vector3i max_pos = block_size - Vector3iUtil::create(VoxelMesherCubes::PADDING);
 
-					arrays.positions.push_back(v0);
-					arrays.positions.push_back(v1);
-					arrays.positions.push_back(v2);
-					arrays.positions.push_back(v3);
+	FixedArray<uint32_t, VoxelMesherCubes::MATERIAL_COUNT> index_offsets;
+	fill(index_offsets, uint32_t(0));
 
-					arrays.colors.push_back(colorf);
-					arrays.colors.push_back(colorf);
-					arrays.colors.push_back(colorf);
-					arrays.colors.push_back(colorf);
+	// Faces are merged if they have the same raw color and side. Colors are only resolved once per quad.
+	auto get_key = [voxel_buffer](unsigned int voxel_index, uint8_t side, unsigned int mask_index) {
+		return (static_cast<uint64_t>(voxel_buffer[voxel_index]) << 1) | side;
+	};
 
-					arrays.normals.push_back(n);
-					arrays.normals.push_back(n);
-					arrays.normals.push_back(n);
-					arrays.normals.push_back(n);
+	// For each axis
+	for (unsigned int za = 0; za < Vector3iUtil::AXIS_COUNT; ++za) {
+		const unsigned int xa = g_face_axes_lut[za][0];
+		const unsigned int ya = g_face_axes_lut[za][1];
 
-					const unsigned int index_offset = index_offsets[material_index];
-					CRASH_COND(za >= 3 || m.side >= 2);
-					const uint8_t *lut = g_indices_lut[za][m.side];
-					for (unsigned int i = 0; i < 6; ++i) {
-						arrays.indices.push_back(index_offset + lut[i]);
-					}
-					index_offsets[material_index] += 4;
+		const unsigned int mask_size_x = (max_pos[xa] - min_pos[xa]);
+		const unsigned int mask_size_y = (max_pos[ya] - min_pos[ya]);
+		prepare_greedy_mask(mask, mask_size_x, mask_size_y);
 
-					for (unsigned int j = fy; j < ry; ++j) {
-						for (unsigned int i = fx; i < rx; ++i) {
-							mask[i + j * mask_size_x].side = FACE_SIDE_NONE;
-						}
+		// For each deck
+		for (unsigned int d = min_pos[za] - VoxelMesherCubes::PADDING; d < (unsigned int)max_pos[za]; ++d) {
+			fill_greedy_mask(mask, block_size, za, d, get_key);
+
+			for_each_greedy_quad(
+					mask,
+					mask_size_x,
+					mask_size_y,
+					[&out_arrays_per_material, &index_offsets, color_func, za, d](
+							unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, uint64_t key
+					) {
+						const uint8_t side = key & 1;
+						const Color8 color = color_func(static_cast<Voxel_T>(key >> 1));
+						const uint8_t material_index = color.a < 255;
+						VoxelMesherCubes::Arrays &arrays = out_arrays_per_material[material_index];
+
+						add_greedy_quad(arrays, za, d, x0, y0, x1, y1, side, index_offsets[material_index]);
+
+						const Color colorf = color;
+						arrays.colors.push_back(colorf);
+						arrays.colors.push_back(colorf);
+						arrays.colors.push_back(colorf);
+						arrays.colors.push_back(colorf);
 					}
-				}
-			}
+			);
 		}
 	}
 }
@@ -411,9 +516,9 @@ template <typename Voxel_T, typename Color_F>
 void build_voxel_mesh_as_greedy_cubes_atlased(
 		FixedArray<VoxelMesherCubes::Arrays, VoxelMesherCubes::MATERIAL_COUNT> &out_arrays_per_material,
 		VoxelMesherCubes::GreedyAtlasData &out_greedy_atlas_data,
-		const Span<Voxel_T> voxel_buffer,
+		const Span<const Voxel_T> voxel_buffer,
 		const Vector3i block_size,
-		StdVector<uint8_t> &mask_memory_pool,
+		VoxelMesherCubes::GreedyMask &mask,
 		Color_F color_func
 ) {
 	//
@@ -424,35 +529,24 @@ void build_voxel_mesh_as_greedy_cubes_atlased(
 			block_size.z < static_cast<int>(2 * VoxelMesherCubes::PADDING)
 	);
 
-	struct MaskValue {
-		uint8_t side;
-		uint8_t material_index;
-
-		inline bool operator==(const MaskValue &other) const {
-			return side == other.side && material_index == other.material_index;
-		}
-
-		inline bool operator!=(const MaskValue &other) const {
-			return side != other.side || material_index != other.material_index;
-		}
-	};
-
 	out_greedy_atlas_data.clear();
 
+	compute_alpha_indices(voxel_buffer, mask.alpha_indices, color_func);
+
 	const Vector3i min_pos = Vector3iUtil::create(VoxelMesherCubes::PADDING);
 	const Vector3i max_pos = block_size - Vector3iUtil::create(VoxelMesherCubes::PADDING);
-	const unsigned int row_size = block_size.y;
-	const unsigned int deck_size = block_size.x * row_size;
-
-	// Note: voxel buffers are indexed in ZXY order
-	FixedArray<uint32_t, Vector3iUtil::AXIS_COUNT> neighbor_offset_d_lut;
-	neighbor_offset_d_lut[Vector3i::AXIS_X] = block_size.y;
-	neighbor_offset_d_lut[Vector3i::AXIS_Y] = 1;
-	neighbor_offset_d_lut[Vector3i::AXIS_Z] = block_size.x * block_size.y;
 
 	FixedArray<uint32_t, VoxelMesherCubes::MATERIAL_COUNT> index_offsets;
 	fill(index_offsets, uint32_t(0));
 
+	// Colors go in the atlas, so faces of different colors can be merged as long as they use the same material
+	auto get_key = [voxel_buffer, &mask, color_func](unsigned int voxel_index, uint8_t side, unsigned int mask_index) {
+		const Color8 color = color_func(voxel_buffer[voxel_index]);
+		mask.colors[mask_index] = color;
+		const uint8_t material_index = color.a < 255;
+		return static_cast<uint64_t>((material_index << 1) | side);
+	};
+
 	// For each axis
 	for (unsigned int za = 0; za < Vector3iUtil::AXIS_COUNT; ++za) {
 		const unsigned int xa = g_face_axes_lut[za][0];
@@ -460,231 +554,121 @@ void build_voxel_mesh_as_greedy_cubes_atlased(
 
 		const unsigned int mask_size_x = (max_pos[xa] - min_pos[xa]);
 		const unsigned int mask_size_y = (max_pos[ya] - min_pos[ya]);
-		const unsigned int mask_area = mask_size_x * mask_size_y;
-		// Using the vector as memory pool
-		const unsigned int mask_memory_size = mask_area * sizeof(MaskValue);
-		mask_memory_pool.resize(mask_memory_size + mask_area * sizeof(Color8));
-		// `mask` and `colors` are grids covering one deck
-		Span<MaskValue> mask(reinterpret_cast<MaskValue *>(mask_memory_pool.data()), 0, mask_area);
-		Span<Color8> colors(reinterpret_cast<Color8 *>(mask_memory_pool.data() + mask_memory_size), 0, mask_area);
+		prepare_greedy_mask(mask, mask_size_x, mask_size_y);
+		mask.colors.resize(mask_size_x * mask_size_y);
 
 		// For each deck
 		for (unsigned int d = min_pos[za] - VoxelMesherCubes::PADDING; d < (unsigned int)max_pos[za]; ++d) {
-			// For each cell of the deck, gather face info
-			for (unsigned int fy = min_pos[ya]; fy < (unsigned int)max_pos[ya]; ++fy) {
-				for (unsigned int fx = min_pos[xa]; fx < (unsigned int)max_pos[xa]; ++fx) {
-					FixedArray<unsigned int, Vector3iUtil::AXIS_COUNT> pos;
-					pos[xa] = fx;
-					pos[ya] = fy;
-					pos[za] = d;
-
-					const unsigned int voxel_index = pos[Vector3i::AXIS_Y] + pos[Vector3i::AXIS_X] * row_size +
-							pos[Vector3i::AXIS_Z] * deck_size;
-
-					const Voxel_T raw_color0 = voxel_buffer[voxel_index];
-					const Voxel_T raw_color1 = voxel_buffer[voxel_index + neighbor_offset_d_lut[za]];
-
-					const Color8 color0 = color_func(raw_color0);
-					const Color8 color1 = color_func(raw_color1);
-
-					const uint8_t ai0 = get_alpha_index(color0);
-					const uint8_t ai1 = get_alpha_index(color1);
-
-					MaskValue mv;
-					Color8 color;
-					if (ai0 == ai1) {
-						mv.side = FACE_SIDE_NONE;
-					} else if (ai0 > ai1) {
-						color = color0;
-						mv.side = FACE_SIDE_BACK;
-						mv.material_index = color.a < 0.999f;
-					} else {
-						color = color1;
-						mv.side = FACE_SIDE_FRONT;
-						mv.material_index = color.a < 0.999f;
-					}
-
-					const unsigned int mask_index =
-							(fx - VoxelMesherCubes::PADDING) + (fy - VoxelMesherCubes::PADDING) * mask_size_x;
-					mask[mask_index] = mv;
-					colors[mask_index] = color;
-				}
-			}
-
-			struct L {
-				static inline bool is_range_equal(
-						const Span<MaskValue> &mask,
-						unsigned int xmin,
-						unsigned int xmax,
-						MaskValue v
-				) {
-					for (unsigned int x = xmin; x < xmax; ++x) {
-						if (mask[x] != v) {
-							return false;
-						}
-					}
-					return true;
-				}
-			};
-
-			// Greedy quads
-			for (unsigned int fy = 0; fy < mask_size_y; ++fy) {
-				for (unsigned int fx = 0; fx < mask_size_x; ++fx) {
-					const unsigned int mask_index = fx + fy * mask_size_x;
-					const MaskValue m = mask[mask_index];
-
-					if (m.side == FACE_SIDE_NONE) {
-						continue;
-					}
-
-					// Check if the next faces are the same along X
-					unsigned int rx = fx + 1;
-					while (rx < mask_size_x && mask[rx + fy * mask_size_x] == m) {
-						++rx;
-					}
-
-					// Check if the next rows of faces are the same along Y
-					unsigned int ry = fy + 1;
-					while (ry < mask_size_y && L::is_range_equal(mask, fx + ry * mask_size_x, rx + ry * mask_size_x, m)
+			fill_greedy_mask(mask, block_size, za, d, get_key);
+
+			for_each_greedy_quad(
+					mask,
+					mask_size_x,
+					mask_size_y,
+					[&out_arrays_per_material, &out_greedy_atlas_data, &index_offsets, &mask, mask_size_x, za, d](
+							unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, uint64_t key
 					) {
-						++ry;
-					}
-
-					// Commit face to the mesh
-
-					const uint8_t material_index = m.material_index;
-					VoxelMesherCubes::Arrays &arrays = out_arrays_per_material[material_index];
-
-					Vector3f v0;
-					v0[xa] = fx;
-					v0[ya] = fy;
-					v0[za] = d;
-
-					Vector3f v1;
-					v1[xa] = rx;
-					v1[ya] = fy;
-					v1[za] = d;
-
-					Vector3f v2;
-					v2[xa] = fx;
-					v2[ya] = ry;
-					v2[za] = d;
-
-					Vector3f v3;
-					v3[xa] = rx;
-					v3[ya] = ry;
-					v3[za] = d;
-
-					Vector3f n;
-					n[za] = m.side == FACE_SIDE_FRONT ? -1 : 1;
-
-					// 2-----3
-					// |     |
-					// |     |
-					// 0-----1
-
-					arrays.positions.push_back(v0);
-					arrays.positions.push_back(v1);
-					arrays.positions.push_back(v2);
-					arrays.positions.push_back(v3);
-
-					VoxelMesherCubes::GreedyAtlasData::ImageInfo image_info;
-					image_info.first_vertex_index = arrays.uvs.size();
-					arrays.uvs.resize(arrays.uvs.size() + 4); // Values will be assigned in a second pass
-
-					arrays.normals.push_back(n);
-					arrays.normals.push_back(n);
-					arrays.normals.push_back(n);
-					arrays.normals.push_back(n);
+						const uint8_t side = key & 1;
+						const uint8_t material_index = key >> 1;
+						VoxelMesherCubes::Arrays &arrays = out_arrays_per_material[material_index];
+
+						VoxelMesherCubes::GreedyAtlasData::ImageInfo image_info;
+						image_info.first_vertex_index =
+								add_greedy_quad(arrays, za, d, x0, y0, x1, y1, side, index_offsets[material_index]);
+						// Values will be assigned in a second pass
+						arrays.uvs.resize(arrays.uvs.size() + 4);
+
+						image_info.size_x = x1 - x0;
+						image_info.size_y = y1 - y0;
+						image_info.first_color_index = out_greedy_atlas_data.colors.size();
+						image_info.surface_index = material_index;
+						out_greedy_atlas_data.colors.resize(
+								out_greedy_atlas_data.colors.size() + image_info.size_x * image_info.size_y
+						);
 
-					image_info.size_x = rx - fx;
-					image_info.size_y = ry - fy;
-					image_info.first_color_index = out_greedy_atlas_data.colors.size();
-					out_greedy_atlas_data.colors.resize(
-							out_greedy_atlas_data.colors.size() + image_info.size_x * image_info.size_y
-					);
+						// Copy colors row by row
+						Color8 *dst = out_greedy_atlas_data.colors.data() + image_info.first_color_index;
+						for (unsigned int y = y0; y < y1; ++y) {
+							memcpy(dst, mask.colors.data() + x0 + y * mask_size_x, image_info.size_x * sizeof(Color8));
+							dst += image_info.size_x;
+						}
 
-					const unsigned int index_offset = index_offsets[material_index];
-					CRASH_COND(za >= 3 || m.side >= 2);
-					const uint8_t *lut = g_indices_lut[za][m.side];
-					for (unsigned int i = 0; i < 6; ++i) {
-						arrays.indices.push_back(index_offset + lut[i]);
-					}
-					index_offsets[material_index] += 4;
+						// TODO Optimization: if colors are uniform, we could allocate a shared single pixel instead.
+						// This would reduce texture size and packing cost
 
-					unsigned int im_i = image_info.first_color_index;
-					for (unsigned int my = fy; my < ry; ++my) {
-						const unsigned int i0 = fx + my * mask_size_x;
-						{
-							unsigned int i = i0;
-							for (unsigned int mx = fx; mx < rx; ++mx) {
-								mask[i].side = FACE_SIDE_NONE;
-								++i;
-							}
-						}
-						{
-							unsigned int i = i0;
-							for (unsigned int mx = fx; mx < rx; ++mx) {
-								out_greedy_atlas_data.colors[im_i] = colors[i];
-								++im_i;
-								++i;
-							}
-						}
-						// TODO Actually that code only missed an offset to its destination for each row?
-						// Copy colors row by row
-						// memcpy(out_greedy_atlas_data.colors.data() + image_info.first_color_index,
-						// 		colors.data() + i0,
-						// 		image_info.size_x * sizeof(Color8));
+						out_greedy_atlas_data.images.push_back(image_info);
 					}
+			);
+		}
+	}
+}
 
-					// TODO Optimization: if colors are uniform, we could allocate a shared single pixel instead.
-					// This would reduce texture size and packing cost
+// Packs images of greedy quads in rows of decreasing height. Quads are small and numerous, so this wastes little space
+// and is much cheaper than a general-purpose packer. Buffers of the packer are reused.
+Vector2i pack_greedy_atlas(
+		const VoxelMesherCubes::GreedyAtlasData &atlas_data,
+		VoxelMesherCubes::GreedyAtlasPacker &packer
+) {
+	ZN_PROFILE_SCOPE();
+	const StdVector<VoxelMesherCubes::GreedyAtlasData::ImageInfo> &images = atlas_data.images;
+
+	packer.order.resize(images.size());
+	uint64_t area = 0;
+	unsigned int max_size_x = 0;
+	for (unsigned int i = 0; i < images.size(); ++i) {
+		const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im = images[i];
+		packer.order[i] = i;
+		area += im.size_x * im.size_y;
+		max_size_x = math::max(max_size_x, im.size_x);
+	}
 
-					image_info.surface_index = material_index;
-					out_greedy_atlas_data.images.push_back(image_info);
-				}
-			}
+	std::sort(packer.order.begin(), packer.order.end(), [&images](uint32_t a, uint32_t b) {
+		const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im_a = images[a];
+		const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im_b = images[b];
+		if (im_a.size_y != im_b.size_y) {
+			return im_a.size_y > im_b.size_y;
+		}
+		return im_a.size_x > im_b.size_x;
+	});
+
+	// Aim for a roughly square atlas
+	const unsigned int max_width =
+			math::max(max_size_x, static_cast<unsigned int>(Math::ceil(Math::sqrt(double(area)))));
+
+	packer.positions.resize(images.size());
+	unsigned int x = 0;
+	unsigned int y = 0;
+	unsigned int row_height = 0;
+	unsigned int width = 0;
+
+	for (const uint32_t image_index : packer.order) {
+		const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im = images[image_index];
+		if (x + im.size_x > max_width) {
+			// Start a new row
+			y += row_height;
+			x = 0;
+			row_height = 0;
 		}
+		packer.positions[image_index] = Vector2i(x, y);
+		x += im.size_x;
+		width = math::max(width, x);
+		row_height = math::max(row_height, im.size_y);
 	}
+
+	return Vector2i(width, y + row_height);
 }
 
 Ref<Image> make_greedy_atlas(
 		const VoxelMesherCubes::GreedyAtlasData &atlas_data,
+		VoxelMesherCubes::GreedyAtlasPacker &packer,
 		Span<VoxelMesherCubes::Arrays> surfaces
 ) {
 	//
 	ERR_FAIL_COND_V(atlas_data.images.size() == 0, Ref<Image>());
 	ZN_PROFILE_SCOPE();
 
-	// Pack rectangles
-	StdVector<Vector2i> result_points;
-	Vector2i result_size;
-	{
-		ZN_PROFILE_SCOPE_NAMED("Packing");
-		StdVector<Vector2i> sizes;
-		sizes.resize(atlas_data.images.size());
-		for (unsigned int i = 0; i < atlas_data.images.size(); ++i) {
-			const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im = atlas_data.images[i];
-			sizes[i] = Vector2i(im.size_x, im.size_y);
-		}
-		zylann::godot::geometry_2d_make_atlas(to_span(sizes), result_points, result_size);
-	}
-
-	// DEBUG
-	// Ref<Image> debug_im;
-	// debug_im.instance();
-	// debug_im->create(result_size.x, result_size.y, false, Image::FORMAT_RGBA8);
-	// debug_im->fill(Color(0, 0, 0));
-	// for (unsigned int i = 0; i < atlas_data.images.size(); ++i) {
-	// 	const Vector2i dst_pos = result_points[i];
-	// 	const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im = atlas_data.images[i];
-	// 	Ref<Image> tmp;
-	// 	tmp.instance();
-	// 	tmp->create(im.size_x, im.size_y, false, debug_im->get_format());
-	// 	tmp->fill(Color(Math::randf(), Math::randf(), Math::randf()));
-	// 	debug_im->blit_rect(tmp, Rect2(0, 0, tmp->get_width(), tmp->get_height()), Vector2f(dst_pos));
-	// }
-	// debug_im->save_png("debug_atlas_packing.png");
+	const Vector2i result_size = pack_greedy_atlas(atlas_data, packer);
+	const StdVector<Vector2i> &result_points = packer.positions;
 
 	// Update UVs
 	const Vector2f uv_scale(1.f / float(result_size.x), 1.f / float(result_size.y));
@@ -709,21 +693,20 @@ Ref<Image> make_greedy_atlas(
 	im_data.resize(result_size.x * result_size.y * sizeof(Color8));
 	{
 		Span<Color8> dst_data = Span<Color8>(reinterpret_cast<Color8 *>(im_data.ptrw()), result_size.x * result_size.y);
+		// Rows don't pack perfectly, leave gaps transparent
+		memset(dst_data.data(), 0, dst_data.size() * sizeof(Color8));
 
 		// For all rectangles
 		for (unsigned int i = 0; i < atlas_data.images.size(); ++i) {
 			const VoxelMesherCubes::GreedyAtlasData::ImageInfo &im = atlas_data.images[i];
 			const Vector2i dst_pos = result_points[i];
-			Span<const Color8> src_data =
-					to_span_from_position_and_size(atlas_data.colors, im.first_color_index, im.size_x * im.size_y);
+			const Color8 *src = atlas_data.colors.data() + im.first_color_index;
 
-			// Blit rectangle
+			// Blit rectangle row by row
 			for (unsigned int y = 0; y < im.size_y; ++y) {
-				for (unsigned int x = 0; x < im.size_x; ++x) {
-					const unsigned int src_i = x + y * im.size_x;
-					const unsigned int dst_i = (dst_pos.x + x) + (dst_pos.y + y) * result_size.x;
-					dst_data[dst_i] = src_data[src_i];
-				}
+				Color8 *dst = dst_data.data() + dst_pos.x + (dst_pos.y + y) * result_size.x;
+				memcpy(dst, src, im.size_x * sizeof(Color8));
+				src += im.size_x;
 			}
 		}
 	}
@@ -803,7 +786,7 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 								cache.arrays_per_material,
 								raw_channel,
 								block_size,
-								cache.mask_memory_pool,
+								cache.greedy_mask,
 								Color8::from_u8
 						);
 					} else {
@@ -819,7 +802,7 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 								cache.arrays_per_material,
 								raw_channel.reinterpret_cast_to<const uint16_t>(),
 								block_size,
-								cache.mask_memory_pool,
+								cache.greedy_mask,
 								Color8::from_u16
 						);
 					} else {
@@ -838,7 +821,7 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 								cache.arrays_per_material,
 								raw_channel.reinterpret_cast_to<const uint32_t>(),
 								block_size,
-								cache.mask_memory_pool,
+								cache.greedy_mask,
 								Color8::from_u32
 						);
 					} else {
@@ -880,17 +863,20 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 									cache.greedy_atlas_data,
 									raw_channel,
 									block_size,
-									cache.mask_memory_pool,
+									cache.greedy_mask,
 									get_color_from_palette
 							);
-							atlas_image =
-									make_greedy_atlas(cache.greedy_atlas_data, to_span(cache.arrays_per_material));
+							atlas_image = make_greedy_atlas(
+									cache.greedy_atlas_data,
+									cache.greedy_atlas_packer,
+									to_span(cache.arrays_per_material)
+							);
 						} else {
 							build_voxel_mesh_as_greedy_cubes(
 									cache.arrays_per_material,
 									raw_channel,
 									block_size,
-									cache.mask_memory_pool,
+									cache.greedy_mask,
 									get_color_from_palette
 							);
 						}
@@ -907,7 +893,7 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 								cache.arrays_per_material,
 								raw_channel.reinterpret_cast_to<const uint16_t>(),
 								block_size,
-								cache.mask_memory_pool,
+								cache.greedy_mask,
 								get_color_from_palette
 						);
 					} else {
@@ -945,7 +931,7 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 								cache.arrays_per_material,
 								raw_channel,
 								block_size,
-								cache.mask_memory_pool,
+								cache.greedy_mask,
 								get_index_from_palette
 						);
 					} else {
@@ -961,7 +947,7 @@ void VoxelMesherCubes::build(VoxelMesher::Output &output, const VoxelMesher::Inp
 								cache.arrays_per_material,
 								raw_channel.reinterpret_cast_to<const uint16_t>(),
 								block_size,
-								cache.mask_memory_pool,
+								cache.greedy_mask,
 								get_index_from_palette
 						);
 					} else {
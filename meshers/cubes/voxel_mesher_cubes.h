@@ -2,6 +2,7 @@
 #define VOXEL_MESHER_CUBES_H
 
 #include "../../util/math/vector2f.h"
+#include "../../util/math/vector2i.h"
 #include "../../util/math/vector3f.h"
 #include "../../util/thread/rw_lock.h"
 #include "../voxel_mesher.h"
@@ -111,6 +112,25 @@ public:
 		}
 	};
 
+	// Faces found in one deck of voxels during greedy meshing
+	struct GreedyMask {
+		// One bit per cell, set where there is a face that wasn't meshed yet. Each row starts on a new word, so rows
+		// can be tested and consumed with bitwise operations.
+		StdVector<uint64_t> bits;
+		// Per cell, identifies faces that can be merged together. Only valid where bits are set.
+		StdVector<uint64_t> keys;
+		// Per cell, only used when colors are stored in a texture
+		StdVector<Color8> colors;
+		// Alpha index of every voxel of the block, so colors don't have to be resolved again for each axis
+		StdVector<uint8_t> alpha_indices;
+	};
+
+	// Buffers used to pack greedy quad images into an atlas, kept around so they don't get reallocated every time
+	struct GreedyAtlasPacker {
+		StdVector<uint32_t> order;
+		StdVector<Vector2i> positions;
+	};
+
 private:
 	void _b_set_opaque_material(Ref<Material> material);
 	Ref<Material> _b_get_opaque_material() const;
@@ -129,8 +149,9 @@ private:
 
 	struct Cache {
 		FixedArray<Arrays, MATERIAL_COUNT> arrays_per_material;
-		StdVector<uint8_t> mask_memory_pool;
+		GreedyMask greedy_mask;
 		GreedyAtlasData greedy_atlas_data;
+		GreedyAtlasPacker greedy_atlas_packer;
 	};
 
 	// Parameters
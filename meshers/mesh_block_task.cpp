@@ -581,6 +581,17 @@ void MeshBlockTask::build_mesh() {
 		_has_mesh_resource = false;
 	}
 
+	if (collision_hint && require_collision_shape &&
+		VoxelEngine::get_singleton().is_threaded_collision_shape_building_enabled()) {
+		ZN_PROFILE_SCOPE_NAMED("Build collision shape");
+		// Can be null if there are no collidable surfaces
+		_collision_shape = make_collision_shape_from_mesher_output(_surfaces_output, **mesher);
+		_has_collision_shape_resource = true;
+
+	} else {
+		_has_collision_shape_resource = false;
+	}
+
 	_has_run = true;
 }
 
@@ -623,6 +634,8 @@ void MeshBlockTask::apply_result() {
 			o.mesh_material_indices = std::move(_mesh_material_indices);
 			o.has_mesh_resource = _has_mesh_resource;
 			o.visual_was_required = require_visual;
+			o.has_collision_shape_resource = _has_collision_shape_resource;
+			o.collision_shape = _collision_shape;
 			o.detail_textures = _detail_textures;
 
 			VoxelEngine::VolumeCallbacks callbacks = VoxelEngine::get_singleton().get_volume_callbacks(volume_id);
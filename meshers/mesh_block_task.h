@@ -48,6 +48,9 @@ public:
 	bool require_visual = true;
 	// If true, a collision mesh is required if possible
 	bool collision_hint = false;
+	// If true (and `collision_hint` too), the collision shape resource will be built in the task if the engine allows
+	// it, so the main thread only has to attach it to a physics body.
+	bool require_collision_shape = false;
 	// If true, the mesh will be used in a context with LOD, which might require a few extra things in the way it is
 	// built
 	bool lod_hint = false;
@@ -72,11 +75,13 @@ private:
 	bool _has_run = false;
 	bool _too_far = false;
 	bool _has_mesh_resource = false;
+	bool _has_collision_shape_resource = false;
 	uint8_t _stage = 0;
 	VoxelBuffer _voxels;
 	VoxelMesher::Output _surfaces_output;
 	Ref<Mesh> _mesh;
 	Ref<Mesh> _shadow_occluder_mesh;
+	Ref<Shape3D> _collision_shape;
 	StdVector<uint16_t> _mesh_material_indices; // Indexed by mesh surface
 	std::shared_ptr<DetailTextureOutput> _detail_textures;
 	StdVector<GenerateBlockGPUTaskResult> _gpu_generation_results;
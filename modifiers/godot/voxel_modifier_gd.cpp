@@ -23,8 +23,31 @@ zylann::voxel::VoxelModifierSdf::Operation to_op(VoxelModifier::Operation op) {
 	return zylann::voxel::VoxelModifierSdf::Operation(op);
 }
 
+namespace {
+
+Box3i get_voxel_box(const AABB &aabb) {
+	return Box3i::from_min_max(math::floor_to_int(aabb.position), math::ceil_to_int(aabb.position + aabb.size));
+}
+
+} // namespace
+
 void post_edit_modifier(VoxelLodTerrain &volume, AABB aabb) {
-	volume.post_edit_modifiers(Box3i(math::floor_to_int(aabb.position), math::floor_to_int(aabb.size)));
+	volume.post_edit_modifiers(get_voxel_box(aabb));
+}
+
+void post_edit_modifier_aabb_change(VoxelLodTerrain &volume, uint32_t modifier_id, AABB prev_aabb) {
+	VoxelModifierStack &modifiers = volume.get_storage().get_modifiers();
+	const zylann::voxel::VoxelModifier *modifier = modifiers.get_modifier(modifier_id);
+	ZN_ASSERT_RETURN(modifier != nullptr);
+	modifiers.update_modifier_aabb(modifier_id);
+
+	// The modifier changed where it is now, and where it was before. When it moves by small steps these areas
+	// overlap a lot, so the overlapping part is only updated once.
+	const Box3i new_box = get_voxel_box(modifier->get_aabb());
+	volume.post_edit_modifiers(new_box);
+	get_voxel_box(prev_aabb).difference(new_box, [&volume](const Box3i &left_box) { //
+		volume.post_edit_modifiers(left_box);
+	});
 }
 
 void VoxelModifier::set_operation(Operation op) {
@@ -66,9 +89,7 @@ void VoxelModifier::set_smoothness(float s) {
 	zylann::voxel::VoxelModifierSdf *sdf_modifier = static_cast<zylann::voxel::VoxelModifierSdf *>(modifier);
 	const AABB prev_aabb = modifier->get_aabb();
 	sdf_modifier->set_smoothness(_smoothness);
-	const AABB new_aabb = modifier->get_aabb();
-	post_edit_modifier(*_volume, prev_aabb);
-	post_edit_modifier(*_volume, new_aabb);
+	post_edit_modifier_aabb_change(*_volume, _modifier_id, prev_aabb);
 }
 
 float VoxelModifier::get_smoothness() const {
@@ -98,6 +119,7 @@ void VoxelModifier::_notification(int p_what) {
 				}
 
 				modifier->set_transform(get_transform());
+				modifiers.update_modifier_aabb(id);
 				_modifier_id = id;
 				// TODO Optimize: on loading of a scene, this could be very bad for performance because there could be,
 				// a lot of modifiers on the map, but there is no distinction possible in Godot at the moment...
@@ -127,11 +149,14 @@ void VoxelModifier::_notification(int p_what) {
 				zylann::voxel::VoxelModifier *modifier = modifiers.get_modifier(_modifier_id);
 				ZN_ASSERT_RETURN(modifier != nullptr);
 
+				const Transform3D transform = get_transform();
+				if (modifier->get_transform() == transform) {
+					break;
+				}
+
 				const AABB prev_aabb = modifier->get_aabb();
-				modifier->set_transform(get_transform());
-				const AABB aabb = modifier->get_aabb();
-				post_edit_modifier(*_volume, prev_aabb);
-				post_edit_modifier(*_volume, aabb);
+				modifier->set_transform(transform);
+				post_edit_modifier_aabb_change(*_volume, _modifier_id, prev_aabb);
 
 				// TODO Handle nesting properly, though it's a pain in the ass
 				// When the terrain is moved, the local transform of modifiers technically changes too.
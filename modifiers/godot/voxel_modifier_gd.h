@@ -55,6 +55,8 @@ private:
 // Helpers
 
 void post_edit_modifier(VoxelLodTerrain &volume, AABB aabb);
+// Must be used after a property of a modifier affecting its AABB has changed.
+void post_edit_modifier_aabb_change(VoxelLodTerrain &volume, uint32_t modifier_id, AABB prev_aabb);
 
 template <typename T>
 T *get_modifier(VoxelLodTerrain &volume, uint32_t id, zylann::voxel::VoxelModifier::Type type) {
@@ -26,9 +26,7 @@ void VoxelModifierMesh::set_mesh_sdf(Ref<VoxelMeshSDF> mesh_sdf) {
 	ZN_ASSERT_RETURN(modifier != nullptr);
 	const AABB prev_aabb = modifier->get_aabb();
 	modifier->set_mesh_sdf(_mesh_sdf);
-	const AABB new_aabb = modifier->get_aabb();
-	post_edit_modifier(*_volume, prev_aabb);
-	post_edit_modifier(*_volume, new_aabb);
+	post_edit_modifier_aabb_change(*_volume, _modifier_id, prev_aabb);
 	update_configuration_warnings();
 }
 
@@ -69,9 +67,7 @@ void VoxelModifierMesh::_on_mesh_sdf_baked() {
 	ZN_ASSERT_RETURN(modifier != nullptr);
 	const AABB prev_aabb = modifier->get_aabb();
 	modifier->set_mesh_sdf(_mesh_sdf);
-	const AABB new_aabb = modifier->get_aabb();
-	post_edit_modifier(*_volume, prev_aabb);
-	post_edit_modifier(*_volume, new_aabb);
+	post_edit_modifier_aabb_change(*_volume, _modifier_id, prev_aabb);
 	update_configuration_warnings();
 }
 
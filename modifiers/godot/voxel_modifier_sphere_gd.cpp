@@ -20,9 +20,7 @@ void VoxelModifierSphere::set_radius(float r) {
 	ZN_ASSERT_RETURN(sphere != nullptr);
 	const AABB prev_aabb = sphere->get_aabb();
 	sphere->set_radius(r);
-	const AABB new_aabb = sphere->get_aabb();
-	post_edit_modifier(*_volume, prev_aabb);
-	post_edit_modifier(*_volume, new_aabb);
+	post_edit_modifier_aabb_change(*_volume, _modifier_id, prev_aabb);
 }
 
 zylann::voxel::VoxelModifier *VoxelModifierSphere::create(zylann::voxel::VoxelModifierStack &modifiers, uint32_t id) {
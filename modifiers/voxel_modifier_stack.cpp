@@ -2,6 +2,7 @@
 #include "../edition/funcs.h"
 #include "../util/dstack.h"
 #include "../util/profiling.h"
+#include <algorithm>
 
 namespace zylann::voxel {
 
@@ -60,56 +61,154 @@ Span<const Vector3f> get_positions_temporary(
 	return positions;
 }
 
-// TODO Use VoxelBuffer helper function
-void decompress_sdf_to_buffer(VoxelBuffer &voxels, StdVector<float> &sdf) {
+// Calls `f(buffer_index, area_index)` for each voxel of an area of a buffer. Both are indices in ZXY order.
+template <typename F>
+inline void for_each_area_index(const Vector3i buffer_size, const Box3i area, F f) {
+	unsigned int area_index = 0;
+	const Vector3i area_end = area.position + area.size;
+	for (int z = area.position.z; z < area_end.z; ++z) {
+		for (int x = area.position.x; x < area_end.x; ++x) {
+			unsigned int buffer_index = Vector3iUtil::get_zxy_index(Vector3i(x, area.position.y, z), buffer_size);
+			for (int y = 0; y < area.size.y; ++y) {
+				f(buffer_index, area_index);
+				++buffer_index;
+				++area_index;
+			}
+		}
+	}
+}
+
+// Decodes SDF values of an area of the buffer to floats, in ZXY order.
+void decode_sdf_area(const VoxelBuffer &voxels, const Box3i area, StdVector<float> &sdf) {
+	ZN_DSTACK();
+
+	sdf.resize(Vector3iUtil::get_volume(area.size));
+
+	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_SDF;
+
+	if (voxels.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_UNIFORM) {
+		const float v = voxels.get_voxel_f(0, 0, 0, channel);
+		for (float &d : sdf) {
+			d = v;
+		}
+		return;
+	}
+
+	const VoxelBuffer::Depth depth = voxels.get_channel_depth(channel);
+	const float inv_scale = 1.0f / VoxelBuffer::get_sdf_quantization_scale(depth);
+	const Vector3i buffer_size = voxels.get_size();
+
+	switch (depth) {
+		case VoxelBuffer::DEPTH_8_BIT: {
+			Span<const int8_t> raw;
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				sdf[ai] = s8_to_snorm(raw[bi]) * inv_scale;
+			});
+		} break;
+
+		case VoxelBuffer::DEPTH_16_BIT: {
+			Span<const int16_t> raw;
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				sdf[ai] = s16_to_snorm(raw[bi]) * inv_scale;
+			});
+		} break;
+
+		case VoxelBuffer::DEPTH_32_BIT: {
+			Span<const float> raw;
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				sdf[ai] = raw[bi];
+			});
+		} break;
+
+		case VoxelBuffer::DEPTH_64_BIT: {
+			Span<const double> raw;
+			ZN_ASSERT(voxels.get_channel_data_read_only(channel, raw));
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				sdf[ai] = raw[bi];
+			});
+		} break;
+
+		default:
+			ZN_CRASH();
+	}
+}
+
+// Encodes back SDF values of an area of the buffer, only where they differ from the comparand. Encoding is lossy, so
+// this avoids introducing tiny changes where modifiers did nothing.
+// Returns true if any value was modified.
+bool encode_sdf_area_if_modified(
+		VoxelBuffer &voxels,
+		const Box3i area,
+		Span<const float> sdf,
+		Span<const float> comparand
+) {
 	ZN_DSTACK();
+	ZN_ASSERT(sdf.size() == comparand.size());
 
-	sdf.resize(Vector3iUtil::get_volume(voxels.get_size()));
+	bool modified = false;
+	for (unsigned int i = 0; i < sdf.size(); ++i) {
+		if (sdf[i] != comparand[i]) {
+			modified = true;
+			break;
+		}
+	}
+	// Uniform channels don't get decompressed if nothing changed
+	if (!modified) {
+		return false;
+	}
 
 	const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_SDF;
 	voxels.decompress_channel(channel);
 
 	const VoxelBuffer::Depth depth = voxels.get_channel_depth(channel);
+	const float scale = VoxelBuffer::get_sdf_quantization_scale(depth);
+	const Vector3i buffer_size = voxels.get_size();
 
 	switch (depth) {
 		case VoxelBuffer::DEPTH_8_BIT: {
 			Span<int8_t> raw;
 			ZN_ASSERT(voxels.get_channel_data(channel, raw));
-			for (unsigned int i = 0; i < sdf.size(); ++i) {
-				sdf[i] = s8_to_snorm(raw[i]);
-			}
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				if (sdf[ai] != comparand[ai]) {
+					raw[bi] = snorm_to_s8(sdf[ai] * scale);
+				}
+			});
 		} break;
 
 		case VoxelBuffer::DEPTH_16_BIT: {
 			Span<int16_t> raw;
 			ZN_ASSERT(voxels.get_channel_data(channel, raw));
-			for (unsigned int i = 0; i < sdf.size(); ++i) {
-				sdf[i] = s16_to_snorm(raw[i]);
-			}
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				if (sdf[ai] != comparand[ai]) {
+					raw[bi] = snorm_to_s16(sdf[ai] * scale);
+				}
+			});
 		} break;
 
 		case VoxelBuffer::DEPTH_32_BIT: {
 			Span<float> raw;
 			ZN_ASSERT(voxels.get_channel_data(channel, raw));
-			memcpy(sdf.data(), raw.data(), sizeof(float) * sdf.size());
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				raw[bi] = sdf[ai];
+			});
 		} break;
 
 		case VoxelBuffer::DEPTH_64_BIT: {
 			Span<double> raw;
 			ZN_ASSERT(voxels.get_channel_data(channel, raw));
-			for (unsigned int i = 0; i < sdf.size(); ++i) {
-				sdf[i] = raw[i];
-			}
+			for_each_area_index(buffer_size, area, [&](unsigned int bi, unsigned int ai) {
+				raw[bi] = sdf[ai];
+			});
 		} break;
 
 		default:
 			ZN_CRASH();
 	}
 
-	const float inv_scale = 1.0f / VoxelBuffer::get_sdf_quantization_scale(depth);
-	for (unsigned int i = 0; i < sdf.size(); ++i) {
-		sdf[i] *= inv_scale;
-	}
+	return true;
 }
 
 } // namespace
@@ -132,21 +231,35 @@ void VoxelModifierStack::move_from_noclear(VoxelModifierStack &other) {
 		RWLockRead rlock(other._stack_lock);
 		_modifiers = std::move(other._modifiers);
 		_stack = std::move(other._stack);
+		_tree = std::move(other._tree);
 	}
 	_next_id = other._next_id;
+	_next_order = other._next_order;
 }
 
 uint32_t VoxelModifierStack::allocate_id() {
 	return ++_next_id;
 }
 
+void VoxelModifierStack::add_modifier_internal(uint32_t id, UniquePtr<VoxelModifier> &&modifier) {
+	RWLockWrite lock(_stack_lock);
+	VoxelModifier *ptr = modifier.get();
+	Entry &entry = _modifiers[id];
+	entry.tree_id = _tree.add(ptr->get_aabb(), id);
+	entry.order = _next_order++;
+	entry.modifier = std::move(modifier);
+	_stack.push_back(ptr);
+}
+
 void VoxelModifierStack::remove_modifier(uint32_t id) {
 	RWLockWrite lock(_stack_lock);
 
 	auto map_it = _modifiers.find(id);
 	ZN_ASSERT_RETURN(map_it != _modifiers.end());
 
-	const VoxelModifier *ptr = map_it->second.get();
+	_tree.remove(map_it->second.tree_id);
+
+	const VoxelModifier *ptr = map_it->second.modifier.get();
 	for (auto stack_it = _stack.begin(); stack_it != _stack.end(); ++stack_it) {
 		if (*stack_it == ptr) {
 			_stack.erase(stack_it);
@@ -164,11 +277,41 @@ bool VoxelModifierStack::has_modifier(uint32_t id) const {
 VoxelModifier *VoxelModifierStack::get_modifier(uint32_t id) const {
 	auto it = _modifiers.find(id);
 	if (it != _modifiers.end()) {
-		return it->second.get();
+		return it->second.modifier.get();
 	}
 	return nullptr;
 }
 
+void VoxelModifierStack::update_modifier_aabb(uint32_t id) {
+	RWLockWrite lock(_stack_lock);
+	auto it = _modifiers.find(id);
+	ZN_ASSERT_RETURN(it != _modifiers.end());
+	const Entry &entry = it->second;
+	_tree.set_aabb(entry.tree_id, entry.modifier->get_aabb());
+}
+
+void VoxelModifierStack::get_modifiers_in_aabb(const AABB &aabb, StdVector<VoxelModifier *> &out_modifiers) const {
+	struct Item {
+		uint32_t order;
+		VoxelModifier *modifier;
+	};
+	thread_local StdVector<Item> tls_items;
+	StdVector<Item> &items = tls_items;
+	items.clear();
+
+	_tree.query(aabb, [this, &items](uint32_t id) {
+		auto it = _modifiers.find(id);
+		ZN_ASSERT(it != _modifiers.end());
+		items.push_back(Item{ it->second.order, it->second.modifier.get() });
+	});
+
+	std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) { return a.order < b.order; });
+
+	for (const Item &item : items) {
+		out_modifiers.push_back(item.modifier);
+	}
+}
+
 void VoxelModifierStack::apply(VoxelBuffer &voxels, AABB aabb) const {
 	ZN_PROFILE_SCOPE();
 	RWLockRead lock(_stack_lock);
@@ -177,8 +320,14 @@ void VoxelModifierStack::apply(VoxelBuffer &voxels, AABB aabb) const {
 		return;
 	}
 
-	VoxelModifierContext ctx;
-	bool any_intersection = false;
+	thread_local StdVector<VoxelModifier *> tls_modifiers;
+	StdVector<VoxelModifier *> &modifiers = tls_modifiers;
+	modifiers.clear();
+	get_modifiers_in_aabb(aabb, modifiers);
+
+	if (modifiers.size() == 0) {
+		return;
+	}
 
 	// This version can be slower because we are trying to workaround a side-effect of fixed-point compression.
 	// Processing through the whole block is easier, but it can introduce artifacts because scaling and applying
@@ -188,79 +337,106 @@ void VoxelModifierStack::apply(VoxelBuffer &voxels, AABB aabb) const {
 	// modify only the area that intersects the block, and we re-encode only what was modified.
 	// Another option later could be to use uncompressed blocks (32-bit float) when doing on-the-fly sampling?
 
-	thread_local StdVector<float> tls_block_sdf_initial;
-	thread_local StdVector<float> tls_block_sdf;
-
-	StdVector<float> &area_sdf = get_tls_sdf();
-	StdVector<Vector3f> &area_positions = get_tls_positions();
-
 	const Vector3 v_to_w = aabb.size / Vector3(voxels.get_size());
 	const Vector3 w_to_v = Vector3(voxels.get_size()) / aabb.size;
 	const Vector3i origin_voxels = Vector3i(math::floor(aabb.position * w_to_v));
+	const Box3i block_box(origin_voxels, voxels.get_size());
 
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		const VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
+	// Get modifier bounds in voxels. Only the area they cover gets decoded and encoded back.
+	thread_local StdVector<Box3i> tls_modifier_boxes;
+	StdVector<Box3i> &modifier_boxes = tls_modifier_boxes;
+	modifier_boxes.clear();
+	Box3i area_box;
 
+	for (const VoxelModifier *modifier : modifiers) {
 		const AABB modifier_aabb = modifier->get_aabb();
-		if (modifier_aabb.intersects(aabb)) {
-			ZN_PROFILE_SCOPE_NAMED("Intersecting modifier");
+		Box3i modifier_box(math::floor(modifier_aabb.position * w_to_v), math::ceil(modifier_aabb.size * w_to_v));
+		modifier_box.clip(block_box);
+		if (modifier_box.is_empty()) {
+			modifier_box = Box3i();
+		} else if (area_box.is_empty()) {
+			area_box = modifier_box;
+		} else {
+			area_box.merge_with(modifier_box);
+		}
+		modifier_boxes.push_back(modifier_box);
+	}
+
+	if (area_box.is_empty()) {
+		return;
+	}
 
-			if (any_intersection == false) {
-				ZN_PROFILE_SCOPE_NAMED("Read block");
-				any_intersection = true;
+	const Box3i local_area_box(area_box.position - origin_voxels, area_box.size);
 
-				decompress_sdf_to_buffer(voxels, tls_block_sdf_initial);
+	thread_local StdVector<float> tls_area_sdf_initial;
+	thread_local StdVector<float> tls_area_sdf;
 
-				tls_block_sdf.resize(tls_block_sdf_initial.size());
-				memcpy(tls_block_sdf.data(), tls_block_sdf_initial.data(), tls_block_sdf.size() * sizeof(float));
-			}
+	{
+		ZN_PROFILE_SCOPE_NAMED("Read area");
+		decode_sdf_area(voxels, local_area_box, tls_area_sdf_initial);
+		tls_area_sdf = tls_area_sdf_initial;
+	}
 
-			// Get modifier bounds in voxels
-			Box3i modifier_box(math::floor(modifier_aabb.position * w_to_v), math::ceil(modifier_aabb.size * w_to_v));
-			modifier_box.clip(Box3i(origin_voxels, voxels.get_size()));
-			const Vector3i local_origin_in_voxels = modifier_box.position - origin_voxels;
-
-			const int64_t volume = Vector3iUtil::get_volume(modifier_box.size);
-			area_sdf.resize(volume);
-			copy_3d_region_zxy(
-					to_span(area_sdf),
-					modifier_box.size,
-					Vector3i(),
-					to_span_const(tls_block_sdf),
-					voxels.get_size(),
-					local_origin_in_voxels,
-					local_origin_in_voxels + modifier_box.size
-			);
-
-			get_positions_buffer(
-					modifier_box.size,
-					to_vec3f(v_to_w * modifier_box.position),
-					to_vec3f(v_to_w * modifier_box.size),
-					area_positions
-			);
-
-			ctx.positions = to_span(area_positions);
-			ctx.sdf = to_span(area_sdf);
-			modifier->apply(ctx);
+	StdVector<float> &modifier_sdf = get_tls_sdf();
+	StdVector<Vector3f> &modifier_positions = get_tls_positions();
+
+	VoxelModifierContext ctx;
+
+	for (unsigned int i = 0; i < modifiers.size(); ++i) {
+		const VoxelModifier *modifier = modifiers[i];
+		ZN_ASSERT(modifier != nullptr);
 
-			// Write modifications back to the full-block decompressed buffer
-			// TODO Maybe use an unchecked version for a bit more speed?
-			copy_3d_region_zxy(
-					to_span(tls_block_sdf),
-					voxels.get_size(),
-					local_origin_in_voxels,
-					Span<const float>(ctx.sdf),
-					modifier_box.size,
-					Vector3i(),
-					modifier_box.size
-			);
+		const Box3i &modifier_box = modifier_boxes[i];
+		if (modifier_box.is_empty()) {
+			continue;
 		}
+
+		ZN_PROFILE_SCOPE_NAMED("Intersecting modifier");
+
+		get_positions_buffer(
+				modifier_box.size,
+				to_vec3f(v_to_w * modifier_box.position),
+				to_vec3f(v_to_w * modifier_box.size),
+				modifier_positions
+		);
+		ctx.positions = to_span(modifier_positions);
+
+		if (modifier_box == area_box) {
+			// Common when there is a single modifier, the area can be modified directly
+			ctx.sdf = to_span(tls_area_sdf);
+			modifier->apply(ctx);
+			continue;
+		}
+
+		const Vector3i origin_in_area = modifier_box.position - area_box.position;
+
+		modifier_sdf.resize(Vector3iUtil::get_volume(modifier_box.size));
+		copy_3d_region_zxy(
+				to_span(modifier_sdf),
+				modifier_box.size,
+				Vector3i(),
+				to_span_const(tls_area_sdf),
+				area_box.size,
+				origin_in_area,
+				origin_in_area + modifier_box.size
+		);
+
+		ctx.sdf = to_span(modifier_sdf);
+		modifier->apply(ctx);
+
+		// Write modifications back to the area buffer
+		copy_3d_region_zxy(
+				to_span(tls_area_sdf),
+				area_box.size,
+				origin_in_area,
+				Span<const float>(ctx.sdf),
+				modifier_box.size,
+				Vector3i(),
+				modifier_box.size
+		);
 	}
 
-	if (any_intersection) {
-		// scale_and_store_sdf(voxels, to_span(tls_block_sdf));
-		scale_and_store_sdf_if_modified(voxels, to_span(tls_block_sdf), to_span(tls_block_sdf_initial));
+	if (encode_sdf_area_if_modified(voxels, local_area_box, to_span(tls_area_sdf), to_span(tls_area_sdf_initial))) {
 		voxels.compress_uniform_channels();
 	}
 }
@@ -279,13 +455,12 @@ void VoxelModifierStack::apply(float &sdf, Vector3f position) const {
 
 	const AABB aabb(to_vec3(position), Vector3(1, 1, 1));
 
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		const VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
+	thread_local StdVector<VoxelModifier *> tls_modifiers;
+	tls_modifiers.clear();
+	get_modifiers_in_aabb(aabb, tls_modifiers);
 
-		if (modifier->get_aabb().intersects(aabb)) {
-			modifier->apply(ctx);
-		}
+	for (const VoxelModifier *modifier : tls_modifiers) {
+		modifier->apply(ctx);
 	}
 }
 
@@ -310,13 +485,12 @@ void VoxelModifierStack::apply(
 
 	const AABB aabb(to_vec3(min_pos), to_vec3(max_pos - min_pos));
 
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		const VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
+	thread_local StdVector<VoxelModifier *> tls_modifiers;
+	tls_modifiers.clear();
+	get_modifiers_in_aabb(aabb, tls_modifiers);
 
-		if (modifier->get_aabb().intersects(aabb)) {
-			modifier->apply(ctx);
-		}
+	for (const VoxelModifier *modifier : tls_modifiers) {
+		modifier->apply(ctx);
 	}
 }
 
@@ -332,16 +506,15 @@ void VoxelModifierStack::apply_for_gpu_rendering(
 		return;
 	}
 
-	for (unsigned int i = 0; i < _stack.size(); ++i) {
-		VoxelModifier *modifier = _stack[i];
-		ZN_ASSERT(modifier != nullptr);
+	thread_local StdVector<VoxelModifier *> tls_modifiers;
+	tls_modifiers.clear();
+	get_modifiers_in_aabb(aabb, tls_modifiers);
 
-		if (modifier->get_aabb().intersects(aabb)) {
-			VoxelModifier::ShaderData sd;
-			modifier->get_shader_data(sd);
-			if (sd.shader_rids[type].is_valid()) {
-				out_data.push_back(sd);
-			}
+	for (VoxelModifier *modifier : tls_modifiers) {
+		VoxelModifier::ShaderData sd;
+		modifier->get_shader_data(sd);
+		if (sd.shader_rids[type].is_valid()) {
+			out_data.push_back(sd);
 		}
 	}
 }
@@ -350,6 +523,7 @@ void VoxelModifierStack::clear() {
 	RWLockWrite lock(_stack_lock);
 	_stack.clear();
 	_modifiers.clear();
+	_tree.clear();
 }
 
 } // namespace zylann::voxel
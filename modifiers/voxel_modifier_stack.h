@@ -1,6 +1,7 @@
 #ifndef VOXEL_MODIFIER_STACK_H
 #define VOXEL_MODIFIER_STACK_H
 
+#include "../util/containers/dynamic_aabb_tree.h"
 #include "../util/containers/std_unordered_map.h"
 #include "../util/containers/std_vector.h"
 #include "../util/math/vector3f.h"
@@ -23,15 +24,16 @@ public:
 	template <typename T>
 	T *add_modifier(uint32_t id) {
 		ZN_ASSERT(!has_modifier(id));
-		UniquePtr<VoxelModifier> &uptr = _modifiers[id];
-		uptr = make_unique_instance<T>();
-		VoxelModifier *ptr = uptr.get();
-		RWLockWrite lock(_stack_lock);
-		_stack.push_back(ptr);
-		return static_cast<T *>(ptr);
+		UniquePtr<VoxelModifier> uptr = make_unique_instance<T>();
+		T *ptr = static_cast<T *>(uptr.get());
+		add_modifier_internal(id, std::move(uptr));
+		return ptr;
 	}
 
 	void remove_modifier(uint32_t id);
+	// Must be called after changing properties of a modifier affecting its AABB, such as its transform, so it can be
+	// found by spatial queries.
+	void update_modifier_aabb(uint32_t id);
 	bool has_modifier(uint32_t id) const;
 	VoxelModifier *get_modifier(uint32_t id) const;
 	void apply(VoxelBuffer &voxels, AABB aabb) const;
@@ -63,12 +65,27 @@ public:
 	}
 
 private:
+	struct Entry {
+		UniquePtr<VoxelModifier> modifier;
+		// Item of the modifier in `_tree`
+		uint32_t tree_id;
+		// Modifiers are applied in the order they were added
+		uint32_t order;
+	};
+
 	void move_from_noclear(VoxelModifierStack &other);
+	void add_modifier_internal(uint32_t id, UniquePtr<VoxelModifier> &&modifier);
+
+	// Gets modifiers intersecting an AABB, in the order they must be applied. `_stack_lock` must be locked.
+	void get_modifiers_in_aabb(const AABB &aabb, StdVector<VoxelModifier *> &out_modifiers) const;
 
-	StdUnorderedMap<uint32_t, UniquePtr<VoxelModifier>> _modifiers;
+	StdUnorderedMap<uint32_t, Entry> _modifiers;
 	uint32_t _next_id = 1;
-	// TODO Later, replace this with a spatial acceleration structure based on AABBs, like BVH
+	uint32_t _next_order = 0;
 	StdVector<VoxelModifier *> _stack;
+	// Spatial index of modifiers, holding their IDs. With a lot of modifiers, most of them are far from the area being
+	// processed, so this avoids checking all of them.
+	DynamicAABBTree _tree;
 	RWLock _stack_lock;
 };
 
@@ -349,7 +349,7 @@ void initialize_voxel_module(ModuleInitializationLevel p_level) {
 #if defined(ZN_GODOT)
 		// RenderingServer can be null with `tests=yes`.
 		// TODO There is no hook to integrate modules to Godot's test framework, update this when it gets improved
-		if (RenderingServer::get_singleton() != nullptr) {
+		if (RenderingServer::get_singleton() != nullptr && !VoxelEngine::get_singleton().is_headless()) {
 			// TODO Enhancement: threaded graphics resource building should be initialized better.
 			// Pick this from the current renderer + user option (at time of writing, Godot 4 has only one
 			// renderer and has not figured out how such option would be exposed). Could use
@@ -376,12 +376,14 @@ void initialize_voxel_module(ModuleInitializationLevel p_level) {
 #ifdef VOXEL_TESTS
 		const PackedStringArray command_line_arguments = zylann::godot::get_command_line_arguments();
 		const String tests_cmd = "--run_voxel_tests";
+		const String benchmarks_cmd = "--run_voxel_benchmarks";
 
 		for (int i = 0; i < command_line_arguments.size(); ++i) {
 			const String arg = command_line_arguments[i];
 			if (arg == tests_cmd) {
 				zylann::voxel::tests::run_voxel_tests();
-				break;
+			} else if (arg == benchmarks_cmd) {
+				zylann::voxel::tests::run_voxel_benchmarks();
 			}
 		}
 #endif
@@ -0,0 +1,189 @@
+#include "voxel_metadata_map.h"
+#include "../../util/errors.h"
+
+namespace zylann::voxel {
+
+VoxelMetadataMap &VoxelMetadataMap::operator=(VoxelMetadataMap &&other) {
+	_keys = std::move(other._keys);
+	_slots = std::move(other._slots);
+	_values = std::move(other._values);
+	_free_slots = std::move(other._free_slots);
+	_occupied_cells = std::move(other._occupied_cells);
+	_buffer_size = other._buffer_size;
+	_cells_size = other._cells_size;
+	// Leave the other map in a valid empty state
+	other.create(other._buffer_size);
+	return *this;
+}
+
+void VoxelMetadataMap::create(Vector3i buffer_size) {
+	_keys.clear();
+	_slots.clear();
+	_values.clear();
+	_free_slots.clear();
+	_occupied_cells.resize_no_init(0);
+	_buffer_size = buffer_size;
+	_cells_size = math::ceildiv(buffer_size, CELL_SIZE);
+}
+
+void VoxelMetadataMap::clear() {
+	_keys.clear();
+	_slots.clear();
+	_values.clear();
+	_free_slots.clear();
+	_occupied_cells.fill(false);
+}
+
+size_t VoxelMetadataMap::lower_bound(uint64_t key) const {
+	size_t begin = 0;
+	size_t end = _keys.size();
+	while (begin < end) {
+		const size_t mid = (begin + end) / 2;
+		if (_keys[mid] < key) {
+			begin = mid + 1;
+		} else {
+			end = mid;
+		}
+	}
+	return begin;
+}
+
+const VoxelMetadata *VoxelMetadataMap::find(Vector3i pos) const {
+	const uint64_t key = get_key(pos);
+	const size_t i = lower_bound(key);
+	if (i < _keys.size() && _keys[i] == key) {
+		return &_values[_slots[i]];
+	}
+	return nullptr;
+}
+
+VoxelMetadata *VoxelMetadataMap::find(Vector3i pos) {
+	const uint64_t key = get_key(pos);
+	const size_t i = lower_bound(key);
+	if (i < _keys.size() && _keys[i] == key) {
+		return &_values[_slots[i]];
+	}
+	return nullptr;
+}
+
+VoxelMetadata &VoxelMetadataMap::get_or_create(Vector3i pos) {
+#ifdef DEBUG_ENABLED
+	ZN_ASSERT(Box3i(Vector3i(), _buffer_size).contains(pos));
+#endif
+	return get_or_create_from_key(get_key(pos));
+}
+
+VoxelMetadata &VoxelMetadataMap::get_or_create_from_key(uint64_t key) {
+#ifdef DEBUG_ENABLED
+	ZN_ASSERT(is_key_valid(key));
+#endif
+	// Entries are often inserted in key order (when deserializing or copying), so check the end first
+	size_t i;
+	if (_keys.size() == 0 || _keys.back() < key) {
+		i = _keys.size();
+	} else {
+		i = lower_bound(key);
+		if (_keys[i] == key) {
+			return _values[_slots[i]];
+		}
+	}
+
+	const uint32_t slot = allocate_slot();
+	_keys.insert(_keys.begin() + i, key);
+	_slots.insert(_slots.begin() + i, slot);
+
+	if (_occupied_cells.size() == 0) {
+		_occupied_cells.resize_no_init(Vector3iUtil::get_volume(_cells_size));
+		_occupied_cells.fill(false);
+	}
+	_occupied_cells.set(key >> CELL_VOLUME_PO2);
+
+	return _values[slot];
+}
+
+bool VoxelMetadataMap::erase(Vector3i pos) {
+	const uint64_t key = get_key(pos);
+	const size_t i = lower_bound(key);
+	if (i == _keys.size() || _keys[i] != key) {
+		return false;
+	}
+
+	free_slot(_slots[i]);
+	_keys.erase(_keys.begin() + i);
+	_slots.erase(_slots.begin() + i);
+
+	// Entries of the same cell are contiguous, so only neighbors can tell if the cell is still occupied
+	const uint64_t cell_index = key >> CELL_VOLUME_PO2;
+	const bool occupied_before = i > 0 && (_keys[i - 1] >> CELL_VOLUME_PO2) == cell_index;
+	const bool occupied_after = i < _keys.size() && (_keys[i] >> CELL_VOLUME_PO2) == cell_index;
+	if (!occupied_before && !occupied_after) {
+		_occupied_cells.unset(cell_index);
+	}
+
+	return true;
+}
+
+void VoxelMetadataMap::remove_in_area(Box3i box) {
+	remove_if([&box](Vector3i pos, const VoxelMetadata &meta) { //
+		return box.contains(pos);
+	});
+}
+
+void VoxelMetadataMap::copy_from(const VoxelMetadataMap &other) {
+	ZN_ASSERT_RETURN(other._buffer_size == _buffer_size);
+
+	for (size_t i = 0; i < other._keys.size(); ++i) {
+		VoxelMetadata &meta = get_or_create_from_key(other._keys[i]);
+		meta.copy_from(other._values[other._slots[i]]);
+	}
+}
+
+Vector3i VoxelMetadataMap::get_position(uint64_t key) const {
+	const unsigned int local_index = key & (CELL_VOLUME - 1);
+	const uint64_t cell_index = key >> CELL_VOLUME_PO2;
+
+	const uint64_t cell_xz = cell_index / _cells_size.y;
+	const Vector3i cpos(cell_xz % _cells_size.x, cell_index % _cells_size.y, cell_xz / _cells_size.x);
+
+	const Vector3i local_pos( //
+			(local_index >> CELL_SIZE_PO2) & CELL_MASK, //
+			local_index & CELL_MASK, //
+			local_index >> (2 * CELL_SIZE_PO2)
+	);
+
+	return (cpos << CELL_SIZE_PO2) + local_pos;
+}
+
+bool VoxelMetadataMap::is_key_valid(uint64_t key) const {
+	const uint64_t cell_index = key >> CELL_VOLUME_PO2;
+	if (cell_index >= static_cast<uint64_t>(Vector3iUtil::get_volume(_cells_size))) {
+		return false;
+	}
+	// Cells on the upper borders can be partially outside the buffer
+	return Box3i(Vector3i(), _buffer_size).contains(get_position(key));
+}
+
+uint32_t VoxelMetadataMap::allocate_slot() {
+	if (_free_slots.size() > 0) {
+		const uint32_t slot = _free_slots.back();
+		_free_slots.pop_back();
+		return slot;
+	}
+	const uint32_t slot = _values.size();
+	_values.emplace_back();
+	return slot;
+}
+
+void VoxelMetadataMap::free_slot(uint32_t slot) {
+	_values[slot].clear();
+	_free_slots.push_back(slot);
+}
+
+void VoxelMetadataMap::update_occupied_cells() {
+	_occupied_cells.fill(false);
+	for (const uint64_t key : _keys) {
+		_occupied_cells.set(key >> CELL_VOLUME_PO2);
+	}
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,185 @@
+#ifndef VOXEL_METADATA_MAP_H
+#define VOXEL_METADATA_MAP_H
+
+#include "../../util/containers/dynamic_bitset.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/math/box3i.h"
+#include "voxel_metadata.h"
+
+namespace zylann::voxel {
+
+// Sparse storage of metadata attached to individual voxels of a buffer.
+//
+// Entries are keyed by a packed index of their position. The buffer is divided in cells of 4x4x4 voxels: high bits of
+// the key index the cell (in ZXY order), and the 6 low bits index the voxel within that cell (also in ZXY order).
+// Keys are kept sorted, so entries of the same cell are contiguous, and a bitset tells which cells contain at least
+// one entry. Area queries only visit occupied cells overlapping the area, and entries within them.
+//
+// Keys are stored separately from values, so searches don't touch metadata. Each key refers to a slot in the value
+// array. Inserting or erasing entries only shifts keys and slot indices, values are not moved around to stay sorted.
+// Erased slots are reused. Values are not stable in memory though: adding a slot can reallocate the array, so pointers
+// and references returned by `find` and `get_or_create` may be invalidated by later insertions.
+class VoxelMetadataMap {
+public:
+	static const unsigned int CELL_SIZE_PO2 = 2;
+	static const unsigned int CELL_SIZE = 1 << CELL_SIZE_PO2;
+	static const unsigned int CELL_MASK = CELL_SIZE - 1;
+	static const unsigned int CELL_VOLUME_PO2 = 3 * CELL_SIZE_PO2;
+	static const unsigned int CELL_VOLUME = 1 << CELL_VOLUME_PO2;
+
+	VoxelMetadataMap() {}
+
+	VoxelMetadataMap(VoxelMetadataMap &&other) {
+		*this = std::move(other);
+	}
+
+	VoxelMetadataMap &operator=(VoxelMetadataMap &&other);
+
+	// Removes all entries and sets the size of the buffer positions will be in.
+	void create(Vector3i buffer_size);
+	// Removes all entries.
+	void clear();
+
+	inline Vector3i get_buffer_size() const {
+		return _buffer_size;
+	}
+
+	inline unsigned int size() const {
+		return _keys.size();
+	}
+
+	const VoxelMetadata *find(Vector3i pos) const;
+	VoxelMetadata *find(Vector3i pos);
+
+	// Returns metadata at the given position, inserting an empty one if none was present.
+	// The position must be inside the buffer.
+	VoxelMetadata &get_or_create(Vector3i pos);
+
+	// Returns true if an entry was removed.
+	bool erase(Vector3i pos);
+
+	// Replaces entries with copies of those from another map of the same buffer size.
+	void copy_from(const VoxelMetadataMap &other);
+
+	// Keys are exposed so serialization can store them compactly. They are ordered, and can only be used with maps of
+	// the same buffer size.
+
+	inline uint64_t get_key(Vector3i pos) const {
+		const Vector3i cpos = pos >> CELL_SIZE_PO2;
+		const uint64_t cell_index = get_cell_index(cpos);
+		const unsigned int local_index = (pos.y & CELL_MASK) //
+				| ((pos.x & CELL_MASK) << CELL_SIZE_PO2) //
+				| ((pos.z & CELL_MASK) << (2 * CELL_SIZE_PO2));
+		return (cell_index << CELL_VOLUME_PO2) | local_index;
+	}
+
+	Vector3i get_position(uint64_t key) const;
+
+	// Returns true if the key corresponds to a position inside the buffer.
+	bool is_key_valid(uint64_t key) const;
+
+	// Same as `get_or_create`, using a key. The key must be valid.
+	VoxelMetadata &get_or_create_from_key(uint64_t key);
+
+	// Visits entries in key order.
+	// Callback signature: `void(uint64_t key, const VoxelMetadata &meta)`
+	template <typename F>
+	void for_each_key(F f) const {
+		for (size_t i = 0; i < _keys.size(); ++i) {
+			f(_keys[i], _values[_slots[i]]);
+		}
+	}
+
+	// Callback signature: `void(Vector3i pos, const VoxelMetadata &meta)`
+	template <typename F>
+	void for_each(F f) const {
+		for (size_t i = 0; i < _keys.size(); ++i) {
+			f(get_position(_keys[i]), _values[_slots[i]]);
+		}
+	}
+
+	// Callback signature: `void(Vector3i pos, const VoxelMetadata &meta)`
+	template <typename F>
+	void for_each_in_area(Box3i box, F f) const {
+		if (_keys.size() == 0) {
+			return;
+		}
+		box.clip(_buffer_size);
+		if (Vector3iUtil::get_volume(box.size) == 0) {
+			return;
+		}
+		const Vector3i cmin = box.position >> CELL_SIZE_PO2;
+		const Vector3i cmax = (box.position + box.size - Vector3i(1, 1, 1)) >> CELL_SIZE_PO2;
+
+		Vector3i cpos;
+		for (cpos.z = cmin.z; cpos.z <= cmax.z; ++cpos.z) {
+			for (cpos.x = cmin.x; cpos.x <= cmax.x; ++cpos.x) {
+				for (cpos.y = cmin.y; cpos.y <= cmax.y; ++cpos.y) {
+					const uint64_t cell_index = get_cell_index(cpos);
+					if (!_occupied_cells.get(cell_index)) {
+						continue;
+					}
+					const uint64_t key_begin = cell_index << CELL_VOLUME_PO2;
+					const uint64_t key_end = key_begin + CELL_VOLUME;
+					for (size_t i = lower_bound(key_begin); i < _keys.size() && _keys[i] < key_end; ++i) {
+						const Vector3i pos = get_position(_keys[i]);
+						if (box.contains(pos)) {
+							f(pos, _values[_slots[i]]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Erases entries for which the predicate returns true.
+	// Predicate signature: `bool(Vector3i pos, const VoxelMetadata &meta)`
+	template <typename F>
+	void remove_if(F predicate) {
+		size_t dst_index = 0;
+		for (size_t i = 0; i < _keys.size(); ++i) {
+			const uint32_t slot = _slots[i];
+			if (predicate(get_position(_keys[i]), _values[slot])) {
+				free_slot(slot);
+			} else {
+				_keys[dst_index] = _keys[i];
+				_slots[dst_index] = slot;
+				++dst_index;
+			}
+		}
+		if (dst_index != _keys.size()) {
+			_keys.resize(dst_index);
+			_slots.resize(dst_index);
+			update_occupied_cells();
+		}
+	}
+
+	void remove_in_area(Box3i box);
+
+private:
+	inline uint64_t get_cell_index(Vector3i cpos) const {
+		return cpos.y + _cells_size.y * (uint64_t(cpos.x) + _cells_size.x * uint64_t(cpos.z));
+	}
+
+	// Index of the first key greater or equal to the given one
+	size_t lower_bound(uint64_t key) const;
+
+	uint32_t allocate_slot();
+	void free_slot(uint32_t slot);
+	void update_occupied_cells();
+
+	// Sorted
+	StdVector<uint64_t> _keys;
+	// Slot of the value of each key
+	StdVector<uint32_t> _slots;
+	StdVector<VoxelMetadata> _values;
+	StdVector<uint32_t> _free_slots;
+	// Allocated when the first entry is inserted
+	DynamicBitset _occupied_cells;
+	Vector3i _buffer_size;
+	Vector3i _cells_size;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_METADATA_MAP_H
@@ -205,6 +205,7 @@ void VoxelBuffer::create(unsigned int sx, unsigned int sy, unsigned int sz) {
 #endif
 
 	_size = Vector3i(sx, sy, sz);
+	_voxel_metadata.create(_size);
 
 #ifdef DEV_ENABLED
 	for (const Channel &channel : _channels) {
@@ -231,7 +232,7 @@ void VoxelBuffer::clear() {
 		channel.defval = g_default_values[channel_index];
 	}
 	_size = Vector3i();
-	clear_voxel_metadata();
+	_voxel_metadata.create(_size);
 }
 
 void VoxelBuffer::clear_channel(unsigned int channel_index, uint64_t clear_value) {
@@ -981,13 +982,7 @@ VoxelMetadata *VoxelBuffer::get_voxel_metadata(Vector3i pos) {
 
 VoxelMetadata *VoxelBuffer::get_or_create_voxel_metadata(Vector3i pos) {
 	ZN_ASSERT_RETURN_V(is_position_valid(pos), nullptr);
-	VoxelMetadata *d = _voxel_metadata.find(pos);
-	if (d != nullptr) {
-		return d;
-	}
-	// TODO Optimize: we know the key should not exist
-	VoxelMetadata &meta = _voxel_metadata.insert_or_assign(pos, VoxelMetadata());
-	return &meta;
+	return &_voxel_metadata.get_or_create(pos);
 }
 
 void VoxelBuffer::erase_voxel_metadata(Vector3i pos) {
@@ -995,15 +990,6 @@ void VoxelBuffer::erase_voxel_metadata(Vector3i pos) {
 	_voxel_metadata.erase(pos);
 }
 
-void VoxelBuffer::clear_and_set_voxel_metadata(Span<FlatMapMoveOnly<Vector3i, VoxelMetadata>::Pair> pairs) {
-#ifdef DEBUG_ENABLED
-	for (size_t i = 0; i < pairs.size(); ++i) {
-		ZN_ASSERT_CONTINUE(is_position_valid(pairs[i].key));
-	}
-#endif
-	_voxel_metadata.clear_and_insert(pairs);
-}
-
 /*#ifdef ZN_GODOT
 
 void VoxelBuffer::for_each_voxel_metadata(const Callable &callback) const {
@@ -1048,39 +1034,31 @@ void VoxelBuffer::clear_voxel_metadata() {
 }
 
 void VoxelBuffer::clear_voxel_metadata_in_area(Box3i box) {
-	_voxel_metadata.remove_if([&box](const FlatMapMoveOnly<Vector3i, VoxelMetadata>::Pair &p) { //
-		return box.contains(p.key);
-	});
+	_voxel_metadata.remove_in_area(box);
 }
 
 void VoxelBuffer::copy_voxel_metadata_in_area(const VoxelBuffer &src_buffer, Box3i src_box, Vector3i dst_origin) {
 	ZN_ASSERT_RETURN(src_buffer.is_box_valid(src_box));
 
 	const Box3i clipped_src_box = src_box.clipped(Box3i(src_box.position - dst_origin, _size));
-	const Vector3i clipped_dst_offset = dst_origin + clipped_src_box.position - src_box.position;
+	const Vector3i dst_offset = dst_origin - src_box.position;
 
-	for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator src_it = src_buffer._voxel_metadata.begin();
-		 src_it != src_buffer._voxel_metadata.end();
-		 ++src_it) {
-		if (src_box.contains(src_it->key)) {
-			const Vector3i dst_pos = src_it->key + clipped_dst_offset;
-			ZN_ASSERT(is_position_valid(dst_pos));
+	src_buffer._voxel_metadata.for_each_in_area(
+			clipped_src_box,
+			[this, dst_offset](Vector3i src_pos, const VoxelMetadata &src_meta) {
+				const Vector3i dst_pos = src_pos + dst_offset;
+				ZN_ASSERT(is_position_valid(dst_pos));
 
-			VoxelMetadata &meta = _voxel_metadata.insert_or_assign(dst_pos, VoxelMetadata());
-			meta.copy_from(src_it->value);
-		}
-	}
+				VoxelMetadata &meta = _voxel_metadata.get_or_create(dst_pos);
+				meta.copy_from(src_meta);
+			}
+	);
 }
 
 void VoxelBuffer::copy_voxel_metadata(const VoxelBuffer &src_buffer) {
 	ZN_ASSERT_RETURN(src_buffer.get_size() == _size);
 
-	for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator src_it = src_buffer._voxel_metadata.begin();
-		 src_it != src_buffer._voxel_metadata.end();
-		 ++src_it) {
-		VoxelMetadata &meta = _voxel_metadata.insert_or_assign(src_it->key, VoxelMetadata());
-		meta.copy_from(src_it->value);
-	}
+	_voxel_metadata.copy_from(src_buffer._voxel_metadata);
 
 	_block_metadata.copy_from(src_buffer._block_metadata);
 }
@@ -1304,9 +1282,9 @@ void paste_src_masked(
 
 	if (with_metadata) {
 		dst_buffer.erase_voxel_metadata_if([dst_box, &src_buffer, src_mask_channel, src_mask_value](
-												   const FlatMapMoveOnly<Vector3i, VoxelMetadata>::Pair &p
+												   Vector3i pos, const VoxelMetadata &meta
 										   ) {
-			return dst_box.contains(p.key) && src_buffer.get_voxel(p.key, src_mask_channel) != src_mask_value;
+			return dst_box.contains(pos) && src_buffer.get_voxel(pos, src_mask_channel) != src_mask_value;
 		});
 
 		const Box3i src_box(dst_box.position - dst_base_pos, dst_box.size);
@@ -1395,12 +1373,12 @@ void paste_src_masked_dst_predicate(
 	if (with_metadata) {
 		dst_buffer.erase_voxel_metadata_if(
 				[&src_buffer, src_mask_channel, src_mask_value, dst_box, &dst_buffer, dst_mask_channel, &dst_predicate](
-						const FlatMapMoveOnly<Vector3i, VoxelMetadata>::Pair &p
+						Vector3i pos, const VoxelMetadata &meta
 				) {
 					//
-					return dst_box.contains(p.key) //
-							&& src_buffer.get_voxel(p.key, src_mask_channel) != src_mask_value //
-							&& dst_predicate(dst_buffer.get_voxel(p.key, dst_mask_channel));
+					return dst_box.contains(pos) //
+							&& src_buffer.get_voxel(pos, src_mask_channel) != src_mask_value //
+							&& dst_predicate(dst_buffer.get_voxel(pos, dst_mask_channel));
 				}
 		);
 
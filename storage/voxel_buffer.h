@@ -2,11 +2,11 @@
 #define VOXEL_BUFFER_INTERNAL_H
 
 #include "../util/containers/fixed_array.h"
-#include "../util/containers/flat_map.h"
 #include "../util/containers/small_vector.h"
 #include "../util/math/box3i.h"
 #include "funcs.h"
 #include "metadata/voxel_metadata.h"
+#include "metadata/voxel_metadata_map.h"
 
 #include <limits>
 
@@ -482,21 +482,13 @@ public:
 	VoxelMetadata *get_or_create_voxel_metadata(Vector3i pos);
 	void erase_voxel_metadata(Vector3i pos);
 
-	void clear_and_set_voxel_metadata(Span<FlatMapMoveOnly<Vector3i, VoxelMetadata>::Pair> pairs);
-
+	// Callback signature: `void(Vector3i pos, const VoxelMetadata &meta)`
 	template <typename F>
 	void for_each_voxel_metadata_in_area(Box3i box, F callback) const {
-		// TODO For `find`s and this kind of iteration, we may want to separate keys and values in FlatMap's internal
-		// storage, to reduce cache misses
-		for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator it = _voxel_metadata.begin();
-			 it != _voxel_metadata.end();
-			 ++it) {
-			if (box.contains(it->key)) {
-				callback(it->key, it->value);
-			}
-		}
+		_voxel_metadata.for_each_in_area(box, callback);
 	}
 
+	// Predicate signature: `bool(Vector3i pos, const VoxelMetadata &meta)`
 	template <typename F>
 	inline void erase_voxel_metadata_if(F predicate) {
 		_voxel_metadata.remove_if(predicate);
@@ -513,7 +505,11 @@ public:
 	void copy_voxel_metadata_in_area(const VoxelBuffer &src_buffer, Box3i src_box, Vector3i dst_origin);
 	void copy_voxel_metadata(const VoxelBuffer &src_buffer);
 
-	const FlatMapMoveOnly<Vector3i, VoxelMetadata> &get_voxel_metadata() const {
+	const VoxelMetadataMap &get_voxel_metadata() const {
+		return _voxel_metadata;
+	}
+
+	VoxelMetadataMap &get_voxel_metadata() {
 		return _voxel_metadata;
 	}
 
@@ -542,7 +538,7 @@ private:
 	// TODO Could we separate metadata from VoxelBuffer?
 	VoxelMetadata _block_metadata;
 	// This metadata is expected to be sparse, with low amount of items.
-	FlatMapMoveOnly<Vector3i, VoxelMetadata> _voxel_metadata;
+	VoxelMetadataMap _voxel_metadata;
 };
 
 void get_unscaled_sdf(const VoxelBuffer &voxels, Span<float> sdf);
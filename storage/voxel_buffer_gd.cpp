@@ -477,14 +477,14 @@ void VoxelBuffer::for_each_voxel_metadata(const Callable &callback) const {
 	ERR_FAIL_COND(callback.is_null());
 	//_buffer->for_each_voxel_metadata(callback);
 
-	const FlatMapMoveOnly<Vector3i, VoxelMetadata> &metadata_map = _buffer->get_voxel_metadata();
+	const VoxelMetadataMap &metadata_map = _buffer->get_voxel_metadata();
 
-	for (auto it = metadata_map.begin(); it != metadata_map.end(); ++it) {
-		Variant v = get_as_variant(it->value);
+	metadata_map.for_each([&callback](Vector3i pos, const VoxelMetadata &meta) {
+		Variant v = get_as_variant(meta);
 
 #if defined(ZN_GODOT)
 		// TODO Use template version? Could get closer to GodotCpp
-		const Variant key = it->key;
+		const Variant key = pos;
 		const Variant *args[2] = { &key, &v };
 		Callable::CallError err;
 		Variant retval; // We don't care about the return value, Callable API requires it
@@ -495,11 +495,11 @@ void VoxelBuffer::for_each_voxel_metadata(const Callable &callback) const {
 
 #elif defined(ZN_GODOT_EXTENSION)
 		// TODO Error reporting? GodotCpp doesn't expose anything
-		// callback.call(it->key, v);
+		// callback.call(pos, v);
 		// TODO GodotCpp is missing the implementation of `Callable::call`.
 		ZN_PRINT_ERROR("Unable to call Callable, go moan at https://github.com/godotengine/godot-cpp/issues/802");
 #endif
-	}
+	});
 }
 
 void VoxelBuffer::for_each_voxel_metadata_in_area(const Callable &callback, Vector3i min_pos, Vector3i max_pos) {
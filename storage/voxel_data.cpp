@@ -1,4 +1,5 @@
 #include "voxel_data.h"
+#include "../util/containers/container_funcs.h"
 #include "../util/containers/std_vector.h"
 #include "../util/dstack.h"
 #include "../util/math/conv.h"
@@ -87,6 +88,12 @@ void VoxelData::reset_maps() {
 }
 
 void VoxelData::reset_maps_no_settings_lock() {
+	{
+		// Recorded edits refer to blocks that are about to be removed
+		MutexLock mlock(_edit_journal_mutex);
+		_edit_journal.clear();
+	}
+
 	for (unsigned int lod_index = 0; lod_index < _lods.size(); ++lod_index) {
 		Lod &data_lod = _lods[lod_index];
 
@@ -103,6 +110,9 @@ void VoxelData::reset_maps_no_settings_lock() {
 			data_lod.map.clear();
 		}
 	}
+
+	// Settings are already locked, so bounds are accessed directly
+	notify_area_changed(_bounds_in_voxels);
 }
 
 void VoxelData::set_bounds(Box3i bounds) {
@@ -275,6 +285,126 @@ float VoxelData::get_voxel_f(Vector3i pos, unsigned int channel_index) const {
 	return get_voxel(pos, channel_index, defval).f;
 }
 
+VoxelData::BlockReader::BlockReader(const VoxelData &data, unsigned int channel_index, VoxelSingleValue defval) :
+		_data(data), _channel_index(channel_index), _defval(defval) {}
+
+VoxelData::BlockReader::~BlockReader() {
+	unlock();
+}
+
+void VoxelData::BlockReader::unlock() {
+	if (_voxels != nullptr) {
+		_data._lods[0].spatial_lock.unlock_read(BoxBounds3i::from_position(_block_position));
+		_voxels.reset();
+	}
+}
+
+namespace {
+
+bool get_block_value_range(
+		const VoxelDataBlock &block,
+		const VoxelBuffer &voxels,
+		unsigned int channel_index,
+		VoxelSingleValue &out_min,
+		VoxelSingleValue &out_max
+) {
+	if (channel_index == VoxelBuffer::CHANNEL_SDF) {
+		block.get_sdf_range(out_min.f, out_max.f);
+		return true;
+	}
+	if (voxels.is_uniform(channel_index)) {
+		out_min.i = voxels.get_voxel(Vector3i(), channel_index);
+		out_max = out_min;
+		return true;
+	}
+	return false;
+}
+
+} // namespace
+
+bool VoxelData::BlockReader::enter_block(
+		const Vector3i block_position,
+		VoxelSingleValue &out_min,
+		VoxelSingleValue &out_max
+) {
+	unlock();
+	_block_position = block_position;
+
+	const unsigned int block_size_po2 = _data.get_block_size_po2();
+	const Box3i voxel_box(block_position << block_size_po2, Vector3iUtil::create(1 << block_size_po2));
+	const Box3i bounds = _data.get_bounds();
+
+	if (!bounds.intersects(voxel_box)) {
+		out_min = _defval;
+		out_max = _defval;
+		return true;
+	}
+	// Otherwise the default value would have to be included
+	const bool fully_in_bounds = bounds.contains(voxel_box);
+
+	const Lod &data_lod0 = _data._lods[0];
+
+	data_lod0.spatial_lock.lock_read(BoxBounds3i::from_position(block_position));
+
+	const VoxelDataBlock *block = nullptr;
+	{
+		RWLockRead rlock(data_lod0.map_lock);
+		block = data_lod0.map.get_block(block_position);
+		if (block != nullptr && block->has_voxels()) {
+			_voxels = block->get_voxels_shared();
+		}
+	}
+
+	if (_voxels != nullptr) {
+		// The block remains locked until we leave it
+		return fully_in_bounds && get_block_value_range(*block, *_voxels, _channel_index, out_min, out_max);
+	}
+
+	data_lod0.spatial_lock.unlock_read(BoxBounds3i::from_position(block_position));
+
+	if (block != nullptr || !_data.is_streaming_enabled()) {
+		// Voxels would come from the generator, which `get_voxel` will take care of
+		return false;
+	}
+
+	// Not loaded at LOD0. Like `get_voxel`, fall back on lower LODs. Values obtained that way are a subset of the
+	// values of the first block found, so its range can be used.
+	const unsigned int lod_count = _data.get_lod_count();
+	for (unsigned int lod_index = 1; lod_index < lod_count; ++lod_index) {
+		const Lod &data_lod = _data._lods[lod_index];
+		const Vector3i lod_block_position = block_position >> lod_index;
+
+		SpatialLock3D::Read srlock(data_lod.spatial_lock, BoxBounds3i::from_position(lod_block_position));
+		RWLockRead rlock(data_lod.map_lock);
+
+		const VoxelDataBlock *lod_block = data_lod.map.get_block(lod_block_position);
+		if (lod_block == nullptr) {
+			continue;
+		}
+		if (!lod_block->has_voxels()) {
+			// Voxels would come from the generator
+			return false;
+		}
+		return fully_in_bounds &&
+				get_block_value_range(*lod_block, lod_block->get_voxels_const(), _channel_index, out_min, out_max);
+	}
+
+	// Not loaded, `get_voxel` would return the default value
+	out_min = _defval;
+	out_max = _defval;
+	return true;
+}
+
+VoxelSingleValue VoxelData::BlockReader::get_voxel(Vector3i pos) const {
+	if (_voxels == nullptr) {
+		return _data.get_voxel(pos, _channel_index, _defval);
+	}
+	if (!_data._bounds_in_voxels.contains(pos)) {
+		return _defval;
+	}
+	return get_voxel_sv(*_voxels, pos - (_block_position << _data.get_block_size_po2()), _channel_index);
+}
+
 bool VoxelData::try_set_voxel_f(real_t value, Vector3i pos, unsigned int channel_index) {
 	// TODO Handle format instead of hardcoding 16-bits
 	return try_set_voxel(snorm_to_s16(value), pos, channel_index);
@@ -666,6 +796,7 @@ void VoxelData::mark_area_modified(
 			// RWLockWrite wlock(block->get_voxels_shared()->get_lock());
 			block->set_modified(true);
 			block->set_edited(true);
+			block->invalidate_cached_summaries();
 
 			// TODO That boolean is also modified by the threaded update task (always set to false)
 			if (!block->get_needs_lodding() && require_lod_updates) {
@@ -678,6 +809,25 @@ void VoxelData::mark_area_modified(
 			}
 		});
 	}
+
+	notify_area_changed(p_voxel_box);
+}
+
+void VoxelData::notify_area_changed(Box3i voxel_box) {
+	MutexLock mlock(_edit_listeners_mutex);
+	unordered_remove_if(_edit_listeners, [voxel_box](const std::weak_ptr<IEditListener> &wp) {
+		std::shared_ptr<IEditListener> listener = wp.lock();
+		if (listener == nullptr) {
+			return true;
+		}
+		listener->on_area_changed(voxel_box);
+		return false;
+	});
+}
+
+void VoxelData::add_edit_listener(std::weak_ptr<IEditListener> listener) {
+	MutexLock mlock(_edit_listeners_mutex);
+	_edit_listeners.push_back(listener);
 }
 
 bool VoxelData::try_set_block(Vector3i block_position, const VoxelDataBlock &block) {
@@ -920,16 +1070,21 @@ void VoxelData::update_lods(Span<const Vector3i> modified_lod0_blocks, StdVector
 
 void VoxelData::unload_blocks(Box3i bbox, unsigned int lod_index, StdVector<BlockToSave> *to_save) {
 	Lod &lod = _lods[lod_index];
-	SpatialLock3D::Write swlock(lod.spatial_lock, bbox);
-	RWLockWrite wlock(lod.map_lock);
-	if (to_save == nullptr) {
-		bbox.for_each_cell_zxy([&lod](Vector3i bpos) { //
-			lod.map.remove_block(bpos, VoxelDataMap::NoAction());
-		});
-	} else {
-		bbox.for_each_cell_zxy([&lod, lod_index, to_save](Vector3i bpos) {
-			lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, lod_index });
-		});
+	{
+		SpatialLock3D::Write swlock(lod.spatial_lock, bbox);
+		RWLockWrite wlock(lod.map_lock);
+		if (to_save == nullptr) {
+			bbox.for_each_cell_zxy([&lod](Vector3i bpos) { //
+				lod.map.remove_block(bpos, VoxelDataMap::NoAction());
+			});
+		} else {
+			bbox.for_each_cell_zxy([&lod, lod_index, to_save](Vector3i bpos) {
+				lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, lod_index });
+			});
+		}
+	}
+	if (lod_index == 0) {
+		notify_area_changed(bbox.scaled(get_block_size()));
 	}
 }
 
@@ -1020,6 +1175,43 @@ void VoxelData::get_missing_blocks(Box3i p_blocks_box, unsigned int lod_index, S
 	});
 }
 
+void VoxelData::get_loaded_blocks(Box3i p_blocks_box, unsigned int lod_index, StdVector<Vector3i> &out_positions)
+		const {
+	const Lod &data_lod = _lods[lod_index];
+
+	const Box3i bounds_in_blocks = get_bounds().downscaled(get_block_size());
+	const Box3i blocks_box = p_blocks_box.clipped(bounds_in_blocks);
+
+	RWLockRead rlock(data_lod.map_lock);
+
+	// The box can span the whole world, in which case its volume doesn't even fit in 64 bits. Compare it progressively.
+	const int64_t loaded_count = data_lod.map.get_block_count();
+	int64_t volume = 1;
+	bool box_is_larger = false;
+	for (int axis = 0; axis < Vector3iUtil::AXIS_COUNT; ++axis) {
+		volume *= math::max(blocks_box.size[axis], 0);
+		if (volume > loaded_count) {
+			box_is_larger = true;
+			break;
+		}
+	}
+
+	if (box_is_larger) {
+		// Fewer blocks are loaded than the area contains, go through loaded blocks instead
+		data_lod.map.for_each_block_position([&blocks_box, &out_positions](Vector3i bpos) {
+			if (blocks_box.contains(bpos)) {
+				out_positions.push_back(bpos);
+			}
+		});
+	} else {
+		blocks_box.for_each_cell_zxy([&data_lod, &out_positions](Vector3i bpos) {
+			if (data_lod.map.has_block(bpos)) {
+				out_positions.push_back(bpos);
+			}
+		});
+	}
+}
+
 void VoxelData::get_blocks_with_voxel_data(
 		Box3i p_blocks_box,
 		unsigned int lod_index,
@@ -1150,33 +1342,43 @@ void VoxelData::unview_area(
 	blocks_box = blocks_box.clipped(bounds_in_blocks);
 
 	Lod &lod = _lods[lod_index];
+	bool removed_any = false;
 
-	// Locking for write because we are modifying states on blocks.
-	// TODO Could use atomics if contention is too much? However if we do, we need to ensure no other thread is holding
-	// a pointer to any of the blocks we could remove.
-	SpatialLock3D::Write swlock(lod.spatial_lock, blocks_box);
-
-	// Locking for write because we are potentially going to remove blocks from the map.
-	RWLockWrite wlock(lod.map_lock);
+	{
+		// Locking for write because we are modifying states on blocks.
+		// TODO Could use atomics if contention is too much? However if we do, we need to ensure no other thread is
+		// holding a pointer to any of the blocks we could remove.
+		SpatialLock3D::Write swlock(lod.spatial_lock, blocks_box);
 
-	blocks_box.for_each_cell_zxy([&lod, missing_blocks, removed_blocks, to_save, lod_index](Vector3i bpos) {
-		VoxelDataBlock *block = lod.map.get_block(bpos);
-		if (block != nullptr) {
-			block->viewers.remove();
-			if (block->viewers.get() == 0) {
-				if (to_save == nullptr) {
-					lod.map.remove_block(bpos, VoxelDataMap::NoAction());
-				} else {
-					lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, lod_index });
-				}
-				if (removed_blocks != nullptr) {
-					removed_blocks->push_back(bpos);
+		// Locking for write because we are potentially going to remove blocks from the map.
+		RWLockWrite wlock(lod.map_lock);
+
+		blocks_box.for_each_cell_zxy(
+				[&lod, &removed_any, missing_blocks, removed_blocks, to_save, lod_index](Vector3i bpos) {
+					VoxelDataBlock *block = lod.map.get_block(bpos);
+					if (block != nullptr) {
+						block->viewers.remove();
+						if (block->viewers.get() == 0) {
+							if (to_save == nullptr) {
+								lod.map.remove_block(bpos, VoxelDataMap::NoAction());
+							} else {
+								lod.map.remove_block(bpos, BeforeUnloadSaveAction{ to_save, bpos, lod_index });
+							}
+							if (removed_blocks != nullptr) {
+								removed_blocks->push_back(bpos);
+							}
+							removed_any = true;
+						}
+					} else if (missing_blocks != nullptr) {
+						missing_blocks->push_back(bpos);
+					}
 				}
-			}
-		} else if (missing_blocks != nullptr) {
-			missing_blocks->push_back(bpos);
-		}
-	});
+		);
+	}
+
+	if (removed_any && lod_index == 0) {
+		notify_area_changed(blocks_box.scaled(get_block_size()));
+	}
 }
 
 std::shared_ptr<VoxelBuffer> VoxelData::try_get_block_voxels(Vector3i bpos) {
@@ -1197,6 +1399,22 @@ std::shared_ptr<VoxelBuffer> VoxelData::try_get_block_voxels(Vector3i bpos) {
 	return nullptr;
 }
 
+std::shared_ptr<VoxelBuffer> VoxelData::try_get_block_voxels_and_type_summary(
+		Vector3i bpos,
+		uint64_t &out_type_summary
+) const {
+	const Lod &lod = _lods[0];
+
+	RWLockRead rlock(lod.map_lock);
+
+	const VoxelDataBlock *block = lod.map.get_block(bpos);
+	if (block == nullptr || !block->has_voxels()) {
+		return nullptr;
+	}
+	out_type_summary = block->get_type_summary();
+	return block->get_voxels_shared();
+}
+
 void VoxelData::set_voxel_metadata(Vector3i pos, Variant meta) {
 	Lod &lod = _lods[0];
 
@@ -1233,4 +1451,183 @@ Variant VoxelData::get_voxel_metadata(Vector3i pos) {
 	return godot::get_as_variant(*meta);
 }
 
+void VoxelData::set_edit_journal_max_memory(size_t max_memory) {
+	MutexLock mlock(_edit_journal_mutex);
+	_edit_journal.set_max_memory(max_memory);
+}
+
+size_t VoxelData::get_edit_journal_max_memory() const {
+	MutexLock mlock(_edit_journal_mutex);
+	return _edit_journal.get_max_memory();
+}
+
+void VoxelData::begin_journaled_edit(Box3i voxel_box, VoxelEditJournal::Snapshot &out_snapshot) const {
+	out_snapshot.clear();
+	{
+		MutexLock mlock(_edit_journal_mutex);
+		if (!_edit_journal.is_enabled()) {
+			return;
+		}
+	}
+
+	ZN_PROFILE_SCOPE();
+
+	const Lod &lod = _lods[0];
+	const Box3i blocks_box = voxel_box.downscaled(get_block_size());
+	out_snapshot.voxel_box = voxel_box;
+
+	SpatialLock3D::Read srlock(lod.spatial_lock, BoxBounds3i(blocks_box));
+	RWLockRead rlock(lod.map_lock);
+
+	blocks_box.for_each_cell([&lod, &out_snapshot](Vector3i bpos) {
+		const VoxelDataBlock *block = lod.map.get_block(bpos);
+		if (block == nullptr) {
+			// Not loaded, edits can't happen there
+			return;
+		}
+		std::shared_ptr<VoxelBuffer> voxels;
+		if (block->has_voxels()) {
+			voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+			block->get_voxels_const().copy_to(*voxels, true);
+		}
+		out_snapshot.block_positions.push_back(bpos);
+		out_snapshot.block_voxels.push_back(voxels);
+	});
+}
+
+void VoxelData::end_journaled_edit(VoxelEditJournal::Snapshot &snapshot) {
+	if (snapshot.is_empty()) {
+		return;
+	}
+
+	ZN_PROFILE_SCOPE();
+
+	VoxelEditJournal::Edit edit;
+	edit.voxel_box = snapshot.voxel_box;
+	{
+		const Lod &lod = _lods[0];
+		SpatialLock3D::Read srlock(lod.spatial_lock, BoxBounds3i(snapshot.voxel_box.downscaled(get_block_size())));
+		RWLockRead rlock(lod.map_lock);
+
+		for (unsigned int i = 0; i < snapshot.block_positions.size(); ++i) {
+			const Vector3i bpos = snapshot.block_positions[i];
+			const VoxelDataBlock *block = lod.map.get_block(bpos);
+			if (block == nullptr) {
+				// Got unloaded in the meantime
+				continue;
+			}
+			const VoxelBuffer *voxels_after = block->has_voxels() ? &block->get_voxels_const() : nullptr;
+			VoxelEditJournal::BlockDiff diff;
+			if (VoxelEditJournal::make_block_diff(bpos, snapshot.block_voxels[i].get(), voxels_after, diff)) {
+				edit.blocks.push_back(std::move(diff));
+			}
+		}
+	}
+
+	snapshot.clear();
+
+	if (edit.blocks.size() == 0) {
+		return;
+	}
+
+	MutexLock mlock(_edit_journal_mutex);
+	// Could have been disabled in the meantime
+	if (_edit_journal.is_enabled()) {
+		_edit_journal.push(std::move(edit));
+	}
+}
+
+bool VoxelData::apply_journaled_edit(const VoxelEditJournal::Edit &edit, bool forward) {
+	ZN_PROFILE_SCOPE();
+
+	Lod &lod = _lods[0];
+	SpatialLock3D::Write swlock(lod.spatial_lock, BoxBounds3i(edit.voxel_box.downscaled(get_block_size())));
+	// Locking map for read because we won't add or remove blocks
+	RWLockRead rlock(lod.map_lock);
+
+	// Check all blocks first, so the edit is either applied entirely or not at all
+	for (const VoxelEditJournal::BlockDiff &diff : edit.blocks) {
+		const VoxelDataBlock *block = lod.map.get_block(diff.position);
+		if (block != nullptr && !VoxelEditJournal::can_apply_block_diff(diff, forward, *block)) {
+			ZN_PRINT_WARNING(format("Block {} was changed outside of the edit journal, can't apply it", diff.position));
+			return false;
+		}
+	}
+
+	for (const VoxelEditJournal::BlockDiff &diff : edit.blocks) {
+		VoxelDataBlock *block = lod.map.get_block(diff.position);
+		if (block == nullptr) {
+			ZN_PRINT_VERBOSE(format("Block {} was unloaded since it was edited, can't apply journal", diff.position));
+			continue;
+		}
+		VoxelEditJournal::apply_block_diff(diff, forward, *block);
+	}
+
+	return true;
+}
+
+bool VoxelData::undo_edit(Box3i &out_voxel_box) {
+	MutexLock mlock(_edit_journal_mutex);
+	const VoxelEditJournal::Edit *edit = _edit_journal.get_undo_edit();
+	if (edit == nullptr || !apply_journaled_edit(*edit, false)) {
+		return false;
+	}
+	out_voxel_box = edit->voxel_box;
+	_edit_journal.undo();
+	return true;
+}
+
+bool VoxelData::redo_edit(Box3i &out_voxel_box) {
+	MutexLock mlock(_edit_journal_mutex);
+	const VoxelEditJournal::Edit *edit = _edit_journal.get_redo_edit();
+	if (edit == nullptr || !apply_journaled_edit(*edit, true)) {
+		return false;
+	}
+	out_voxel_box = edit->voxel_box;
+	_edit_journal.redo();
+	return true;
+}
+
+uint32_t VoxelData::get_edit_tick() const {
+	MutexLock mlock(_edit_journal_mutex);
+	return _edit_journal.get_tick();
+}
+
+bool VoxelData::seek_edit_tick(uint32_t tick, Box3i &out_voxel_box) {
+	ZN_PROFILE_SCOPE();
+	MutexLock mlock(_edit_journal_mutex);
+
+	out_voxel_box = Box3i();
+	bool changed = false;
+
+	auto add_changed_box = [&out_voxel_box, &changed](const Box3i &box) {
+		if (changed) {
+			out_voxel_box.merge_with(box);
+		} else {
+			out_voxel_box = box;
+			changed = true;
+		}
+	};
+
+	while (_edit_journal.get_tick() > tick) {
+		const VoxelEditJournal::Edit *edit = _edit_journal.get_undo_edit();
+		if (edit == nullptr || !apply_journaled_edit(*edit, false)) {
+			break;
+		}
+		add_changed_box(edit->voxel_box);
+		_edit_journal.undo();
+	}
+
+	while (_edit_journal.get_tick() < tick) {
+		const VoxelEditJournal::Edit *edit = _edit_journal.get_redo_edit();
+		if (edit == nullptr || !apply_journaled_edit(*edit, true)) {
+			break;
+		}
+		add_changed_box(edit->voxel_box);
+		_edit_journal.redo();
+	}
+
+	return _edit_journal.get_tick() == tick;
+}
+
 } // namespace zylann::voxel
@@ -7,6 +7,7 @@
 #include "../util/thread/mutex.h"
 #include "../util/thread/spatial_lock_3d.h"
 #include "voxel_data_map.h"
+#include "voxel_edit_journal.h"
 
 namespace zylann::voxel {
 
@@ -103,6 +104,34 @@ public:
 	float get_voxel_f(Vector3i pos, unsigned int channel_index) const;
 	bool try_set_voxel_f(real_t value, Vector3i pos, unsigned int channel_index);
 
+	// Reads single voxels of LOD0 one block at a time. This is faster than `get_voxel` when many voxels are read in the
+	// same block, such as along a ray, because the map is looked up and locked only once per block.
+	// Only the current block is locked (for reading), until another block is entered or the reader is destroyed.
+	// Where voxel data is not in memory, it falls back on `get_voxel`, so it returns the same values.
+	class BlockReader {
+	public:
+		BlockReader(const VoxelData &data, unsigned int channel_index, VoxelSingleValue defval);
+		~BlockReader();
+
+		// Returns `true` if the range of values the block contains is known. With the SDF channel, ranges are cached
+		// per block. With other channels, the range is only known if the block is uniform (then min == max).
+		// If the block is not loaded, lower LODs may be used to find a range, the same way `get_voxel` falls back on
+		// them.
+		bool enter_block(Vector3i block_position, VoxelSingleValue &out_min, VoxelSingleValue &out_max);
+
+		// Position must be inside the last entered block.
+		VoxelSingleValue get_voxel(Vector3i pos) const;
+
+	private:
+		void unlock();
+
+		const VoxelData &_data;
+		const unsigned int _channel_index;
+		const VoxelSingleValue _defval;
+		Vector3i _block_position;
+		std::shared_ptr<VoxelBuffer> _voxels;
+	};
+
 	// Copies voxel data in a box from LOD0.
 	// `channels_mask` bits tell which channel is read.
 	void copy(Vector3i min_pos, VoxelBuffer &dst_buffer, unsigned int channels_mask) const;
@@ -174,15 +203,19 @@ public:
 			ZN_ASSERT(block.get_voxels_const().get_size() == Vector3iUtil::create(get_block_size()));
 		}
 #endif
-		RWLockWrite wlock(lod.map_lock);
-		VoxelDataBlock *existing_block = lod.map.get_block(block_position);
-		if (existing_block != nullptr) {
-			action_when_exists(*existing_block, block);
-			return false;
-		} else {
+		{
+			RWLockWrite wlock(lod.map_lock);
+			VoxelDataBlock *existing_block = lod.map.get_block(block_position);
+			if (existing_block != nullptr) {
+				action_when_exists(*existing_block, block);
+				return false;
+			}
 			lod.map.set_block(block_position, block);
-			return true;
 		}
+		if (block.get_lod_index() == 0) {
+			notify_area_changed(Box3i(block_position << get_block_size_po2(), Vector3iUtil::create(get_block_size())));
+		}
+		return true;
 	}
 
 	template <typename F>
@@ -277,6 +310,11 @@ public:
 	// If the area intersects the outside of the bounds, it will be clipped.
 	void get_missing_blocks(Box3i p_blocks_box, unsigned int lod_index, StdVector<Vector3i> &out_missing) const;
 
+	// Gets positions of loaded blocks within the given area in block coordinates, in no particular order.
+	// If the area intersects the outside of the bounds, it will be clipped. Cost is bounded by the number of loaded
+	// blocks, so it can be used with areas much larger than what is loaded.
+	void get_loaded_blocks(Box3i p_blocks_box, unsigned int lod_index, StdVector<Vector3i> &out_positions) const;
+
 	// Gets blocks with voxel data in the given area in block coordinates.
 	// Voxel data references are returned in an array big enough to contain a grid of the size of the area.
 	// Blocks found will be placed at an index computed as if the array was a flat grid (ZXY).
@@ -306,6 +344,11 @@ public:
 	// Can return null.
 	std::shared_ptr<VoxelBuffer> try_get_block_voxels(Vector3i bpos);
 
+	// Same as `try_get_block_voxels`, and also gets the summary of the TYPE channel of the block (see
+	// `VoxelDataBlock::get_type_summary`), which is cached until the block is modified.
+	// WARNING: you must hold the spatial lock (for reading at least) before calling this.
+	std::shared_ptr<VoxelBuffer> try_get_block_voxels_and_type_summary(Vector3i bpos, uint64_t &out_type_summary) const;
+
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Reference-counted API (LOD0 only)
 	// Data blocks have a reference count that can be optionally used.
@@ -344,8 +387,64 @@ public:
 	void set_voxel_metadata(Vector3i pos, Variant meta);
 	Variant get_voxel_metadata(Vector3i pos);
 
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Edit journal.
+	// Only at LOD0.
+	// Optional record of edits, allowing to undo and redo them. An edit is recorded when it is surrounded by
+	// `begin_journaled_edit` and `end_journaled_edit`, which do nothing while the journal is disabled.
+	// If other edits happen concurrently in the same area, the recorded edit may include them.
+	// Blocks may also be changed without being recorded (async edits, network sync...). Undoing or redoing restores
+	// voxels the edit changed, and leaves others as they are. Edits that replaced whole blocks are refused if these
+	// blocks changed since then.
+
+	// The journal is enabled when the size is greater than zero. Setting it to zero clears it.
+	void set_edit_journal_max_memory(size_t max_memory);
+	size_t get_edit_journal_max_memory() const;
+
+	// Captures blocks of an area before they get edited. They should already be loaded or generated.
+	void begin_journaled_edit(Box3i voxel_box, VoxelEditJournal::Snapshot &out_snapshot) const;
+
+	// Records differences between the snapshot and the current state of blocks as a new edit, then clears the
+	// snapshot.
+	void end_journaled_edit(VoxelEditJournal::Snapshot &snapshot);
+
+	// Reverts the latest recorded edit. Returns false if there is nothing to undo, or if it can't be undone. Otherwise,
+	// returns the area that changed, which must then be handled like an edit (marked as modified, remeshed...).
+	bool undo_edit(Box3i &out_voxel_box);
+
+	// Applies again the latest undone edit, if no other edit was recorded since. Same usage as `undo_edit`.
+	bool redo_edit(Box3i &out_voxel_box);
+
+	// Identifies the current state of edits in the journal. See `VoxelEditJournal::get_tick`.
+	uint32_t get_edit_tick() const;
+
+	// Undoes or redoes edits until the journal reaches the given tick. Returns false if the journal doesn't contain
+	// enough edits to reach it, or if one of them can't be applied. The output box contains the area changed by edits
+	// that were applied, and has zero size if nothing changed.
+	bool seek_edit_tick(uint32_t tick, Box3i &out_voxel_box);
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// Edit listeners.
+	// Only at LOD0.
+
+	// Implemented by objects caching information derived from voxels, so they know when it becomes outdated.
+	class IEditListener {
+	public:
+		virtual ~IEditListener() {}
+
+		// Called when voxels of an area may have changed: when it is marked as modified, or when blocks get loaded or
+		// unloaded. Can be called from any thread.
+		virtual void on_area_changed(Box3i voxel_box) = 0;
+	};
+
+	// Listeners are held weakly, and are forgotten when they get destroyed.
+	void add_edit_listener(std::weak_ptr<IEditListener> listener);
+
 private:
 	void reset_maps_no_settings_lock();
+	void notify_area_changed(Box3i voxel_box);
+	// Returns false if the edit can't be applied because blocks it replaces changed since then.
+	bool apply_journaled_edit(const VoxelEditJournal::Edit &edit, bool forward);
 
 	struct Lod {
 		// Storage for edited and cached voxels.
@@ -438,6 +537,13 @@ private:
 	// Persistent storage (file(s)).
 	Ref<VoxelStream> _stream;
 
+	// Locked before spatial locks of LODs.
+	VoxelEditJournal _edit_journal;
+	mutable Mutex _edit_journal_mutex;
+
+	StdVector<std::weak_ptr<IEditListener>> _edit_listeners;
+	Mutex _edit_listeners_mutex;
+
 	// This should be locked when accessing settings members.
 	// If other locks are needed simultaneously such as voxel maps, they should always be locked AFTER, to prevent
 	// deadlocks.
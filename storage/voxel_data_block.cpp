@@ -1,6 +1,8 @@
 #include "voxel_data_block.h"
 #include "../util/io/log.h"
+#include "../util/profiling.h"
 #include "../util/string/format.h"
+#include "voxel_buffer.h"
 
 namespace zylann::voxel {
 
@@ -13,4 +15,77 @@ void VoxelDataBlock::set_modified(bool modified) {
 	_modified = modified;
 }
 
+void VoxelDataBlock::get_sdf_range(float &out_min, float &out_max) const {
+	ZN_ASSERT(_voxels != nullptr);
+
+	if (!_sdf_range_valid) {
+		ZN_PROFILE_SCOPE();
+		float min_value;
+		float max_value;
+		_voxels->get_range_f(min_value, max_value, VoxelBuffer::CHANNEL_SDF);
+		_sdf_min = min_value;
+		_sdf_max = max_value;
+		_sdf_range_valid = true;
+	}
+
+	out_min = _sdf_min;
+	out_max = _sdf_max;
+}
+
+namespace {
+
+template <typename T>
+uint64_t get_type_summary_t(const VoxelBuffer &voxels, const unsigned int channel) {
+	Span<const T> values;
+	ZN_ASSERT_RETURN_V(voxels.get_channel_data_read_only(channel, values), ~uint64_t(0));
+	uint64_t summary = 0;
+	for (const T v : values) {
+		summary |= uint64_t(1) << (v & 63);
+	}
+	return summary;
+}
+
+} // namespace
+
+uint64_t VoxelDataBlock::get_type_summary() const {
+	ZN_ASSERT(_voxels != nullptr);
+
+	if (!_type_summary_valid) {
+		ZN_PROFILE_SCOPE();
+		const VoxelBuffer &voxels = *_voxels;
+		const VoxelBuffer::ChannelId channel = VoxelBuffer::CHANNEL_TYPE;
+		uint64_t summary;
+
+		if (voxels.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_UNIFORM) {
+			summary = uint64_t(1) << (voxels.get_voxel(Vector3i(), channel) & 63);
+
+		} else {
+			switch (voxels.get_channel_depth(channel)) {
+				case VoxelBuffer::DEPTH_8_BIT:
+					summary = get_type_summary_t<uint8_t>(voxels, channel);
+					break;
+				case VoxelBuffer::DEPTH_16_BIT:
+					summary = get_type_summary_t<uint16_t>(voxels, channel);
+					break;
+				case VoxelBuffer::DEPTH_32_BIT:
+					summary = get_type_summary_t<uint32_t>(voxels, channel);
+					break;
+				case VoxelBuffer::DEPTH_64_BIT:
+					summary = get_type_summary_t<uint64_t>(voxels, channel);
+					break;
+				default:
+					ZN_PRINT_ERROR("Unhandled depth");
+					// Can't tell, so assume any value could be present
+					summary = ~uint64_t(0);
+					break;
+			}
+		}
+
+		_type_summary = summary;
+		_type_summary_valid = true;
+	}
+
+	return _type_summary;
+}
+
 } // namespace zylann::voxel
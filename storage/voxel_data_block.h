@@ -2,6 +2,7 @@
 #define VOXEL_DATA_BLOCK_H
 
 #include "../util/ref_count.h"
+#include <atomic>
 #include <memory>
 
 namespace zylann::voxel {
@@ -29,7 +30,9 @@ public:
 			_lod_index(src._lod_index),
 			_needs_lodding(src._needs_lodding),
 			_modified(src._modified),
-			_edited(src._edited) {}
+			_edited(src._edited) {
+		copy_cached_summaries(src);
+	}
 
 	VoxelDataBlock(const VoxelDataBlock &src) :
 			viewers(src.viewers),
@@ -37,7 +40,9 @@ public:
 			_lod_index(src._lod_index),
 			_needs_lodding(src._needs_lodding),
 			_modified(src._modified),
-			_edited(src._edited) {}
+			_edited(src._edited) {
+		copy_cached_summaries(src);
+	}
 
 	VoxelDataBlock &operator=(VoxelDataBlock &&src) {
 		viewers = src.viewers;
@@ -46,6 +51,7 @@ public:
 		_needs_lodding = src._needs_lodding;
 		_modified = src._modified;
 		_edited = src._edited;
+		copy_cached_summaries(src);
 		return *this;
 	}
 
@@ -56,6 +62,7 @@ public:
 		_needs_lodding = src._needs_lodding;
 		_modified = src._modified;
 		_edited = src._edited;
+		copy_cached_summaries(src);
 		return *this;
 	}
 
@@ -70,11 +77,13 @@ public:
 		return _voxels != nullptr;
 	}
 
-	// Get voxels, expecting them to be present
+	// Get voxels, expecting them to be present.
+	// Access is assumed to be for writing, so cached information about voxels is invalidated.
 	VoxelBuffer &get_voxels() {
 #ifdef DEBUG_ENABLED
 		ZN_ASSERT(_voxels != nullptr);
 #endif
+		invalidate_cached_summaries();
 		return *_voxels;
 	}
 
@@ -97,11 +106,32 @@ public:
 	void set_voxels(const std::shared_ptr<VoxelBuffer> &buffer) {
 		ZN_ASSERT_RETURN(buffer != nullptr);
 		_voxels = buffer;
+		invalidate_cached_summaries();
 	}
 
 	void clear_voxels() {
 		_voxels = nullptr;
 		_edited = false;
+		invalidate_cached_summaries();
+	}
+
+	// Gets the range of SDF values in the block, which allows queries such as raycasts to skip the block entirely.
+	// It is computed on first call and cached until voxels change. Requires voxels to be present.
+	// Can be called while the block is locked for reading only.
+	void get_sdf_range(float &out_min, float &out_max) const;
+
+	// Gets a summary of values in the TYPE channel, as a mask where bit `i` is set if at least one voxel has a value
+	// `v` such that `v % 64 == i`. Values sharing a bit can't be told apart, but if no bit of a given set of values is
+	// present, the block is known to contain none of them. For example, random ticks skip blocks that contain no
+	// tickable models that way.
+	// Cached the same way as the SDF range. Requires voxels to be present.
+	uint64_t get_type_summary() const;
+
+	// Must be called when voxels are modified.
+	// Requires the block to be locked for writing.
+	inline void invalidate_cached_summaries() {
+		_sdf_range_valid = false;
+		_type_summary_valid = false;
 	}
 
 	void set_modified(bool modified);
@@ -127,6 +157,14 @@ public:
 	}
 
 private:
+	inline void copy_cached_summaries(const VoxelDataBlock &src) {
+		_sdf_min = src._sdf_min.load();
+		_sdf_max = src._sdf_max.load();
+		_sdf_range_valid = src._sdf_range_valid.load();
+		_type_summary = src._type_summary.load();
+		_type_summary_valid = src._type_summary_valid.load();
+	}
+
 	// Voxel data. If null, it means the data may be obtained with procedural generation.
 	std::shared_ptr<VoxelBuffer> _voxels;
 
@@ -145,6 +183,16 @@ private:
 	// Once it becomes `true`, it usually never comes back to `false` unless reverted.
 	bool _edited = false;
 
+	// Cached range of SDF values. Atomic because it can be computed by concurrent readers (which will all compute the
+	// same result).
+	mutable std::atomic_bool _sdf_range_valid = { false };
+	mutable std::atomic<float> _sdf_min = { 0.f };
+	mutable std::atomic<float> _sdf_max = { 0.f };
+
+	// Cached summary of TYPE values, see `get_type_summary`
+	mutable std::atomic_bool _type_summary_valid = { false };
+	mutable std::atomic<uint64_t> _type_summary = { 0 };
+
 	// TODO Optimization: design a proper way to implement client-side caching for multiplayer
 	//
 	// Represents how many times the block was edited.
@@ -0,0 +1,234 @@
+#include "voxel_edit_journal.h"
+#include "../streams/voxel_block_serializer.h"
+#include "../util/errors.h"
+#include "../util/io/log.h"
+#include "../util/memory/memory.h"
+#include "../util/profiling.h"
+#include "voxel_buffer.h"
+#include "voxel_data_block.h"
+
+namespace zylann::voxel {
+
+size_t VoxelEditJournal::Edit::get_memory_usage() const {
+	size_t size = sizeof(Edit) + blocks.size() * sizeof(BlockDiff);
+	for (const BlockDiff &diff : blocks) {
+		size += diff.data.size() + diff.data_after.size();
+	}
+	return size;
+}
+
+namespace {
+
+void serialize_full(const VoxelBuffer *voxels, StdVector<uint8_t> &dst) {
+	if (voxels == nullptr) {
+		dst.clear();
+		return;
+	}
+	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(*voxels);
+	ZN_ASSERT_RETURN(result.success);
+	dst = result.data;
+}
+
+// Unlike `VoxelBuffer::equals`, doesn't depend on how channels are compressed, which can change without voxels changing
+// (diffs, saving...).
+bool has_same_voxels(const VoxelBuffer &a, const VoxelBuffer &b) {
+	if (a.get_size() != b.get_size()) {
+		return false;
+	}
+	const Vector3i size = a.get_size();
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (a.get_channel_depth(channel_index) != b.get_channel_depth(channel_index)) {
+			return false;
+		}
+		if (a.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM &&
+			b.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+			if (a.get_voxel(Vector3i(), channel_index) != b.get_voxel(Vector3i(), channel_index)) {
+				return false;
+			}
+			continue;
+		}
+		Vector3i pos;
+		for (pos.z = 0; pos.z < size.z; ++pos.z) {
+			for (pos.x = 0; pos.x < size.x; ++pos.x) {
+				for (pos.y = 0; pos.y < size.y; ++pos.y) {
+					if (a.get_voxel(pos, channel_index) != b.get_voxel(pos, channel_index)) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+bool VoxelEditJournal::make_block_diff(
+		const Vector3i block_position,
+		const VoxelBuffer *voxels_before,
+		const VoxelBuffer *voxels_after,
+		BlockDiff &out_diff
+) {
+	ZN_PROFILE_SCOPE();
+
+	if (voxels_before == nullptr && voxels_after == nullptr) {
+		return false;
+	}
+
+	out_diff.position = block_position;
+
+	if (voxels_before != nullptr && voxels_after != nullptr) {
+		if (voxels_before->equals(*voxels_after) && BlockSerializer::has_same_metadata(*voxels_before, *voxels_after)) {
+			return false;
+		}
+		// Runs setting voxels back to how they were
+		const BlockSerializer::SerializeResult undo_result =
+				BlockSerializer::serialize_diff_and_compress(*voxels_after, *voxels_before);
+		if (undo_result.success) {
+			out_diff.type = BlockDiff::TYPE_RUNS;
+			out_diff.data = undo_result.data;
+			// Same runs with values after the edit. Can't fail if the previous call succeeded.
+			const BlockSerializer::SerializeResult redo_result =
+					BlockSerializer::serialize_diff_and_compress(*voxels_before, *voxels_after);
+			ZN_ASSERT_RETURN_V(redo_result.success, false);
+			out_diff.data_after = redo_result.data;
+			return true;
+		}
+	}
+
+	out_diff.type = BlockDiff::TYPE_FULL;
+	serialize_full(voxels_before, out_diff.data);
+	serialize_full(voxels_after, out_diff.data_after);
+	return true;
+}
+
+bool VoxelEditJournal::can_apply_block_diff(const BlockDiff &diff, const bool forward, const VoxelDataBlock &block) {
+	switch (diff.type) {
+		case BlockDiff::TYPE_RUNS:
+			// Other voxels may have changed since the edit, that's fine since only the edited ones get set
+			return block.has_voxels();
+
+		case BlockDiff::TYPE_FULL: {
+			// The whole block gets replaced, so it must not have changed since the edit
+			const StdVector<uint8_t> &expected_state = forward ? diff.data : diff.data_after;
+			if (expected_state.size() == 0) {
+				return !block.has_voxels();
+			}
+			if (!block.has_voxels()) {
+				return false;
+			}
+			VoxelBuffer expected_voxels(VoxelBuffer::ALLOCATOR_POOL);
+			ZN_ASSERT_RETURN_V(
+					BlockSerializer::decompress_and_deserialize(to_span(expected_state), expected_voxels), false
+			);
+			const VoxelBuffer &voxels = block.get_voxels_const();
+			return has_same_voxels(voxels, expected_voxels) &&
+					BlockSerializer::has_same_metadata(voxels, expected_voxels);
+		}
+
+		default:
+			ZN_PRINT_ERROR("Unknown block diff type");
+			return false;
+	}
+}
+
+void VoxelEditJournal::apply_block_diff(const BlockDiff &diff, const bool forward, VoxelDataBlock &block) {
+	ZN_PROFILE_SCOPE();
+
+	const StdVector<uint8_t> &state = forward ? diff.data_after : diff.data;
+
+	switch (diff.type) {
+		case BlockDiff::TYPE_RUNS:
+			ZN_ASSERT_RETURN_MSG(block.has_voxels(), "Block lost its voxels since it was edited");
+			ZN_ASSERT_RETURN(BlockSerializer::decompress_and_apply_diff(to_span(state), block.get_voxels()));
+			break;
+
+		case BlockDiff::TYPE_FULL: {
+			if (state.size() == 0) {
+				block.clear_voxels();
+			} else {
+				std::shared_ptr<VoxelBuffer> voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+				ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(to_span(state), *voxels));
+				block.set_voxels(voxels);
+			}
+			// Make sure the change gets saved, even if the block has no voxels
+			block.set_modified(true);
+		} break;
+
+		default:
+			ZN_PRINT_ERROR("Unknown block diff type");
+			break;
+	}
+}
+
+void VoxelEditJournal::set_max_memory(size_t max_memory) {
+	_max_memory = max_memory;
+	if (_max_memory == 0) {
+		clear();
+	} else {
+		discard_oldest_edits();
+	}
+}
+
+void VoxelEditJournal::push(Edit &&edit) {
+	// Edits that were undone can no longer be redone
+	for (unsigned int i = _cursor; i < _edits.size(); ++i) {
+		_memory_usage -= _edits[i].get_memory_usage();
+	}
+	_edits.resize(_cursor);
+
+	_memory_usage += edit.get_memory_usage();
+	_edits.push_back(std::move(edit));
+	++_cursor;
+	++_tick;
+
+	discard_oldest_edits();
+}
+
+void VoxelEditJournal::discard_oldest_edits() {
+	// The latest edit is always kept, even if it alone exceeds the limit
+	unsigned int discarded_count = 0;
+	while (_memory_usage > _max_memory && discarded_count + 1 < _edits.size() && discarded_count < _cursor) {
+		_memory_usage -= _edits[discarded_count].get_memory_usage();
+		++discarded_count;
+	}
+	if (discarded_count > 0) {
+		_edits.erase(_edits.begin(), _edits.begin() + discarded_count);
+		_cursor -= discarded_count;
+	}
+}
+
+const VoxelEditJournal::Edit *VoxelEditJournal::get_undo_edit() const {
+	if (_cursor == 0) {
+		return nullptr;
+	}
+	return &_edits[_cursor - 1];
+}
+
+const VoxelEditJournal::Edit *VoxelEditJournal::get_redo_edit() const {
+	if (_cursor == _edits.size()) {
+		return nullptr;
+	}
+	return &_edits[_cursor];
+}
+
+void VoxelEditJournal::undo() {
+	ZN_ASSERT_RETURN(_cursor > 0);
+	--_cursor;
+	--_tick;
+}
+
+void VoxelEditJournal::redo() {
+	ZN_ASSERT_RETURN(_cursor < _edits.size());
+	++_cursor;
+	++_tick;
+}
+
+void VoxelEditJournal::clear() {
+	_edits.clear();
+	_cursor = 0;
+	_tick = 0;
+	_memory_usage = 0;
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,128 @@
+#ifndef VOXEL_EDIT_JOURNAL_H
+#define VOXEL_EDIT_JOURNAL_H
+
+#include "../util/containers/std_vector.h"
+#include "../util/math/box3i.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace zylann::voxel {
+
+class VoxelBuffer;
+class VoxelDataBlock;
+
+// Records edits done to voxel data at LOD0, so they can be undone and redone.
+// Each edit is stored as a list of per-block diffs. Diffs are compressed runs of the voxels that changed, with their
+// values before and after the edit. They are much smaller than a copy of the edited area, since most voxels of a block
+// are usually left untouched by an edit. Because they store values rather than differences, blocks can also be changed
+// by things the journal doesn't know about (async edits, network sync...) without getting corrupted by undos.
+// The oldest edits are discarded when the total size exceeds a limit.
+// Not thread-safe, `VoxelData` synchronizes access to it.
+class VoxelEditJournal {
+public:
+	// Blocks as they were before an edit, captured before voxels get modified.
+	struct Snapshot {
+		Box3i voxel_box;
+		StdVector<Vector3i> block_positions;
+		// Copies of voxels. Null where blocks had no voxels.
+		StdVector<std::shared_ptr<VoxelBuffer>> block_voxels;
+
+		inline bool is_empty() const {
+			return block_positions.size() == 0;
+		}
+
+		inline void clear() {
+			block_positions.clear();
+			block_voxels.clear();
+		}
+	};
+
+	struct BlockDiff {
+		enum Type : uint8_t {
+			// Runs of voxels that changed, only setting these voxels when applied
+			TYPE_RUNS,
+			// Both states are stored fully, because voxels were missing, or the format or metadata changed. An empty
+			// state means the block had no voxels. Such diffs replace the whole block, so they are only applied if
+			// the block is still in the state the edit left it in.
+			TYPE_FULL
+		};
+
+		Vector3i position;
+		Type type;
+		// State before the edit
+		StdVector<uint8_t> data;
+		// State after the edit
+		StdVector<uint8_t> data_after;
+	};
+
+	struct Edit {
+		Box3i voxel_box;
+		StdVector<BlockDiff> blocks;
+
+		size_t get_memory_usage() const;
+	};
+
+	// Computes the diff of a block between a snapshot of its voxels and their current state.
+	// Returns false if nothing changed.
+	static bool make_block_diff(
+			Vector3i block_position,
+			const VoxelBuffer *voxels_before,
+			const VoxelBuffer *voxels_after,
+			BlockDiff &out_diff
+	);
+
+	// Tests if a diff can be applied to a block without overwriting changes done since the edit.
+	static bool can_apply_block_diff(const BlockDiff &diff, bool forward, const VoxelDataBlock &block);
+
+	// Changes the state of a block from before the edit to after it if `forward` is true, or the reverse otherwise.
+	static void apply_block_diff(const BlockDiff &diff, bool forward, VoxelDataBlock &block);
+
+	// The journal is disabled when this is zero.
+	void set_max_memory(size_t max_memory);
+
+	inline size_t get_max_memory() const {
+		return _max_memory;
+	}
+
+	inline bool is_enabled() const {
+		return _max_memory > 0;
+	}
+
+	// Records a new edit. Edits that were undone can no longer be redone after this.
+	void push(Edit &&edit);
+
+	// Returns the latest edit that can be undone, or null if there is none.
+	const Edit *get_undo_edit() const;
+
+	// Returns the next edit that can be redone, or null if there is none.
+	const Edit *get_redo_edit() const;
+
+	// Moves back before the edit returned by `get_undo_edit`, once it has been reverted.
+	void undo();
+
+	// Moves after the edit returned by `get_redo_edit`, once it has been applied again.
+	void redo();
+
+	// Counts edits currently applied since the journal was created or cleared. It is incremented by new edits and
+	// redos, and decremented by undos. Can be used to identify a state of the voxel data.
+	inline uint32_t get_tick() const {
+		return _tick;
+	}
+
+	void clear();
+
+private:
+	void discard_oldest_edits();
+
+	// Edits below this index are applied, and the ones after can be redone
+	StdVector<Edit> _edits;
+	unsigned int _cursor = 0;
+	uint32_t _tick = 0;
+	size_t _memory_usage = 0;
+	size_t _max_memory = 0;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_EDIT_JOURNAL_H
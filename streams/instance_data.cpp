@@ -2,7 +2,9 @@
 #include "../constants/voxel_constants.h"
 #include "../util/io/serialization.h"
 #include "../util/math/basis.h"
+#include "../util/containers/fixed_array.h"
 #include "../util/math/funcs.h"
+#include "../util/profiling.h"
 #include "../util/string/format.h"
 
 namespace zylann::voxel {
@@ -30,30 +32,54 @@ inline float u8_to_norm(uint8_t v) {
 	return (static_cast<real_t>(v) - 0x7f) * zylann::voxel::constants::INV_0x7f;
 }
 
-struct CompressedQuaternion4b {
-	uint8_t x;
-	uint8_t y;
-	uint8_t z;
-	uint8_t w;
-
-	static CompressedQuaternion4b from_quaternion(Quaternionf q) {
-		CompressedQuaternion4b c;
-		c.x = norm_to_u8(q.x);
-		c.y = norm_to_u8(q.y);
-		c.z = norm_to_u8(q.z);
-		c.w = norm_to_u8(q.w);
-		return c;
-	}
+inline uint16_t quantize_position(float x, float inv_range) {
+	return math::clamp(static_cast<int>(x * inv_range * 0xffff + 0.5f), 0, 0xffff);
+}
 
-	Quaternionf to_quaternion() const {
-		Quaternionf q;
-		q.x = u8_to_norm(x);
-		q.y = u8_to_norm(y);
-		q.z = u8_to_norm(z);
-		q.w = u8_to_norm(w);
-		return math::normalized(q);
-	}
-};
+inline uint8_t quantize_scale(float s, float scale_min, float inv_scale_range) {
+	return math::clamp(static_cast<int>((s - scale_min) * inv_scale_range * 0xff + 0.5f), 0, 0xff);
+}
+
+void InstanceBlockData::LayerData::clear_instances() {
+	positions_x.clear();
+	positions_y.clear();
+	positions_z.clear();
+	scales.clear();
+	rotations.clear();
+}
+
+void InstanceBlockData::LayerData::reserve_instances(unsigned int count) {
+	positions_x.reserve(count);
+	positions_y.reserve(count);
+	positions_z.reserve(count);
+	scales.reserve(count);
+	rotations.reserve(count * 4);
+}
+
+void InstanceBlockData::LayerData::resize_instances(unsigned int count) {
+	positions_x.resize(count);
+	positions_y.resize(count);
+	positions_z.resize(count);
+	scales.resize(count);
+	rotations.resize(count * 4);
+}
+
+void InstanceBlockData::LayerData::add_instance(const Transform3f &transform, float quantized_position_range) {
+	const float inv_position_range = 1.f / quantized_position_range;
+	positions_x.push_back(quantize_position(transform.origin.x, inv_position_range));
+	positions_y.push_back(quantize_position(transform.origin.y, inv_position_range));
+	positions_z.push_back(quantize_position(transform.origin.z, inv_position_range));
+
+	const float scale = transform.basis.get_scale_abs().y;
+	const float inv_scale_range = 1.f / (get_quantized_scale_max() - scale_min);
+	scales.push_back(quantize_scale(scale, scale_min, inv_scale_range));
+
+	const Quaternionf q = transform.basis.get_rotation_quaternion();
+	rotations.push_back(norm_to_u8(q.x));
+	rotations.push_back(norm_to_u8(q.y));
+	rotations.push_back(norm_to_u8(q.z));
+	rotations.push_back(norm_to_u8(q.w));
+}
 
 bool serialize_instance_block_data(const InstanceBlockData &src, StdVector<uint8_t> &dst) {
 	const uint8_t instance_format = InstanceBlockData::FORMAT_SIMPLE_11B_V1;
@@ -64,52 +90,44 @@ bool serialize_instance_block_data(const InstanceBlockData &src, StdVector<uint8
 	zylann::MemoryWriter w(dst, zylann::ENDIANNESS_LITTLE_ENDIAN);
 
 	ZN_ASSERT_RETURN_V(src.position_range >= 0.f, false);
-	const float position_range = math::max(src.position_range, InstanceBlockData::POSITION_RANGE_MINIMUM);
 
 	w.store_8(INSTANCE_BLOCK_FORMAT_VERSION_1);
 	w.store_8(src.layers.size());
-	w.store_float(position_range);
+	w.store_float(src.get_quantized_position_range());
 
 	// TODO Introduce a margin to position coordinates, stuff can spawn offset from the ground.
 	// Or just compute the ranges
-	const float pos_norm_scale = 1.f / position_range;
 
 	for (size_t i = 0; i < src.layers.size(); ++i) {
 		const InstanceBlockData::LayerData &layer = src.layers[i];
 
 		ZN_ASSERT_RETURN_V(layer.scale_max >= layer.scale_min, false);
 
-		float scale_min = layer.scale_min;
-		float scale_max = layer.scale_max;
-		if (scale_max - scale_min < InstanceBlockData::SIMPLE_11B_V1_SCALE_RANGE_MINIMUM) {
-			scale_min = layer.scale_min;
-			scale_max = scale_min + InstanceBlockData::SIMPLE_11B_V1_SCALE_RANGE_MINIMUM;
-		}
+		const unsigned int instance_count = layer.get_instance_count();
+		ZN_ASSERT_RETURN_V(layer.positions_x.size() == instance_count, false);
+		ZN_ASSERT_RETURN_V(layer.positions_y.size() == instance_count, false);
+		ZN_ASSERT_RETURN_V(layer.positions_z.size() == instance_count, false);
+		ZN_ASSERT_RETURN_V(layer.rotations.size() == instance_count * 4, false);
 
 		w.store_16(layer.id);
-		w.store_16(layer.instances.size());
-		w.store_float(scale_min);
-		w.store_float(scale_max);
+		w.store_16(instance_count);
+		w.store_float(layer.scale_min);
+		w.store_float(layer.get_quantized_scale_max());
 		w.store_8(instance_format);
 
-		const float scale_norm_scale = 1.f / (scale_max - scale_min);
+		// Instances are already quantized, they only need to be interleaved
+		for (unsigned int j = 0; j < instance_count; ++j) {
+			w.store_16(layer.positions_x[j]);
+			w.store_16(layer.positions_y[j]);
+			w.store_16(layer.positions_z[j]);
 
-		for (size_t j = 0; j < layer.instances.size(); ++j) {
-			const InstanceBlockData::InstanceData &instance = layer.instances[j];
+			w.store_8(layer.scales[j]);
 
-			w.store_16(static_cast<uint16_t>(pos_norm_scale * instance.transform.origin.x * 0xffff));
-			w.store_16(static_cast<uint16_t>(pos_norm_scale * instance.transform.origin.y * 0xffff));
-			w.store_16(static_cast<uint16_t>(pos_norm_scale * instance.transform.origin.z * 0xffff));
-
-			const float scale = instance.transform.basis.get_scale_abs().y;
-			w.store_8(static_cast<uint8_t>(scale_norm_scale * (scale - scale_min) * 0xff));
-
-			const Quaternionf q = instance.transform.basis.get_rotation_quaternion();
-			const CompressedQuaternion4b cq = CompressedQuaternion4b::from_quaternion(q);
-			w.store_8(cq.x);
-			w.store_8(cq.y);
-			w.store_8(cq.z);
-			w.store_8(cq.w);
+			const unsigned int ri = j * 4;
+			w.store_8(layer.rotations[ri + 0]);
+			w.store_8(layer.rotations[ri + 1]);
+			w.store_8(layer.rotations[ri + 2]);
+			w.store_8(layer.rotations[ri + 3]);
 		}
 	}
 
@@ -142,32 +160,28 @@ bool deserialize_instance_block_data(InstanceBlockData &dst, Span<const uint8_t>
 		layer.id = r.get_16();
 
 		const uint16_t instance_count = r.get_16();
-		layer.instances.resize(instance_count);
+		layer.resize_instances(instance_count);
 
 		layer.scale_min = r.get_float();
 		layer.scale_max = r.get_float();
 		ZN_ASSERT_RETURN_V(layer.scale_max >= layer.scale_min, false);
-		const float scale_range = layer.scale_max - layer.scale_min;
 
 		const uint8_t instance_format = r.get_8();
 		ZN_ASSERT_RETURN_V(instance_format == expected_instance_format, false);
 
-		for (size_t j = 0; j < layer.instances.size(); ++j) {
-			const float x = (static_cast<float>(r.get_16()) / 0xffff) * dst.position_range;
-			const float y = (static_cast<float>(r.get_16()) / 0xffff) * dst.position_range;
-			const float z = (static_cast<float>(r.get_16()) / 0xffff) * dst.position_range;
+		// Instances are kept quantized, they only need to be de-interleaved
+		for (unsigned int j = 0; j < instance_count; ++j) {
+			layer.positions_x[j] = r.get_16();
+			layer.positions_y[j] = r.get_16();
+			layer.positions_z[j] = r.get_16();
 
-			const float s = (static_cast<float>(r.get_8()) / 0xff) * scale_range + layer.scale_min;
+			layer.scales[j] = r.get_8();
 
-			CompressedQuaternion4b cq;
-			cq.x = r.get_8();
-			cq.y = r.get_8();
-			cq.z = r.get_8();
-			cq.w = r.get_8();
-			const Quaternionf q = cq.to_quaternion();
-
-			InstanceBlockData::InstanceData &instance = layer.instances[j];
-			instance.transform = Transform3f(Basis3f(q).scaled(s), Vector3f(x, y, z));
+			const unsigned int ri = j * 4;
+			layer.rotations[ri + 0] = r.get_8();
+			layer.rotations[ri + 1] = r.get_8();
+			layer.rotations[ri + 2] = r.get_8();
+			layer.rotations[ri + 3] = r.get_8();
 		}
 	}
 
@@ -178,4 +192,148 @@ bool deserialize_instance_block_data(InstanceBlockData &dst, Span<const uint8_t>
 	return true;
 }
 
+namespace {
+
+// Instances are decoded in small batches. Each step loops over all instances of the batch with no branches and
+// contiguous arrays, so compilers can vectorize them.
+static const unsigned int DECODE_BATCH_SIZE = 16;
+
+struct DecodedInstanceBatch {
+	FixedArray<float, DECODE_BATCH_SIZE> px;
+	FixedArray<float, DECODE_BATCH_SIZE> py;
+	FixedArray<float, DECODE_BATCH_SIZE> pz;
+	// Rows of the basis
+	FixedArray<float, DECODE_BATCH_SIZE> m00;
+	FixedArray<float, DECODE_BATCH_SIZE> m01;
+	FixedArray<float, DECODE_BATCH_SIZE> m02;
+	FixedArray<float, DECODE_BATCH_SIZE> m10;
+	FixedArray<float, DECODE_BATCH_SIZE> m11;
+	FixedArray<float, DECODE_BATCH_SIZE> m12;
+	FixedArray<float, DECODE_BATCH_SIZE> m20;
+	FixedArray<float, DECODE_BATCH_SIZE> m21;
+	FixedArray<float, DECODE_BATCH_SIZE> m22;
+};
+
+void decode_instance_batch(
+		const InstanceBlockData::LayerData &layer,
+		const unsigned int begin,
+		const unsigned int count,
+		const float quantized_position_range,
+		const Vector3f offset,
+		DecodedInstanceBatch &b
+) {
+	const float position_scale = quantized_position_range / 0xffff;
+	const float scale_scale = (layer.get_quantized_scale_max() - layer.scale_min) / 0xff;
+	const float scale_min = layer.scale_min;
+
+	const uint16_t *positions_x = layer.positions_x.data() + begin;
+	const uint16_t *positions_y = layer.positions_y.data() + begin;
+	const uint16_t *positions_z = layer.positions_z.data() + begin;
+	const uint8_t *scales = layer.scales.data() + begin;
+	const uint8_t *rotations = layer.rotations.data() + begin * 4;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		b.px[i] = static_cast<float>(positions_x[i]) * position_scale + offset.x;
+		b.py[i] = static_cast<float>(positions_y[i]) * position_scale + offset.y;
+		b.pz[i] = static_cast<float>(positions_z[i]) * position_scale + offset.z;
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		const float qx = u8_to_norm(rotations[i * 4 + 0]);
+		const float qy = u8_to_norm(rotations[i * 4 + 1]);
+		const float qz = u8_to_norm(rotations[i * 4 + 2]);
+		const float qw = u8_to_norm(rotations[i * 4 + 3]);
+		const float s = static_cast<float>(scales[i]) * scale_scale + scale_min;
+
+		// Same as `Basis3f::set_quaternion`, which also normalizes the quaternion. A null quaternion gives identity.
+		const float d = qx * qx + qy * qy + qz * qz + qw * qw;
+		const float k = d > 0.f ? 2.f / d : 0.f;
+		const float xs = qx * k;
+		const float ys = qy * k;
+		const float zs = qz * k;
+		const float wx = qw * xs;
+		const float wy = qw * ys;
+		const float wz = qw * zs;
+		const float xx = qx * xs;
+		const float xy = qx * ys;
+		const float xz = qx * zs;
+		const float yy = qy * ys;
+		const float yz = qy * zs;
+		const float zz = qz * zs;
+
+		b.m00[i] = s * (1.f - (yy + zz));
+		b.m01[i] = s * (xy - wz);
+		b.m02[i] = s * (xz + wy);
+		b.m10[i] = s * (xy + wz);
+		b.m11[i] = s * (1.f - (xx + zz));
+		b.m12[i] = s * (yz - wx);
+		b.m20[i] = s * (xz - wy);
+		b.m21[i] = s * (yz + wx);
+		b.m22[i] = s * (1.f - (xx + yy));
+	}
+}
+
+} // namespace
+
+void decode_instances_to_multimesh_buffer(
+		const InstanceBlockData::LayerData &layer,
+		float quantized_position_range,
+		Vector3f offset,
+		Span<float> dst
+) {
+	ZN_PROFILE_SCOPE();
+	const unsigned int instance_count = layer.get_instance_count();
+	ZN_ASSERT_RETURN(dst.size() == instance_count * 12);
+
+	DecodedInstanceBatch b;
+
+	for (unsigned int begin = 0; begin < instance_count; begin += DECODE_BATCH_SIZE) {
+		const unsigned int count = math::min(instance_count - begin, DECODE_BATCH_SIZE);
+		decode_instance_batch(layer, begin, count, quantized_position_range, offset, b);
+
+		float *d = dst.data() + begin * 12;
+		for (unsigned int i = 0; i < count; ++i) {
+			d[0] = b.m00[i];
+			d[1] = b.m01[i];
+			d[2] = b.m02[i];
+			d[3] = b.px[i];
+			d[4] = b.m10[i];
+			d[5] = b.m11[i];
+			d[6] = b.m12[i];
+			d[7] = b.py[i];
+			d[8] = b.m20[i];
+			d[9] = b.m21[i];
+			d[10] = b.m22[i];
+			d[11] = b.pz[i];
+			d += 12;
+		}
+	}
+}
+
+void decode_instances_to_transforms(
+		const InstanceBlockData::LayerData &layer,
+		float quantized_position_range,
+		Vector3f offset,
+		Span<Transform3f> dst
+) {
+	ZN_PROFILE_SCOPE();
+	const unsigned int instance_count = layer.get_instance_count();
+	ZN_ASSERT_RETURN(dst.size() == instance_count);
+
+	DecodedInstanceBatch b;
+
+	for (unsigned int begin = 0; begin < instance_count; begin += DECODE_BATCH_SIZE) {
+		const unsigned int count = math::min(instance_count - begin, DECODE_BATCH_SIZE);
+		decode_instance_batch(layer, begin, count, quantized_position_range, offset, b);
+
+		for (unsigned int i = 0; i < count; ++i) {
+			Transform3f &t = dst[begin + i];
+			t.basis.rows[0] = Vector3f(b.m00[i], b.m01[i], b.m02[i]);
+			t.basis.rows[1] = Vector3f(b.m10[i], b.m11[i], b.m12[i]);
+			t.basis.rows[2] = Vector3f(b.m20[i], b.m21[i], b.m22[i]);
+			t.origin = Vector3f(b.px[i], b.py[i], b.pz[i]);
+		}
+	}
+}
+
 } // namespace zylann::voxel
@@ -3,17 +3,13 @@
 
 #include "../util/containers/span.h"
 #include "../util/containers/std_vector.h"
+#include "../util/math/funcs.h"
 #include "../util/math/transform3f.h"
 
 namespace zylann::voxel {
 
 // Stores data to pass around until it either gets saved or turned into actual instances
 struct InstanceBlockData {
-	struct InstanceData {
-		// Transform of the instance, relative to the origin of the data block.
-		Transform3f transform;
-	};
-
 	enum VoxelInstanceFormat {
 		// Position is lossy-compressed based on the size of the block
 		// - uint16_t x;
@@ -40,16 +36,46 @@ struct InstanceBlockData {
 	// Because scale is quantized we need its range, but it cannot be zero so it may be clamped to this.
 	static const float SIMPLE_11B_V1_SCALE_RANGE_MINIMUM;
 
+	// Instances are kept quantized in memory, the same way they are serialized with `FORMAT_SIMPLE_11B_V1`, which
+	// takes 11 bytes per instance instead of 48 for a transform. They are stored as a structure of arrays so they can
+	// be decoded in batches.
 	struct LayerData {
 		uint16_t id;
 		float scale_min;
 		float scale_max;
-		StdVector<InstanceData> instances;
+		// Positions relative to the origin of the data block, normalized to the position range of the block
+		StdVector<uint16_t> positions_x;
+		StdVector<uint16_t> positions_y;
+		StdVector<uint16_t> positions_z;
+		// Uniform scales normalized between `scale_min` and `get_quantized_scale_max()`
+		StdVector<uint8_t> scales;
+		// Quaternions, 4 components per instance in XYZW order
+		StdVector<uint8_t> rotations;
+
+		inline unsigned int get_instance_count() const {
+			return scales.size();
+		}
+
+		// Scale range cannot be zero, so it may be larger than the one that was set
+		inline float get_quantized_scale_max() const {
+			return math::max(scale_max, scale_min + SIMPLE_11B_V1_SCALE_RANGE_MINIMUM);
+		}
+
+		void clear_instances();
+		void reserve_instances(unsigned int count);
+		void resize_instances(unsigned int count);
+		// Scale range must be set before adding instances. Transforms are relative to the origin of the data block.
+		void add_instance(const Transform3f &transform, float quantized_position_range);
 	};
 
 	float position_range;
 	StdVector<LayerData> layers;
 
+	// Position range cannot be zero, so it may be larger than the one that was set
+	inline float get_quantized_position_range() const {
+		return math::max(position_range, POSITION_RANGE_MINIMUM);
+	}
+
 	void copy_to(InstanceBlockData &dst) const {
 		// It's all POD so it should work for now
 		dst = *this;
@@ -59,6 +85,23 @@ struct InstanceBlockData {
 bool serialize_instance_block_data(const InstanceBlockData &src, StdVector<uint8_t> &dst);
 bool deserialize_instance_block_data(InstanceBlockData &dst, Span<const uint8_t> src);
 
+// Decodes instances of a layer directly into the buffer layout of a `MultiMesh` using `TRANSFORM_3D` (12 floats per
+// instance, rows of the basis each followed by a component of the origin). `offset` is added to positions.
+void decode_instances_to_multimesh_buffer(
+		const InstanceBlockData::LayerData &layer,
+		float quantized_position_range,
+		Vector3f offset,
+		Span<float> dst
+);
+
+// Decodes instances of a layer into transforms. `offset` is added to positions.
+void decode_instances_to_transforms(
+		const InstanceBlockData::LayerData &layer,
+		float quantized_position_range,
+		Vector3f offset,
+		Span<Transform3f> dst
+);
+
 } // namespace zylann::voxel
 
 #endif // VOXEL_INSTANCE_DATA_H
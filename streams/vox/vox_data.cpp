@@ -219,6 +219,9 @@ Error Data::_load_from_file(String fpath) {
 
 	Vector3i last_size;
 
+	// Re-used between chunks and loads to reduce allocations
+	static thread_local StdVector<uint8_t> tls_chunk_bytes;
+
 	clear();
 
 	while (f.get_position() < file_length) {
@@ -246,33 +249,44 @@ Error Data::_load_from_file(String fpath) {
 			model->size = last_size;
 
 			const uint32_t num_voxels = f.get_32();
+			ERR_FAIL_COND_V(chunk_size < sizeof(uint32_t), ERR_PARSE_ERROR);
+			ERR_FAIL_COND_V(num_voxels > (chunk_size - sizeof(uint32_t)) / 4, ERR_PARSE_ERROR);
+
+			// Voxels are read all at once and decoded from memory. Going through `FileAccess` for every byte is much
+			// slower on models with millions of voxels.
+			StdVector<uint8_t> &voxel_bytes = tls_chunk_bytes;
+			voxel_bytes.resize(num_voxels * 4);
+			ERR_FAIL_COND_V(godot::get_buffer(f, to_span(voxel_bytes)) != voxel_bytes.size(), ERR_PARSE_ERROR);
+
+			// Unsigned, so negative coordinates can't happen and bounds are checked with one comparison
+			const unsigned int size_x = model->size.x;
+			const unsigned int size_y = model->size.y;
+			const unsigned int size_z = model->size.z;
+			Span<uint8_t> color_indexes = to_span(model->color_indexes);
 
 			for (uint32_t i = 0; i < num_voxels; ++i) {
-				Vector3i pos;
-				pos.x = f.get_8();
-				pos.y = f.get_8();
-				pos.z = f.get_8();
-				const uint32_t c = f.get_8();
-				pos = magica_to_opengl(pos);
-				ERR_FAIL_COND_V(pos.x >= model->size.x || pos.x < 0, ERR_PARSE_ERROR);
-				ERR_FAIL_COND_V(pos.y >= model->size.y || pos.y < 0, ERR_PARSE_ERROR);
-				ERR_FAIL_COND_V(pos.z >= model->size.z || pos.z < 0, ERR_PARSE_ERROR);
-				model->color_indexes[Vector3iUtil::get_zxy_index(pos, model->size)] = c;
+				const uint8_t *v = &voxel_bytes[i * 4];
+				// Inline version of `magica_to_opengl`
+				const unsigned int x = v[1];
+				const unsigned int y = v[2];
+				const unsigned int z = v[0];
+				ERR_FAIL_COND_V(x >= size_x || y >= size_y || z >= size_z, ERR_PARSE_ERROR);
+				color_indexes[y + size_y * (x + size_x * z)] = v[3];
 			}
 
 			_models.push_back(std::move(model));
 
 		} else if (strcmp(chunk_id, "RGBA") == 0) {
+			StdVector<uint8_t> &palette_bytes = tls_chunk_bytes;
+			palette_bytes.resize(PALETTE_SIZE * 4);
+			ERR_FAIL_COND_V(godot::get_buffer(f, to_span(palette_bytes)) != palette_bytes.size(), ERR_PARSE_ERROR);
+
+			// The last color of the chunk is not used, index 0 is always empty
 			_palette[0] = Color8{ 0, 0, 0, 0 };
 			for (uint32_t i = 1; i < _palette.size(); ++i) {
-				Color8 c;
-				c.r = f.get_8();
-				c.g = f.get_8();
-				c.b = f.get_8();
-				c.a = f.get_8();
-				_palette[i] = c;
+				const uint8_t *c = &palette_bytes[(i - 1) * 4];
+				_palette[i] = Color8{ c[0], c[1], c[2], c[3] };
 			}
-			f.get_32();
 
 		} else if (strcmp(chunk_id, "nTRN") == 0) {
 			UniquePtr<TransformNode> node_ptr = make_unique_instance<TransformNode>();
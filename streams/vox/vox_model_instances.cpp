@@ -0,0 +1,234 @@
+#include "vox_model_instances.h"
+#include "../../engine/parallel_for.h"
+#include "../../storage/funcs.h"
+#include "../../util/dstack.h"
+#include "../../util/godot/core/array.h"
+#include "../../util/godot/macros.h"
+#include "../../util/math/conv.h"
+#include "../../util/math/transform_3d.h"
+#include "../../util/profiling.h"
+#include "vox_data.h"
+
+namespace zylann::voxel::magica {
+
+namespace {
+
+struct ForEachModelInstanceArgs {
+	const Model *model;
+	// Pivot position, which turns out to be at the center in MagicaVoxel
+	Vector3i position;
+	Basis basis;
+};
+
+template <typename F>
+Error for_each_model_instance_in_scene_graph(const Data &data, int node_id, Transform3D transform, int depth, F f) {
+	//
+	ERR_FAIL_COND_V(depth > 10, ERR_INVALID_DATA);
+	const Node *vox_node = data.get_node(node_id);
+
+	switch (vox_node->type) {
+		case Node::TYPE_TRANSFORM: {
+			const TransformNode *vox_transform_node = reinterpret_cast<const TransformNode *>(vox_node);
+			// Calculate global transform of the child
+			const Transform3D child_trans(
+					transform.basis * vox_transform_node->rotation.basis, transform.xform(vox_transform_node->position)
+			);
+			for_each_model_instance_in_scene_graph(data, vox_transform_node->child_node_id, child_trans, depth + 1, f);
+		} break;
+
+		case Node::TYPE_GROUP: {
+			const GroupNode *vox_group_node = reinterpret_cast<const GroupNode *>(vox_node);
+			for (unsigned int i = 0; i < vox_group_node->child_node_ids.size(); ++i) {
+				const int child_node_id = vox_group_node->child_node_ids[i];
+				for_each_model_instance_in_scene_graph(data, child_node_id, transform, depth + 1, f);
+			}
+		} break;
+
+		case Node::TYPE_SHAPE: {
+			const ShapeNode *vox_shape_node = reinterpret_cast<const ShapeNode *>(vox_node);
+			ForEachModelInstanceArgs args;
+			args.model = &data.get_model(vox_shape_node->model_id);
+			args.position = math::round_to_int(transform.origin);
+			args.basis = transform.basis;
+			f(args);
+		} break;
+
+		default:
+			ERR_FAIL_V(ERR_INVALID_DATA);
+			break;
+	}
+
+	return OK;
+}
+
+template <typename F>
+void for_each_model_instance(const Data &vox_data, F f) {
+	if (vox_data.get_model_count() == 0) {
+		return;
+	}
+	if (vox_data.get_root_node_id() == -1) {
+		// No scene graph
+		ForEachModelInstanceArgs args;
+		args.model = &vox_data.get_model(0);
+		// Put at center to match what MagicaVoxel would do
+		args.position = args.model->size / 2;
+		args.basis = Basis();
+		f(args);
+		return;
+	}
+	for_each_model_instance_in_scene_graph(vox_data, vox_data.get_root_node_id(), Transform3D(), 0, f);
+}
+
+void extract_model_instance(const ForEachModelInstanceArgs &args, ModelInstance &out_instance) {
+	ZN_PROFILE_SCOPE();
+	const Model &model = *args.model;
+
+	if (args.basis == Basis()) {
+		// No transformation
+		out_instance.voxels->create(model.size);
+		out_instance.voxels->decompress_channel(VoxelBuffer::CHANNEL_COLOR);
+
+		Span<uint8_t> dst_color_indices;
+		ERR_FAIL_COND(!out_instance.voxels->get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices));
+		ERR_FAIL_COND(model.color_indexes.size() != dst_color_indices.size());
+		memcpy(dst_color_indices.data(), model.color_indexes.data(), dst_color_indices.size() * sizeof(uint8_t));
+
+	} else {
+		IntBasis basis;
+		basis.x = to_vec3i(args.basis.get_column(Vector3::AXIS_X));
+		basis.y = to_vec3i(args.basis.get_column(Vector3::AXIS_Y));
+		basis.z = to_vec3i(args.basis.get_column(Vector3::AXIS_Z));
+
+		// Rotations only swap axes, so the destination size is known upfront and the model can be transformed
+		// directly into the buffer, without a temporary copy
+		const int xa = basis.x.x != 0 ? 0 : basis.x.y != 0 ? 1 : 2;
+		const int ya = basis.y.x != 0 ? 0 : basis.y.y != 0 ? 1 : 2;
+		const int za = basis.z.x != 0 ? 0 : basis.z.y != 0 ? 1 : 2;
+		Vector3i dst_size;
+		dst_size[xa] = model.size.x;
+		dst_size[ya] = model.size.y;
+		dst_size[za] = model.size.z;
+
+		out_instance.voxels->create(dst_size);
+		out_instance.voxels->decompress_channel(VoxelBuffer::CHANNEL_COLOR);
+
+		Span<uint8_t> dst_color_indices;
+		ERR_FAIL_COND(!out_instance.voxels->get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices));
+		transform_3d_array_zxy(to_span_const(model.color_indexes), dst_color_indices, model.size, basis);
+	}
+
+	out_instance.position = args.position - out_instance.voxels->get_size() / 2;
+}
+
+} // namespace
+
+void extract_model_instances(const Data &vox_data, StdVector<ModelInstance> &out_instances) {
+	ZN_DSTACK();
+	ZN_PROFILE_SCOPE();
+
+	// Walking the scene graph is cheap, gather instances first so models can be converted in parallel
+	StdVector<ForEachModelInstanceArgs> instance_args;
+	for_each_model_instance(vox_data, [&instance_args](ForEachModelInstanceArgs args) {
+		ERR_FAIL_COND(args.model == nullptr);
+		instance_args.push_back(args);
+	});
+
+	const size_t first_index = out_instances.size();
+	out_instances.resize(first_index + instance_args.size());
+	for (size_t i = first_index; i < out_instances.size(); ++i) {
+		// Not using the memory pool, the editor would keep holding onto large amounts of memory after imports
+		out_instances[i].voxels = make_unique_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+	}
+
+	auto extract_range = [&instance_args, &out_instances, first_index](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; ++i) {
+			extract_model_instance(instance_args[i], out_instances[first_index + i]);
+		}
+	};
+
+	parallel_for_ranges(instance_args.size(), 1, extract_range);
+}
+
+bool make_single_voxel_grid(
+		Span<const ModelInstance> instances,
+		unsigned int padding,
+		Vector3i &out_origin,
+		VoxelBuffer &out_voxels
+) {
+	ZN_PROFILE_SCOPE();
+	ERR_FAIL_COND_V(instances.size() == 0, false);
+
+	// Determine total size
+	const ModelInstance &first_instance = instances[0];
+	ERR_FAIL_COND_V(first_instance.voxels == nullptr, false);
+	Box3i bounding_box(first_instance.position, first_instance.voxels->get_size());
+	for (unsigned int instance_index = 1; instance_index < instances.size(); ++instance_index) {
+		const ModelInstance &mi = instances[instance_index];
+		ERR_FAIL_COND_V(mi.voxels == nullptr, false);
+		bounding_box.merge_with(Box3i(mi.position, mi.voxels->get_size()));
+	}
+
+	// Extra sanity check
+	// 3 gigabytes
+	const size_t limit = 3'000'000'000ull;
+	const size_t volume = Vector3iUtil::get_volume(bounding_box.size);
+	ERR_FAIL_COND_V_MSG(
+			volume > limit,
+			false,
+			String("Vox data is too big to be meshed as a single mesh ({0}: {0} bytes)")
+					.format(varray(bounding_box.size, ZN_SIZE_T_TO_VARIANT(volume)))
+	);
+
+	const Vector3i dst_size = bounding_box.size + Vector3iUtil::create(padding * 2);
+	out_voxels.create(dst_size);
+	out_voxels.set_channel_depth(VoxelBuffer::CHANNEL_COLOR, VoxelBuffer::DEPTH_8_BIT);
+	out_voxels.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
+
+	Span<uint8_t> dst_color_indices;
+	ERR_FAIL_COND_V(!out_voxels.get_channel_as_bytes(VoxelBuffer::CHANNEL_COLOR, dst_color_indices), false);
+
+	const Vector3i dst_offset = Vector3iUtil::create(padding) - bounding_box.position;
+
+	// The grid is split in slabs along Z, which are contiguous in memory. Each slab receives the parts of all instances
+	// overlapping it, in instance order, so later instances still overwrite earlier ones. Slabs don't overlap, so they
+	// can be filled from different threads.
+	static const int SLAB_THICKNESS = 16;
+
+	auto fill_slabs = [instances, dst_color_indices, dst_size, dst_offset](unsigned int begin, unsigned int end) {
+		ZN_PROFILE_SCOPE_NAMED("Fill slabs");
+		const int slab_min_z = begin * SLAB_THICKNESS;
+		const int slab_max_z = math::min(static_cast<int>(end * SLAB_THICKNESS), dst_size.z);
+		const Box3i slab_box =
+				Box3i::from_min_max(Vector3i(0, 0, slab_min_z), Vector3i(dst_size.x, dst_size.y, slab_max_z));
+
+		for (const ModelInstance &mi : instances) {
+			const Box3i dst_box(mi.position + dst_offset, mi.voxels->get_size());
+			if (!dst_box.intersects(slab_box)) {
+				continue;
+			}
+			const Box3i clipped_dst_box = dst_box.clipped(slab_box);
+
+			Span<const uint8_t> src_color_indices;
+			// Instances are created with a decompressed color channel
+			ERR_CONTINUE(!mi.voxels->get_channel_as_bytes_read_only(VoxelBuffer::CHANNEL_COLOR, src_color_indices));
+
+			const Vector3i src_min = clipped_dst_box.position - dst_box.position;
+			copy_3d_region_zxy(
+					dst_color_indices,
+					dst_size,
+					clipped_dst_box.position,
+					src_color_indices,
+					mi.voxels->get_size(),
+					src_min,
+					src_min + clipped_dst_box.size
+			);
+		}
+	};
+
+	parallel_for_ranges(math::ceildiv(dst_size.z, SLAB_THICKNESS), 1, fill_slabs);
+
+	out_origin = bounding_box.position;
+	return true;
+}
+
+} // namespace zylann::voxel::magica
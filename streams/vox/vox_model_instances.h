@@ -0,0 +1,36 @@
+#ifndef VOX_MODEL_INSTANCES_H
+#define VOX_MODEL_INSTANCES_H
+
+#include "../../storage/voxel_buffer.h"
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/memory/memory.h"
+
+namespace zylann::voxel::magica {
+
+class Data;
+
+struct ModelInstance {
+	// Model with baked rotation, with color indices in the 8-bit color channel
+	UniquePtr<VoxelBuffer> voxels;
+	// Lowest corner position
+	Vector3i position;
+};
+
+// Gathers all models placed in the scene graph, and converts them into voxel buffers with their rotation baked in.
+// If the data has no scene graph, the first model is used, centered on the origin like MagicaVoxel would do.
+// Conversions run on threads of `VoxelEngine`.
+void extract_model_instances(const Data &vox_data, StdVector<ModelInstance> &out_instances);
+
+// Merges model instances into a single grid in the 8-bit color channel, where later instances overwrite earlier ones.
+// The grid has a margin of `padding` voxels on every side. Slabs of the grid are filled on threads of `VoxelEngine`.
+bool make_single_voxel_grid(
+		Span<const ModelInstance> instances,
+		unsigned int padding,
+		Vector3i &out_origin,
+		VoxelBuffer &out_voxels
+);
+
+} // namespace zylann::voxel::magica
+
+#endif // VOX_MODEL_INSTANCES_H
@@ -1,8 +1,10 @@
 #include "voxel_block_serializer.h"
 #include "../storage/voxel_buffer.h"
 #include "../storage/voxel_memory_pool.h"
+#include "../util/containers/std_unordered_map.h"
 #include "../util/dstack.h"
 #include "../util/godot/classes/file_access.h"
+#include "../util/hash_funcs.h"
 #include "../util/io/serialization.h"
 #include "../util/math/vector3i.h"
 #include "../util/profiling.h"
@@ -60,48 +62,6 @@ size_t get_metadata_size_in_bytes(const VoxelMetadata &meta) {
 	return size;
 }
 
-size_t get_metadata_size_in_bytes(const VoxelBuffer &buffer) {
-	size_t size = 0;
-
-	const FlatMapMoveOnly<Vector3i, VoxelMetadata> &voxel_metadata = buffer.get_voxel_metadata();
-	for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator it = voxel_metadata.begin();
-		 it != voxel_metadata.end();
-		 ++it) {
-		const Vector3i pos = it->key;
-
-		ERR_FAIL_COND_V_MSG(
-				pos.x < 0 || static_cast<uint32_t>(pos.x) >= VoxelBuffer::MAX_SIZE,
-				0,
-				"Invalid voxel metadata X position"
-		);
-		ERR_FAIL_COND_V_MSG(
-				pos.y < 0 || static_cast<uint32_t>(pos.y) >= VoxelBuffer::MAX_SIZE,
-				0,
-				"Invalid voxel metadata Y position"
-		);
-		ERR_FAIL_COND_V_MSG(
-				pos.z < 0 || static_cast<uint32_t>(pos.z) >= VoxelBuffer::MAX_SIZE,
-				0,
-				"Invalid voxel metadata Z position"
-		);
-
-		size += 3 * sizeof(uint16_t); // Positions are stored as 3 unsigned shorts
-		size += get_metadata_size_in_bytes(it->value);
-	}
-
-	// If no metadata is found at all, nothing is serialized, not even null.
-	// It spares 24 bytes (40 if real_t == double),
-	// and is backward compatible with saves made before introduction of metadata.
-
-	const VoxelMetadata &block_meta = buffer.get_block_metadata();
-
-	if (size != 0 || block_meta.get_type() != VoxelMetadata::TYPE_EMPTY) {
-		size += get_metadata_size_in_bytes(block_meta);
-	}
-
-	return size;
-}
-
 template <typename T>
 inline void write(uint8_t *&dst, T d) {
 	*(T *)dst = d;
@@ -139,30 +99,165 @@ void serialize_metadata(const VoxelMetadata &meta, MemoryWriterExistingBuffer &m
 	}
 }
 
-// The target buffer MUST have correct size. Recoverable errors must have been checked before.
-void serialize_metadata(Span<uint8_t> p_dst, const VoxelBuffer &buffer) {
-	ByteSpanWithPosition bs(p_dst, 0);
+// Appends a metadata item to the end of a buffer. Returns false if it could not be serialized.
+bool serialize_metadata(const VoxelMetadata &meta, StdVector<uint8_t> &dst) {
+	const size_t size = get_metadata_size_in_bytes(meta);
+	if (size == 0) {
+		return false;
+	}
+	const size_t prev_size = dst.size();
+	dst.resize(prev_size + size);
+	ByteSpanWithPosition bs(to_span(dst), prev_size);
 	MemoryWriterExistingBuffer mw(bs, ENDIANNESS_LITTLE_ENDIAN);
+	serialize_metadata(meta, mw);
+	dst.resize(bs.pos);
+	return true;
+}
+
+void store_varuint(MemoryWriter &mw, uint64_t v) {
+	while (v >= 0x80) {
+		mw.store_8((v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	mw.store_8(v);
+}
+
+bool get_varuint(MemoryReader &mr, uint64_t &out_v) {
+	uint64_t v = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		ZN_ASSERT_RETURN_V(mr.pos < mr.data.size(), false);
+		const uint8_t b = mr.get_8();
+		v |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if ((b & 0x80) == 0) {
+			out_v = v;
+			return true;
+		}
+	}
+	ZN_PRINT_ERROR("Variable-length integer is too long");
+	return false;
+}
+
+uint32_t hash_bytes(Span<const uint8_t> bytes) {
+	uint32_t h = HASH_MURMUR3_SEED;
+	size_t i = 0;
+	for (; i + sizeof(uint32_t) <= bytes.size(); i += sizeof(uint32_t)) {
+		uint32_t v;
+		memcpy(&v, &bytes[i], sizeof(uint32_t));
+		h = hash_murmur3_one_32(v, h);
+	}
+	for (; i < bytes.size(); ++i) {
+		h = hash_murmur3_one_32(bytes[i], h);
+	}
+	return hash_fmix32(h ^ bytes.size());
+}
 
+// Serialized metadata items, where identical items are stored only once.
+// Blocks often contain many voxels with the same metadata (empty containers, default states...).
+struct MetadataPalette {
+	static const uint32_t NO_ITEM = std::numeric_limits<uint32_t>::max();
+
+	struct Item {
+		uint32_t offset;
+		uint32_t size;
+		// Next item having the same hash
+		uint32_t next;
+	};
+
+	// Items one after the other, in the order of their index
+	StdVector<uint8_t> data;
+	StdVector<Item> items;
+	StdUnorderedMap<uint32_t, uint32_t> first_item_from_hash;
+
+	void clear() {
+		data.clear();
+		items.clear();
+		first_item_from_hash.clear();
+	}
+
+	bool add(const VoxelMetadata &meta, uint32_t &out_index) {
+		const size_t offset = data.size();
+		if (!serialize_metadata(meta, data)) {
+			return false;
+		}
+		Span<const uint8_t> bytes = to_span_const(data).sub(offset);
+		const uint32_t hash = hash_bytes(bytes);
+
+		uint32_t next = NO_ITEM;
+		auto it = first_item_from_hash.find(hash);
+		if (it != first_item_from_hash.end()) {
+			for (uint32_t i = it->second; i != NO_ITEM; i = items[i].next) {
+				const Item &item = items[i];
+				if (item.size == bytes.size() && memcmp(&data[item.offset], bytes.data(), bytes.size()) == 0) {
+					data.resize(offset);
+					out_index = i;
+					return true;
+				}
+			}
+			next = it->second;
+		}
+
+		out_index = items.size();
+		items.push_back(Item{ static_cast<uint32_t>(offset), static_cast<uint32_t>(bytes.size()), next });
+		first_item_from_hash[hash] = out_index;
+		return true;
+	}
+};
+
+// Appends metadata of the buffer to the end of `dst`. If the buffer has no metadata, nothing is appended.
+// If metadata could not be serialized, returns false and nothing is appended either.
+bool serialize_metadata(const VoxelBuffer &buffer, StdVector<uint8_t> &dst) {
+	const VoxelMetadataMap &voxel_metadata = buffer.get_voxel_metadata();
 	const VoxelMetadata &block_meta = buffer.get_block_metadata();
-	serialize_metadata(block_meta, mw);
-
-	const FlatMapMoveOnly<Vector3i, VoxelMetadata> &voxel_metadata = buffer.get_voxel_metadata();
-	for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator it = voxel_metadata.begin();
-		 it != voxel_metadata.end();
-		 ++it) {
-		// Serializing key as ushort because it's more than enough for a 3D dense array
-		static_assert(
-				VoxelBuffer::MAX_SIZE <= std::numeric_limits<uint16_t>::max(),
-				"Maximum size exceeds serialization support"
-		);
-		const Vector3i pos = it->key;
-		mw.store_16(pos.x);
-		mw.store_16(pos.y);
-		mw.store_16(pos.z);
 
-		serialize_metadata(it->value, mw);
+	// If no metadata is found at all, nothing is serialized, not even null.
+	// It spares 24 bytes (40 if real_t == double),
+	// and is backward compatible with saves made before introduction of metadata.
+	if (voxel_metadata.size() == 0 && block_meta.get_type() == VoxelMetadata::TYPE_EMPTY) {
+		return true;
+	}
+
+	static thread_local MetadataPalette tls_palette;
+	static thread_local StdVector<uint8_t> tls_entries;
+	MetadataPalette &palette = tls_palette;
+	StdVector<uint8_t> &entries = tls_entries;
+	palette.clear();
+	entries.clear();
+
+	const size_t begin = dst.size();
+	if (!serialize_metadata(block_meta, dst)) {
+		return false;
+	}
+
+	// Keys are visited in increasing order, so they are stored as small differences
+	MemoryWriter entries_writer(entries, ENDIANNESS_LITTLE_ENDIAN);
+	uint64_t prev_key = 0;
+	bool success = true;
+
+	voxel_metadata.for_each_key([&palette, &entries_writer, &prev_key, &success](
+										uint64_t key, const VoxelMetadata &meta
+								) {
+		uint32_t palette_index;
+		if (!success || !palette.add(meta, palette_index)) {
+			success = false;
+			return;
+		}
+		store_varuint(entries_writer, key - prev_key);
+		store_varuint(entries_writer, palette_index);
+		prev_key = key;
+	});
+
+	if (!success) {
+		dst.resize(begin);
+		return false;
 	}
+
+	MemoryWriter mw(dst, ENDIANNESS_LITTLE_ENDIAN);
+	store_varuint(mw, palette.items.size());
+	mw.store_buffer(to_span_const(palette.data));
+	store_varuint(mw, voxel_metadata.size());
+	mw.store_buffer(to_span_const(entries));
+
+	return true;
 }
 
 template <typename T>
@@ -218,10 +313,52 @@ bool deserialize_metadata(Span<const uint8_t> p_src, VoxelBuffer &buffer) {
 
 	ZN_ASSERT_RETURN_V(deserialize_metadata(buffer.get_block_metadata(), mr), false);
 
-	typedef FlatMapMoveOnly<Vector3i, VoxelMetadata>::Pair Pair;
-	static thread_local StdVector<Pair> tls_pairs;
+	uint64_t palette_size;
+	ZN_ASSERT_RETURN_V(get_varuint(mr, palette_size), false);
+	// Items take at least one byte
+	ZN_ASSERT_RETURN_V(palette_size <= mr.data.size() - mr.pos, false);
+
+	static thread_local StdVector<VoxelMetadata> tls_palette;
 	// Clear when exiting scope (including cases of error) so we don't store dangling Variants
-	ClearOnExit<StdVector<Pair>> clear_tls_pairs{ tls_pairs };
+	ClearOnExit<StdVector<VoxelMetadata>> clear_tls_palette{ tls_palette };
+	tls_palette.resize(palette_size);
+
+	for (VoxelMetadata &meta : tls_palette) {
+		ZN_ASSERT_RETURN_V_MSG(deserialize_metadata(meta, mr), false, "Failed to deserialize voxel metadata");
+	}
+
+	uint64_t entry_count;
+	ZN_ASSERT_RETURN_V(get_varuint(mr, entry_count), false);
+
+	VoxelMetadataMap &voxel_metadata = buffer.get_voxel_metadata();
+	uint64_t key = 0;
+
+	for (uint64_t i = 0; i < entry_count; ++i) {
+		uint64_t key_delta;
+		uint64_t palette_index;
+		ZN_ASSERT_RETURN_V(get_varuint(mr, key_delta), false);
+		ZN_ASSERT_RETURN_V(get_varuint(mr, palette_index), false);
+		key += key_delta;
+
+		ZN_ASSERT_RETURN_V_MSG(
+				voxel_metadata.is_key_valid(key),
+				false,
+				format("Invalid voxel metadata key {} for buffer of size {}", key, buffer.get_size())
+		);
+		ZN_ASSERT_RETURN_V(palette_index < tls_palette.size(), false);
+
+		VoxelMetadata &meta = voxel_metadata.get_or_create_from_key(key);
+		meta.copy_from(tls_palette[palette_index]);
+	}
+
+	return true;
+}
+
+// Version 4 stored the position of every voxel metadata, each followed by its own item.
+bool deserialize_metadata_v4(Span<const uint8_t> p_src, VoxelBuffer &buffer) {
+	MemoryReader mr(p_src, ENDIANNESS_LITTLE_ENDIAN);
+
+	ZN_ASSERT_RETURN_V(deserialize_metadata(buffer.get_block_metadata(), mr), false);
 
 	while (mr.pos < mr.data.size()) {
 		Vector3i pos;
@@ -229,27 +366,24 @@ bool deserialize_metadata(Span<const uint8_t> p_src, VoxelBuffer &buffer) {
 		pos.y = mr.get_16();
 		pos.z = mr.get_16();
 
+		VoxelMetadata meta;
+		ZN_ASSERT_RETURN_V_MSG(
+				deserialize_metadata(meta, mr), false, format("Failed to deserialize voxel metadata {}", pos)
+		);
+
 		ZN_ASSERT_CONTINUE_MSG(
 				buffer.is_position_valid(pos),
 				format("Invalid voxel metadata position {} for buffer of size {}", pos, buffer.get_size())
 		);
 
-		// VoxelMetadata &vmeta = buffer.get_or_create_voxel_metadata(pos);
-		tls_pairs.resize(tls_pairs.size() + 1);
-		Pair &p = tls_pairs.back();
-		p.key = pos;
-		ZN_ASSERT_RETURN_V_MSG(
-				deserialize_metadata(p.value, mr), false, format("Failed to deserialize voxel metadata {}", pos)
-		);
+		VoxelMetadata *dst_meta = buffer.get_or_create_voxel_metadata(pos);
+		*dst_meta = std::move(meta);
 	}
 
-	// Set all metadata at once, FlatMap is faster to initialize this way
-	buffer.clear_and_set_voxel_metadata(to_span(tls_pairs));
-
 	return true;
 }
 
-size_t get_size_in_bytes(const VoxelBuffer &buffer, size_t &metadata_size) {
+size_t get_size_in_bytes(const VoxelBuffer &buffer, size_t metadata_size) {
 	// Version and size
 	size_t size = 1 * sizeof(uint8_t) + 3 * sizeof(uint16_t);
 
@@ -277,8 +411,6 @@ size_t get_size_in_bytes(const VoxelBuffer &buffer, size_t &metadata_size) {
 		}
 	}
 
-	metadata_size = get_metadata_size_in_bytes(buffer);
-
 	size_t metadata_size_with_header = 0;
 	if (metadata_size > 0) {
 		metadata_size_with_header = metadata_size + BLOCK_METADATA_HEADER_SIZE;
@@ -298,8 +430,11 @@ SerializeResult serialize(const VoxelBuffer &voxel_buffer) {
 	// Cannot serialize an empty block
 	ERR_FAIL_COND_V(Vector3iUtil::get_volume(voxel_buffer.get_size()) == 0, SerializeResult(dst_data, false));
 
-	size_t expected_metadata_size = 0;
-	const size_t expected_data_size = get_size_in_bytes(voxel_buffer, expected_metadata_size);
+	// Metadata has more reasons to fail. If a recoverable error occurs while serializing it,
+	// we just discard all metadata as if it was empty.
+	serialize_metadata(voxel_buffer, metadata_tmp);
+
+	const size_t expected_data_size = get_size_in_bytes(voxel_buffer, metadata_tmp.size());
 	dst_data.reserve(expected_data_size);
 
 	MemoryWriter f(dst_data, ENDIANNESS_LITTLE_ENDIAN);
@@ -364,13 +499,8 @@ SerializeResult serialize(const VoxelBuffer &voxel_buffer) {
 		}
 	}
 
-	// Metadata has more reasons to fail. If a recoverable error occurs prior to serializing,
-	// we just discard all metadata as if it was empty.
-	if (expected_metadata_size > 0) {
-		f.store_32(expected_metadata_size);
-		metadata_tmp.resize(expected_metadata_size);
-		// This function brings me joy. </irony>
-		serialize_metadata(to_span(metadata_tmp), voxel_buffer);
+	if (metadata_tmp.size() > 0) {
+		f.store_32(metadata_tmp.size());
 		f.store_buffer(to_span(metadata_tmp));
 	}
 
@@ -608,6 +738,10 @@ bool deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer) {
 			return deserialize(to_span(migrated_data), out_voxel_buffer);
 		} break;
 
+		case 4:
+			// Only the metadata format changed in version 5
+			break;
+
 		default:
 			ERR_FAIL_COND_V(format_version != BLOCK_FORMAT_VERSION, false);
 	}
@@ -684,7 +818,11 @@ bool deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer) {
 		ERR_FAIL_COND_V(f.get_position() + metadata_size > p_data.size(), false);
 		metadata_tmp.resize(metadata_size);
 		f.get_buffer(to_span(metadata_tmp));
-		deserialize_metadata(to_span(metadata_tmp), out_voxel_buffer);
+		if (format_version == 4) {
+			deserialize_metadata_v4(to_span(metadata_tmp), out_voxel_buffer);
+		} else {
+			deserialize_metadata(to_span(metadata_tmp), out_voxel_buffer);
+		}
 	}
 
 	// Failure at this indicates file corruption
@@ -740,5 +878,209 @@ bool decompress_and_deserialize(FileAccess &f, unsigned int size_to_read, VoxelB
 	return decompress_and_deserialize(to_span(compressed_data), out_voxel_buffer);
 }
 
+bool has_same_metadata(const VoxelBuffer &a, const VoxelBuffer &b) {
+	if (a.get_voxel_metadata().size() != b.get_voxel_metadata().size()) {
+		return false;
+	}
+	// Comparing serialized forms, because metadata doesn't have comparison operators (custom types are opaque)
+	thread_local StdVector<uint8_t> tls_a;
+	thread_local StdVector<uint8_t> tls_b;
+	tls_a.clear();
+	tls_b.clear();
+	serialize_metadata(a, tls_a);
+	serialize_metadata(b, tls_b);
+	if (tls_a.size() != tls_b.size()) {
+		return false;
+	}
+	return tls_a.size() == 0 || memcmp(tls_a.data(), tls_b.data(), tls_a.size()) == 0;
+}
+
+namespace {
+
+inline uint64_t read_raw_voxel(Span<const uint8_t> channel_data, size_t i, unsigned int depth_bytes) {
+	uint64_t v = 0;
+	// Assumes little-endian, like channel data in the full block format
+	memcpy(&v, &channel_data[i * depth_bytes], depth_bytes);
+	return v;
+}
+
+} // namespace
+
+SerializeResult serialize_diff_and_compress(const VoxelBuffer &base, const VoxelBuffer &current) {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<uint8_t> &dst_data = get_tls_data();
+	StdVector<uint8_t> &compressed_data = get_tls_compressed_data();
+	dst_data.clear();
+
+	if (base.get_size() != current.get_size() || !has_same_metadata(base, current)) {
+		// Not an error, the caller is expected to serialize the whole buffer instead
+		return SerializeResult(compressed_data, false);
+	}
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (base.get_channel_depth(channel_index) != current.get_channel_depth(channel_index)) {
+			return SerializeResult(compressed_data, false);
+		}
+	}
+
+	const Vector3i size = current.get_size();
+	ERR_FAIL_COND_V(size.x > std::numeric_limits<uint16_t>().max(), SerializeResult(compressed_data, false));
+	ERR_FAIL_COND_V(size.y > std::numeric_limits<uint16_t>().max(), SerializeResult(compressed_data, false));
+	ERR_FAIL_COND_V(size.z > std::numeric_limits<uint16_t>().max(), SerializeResult(compressed_data, false));
+
+	MemoryWriter f(dst_data, ENDIANNESS_LITTLE_ENDIAN);
+
+	f.store_8(BLOCK_DIFF_FORMAT_VERSION);
+	f.store_16(size.x);
+	f.store_16(size.y);
+	f.store_16(size.z);
+
+	// Channel mask is written after channels are compared
+	const size_t channel_mask_pos = dst_data.size();
+	f.store_8(0);
+	uint8_t channel_mask = 0;
+
+	const size_t volume = Vector3iUtil::get_volume(size);
+
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		const VoxelBuffer::Compression base_compression = base.get_channel_compression(channel_index);
+		const VoxelBuffer::Compression current_compression = current.get_channel_compression(channel_index);
+
+		if (base_compression == VoxelBuffer::COMPRESSION_UNIFORM &&
+			current_compression == VoxelBuffer::COMPRESSION_UNIFORM &&
+			base.get_voxel(Vector3i(), channel_index) == current.get_voxel(Vector3i(), channel_index)) {
+			// Fast path, nothing changed
+			continue;
+		}
+
+		const VoxelBuffer::Depth depth = current.get_channel_depth(channel_index);
+		const unsigned int depth_bytes = VoxelBuffer::get_depth_byte_count(depth);
+
+		// Uniform channels are read through their single value
+		Span<const uint8_t> base_data;
+		Span<const uint8_t> current_data;
+		const bool base_is_uniform = !base.get_channel_as_bytes_read_only(channel_index, base_data);
+		const bool current_is_uniform = !current.get_channel_as_bytes_read_only(channel_index, current_data);
+		const uint64_t base_uniform_value = base_is_uniform ? base.get_voxel(Vector3i(), channel_index) : 0;
+		const uint64_t current_uniform_value =
+				current_is_uniform ? current.get_voxel(Vector3i(), channel_index) : 0;
+
+		const size_t channel_begin_pos = dst_data.size();
+		f.store_8(depth);
+		const size_t run_count_pos = dst_data.size();
+		f.store_32(0);
+		uint32_t run_count = 0;
+
+		// Runs are stored as (skipped voxels count, changed voxels count, new values).
+		// Most edits are spatially coherent so changed voxels tend to group in few runs along Y.
+		size_t prev_run_end = 0;
+		size_t i = 0;
+		while (i < volume) {
+			const uint64_t bv = base_is_uniform ? base_uniform_value : read_raw_voxel(base_data, i, depth_bytes);
+			const uint64_t cv =
+					current_is_uniform ? current_uniform_value : read_raw_voxel(current_data, i, depth_bytes);
+			if (bv == cv) {
+				++i;
+				continue;
+			}
+
+			const size_t run_begin = i;
+			f.store_32(run_begin - prev_run_end);
+			const size_t run_length_pos = dst_data.size();
+			f.store_32(0);
+
+			while (i < volume) {
+				const uint64_t bv2 =
+						base_is_uniform ? base_uniform_value : read_raw_voxel(base_data, i, depth_bytes);
+				const uint64_t cv2 =
+						current_is_uniform ? current_uniform_value : read_raw_voxel(current_data, i, depth_bytes);
+				if (bv2 == cv2) {
+					break;
+				}
+				const size_t value_pos = dst_data.size();
+				dst_data.resize(value_pos + depth_bytes);
+				memcpy(&dst_data[value_pos], &cv2, depth_bytes);
+				++i;
+			}
+
+			const uint32_t run_length = i - run_begin;
+			memcpy(&dst_data[run_length_pos], &run_length, sizeof(uint32_t));
+			prev_run_end = i;
+			++run_count;
+		}
+
+		if (run_count == 0) {
+			// Representations differed but voxels are the same
+			dst_data.resize(channel_begin_pos);
+			continue;
+		}
+
+		memcpy(&dst_data[run_count_pos], &run_count, sizeof(uint32_t));
+		channel_mask |= (1 << channel_index);
+	}
+
+	dst_data[channel_mask_pos] = channel_mask;
+
+	const bool success = CompressedData::compress(
+			Span<const uint8_t>(dst_data.data(), 0, dst_data.size()), compressed_data, CompressedData::COMPRESSION_LZ4
+	);
+	ERR_FAIL_COND_V(!success, SerializeResult(compressed_data, false));
+
+	return SerializeResult(compressed_data, true);
+}
+
+bool decompress_and_apply_diff(Span<const uint8_t> p_data, VoxelBuffer &inout_voxel_buffer) {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<uint8_t> &data = get_tls_data();
+	ERR_FAIL_COND_V(!CompressedData::decompress(p_data, data), false);
+
+	MemoryReader f(to_span_const(data), ENDIANNESS_LITTLE_ENDIAN);
+
+	const uint8_t format_version = f.get_8();
+	ERR_FAIL_COND_V(format_version != BLOCK_DIFF_FORMAT_VERSION, false);
+
+	Vector3i size;
+	size.x = f.get_16();
+	size.y = f.get_16();
+	size.z = f.get_16();
+	ERR_FAIL_COND_V_MSG(size != inout_voxel_buffer.get_size(), false, "Diff doesn't match the size of the buffer");
+
+	const size_t volume = Vector3iUtil::get_volume(size);
+	const uint8_t channel_mask = f.get_8();
+
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if ((channel_mask & (1 << channel_index)) == 0) {
+			continue;
+		}
+
+		const VoxelBuffer::Depth depth = static_cast<VoxelBuffer::Depth>(f.get_8());
+		ERR_FAIL_COND_V(depth != inout_voxel_buffer.get_channel_depth(channel_index), false);
+		const unsigned int depth_bytes = VoxelBuffer::get_depth_byte_count(depth);
+
+		inout_voxel_buffer.decompress_channel(channel_index);
+		Span<uint8_t> channel_data;
+		ERR_FAIL_COND_V(!inout_voxel_buffer.get_channel_as_bytes(channel_index, channel_data), false);
+
+		const uint32_t run_count = f.get_32();
+		size_t i = 0;
+
+		for (uint32_t run_index = 0; run_index < run_count; ++run_index) {
+			i += f.get_32();
+			const uint32_t run_length = f.get_32();
+			ERR_FAIL_COND_V(i + run_length > volume, false);
+			ERR_FAIL_COND_V(f.pos + run_length * depth_bytes > f.data.size(), false);
+
+			memcpy(&channel_data[i * depth_bytes], &f.data[f.pos], run_length * depth_bytes);
+			f.pos += run_length * depth_bytes;
+			i += run_length;
+		}
+	}
+
+	inout_voxel_buffer.compress_uniform_channels();
+
+	return true;
+}
+
 } // namespace BlockSerializer
 } // namespace zylann::voxel
@@ -19,7 +19,9 @@ class VoxelBuffer;
 namespace BlockSerializer {
 
 // Latest version, used when serializing
-static const uint8_t BLOCK_FORMAT_VERSION = 4;
+static const uint8_t BLOCK_FORMAT_VERSION = 5;
+// Version of the format used by diffs. Diffs are not meant to be stored, only transmitted or kept in memory.
+static const uint8_t BLOCK_DIFF_FORMAT_VERSION = 1;
 
 struct SerializeResult {
 	// The lifetime of the pointed object is only valid in the calling thread,
@@ -38,6 +40,16 @@ SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer);
 bool decompress_and_deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer);
 bool decompress_and_deserialize(FileAccess &f, unsigned int size_to_read, VoxelBuffer &out_voxel_buffer);
 
+// Serializes only voxels of `current` that differ from `base`, as runs of new values. Applying the result to a buffer
+// sets these voxels to their value in `current`, so applying it more than once, or to a buffer that already has some
+// of these changes, is harmless. Both buffers must have the same size and channel depths, and the same metadata.
+// If that's not the case, success will be false and the whole buffer should be serialized instead.
+SerializeResult serialize_diff_and_compress(const VoxelBuffer &base, const VoxelBuffer &current);
+bool decompress_and_apply_diff(Span<const uint8_t> p_data, VoxelBuffer &inout_voxel_buffer);
+
+// Tests if two buffers have the same block and voxel metadata.
+bool has_same_metadata(const VoxelBuffer &a, const VoxelBuffer &b);
+
 // Temporary thread-local buffers for internal use
 StdVector<uint8_t> &get_tls_data();
 StdVector<uint8_t> &get_tls_compressed_data();
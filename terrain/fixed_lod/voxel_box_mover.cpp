@@ -3,7 +3,9 @@
 #include "../../meshers/cubes/voxel_mesher_cubes.h"
 #include "../../storage/voxel_buffer.h"
 #include "../../storage/voxel_data.h"
+#include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/math/conv.h"
 #include "../../util/profiling.h"
 #include "voxel_terrain.h"
 
@@ -67,63 +69,6 @@ real_t calculate_i_offset(const AABB &box, AABB other, real_t motion, int i, int
 	return motion;
 }
 
-// Gets the transformed vector for moving a box and slide.
-// This algorithm is free from tunnelling for axis-aligned movement,
-// except in some high-speed diagonal cases or huge size differences:
-// For example, if a box is fast enough to have a diagonal motion jumping from A to B,
-// it will pass through C if that other box is the only other one:
-//
-//  o---o
-//  | A |
-//  o---o
-//          o---o
-//          | C |
-//          o---o
-//                  o---o
-//                  | B |
-//                  o---o
-//
-// TODO one way to fix this would be to try a "hot side" projection instead
-//
-Vector3 get_motion(AABB box, Vector3 motion, Span<const AABB> environment_boxes) {
-	// The bounding box is expanded to include it's estimated version at next update.
-	// This also makes the algorithm tunnelling-free
-	const AABB expanded_box = expand_with_vector(box, motion);
-
-	StdVector<AABB> colliding_boxes;
-	for (size_t i = 0; i < environment_boxes.size(); ++i) {
-		const AABB &other = environment_boxes[i];
-		if (expanded_box.intersects(other)) {
-			colliding_boxes.push_back(other);
-		}
-	}
-
-	if (colliding_boxes.size() == 0) {
-		return motion;
-	}
-
-	// print("Colliding: ", colliding_boxes.size())
-
-	Vector3 new_motion = motion;
-
-	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
-		new_motion.y = calculate_i_offset(colliding_boxes[i], box, new_motion.y, 1, 0, 2);
-	}
-	box.position.y += new_motion.y;
-
-	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
-		new_motion.x = calculate_i_offset(colliding_boxes[i], box, new_motion.x, 0, 1, 2);
-	}
-	box.position.x += new_motion.x;
-
-	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
-		new_motion.z = calculate_i_offset(colliding_boxes[i], box, new_motion.z, 2, 1, 0);
-	}
-	box.position.z += new_motion.z;
-
-	return new_motion;
-}
-
 // bool raycast_down(Span<const AABB> aabbs, Vector3 ray_origin, real_t &out_hit_y) {
 // 	if (aabbs.size() == 0) {
 // 		return false;
@@ -186,118 +131,347 @@ bool intersects(Span<const AABB> aabbs, const AABB &box) {
 	return false;
 }
 
-void collect_boxes(VoxelTerrain &p_terrain, AABB query_box, uint32_t collision_nask, StdVector<AABB> &potential_boxes) {
-	ZN_PROFILE_SCOPE();
-	const VoxelData &voxels = p_terrain.get_storage();
+// How a voxel collides
+enum CellType : uint8_t {
+	CELL_EMPTY,
+	// Unit cube. Tested directly in the grid, without generating boxes.
+	CELL_FULL_CUBE,
+	// Arbitrary collision boxes, which are listed separately
+	CELL_BOXES
+};
+
+// Voxels around a moving box, classified by how they collide
+struct CollisionGrid {
+	Box3i box;
+	// Indexed in ZXY order, like voxel buffers
+	StdVector<uint8_t> cells;
+	// Collision boxes of `CELL_BOXES` voxels
+	StdVector<AABB> boxes;
+	bool has_full_cubes = false;
+
+	inline uint8_t get_cell(Vector3i pos) const {
+		return cells[Vector3iUtil::get_zxy_index(pos - box.position, box.size)];
+	}
+};
+
+// State shared by all boxes moved in the same batch.
+// One instance is reused per thread, so its containers don't get reallocated on every call.
+struct CollisionContext {
+	VoxelData *data = nullptr;
+	// If null, voxels are considered cubes if their COLOR is not zero, like `VoxelMesherCubes`
+	const VoxelBlockyLibraryBase::BakedData *blocky_library = nullptr;
+	uint32_t collision_mask = 0;
+
+	// Voxels of blocks already looked up in the batch. Null where voxels are not loaded.
+	StdUnorderedMap<Vector3i, std::shared_ptr<VoxelBuffer>> block_cache;
+
+	// Reused for every box
+	CollisionGrid grid;
+	StdVector<AABB> all_boxes;
+
+	void begin(
+			VoxelData &p_data,
+			const VoxelBlockyLibraryBase::BakedData *p_blocky_library,
+			uint32_t p_collision_mask
+	) {
+		data = &p_data;
+		blocky_library = p_blocky_library;
+		collision_mask = p_collision_mask;
+	}
 
-	const int min_x = int(Math::floor(query_box.position.x));
-	const int min_y = int(Math::floor(query_box.position.y));
-	const int min_z = int(Math::floor(query_box.position.z));
+	// Blocks must not be kept alive after the batch
+	void end() {
+		block_cache.clear();
+		data = nullptr;
+		blocky_library = nullptr;
+	}
 
-	const Vector3 query_box_end = query_box.position + query_box.size;
-	const int max_x = int(Math::ceil(query_box_end.x));
-	const int max_y = int(Math::ceil(query_box_end.y));
-	const int max_z = int(Math::ceil(query_box_end.z));
+	// The block must be locked for reading
+	std::shared_ptr<VoxelBuffer> get_block_voxels(Vector3i bpos) {
+		auto it = block_cache.find(bpos);
+		if (it != block_cache.end()) {
+			return it->second;
+		}
+		std::shared_ptr<VoxelBuffer> voxels = data->try_get_block_voxels(bpos);
+		block_cache.insert({ bpos, voxels });
+		return voxels;
+	}
+};
 
-	Vector3i i(min_x, min_y, min_z);
+inline uint8_t get_cell_type(const CollisionContext &ctx, const uint64_t value) {
+	if (ctx.blocky_library == nullptr) {
+		return value != 0 ? CELL_FULL_CUBE : CELL_EMPTY;
+	}
+	if (!ctx.blocky_library->has_model(value)) {
+		return CELL_EMPTY;
+	}
+	const VoxelBlockyModel::BakedData &model = ctx.blocky_library->models[value];
+	if ((model.box_collision_mask & ctx.collision_mask) == 0 || model.box_collision_aabbs.size() == 0) {
+		return CELL_EMPTY;
+	}
+	return model.box_collision_is_full_cube ? CELL_FULL_CUBE : CELL_BOXES;
+}
 
-	Ref<VoxelMesherBlocky> mesher_blocky;
-	Ref<VoxelMesherCubes> mesher_cubes;
+inline void set_cell(CollisionContext &ctx, const Vector3i pos, const uint64_t value) {
+	CollisionGrid &grid = ctx.grid;
+	const uint8_t cell_type = get_cell_type(ctx, value);
+	grid.cells[Vector3iUtil::get_zxy_index(pos - grid.box.position, grid.box.size)] = cell_type;
+
+	if (cell_type == CELL_FULL_CUBE) {
+		grid.has_full_cubes = true;
+
+	} else if (cell_type == CELL_BOXES) {
+		const VoxelBlockyModel::BakedData &model = ctx.blocky_library->models[value];
+		for (const AABB &aabb : model.box_collision_aabbs) {
+			AABB world_box = aabb;
+			world_box.position += pos;
+			grid.boxes.push_back(world_box);
+		}
+	}
+}
 
-	if (zylann::godot::try_get_as(p_terrain.get_mesher(), mesher_blocky)) {
-		Ref<VoxelBlockyLibraryBase> library_ref = mesher_blocky->get_library();
-		ERR_FAIL_COND_MSG(library_ref.is_null(), "VoxelMesherBlocky has no library assigned");
-		const int channel = VoxelBuffer::CHANNEL_TYPE;
-		VoxelSingleValue defval;
-		defval.i = 0;
-
-		const VoxelBlockyLibraryBase::BakedData &baked_data = library_ref->get_baked_data();
-
-		// TODO Optimization: read the whole box of voxels at once, querying individually is slower
-		for (i.z = min_z; i.z < max_z; ++i.z) {
-			for (i.y = min_y; i.y < max_y; ++i.y) {
-				for (i.x = min_x; i.x < max_x; ++i.x) {
-					const int type_id = voxels.get_voxel(i, channel, defval).i;
-
-					if (baked_data.has_model(type_id)) {
-						const VoxelBlockyModel::BakedData &model = baked_data.models[type_id];
-
-						if ((model.box_collision_mask & collision_nask) == 0) {
-							continue;
-						}
-
-						for (const AABB &aabb : model.box_collision_aabbs) {
-							AABB world_box = aabb;
-							world_box.position += i;
-							potential_boxes.push_back(world_box);
-						}
-					}
+// Gathers how voxels collide in the area of the query box.
+void collect_collisions(CollisionContext &ctx, AABB query_box) {
+	ZN_PROFILE_SCOPE();
+
+	CollisionGrid &grid = ctx.grid;
+	grid.box = Box3i::from_min_max(
+			math::floor_to_int(query_box.position), math::ceil_to_int(query_box.position + query_box.size)
+	);
+	grid.cells.resize(Vector3iUtil::get_volume(grid.box.size));
+	grid.boxes.clear();
+	grid.has_full_cubes = false;
+
+	const VoxelData &data = *ctx.data;
+	const unsigned int channel = ctx.blocky_library != nullptr ? VoxelBuffer::CHANNEL_TYPE : VoxelBuffer::CHANNEL_COLOR;
+	const int block_size = data.get_block_size();
+	const Box3i bounds = data.get_bounds();
+	SpatialLock3D &spatial_lock = data.get_spatial_lock(0);
+
+	// Read voxels one block at a time rather than individually
+	grid.box.downscaled(block_size).for_each_cell_zxy([&](const Vector3i bpos) {
+		const Box3i block_voxel_box(bpos * block_size, Vector3iUtil::create(block_size));
+		const Box3i box = grid.box.clipped(block_voxel_box);
+
+		bool read_from_block = false;
+		{
+			SpatialLock3D::Read srlock(spatial_lock, BoxBounds3i::from_position(bpos));
+			std::shared_ptr<VoxelBuffer> voxels_ptr = ctx.get_block_voxels(bpos);
+
+			if (voxels_ptr != nullptr && bounds.contains(block_voxel_box)) {
+				const VoxelBuffer &voxels = *voxels_ptr;
+
+				if (voxels.get_channel_compression(channel) == VoxelBuffer::COMPRESSION_UNIFORM) {
+					const uint64_t value = voxels.get_voxel(Vector3i(), channel);
+					box.for_each_cell_zxy([&ctx, value](const Vector3i pos) { //
+						set_cell(ctx, pos, value);
+					});
+				} else {
+					const Vector3i origin = block_voxel_box.position;
+					box.for_each_cell_zxy([&ctx, &voxels, origin, channel](const Vector3i pos) {
+						set_cell(ctx, pos, voxels.get_voxel(pos - origin, channel));
+					});
 				}
+				read_from_block = true;
 			}
 		}
 
-	} else if (zylann::godot::try_get_as(p_terrain.get_mesher(), mesher_cubes)) {
-		const int channel = VoxelBuffer::CHANNEL_COLOR;
-		VoxelSingleValue defval;
-		defval.i = 0;
-
-		// TODO Optimization: read the whole box of voxels at once, querying individually is slower
-		for (i.z = min_z; i.z < max_z; ++i.z) {
-			for (i.y = min_y; i.y < max_y; ++i.y) {
-				for (i.x = min_x; i.x < max_x; ++i.x) {
-					const int color_data = voxels.get_voxel(i, channel, defval).i;
-					if (color_data != 0) {
-						potential_boxes.push_back(AABB(i, Vector3(1, 1, 1)));
-					}
-				}
+		if (!read_from_block) {
+			// Voxels come from the generator, or are partially outside bounds. `get_voxel` takes care of it.
+			VoxelSingleValue defval;
+			defval.i = 0;
+			box.for_each_cell_zxy([&ctx, &data, channel, defval](const Vector3i pos) {
+				set_cell(ctx, pos, data.get_voxel(pos, channel, defval).i);
+			});
+		}
+	});
+}
+
+// Tells if cells of a layer of the grid perpendicular to axis `i` contain a full cube, within a range of the other
+// axes.
+bool has_full_cube_in_layer(
+		const CollisionGrid &grid,
+		const int i,
+		const int layer,
+		const int j,
+		const int min_j,
+		const int max_j,
+		const int k,
+		const int min_k,
+		const int max_k
+) {
+	Vector3i pos;
+	pos[i] = layer;
+	for (pos[k] = min_k; pos[k] < max_k; ++pos[k]) {
+		for (pos[j] = min_j; pos[j] < max_j; ++pos[j]) {
+			if (grid.get_cell(pos) == CELL_FULL_CUBE) {
+				return true;
 			}
 		}
 	}
+	return false;
 }
 
-} // namespace
+// Same as `calculate_i_offset` for all full cubes of the grid at once. Instead of testing boxes, layers of cells are
+// swept along the motion, starting from the closest, so it usually stops after looking at very few cells.
+real_t sweep_full_cubes(const CollisionGrid &grid, const AABB &box, real_t motion, int i, int j, int k) {
+	const real_t EPSILON = 0.001;
 
-Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, VoxelTerrain &p_terrain) {
-	ZN_PROFILE_SCOPE();
-	// The mesher is required to know how collisions should be processed
-	ERR_FAIL_COND_V(p_terrain.get_mesher().is_null(), Vector3());
+	if (!grid.has_full_cubes || motion == 0.0) {
+		return motion;
+	}
 
-	// Transform to local in case the volume is transformed
-	const Transform3D to_world = p_terrain.get_global_transform();
-	const Transform3D to_local = to_world.affine_inverse();
-	const Vector3 pos = to_local.xform(p_pos);
-	const Vector3 motion = to_local.basis.xform(p_motion);
-	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+	const Vector3 box_end = box.position + box.size;
+	const Vector3i grid_min = grid.box.position;
+	const Vector3i grid_max = grid.box.position + grid.box.size;
+
+	// Cells overlapping the box on the other axes
+	const int min_j = math::max(int(Math::floor(box.position[j])), grid_min[j]);
+	const int max_j = math::min(int(Math::ceil(box_end[j])), grid_max[j]);
+	const int min_k = math::max(int(Math::floor(box.position[k])), grid_min[k]);
+	const int max_k = math::min(int(Math::ceil(box_end[k])), grid_max[k]);
+
+	if (min_j >= max_j || min_k >= max_k) {
+		return motion;
+	}
+
+	if (motion > 0.0) {
+		// Cells starting after the end of the box
+		for (int layer = math::max(int(Math::ceil(box_end[i])), grid_min[i]); layer < grid_max[i]; ++layer) {
+			const real_t off = layer - box_end[i] - EPSILON;
+			if (off >= motion) {
+				break;
+			}
+			if (has_full_cube_in_layer(grid, i, layer, j, min_j, max_j, k, min_k, max_k)) {
+				return off;
+			}
+		}
+
+	} else {
+		// Cells ending before the start of the box
+		for (int layer = math::min(int(Math::floor(box.position[i])) - 1, grid_max[i] - 1); layer >= grid_min[i];
+			 --layer) {
+			const real_t off = (layer + 1) - box.position[i] + EPSILON;
+			if (off <= motion) {
+				break;
+			}
+			if (has_full_cube_in_layer(grid, i, layer, j, min_j, max_j, k, min_k, max_k)) {
+				return off;
+			}
+		}
+	}
 
-	const AABB box(aabb.position + pos, aabb.size);
+	return motion;
+}
+
+// Gets boxes of all colliding voxels of the grid, including full cubes.
+void get_all_boxes(const CollisionGrid &grid, StdVector<AABB> &out_boxes) {
+	out_boxes = grid.boxes;
+	if (grid.has_full_cubes) {
+		grid.box.for_each_cell_zxy([&grid, &out_boxes](const Vector3i pos) {
+			if (grid.get_cell(pos) == CELL_FULL_CUBE) {
+				out_boxes.push_back(AABB(pos, Vector3(1, 1, 1)));
+			}
+		});
+	}
+}
+
+// Gets the transformed vector for moving a box and slide.
+// This algorithm is free from tunnelling for axis-aligned movement,
+// except in some high-speed diagonal cases or huge size differences:
+// For example, if a box is fast enough to have a diagonal motion jumping from A to B,
+// it will pass through C if that other box is the only other one:
+//
+//  o---o
+//  | A |
+//  o---o
+//          o---o
+//          | C |
+//          o---o
+//                  o---o
+//                  | B |
+//                  o---o
+//
+// TODO one way to fix this would be to try a "hot side" projection instead
+//
+Vector3 get_motion(AABB box, Vector3 motion, const CollisionGrid &grid) {
+	// The bounding box is expanded to include it's estimated version at next update.
+	// This also makes the algorithm tunnelling-free
 	const AABB expanded_box = expand_with_vector(box, motion);
 
-	static thread_local StdVector<AABB> s_colliding_boxes;
-	StdVector<AABB> &potential_boxes = s_colliding_boxes;
-	potential_boxes.clear();
+	static thread_local StdVector<AABB> tls_colliding_boxes;
+	StdVector<AABB> &colliding_boxes = tls_colliding_boxes;
+	colliding_boxes.clear();
+	for (const AABB &other : grid.boxes) {
+		if (expanded_box.intersects(other)) {
+			colliding_boxes.push_back(other);
+		}
+	}
+
+	if (colliding_boxes.size() == 0 && !grid.has_full_cubes) {
+		return motion;
+	}
+
+	// print("Colliding: ", colliding_boxes.size())
+
+	Vector3 new_motion = motion;
+
+	new_motion.y = sweep_full_cubes(grid, box, new_motion.y, 1, 0, 2);
+	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
+		new_motion.y = calculate_i_offset(colliding_boxes[i], box, new_motion.y, 1, 0, 2);
+	}
+	box.position.y += new_motion.y;
+
+	new_motion.x = sweep_full_cubes(grid, box, new_motion.x, 0, 1, 2);
+	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
+		new_motion.x = calculate_i_offset(colliding_boxes[i], box, new_motion.x, 0, 1, 2);
+	}
+	box.position.x += new_motion.x;
+
+	new_motion.z = sweep_full_cubes(grid, box, new_motion.z, 2, 1, 0);
+	for (unsigned int i = 0; i < colliding_boxes.size(); ++i) {
+		new_motion.z = calculate_i_offset(colliding_boxes[i], box, new_motion.z, 2, 1, 0);
+	}
+	box.position.z += new_motion.z;
+
+	return new_motion;
+}
+
+Vector3 get_motion(
+		CollisionContext &ctx,
+		const AABB box,
+		const Vector3 motion,
+		const bool step_climbing_enabled,
+		const real_t max_step_height,
+		bool &out_stepped_up
+) {
+	const AABB expanded_box = expand_with_vector(box, motion);
 
 	// Collect potential collisions with the terrain (broad phase)
 	// TODO If motion is really big, we may want something more optimal or reject it
-	collect_boxes(p_terrain, expanded_box, _collision_mask, potential_boxes);
+	collect_collisions(ctx, expanded_box);
 
 	// Calculate collisions (narrow phase)
-	Vector3 slided_motion = zylann::voxel::get_motion(box, motion, to_span(potential_boxes));
+	Vector3 slided_motion = get_motion(box, motion, ctx.grid);
 
 	// Minecraft-style stair climbing:
 	// If we were moving, changed horizontal direction due to collision, and resulting motion is about horizontal
-	_has_stepped_up = false;
-	if (_step_climbing_enabled &&
+	out_stepped_up = false;
+	if (step_climbing_enabled &&
 			// Movement is horizontal?
 			Math::abs(slided_motion.y) < 0.001 && Vector2(motion.x, motion.z).length_squared() > 0.0001 &&
 			// Motor movement isn't the same as resulting slided motion?
 			Vector2(motion.x, motion.z).normalized().dot(Vector2(slided_motion.x, slided_motion.z).normalized()) <
 					0.99) {
 		// We hit an obstacle
+		StdVector<AABB> &all_boxes = ctx.all_boxes;
+		get_all_boxes(ctx.grid, all_boxes);
+
 		real_t hit_y;
 		// Find out the height of the step
-		if (boxcast_down(to_span(potential_boxes), get_xz(expanded_box.position), get_xz(expanded_box.size), hit_y)) {
+		if (boxcast_down(to_span(all_boxes), get_xz(expanded_box.position), get_xz(expanded_box.size), hit_y)) {
 			// If the step is up and not too high
-			if (hit_y > box.position.y && (hit_y - box.position.y) <= _max_step_height) {
+			if (hit_y > box.position.y && (hit_y - box.position.y) <= max_step_height) {
 				// Check if we would fit if we move the box above the step.
 				// Raise it slightly higher to avoid precision issues. Even if the final motion would move the box
 				// exactly on top of the stair, gameplay code could do some additional calculations with that motion
@@ -306,23 +480,132 @@ Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb,
 				const AABB hyp_box(
 						Vector3(box.position.x + motion.x, hit_y + epsilon, box.position.z + motion.z), box.size);
 
-				potential_boxes.clear();
-				collect_boxes(p_terrain, hyp_box, _collision_mask, potential_boxes);
+				collect_collisions(ctx, hyp_box);
+				get_all_boxes(ctx.grid, all_boxes);
 
 				// If the box fits on top of the step
-				if (!intersects(to_span(potential_boxes), hyp_box)) {
+				if (!intersects(to_span(all_boxes), hyp_box)) {
 					// Change motion so that it brings the box on top of the step
 					slided_motion = hyp_box.position - box.position;
-					_has_stepped_up = true;
+					out_stepped_up = true;
 				}
 			}
 		}
 	}
 
+	return slided_motion;
+}
+
+} // namespace
+
+Vector3 VoxelBoxMover::get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, VoxelTerrain &p_terrain) {
+	Vector3 motion;
+	get_motions(
+			to_single_element_span(p_pos),
+			to_single_element_span(p_motion),
+			p_aabb,
+			p_terrain,
+			to_single_element_span(motion)
+	);
+	return motion;
+}
+
+void VoxelBoxMover::get_motions(
+		Span<const Vector3> p_positions,
+		Span<const Vector3> p_motions,
+		AABB p_aabb,
+		VoxelTerrain &p_terrain,
+		Span<Vector3> out_motions,
+		Span<uint8_t> out_stepped_up
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(p_positions.size() == p_motions.size());
+	ZN_ASSERT_RETURN(p_positions.size() == out_motions.size());
+	ZN_ASSERT_RETURN(out_stepped_up.size() == 0 || out_stepped_up.size() == p_positions.size());
+	// The mesher is required to know how collisions should be processed
+	ERR_FAIL_COND(p_terrain.get_mesher().is_null());
+
+	// Transform to local in case the volume is transformed
+	const Transform3D to_world = p_terrain.get_global_transform();
+	const Transform3D to_local = to_world.affine_inverse();
+	const AABB aabb = Transform3D(to_local.basis, Vector3()).xform(p_aabb);
+
+	static thread_local StdVector<Vector3> tls_positions;
+	static thread_local StdVector<Vector3> tls_motions;
+	StdVector<Vector3> &positions = tls_positions;
+	StdVector<Vector3> &motions = tls_motions;
+	positions.resize(p_positions.size());
+	motions.resize(p_motions.size());
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		positions[i] = to_local.xform(p_positions[i]);
+		motions[i] = to_local.basis.xform(p_motions[i]);
+	}
+
+	get_motions_in_data(
+			p_terrain.get_storage(),
+			p_terrain.get_mesher(),
+			to_span(positions),
+			to_span(motions),
+			aabb,
+			out_motions,
+			out_stepped_up
+	);
+
 	// Switch back to world
-	const Vector3 world_slided_motion = to_world.basis.xform(slided_motion);
+	for (Vector3 &motion : out_motions) {
+		motion = to_world.basis.xform(motion);
+	}
+}
+
+void VoxelBoxMover::get_motions_in_data(
+		VoxelData &data,
+		const Ref<VoxelMesher> &mesher,
+		Span<const Vector3> positions,
+		Span<const Vector3> motions,
+		AABB aabb,
+		Span<Vector3> out_motions,
+		Span<uint8_t> out_stepped_up
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(positions.size() == motions.size());
+	ZN_ASSERT_RETURN(positions.size() == out_motions.size());
+	ZN_ASSERT_RETURN(out_stepped_up.size() == 0 || out_stepped_up.size() == positions.size());
+
+	Ref<VoxelMesherBlocky> mesher_blocky;
+	Ref<VoxelMesherCubes> mesher_cubes;
+	Ref<VoxelBlockyLibraryBase> library;
+	const VoxelBlockyLibraryBase::BakedData *blocky_library = nullptr;
+
+	if (zylann::godot::try_get_as(mesher, mesher_blocky)) {
+		library = mesher_blocky->get_library();
+		ERR_FAIL_COND_MSG(library.is_null(), "VoxelMesherBlocky has no library assigned");
+		blocky_library = &library->get_baked_data();
+
+	} else if (!zylann::godot::try_get_as(mesher, mesher_cubes)) {
+		// Nothing collides
+		for (unsigned int i = 0; i < motions.size(); ++i) {
+			out_motions[i] = motions[i];
+		}
+		out_stepped_up.fill(0);
+		_has_stepped_up = false;
+		return;
+	}
+
+	static thread_local CollisionContext tls_ctx;
+	CollisionContext &ctx = tls_ctx;
+	ctx.begin(data, blocky_library, _collision_mask);
+
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		const AABB box(aabb.position + positions[i], aabb.size);
+		out_motions[i] = zylann::voxel::get_motion(
+				ctx, box, motions[i], _step_climbing_enabled, _max_step_height, _has_stepped_up
+		);
+		if (out_stepped_up.size() > 0) {
+			out_stepped_up[i] = _has_stepped_up;
+		}
+	}
 
-	return world_slided_motion;
+	ctx.end();
 }
 
 void VoxelBoxMover::set_collision_mask(uint32_t mask) {
@@ -361,8 +644,44 @@ Vector3 VoxelBoxMover::_b_get_motion(Vector3 pos, Vector3 motion, AABB aabb, Obj
 	return get_motion(pos, motion, aabb, *terrain);
 }
 
+#if defined(ZN_GODOT)
+PackedVector3Array VoxelBoxMover::_b_get_motions(
+		PackedVector3Array positions,
+		PackedVector3Array motions,
+		AABB aabb,
+		Node *terrain_node
+) {
+#elif defined(ZN_GODOT_EXTENSION)
+PackedVector3Array VoxelBoxMover::_b_get_motions(
+		PackedVector3Array positions,
+		PackedVector3Array motions,
+		AABB aabb,
+		Object *terrain_node_o
+) {
+	Node *terrain_node = Object::cast_to<Node>(terrain_node_o);
+#endif
+	ERR_FAIL_COND_V(terrain_node == nullptr, PackedVector3Array());
+	VoxelTerrain *terrain = Object::cast_to<VoxelTerrain>(terrain_node);
+	ERR_FAIL_COND_V(terrain == nullptr, PackedVector3Array());
+	ERR_FAIL_COND_V(positions.size() != motions.size(), PackedVector3Array());
+
+	PackedVector3Array out_motions;
+	out_motions.resize(motions.size());
+	get_motions(
+			to_span(positions),
+			to_span(motions),
+			aabb,
+			*terrain,
+			Span<Vector3>(out_motions.ptrw(), out_motions.size())
+	);
+	return out_motions;
+}
+
 void VoxelBoxMover::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_motion", "pos", "motion", "aabb", "terrain"), &VoxelBoxMover::_b_get_motion);
+	ClassDB::bind_method(
+			D_METHOD("get_motions", "positions", "motions", "aabb", "terrain"), &VoxelBoxMover::_b_get_motions
+	);
 
 	ClassDB::bind_method(D_METHOD("set_collision_mask", "mask"), &VoxelBoxMover::set_collision_mask);
 	ClassDB::bind_method(D_METHOD("get_collision_mask"), &VoxelBoxMover::get_collision_mask);
@@ -1,7 +1,9 @@
 #ifndef VOXEL_BOX_MOVER_H
 #define VOXEL_BOX_MOVER_H
 
+#include "../../util/containers/span.h"
 #include "../../util/godot/classes/ref_counted.h"
+#include "../../util/godot/core/packed_arrays.h"
 #include "../../util/godot/macros.h"
 
 ZN_GODOT_FORWARD_DECLARE(class Node);
@@ -9,6 +11,8 @@ ZN_GODOT_FORWARD_DECLARE(class Node);
 namespace zylann::voxel {
 
 class VoxelTerrain;
+class VoxelData;
+class VoxelMesher;
 
 // Helper to get simple AABB physics
 class VoxelBoxMover : public RefCounted {
@@ -16,6 +20,31 @@ class VoxelBoxMover : public RefCounted {
 public:
 	Vector3 get_motion(Vector3 pos, Vector3 motion, AABB aabb, VoxelTerrain &terrain);
 
+	// Moves many boxes of the same size at once. This is faster than calling `get_motion` for each of them, because
+	// voxel blocks are looked up only once for the whole batch. Boxes don't collide with each other.
+	// `has_stepped_up()` only tells about the last box of the batch. To know it for every box, pass
+	// `out_stepped_up` with the same size as `positions`: it receives 1 for each box that climbed a step, 0 otherwise.
+	void get_motions(
+			Span<const Vector3> positions,
+			Span<const Vector3> motions,
+			AABB aabb,
+			VoxelTerrain &terrain,
+			Span<Vector3> out_motions,
+			Span<uint8_t> out_stepped_up = Span<uint8_t>()
+	);
+
+	// Same as `get_motions`, directly using voxel data. Positions, motions and the box are in the local space of the
+	// data. The mesher tells how voxels collide.
+	void get_motions_in_data(
+			VoxelData &data,
+			const Ref<VoxelMesher> &mesher,
+			Span<const Vector3> positions,
+			Span<const Vector3> motions,
+			AABB aabb,
+			Span<Vector3> out_motions,
+			Span<uint8_t> out_stepped_up = Span<uint8_t>()
+	);
+
 	void set_collision_mask(uint32_t mask);
 	inline uint32_t get_collision_mask() const {
 		return _collision_mask;
@@ -32,9 +61,21 @@ public:
 private:
 #if defined(ZN_GODOT)
 	Vector3 _b_get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, Node *p_terrain_node);
+	PackedVector3Array _b_get_motions(
+			PackedVector3Array p_positions,
+			PackedVector3Array p_motions,
+			AABB p_aabb,
+			Node *p_terrain_node
+	);
 #elif defined(ZN_GODOT_EXTENSION)
 	// TODO GDX: it seems binding a method taking a `Node*` fails to compile. It is supposed to be working.
 	Vector3 _b_get_motion(Vector3 p_pos, Vector3 p_motion, AABB p_aabb, Object *p_terrain_node_o);
+	PackedVector3Array _b_get_motions(
+			PackedVector3Array p_positions,
+			PackedVector3Array p_motions,
+			AABB p_aabb,
+			Object *p_terrain_node_o
+	);
 #endif
 
 	static void _bind_methods();
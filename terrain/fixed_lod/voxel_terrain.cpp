@@ -126,6 +126,15 @@ bool VoxelTerrain::get_generator_use_gpu() const {
 	return _generator_use_gpu;
 }
 
+void VoxelTerrain::set_edit_journal_max_memory_mb(int mb) {
+	ERR_FAIL_COND(mb < 0);
+	_data->set_edit_journal_max_memory(static_cast<size_t>(mb) * 1024 * 1024);
+}
+
+int VoxelTerrain::get_edit_journal_max_memory_mb() const {
+	return _data->get_edit_journal_max_memory() / (1024 * 1024);
+}
+
 void VoxelTerrain::set_stream(Ref<VoxelStream> p_stream) {
 	if (p_stream == get_stream()) {
 		return;
@@ -791,6 +800,18 @@ void VoxelTerrain::post_edit_area(Box3i box_in_voxels, bool update_mesh) {
 	}
 }
 
+void VoxelTerrain::push_async_edit(IVoxelTerrainAsyncEdit *edit) {
+	_async_edits.push(edit);
+}
+
+void VoxelTerrain::process_async_edits() {
+	StdVector<Box3i> edited_boxes;
+	_async_edits.process(_data, edited_boxes);
+	for (const Box3i &box : edited_boxes) {
+		post_edit_area(box, true);
+	}
+}
+
 void VoxelTerrain::_notification(int p_what) {
 	struct SetWorldAction {
 		World3D *world;
@@ -1168,6 +1189,7 @@ void VoxelTerrain::process() {
 
 	process_viewers();
 	// process_received_data_blocks();
+	process_async_edits();
 	process_meshing();
 
 #ifdef TOOLS_ENABLED
@@ -1807,6 +1829,9 @@ void VoxelTerrain::process_meshing() {
 		task->lod_index = 0;
 		task->meshing_dependency = _meshing_dependency;
 		task->collision_hint = _generate_collisions;
+		// Same condition as when applying the result, so shapes are not built in threads only to be discarded
+		task->require_collision_shape = _generate_collisions && mesh_block->collision_viewers.get() > 0;
+		task->require_visual = mesh_block->mesh_viewers.get() > 0;
 		task->data = _data;
 
 		// This iteration order is specifically chosen to match VoxelEngine and threaded access
@@ -1879,75 +1904,85 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 		return;
 	}
 
-	Ref<ArrayMesh> mesh;
-	Ref<Mesh> shadow_occluder_mesh;
-	StdVector<uint16_t> material_indices;
-	if (ob.has_mesh_resource) {
-		// The mesh was already built as part of the threaded task
-		mesh = ob.mesh;
-		shadow_occluder_mesh = ob.shadow_occluder_mesh;
-		// It can be empty
-		material_indices = std::move(ob.mesh_material_indices);
-	} else {
-		// Can't build meshes in threads, do it here
-		material_indices.clear();
-		mesh = build_mesh(
-				to_span_const(ob.surfaces.surfaces),
-				ob.surfaces.primitive_type,
-				ob.surfaces.mesh_flags,
-				material_indices
-		);
-		shadow_occluder_mesh = build_mesh(ob.surfaces.shadow_occluder);
-	}
-	if (mesh.is_valid()) {
-		const unsigned int surface_count = mesh->get_surface_count();
-		for (unsigned int surface_index = 0; surface_index < surface_count; ++surface_index) {
-			const unsigned int material_index = material_indices[surface_index];
-			Ref<Material> material = _mesher->get_material_by_index(material_index);
-			mesh->surface_set_material(surface_index, material);
+	// Visuals are skipped if no viewer needs them, which is always the case in headless mode
+	const bool gen_visuals = block->mesh_viewers.get() > 0;
+	if (gen_visuals) {
+		Ref<ArrayMesh> mesh;
+		Ref<Mesh> shadow_occluder_mesh;
+		StdVector<uint16_t> material_indices;
+		if (ob.has_mesh_resource) {
+			// The mesh was already built as part of the threaded task
+			mesh = ob.mesh;
+			shadow_occluder_mesh = ob.shadow_occluder_mesh;
+			// It can be empty
+			material_indices = std::move(ob.mesh_material_indices);
+		} else {
+			// Can't build meshes in threads, do it here
+			material_indices.clear();
+			mesh = build_mesh(
+					to_span_const(ob.surfaces.surfaces),
+					ob.surfaces.primitive_type,
+					ob.surfaces.mesh_flags,
+					material_indices
+			);
+			shadow_occluder_mesh = build_mesh(ob.surfaces.shadow_occluder);
+		}
+		if (mesh.is_valid()) {
+			const unsigned int surface_count = mesh->get_surface_count();
+			for (unsigned int surface_index = 0; surface_index < surface_count; ++surface_index) {
+				const unsigned int material_index = material_indices[surface_index];
+				Ref<Material> material = _mesher->get_material_by_index(material_index);
+				mesh->surface_set_material(surface_index, material);
+			}
 		}
-	}
 
-	if (mesh.is_null() && block->has_mesh()) {
-		// No surface anymore in this block
-		if (_instancer != nullptr) {
-			_instancer->on_mesh_block_exit(ob.position, ob.lod);
+		if (mesh.is_null() && block->has_mesh()) {
+			// No surface anymore in this block
+			if (_instancer != nullptr) {
+				_instancer->on_mesh_block_exit(ob.position, ob.lod);
+			}
 		}
-	}
-	if (ob.surfaces.surfaces.size() > 0 && mesh.is_valid() && !block->has_mesh()) {
-		// TODO The mesh could come from an edited region!
-		// We would have to know if specific voxels got edited, or different from the generator
-		// TODO Support multi-surfaces in VoxelInstancer
-		if (_instancer != nullptr) {
-			_instancer->on_mesh_block_enter(ob.position, ob.lod, ob.surfaces.surfaces[0].arrays);
+		if (ob.surfaces.surfaces.size() > 0 && mesh.is_valid() && !block->has_mesh()) {
+			// TODO The mesh could come from an edited region!
+			// We would have to know if specific voxels got edited, or different from the generator
+			// TODO Support multi-surfaces in VoxelInstancer
+			if (_instancer != nullptr) {
+				_instancer->on_mesh_block_enter(ob.position, ob.lod, ob.surfaces.surfaces[0].arrays);
+			}
 		}
-	}
 
 #ifdef TOOLS_ENABLED
-	const RenderingServer::ShadowCastingSetting shadow_occluder_mode = _debug_draw_shadow_occluders
-			? RenderingServer::SHADOW_CASTING_SETTING_ON
-			: RenderingServer::SHADOW_CASTING_SETTING_SHADOWS_ONLY;
+		const RenderingServer::ShadowCastingSetting shadow_occluder_mode = _debug_draw_shadow_occluders
+				? RenderingServer::SHADOW_CASTING_SETTING_ON
+				: RenderingServer::SHADOW_CASTING_SETTING_SHADOWS_ONLY;
 #endif
 
-	block->set_mesh(
-			mesh,
-			get_gi_mode(),
-			static_cast<RenderingServer::ShadowCastingSetting>(get_shadow_casting()),
-			get_render_layers_mask(),
-			shadow_occluder_mesh
+		block->set_mesh(
+				mesh,
+				get_gi_mode(),
+				static_cast<RenderingServer::ShadowCastingSetting>(get_shadow_casting()),
+				get_render_layers_mask(),
+				shadow_occluder_mesh
 #ifdef TOOLS_ENABLED
-			,
-			shadow_occluder_mode
+				,
+				shadow_occluder_mode
 #endif
-	);
+		);
 
-	if (_material_override.is_valid()) {
-		block->set_material_override(_material_override);
+		if (_material_override.is_valid()) {
+			block->set_material_override(_material_override);
+		}
 	}
 
 	const bool gen_collisions = _generate_collisions && block->collision_viewers.get() > 0;
 	if (gen_collisions) {
-		Ref<Shape3D> collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
+		Ref<Shape3D> collision_shape;
+		if (ob.has_collision_shape_resource) {
+			// The shape was already built as part of the threaded task
+			collision_shape = ob.collision_shape;
+		} else {
+			collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
+		}
 		const bool debug_collisions = is_inside_tree() ? get_tree()->is_debugging_collisions_hint() : false;
 		block->set_collision_shape(collision_shape, debug_collisions, this, _collision_margin);
 
@@ -2306,6 +2341,9 @@ void VoxelTerrain::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_generator_use_gpu", "enable"), &Self::set_generator_use_gpu);
 	ClassDB::bind_method(D_METHOD("get_generator_use_gpu"), &Self::get_generator_use_gpu);
 
+	ClassDB::bind_method(D_METHOD("set_edit_journal_max_memory_mb", "mb"), &Self::set_edit_journal_max_memory_mb);
+	ClassDB::bind_method(D_METHOD("get_edit_journal_max_memory_mb"), &Self::get_edit_journal_max_memory_mb);
+
 	// TODO Rename `_voxel_bounds`
 	ClassDB::bind_method(D_METHOD("set_bounds", "bounds"), &Self::_b_set_bounds);
 	ClassDB::bind_method(D_METHOD("get_bounds"), &Self::_b_get_bounds);
@@ -2403,6 +2441,11 @@ void VoxelTerrain::_bind_methods() {
 	);
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "mesh_block_size"), "set_mesh_block_size", "get_mesh_block_size");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_gpu_generation"), "set_generator_use_gpu", "get_generator_use_gpu");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "edit_journal_max_memory_mb"),
+			"set_edit_journal_max_memory_mb",
+			"get_edit_journal_max_memory_mb"
+	);
 
 	ADD_GROUP("Debug", "debug_");
 
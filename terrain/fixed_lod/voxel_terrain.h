@@ -13,6 +13,7 @@
 #include "../voxel_mesh_map.h"
 #include "../voxel_node.h"
 #include "voxel_mesh_block_vt.h"
+#include "voxel_terrain_async_edits.h"
 #include "voxel_terrain_multiplayer_synchronizer.h"
 
 #ifdef TOOLS_ENABLED
@@ -66,6 +67,9 @@ public:
 	void post_edit_voxel(Vector3i pos);
 	void post_edit_area(Box3i box_in_voxels, bool update_mesh);
 
+	// Queues an edit to run on the thread pool. Takes ownership of it. Meshes are updated when its batch completes.
+	void push_async_edit(IVoxelTerrainAsyncEdit *edit);
+
 	void set_generate_collisions(bool enabled);
 	bool get_generate_collisions() const {
 		return _generate_collisions;
@@ -98,6 +102,9 @@ public:
 	void set_generator_use_gpu(bool enabled);
 	bool get_generator_use_gpu() const;
 
+	void set_edit_journal_max_memory_mb(int mb);
+	int get_edit_journal_max_memory_mb() const;
+
 	VoxelData &get_storage() const {
 		ZN_ASSERT(_data != nullptr);
 		return *_data;
@@ -204,6 +211,7 @@ private:
 			bool can_load_blocks
 	);
 	// void process_received_data_blocks();
+	void process_async_edits();
 	void process_meshing();
 	void apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob);
 	void apply_data_block_response(VoxelEngine::BlockDataOutput &ob);
@@ -338,6 +346,8 @@ private:
 	};
 	StdVector<QuickReloadingBlock> _quick_reloading_blocks;
 
+	VoxelTerrainAsyncEditQueue _async_edits;
+
 	Ref<VoxelMesher> _mesher;
 
 	// Data stored with a shared pointer so it can be sent to asynchronous tasks, and these tasks can be cancelled by
@@ -0,0 +1,181 @@
+#include "voxel_terrain_async_edits.h"
+#include "../../engine/voxel_engine.h"
+#include "../../storage/voxel_data.h"
+#include "../../storage/voxel_data_grid.h"
+#include "../../util/memory/memory.h"
+#include "../../util/profiling.h"
+#include "../../util/tasks/async_dependency_tracker.h"
+#include "../../util/tasks/threaded_task.h"
+
+namespace zylann::voxel {
+
+namespace {
+
+struct AsyncEditGroup {
+	// Covers all edits of the group, in blocks
+	Box3i blocks_box;
+	StdVector<IVoxelTerrainAsyncEdit *> edits;
+};
+
+class VoxelTerrainAsyncEditTask : public IThreadedTask {
+public:
+	VoxelTerrainAsyncEditTask(
+			StdVector<IVoxelTerrainAsyncEdit *> &&edits,
+			Box3i voxel_box,
+			std::shared_ptr<VoxelData> data,
+			std::shared_ptr<AsyncDependencyTracker> tracker
+	) :
+			_edits(std::move(edits)), _voxel_box(voxel_box), _data(data), _tracker(tracker) {}
+
+	~VoxelTerrainAsyncEditTask() {
+		for (IVoxelTerrainAsyncEdit *edit : _edits) {
+			ZN_DELETE(edit);
+		}
+	}
+
+	const char *get_debug_name() const override {
+		return "VoxelTerrainAsyncEdit";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		ZN_PROFILE_SCOPE();
+		ZN_ASSERT(_data != nullptr);
+
+		VoxelDataGrid grid;
+		// The grid references voxels of blocks, so they remain valid even if blocks get unloaded in the meantime
+		_data->get_blocks_grid(grid, _voxel_box, 0);
+		{
+			VoxelDataGrid::LockWrite wlock(grid);
+			for (IVoxelTerrainAsyncEdit *edit : _edits) {
+				edit->apply(grid);
+			}
+		}
+
+		_tracker->post_complete();
+	}
+
+private:
+	StdVector<IVoxelTerrainAsyncEdit *> _edits;
+	Box3i _voxel_box;
+	std::shared_ptr<VoxelData> _data;
+	std::shared_ptr<AsyncDependencyTracker> _tracker;
+};
+
+void group_overlapping_edits(
+		Span<IVoxelTerrainAsyncEdit *const> edits,
+		const int block_size,
+		StdVector<AsyncEditGroup> &groups
+) {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<unsigned int> overlapping_group_indices;
+
+	for (IVoxelTerrainAsyncEdit *edit : edits) {
+		const Box3i blocks_box = edit->get_box().downscaled(block_size);
+
+		// Locks are per block, so edits touching the same blocks must not run in parallel
+		overlapping_group_indices.clear();
+		for (unsigned int group_index = 0; group_index < groups.size(); ++group_index) {
+			if (groups[group_index].blocks_box.intersects(blocks_box)) {
+				overlapping_group_indices.push_back(group_index);
+			}
+		}
+
+		if (overlapping_group_indices.size() == 0) {
+			AsyncEditGroup group;
+			group.blocks_box = blocks_box;
+			group.edits.push_back(edit);
+			groups.push_back(std::move(group));
+			continue;
+		}
+
+		// Merge all overlapping groups into the first one. They didn't overlap each other, so the order in which their
+		// edits run relative to each other doesn't matter.
+		AsyncEditGroup &dst_group = groups[overlapping_group_indices[0]];
+		for (unsigned int i = 1; i < overlapping_group_indices.size(); ++i) {
+			const AsyncEditGroup &src_group = groups[overlapping_group_indices[i]];
+			dst_group.blocks_box.merge_with(src_group.blocks_box);
+			for (IVoxelTerrainAsyncEdit *src_edit : src_group.edits) {
+				dst_group.edits.push_back(src_edit);
+			}
+		}
+		dst_group.blocks_box.merge_with(blocks_box);
+		dst_group.edits.push_back(edit);
+
+		// Remove merged groups, from last to first so indices remain valid
+		for (unsigned int i = overlapping_group_indices.size() - 1; i > 0; --i) {
+			groups.erase(groups.begin() + overlapping_group_indices[i]);
+		}
+	}
+}
+
+} // namespace
+
+VoxelTerrainAsyncEditQueue::~VoxelTerrainAsyncEditQueue() {
+	clear();
+}
+
+void VoxelTerrainAsyncEditQueue::push(IVoxelTerrainAsyncEdit *edit) {
+	ZN_ASSERT_RETURN(edit != nullptr);
+	MutexLock mlock(_pending_edits_mutex);
+	_pending_edits.push_back(edit);
+}
+
+void VoxelTerrainAsyncEditQueue::process(std::shared_ptr<VoxelData> data, StdVector<Box3i> &out_edited_boxes) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(data != nullptr);
+
+	if (_running_tracker != nullptr) {
+		if (!_running_tracker->is_complete()) {
+			return;
+		}
+		// The whole batch is done, meshes can be updated once for it
+		for (const Box3i &box : _running_boxes) {
+			out_edited_boxes.push_back(box);
+		}
+		_running_boxes.clear();
+		_running_tracker = nullptr;
+	}
+
+	StdVector<IVoxelTerrainAsyncEdit *> edits;
+	{
+		MutexLock mlock(_pending_edits_mutex);
+		if (_pending_edits.size() == 0) {
+			return;
+		}
+		edits = std::move(_pending_edits);
+		_pending_edits.clear();
+	}
+
+	const int block_size = data->get_block_size();
+
+	StdVector<AsyncEditGroup> groups;
+	group_overlapping_edits(to_span_const(edits), block_size, groups);
+
+	_running_tracker = make_shared_instance<AsyncDependencyTracker>(groups.size());
+
+	StdVector<IThreadedTask *> tasks;
+	tasks.reserve(groups.size());
+
+	for (AsyncEditGroup &group : groups) {
+		Box3i voxel_box = group.edits[0]->get_box();
+		for (unsigned int i = 1; i < group.edits.size(); ++i) {
+			voxel_box.merge_with(group.edits[i]->get_box());
+		}
+		_running_boxes.push_back(voxel_box);
+
+		tasks.push_back(ZN_NEW(VoxelTerrainAsyncEditTask(std::move(group.edits), voxel_box, data, _running_tracker)));
+	}
+
+	VoxelEngine::get_singleton().push_async_tasks(to_span(tasks));
+}
+
+void VoxelTerrainAsyncEditQueue::clear() {
+	MutexLock mlock(_pending_edits_mutex);
+	for (IVoxelTerrainAsyncEdit *edit : _pending_edits) {
+		ZN_DELETE(edit);
+	}
+	_pending_edits.clear();
+}
+
+} // namespace zylann::voxel
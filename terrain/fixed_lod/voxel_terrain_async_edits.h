@@ -0,0 +1,60 @@
+#ifndef VOXEL_TERRAIN_ASYNC_EDITS_H
+#define VOXEL_TERRAIN_ASYNC_EDITS_H
+
+#include "../../util/containers/std_vector.h"
+#include "../../util/math/box3i.h"
+#include "../../util/thread/mutex.h"
+
+#include <memory>
+
+namespace zylann {
+class AsyncDependencyTracker;
+}
+
+namespace zylann::voxel {
+
+class VoxelData;
+class VoxelDataGrid;
+
+// Edit of voxels that can run on a thread of the pool.
+class IVoxelTerrainAsyncEdit {
+public:
+	virtual ~IVoxelTerrainAsyncEdit() {}
+
+	// Area of voxels the edit may modify.
+	virtual Box3i get_box() const = 0;
+
+	// Modifies voxels. The grid contains blocks of at least the edit's box, and is already locked for writing.
+	virtual void apply(VoxelDataGrid &grid) = 0;
+};
+
+// Runs edits of `VoxelTerrain` on the thread pool, in batches.
+// Pending edits are grouped by overlapping areas. Edits of the same group run in the order they were pushed, in a
+// single task holding one lock on their combined area. Different groups run in parallel. A new batch is only
+// scheduled once the previous one has completed, so edits never run out of order.
+class VoxelTerrainAsyncEditQueue {
+public:
+	~VoxelTerrainAsyncEditQueue();
+
+	// Takes ownership of the edit. Can be called from any thread.
+	void push(IVoxelTerrainAsyncEdit *edit);
+
+	// Schedules pending edits if no batch is running. When the running batch completes, outputs the areas it modified
+	// so meshes can be updated. Must be called from the thread owning the terrain.
+	void process(std::shared_ptr<VoxelData> data, StdVector<Box3i> &out_edited_boxes);
+
+	// Deletes pending edits. Edits already running can't be cancelled.
+	void clear();
+
+private:
+	StdVector<IVoxelTerrainAsyncEdit *> _pending_edits;
+	BinaryMutex _pending_edits_mutex;
+
+	std::shared_ptr<AsyncDependencyTracker> _running_tracker;
+	// One box per group of the running batch
+	StdVector<Box3i> _running_boxes;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_TERRAIN_ASYNC_EDITS_H
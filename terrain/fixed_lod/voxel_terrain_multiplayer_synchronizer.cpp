@@ -1,6 +1,7 @@
 #include "voxel_terrain_multiplayer_synchronizer.h"
 #include "../../constants/voxel_string_names.h"
 #include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
 #include "../../streams/voxel_block_serializer.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/godot/classes/multiplayer_api.h"
@@ -16,6 +17,8 @@
 #include "../../util/godot/core/packed_arrays.h"
 #endif
 
+#include <algorithm>
+
 namespace zylann::voxel {
 
 VoxelTerrainMultiplayerSynchronizer::VoxelTerrainMultiplayerSynchronizer() {
@@ -26,7 +29,7 @@ VoxelTerrainMultiplayerSynchronizer::VoxelTerrainMultiplayerSynchronizer() {
 	config["channel"] = _rpc_channel;
 
 	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_blocks, config);
-	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_area, config);
+	rpc_config(VoxelStringNames::get_singleton()._rpc_receive_block_diffs, config);
 
 	set_process(true);
 }
@@ -44,6 +47,38 @@ bool VoxelTerrainMultiplayerSynchronizer::is_server() const {
 	return mp->is_server();
 }
 
+namespace {
+
+// Full block messages use a 16-bit size, diffs use a 32-bit size because they can be larger in worst cases
+PackedByteArray make_block_message(Vector3i bpos, Span<const uint8_t> payload, bool is_diff) {
+	PackedByteArray message_data;
+	message_data.resize(3 * sizeof(int16_t) + (is_diff ? sizeof(uint32_t) : sizeof(uint16_t)) + payload.size());
+
+	ByteSpanWithPosition mw_span(Span<uint8_t>(message_data.ptrw(), message_data.size()), 0);
+	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+
+	mw.store_16(bpos.x);
+	mw.store_16(bpos.y);
+	mw.store_16(bpos.z);
+	if (is_diff) {
+		mw.store_32(payload.size());
+	} else {
+		ZN_ASSERT_RETURN_V(payload.size() <= 65535, PackedByteArray());
+		mw.store_16(payload.size());
+	}
+	mw.store_buffer(payload);
+
+	return message_data;
+}
+
+PackedByteArray serialize_block_message(Vector3i bpos, const VoxelBuffer &voxels) {
+	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(voxels);
+	ZN_ASSERT_RETURN_V(result.success, PackedByteArray());
+	return make_block_message(bpos, to_span(result.data), false);
+}
+
+} // namespace
+
 void VoxelTerrainMultiplayerSynchronizer::send_block(
 		int viewer_peer_id,
 		const VoxelDataBlock &data_block,
@@ -51,21 +86,33 @@ void VoxelTerrainMultiplayerSynchronizer::send_block(
 ) {
 	ZN_PROFILE_SCOPE();
 
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(data_block.get_voxels_const());
-	ZN_ASSERT_RETURN(result.success);
-
 	PackedByteArray message_data;
-	message_data.resize(4 * sizeof(int16_t) + result.data.size());
 
-	ByteSpanWithPosition mw_span(Span<uint8_t>(message_data.ptrw(), message_data.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+	auto cache_it = _serialized_blocks_cache.find(bpos);
+	if (cache_it != _serialized_blocks_cache.end()) {
+		// Already serialized for another peer this frame
+		message_data = cache_it->second;
+
+	} else {
+		const VoxelBuffer *voxels = &data_block.get_voxels_const();
+
+		auto baseline_it = _baselines.find(bpos);
+		if (baseline_it != _baselines.end()) {
+			Baseline &baseline = baseline_it->second;
+			if (has_pending_edits(bpos)) {
+				// Other peers will receive pending edits as a difference from the baseline. Send the baseline, so this
+				// peer gets the same difference applied to the same state.
+				voxels = baseline.voxels.get();
+			} else {
+				// The block could have been unloaded and loaded again since the baseline was made
+				data_block.get_voxels_const().copy_to(*baseline.voxels, true);
+			}
+		}
 
-	mw.store_16(bpos.x);
-	mw.store_16(bpos.y);
-	mw.store_16(bpos.z);
-	ZN_ASSERT_RETURN(result.data.size() <= 65535);
-	mw.store_16(result.data.size());
-	mw.store_buffer(to_span(result.data));
+		message_data = serialize_block_message(bpos, *voxels);
+		ZN_ASSERT_RETURN(message_data.size() > 0);
+		_serialized_blocks_cache[bpos] = message_data;
+	}
 
 	// print_line(String("Server: send block {0}").format(varray(bpos)));
 
@@ -82,36 +129,119 @@ void VoxelTerrainMultiplayerSynchronizer::send_block(
 // isn't acknowledging it for some time.
 
 void VoxelTerrainMultiplayerSynchronizer::send_area(Box3i voxel_box) {
+	// Deferred until the end of the frame, see `flush_edited_blocks`
+	_pending_edited_boxes.push_back(voxel_box);
+}
+
+bool VoxelTerrainMultiplayerSynchronizer::has_pending_edits(Vector3i bpos) const {
+	ZN_ASSERT_RETURN_V(_terrain != nullptr, false);
+	const int block_size = _terrain->get_data_block_size();
+	for (const Box3i &box : _pending_edited_boxes) {
+		if (box.downscaled(block_size).contains(bpos)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void VoxelTerrainMultiplayerSynchronizer::flush_edited_blocks() {
 	ZN_PROFILE_SCOPE();
+
+	if (_pending_edited_boxes.size() == 0) {
+		return;
+	}
 	ZN_ASSERT_RETURN(_terrain != nullptr);
 
+	const int block_size = _terrain->get_data_block_size();
+	VoxelData &data = _terrain->get_storage();
+
+	// Coalesce edits into the list of blocks they touched
+	StdVector<Vector3i> edited_blocks;
+	for (const Box3i &voxel_box : _pending_edited_boxes) {
+		voxel_box.downscaled(block_size).for_each_cell([&edited_blocks](Vector3i bpos) { //
+			edited_blocks.push_back(bpos);
+		});
+	}
+	_pending_edited_boxes.clear();
+	// TODO Candidate for temp allocator
+	std::sort(edited_blocks.begin(), edited_blocks.end());
+	edited_blocks.erase(std::unique(edited_blocks.begin(), edited_blocks.end()), edited_blocks.end());
+
 	StdVector<ViewerID> viewers;
-	_terrain->get_viewers_in_area(viewers, voxel_box);
+	StdVector<int> peer_ids;
 
-	// Not particularly efficient for single-voxel edits, but should scale ok with bigger boxes
-	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-	voxels.create(voxel_box.size);
-	_terrain->get_storage().copy(voxel_box.position, voxels, 0xff);
+	for (const Vector3i bpos : edited_blocks) {
+		_serialized_blocks_cache.erase(bpos);
 
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(voxels);
-	ZN_ASSERT_RETURN(result.success);
+		viewers.clear();
+		_terrain->get_viewers_in_area(viewers, Box3i(bpos * block_size, Vector3iUtil::create(block_size)));
 
-	PackedByteArray pba;
-	pba.resize(4 * sizeof(int32_t) + result.data.size());
+		peer_ids.clear();
+		for (const ViewerID viewer_id : viewers) {
+			const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
+			if (peer_id != -1 && peer_id != MultiplayerPeer::TARGET_PEER_SERVER) {
+				peer_ids.push_back(peer_id);
+			}
+		}
 
-	ByteSpanWithPosition mw_span(Span<uint8_t>(pba.ptrw(), pba.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+		if (peer_ids.size() == 0) {
+			// Nobody to send to. Peers coming later will receive the whole block.
+			_baselines.erase(bpos);
+			continue;
+		}
 
-	mw.store_32(voxel_box.position.x);
-	mw.store_32(voxel_box.position.y);
-	mw.store_32(voxel_box.position.z);
-	mw.store_32(result.data.size());
-	mw.store_buffer(to_span(result.data));
-	for (const ViewerID viewer_id : viewers) {
-		const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
-		// TODO Don't bother copying and serializing if no networked viewers are around?
-		if (peer_id != -1 && peer_id != MultiplayerPeer::TARGET_PEER_SERVER) {
-			rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_area, pba);
+		SpatialLock3D::Read srlock(data.get_spatial_lock(0), BoxBounds3i::from_position(bpos));
+		std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(bpos);
+		if (voxels == nullptr) {
+			_baselines.erase(bpos);
+			continue;
+		}
+
+		// Serialize once for all peers
+		PackedByteArray message_data;
+		bool is_diff = false;
+
+		auto baseline_it = _baselines.find(bpos);
+		if (baseline_it != _baselines.end()) {
+			BlockSerializer::SerializeResult result =
+					BlockSerializer::serialize_diff_and_compress(*baseline_it->second.voxels, *voxels);
+			// Can fail if metadata changed, in which case we send the whole block
+			if (result.success) {
+				message_data = make_block_message(bpos, to_span(result.data), true);
+				is_diff = true;
+			}
+		}
+
+		if (!is_diff) {
+			message_data = serialize_block_message(bpos, *voxels);
+			if (message_data.size() == 0) {
+				continue;
+			}
+		}
+
+		StdUnorderedMap<int, StdVector<DeferredBlockMessage>> &messages_per_peer =
+				is_diff ? _deferred_block_diff_messages_per_peer : _deferred_block_messages_per_peer;
+		for (const int peer_id : peer_ids) {
+			messages_per_peer[peer_id].push_back(DeferredBlockMessage{ message_data });
+		}
+
+		// Update baseline to what peers will have after receiving the message
+		Baseline &baseline = _baselines[bpos];
+		if (baseline.voxels == nullptr) {
+			baseline.voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+		}
+		voxels->copy_to(*baseline.voxels, true);
+		baseline.last_edit_frame = _frame_index;
+	}
+
+	// Forget baselines of blocks that haven't been edited recently, edits tend to happen in bursts at the same places.
+	// If they get edited again, the whole block will be sent.
+	const uint64_t BASELINE_EXPIRATION_FRAMES = 600;
+	for (auto it = _baselines.begin(); it != _baselines.end();) {
+		if (_frame_index - it->second.last_edit_frame > BASELINE_EXPIRATION_FRAMES) {
+			it = _baselines.erase(it);
+		} else {
+			++it;
 		}
 	}
 }
@@ -142,23 +272,24 @@ void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
 // 	}
 // }
 
-void VoxelTerrainMultiplayerSynchronizer::process() {
-	ZN_PROFILE_SCOPE();
+namespace {
 
-	for (auto it = _deferred_block_messages_per_peer.begin(); it != _deferred_block_messages_per_peer.end(); ++it) {
-		StdVector<DeferredBlockMessage> &messages = it->second;
+// Makes one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
+// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by the
+// high-level features...
+template <typename TMessage, typename FSend>
+void send_deferred_messages(StdUnorderedMap<int, StdVector<TMessage>> &messages_per_peer, FSend send_func) {
+	for (auto it = messages_per_peer.begin(); it != messages_per_peer.end(); ++it) {
+		StdVector<TMessage> &messages = it->second;
 
 		if (messages.size() == 0) {
 			continue;
 		}
 
 		PackedByteArray pba;
-		// Make one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
-		// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by
-		// the high-level features...
 
 		unsigned int size = 0;
-		for (const DeferredBlockMessage &message : messages) {
+		for (const TMessage &message : messages) {
 			size += message.data.size();
 		}
 
@@ -168,18 +299,38 @@ void VoxelTerrainMultiplayerSynchronizer::process() {
 		MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
 		mw.store_32(messages.size());
 
-		for (const DeferredBlockMessage &message : messages) {
+		for (const TMessage &message : messages) {
 			mw.store_buffer(Span<const uint8_t>(message.data.ptr(), message.data.size()));
 		}
 		ZN_ASSERT(mw.data.size() == mw.data.pos);
 
 		messages.clear();
 
-		const int peer_id = it->first;
+		send_func(it->first, pba);
+	}
+}
+
+} // namespace
+
+void VoxelTerrainMultiplayerSynchronizer::process() {
+	ZN_PROFILE_SCOPE();
+
+	flush_edited_blocks();
+
+	// Whole blocks are sent first, because diffs of the same frame may be relative to them
+	send_deferred_messages(_deferred_block_messages_per_peer, [this](int peer_id, const PackedByteArray &pba) {
 		ZN_PRINT_VERBOSE(format("Sending {} bytes of block data to peer {}", pba.size(), peer_id));
 		// print_data_hex(Span<const uint8_t>(pba.ptr(), pba.size()));
 		rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_blocks, pba);
-	}
+	});
+
+	send_deferred_messages(_deferred_block_diff_messages_per_peer, [this](int peer_id, const PackedByteArray &pba) {
+		ZN_PRINT_VERBOSE(format("Sending {} bytes of block diff data to peer {}", pba.size(), peer_id));
+		rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_block_diffs, pba);
+	});
+
+	_serialized_blocks_cache.clear();
+	++_frame_index;
 }
 
 void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray message_data) {
@@ -216,28 +367,46 @@ void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray mess
 	}
 }
 
-void VoxelTerrainMultiplayerSynchronizer::_b_receive_area(PackedByteArray message_data) {
+void VoxelTerrainMultiplayerSynchronizer::_b_receive_block_diffs(PackedByteArray message_data) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
 
 	MemoryReader mr(Span<const uint8_t>(message_data.ptr(), message_data.size()), ENDIANNESS_LITTLE_ENDIAN);
 
-	Vector3i pos;
-	pos.x = int32_t(mr.get_32());
-	pos.y = int32_t(mr.get_32());
-	pos.z = int32_t(mr.get_32());
-	const int voxel_data_size = mr.get_32();
-
-	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-	ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(mr.data.sub(mr.pos, voxel_data_size), voxels));
-
-	_terrain->get_storage().paste(pos, voxels, 0xff, false);
-	_terrain->post_edit_area(
-			Box3i(pos, voxels.get_size()),
-			// Don't bother for now, update mesh regardless. If necessary we would have to add a flag with the message
-			// to tell it's not actually changing voxels (if it's metadata changes), but might not be worth it
-			true
-	);
+	const unsigned int block_count = mr.get_32();
+	VoxelData &data = _terrain->get_storage();
+	const int block_size = _terrain->get_data_block_size();
+
+	for (unsigned int i = 0; i < block_count; ++i) {
+		Vector3i bpos;
+		bpos.x = int16_t(mr.get_16());
+		bpos.y = int16_t(mr.get_16());
+		bpos.z = int16_t(mr.get_16());
+		const unsigned int diff_data_size = mr.get_32();
+		ZN_ASSERT_RETURN(mr.pos + diff_data_size <= mr.data.size());
+
+		bool applied = false;
+		{
+			SpatialLock3D::Write swlock(data.get_spatial_lock(0), BoxBounds3i::from_position(bpos));
+			std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(bpos);
+			// If we don't have the block, ignore. It will be received entirely when it gets in range.
+			if (voxels != nullptr) {
+				applied = BlockSerializer::decompress_and_apply_diff(mr.data.sub(mr.pos, diff_data_size), *voxels);
+			}
+		}
+
+		mr.pos += diff_data_size;
+
+		if (applied) {
+			_terrain->post_edit_area(
+					Box3i(bpos * block_size, Vector3iUtil::create(block_size)),
+					// Don't bother for now, update mesh regardless. If necessary we would have to add a flag with the
+					// message to tell it's not actually changing voxels (if it's metadata changes), but might not be
+					// worth it
+					true
+			);
+		}
+	}
 }
 
 #ifdef TOOLS_ENABLED
@@ -285,7 +454,9 @@ void VoxelTerrainMultiplayerSynchronizer::_bind_methods() {
 	ClassDB::bind_method(
 			D_METHOD("_rpc_receive_blocks", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks
 	);
-	ClassDB::bind_method(D_METHOD("_rpc_receive_area", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_area);
+	ClassDB::bind_method(
+			D_METHOD("_rpc_receive_block_diffs", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_block_diffs
+	);
 }
 
 } // namespace zylann::voxel
@@ -40,8 +40,11 @@ private:
 
 	void process();
 
+	void flush_edited_blocks();
+	bool has_pending_edits(Vector3i bpos) const;
+
 	void _b_receive_blocks(PackedByteArray message_data);
-	void _b_receive_area(PackedByteArray message_data);
+	void _b_receive_block_diffs(PackedByteArray message_data);
 
 	static void _bind_methods();
 
@@ -53,6 +56,25 @@ private:
 	};
 
 	StdUnorderedMap<int, StdVector<DeferredBlockMessage>> _deferred_block_messages_per_peer;
+	StdUnorderedMap<int, StdVector<DeferredBlockMessage>> _deferred_block_diff_messages_per_peer;
+
+	// Edited areas are accumulated and sent once per frame, so many edits in the same frame (like explosions) result
+	// in one message per peer, and blocks touched by several edits are only sent once.
+	StdVector<Box3i> _pending_edited_boxes;
+
+	// Last state of edited blocks sent to peers. Next edits are sent as differences from that state.
+	// Messages are sent on a reliable ordered channel, so every peer viewing a block is known to have that state by the
+	// time it receives the next difference, without having to acknowledge it.
+	struct Baseline {
+		std::shared_ptr<VoxelBuffer> voxels;
+		uint64_t last_edit_frame = 0;
+	};
+	StdUnorderedMap<Vector3i, Baseline> _baselines;
+
+	// Block messages serialized during the current frame, shared by all peers requesting the same block
+	StdUnorderedMap<Vector3i, PackedByteArray> _serialized_blocks_cache;
+
+	uint64_t _frame_index = 0;
 };
 
 } // namespace zylann::voxel
@@ -1,6 +1,7 @@
 #ifndef VOXEL_INSTANCER_TASK_OUTPUT_QUEUE_H
 #define VOXEL_INSTANCER_TASK_OUTPUT_QUEUE_H
 
+#include "../../streams/instance_data.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/math/transform3f.h"
 #include "../../util/math/vector3i.h"
@@ -16,6 +17,16 @@ struct InstanceLoadingTaskOutput {
 	// When data chunks are half the size of render chunks, this is 8 bits in XYZ order.
 	uint8_t edited_mask;
 	StdVector<Transform3f> transforms;
+
+	// Saved instances are passed in their quantized form, so they can be decoded straight into the format needed to
+	// render them. They come after `transforms`.
+	struct LoadedInstances {
+		InstanceBlockData::LayerData data;
+		float quantized_position_range;
+		// Origin of the data block relative to the render block
+		Vector3f offset;
+	};
+	StdVector<LoadedInstances> loaded_instances;
 };
 
 struct InstancerTaskOutputQueue {
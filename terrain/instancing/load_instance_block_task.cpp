@@ -12,6 +12,33 @@
 
 namespace zylann::voxel {
 
+unsigned int get_instance_count(Span<const InstanceLoadingTaskOutput::LoadedInstances> loaded_instances) {
+	unsigned int count = 0;
+	for (const InstanceLoadingTaskOutput::LoadedInstances &li : loaded_instances) {
+		count += li.data.get_instance_count();
+	}
+	return count;
+}
+
+void decode_loaded_instances(
+		Span<const InstanceLoadingTaskOutput::LoadedInstances> loaded_instances,
+		StdVector<Transform3f> &transforms
+) {
+	ZN_PROFILE_SCOPE();
+	unsigned int dst_index = transforms.size();
+	transforms.resize(transforms.size() + get_instance_count(loaded_instances));
+	for (const InstanceLoadingTaskOutput::LoadedInstances &li : loaded_instances) {
+		const unsigned int instance_count = li.data.get_instance_count();
+		decode_instances_to_transforms(
+				li.data,
+				li.quantized_position_range,
+				li.offset,
+				to_span(transforms).sub(dst_index, instance_count)
+		);
+		dst_index += instance_count;
+	}
+}
+
 LoadInstanceChunkTask::LoadInstanceChunkTask( //
 		std::shared_ptr<InstancerTaskOutputQueue> output_queue, //
 		Ref<VoxelStream> stream, //
@@ -53,6 +80,7 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 		int id = -1;
 		uint8_t edited_mask = 0;
 		StdVector<Transform3f> transforms;
+		StdVector<InstanceLoadingTaskOutput::LoadedInstances> loaded_instances;
 	};
 
 	StdVector<Layer> layers;
@@ -130,7 +158,7 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 		// For each octant (will be only 1 if data chunks are the same size as render chunks, otherwise 8)
 		// Populate layers from what we found in stream
 		for (unsigned int octant_index = 0; octant_index < query_count; ++octant_index) {
-			const VoxelStream::InstancesQueryData &query = queries[octant_index];
+			VoxelStream::InstancesQueryData &query = queries[octant_index];
 
 			if (query.result == VoxelStream::RESULT_BLOCK_FOUND) {
 				if (query.data == nullptr) {
@@ -149,7 +177,9 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 					continue;
 				}
 
-				for (const InstanceBlockData::LayerData &loaded_layer_data : query.data->layers) {
+				const float quantized_position_range = query.data->get_quantized_position_range();
+
+				for (InstanceBlockData::LayerData &loaded_layer_data : query.data->layers) {
 					const int layer_id = loaded_layer_data.id;
 					size_t layer_index;
 
@@ -172,23 +202,13 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 						layer.edited_mask = 0xff;
 					}
 
-					const unsigned int dst_index0 = layer.transforms.size();
-
-					layer.transforms.reserve(layer.transforms.size() + loaded_layer_data.instances.size());
-					for (const InstanceBlockData::InstanceData &id : loaded_layer_data.instances) {
-						layer.transforms.push_back(id.transform);
-					}
-
-					if (data_factor == 2) {
-						// Data blocks store instances relative to a smaller grid than render blocks.
-						// So we need to adjust their relative position.
-						const Vector3f rel =
-								to_vec3f((query.position_in_blocks - data_min_block_pos) * data_block_size_at_lod);
-						ZN_ASSERT(dst_index0 <= layer.transforms.size());
-						for (auto it = layer.transforms.begin() + dst_index0; it != layer.transforms.end(); ++it) {
-							it->origin += rel;
-						}
-					}
+					// Instances are not decoded yet, they might not need to be turned into transforms.
+					// Data blocks store instances relative to a smaller grid than render blocks, so their position will
+					// have to be offset.
+					const Vector3f offset =
+							to_vec3f((query.position_in_blocks - data_min_block_pos) * data_block_size_at_lod);
+					layer.loaded_instances.push_back(InstanceLoadingTaskOutput::LoadedInstances{
+							std::move(loaded_layer_data), quantized_position_range, offset });
 				}
 			}
 		}
@@ -237,6 +257,8 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 						task->up_mode = _up_mode;
 						task->surface_arrays = _mesh_arrays;
 						task->generator = item.generator;
+						// Generated instances will be added to loaded ones, so they are decoded now
+						decode_loaded_instances(to_span_const(layer.loaded_instances), layer.transforms);
 						task->transforms = std::move(layer.transforms);
 						task->output_queue = _output_queue;
 
@@ -261,6 +283,7 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 		o.edited_mask = layer.edited_mask;
 		o.render_block_position = _render_grid_position;
 		o.transforms = std::move(layer.transforms);
+		o.loaded_instances = std::move(layer.loaded_instances);
 		{
 			MutexLock(_output_queue->mutex);
 			_output_queue->results.push_back(std::move(o));
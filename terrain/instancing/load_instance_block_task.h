@@ -50,6 +50,14 @@ private:
 	UpMode _up_mode;
 };
 
+unsigned int get_instance_count(Span<const InstanceLoadingTaskOutput::LoadedInstances> loaded_instances);
+
+// Appends decoded loaded instances to a list of transforms
+void decode_loaded_instances(
+		Span<const InstanceLoadingTaskOutput::LoadedInstances> loaded_instances,
+		StdVector<Transform3f> &transforms
+);
+
 } // namespace zylann::voxel
 
 #endif // VOXEL_LOAD_INSTANCE_BLOCK_TASK_H
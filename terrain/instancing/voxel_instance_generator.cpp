@@ -1,6 +1,5 @@
 #include "voxel_instance_generator.h"
 #include "../../constants/voxel_string_names.h"
-#include "../../util/containers/container_funcs.h"
 #include "../../util/godot/classes/array_mesh.h"
 #include "../../util/godot/classes/engine.h"
 #include "../../util/godot/core/array.h"
@@ -9,6 +8,8 @@
 #include "../../util/math/triangle.h"
 #include "../../util/profiling.h"
 
+#include <algorithm>
+
 namespace zylann::voxel {
 
 namespace {
@@ -18,6 +19,62 @@ const float MAX_DENSITY = 10.f;
 // We expose a slider going below max density as it should not often be needed, but we allow greater if really necessary
 const char *DENSITY_HINT_STRING = "0.0, 1.0, 0.01, or_greater";
 
+// Removes items for which `keep` is zero, preserving the order of remaining items.
+// Each stage of instance generation first computes `keep` for all candidates, then compacts every attribute array,
+// so predicates can be evaluated in tight loops without branching on removal.
+template <typename T>
+void compact(StdVector<T> &items, Span<const uint8_t> keep) {
+	size_t dst = 0;
+	for (size_t src = 0; src < items.size(); ++src) {
+		items[dst] = items[src];
+		dst += keep[src];
+	}
+	items.resize(dst);
+}
+
+// Candidate instances are stored as one array per attribute, which stages fill and filter in batches.
+struct InstanceCandidates {
+	StdVector<Vector3f> positions;
+	StdVector<Vector3f> normals;
+	// Only used with `UP_MODE_SPHERE`: direction and distance from the center of the world.
+	StdVector<Vector3f> sphere_ups;
+	StdVector<float> sphere_distances;
+	StdVector<float> noise;
+	// Scratch
+	StdVector<uint8_t> keep;
+	StdVector<float> noise_x;
+	StdVector<float> noise_y;
+	StdVector<float> noise_z;
+
+	void clear() {
+		positions.clear();
+		normals.clear();
+		sphere_ups.clear();
+		sphere_distances.clear();
+		noise.clear();
+	}
+
+	void compact_with_keep(const bool has_sphere, const bool has_noise) {
+		const Span<const uint8_t> keep_s = to_span_const(keep);
+		compact(positions, keep_s);
+		compact(normals, keep_s);
+		if (has_sphere) {
+			compact(sphere_ups, keep_s);
+			compact(sphere_distances, keep_s);
+		}
+		if (has_noise) {
+			compact(noise, keep_s);
+		}
+	}
+};
+
+// Attributes of instances which passed all filters, used to build final transforms
+struct InstanceAttributes {
+	StdVector<Vector3f> axis_y;
+	StdVector<Vector3f> look_dirs;
+	StdVector<float> scales;
+};
+
 } // namespace
 
 void VoxelInstanceGenerator::generate_transforms(
@@ -56,7 +113,7 @@ void VoxelInstanceGenerator::generate_transforms(
 
 	const uint32_t block_pos_hash = Vector3iHasher::hash(grid_position);
 
-	Vector3f global_up(0.f, 1.f, 0.f);
+	const Vector3f global_up(0.f, 1.f, 0.f);
 
 	// Using different number generators so changing parameters affecting one doesn't affect the other
 	const uint64_t seed = block_pos_hash + layer_id;
@@ -69,19 +126,17 @@ void VoxelInstanceGenerator::generate_transforms(
 
 	// TODO This part might be moved to the meshing thread if it turns out to be too heavy
 
-	static thread_local StdVector<Vector3f> g_vertex_cache;
-	static thread_local StdVector<Vector3f> g_normal_cache;
-	static thread_local StdVector<float> g_noise_cache;
-	// static thread_local StdVector<float> g_noise_graph_output_cache;
-	static thread_local StdVector<float> g_noise_graph_x_cache;
-	static thread_local StdVector<float> g_noise_graph_y_cache;
-	static thread_local StdVector<float> g_noise_graph_z_cache;
+	// Instances are generated in batched stages: candidates are emitted from the mesh, then filtered by cheap
+	// geometric criteria, then by noise evaluated in one go over the remaining candidates, and finally transforms
+	// are built. Each stage runs over whole arrays, which is friendlier to caches and auto-vectorization.
+	static thread_local InstanceCandidates g_candidates;
+	static thread_local InstanceAttributes g_attributes;
 
-	StdVector<Vector3f> &vertex_cache = g_vertex_cache;
-	StdVector<Vector3f> &normal_cache = g_normal_cache;
+	InstanceCandidates &candidates = g_candidates;
+	candidates.clear();
 
-	vertex_cache.clear();
-	normal_cache.clear();
+	StdVector<Vector3f> &vertex_cache = candidates.positions;
+	StdVector<Vector3f> &normal_cache = candidates.normals;
 
 	// Pick random points
 	{
@@ -226,26 +281,100 @@ void VoxelInstanceGenerator::generate_transforms(
 		}
 	}
 
-	// Filter out by octants
-	// This is done so some octants can be filled with user-edited data instead,
-	// because mesh size may not necessarily match data block size
-	if ((octant_mask & 0xff) != 0xff) {
-		ZN_PROFILE_SCOPE_NAMED("octant filter");
-		const float h = block_size / 2.f;
-		for (unsigned int i = 0; i < vertex_cache.size(); ++i) {
-			const Vector3f &pos = vertex_cache[i];
-			const uint8_t octant_index = get_octant_index(pos, h);
-			if ((octant_mask & (1 << octant_index)) == 0) {
-				unordered_remove(vertex_cache, i);
-				unordered_remove(normal_cache, i);
-				--i;
-			}
-		}
+	if (vertex_cache.size() == 0) {
+		return;
 	}
 
 	// Position of the block relative to the instancer node.
 	// Use full-precision here because we deal with potentially large coordinates
 	const Vector3 mesh_block_origin_d = grid_position * block_size;
+	const Vector3f mesh_block_origin = to_vec3f(mesh_block_origin_d);
+
+	const float vertical_alignment = _vertical_alignment;
+	const float scale_min = _min_scale;
+	const float scale_range = _max_scale - _min_scale;
+	const Distribution scale_distribution = _scale_distribution;
+	const bool random_vertical_flip = _random_vertical_flip;
+	const bool random_rotation = _random_rotation;
+	const float offset_along_normal = _offset_along_normal;
+	const float normal_min_y = _min_surface_normal_y;
+	const float normal_max_y = _max_surface_normal_y;
+	const bool slope_filter = normal_min_y != -1.f || normal_max_y != 1.f;
+	const bool height_filter =
+			_min_height != std::numeric_limits<float>::min() || _max_height != std::numeric_limits<float>::max();
+	const float min_height = _min_height;
+	const float max_height = _max_height;
+	const bool octant_filter = (octant_mask & 0xff) != 0xff;
+	const Dimension noise_dimension = _noise_dimension;
+	const float noise_on_scale = _noise_on_scale;
+
+	const bool sphere_mode = up_mode == UP_MODE_SPHERE;
+	// Sphere up vectors are used by several stages, so they are computed once if any of them needs it
+	const bool use_sphere_up = sphere_mode && (vertical_alignment != 0.f || slope_filter || height_filter);
+
+	if (use_sphere_up) {
+		ZN_PROFILE_SCOPE_NAMED("Sphere up");
+		candidates.sphere_ups.resize(vertex_cache.size());
+		candidates.sphere_distances.resize(vertex_cache.size());
+		for (size_t i = 0; i < vertex_cache.size(); ++i) {
+			float distance;
+			candidates.sphere_ups[i] = math::normalized(mesh_block_origin + vertex_cache[i], distance);
+			candidates.sphere_distances[i] = distance;
+		}
+	}
+
+	// Filter out by octants, slope and height.
+	// These are cheap, so they run before noise in order to evaluate noise on fewer candidates.
+	if (octant_filter || slope_filter || height_filter) {
+		ZN_PROFILE_SCOPE_NAMED("Geometric filter");
+
+		StdVector<uint8_t> &keep = candidates.keep;
+		keep.resize(vertex_cache.size());
+
+		// Filter out by octants
+		// This is done so some octants can be filled with user-edited data instead,
+		// because mesh size may not necessarily match data block size
+		if (octant_filter) {
+			const float h = block_size / 2.f;
+			for (size_t i = 0; i < vertex_cache.size(); ++i) {
+				keep[i] = (octant_mask >> get_octant_index(vertex_cache[i], h)) & 1;
+			}
+		} else {
+			std::fill(keep.begin(), keep.end(), 1);
+		}
+
+		// Warning: sometimes mesh normals are not perfectly normalized.
+		// The cause is for meshing speed on CPU. It's normalized on GPU anyways.
+		if (slope_filter) {
+			if (use_sphere_up) {
+				for (size_t i = 0; i < vertex_cache.size(); ++i) {
+					const float ny = math::dot(math::normalized(normal_cache[i]), candidates.sphere_ups[i]);
+					keep[i] &= (ny >= normal_min_y && ny <= normal_max_y);
+				}
+			} else {
+				for (size_t i = 0; i < vertex_cache.size(); ++i) {
+					const float ny = math::normalized(normal_cache[i]).y;
+					keep[i] &= (ny >= normal_min_y && ny <= normal_max_y);
+				}
+			}
+		}
+
+		if (height_filter) {
+			if (use_sphere_up) {
+				for (size_t i = 0; i < vertex_cache.size(); ++i) {
+					const float y = candidates.sphere_distances[i];
+					keep[i] &= (y >= min_height && y <= max_height);
+				}
+			} else {
+				for (size_t i = 0; i < vertex_cache.size(); ++i) {
+					const float y = mesh_block_origin.y + vertex_cache[i].y;
+					keep[i] &= (y >= min_height && y <= max_height);
+				}
+			}
+		}
+
+		candidates.compact_with_keep(use_sphere_up, false);
+	}
 
 	// Don't directly access member vars because they can be modified by the editor thread (the resources themselves can
 	// get modified with relatively no harm, but the pointers can't)
@@ -257,320 +386,274 @@ void VoxelInstanceGenerator::generate_transforms(
 		noise_graph = _noise_graph;
 	}
 
-	// Filter out by noise graph
-	if (noise_graph.is_valid()) {
-		ZN_PROFILE_SCOPE_NAMED("Noise graph filter");
+	const bool use_noise = noise.is_valid() || noise_graph.is_valid();
 
-		StdVector<float> &out_buffer = g_noise_cache;
-		out_buffer.resize(vertex_cache.size());
+	StdVector<float> &noise_cache = candidates.noise;
 
-		// Check noise graph validity
-		std::shared_ptr<pg::VoxelGraphFunction::CompiledGraph> compiled_graph = noise_graph->get_compiled_graph();
-		if (compiled_graph != nullptr) {
-			const int input_count = compiled_graph->runtime.get_input_count();
-			const int output_count = compiled_graph->runtime.get_output_count();
+	// Filter out by noise
+	if (use_noise && vertex_cache.size() > 0) {
+		ZN_PROFILE_SCOPE_NAMED("Noise filter");
+		ERR_FAIL_INDEX(noise_dimension, DIMENSION_COUNT);
 
-			bool valid = (output_count == 1);
+		const size_t count = vertex_cache.size();
+		noise_cache.resize(count);
 
-			switch (_noise_dimension) {
-				case DIMENSION_2D:
-					if (input_count != 2) {
-						valid = false;
-					}
-					break;
-				case DIMENSION_3D:
-					if (input_count != 3) {
-						valid = false;
-					}
-					break;
-				default:
-					ERR_FAIL();
-			}
+		if (noise_graph.is_valid()) {
+			// Check noise graph validity
+			std::shared_ptr<pg::VoxelGraphFunction::CompiledGraph> compiled_graph = noise_graph->get_compiled_graph();
+			if (compiled_graph != nullptr) {
+				const int input_count = compiled_graph->runtime.get_input_count();
+				const int output_count = compiled_graph->runtime.get_output_count();
+				const int expected_input_count = noise_dimension == DIMENSION_2D ? 2 : 3;
 
-			if (!valid) {
-				compiled_graph = nullptr;
+				if (output_count != 1 || input_count != expected_input_count) {
+					compiled_graph = nullptr;
+				}
 			}
-		}
-
-		if (compiled_graph != nullptr) {
-			// Execute graph
-
-			StdVector<float> &x_buffer = g_noise_graph_x_cache;
-			StdVector<float> &z_buffer = g_noise_graph_z_cache;
-			x_buffer.resize(vertex_cache.size());
-			z_buffer.resize(vertex_cache.size());
 
-			FixedArray<Span<float>, 1> outputs;
-			outputs[0] = to_span(out_buffer);
+			if (compiled_graph != nullptr) {
+				// World-space coordinates of all candidates, evaluated in one batch. Graphs only take floats.
+				StdVector<float> &x_buffer = candidates.noise_x;
+				StdVector<float> &y_buffer = candidates.noise_y;
+				StdVector<float> &z_buffer = candidates.noise_z;
+				x_buffer.resize(count);
+				y_buffer.resize(count);
+				z_buffer.resize(count);
+
+				for (size_t i = 0; i < count; ++i) {
+					const Vector3 pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+					x_buffer[i] = pos.x;
+					y_buffer[i] = pos.y;
+					z_buffer[i] = pos.z;
+				}
 
-			switch (_noise_dimension) {
-				case DIMENSION_2D: {
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						x_buffer[i] = pos.x;
-						z_buffer[i] = pos.z;
-					}
+				// Execute graph
+				FixedArray<Span<float>, 1> outputs;
+				outputs[0] = to_span(noise_cache);
 
+				if (noise_dimension == DIMENSION_2D) {
 					FixedArray<Span<float>, 2> inputs;
 					inputs[0] = to_span(x_buffer);
 					inputs[1] = to_span(z_buffer);
-
 					noise_graph->execute(to_span(inputs), to_span(outputs));
-				} break;
-
-				case DIMENSION_3D: {
-					StdVector<float> &y_buffer = g_noise_graph_y_cache;
-					y_buffer.resize(vertex_cache.size());
-
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						x_buffer[i] = pos.x;
-						y_buffer[i] = pos.y;
-						z_buffer[i] = pos.z;
-					}
 
+				} else {
 					FixedArray<Span<float>, 3> inputs;
 					inputs[0] = to_span(x_buffer);
 					inputs[1] = to_span(y_buffer);
 					inputs[2] = to_span(z_buffer);
-
 					noise_graph->execute(to_span(inputs), to_span(outputs));
-				} break;
-
-				default:
-					ERR_FAIL();
-			}
+				}
 
-		} else {
-			// Error fallback
-			for (float &v : out_buffer) {
-				v = 0.f;
+			} else {
+				// Error fallback
+				std::fill(noise_cache.begin(), noise_cache.end(), 0.f);
 			}
 		}
-	}
 
-	StdVector<float> &noise_cache = g_noise_cache;
-
-	// Legacy noise (noise graph is more versatile, but this remains for compatibility)
-	if (noise.is_valid()) {
-		noise_cache.resize(vertex_cache.size());
-
-		switch (_noise_dimension) {
-			case DIMENSION_2D: {
-				if (noise_graph.is_valid()) {
-					// Multiply output of noise graph
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						// Casting to float because Noise returns `real_t`, which is `double` in 64-bit float builds,
-						// but we don't need doubles for noise in this context...
+		// Legacy noise (noise graph is more versatile, but this remains for compatibility).
+		// Positions are given with full precision, since `Noise` takes `real_t`, which is `double` in 64-bit float
+		// builds. Casting the result to float because we don't need doubles for noise in this context...
+		if (noise.is_valid()) {
+			if (noise_graph.is_valid()) {
+				// Multiply output of noise graph
+				if (noise_dimension == DIMENSION_2D) {
+					for (size_t i = 0; i < count; ++i) {
+						const Vector3 pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
 						noise_cache[i] *= math::max(float(noise->get_noise_2d(pos.x, pos.z)), 0.f);
 					}
 				} else {
-					// Use noise directly
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						noise_cache[i] = noise->get_noise_2d(pos.x, pos.z);
+					for (size_t i = 0; i < count; ++i) {
+						const Vector3 pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+						noise_cache[i] *= math::max(float(noise->get_noise_3d(pos.x, pos.y, pos.z)), 0.f);
 					}
 				}
-			} break;
-
-			case DIMENSION_3D: {
-				if (noise_graph.is_valid()) {
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
-						noise_cache[i] *= math::max(float(noise->get_noise_3d(pos.x, pos.y, pos.z)), 0.f);
+			} else {
+				// Use noise directly
+				if (noise_dimension == DIMENSION_2D) {
+					for (size_t i = 0; i < count; ++i) {
+						const Vector3 pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+						noise_cache[i] = noise->get_noise_2d(pos.x, pos.z);
 					}
 				} else {
-					for (size_t i = 0; i < vertex_cache.size(); ++i) {
-						const Vector3 &pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
+					for (size_t i = 0; i < count; ++i) {
+						const Vector3 pos = to_vec3(vertex_cache[i]) + mesh_block_origin_d;
 						noise_cache[i] = noise->get_noise_3d(pos.x, pos.y, pos.z);
 					}
 				}
-			} break;
-
-			default:
-				ERR_FAIL();
-		}
-	}
-
-	const bool use_noise = noise.is_valid() || noise_graph.is_valid();
-
-	// Filter out by noise
-	if (use_noise) {
-		ZN_PROFILE_SCOPE_NAMED("Noise filter");
-
-		for (size_t i = 0; i < vertex_cache.size(); ++i) {
-			const float n = noise_cache[i];
-			if (n <= 0) {
-				unordered_remove(vertex_cache, i);
-				unordered_remove(normal_cache, i);
-				unordered_remove(noise_cache, i);
-				--i;
 			}
 		}
-	}
-
-	const float vertical_alignment = _vertical_alignment;
-	const float scale_min = _min_scale;
-	const float scale_range = _max_scale - _min_scale;
-	const bool random_vertical_flip = _random_vertical_flip;
-	const float offset_along_normal = _offset_along_normal;
-	const float normal_min_y = _min_surface_normal_y;
-	const float normal_max_y = _max_surface_normal_y;
-	const bool slope_filter = normal_min_y != -1.f || normal_max_y != 1.f;
-	const bool height_filter =
-			_min_height != std::numeric_limits<float>::min() || _max_height != std::numeric_limits<float>::max();
-	const float min_height = _min_height;
-	const float max_height = _max_height;
 
-	const Vector3f fixed_look_axis = up_mode == UP_MODE_POSITIVE_Y ? Vector3f(1, 0, 0) : Vector3f(0, 1, 0);
-	const Vector3f fixed_look_axis_alternative = up_mode == UP_MODE_POSITIVE_Y ? Vector3f(0, 1, 0) : Vector3f(1, 0, 0);
-	const Vector3f mesh_block_origin = to_vec3f(grid_position * block_size);
+		StdVector<uint8_t> &keep = candidates.keep;
+		keep.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			keep[i] = noise_cache[i] > 0.f;
+		}
 
-	// Calculate orientations and scales
-	for (size_t vertex_index = 0; vertex_index < vertex_cache.size(); ++vertex_index) {
-		Transform3f t;
-		t.origin = vertex_cache[vertex_index];
+		candidates.compact_with_keep(use_sphere_up, true);
+	}
 
-		// Warning: sometimes mesh normals are not perfectly normalized.
-		// The cause is for meshing speed on CPU. It's normalized on GPU anyways.
-		Vector3f surface_normal = normal_cache[vertex_index];
+	const size_t instance_count = vertex_cache.size();
+	if (instance_count == 0) {
+		return;
+	}
 
-		Vector3f axis_y;
+	InstanceAttributes &attributes = g_attributes;
+	StdVector<Vector3f> &axis_y_cache = attributes.axis_y;
+	StdVector<Vector3f> &look_dir_cache = attributes.look_dirs;
+	StdVector<float> &scale_cache = attributes.scales;
+	axis_y_cache.resize(instance_count);
+	look_dir_cache.resize(instance_count);
+	scale_cache.resize(instance_count);
 
-		bool surface_normal_is_normalized = false;
-		bool sphere_up_is_computed = false;
-		bool sphere_distance_is_computed = false;
-		float sphere_distance;
+	// Calculate up axes
+	{
+		ZN_PROFILE_SCOPE_NAMED("Up axes");
 
 		if (vertical_alignment == 0.f) {
-			surface_normal = math::normalized(surface_normal);
-			surface_normal_is_normalized = true;
-			axis_y = surface_normal;
-
-		} else {
-			if (up_mode == UP_MODE_SPHERE) {
-				global_up = math::normalized(mesh_block_origin + t.origin, sphere_distance);
-				sphere_up_is_computed = true;
-				sphere_distance_is_computed = true;
+			for (size_t i = 0; i < instance_count; ++i) {
+				axis_y_cache[i] = math::normalized(normal_cache[i]);
 			}
 
-			if (vertical_alignment < 1.f) {
-				axis_y = math::normalized(math::lerp(surface_normal, global_up, vertical_alignment));
+		} else if (vertical_alignment < 1.f) {
+			if (use_sphere_up) {
+				for (size_t i = 0; i < instance_count; ++i) {
+					const Vector3f up = candidates.sphere_ups[i];
+					axis_y_cache[i] = math::normalized(math::lerp(normal_cache[i], up, vertical_alignment));
+				}
+			} else {
+				for (size_t i = 0; i < instance_count; ++i) {
+					axis_y_cache[i] = math::normalized(math::lerp(normal_cache[i], global_up, vertical_alignment));
+				}
+			}
 
+		} else {
+			if (use_sphere_up) {
+				axis_y_cache = candidates.sphere_ups;
 			} else {
-				axis_y = global_up;
+				std::fill(axis_y_cache.begin(), axis_y_cache.end(), global_up);
 			}
 		}
 
-		if (slope_filter) {
-			if (!surface_normal_is_normalized) {
-				surface_normal = math::normalized(surface_normal);
+		if (offset_along_normal != 0.f) {
+			for (size_t i = 0; i < instance_count; ++i) {
+				vertex_cache[i] += offset_along_normal * axis_y_cache[i];
 			}
+		}
+	}
 
-			float ny = surface_normal.y;
-			if (up_mode == UP_MODE_SPHERE) {
-				if (!sphere_up_is_computed) {
-					global_up = math::normalized(mesh_block_origin + t.origin, sphere_distance);
-					sphere_up_is_computed = true;
-					sphere_distance_is_computed = true;
-				}
-				ny = math::dot(surface_normal, global_up);
-			}
+	// Random attributes.
+	// Random numbers are drawn in the same order for each instance so results remain deterministic, which is why this
+	// stage is kept separate from the others. Note that they depend on the order of candidates after filtering, so
+	// changing how filters remove candidates changes which instance gets which rotation and scale.
+	{
+		ZN_PROFILE_SCOPE_NAMED("Random attributes");
 
-			if (ny < normal_min_y || ny > normal_max_y) {
-				// Discard
-				continue;
-			}
-		}
+		const Vector3f fixed_look_axis = up_mode == UP_MODE_POSITIVE_Y ? Vector3f(1, 0, 0) : Vector3f(0, 1, 0);
+		const Vector3f fixed_look_axis_alternative =
+				up_mode == UP_MODE_POSITIVE_Y ? Vector3f(0, 1, 0) : Vector3f(1, 0, 0);
 
-		if (height_filter) {
-			float y = mesh_block_origin.y + t.origin.y;
-			if (up_mode == UP_MODE_SPHERE) {
-				if (!sphere_distance_is_computed) {
-					sphere_distance = math::length(mesh_block_origin + t.origin);
-					sphere_distance_is_computed = true;
-				}
-				y = sphere_distance;
-			}
+		for (size_t i = 0; i < instance_count; ++i) {
+			Vector3f &axis_y = axis_y_cache[i];
 
-			if (y < min_height || y > max_height) {
-				continue;
+			// Allows to use two faces of a single rock to create variety in the same layer
+			if (random_vertical_flip && (pcg1.rand() & 1) == 1) {
+				axis_y = -axis_y;
+				// TODO Should have to flip another axis as well?
 			}
-		}
 
-		t.origin += offset_along_normal * axis_y;
+			// Pick a random rotation from the floor's normal.
+			// We may check for cases too close to Y to avoid broken basis due to float precision limits,
+			// even if that could differ from the expected result
+			Vector3f dir;
+			if (random_rotation) {
+				do {
+					// TODO Optimization: a pool of precomputed random directions would do the job too? Or would it
+					// waste the cache?
+					dir = math::normalized(Vector3f(pcg1.randf() - 0.5f, pcg1.randf() - 0.5f, pcg1.randf() - 0.5f));
+					// TODO Any way to check if the two vectors are close to aligned without normalizing `dir`?
+				} while (Math::abs(math::dot(dir, axis_y)) > 0.9999f);
 
-		// Allows to use two faces of a single rock to create variety in the same layer
-		if (random_vertical_flip && (pcg1.rand() & 1) == 1) {
-			axis_y = -axis_y;
-			// TODO Should have to flip another axis as well?
-		}
-
-		// Pick a random rotation from the floor's normal.
-		// We may check for cases too close to Y to avoid broken basis due to float precision limits,
-		// even if that could differ from the expected result
-		Vector3f dir;
-		if (_random_rotation) {
-			do {
-				// TODO Optimization: a pool of precomputed random directions would do the job too? Or would it waste
-				// the cache?
-				dir = math::normalized(Vector3f(pcg1.randf() - 0.5f, pcg1.randf() - 0.5f, pcg1.randf() - 0.5f));
-				// TODO Any way to check if the two vectors are close to aligned without normalizing `dir`?
-			} while (Math::abs(math::dot(dir, axis_y)) > 0.9999f);
+			} else {
+				// If the surface is aligned with this axis, it will create a "pole" where all instances are looking
+				// at. When getting too close to it, we may pick a different axis.
+				dir = fixed_look_axis;
+				if (Math::abs(math::dot(dir, axis_y)) > 0.9999f) {
+					dir = fixed_look_axis_alternative;
+				}
+			}
+			look_dir_cache[i] = dir;
 
-		} else {
-			// If the surface is aligned with this axis, it will create a "pole" where all instances are looking at.
-			// When getting too close to it, we may pick a different axis.
-			dir = fixed_look_axis;
-			if (Math::abs(math::dot(dir, axis_y)) > 0.9999f) {
-				dir = fixed_look_axis_alternative;
+			if (scale_range > 0.f) {
+				scale_cache[i] = pcg1.randf();
 			}
 		}
+	}
 
-		const Vector3f axis_x = math::normalized(math::cross(axis_y, dir));
-		const Vector3f axis_z = math::cross(axis_x, axis_y);
-
-		// In Godot 3, the Basis constructor expected 3 rows, but in Godot 4 it was changed to take 3 columns...
-		// t.basis = Basis3f(Vector3f(axis_x.x, axis_y.x, axis_z.x), Vector3f(axis_x.y, axis_y.y, axis_z.y),
-		// 		Vector3f(axis_x.z, axis_y.z, axis_z.z));
-		t.basis = Basis3f(axis_x, axis_y, axis_z);
+	// Calculate scales
+	{
+		ZN_PROFILE_SCOPE_NAMED("Scales");
 
 		if (scale_range > 0.f) {
-			float r = pcg1.randf();
-
-			switch (_scale_distribution) {
+			switch (scale_distribution) {
 				case DISTRIBUTION_QUADRATIC:
-					r = r * r;
+					for (float &r : scale_cache) {
+						r = r * r;
+					}
 					break;
 				case DISTRIBUTION_CUBIC:
-					r = r * r * r;
+					for (float &r : scale_cache) {
+						r = r * r * r;
+					}
 					break;
 				case DISTRIBUTION_QUINTIC:
-					r = r * r * r * r * r;
+					for (float &r : scale_cache) {
+						r = r * r * r * r * r;
+					}
 					break;
 				default:
 					break;
 			}
 
-			if (use_noise && _noise_on_scale > 0.f) {
+			if (use_noise && noise_on_scale > 0.f) {
 #ifdef DEBUG_ENABLED
-				CRASH_COND(vertex_index >= noise_cache.size());
+				CRASH_COND(noise_cache.size() != instance_count);
 #endif
-				// Multiplied noise because it gives more pronounced results
-				const float n = math::clamp(noise_cache[vertex_index] * 2.f, 0.f, 1.f);
-				r *= Math::lerp(1.f, n, _noise_on_scale);
+				for (size_t i = 0; i < instance_count; ++i) {
+					// Multiplied noise because it gives more pronounced results
+					const float n = math::clamp(noise_cache[i] * 2.f, 0.f, 1.f);
+					scale_cache[i] *= Math::lerp(1.f, n, noise_on_scale);
+				}
 			}
 
-			const float scale = scale_min + scale_range * r;
-
-			t.basis.scale(scale);
+			for (float &r : scale_cache) {
+				r = scale_min + scale_range * r;
+			}
 
-		} else if (scale_min != 1.f) {
-			t.basis.scale(scale_min);
+		} else {
+			std::fill(scale_cache.begin(), scale_cache.end(), scale_min);
 		}
+	}
 
-		out_transforms.push_back(t);
+	// Build transforms
+	{
+		ZN_PROFILE_SCOPE_NAMED("Transforms");
+
+		out_transforms.resize(instance_count);
+
+		for (size_t i = 0; i < instance_count; ++i) {
+			const Vector3f axis_y = axis_y_cache[i];
+			const Vector3f axis_x = math::normalized(math::cross(axis_y, look_dir_cache[i]));
+			const Vector3f axis_z = math::cross(axis_x, axis_y);
+
+			Transform3f &t = out_transforms[i];
+			// In Godot 3, the Basis constructor expected 3 rows, but in Godot 4 it was changed to take 3 columns...
+			// t.basis = Basis3f(Vector3f(axis_x.x, axis_y.x, axis_z.x), Vector3f(axis_x.y, axis_y.y, axis_z.y),
+			// 		Vector3f(axis_x.z, axis_y.z, axis_z.z));
+			t.basis = Basis3f(axis_x, axis_y, axis_z);
+			t.basis.scale(scale_cache[i]);
+			t.origin = vertex_cache[i];
+		}
 	}
 
 	// TODO Investigate if this helps (won't help with authored terrain)
@@ -83,6 +83,7 @@ void VoxelInstancer::clear_blocks() {
 	for (auto it = _layers.begin(); it != _layers.end(); ++it) {
 		Layer &layer = it->second;
 		layer.blocks.clear();
+		layer.pages.clear();
 	}
 	for (unsigned int lod_index = 0; lod_index < _lods.size(); ++lod_index) {
 		Lod &lod = _lods[lod_index];
@@ -191,6 +192,17 @@ void VoxelInstancer::_notification(int p_what) {
 				const Transform3D block_transform(parent_transform.basis, parent_transform.xform(block_local_pos));
 				block.multimesh_instance.set_transform(block_transform);
 			}
+
+			for (auto layer_it = _layers.begin(); layer_it != _layers.end(); ++layer_it) {
+				Layer &layer = layer_it->second;
+				const int page_size_po2 = base_block_size_po2 + layer.lod_index + MULTIMESH_PAGE_SIZE_PO2;
+				for (auto page_it = layer.pages.begin(); page_it != layer.pages.end(); ++page_it) {
+					MultiMeshPage &page = *page_it->second;
+					const Vector3 page_local_pos(page.grid_position << page_size_po2);
+					const Transform3D page_transform(parent_transform.basis, parent_transform.xform(page_local_pos));
+					page.multimesh_instance.set_transform(page_transform);
+				}
+			}
 		} break;
 
 		case NOTIFICATION_VISIBILITY_CHANGED:
@@ -210,6 +222,7 @@ void VoxelInstancer::_notification(int p_what) {
 
 void VoxelInstancer::process() {
 	process_task_results();
+	upload_multimesh_pages();
 	if (_parent != nullptr) {
 		if (_library.is_valid() && _mesh_lod_distances[0] > 0.f) {
 			process_mesh_lods();
@@ -300,6 +313,45 @@ void VoxelInstancer::process_task_results() {
 		const Transform3D block_local_transform = Transform3D(Basis(), output.render_block_position * mesh_block_size);
 		const Transform3D block_global_transform = parent_transform * block_local_transform;
 
+		if (output.loaded_instances.size() > 0) {
+			const VoxelInstanceLibraryMultiMeshItem *multimesh_item =
+					Object::cast_to<VoxelInstanceLibraryMultiMeshItem>(item);
+
+			if (output.transforms.size() == 0 && multimesh_item != nullptr &&
+				multimesh_item->get_multimesh_settings().collision_shapes.size() == 0) {
+				// Only rendering is needed, so saved instances can be decoded straight into the multimesh buffer
+				ZN_PROFILE_SCOPE_NAMED("Decode loaded instances to multimesh");
+				const unsigned int instance_count = get_instance_count(to_span_const(output.loaded_instances));
+
+				PackedFloat32Array bulk_array;
+				bulk_array.resize(instance_count * 12);
+				Span<float> bulk_array_s(bulk_array.ptrw(), bulk_array.size());
+
+				unsigned int dst_index = 0;
+				for (const InstanceLoadingTaskOutput::LoadedInstances &li : output.loaded_instances) {
+					const unsigned int count = li.data.get_instance_count();
+					Span<float> dst = bulk_array_s.sub(dst_index * 12, count * 12);
+					decode_instances_to_multimesh_buffer(li.data, li.quantized_position_range, li.offset, dst);
+					dst_index += count;
+				}
+
+				update_block_from_multimesh_buffer(
+						block_it->second,
+						bulk_array,
+						instance_count,
+						output.render_block_position,
+						layer,
+						*multimesh_item,
+						output.layer_id,
+						world,
+						block_global_transform
+				);
+				continue;
+			}
+
+			decode_loaded_instances(to_span_const(output.loaded_instances), output.transforms);
+		}
+
 		update_block_from_transforms( //
 				block_it->second, //
 				to_span_const(output.transforms), //
@@ -361,7 +413,7 @@ void VoxelInstancer::process_gizmos() {
 					// Allocated but empty multimesh
 					color = Color8(255, 64, 0, 255);
 				}
-			} else if (block.scene_instances.size() == 0) {
+			} else if (block.page == nullptr && block.scene_instances.size() == 0) {
 				// Only draw blocks that are setup
 				continue;
 			}
@@ -621,6 +673,14 @@ void VoxelInstancer::update_visibility() {
 			block.multimesh_instance.set_visible(instancer_is_visible && visible_with_lod);
 		}
 	}
+
+	for (auto layer_it = _layers.begin(); layer_it != _layers.end(); ++layer_it) {
+		Layer &layer = layer_it->second;
+		for (auto page_it = layer.pages.begin(); page_it != layer.pages.end(); ++page_it) {
+			MultiMeshPage &page = *page_it->second;
+			page.multimesh_instance.set_visible(instancer_is_visible);
+		}
+	}
 }
 
 void VoxelInstancer::set_world(World3D *world) {
@@ -630,6 +690,13 @@ void VoxelInstancer::set_world(World3D *world) {
 			block.multimesh_instance.set_world(world);
 		}
 	}
+	for (auto layer_it = _layers.begin(); layer_it != _layers.end(); ++layer_it) {
+		Layer &layer = layer_it->second;
+		for (auto page_it = layer.pages.begin(); page_it != layer.pages.end(); ++page_it) {
+			MultiMeshPage &page = *page_it->second;
+			page.multimesh_instance.set_world(world);
+		}
+	}
 }
 
 void VoxelInstancer::set_up_mode(UpMode mode) {
@@ -678,6 +745,23 @@ Ref<VoxelInstanceLibrary> VoxelInstancer::get_library() const {
 	return _library;
 }
 
+void VoxelInstancer::set_multimesh_pages_enabled(bool enabled) {
+	if (_multimesh_pages_enabled == enabled) {
+		return;
+	}
+	_multimesh_pages_enabled = enabled;
+	// Blocks move in or out of pages when they get updated
+	if (_parent != nullptr && is_inside_tree()) {
+		for (auto it = _layers.begin(); it != _layers.end(); ++it) {
+			regenerate_layer(it->first, false);
+		}
+	}
+}
+
+bool VoxelInstancer::get_multimesh_pages_enabled() const {
+	return _multimesh_pages_enabled;
+}
+
 void VoxelInstancer::regenerate_layer(uint16_t layer_id, bool regenerate_blocks) {
 	ZN_PROFILE_SCOPE();
 	ERR_FAIL_COND(_parent == nullptr);
@@ -741,16 +825,11 @@ void VoxelInstancer::regenerate_layer(uint16_t layer_id, bool regenerate_blocks)
 				uint8_t octant_mask,
 				int render_block_size
 		) {
-			if (!render_block.multimesh_instance.is_valid()) {
-				return;
-			}
-			Ref<MultiMesh> multimesh = render_block.multimesh_instance.get_multimesh();
-			ERR_FAIL_COND(multimesh.is_null());
-			const int instance_count = zylann::godot::get_visible_instance_count(**multimesh);
+			const unsigned int instance_count = get_block_multimesh_instance_count(render_block);
 			const float h = render_block_size / 2;
-			for (int i = 0; i < instance_count; ++i) {
+			for (unsigned int i = 0; i < instance_count; ++i) {
 				// TODO This is terrible in MT mode! Think about keeping a local copy...
-				const Transform3D t = multimesh->get_instance_transform(i);
+				const Transform3D t = get_block_multimesh_instance_transform(render_block, i);
 				const uint8_t octant_index = VoxelInstanceGenerator::get_octant_index(to_vec3f(t.origin), h);
 				if ((octant_mask & (1 << octant_index)) != 0) {
 					dst.push_back(to_transform3f(t));
@@ -869,6 +948,21 @@ void VoxelInstancer::update_layer_meshes(int layer_id) {
 		block.current_mesh_lod = math::min(static_cast<unsigned int>(block.current_mesh_lod), extended_mesh_lod_count);
 		update_mesh_from_mesh_lod(block, settings, hide_beyond_max_lod, instancer_is_visible);
 	}
+
+	Layer &layer = get_layer(layer_id);
+	for (auto it = layer.pages.begin(); it != layer.pages.end(); ++it) {
+		MultiMeshPage &page = *it->second;
+		page.multimesh_instance.set_render_layer(settings.render_layer);
+		page.multimesh_instance.set_material_override(settings.material_override);
+		page.multimesh_instance.set_cast_shadows_setting(settings.shadow_casting_setting);
+		page.multimesh_instance.set_gi_mode(settings.gi_mode);
+
+		// TODO If the item now has mesh LODs or collisions, blocks remain in pages until they get regenerated
+		Ref<MultiMesh> multimesh = page.multimesh_instance.get_multimesh();
+		if (multimesh.is_valid() && settings.mesh_lod_count > 0) {
+			multimesh->set_mesh(settings.mesh_lods[0]);
+		}
+	}
 }
 
 void VoxelInstancer::update_layer_scenes(int layer_id) {
@@ -976,7 +1070,7 @@ void VoxelInstancer::add_layer(int layer_id, int lod_index) {
 
 	Layer layer;
 	layer.lod_index = lod_index;
-	_layers.insert({ layer_id, layer });
+	_layers.insert({ layer_id, std::move(layer) });
 
 	lod.layers.push_back(layer_id);
 }
@@ -1014,6 +1108,7 @@ void VoxelInstancer::remove_block(unsigned int block_index) {
 		Layer &layer = get_layer(block->layer_id);
 		layer.blocks.erase(block->grid_position);
 	}
+	release_block_multimesh_page(*block);
 	_blocks[block_index] = std::move(_blocks.back());
 	_blocks.pop_back();
 
@@ -1203,6 +1298,340 @@ unsigned int VoxelInstancer::create_block(
 	return block_index;
 }
 
+void VoxelInstancer::update_block_multimesh(
+		Block &block,
+		const PackedFloat32Array &bulk_array,
+		unsigned int instance_count,
+		const VoxelInstanceLibraryMultiMeshItem &item,
+		World3D &world,
+		const Transform3D &block_global_transform
+) {
+	ZN_PROFILE_SCOPE();
+	const VoxelInstanceLibraryMultiMeshItem::Settings &settings = item.get_multimesh_settings();
+
+	if (_multimesh_pages_enabled && can_use_multimesh_pages(item)) {
+		if (block.multimesh_instance.is_valid()) {
+			block.multimesh_instance.set_multimesh(Ref<MultiMesh>());
+			block.multimesh_instance.destroy();
+		}
+		update_block_multimesh_page(block, bulk_array, instance_count, item, world, block_global_transform);
+		return;
+	}
+
+	release_block_multimesh_page(block);
+
+	if (instance_count == 0) {
+		if (block.multimesh_instance.is_valid()) {
+			block.multimesh_instance.set_multimesh(Ref<MultiMesh>());
+			block.multimesh_instance.destroy();
+		}
+
+	} else {
+		Ref<MultiMesh> multimesh = block.multimesh_instance.get_multimesh();
+		if (multimesh.is_null()) {
+			multimesh.instantiate();
+			multimesh->set_transform_format(MultiMesh::TRANSFORM_3D);
+			multimesh->set_use_colors(false);
+			multimesh->set_use_custom_data(false);
+		} else {
+			multimesh->set_visible_instance_count(-1);
+		}
+		multimesh->set_instance_count(instance_count);
+
+		// Setting the mesh BEFORE `multimesh_set_buffer` because otherwise Godot computes the AABB inside
+		// `multimesh_set_buffer` BY DOWNLOADING BACK THE BUFFER FROM THE GRAPHICS CARD which can incur a very harsh
+		// performance penalty
+		// TODO If we could use custom AABBs, we would not need this reordering
+		if (settings.mesh_lod_count > 0) {
+			if (block.current_mesh_lod < settings.mesh_lod_count) {
+				multimesh->set_mesh(settings.mesh_lods[block.current_mesh_lod]);
+			}
+		}
+
+		// TODO Waiting for Godot to expose the method on the resource object
+		// multimesh->set_as_bulk_array(bulk_array);
+		RenderingServer::get_singleton()->multimesh_set_buffer(multimesh->get_rid(), bulk_array);
+
+		if (!block.multimesh_instance.is_valid()) {
+			block.multimesh_instance.create();
+			block.multimesh_instance.set_visible(
+					is_visible() &&
+					!(item.get_hide_beyond_max_lod() && block.current_mesh_lod == settings.mesh_lod_count)
+			);
+		}
+		block.multimesh_instance.set_multimesh(multimesh);
+		block.multimesh_instance.set_render_layer(settings.render_layer);
+		block.multimesh_instance.set_world(&world);
+		block.multimesh_instance.set_transform(block_global_transform);
+		block.multimesh_instance.set_material_override(settings.material_override);
+		block.multimesh_instance.set_cast_shadows_setting(settings.shadow_casting_setting);
+		block.multimesh_instance.set_gi_mode(settings.gi_mode);
+
+		if (settings.mesh_lod_count > 1 || (settings.mesh_lod_count == 1 && item.get_hide_beyond_max_lod())) {
+			// Hide for now, let the LOD system show/hide and assign the right mesh when it runs. We do this because
+			// the LOD system doesn't necessarily update every blocks every frame, which would flicker at their full
+			// LOD when spawning
+			block.current_mesh_lod = settings.mesh_lod_count;
+			block.multimesh_instance.set_visible(false);
+		}
+	}
+}
+
+bool VoxelInstancer::can_use_multimesh_pages(const VoxelInstanceLibraryMultiMeshItem &item) {
+	const VoxelInstanceLibraryMultiMeshItem::Settings &settings = item.get_multimesh_settings();
+	// All blocks of a page must use the same mesh, and bodies refer to instances by index in their block
+	return settings.collision_shapes.size() == 0 && settings.mesh_lod_count <= 1 && !item.get_hide_beyond_max_lod();
+}
+
+namespace {
+
+const unsigned int MULTIMESH_TRANSFORM_3D_FLOATS = 12;
+// Blocks allocate slots in pages by multiples of this, so they can get a few more instances without moving
+const unsigned int MULTIMESH_PAGE_SLOT_GRANULARITY = 16;
+
+inline void clear_multimesh_page_slots(PackedFloat32Array &buffer, uint32_t begin, uint32_t end) {
+	float *ptr = buffer.ptrw();
+	for (uint32_t i = begin * MULTIMESH_TRANSFORM_3D_FLOATS; i < end * MULTIMESH_TRANSFORM_3D_FLOATS; ++i) {
+		ptr[i] = 0.f;
+	}
+}
+
+} // namespace
+
+void VoxelInstancer::update_block_multimesh_page(
+		Block &block,
+		const PackedFloat32Array &bulk_array,
+		unsigned int instance_count,
+		const VoxelInstanceLibraryMultiMeshItem &item,
+		World3D &world,
+		const Transform3D &block_global_transform
+) {
+	ZN_PROFILE_SCOPE();
+
+	if (instance_count == 0) {
+		release_block_multimesh_page(block);
+		return;
+	}
+
+	ZN_ASSERT_RETURN(bulk_array.size() >= static_cast<int64_t>(instance_count * MULTIMESH_TRANSFORM_3D_FLOATS));
+
+	if (block.page == nullptr) {
+		Layer &layer = get_layer(block.layer_id);
+		const Vector3i page_position = block.grid_position >> MULTIMESH_PAGE_SIZE_PO2;
+
+		UniquePtr<MultiMeshPage> &page_ptr = layer.pages[page_position];
+		if (page_ptr == nullptr) {
+			page_ptr = make_unique_instance<MultiMeshPage>();
+			page_ptr->grid_position = page_position;
+		}
+
+		const int lod_block_size = (1 << _parent_mesh_block_size_po2) << block.lod_index;
+		const Vector3i block_position_in_page = block.grid_position - (page_position << MULTIMESH_PAGE_SIZE_PO2);
+
+		block.page = page_ptr.get();
+		block.page_offset = 0;
+		block.page_capacity = 0;
+		block.page_instance_count = 0;
+		block.page_origin_offset = to_vec3f(block_position_in_page * lod_block_size);
+		++block.page->block_count;
+	}
+
+	MultiMeshPage &page = *block.page;
+
+	// Move to another range if the block doesn't fit in its current one
+	if (instance_count > block.page_capacity) {
+		if (block.page_capacity > 0) {
+			clear_multimesh_page_slots(page.buffer, block.page_offset, block.page_offset + block.page_instance_count);
+			page.allocator.free(block.page_offset, block.page_capacity);
+			block.page_instance_count = 0;
+		}
+
+		const uint32_t capacity = math::alignup(instance_count, MULTIMESH_PAGE_SLOT_GRANULARITY);
+		uint32_t offset = page.allocator.allocate(capacity);
+
+		if (offset == RangeAllocator::INVALID_OFFSET) {
+			// Grow the page. This is the only case where the multimesh gets reallocated.
+			const uint32_t prev_page_capacity = page.allocator.get_capacity();
+			page.allocator.grow(math::max(prev_page_capacity * 2, prev_page_capacity + capacity));
+			page.buffer.resize(page.allocator.get_capacity() * MULTIMESH_TRANSFORM_3D_FLOATS);
+			clear_multimesh_page_slots(page.buffer, prev_page_capacity, page.allocator.get_capacity());
+
+			offset = page.allocator.allocate(capacity);
+			ZN_ASSERT_RETURN(offset != RangeAllocator::INVALID_OFFSET);
+		}
+
+		block.page_offset = offset;
+		block.page_capacity = capacity;
+	}
+
+	// Write instances in the range of the block, relative to the page
+	{
+		const float *src = bulk_array.ptr();
+		float *dst = page.buffer.ptrw() + block.page_offset * MULTIMESH_TRANSFORM_3D_FLOATS;
+		const Vector3f offset = block.page_origin_offset;
+
+		for (unsigned int i = 0; i < instance_count * MULTIMESH_TRANSFORM_3D_FLOATS; ++i) {
+			dst[i] = src[i];
+		}
+		for (unsigned int i = 0; i < instance_count; ++i) {
+			float *t = dst + i * MULTIMESH_TRANSFORM_3D_FLOATS;
+			t[3] += offset.x;
+			t[7] += offset.y;
+			t[11] += offset.z;
+		}
+	}
+
+	if (instance_count < block.page_instance_count) {
+		// Hide slots the block no longer uses
+		clear_multimesh_page_slots(
+				page.buffer, block.page_offset + instance_count, block.page_offset + block.page_instance_count
+		);
+	}
+
+	block.page_instance_count = instance_count;
+	page.dirty = true;
+
+	if (!page.multimesh_instance.is_valid()) {
+		const VoxelInstanceLibraryMultiMeshItem::Settings &settings = item.get_multimesh_settings();
+
+		Ref<MultiMesh> multimesh;
+		multimesh.instantiate();
+		multimesh->set_transform_format(MultiMesh::TRANSFORM_3D);
+		multimesh->set_use_colors(false);
+		multimesh->set_use_custom_data(false);
+		if (settings.mesh_lod_count > 0) {
+			multimesh->set_mesh(settings.mesh_lods[0]);
+		}
+
+		// The page has the same orientation as blocks
+		const Transform3D page_global_transform(
+				block_global_transform.basis, block_global_transform.xform(-to_vec3(block.page_origin_offset))
+		);
+
+		page.multimesh_instance.create();
+		page.multimesh_instance.set_visible(is_visible_in_tree());
+		page.multimesh_instance.set_multimesh(multimesh);
+		page.multimesh_instance.set_render_layer(settings.render_layer);
+		page.multimesh_instance.set_world(&world);
+		page.multimesh_instance.set_transform(page_global_transform);
+		page.multimesh_instance.set_material_override(settings.material_override);
+		page.multimesh_instance.set_cast_shadows_setting(settings.shadow_casting_setting);
+		page.multimesh_instance.set_gi_mode(settings.gi_mode);
+	}
+}
+
+void VoxelInstancer::release_block_multimesh_page(Block &block) {
+	if (block.page == nullptr) {
+		return;
+	}
+
+	MultiMeshPage &page = *block.page;
+
+	if (block.page_capacity > 0) {
+		clear_multimesh_page_slots(page.buffer, block.page_offset, block.page_offset + block.page_instance_count);
+		page.allocator.free(block.page_offset, block.page_capacity);
+		page.dirty = true;
+	}
+
+	block.page = nullptr;
+	block.page_offset = 0;
+	block.page_capacity = 0;
+	block.page_instance_count = 0;
+
+	ZN_ASSERT(page.block_count > 0);
+	--page.block_count;
+
+	if (page.block_count == 0) {
+		Layer &layer = get_layer(block.layer_id);
+		// Destroys the page
+		layer.pages.erase(page.grid_position);
+	}
+}
+
+void VoxelInstancer::upload_multimesh_pages() {
+	ZN_PROFILE_SCOPE();
+
+	// Uploading once per frame, because many blocks of the same page can change in the same frame
+	for (auto layer_it = _layers.begin(); layer_it != _layers.end(); ++layer_it) {
+		Layer &layer = layer_it->second;
+
+		for (auto page_it = layer.pages.begin(); page_it != layer.pages.end(); ++page_it) {
+			MultiMeshPage &page = *page_it->second;
+			if (!page.dirty) {
+				continue;
+			}
+			page.dirty = false;
+
+			Ref<MultiMesh> multimesh = page.multimesh_instance.get_multimesh();
+			ZN_ASSERT_CONTINUE(multimesh.is_valid());
+
+			const int capacity = page.allocator.get_capacity();
+			if (multimesh->get_instance_count() != capacity) {
+				multimesh->set_instance_count(capacity);
+			}
+
+			// TODO Waiting for Godot to expose the method on the resource object
+			RenderingServer::get_singleton()->multimesh_set_buffer(multimesh->get_rid(), page.buffer);
+
+			// Slots after the last used range are not drawn
+			multimesh->set_visible_instance_count(page.allocator.get_used_end());
+		}
+	}
+}
+
+unsigned int VoxelInstancer::get_block_multimesh_instance_count(const Block &block) {
+	if (block.page != nullptr) {
+		return block.page_instance_count;
+	}
+	if (block.multimesh_instance.is_valid()) {
+		Ref<MultiMesh> multimesh = block.multimesh_instance.get_multimesh();
+		ZN_ASSERT_RETURN_V(multimesh.is_valid(), 0);
+		return zylann::godot::get_visible_instance_count(**multimesh);
+	}
+	return 0;
+}
+
+Transform3D VoxelInstancer::get_block_multimesh_instance_transform(const Block &block, unsigned int instance_index) {
+	if (block.page != nullptr) {
+		ZN_ASSERT(instance_index < block.page_instance_count);
+		const float *src =
+				block.page->buffer.ptr() + (block.page_offset + instance_index) * MULTIMESH_TRANSFORM_3D_FLOATS;
+		const Vector3f offset = block.page_origin_offset;
+		return Transform3D(
+				Basis(src[0], src[1], src[2], src[4], src[5], src[6], src[8], src[9], src[10]),
+				Vector3(src[3] - offset.x, src[7] - offset.y, src[11] - offset.z)
+		);
+	}
+	// TODO This is terrible in MT mode! Think about keeping a local copy...
+	return block.multimesh_instance.get_multimesh()->get_instance_transform(instance_index);
+}
+
+void VoxelInstancer::update_block_from_multimesh_buffer(
+		int block_index,
+		const PackedFloat32Array &bulk_array,
+		unsigned int instance_count,
+		Vector3i grid_position,
+		Layer &layer,
+		const VoxelInstanceLibraryMultiMeshItem &item,
+		uint16_t layer_id,
+		World3D &world,
+		const Transform3D &block_global_transform
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(item.get_multimesh_settings().collision_shapes.size() == 0);
+
+	if (block_index == -1) {
+		block_index = create_block(layer, layer_id, grid_position, false);
+	}
+#ifdef DEBUG_ENABLED
+	ERR_FAIL_COND(block_index < 0 || block_index >= static_cast<int>(_blocks.size()));
+	ERR_FAIL_COND(_blocks[block_index] == nullptr);
+#endif
+	Block &block = *_blocks[block_index];
+
+	update_block_multimesh(block, bulk_array, instance_count, item, world, block_global_transform);
+}
+
 void VoxelInstancer::update_block_from_transforms( //
 		int block_index, //
 		Span<const Transform3f> transforms, //
@@ -1233,63 +1662,11 @@ void VoxelInstancer::update_block_from_transforms( //
 	if (item != nullptr) {
 		const VoxelInstanceLibraryMultiMeshItem::Settings &settings = item->get_multimesh_settings();
 
-		if (transforms.size() == 0) {
-			if (block.multimesh_instance.is_valid()) {
-				block.multimesh_instance.set_multimesh(Ref<MultiMesh>());
-				block.multimesh_instance.destroy();
-			}
-
-		} else {
-			Ref<MultiMesh> multimesh = block.multimesh_instance.get_multimesh();
-			if (multimesh.is_null()) {
-				multimesh.instantiate();
-				multimesh->set_transform_format(MultiMesh::TRANSFORM_3D);
-				multimesh->set_use_colors(false);
-				multimesh->set_use_custom_data(false);
-			} else {
-				multimesh->set_visible_instance_count(-1);
-			}
-			PackedFloat32Array bulk_array;
+		PackedFloat32Array bulk_array;
+		if (transforms.size() > 0) {
 			zylann::godot::DirectMultiMeshInstance::make_transform_3d_bulk_array(transforms, bulk_array);
-			multimesh->set_instance_count(transforms.size());
-
-			// Setting the mesh BEFORE `multimesh_set_buffer` because otherwise Godot computes the AABB inside
-			// `multimesh_set_buffer` BY DOWNLOADING BACK THE BUFFER FROM THE GRAPHICS CARD which can incur a very harsh
-			// performance penalty
-			// TODO If we could use custom AABBs, we would not need this reordering
-			if (settings.mesh_lod_count > 0) {
-				if (block.current_mesh_lod < settings.mesh_lod_count) {
-					multimesh->set_mesh(settings.mesh_lods[block.current_mesh_lod]);
-				}
-			}
-
-			// TODO Waiting for Godot to expose the method on the resource object
-			// multimesh->set_as_bulk_array(bulk_array);
-			RenderingServer::get_singleton()->multimesh_set_buffer(multimesh->get_rid(), bulk_array);
-
-			if (!block.multimesh_instance.is_valid()) {
-				block.multimesh_instance.create();
-				block.multimesh_instance.set_visible(
-						is_visible() &&
-						!(item->get_hide_beyond_max_lod() && block.current_mesh_lod == settings.mesh_lod_count)
-				);
-			}
-			block.multimesh_instance.set_multimesh(multimesh);
-			block.multimesh_instance.set_render_layer(settings.render_layer);
-			block.multimesh_instance.set_world(&world);
-			block.multimesh_instance.set_transform(block_global_transform);
-			block.multimesh_instance.set_material_override(settings.material_override);
-			block.multimesh_instance.set_cast_shadows_setting(settings.shadow_casting_setting);
-			block.multimesh_instance.set_gi_mode(settings.gi_mode);
-
-			if (settings.mesh_lod_count > 1 || (settings.mesh_lod_count == 1 && item->get_hide_beyond_max_lod())) {
-				// Hide for now, let the LOD system show/hide and assign the right mesh when it runs. We do this because
-				// the LOD system doesn't necessarily update every blocks every frame, which would flicker at their full
-				// LOD when spawning
-				block.current_mesh_lod = settings.mesh_lod_count;
-				block.multimesh_instance.set_visible(false);
-			}
 		}
+		update_block_multimesh(block, bulk_array, transforms.size(), *item, world, block_global_transform);
 
 		// Update bodies
 		Span<const CollisionShapeInfo> collision_shapes = to_span(settings.collision_shapes);
@@ -1476,6 +1853,12 @@ SaveBlockDataTask *VoxelInstancer::save_block(
 	const int octant_index =
 			VoxelInstanceGenerator::get_octant_index(data_grid_pos.x & 1, data_grid_pos.y & 1, data_grid_pos.z & 1);
 
+	// Data blocks can be on a smaller grid than render blocks, in which case instances have to be made relative to the
+	// data block
+	const Vector3f data_block_origin_in_render_block =
+			to_vec3f(data_block_size * (data_grid_pos - render_block_pos * render_to_data_factor));
+	const float position_range = block_data->get_quantized_position_range();
+
 	for (auto it = lod.layers.begin(); it != lod.layers.end(); ++it) {
 		const int layer_id = *it;
 
@@ -1503,7 +1886,7 @@ SaveBlockDataTask *VoxelInstancer::save_block(
 		block_data->layers.push_back(InstanceBlockData::LayerData());
 		InstanceBlockData::LayerData &layer_data = block_data->layers.back();
 
-		layer_data.instances.clear();
+		layer_data.clear_instances();
 		layer_data.id = layer_id;
 
 		if (item->get_generator().is_valid()) {
@@ -1515,39 +1898,39 @@ SaveBlockDataTask *VoxelInstancer::save_block(
 			layer_data.scale_max = 10.f;
 		}
 
-		if (render_block.multimesh_instance.is_valid()) {
+		if (render_block.multimesh_instance.is_valid() || render_block.page != nullptr) {
 			// Multimeshes
 
-			Ref<MultiMesh> multimesh = render_block.multimesh_instance.get_multimesh();
-			CRASH_COND(multimesh.is_null());
-
 			ZN_PROFILE_SCOPE();
 
-			const int instance_count = zylann::godot::get_visible_instance_count(**multimesh);
+			const unsigned int instance_count = get_block_multimesh_instance_count(render_block);
 
 			if (render_to_data_factor == 1) {
-				layer_data.instances.resize(instance_count);
+				layer_data.reserve_instances(instance_count);
 
 				// TODO Optimization: it would be nice to get the whole array at once
-				for (int instance_index = 0; instance_index < instance_count; ++instance_index) {
+				for (unsigned int instance_index = 0; instance_index < instance_count; ++instance_index) {
 					// TODO This is terrible in MT mode! Think about keeping a local copy...
 					// TODO This is also terrible because it downloads the data from GPU (although Godot makes a cache
 					// by itself)
-					layer_data.instances[instance_index].transform =
-							to_transform3f(multimesh->get_instance_transform(instance_index));
+					layer_data.add_instance(
+							to_transform3f(get_block_multimesh_instance_transform(render_block, instance_index)),
+							position_range
+					);
 				}
 
 			} else if (render_to_data_factor == 2) {
-				for (int instance_index = 0; instance_index < instance_count; ++instance_index) {
+				for (unsigned int instance_index = 0; instance_index < instance_count; ++instance_index) {
 					// TODO Optimize: This is terrible in MT mode! Think about keeping a local copy...
-					const Transform3D rendered_instance_transform = multimesh->get_instance_transform(instance_index);
+					const Transform3D rendered_instance_transform =
+							get_block_multimesh_instance_transform(render_block, instance_index);
 					const int instance_octant_index = VoxelInstanceGenerator::get_octant_index(
 							to_vec3f(rendered_instance_transform.origin), half_render_block_size
 					);
 					if (instance_octant_index == octant_index) {
-						InstanceBlockData::InstanceData d;
-						d.transform = to_transform3f(rendered_instance_transform);
-						layer_data.instances.push_back(d);
+						Transform3f t = to_transform3f(rendered_instance_transform);
+						t.origin -= data_block_origin_in_render_block;
+						layer_data.add_instance(t, position_range);
 					}
 				}
 			}
@@ -1561,13 +1944,15 @@ SaveBlockDataTask *VoxelInstancer::save_block(
 			const Vector3 render_block_origin = render_block_pos * render_block_size;
 
 			if (render_to_data_factor == 1) {
-				layer_data.instances.resize(instance_count);
+				layer_data.reserve_instances(instance_count);
 
 				for (unsigned int instance_index = 0; instance_index < instance_count; ++instance_index) {
 					const SceneInstance instance = render_block.scene_instances[instance_index];
 					ERR_CONTINUE(instance.root == nullptr);
-					layer_data.instances[instance_index].transform =
-							to_transform3f(instance.root->get_transform().translated(-render_block_origin));
+					layer_data.add_instance(
+							to_transform3f(instance.root->get_transform().translated(-render_block_origin)),
+							position_range
+					);
 				}
 
 			} else if (render_to_data_factor == 2) {
@@ -1579,27 +1964,14 @@ SaveBlockDataTask *VoxelInstancer::save_block(
 					const int instance_octant_index =
 							VoxelInstanceGenerator::get_octant_index(to_vec3f(t.origin), half_render_block_size);
 					if (instance_octant_index == octant_index) {
-						InstanceBlockData::InstanceData d;
-						d.transform = to_transform3f(t);
-						layer_data.instances.push_back(d);
+						Transform3f tf = to_transform3f(t);
+						tf.origin -= data_block_origin_in_render_block;
+						layer_data.add_instance(tf, position_range);
 					}
 					// TODO Serialize state?
 				}
 			}
 
-			// Make scene transforms relative to render block
-			// for (InstanceBlockData::InstanceData &d : layer_data.instances) {
-			// 	d.transform.origin -= render_block_origin;
-			// }
-		}
-
-		if (render_to_data_factor == 2) {
-			// Data blocks are on a smaller grid than render blocks so we may convert the relative position
-			// of the instances
-			const Vector3f rel = to_vec3f(data_block_size * (data_grid_pos - render_block_pos * render_to_data_factor));
-			for (InstanceBlockData::InstanceData &d : layer_data.instances) {
-				d.transform.origin -= rel;
-			}
 		}
 	}
 
@@ -1637,6 +2009,11 @@ void VoxelInstancer::remove_floating_multimesh_instances(
 		const VoxelTool &voxel_tool,
 		int block_size_po2
 ) {
+	if (block.page != nullptr) {
+		remove_floating_multimesh_page_instances(block, parent_transform, p_voxel_box, voxel_tool, block_size_po2);
+		return;
+	}
+
 	if (!block.multimesh_instance.is_valid()) {
 		// Empty block
 		return;
@@ -1729,6 +2106,60 @@ void VoxelInstancer::remove_floating_multimesh_instances(
 	}
 }
 
+void VoxelInstancer::remove_floating_multimesh_page_instances(
+		Block &block,
+		const Transform3D &parent_transform,
+		Box3i p_voxel_box,
+		const VoxelTool &voxel_tool,
+		int block_size_po2
+) {
+	ZN_ASSERT_RETURN(block.page != nullptr);
+	MultiMeshPage &page = *block.page;
+	// Items using pages don't have bodies
+	ZN_ASSERT_RETURN(block.bodies.size() == 0);
+
+	const unsigned int initial_instance_count = block.page_instance_count;
+	unsigned int instance_count = initial_instance_count;
+
+	const Transform3D block_global_transform =
+			Transform3D(parent_transform.basis, parent_transform.xform(block.grid_position << block_size_po2));
+
+	float *instances = page.buffer.ptrw() + block.page_offset * MULTIMESH_TRANSFORM_3D_FLOATS;
+
+	for (unsigned int instance_index = 0; instance_index < instance_count; ++instance_index) {
+		const Transform3D mm_transform = get_block_multimesh_instance_transform(block, instance_index);
+		const Vector3i voxel_pos(math::floor_to_int(mm_transform.origin + block_global_transform.origin));
+
+		if (!p_voxel_box.contains(voxel_pos)) {
+			continue;
+		}
+
+		// 1-voxel cheap check without interpolation
+		const float sdf = voxel_tool.get_voxel_f(voxel_pos);
+		if (sdf < -0.0001f) {
+			// Still enough ground
+			continue;
+		}
+
+		// Remove the instance by moving the last one in its slot. This only writes our copy of the page, which gets
+		// uploaded later.
+		const unsigned int last_instance_index = --instance_count;
+		float *dst = instances + instance_index * MULTIMESH_TRANSFORM_3D_FLOATS;
+		float *last = instances + last_instance_index * MULTIMESH_TRANSFORM_3D_FLOATS;
+		for (unsigned int i = 0; i < MULTIMESH_TRANSFORM_3D_FLOATS; ++i) {
+			dst[i] = last[i];
+			last[i] = 0.f;
+		}
+		block.page_instance_count = instance_count;
+
+		--instance_index;
+	}
+
+	if (instance_count < initial_instance_count) {
+		page.dirty = true;
+	}
+}
+
 void VoxelInstancer::remove_floating_scene_instances(
 		Block &block,
 		const Transform3D &parent_transform,
@@ -1973,13 +2404,7 @@ void VoxelInstancer::debug_get_instance_counts(StdUnorderedMap<uint32_t, uint32_
 		const Block &block = **it;
 
 		uint32_t count = block.scene_instances.size();
-
-		if (block.multimesh_instance.is_valid()) {
-			Ref<MultiMesh> multimesh = block.multimesh_instance.get_multimesh();
-			ZN_ASSERT_CONTINUE(multimesh.is_valid());
-
-			count += zylann::godot::get_visible_instance_count(**multimesh);
-		}
+		count += get_block_multimesh_instance_count(block);
 
 		counts_per_layer[block.layer_id] += count;
 	}
@@ -2064,6 +2489,35 @@ Node *VoxelInstancer::debug_dump_as_nodes() const {
 
 			// TODO Dump scene instances too
 		}
+
+		// For each multimesh page in layer
+		for (auto page_it = layer.pages.begin(); page_it != layer.pages.end(); ++page_it) {
+			const MultiMeshPage &page = *page_it->second;
+			const int page_size = lod_block_size << MULTIMESH_PAGE_SIZE_PO2;
+			const Transform3D page_local_transform(Basis(), Vector3(page.grid_position * page_size));
+
+			Ref<MultiMesh> multimesh = page.multimesh_instance.get_multimesh();
+			ERR_CONTINUE(multimesh.is_null());
+			Ref<Mesh> src_mesh = multimesh->get_mesh();
+			ERR_CONTINUE(src_mesh.is_null());
+
+			auto mesh_copy_it = mesh_copies.find(src_mesh);
+			Ref<Mesh> mesh_copy;
+			if (mesh_copy_it == mesh_copies.end()) {
+				mesh_copy = src_mesh->duplicate();
+				mesh_copies.insert({ src_mesh, mesh_copy });
+			} else {
+				mesh_copy = mesh_copy_it->second;
+			}
+
+			Ref<MultiMesh> multimesh_copy = multimesh->duplicate();
+			multimesh_copy->set_mesh(mesh_copy);
+
+			MultiMeshInstance3D *mmi = memnew(MultiMeshInstance3D);
+			mmi->set_multimesh(multimesh_copy);
+			mmi->set_transform(page_local_transform);
+			layer_node->add_child(mmi);
+		}
 	}
 
 	return root;
@@ -2165,6 +2619,11 @@ void VoxelInstancer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_up_mode", "mode"), &VoxelInstancer::set_up_mode);
 	ClassDB::bind_method(D_METHOD("get_up_mode"), &VoxelInstancer::get_up_mode);
 
+	ClassDB::bind_method(
+			D_METHOD("set_multimesh_pages_enabled", "enabled"), &VoxelInstancer::set_multimesh_pages_enabled
+	);
+	ClassDB::bind_method(D_METHOD("get_multimesh_pages_enabled"), &VoxelInstancer::get_multimesh_pages_enabled);
+
 	ClassDB::bind_method(D_METHOD("debug_get_block_count"), &VoxelInstancer::debug_get_block_count);
 	ClassDB::bind_method(D_METHOD("debug_get_instance_counts"), &VoxelInstancer::_b_debug_get_instance_counts);
 	ClassDB::bind_method(D_METHOD("debug_dump_as_scene", "fpath"), &VoxelInstancer::debug_dump_as_scene);
@@ -2183,6 +2642,11 @@ void VoxelInstancer::_bind_methods() {
 	ADD_PROPERTY(
 			PropertyInfo(Variant::INT, "up_mode", PROPERTY_HINT_ENUM, "PositiveY,Sphere"), "set_up_mode", "get_up_mode"
 	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "multimesh_pages_enabled"),
+			"set_multimesh_pages_enabled",
+			"get_multimesh_pages_enabled"
+	);
 
 	BIND_CONSTANT(MAX_LOD);
 
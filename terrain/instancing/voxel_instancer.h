@@ -4,6 +4,7 @@
 #include "../../constants/voxel_constants.h"
 #include "../../streams/instance_data.h"
 #include "../../util/containers/fixed_array.h"
+#include "../../util/containers/range_allocator.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_unordered_set.h"
 #include "../../util/containers/std_vector.h"
@@ -34,6 +35,7 @@ class VoxelInstancerRigidBody;
 class VoxelInstanceComponent;
 class VoxelInstanceLibrary;
 class VoxelInstanceLibraryItem;
+class VoxelInstanceLibraryMultiMeshItem;
 class VoxelInstanceLibrarySceneItem;
 class VoxelTool;
 class SaveBlockDataTask;
@@ -71,6 +73,9 @@ public:
 	void set_library(Ref<VoxelInstanceLibrary> library);
 	Ref<VoxelInstanceLibrary> get_library() const;
 
+	void set_multimesh_pages_enabled(bool enabled);
+	bool get_multimesh_pages_enabled() const;
+
 	// Actions
 
 	void save_all_modified_blocks(
@@ -138,6 +143,8 @@ protected:
 
 private:
 	struct Layer;
+	struct Block;
+	struct MultiMeshPage;
 
 	void process();
 	void process_task_results();
@@ -199,9 +206,49 @@ private:
 			Vector3 block_local_position
 	);
 
+	void update_block_multimesh(
+			Block &block,
+			const PackedFloat32Array &bulk_array,
+			unsigned int instance_count,
+			const VoxelInstanceLibraryMultiMeshItem &item,
+			World3D &world,
+			const Transform3D &block_transform
+	);
+
+	// Same as `update_block_from_transforms`, for multimesh items without collision, where transforms are already in
+	// the buffer format of multimeshes.
+	void update_block_from_multimesh_buffer(
+			int block_index,
+			const PackedFloat32Array &bulk_array,
+			unsigned int instance_count,
+			Vector3i grid_position,
+			Layer &layer,
+			const VoxelInstanceLibraryMultiMeshItem &item,
+			uint16_t layer_id,
+			World3D &world,
+			const Transform3D &block_transform
+	);
+
 	void on_library_item_changed(int item_id, IInstanceLibraryItemListener::ChangeType change) override;
 
-	struct Block;
+	static bool can_use_multimesh_pages(const VoxelInstanceLibraryMultiMeshItem &item);
+
+	void update_block_multimesh_page(
+			Block &block,
+			const PackedFloat32Array &bulk_array,
+			unsigned int instance_count,
+			const VoxelInstanceLibraryMultiMeshItem &item,
+			World3D &world,
+			const Transform3D &block_transform
+	);
+
+	void release_block_multimesh_page(Block &block);
+	void upload_multimesh_pages();
+
+	// Accesses multimesh instances of a block, whether it has its own multimesh or uses a page.
+	// Transforms are local to the block.
+	static unsigned int get_block_multimesh_instance_count(const Block &block);
+	static Transform3D get_block_multimesh_instance_transform(const Block &block, unsigned int instance_index);
 
 	static void remove_floating_multimesh_instances(
 			Block &block,
@@ -211,6 +258,14 @@ private:
 			int block_size_po2
 	);
 
+	static void remove_floating_multimesh_page_instances(
+			Block &block,
+			const Transform3D &parent_transform,
+			Box3i p_voxel_box,
+			const VoxelTool &voxel_tool,
+			int block_size_po2
+	);
+
 	static void remove_floating_scene_instances(
 			Block &block,
 			const Transform3D &parent_transform,
@@ -245,6 +300,16 @@ private:
 		// Position in mesh block coordinate system
 		Vector3i grid_position;
 		zylann::godot::DirectMultiMeshInstance multimesh_instance;
+		// If not null, multimesh instances of this block are stored in a range of this page instead of
+		// `multimesh_instance`.
+		MultiMeshPage *page = nullptr;
+		uint32_t page_offset = 0;
+		// Number of slots allocated in the page, which can be higher than the number of instances so the block can
+		// change a bit without moving to another range.
+		uint32_t page_capacity = 0;
+		uint32_t page_instance_count = 0;
+		// Position of the block relative to the page
+		Vector3f page_origin_offset;
 		// For physics we use nodes because it's easier to manage.
 		// Such instances may be less numerous.
 		// If the item associated to this block has no collisions, this will be empty.
@@ -253,11 +318,34 @@ private:
 		StdVector<SceneInstance> scene_instances;
 	};
 
+	// When multimesh pages are enabled, render blocks of a multimesh layer without collisions and without mesh LODs
+	// don't get their own multimesh. Instead, blocks located in the same region share a larger multimesh, in which
+	// each block gets a range of instances. Blocks entering or leaving only write their range and change the visible
+	// count, instead of creating and destroying objects in the rendering server. Regions remain small enough to be
+	// culled efficiently.
+	struct MultiMeshPage {
+		// Position in page coordinate system, which is mesh blocks coordinates divided by the size of pages
+		Vector3i grid_position;
+		unsigned int block_count = 0;
+		zylann::godot::DirectMultiMeshInstance multimesh_instance;
+		RangeAllocator allocator;
+		// Copy of the multimesh buffer. Transforms are local to the page. Unused slots have a zero transform.
+		PackedFloat32Array buffer;
+		// If true, the buffer needs to be uploaded to the rendering server.
+		bool dirty = false;
+	};
+
+	// Pages are cubes of this number of mesh blocks (as a power of two) along each axis
+	static const unsigned int MULTIMESH_PAGE_SIZE_PO2 = 2;
+
 	struct Layer {
 		unsigned int lod_index;
 		// Blocks indexed by grid position.
 		// Keys follow the mesh block coordinate system.
 		StdUnorderedMap<Vector3i, unsigned int> blocks;
+		// Multimesh pages indexed by grid position.
+		// Keys follow the page coordinate system.
+		StdUnorderedMap<Vector3i, UniquePtr<MultiMeshPage>> pages;
 	};
 
 	struct MeshLodDistances {
@@ -299,6 +387,7 @@ private:
 	};
 
 	UpMode _up_mode = UP_MODE_POSITIVE_Y;
+	bool _multimesh_pages_enabled = false;
 
 	FixedArray<Lod, MAX_LOD> _lods;
 
@@ -2759,6 +2759,15 @@ bool VoxelLodTerrain::get_generator_use_gpu() const {
 	return _update_data->settings.generator_use_gpu;
 }
 
+void VoxelLodTerrain::set_edit_journal_max_memory_mb(int mb) {
+	ERR_FAIL_COND(mb < 0);
+	_data->set_edit_journal_max_memory(static_cast<size_t>(mb) * 1024 * 1024);
+}
+
+int VoxelLodTerrain::get_edit_journal_max_memory_mb() const {
+	return _data->get_edit_journal_max_memory() / (1024 * 1024);
+}
+
 #ifdef TOOLS_ENABLED
 
 void VoxelLodTerrain::get_configuration_warnings(PackedStringArray &warnings) const {
@@ -3700,6 +3709,9 @@ void VoxelLodTerrain::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_generator_use_gpu", "enabled"), &Self::set_generator_use_gpu);
 	ClassDB::bind_method(D_METHOD("get_generator_use_gpu"), &Self::get_generator_use_gpu);
 
+	ClassDB::bind_method(D_METHOD("set_edit_journal_max_memory_mb", "mb"), &Self::set_edit_journal_max_memory_mb);
+	ClassDB::bind_method(D_METHOD("get_edit_journal_max_memory_mb"), &Self::get_edit_journal_max_memory_mb);
+
 	ClassDB::bind_method(D_METHOD("set_streaming_system", "system"), &Self::set_streaming_system);
 	ClassDB::bind_method(D_METHOD("get_streaming_system"), &Self::get_streaming_system);
 
@@ -3852,6 +3864,11 @@ void VoxelLodTerrain::_bind_methods() {
 			"is_threaded_update_enabled"
 	);
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_gpu_generation"), "set_generator_use_gpu", "get_generator_use_gpu");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "edit_journal_max_memory_mb"),
+			"set_edit_journal_max_memory_mb",
+			"get_edit_journal_max_memory_mb"
+	);
 	ADD_PROPERTY(
 			PropertyInfo(Variant::INT, "streaming_system", PROPERTY_HINT_ENUM, "Octree (legacy),Clipbox"),
 			"set_streaming_system",
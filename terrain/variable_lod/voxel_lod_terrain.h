@@ -125,6 +125,9 @@ public:
 	void set_generator_use_gpu(bool enabled);
 	bool get_generator_use_gpu() const;
 
+	void set_edit_journal_max_memory_mb(int mb);
+	int get_edit_journal_max_memory_mb() const;
+
 	// These must be called after an edit
 	void post_edit_area(Box3i p_box, bool update_mesh);
 	void post_edit_modifiers(Box3i p_voxel_box);
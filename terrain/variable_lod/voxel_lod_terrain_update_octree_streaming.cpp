@@ -1,3 +1,4 @@
+#include "../../engine/voxel_engine.h"
 #include "../../storage/voxel_data.h"
 #include "../../util/math/conv.h"
 #include "voxel_lod_terrain_update_data.h"
@@ -401,7 +402,7 @@ bool check_block_mesh_updated(
 
 			if (surrounded) {
 				lod.mesh_blocks_pending_update.push_back(VoxelLodTerrainUpdateData::MeshToUpdate{
-						mesh_block_pos, TaskCancellationToken(), true });
+						mesh_block_pos, TaskCancellationToken(), mesh_block.mesh_viewers.get() > 0 });
 				mesh_block.state = VoxelLodTerrainUpdateData::MESH_UPDATE_NOT_SENT;
 			}
 
@@ -506,7 +507,10 @@ bool check_block_loaded_and_meshed(
 		// we could defer additions to the end of octree fitting.
 		RWLockWrite wlock(lod.mesh_map_state.map_lock);
 		mesh_block = &insert_new(lod.mesh_map_state.map, p_mesh_block_pos);
-		mesh_block->mesh_viewers.add();
+		// Octree streaming has no viewer requirements, but visuals are still never needed in headless mode
+		if (!VoxelEngine::get_singleton().is_headless()) {
+			mesh_block->mesh_viewers.add();
+		}
 		mesh_block->collision_viewers.add();
 	} else {
 		mesh_block = &mesh_block_it->second;
@@ -306,8 +306,9 @@ void send_mesh_requests( //
 			task->block_generation_use_gpu = settings.generator_use_gpu;
 			task->cancellation_token = mesh_to_update.cancellation_token;
 
-			// Don't update a detail texture if one update is already processing
-			if (settings.detail_texture_settings.enabled &&
+			// Don't update a detail texture if one update is already processing.
+			// Detail textures are only used for rendering, so they are skipped when visuals are not required.
+			if (mesh_to_update.require_visual && settings.detail_texture_settings.enabled &&
 					lod_index >= settings.detail_texture_settings.begin_lod_index &&
 					mesh_block.detail_texture_state != VoxelLodTerrainUpdateData::DETAIL_TEXTURE_PENDING) {
 				mesh_block.detail_texture_state = VoxelLodTerrainUpdateData::DETAIL_TEXTURE_PENDING;
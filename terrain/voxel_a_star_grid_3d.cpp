@@ -2,6 +2,7 @@
 #include "../terrain/fixed_lod/voxel_terrain.h"
 // #include "../util/string/format.h"
 #include "../constants/voxel_string_names.h"
+#include "../engine/parallel_for.h"
 #include "../util/math/conv.h"
 
 namespace zylann::voxel {
@@ -105,6 +106,7 @@ void VoxelAStarGrid3D::set_terrain(VoxelTerrain *node) {
 	// Can't modify the pathfinder while it is running in a different thread
 	ZN_ASSERT_RETURN(_is_running_async == false);
 	_path_finder.data = node->get_storage_shared();
+	_hierarchy.reset();
 }
 
 TypedArray<Vector3i> VoxelAStarGrid3D::find_path(Vector3i from_position, Vector3i to_position) {
@@ -142,6 +144,15 @@ TypedArray<Vector3i> to_typed_array(Span<const Vector3i> items) {
 } // namespace
 
 TypedArray<Vector3i> VoxelAStarGrid3D::find_path_internal(Vector3i from_position, Vector3i to_position) {
+	if (_hierarchical_enabled) {
+		std::shared_ptr<VoxelAStarGrid3DHierarchy> hierarchy = get_or_create_hierarchy();
+		ZN_ASSERT_RETURN_V(hierarchy != nullptr, TypedArray<Vector3i>());
+		hierarchy->update();
+		StdVector<Vector3i> path;
+		hierarchy->find_path(from_position, to_position, _hierarchy_search_context, path);
+		return to_typed_array(to_span(path));
+	}
+
 	_path_finder.start(from_position, to_position);
 	_path_finder.init_cache();
 
@@ -156,6 +167,7 @@ TypedArray<Vector3i> VoxelAStarGrid3D::find_path_internal(Vector3i from_position
 void VoxelAStarGrid3D::set_region(Box3i region) {
 	ZN_ASSERT_RETURN(_is_running_async == false);
 	_path_finder.set_region(region);
+	_hierarchy.reset();
 }
 
 Box3i VoxelAStarGrid3D::get_region() {
@@ -200,6 +212,96 @@ bool VoxelAStarGrid3D::is_running_async() const {
 	return _is_running_async;
 }
 
+void VoxelAStarGrid3D::set_hierarchical_enabled(bool enabled) {
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	_hierarchical_enabled = enabled;
+}
+
+bool VoxelAStarGrid3D::is_hierarchical_enabled() const {
+	return _hierarchical_enabled;
+}
+
+std::shared_ptr<VoxelAStarGrid3DHierarchy> VoxelAStarGrid3D::get_or_create_hierarchy() {
+	if (_hierarchy == nullptr) {
+		ZN_ASSERT_RETURN_V_MSG(_path_finder.data != nullptr, nullptr, "No terrain was set");
+
+		VoxelAStarGrid3DHierarchy::Params params;
+		params.region = _path_finder.get_region();
+		params.agent_size = _path_finder.get_agent_size();
+		params.max_fall_height = _path_finder.get_max_fall_height();
+		params.max_path_cost = _path_finder.get_max_path_cost();
+
+		_hierarchy = make_shared_instance<VoxelAStarGrid3DHierarchy>(_path_finder.data, params);
+		// Edits done to the terrain will invalidate parts of the hierarchy
+		_path_finder.data->add_edit_listener(_hierarchy);
+	}
+	return _hierarchy;
+}
+
+void VoxelAStarGrid3D::find_paths_async(
+		const TypedArray<Vector3i> &from_positions,
+		const TypedArray<Vector3i> &to_positions
+) {
+	ZN_ASSERT_RETURN(_is_running_async == false);
+	ZN_ASSERT_RETURN_MSG(
+			from_positions.size() == to_positions.size(), "Source and destination arrays must have the same size"
+	);
+
+	std::shared_ptr<VoxelAStarGrid3DHierarchy> hierarchy = get_or_create_hierarchy();
+	ZN_ASSERT_RETURN(hierarchy != nullptr);
+
+	_is_running_async = true;
+
+	class Task : public IThreadedTask {
+	public:
+		Ref<VoxelAStarGrid3D> astar;
+		std::shared_ptr<VoxelAStarGrid3DHierarchy> hierarchy;
+		StdVector<Vector3i> from_positions;
+		StdVector<Vector3i> to_positions;
+
+		void run(ThreadedTaskContext &ctx) override {
+			ZN_PROFILE_SCOPE();
+			ZN_ASSERT(astar.is_valid());
+
+			// Updated once, then shared by all searches
+			hierarchy->update();
+
+			StdVector<StdVector<Vector3i>> paths;
+			paths.resize(from_positions.size());
+
+			parallel_for_ranges(paths.size(), 8, [this, &paths](unsigned int begin, unsigned int end) {
+				VoxelAStarGrid3DHierarchy::SearchContext search_context;
+				for (unsigned int i = begin; i < end; ++i) {
+					hierarchy->find_path(from_positions[i], to_positions[i], search_context, paths[i]);
+				}
+			});
+
+			Array results;
+			results.resize(paths.size());
+			for (unsigned int i = 0; i < paths.size(); ++i) {
+				results[i] = to_typed_array(to_span(paths[i]));
+			}
+			astar->call_deferred(VoxelStringNames::get_singleton()._on_async_batch_search_completed, results);
+		}
+
+		const char *get_debug_name() const override {
+			return "VoxelAStarGrid3DBatchTask";
+		}
+	};
+
+	Task *task = ZN_NEW(Task);
+	task->astar = Ref<VoxelAStarGrid3D>(this);
+	task->hierarchy = hierarchy;
+	task->from_positions.resize(from_positions.size());
+	task->to_positions.resize(to_positions.size());
+	for (int i = 0; i < from_positions.size(); ++i) {
+		task->from_positions[i] = from_positions[i];
+		task->to_positions[i] = to_positions[i];
+	}
+
+	VoxelEngine::get_singleton().push_async_task(task);
+}
+
 TypedArray<Vector3i> VoxelAStarGrid3D::debug_get_visited_positions() const {
 	ZN_ASSERT_RETURN_V(_is_running_async == false, TypedArray<Vector3i>());
 	StdVector<Vector3i> positions;
@@ -222,6 +324,11 @@ void VoxelAStarGrid3D::_b_on_async_search_completed(TypedArray<Vector3i> path) {
 	emit_signal(VoxelStringNames::get_singleton().async_search_completed, path);
 }
 
+void VoxelAStarGrid3D::_b_on_async_batch_search_completed(Array paths) {
+	_is_running_async = false;
+	emit_signal(VoxelStringNames::get_singleton().async_batch_search_completed, paths);
+}
+
 void VoxelAStarGrid3D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_terrain", "terrain"), &VoxelAStarGrid3D::set_terrain);
 
@@ -232,15 +339,23 @@ void VoxelAStarGrid3D::_bind_methods() {
 	ClassDB::bind_method(
 			D_METHOD("find_path_async", "from_position", "to_position"), &VoxelAStarGrid3D::find_path_async);
 	ClassDB::bind_method(D_METHOD("is_running_async"), &VoxelAStarGrid3D::is_running_async);
+	ClassDB::bind_method(
+			D_METHOD("find_paths_async", "from_positions", "to_positions"), &VoxelAStarGrid3D::find_paths_async);
+
+	ClassDB::bind_method(D_METHOD("set_hierarchical_enabled", "enabled"), &VoxelAStarGrid3D::set_hierarchical_enabled);
+	ClassDB::bind_method(D_METHOD("is_hierarchical_enabled"), &VoxelAStarGrid3D::is_hierarchical_enabled);
 
 	ClassDB::bind_method(D_METHOD("debug_get_visited_positions"), &VoxelAStarGrid3D::debug_get_visited_positions);
 
 	// Internal
 	ClassDB::bind_method(
 			D_METHOD("_on_async_search_completed", "path"), &VoxelAStarGrid3D::_b_on_async_search_completed);
+	ClassDB::bind_method(D_METHOD("_on_async_batch_search_completed", "paths"),
+			&VoxelAStarGrid3D::_b_on_async_batch_search_completed);
 
 	ADD_SIGNAL(MethodInfo(
 			"async_search_completed", PropertyInfo(Variant::ARRAY, "path", PROPERTY_HINT_ARRAY_TYPE, "Vector3i")));
+	ADD_SIGNAL(MethodInfo("async_batch_search_completed", PropertyInfo(Variant::ARRAY, "paths")));
 }
 
 } // namespace zylann::voxel
@@ -6,6 +6,7 @@
 #include "../util/a_star_grid_3d.h"
 #include "../util/containers/dynamic_bitset.h"
 #include "../util/containers/std_vector.h"
+#include "voxel_a_star_grid_3d_hierarchy.h"
 #include <atomic>
 
 namespace zylann::voxel {
@@ -61,7 +62,8 @@ class VoxelAStarGrid3D : public RefCounted {
 	GDCLASS(VoxelAStarGrid3D, RefCounted)
 public:
 	// Bare bones at the moment. May need more configurations and customization.
-	// Also, it does not cache data between queries.
+	// Flat searches don't cache data between queries. Hierarchical searches cache a graph of portals per data block,
+	// which is shared by all searches and updated when voxels get edited.
 
 	void set_terrain(VoxelTerrain *node);
 
@@ -73,10 +75,17 @@ public:
 	void find_path_async(Vector3i from_position, Vector3i to_position);
 	bool is_running_async() const;
 
+	void set_hierarchical_enabled(bool enabled);
+	bool is_hierarchical_enabled() const;
+
+	// Finds many paths at once on threads, using hierarchical search.
+	void find_paths_async(const TypedArray<Vector3i> &from_positions, const TypedArray<Vector3i> &to_positions);
+
 	TypedArray<Vector3i> debug_get_visited_positions() const;
 
 private:
 	TypedArray<Vector3i> find_path_internal(Vector3i from_position, Vector3i to_position);
+	std::shared_ptr<VoxelAStarGrid3DHierarchy> get_or_create_hierarchy();
 #ifdef DEBUG_ENABLED
 	void check_params(Vector3i from_position, Vector3i to_position);
 #endif
@@ -84,11 +93,17 @@ private:
 	void _b_set_region(AABB aabb);
 	AABB _b_get_region();
 	void _b_on_async_search_completed(TypedArray<Vector3i> path);
+	void _b_on_async_batch_search_completed(Array paths);
 
 	static void _bind_methods();
 
 	VoxelAStarGrid3DInternal _path_finder;
 	std::atomic_bool _is_running_async = { false };
+
+	bool _hierarchical_enabled = false;
+	// Created on demand, and reset when settings change. Held by threaded tasks while they use it.
+	std::shared_ptr<VoxelAStarGrid3DHierarchy> _hierarchy;
+	VoxelAStarGrid3DHierarchy::SearchContext _hierarchy_search_context;
 };
 
 } // namespace zylann::voxel
@@ -0,0 +1,579 @@
+#include "voxel_a_star_grid_3d_hierarchy.h"
+#include "../engine/parallel_for.h"
+#include "../storage/voxel_buffer.h"
+#include "../util/math/conv.h"
+#include "../util/profiling.h"
+#include <algorithm>
+
+namespace zylann::voxel {
+
+namespace {
+
+// Adding an epsilon to fix float precision issues, same as in `AStarGrid3D`
+const float COST_EPSILON = 0.001f;
+
+// Euclidean distance never overestimates the cost of a path, since every step costs its own length. That keeps
+// searches optimal, unlike Manhattan distance, which overestimates diagonal steps.
+inline float get_heuristic_distance(Vector3i a, Vector3i b) {
+	return math::length(to_vec3f(b - a));
+}
+
+inline float get_step_cost(Vector3i a, Vector3i b) {
+	return math::length(to_vec3f(b - a));
+}
+
+template <typename TOpenItem>
+inline bool compare_open_items(const TOpenItem &a, const TOpenItem &b) {
+	// Makes a min-heap with standard heap functions
+	return a.fscore > b.fscore;
+}
+
+} // namespace
+
+void VoxelAStarGrid3DHierarchy::ClusterGrid::set_cluster(const Cluster &cluster) {
+	_cluster = &cluster;
+	set_region(cluster.solid_box);
+}
+
+bool VoxelAStarGrid3DHierarchy::ClusterGrid::is_solid(Vector3i pos) {
+	return get_solid(pos);
+}
+
+bool VoxelAStarGrid3DHierarchy::ClusterGrid::get_solid(Vector3i pos) const {
+	const Cluster &cluster = *_cluster;
+	if (!cluster.solid_box.contains(pos)) {
+		return false;
+	}
+	const Vector3i rpos = pos - cluster.solid_box.position;
+	return cluster.solid_bits.get(Vector3iUtil::get_zxy_index(rpos, cluster.solid_box.size));
+}
+
+uint32_t VoxelAStarGrid3DHierarchy::LocalSearch::find_point(Vector3i pos) const {
+	auto it = points_map.find(pos);
+	if (it == points_map.end()) {
+		return NO_CAME_FROM;
+	}
+	return it->second;
+}
+
+VoxelAStarGrid3DHierarchy::VoxelAStarGrid3DHierarchy(std::shared_ptr<VoxelData> data, const Params &params) :
+		_data(data), _params(params) {
+	ZN_ASSERT(_data != nullptr);
+
+	_block_size_po2 = _data->get_block_size_po2();
+
+	// Checking if an agent can move somewhere looks at voxels around it: the space it occupies, and ground below it.
+	// Portals are also found by looking one voxel outside of clusters.
+	const Vector3i agent_size = math::ceil_to_int(_params.agent_size);
+	const int agent_max_size = math::max(agent_size.x, math::max(agent_size.y, agent_size.z));
+	_solid_padding = 2 + math::max(_params.max_fall_height, 2) + agent_max_size;
+
+	_clusters_box = _params.region.downscaled(1 << _block_size_po2);
+	_clusters.resize(Vector3iUtil::get_volume(_clusters_box.size));
+
+	for (unsigned int cluster_index = 0; cluster_index < _clusters.size(); ++cluster_index) {
+		const Vector3i bpos = Vector3iUtil::from_zxy_index(cluster_index, _clusters_box.size) + _clusters_box.position;
+		Cluster &cluster = _clusters[cluster_index];
+		const Box3i block_box(bpos << _block_size_po2, Vector3iUtil::create(1 << _block_size_po2));
+		cluster.box = block_box.clipped(_params.region);
+	}
+
+	_dirty_clusters.resize_no_init(_clusters.size());
+	_dirty_clusters.fill(true);
+	_has_dirty_clusters = true;
+}
+
+void VoxelAStarGrid3DHierarchy::on_area_changed(Box3i voxel_box) {
+	const Box3i blocks_box = voxel_box.padded(_solid_padding).downscaled(1 << _block_size_po2).clipped(_clusters_box);
+
+	MutexLock mlock(_dirty_clusters_mutex);
+	blocks_box.for_each_cell([this](Vector3i bpos) {
+		_dirty_clusters.set(Vector3iUtil::get_zxy_index(bpos - _clusters_box.position, _clusters_box.size));
+	});
+	_has_dirty_clusters = true;
+}
+
+void VoxelAStarGrid3DHierarchy::update() {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<uint32_t> cluster_indices;
+	{
+		MutexLock mlock(_dirty_clusters_mutex);
+		if (!_has_dirty_clusters) {
+			return;
+		}
+		for (unsigned int cluster_index = 0; cluster_index < _clusters.size(); ++cluster_index) {
+			if (_dirty_clusters.get(cluster_index)) {
+				cluster_indices.push_back(cluster_index);
+			}
+		}
+		_dirty_clusters.fill(false);
+		_has_dirty_clusters = false;
+	}
+
+	// Clusters only depend on voxels, so they can be built independently
+	parallel_for_ranges(cluster_indices.size(), 4, [this, &cluster_indices](unsigned int begin, unsigned int end) {
+		ClusterGrid grid;
+		LocalSearch local_search;
+		for (unsigned int i = begin; i < end; ++i) {
+			build_cluster(_clusters[cluster_indices[i]], grid, local_search);
+		}
+	});
+}
+
+void VoxelAStarGrid3DHierarchy::build_cluster(Cluster &cluster, ClusterGrid &grid, LocalSearch &local_search) const {
+	ZN_PROFILE_SCOPE();
+
+	cluster.portals.clear();
+	cluster.edges.clear();
+	cluster.portals_map.clear();
+
+	// Cache solid voxels
+
+	cluster.solid_box = cluster.box.padded(_solid_padding).clipped(_params.region);
+	{
+		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
+		voxels.create(cluster.solid_box.size);
+		const VoxelBuffer::ChannelId channel_index = VoxelBuffer::CHANNEL_TYPE;
+		_data->copy(cluster.solid_box.position, voxels, 1 << channel_index);
+
+		cluster.solid_bits.resize_no_init(Vector3iUtil::get_volume(cluster.solid_box.size));
+
+		if (voxels.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM) {
+			cluster.solid_bits.fill(voxels.get_voxel(0, 0, 0, channel_index) != 0);
+
+		} else {
+			// Both are in ZXY order
+			switch (voxels.get_channel_depth(channel_index)) {
+				case VoxelBuffer::DEPTH_8_BIT: {
+					Span<const uint8_t> values;
+					ZN_ASSERT(voxels.get_channel_data_read_only(channel_index, values));
+					for (unsigned int i = 0; i < values.size(); ++i) {
+						cluster.solid_bits.set(i, values[i] != 0);
+					}
+				} break;
+
+				case VoxelBuffer::DEPTH_16_BIT: {
+					Span<const uint16_t> values;
+					ZN_ASSERT(voxels.get_channel_data_read_only(channel_index, values));
+					for (unsigned int i = 0; i < values.size(); ++i) {
+						cluster.solid_bits.set(i, values[i] != 0);
+					}
+				} break;
+
+				default:
+					ZN_PRINT_ERROR("Unhandled channel depth");
+					cluster.solid_bits.fill(false);
+					break;
+			}
+		}
+	}
+
+	grid.set_agent_size(_params.agent_size);
+	grid.set_max_fall_height(_params.max_fall_height);
+	grid.set_cluster(cluster);
+
+	// Find portals.
+	// Agents can only stand on ground, or be in the air after jumping or falling a few voxels, so other positions are
+	// skipped early to avoid expensive neighbor checks.
+
+	const int ground_search_height = math::max(_params.max_fall_height, 2);
+
+	auto may_be_walked = [&grid, ground_search_height](Vector3i pos) {
+		if (grid.get_solid(pos)) {
+			return false;
+		}
+		for (int i = 1; i <= ground_search_height; ++i) {
+			if (grid.get_solid(pos - Vector3i(0, i, 0))) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	auto add_portal = [&cluster](Vector3i pos) {
+		if (cluster.portals_map.find(pos) == cluster.portals_map.end()) {
+			cluster.portals_map.insert({ pos, cluster.portals.size() });
+			cluster.portals.push_back(Cluster::Portal{ pos, 0, 0 });
+		}
+	};
+
+	struct ExitStep {
+		Vector3i from_position;
+		Vector3i to_position;
+	};
+
+	StdVector<ExitStep> exit_steps;
+	StdVector<Vector3i> neighbor_positions;
+
+	const Box3i &box = cluster.box;
+	const Box3i inner_box(box.position + Vector3i(1, 1, 1), box.size - Vector3i(2, 2, 2));
+
+	// Look at the border of the cluster for positions leading outside, and one voxel around the cluster for positions
+	// leading inside
+	box.padded(1).clipped(_params.region).for_each_cell_zxy([&](Vector3i pos) {
+		if (inner_box.contains(pos)) {
+			return;
+		}
+		if (!may_be_walked(pos)) {
+			return;
+		}
+		const bool inside = box.contains(pos);
+		neighbor_positions.clear();
+		grid.get_neighbor_positions(pos, neighbor_positions);
+
+		for (const Vector3i npos : neighbor_positions) {
+			if (box.contains(npos) == inside) {
+				continue;
+			}
+			if (inside) {
+				add_portal(pos);
+				exit_steps.push_back(ExitStep{ pos, npos });
+			} else {
+				add_portal(npos);
+			}
+		}
+	});
+
+	// Find costs between portals
+
+	for (uint32_t portal_index = 0; portal_index < cluster.portals.size(); ++portal_index) {
+		Cluster::Portal &portal = cluster.portals[portal_index];
+		portal.edges_begin = cluster.edges.size();
+
+		search_in_cluster(cluster, portal.position, nullptr, grid, local_search);
+
+		for (uint32_t other_portal_index = 0; other_portal_index < cluster.portals.size(); ++other_portal_index) {
+			if (other_portal_index == portal_index) {
+				continue;
+			}
+			const Vector3i other_position = cluster.portals[other_portal_index].position;
+			const uint32_t point_index = local_search.find_point(other_position);
+			if (point_index != LocalSearch::NO_CAME_FROM) {
+				const float cost = local_search.points[point_index].gscore;
+				cluster.edges.push_back(Cluster::Edge{ other_position, other_portal_index, cost });
+			}
+		}
+
+		for (const ExitStep &step : exit_steps) {
+			if (step.from_position == portal.position) {
+				const float cost = get_step_cost(step.from_position, step.to_position);
+				cluster.edges.push_back(Cluster::Edge{ step.to_position, SearchContext::NO_PORTAL, cost });
+			}
+		}
+
+		portal.edges_end = cluster.edges.size();
+	}
+}
+
+bool VoxelAStarGrid3DHierarchy::search_in_cluster(
+		const Cluster &cluster,
+		const Vector3i from_position,
+		const Vector3i *to_position,
+		ClusterGrid &grid,
+		LocalSearch &ls
+) const {
+	// Flat A* similar to `AStarGrid3D`, but limited to the cluster. Without destination, it visits every reachable
+	// position, which is used to find costs to many positions at once.
+
+	ls.points.clear();
+	ls.points_map.clear();
+	ls.open_list.clear();
+
+	if (!cluster.box.contains(from_position)) {
+		return false;
+	}
+
+	grid.set_agent_size(_params.agent_size);
+	grid.set_max_fall_height(_params.max_fall_height);
+	grid.set_cluster(cluster);
+
+	auto heuristic = [to_position](Vector3i pos) {
+		return to_position != nullptr ? get_heuristic_distance(pos, *to_position) : 0.f;
+	};
+
+	ls.points.push_back(LocalSearch::Point{ from_position, 0.f, LocalSearch::NO_CAME_FROM });
+	ls.points_map.insert({ from_position, 0 });
+	ls.open_list.push_back(LocalSearch::OpenItem{ heuristic(from_position), 0 });
+
+	while (ls.open_list.size() > 0) {
+		std::pop_heap(ls.open_list.begin(), ls.open_list.end(), compare_open_items<LocalSearch::OpenItem>);
+		const LocalSearch::OpenItem item = ls.open_list.back();
+		ls.open_list.pop_back();
+
+		const LocalSearch::Point current_point = ls.points[item.point_index];
+
+		// Points are pushed again when a better path is found to them, instead of being moved in the list
+		if (item.fscore > current_point.gscore + heuristic(current_point.position) + COST_EPSILON) {
+			continue;
+		}
+
+		if (to_position != nullptr && current_point.position == *to_position) {
+			return true;
+		}
+
+		ls.neighbor_positions.clear();
+		grid.get_neighbor_positions(current_point.position, ls.neighbor_positions);
+
+		for (const Vector3i npos : ls.neighbor_positions) {
+			if (!cluster.box.contains(npos)) {
+				continue;
+			}
+
+			const float tentative_gscore = current_point.gscore + get_step_cost(current_point.position, npos);
+			if (tentative_gscore >= _params.max_path_cost) {
+				continue;
+			}
+
+			uint32_t neighbor_point_index;
+			auto it = ls.points_map.find(npos);
+			if (it != ls.points_map.end()) {
+				neighbor_point_index = it->second;
+				if (tentative_gscore + COST_EPSILON >= ls.points[neighbor_point_index].gscore) {
+					continue;
+				}
+			} else {
+				neighbor_point_index = ls.points.size();
+				ls.points.push_back(LocalSearch::Point());
+				ls.points_map.insert({ npos, neighbor_point_index });
+			}
+
+			LocalSearch::Point &neighbor_point = ls.points[neighbor_point_index];
+			neighbor_point.position = npos;
+			neighbor_point.gscore = tentative_gscore;
+			neighbor_point.came_from_point_index = item.point_index;
+
+			ls.open_list.push_back(LocalSearch::OpenItem{ tentative_gscore + heuristic(npos), neighbor_point_index });
+			std::push_heap(ls.open_list.begin(), ls.open_list.end(), compare_open_items<LocalSearch::OpenItem>);
+		}
+	}
+
+	return to_position == nullptr;
+}
+
+bool VoxelAStarGrid3DHierarchy::append_local_path(
+		const Cluster &cluster,
+		const Vector3i from_position,
+		const Vector3i to_position,
+		ClusterGrid &grid,
+		LocalSearch &ls,
+		StdVector<Vector3i> &out_path
+) const {
+	if (!search_in_cluster(cluster, from_position, &to_position, grid, ls)) {
+		return false;
+	}
+
+	// Positions from the source to the one preceding the destination
+	const size_t begin = out_path.size();
+	uint32_t point_index = ls.points[ls.find_point(to_position)].came_from_point_index;
+	while (point_index != LocalSearch::NO_CAME_FROM) {
+		const LocalSearch::Point &point = ls.points[point_index];
+		out_path.push_back(point.position);
+		point_index = point.came_from_point_index;
+	}
+	std::reverse(out_path.begin() + begin, out_path.end());
+	return true;
+}
+
+uint32_t VoxelAStarGrid3DHierarchy::get_cluster_index(Vector3i voxel_pos) const {
+	const Vector3i bpos = voxel_pos >> _block_size_po2;
+	if (!_clusters_box.contains(bpos)) {
+		return SearchContext::NO_PORTAL;
+	}
+	return Vector3iUtil::get_zxy_index(bpos - _clusters_box.position, _clusters_box.size);
+}
+
+void VoxelAStarGrid3DHierarchy::find_path(
+		const Vector3i from_position,
+		const Vector3i to_position,
+		SearchContext &ctx,
+		StdVector<Vector3i> &out_path
+) const {
+	ZN_PROFILE_SCOPE();
+
+	out_path.clear();
+
+	if (from_position == to_position) {
+		return;
+	}
+	if (!_params.region.contains(from_position) || !_params.region.contains(to_position)) {
+		return;
+	}
+
+	const uint32_t from_cluster_index = get_cluster_index(from_position);
+	const uint32_t to_cluster_index = get_cluster_index(to_position);
+
+	auto get_portal_index = [](const Cluster &cluster, Vector3i pos) {
+		auto it = cluster.portals_map.find(pos);
+		return it != cluster.portals_map.end() ? it->second : SearchContext::NO_PORTAL;
+	};
+
+	ctx.nodes.clear();
+	ctx.nodes_map.clear();
+	ctx.open_list.clear();
+	ctx.node_path.clear();
+
+	auto get_or_create_node = [&ctx](Vector3i pos, uint32_t cluster_index, uint32_t portal_index) {
+		auto it = ctx.nodes_map.find(pos);
+		if (it != ctx.nodes_map.end()) {
+			return it->second;
+		}
+		const uint32_t node_index = ctx.nodes.size();
+		SearchContext::Node node;
+		node.position = pos;
+		node.cluster_index = cluster_index;
+		node.portal_index = portal_index;
+		node.gscore = 999999999.f;
+		node.came_from_node_index = SearchContext::NO_CAME_FROM;
+		node.closed = false;
+		ctx.nodes.push_back(node);
+		ctx.nodes_map.insert({ pos, node_index });
+		return node_index;
+	};
+
+	// Updates the cost of a node if a better way to it was found
+	auto relax = [&](uint32_t src_node_index, Vector3i pos, uint32_t cluster_index, uint32_t portal_index, float cost) {
+		const float tentative_gscore = ctx.nodes[src_node_index].gscore + cost;
+		if (tentative_gscore >= _params.max_path_cost) {
+			return;
+		}
+		const uint32_t node_index = get_or_create_node(pos, cluster_index, portal_index);
+		SearchContext::Node &node = ctx.nodes[node_index];
+		if (node.closed || tentative_gscore + COST_EPSILON >= node.gscore) {
+			return;
+		}
+		node.gscore = tentative_gscore;
+		node.came_from_node_index = src_node_index;
+		const float fscore = tentative_gscore + get_heuristic_distance(pos, to_position);
+		ctx.open_list.push_back(SearchContext::OpenItem{ fscore, node_index });
+		std::push_heap(ctx.open_list.begin(), ctx.open_list.end(), compare_open_items<SearchContext::OpenItem>);
+	};
+
+	const Cluster &from_cluster = _clusters[from_cluster_index];
+	const Cluster &to_cluster = _clusters[to_cluster_index];
+	const uint32_t to_portal_index = get_portal_index(to_cluster, to_position);
+
+	const uint32_t start_node_index =
+			get_or_create_node(from_position, from_cluster_index, get_portal_index(from_cluster, from_position));
+	ctx.nodes[start_node_index].gscore = 0.f;
+	const float start_fscore = get_heuristic_distance(from_position, to_position);
+	ctx.open_list.push_back(SearchContext::OpenItem{ start_fscore, start_node_index });
+
+	bool found = false;
+
+	// Search on the graph of portals
+
+	while (ctx.open_list.size() > 0) {
+		std::pop_heap(ctx.open_list.begin(), ctx.open_list.end(), compare_open_items<SearchContext::OpenItem>);
+		const uint32_t node_index = ctx.open_list.back().node_index;
+		ctx.open_list.pop_back();
+
+		const SearchContext::Node node = ctx.nodes[node_index];
+		if (node.closed) {
+			continue;
+		}
+		ctx.nodes[node_index].closed = true;
+
+		if (node.position == to_position) {
+			found = true;
+			uint32_t path_node_index = node_index;
+			while (path_node_index != SearchContext::NO_CAME_FROM) {
+				ctx.node_path.push_back(path_node_index);
+				path_node_index = ctx.nodes[path_node_index].came_from_node_index;
+			}
+			std::reverse(ctx.node_path.begin(), ctx.node_path.end());
+			break;
+		}
+
+		const Cluster &cluster = _clusters[node.cluster_index];
+
+		if (node_index == start_node_index) {
+			// The source is not necessarily a portal, find how it reaches portals of its cluster
+			search_in_cluster(cluster, from_position, nullptr, ctx.grid, ctx.local_search);
+			const LocalSearch &ls = ctx.local_search;
+
+			for (uint32_t portal_index = 0; portal_index < cluster.portals.size(); ++portal_index) {
+				const Vector3i portal_position = cluster.portals[portal_index].position;
+				const uint32_t point_index = ls.find_point(portal_position);
+				if (point_index != LocalSearch::NO_CAME_FROM) {
+					relax(node_index, portal_position, node.cluster_index, portal_index, ls.points[point_index].gscore);
+				}
+			}
+
+			if (to_cluster_index == from_cluster_index) {
+				const uint32_t point_index = ls.find_point(to_position);
+				if (point_index != LocalSearch::NO_CAME_FROM) {
+					relax(node_index, to_position, to_cluster_index, to_portal_index, ls.points[point_index].gscore);
+				}
+			}
+
+		} else if (node.cluster_index == to_cluster_index) {
+			// The destination is not necessarily a portal either
+			if (search_in_cluster(cluster, node.position, &to_position, ctx.grid, ctx.local_search)) {
+				const LocalSearch &ls = ctx.local_search;
+				const float cost = ls.points[ls.find_point(to_position)].gscore;
+				relax(node_index, to_position, to_cluster_index, to_portal_index, cost);
+			}
+		}
+
+		if (node.portal_index != SearchContext::NO_PORTAL) {
+			const Cluster::Portal &portal = cluster.portals[node.portal_index];
+
+			for (uint32_t edge_index = portal.edges_begin; edge_index < portal.edges_end; ++edge_index) {
+				const Cluster::Edge &edge = cluster.edges[edge_index];
+
+				if (edge.portal_index != SearchContext::NO_PORTAL) {
+					relax(node_index, edge.position, node.cluster_index, edge.portal_index, edge.cost);
+
+				} else {
+					const uint32_t dst_cluster_index = get_cluster_index(edge.position);
+					if (dst_cluster_index == SearchContext::NO_PORTAL) {
+						continue;
+					}
+					const uint32_t dst_portal_index = get_portal_index(_clusters[dst_cluster_index], edge.position);
+					if (dst_portal_index == SearchContext::NO_PORTAL) {
+						// The neighbor cluster was built from different voxels
+						continue;
+					}
+					relax(node_index, edge.position, dst_cluster_index, dst_portal_index, edge.cost);
+				}
+			}
+		}
+	}
+
+	if (!found) {
+		return;
+	}
+
+	// Refine into a path of voxels.
+	// Consecutive nodes in the same cluster are connected by a path within that cluster. Otherwise, they are
+	// adjacent positions on each side of a cluster border.
+
+	for (unsigned int i = 0; i + 1 < ctx.node_path.size(); ++i) {
+		const SearchContext::Node &node = ctx.nodes[ctx.node_path[i]];
+		const SearchContext::Node &next_node = ctx.nodes[ctx.node_path[i + 1]];
+
+		if (node.cluster_index == next_node.cluster_index) {
+			const Cluster &cluster = _clusters[node.cluster_index];
+			if (!append_local_path(
+						cluster, node.position, next_node.position, ctx.grid, ctx.local_search, out_path
+				)) {
+				ZN_PRINT_ERROR("Could not refine hierarchical path");
+				out_path.clear();
+				return;
+			}
+		} else {
+			out_path.push_back(node.position);
+		}
+	}
+}
+
+unsigned int VoxelAStarGrid3DHierarchy::debug_get_portal_count() const {
+	unsigned int count = 0;
+	for (const Cluster &cluster : _clusters) {
+		count += cluster.portals.size();
+	}
+	return count;
+}
+
+} // namespace zylann::voxel
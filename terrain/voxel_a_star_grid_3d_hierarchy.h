@@ -0,0 +1,191 @@
+#ifndef VOXEL_A_STAR_GRID_3D_HIERARCHY_H
+#define VOXEL_A_STAR_GRID_3D_HIERARCHY_H
+
+#include "../storage/voxel_data.h"
+#include "../util/a_star_grid_3d.h"
+#include "../util/containers/dynamic_bitset.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/containers/std_vector.h"
+#include "../util/thread/mutex.h"
+#include <limits>
+
+namespace zylann::voxel {
+
+// Hierarchical grid A* pathfinding (HPA*), suitable for long paths on blocky terrain.
+// The region is divided into clusters aligned with data blocks. Each cluster caches which of its voxels are solid,
+// and a graph of "portals": positions on its border where agents can enter or leave it, connected by the cost of
+// travelling between them within the cluster. Searches run on the graph of portals first, then get refined into
+// voxel paths within the clusters they go through, so they only visit a small fraction of the voxels flat A* would.
+// Paths may be slightly longer than the shortest ones, because they have to go through portals.
+// Clusters are rebuilt when voxels they depend on get edited, loaded or unloaded.
+class VoxelAStarGrid3DHierarchy : public VoxelData::IEditListener {
+public:
+	struct Params {
+		Box3i region;
+		Vector3f agent_size;
+		int max_fall_height;
+		float max_path_cost;
+	};
+
+	struct Cluster;
+
+	// Generates neighbor positions using the cached solid voxels of a cluster
+	class ClusterGrid : public AStarGrid3D {
+	public:
+		void set_cluster(const Cluster &cluster);
+		bool get_solid(Vector3i pos) const;
+
+	protected:
+		bool is_solid(Vector3i pos) override;
+
+	private:
+		const Cluster *_cluster = nullptr;
+	};
+
+	// Search within a single cluster. It can't leave the cluster's box.
+	struct LocalSearch {
+		static const uint32_t NO_CAME_FROM = std::numeric_limits<uint32_t>::max();
+
+		struct Point {
+			Vector3i position;
+			float gscore;
+			uint32_t came_from_point_index;
+		};
+
+		struct OpenItem {
+			float fscore;
+			uint32_t point_index;
+		};
+
+		StdVector<Point> points;
+		StdUnorderedMap<Vector3i, uint32_t> points_map;
+		StdVector<OpenItem> open_list;
+		StdVector<Vector3i> neighbor_positions;
+
+		// Returns the index of the point at the given position if it was visited, or `NO_CAME_FROM` otherwise.
+		uint32_t find_point(Vector3i pos) const;
+	};
+
+	// State of a search. It can be reused between searches, but not by multiple threads at once.
+	struct SearchContext {
+		static const uint32_t NO_CAME_FROM = std::numeric_limits<uint32_t>::max();
+		static const uint32_t NO_PORTAL = std::numeric_limits<uint32_t>::max();
+
+		struct Node {
+			Vector3i position;
+			uint32_t cluster_index;
+			// Index of the portal within its cluster, or `NO_PORTAL` if the node is the source or destination
+			uint32_t portal_index;
+			float gscore;
+			uint32_t came_from_node_index;
+			bool closed;
+		};
+
+		struct OpenItem {
+			float fscore;
+			uint32_t node_index;
+		};
+
+		StdVector<Node> nodes;
+		StdUnorderedMap<Vector3i, uint32_t> nodes_map;
+		StdVector<OpenItem> open_list;
+		StdVector<uint32_t> node_path;
+		LocalSearch local_search;
+		ClusterGrid grid;
+	};
+
+	struct Cluster {
+		struct Edge {
+			// Destination position. For edges leaving the cluster, it is a portal of the neighbor cluster.
+			Vector3i position;
+			// Index of the destination portal if it is in the same cluster, or `NO_PORTAL` if it leaves the cluster.
+			uint32_t portal_index;
+			float cost;
+		};
+
+		struct Portal {
+			Vector3i position;
+			// Range of outgoing edges in `edges`
+			uint32_t edges_begin;
+			uint32_t edges_end;
+		};
+
+		// Cells of the region belonging to the cluster
+		Box3i box;
+		// Area in which solid voxels are cached. It is larger than the cluster, because checking if an agent can move
+		// to a position also checks voxels around it.
+		Box3i solid_box;
+		// One bit per voxel of `solid_box`, in ZXY order
+		DynamicBitset solid_bits;
+
+		StdVector<Portal> portals;
+		StdVector<Edge> edges;
+		StdUnorderedMap<Vector3i, uint32_t> portals_map;
+	};
+
+	VoxelAStarGrid3DHierarchy(std::shared_ptr<VoxelData> data, const Params &params);
+
+	// Invalidates clusters depending on voxels of the area. This also happens when blocks load or unload, so clusters
+	// built while their area wasn't loaded get rebuilt once it is.
+	void on_area_changed(Box3i voxel_box) override;
+
+	// Builds clusters that are missing or were invalidated, in parallel. Must not run at the same time as searches.
+	void update();
+
+	// Finds a path using clusters as they were at the last update. Follows the same conventions as `AStarGrid3D`:
+	// the path starts with the source position and ends with the position preceding the destination. It is empty if
+	// no path was found.
+	// Can run in multiple threads at once, each with its own context.
+	void find_path(
+			Vector3i from_position,
+			Vector3i to_position,
+			SearchContext &ctx,
+			StdVector<Vector3i> &out_path
+	) const;
+
+	inline const Params &get_params() const {
+		return _params;
+	}
+
+	unsigned int debug_get_portal_count() const;
+
+private:
+	void build_cluster(Cluster &cluster, ClusterGrid &grid, LocalSearch &local_search) const;
+
+	bool search_in_cluster(
+			const Cluster &cluster,
+			Vector3i from_position,
+			const Vector3i *to_position,
+			ClusterGrid &grid,
+			LocalSearch &ls
+	) const;
+
+	bool append_local_path(
+			const Cluster &cluster,
+			Vector3i from_position,
+			Vector3i to_position,
+			ClusterGrid &grid,
+			LocalSearch &ls,
+			StdVector<Vector3i> &out_path
+	) const;
+
+	uint32_t get_cluster_index(Vector3i voxel_pos) const;
+
+	std::shared_ptr<VoxelData> _data;
+	Params _params;
+	unsigned int _block_size_po2;
+	// How far around clusters solid voxels are cached
+	int _solid_padding;
+
+	// Region covered by clusters, in blocks
+	Box3i _clusters_box;
+	StdVector<Cluster> _clusters;
+
+	DynamicBitset _dirty_clusters;
+	bool _has_dirty_clusters = true;
+	BinaryMutex _dirty_clusters_mutex;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_A_STAR_GRID_3D_HIERARCHY_H
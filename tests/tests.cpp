@@ -4,17 +4,21 @@
 
 #include "util/test_box3i.h"
 #include "util/test_container_funcs.h"
+#include "util/test_dynamic_aabb_tree.h"
 #include "util/test_expression_parser.h"
 #include "util/test_flat_map.h"
 #include "util/test_island_finder.h"
 #include "util/test_math_funcs.h"
+#include "util/test_range_allocator.h"
 #include "util/test_slot_map.h"
 #include "util/test_spatial_lock.h"
 #include "util/test_string_funcs.h"
 #include "util/test_threaded_task_runner.h"
+#include "util/test_voxel_raycast.h"
 
 #include "voxel/test_block_serializer.h"
 #include "voxel/test_curve_range.h"
+#include "voxel/test_detail_rendering_cpu.h"
 #include "voxel/test_detail_rendering_gpu.h"
 #include "voxel/test_edition_funcs.h"
 #include "voxel/test_mesh_sdf.h"
@@ -22,11 +26,18 @@
 #include "voxel/test_region_file.h"
 #include "voxel/test_storage_funcs.h"
 #include "voxel/test_stream_sqlite.h"
+#include "voxel/test_vox_data.h"
+#include "voxel/test_voxel_a_star_grid_3d.h"
+#include "voxel/test_voxel_blocky_library.h"
+#include "voxel/test_voxel_box_mover.h"
 #include "voxel/test_voxel_buffer.h"
 #include "voxel/test_voxel_data_map.h"
+#include "voxel/test_voxel_edit_journal.h"
+#include "voxel/test_voxel_generator_multipass.h"
 #include "voxel/test_voxel_graph.h"
 #include "voxel/test_voxel_instancer.h"
 #include "voxel/test_voxel_mesher_cubes.h"
+#include "voxel/test_voxel_terrain_async_edits.h"
 
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 #include "fast_noise_2/test_fast_noise_2.h"
@@ -91,8 +102,12 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_voxel_graph_non_square_image);
 	VOXEL_TEST(test_voxel_graph_4_default_weights);
 	VOXEL_TEST(test_island_finder);
+	VOXEL_TEST(test_island_finder_many_islands);
+	VOXEL_TEST(test_voxel_raycast_hierarchical);
 	VOXEL_TEST(test_unordered_remove_if);
 	VOXEL_TEST(test_instance_data_serialization);
+	VOXEL_TEST(test_instance_data_decode_to_multimesh_buffer);
+	VOXEL_TEST(test_voxel_instance_generator);
 	VOXEL_TEST(test_transform_3d_array_zxy);
 	VOXEL_TEST(test_octree_update);
 	VOXEL_TEST(test_octree_find_in_box);
@@ -100,6 +115,9 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_voxel_buffer_create);
 	VOXEL_TEST(test_block_serializer);
 	VOXEL_TEST(test_block_serializer_stream_peer);
+	VOXEL_TEST(test_block_serializer_diff);
+	VOXEL_TEST(test_voxel_edit_journal);
+	VOXEL_TEST(test_voxel_terrain_async_edits);
 	VOXEL_TEST(test_region_file);
 	VOXEL_TEST(test_voxel_stream_region_files);
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
@@ -107,30 +125,64 @@ void run_voxel_tests() {
 	VOXEL_TEST(test_fast_noise_2_empty_encoded_node_tree);
 #endif
 	VOXEL_TEST(test_run_blocky_random_tick);
+	VOXEL_TEST(test_run_blocky_random_tick_per_block);
 	VOXEL_TEST(test_flat_map);
 	VOXEL_TEST(test_expression_parser);
 	VOXEL_TEST(test_voxel_buffer_metadata);
 	VOXEL_TEST(test_voxel_buffer_metadata_gd);
+	VOXEL_TEST(test_voxel_buffer_metadata_area);
 	VOXEL_TEST(test_voxel_mesher_cubes);
+	VOXEL_TEST(test_voxel_mesher_cubes_greedy);
 	VOXEL_TEST(test_threaded_task_runner_misc);
 	VOXEL_TEST(test_threaded_task_runner_debug_names);
 	VOXEL_TEST(test_task_priority_values);
 	VOXEL_TEST(test_voxel_mesh_sdf_issue463);
+	VOXEL_TEST(test_voxel_mesh_sdf_bvh);
 	VOXEL_TEST(test_normalmap_render_gpu);
+	VOXEL_TEST(test_detail_rendering_cpu_batched);
 	VOXEL_TEST(test_slot_map);
+	VOXEL_TEST(test_dynamic_aabb_tree);
+	VOXEL_TEST(test_range_allocator);
 	VOXEL_TEST(test_box_blur);
+	VOXEL_TEST(test_box_blur_changed_box);
+	VOXEL_TEST(test_grow_sphere);
 	VOXEL_TEST(test_threaded_task_postponing);
 	VOXEL_TEST(test_spatial_lock_misc);
 	VOXEL_TEST(test_spatial_lock_spam);
 	VOXEL_TEST(test_spatial_lock_dependent_map_chunks);
+	VOXEL_TEST(test_voxel_generator_multipass_cb_threads);
+	VOXEL_TEST(test_voxel_generator_multipass_persistent_cache);
 	VOXEL_TEST(test_discord_soakil_copypaste);
 	VOXEL_TEST(test_voxel_stream_sqlite_key_string_csd_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_key_blob80_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_basic);
 	VOXEL_TEST(test_voxel_stream_sqlite_coordinate_format);
 	VOXEL_TEST(test_sdf_hemisphere);
+	VOXEL_TEST(test_voxel_box_mover_full_cubes);
+	VOXEL_TEST(test_voxel_box_mover_batch);
+	VOXEL_TEST(test_voxel_a_star_grid_3d_hierarchy);
+	VOXEL_TEST(test_vox_data_load);
+	VOXEL_TEST(test_voxel_blocky_library_rebake);
+	VOXEL_TEST(test_voxel_blocky_library_mesh_rebake);
+	VOXEL_TEST(test_voxel_blocky_type_library_rebake);
+	VOXEL_TEST(test_voxel_blocky_library_cache);
+	VOXEL_TEST(test_voxel_blocky_library_flat_baked_data);
+	VOXEL_TEST(test_voxel_blocky_library_flat_meshing);
 
 	print_line("------------ Voxel tests end -------------");
 }
 
+// Benchmarks only print timings, correctness is checked by tests. They take longer, so they don't run with tests.
+void run_voxel_benchmarks() {
+	print_line("------------ Voxel benchmarks begin -------------");
+
+	VOXEL_TEST(test_voxel_instance_generator_benchmark);
+	VOXEL_TEST(test_voxel_mesher_cubes_benchmark);
+	VOXEL_TEST(test_voxel_box_mover_benchmark);
+	VOXEL_TEST(test_vox_data_load_benchmark);
+	VOXEL_TEST(test_voxel_blocky_library_flat_meshing_benchmark);
+
+	print_line("------------ Voxel benchmarks end -------------");
+}
+
 } // namespace zylann::voxel::tests
@@ -3,6 +3,7 @@
 
 namespace zylann::voxel::tests {
 void run_voxel_tests();
+void run_voxel_benchmarks();
 } // namespace zylann::voxel::tests
 
 namespace zylann::voxel::noise_tests {
@@ -0,0 +1,92 @@
+#include "test_dynamic_aabb_tree.h"
+#include "../../util/containers/dynamic_aabb_tree.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../testing.h"
+#include <algorithm>
+
+namespace zylann::tests {
+
+void test_dynamic_aabb_tree() {
+	struct Item {
+		AABB aabb;
+		uint32_t tree_id;
+		bool removed;
+	};
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	struct L {
+		static AABB make_random_aabb(RandomPCG &rng) {
+			const Vector3 pos(rng.randf() * 100.0, rng.randf() * 100.0, rng.randf() * 100.0);
+			const Vector3 size(1.0 + rng.randf() * 5.0, 1.0 + rng.randf() * 5.0, 1.0 + rng.randf() * 5.0);
+			return AABB(pos, size);
+		}
+	};
+
+	DynamicAABBTree tree;
+	StdVector<Item> items;
+
+	// Items added in a sorted order are the worst case for a tree without rebalancing
+	const unsigned int sorted_count = 1000;
+	for (unsigned int i = 0; i < sorted_count; ++i) {
+		const AABB aabb(Vector3(i * 2, 0, 0), Vector3(1, 1, 1));
+		items.push_back(Item{ aabb, tree.add(aabb, items.size()), false });
+	}
+	// Height of a balanced binary tree with that many leaves is about log2(1000) = 10
+	ZN_TEST_ASSERT(tree.get_height() < 20);
+
+	for (unsigned int i = 0; i < 1000; ++i) {
+		const AABB aabb = L::make_random_aabb(rng);
+		items.push_back(Item{ aabb, tree.add(aabb, items.size()), false });
+	}
+
+	// Move and remove some items
+	for (unsigned int i = 0; i < items.size(); i += 3) {
+		Item &item = items[i];
+		item.aabb = L::make_random_aabb(rng);
+		tree.set_aabb(item.tree_id, item.aabb);
+	}
+	for (unsigned int i = 0; i < items.size(); i += 5) {
+		Item &item = items[i];
+		tree.remove(item.tree_id);
+		item.removed = true;
+	}
+
+	for (const Item &item : items) {
+		if (!item.removed) {
+			ZN_TEST_ASSERT(tree.get_aabb(item.tree_id) == item.aabb);
+		}
+	}
+
+	// Queries must find the same items as brute force
+	StdVector<uint32_t> found;
+	StdVector<uint32_t> expected;
+	for (unsigned int query_index = 0; query_index < 200; ++query_index) {
+		const AABB query_aabb = L::make_random_aabb(rng).grow(rng.randf() * 10.0);
+
+		found.clear();
+		tree.query(query_aabb, [&found](uint32_t user_data) { found.push_back(user_data); });
+
+		expected.clear();
+		for (unsigned int i = 0; i < items.size(); ++i) {
+			const Item &item = items[i];
+			if (!item.removed && item.aabb.intersects(query_aabb)) {
+				expected.push_back(i);
+			}
+		}
+
+		std::sort(found.begin(), found.end());
+		ZN_TEST_ASSERT(found == expected);
+	}
+
+	for (const Item &item : items) {
+		if (!item.removed) {
+			tree.remove(item.tree_id);
+		}
+	}
+	ZN_TEST_ASSERT(tree.is_empty());
+}
+
+} // namespace zylann::tests
@@ -0,0 +1,10 @@
+#ifndef ZN_TEST_DYNAMIC_AABB_TREE_H
+#define ZN_TEST_DYNAMIC_AABB_TREE_H
+
+namespace zylann::tests {
+
+void test_dynamic_aabb_tree();
+
+} // namespace zylann::tests
+
+#endif // ZN_TEST_DYNAMIC_AABB_TREE_H
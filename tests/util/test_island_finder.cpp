@@ -84,4 +84,49 @@ void test_island_finder() {
 	ZN_TEST_ASSERT(label_count == 3);
 }
 
+void test_island_finder_many_islands() {
+	// More islands than `IslandFinder` supports, spread across several blocks.
+	// Single cells on every even coordinate, and a bar along Z crossing all blocks in between.
+	const Vector3i grid_size(24, 24, 24);
+	const unsigned int block_size = 8;
+
+	auto is_solid = [](Vector3i pos) {
+		return (pos.x % 2 == 0 && pos.y % 2 == 0 && pos.z % 2 == 0) || (pos.x == 1 && pos.y == 1);
+	};
+	const unsigned int expected_count = (grid_size.x / 2) * (grid_size.y / 2) * (grid_size.z / 2) + 1;
+
+	StdVector<uint32_t> output;
+	output.resize(Vector3iUtil::get_volume(grid_size));
+
+	BlockIslandFinder island_finder;
+	const unsigned int label_count = island_finder.scan_3d(grid_size, block_size, is_solid, to_span(output));
+
+	ZN_TEST_ASSERT(label_count == expected_count);
+
+	const uint32_t bar_label = output[Vector3iUtil::get_zxy_index(Vector3i(1, 1, 0), grid_size)];
+	StdVector<uint8_t> label_seen;
+	label_seen.resize(label_count + 1, 0);
+
+	Vector3i pos;
+	for (pos.z = 0; pos.z < grid_size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < grid_size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < grid_size.y; ++pos.y) {
+				const uint32_t label = output[Vector3iUtil::get_zxy_index(pos, grid_size)];
+				if (!is_solid(pos)) {
+					ZN_TEST_ASSERT(label == 0);
+					continue;
+				}
+				ZN_TEST_ASSERT(label >= 1 && label <= label_count);
+				if (pos.x == 1 && pos.y == 1) {
+					ZN_TEST_ASSERT_MSG(label == bar_label, "Island crossing blocks must have a single label");
+				} else {
+					ZN_TEST_ASSERT_MSG(label_seen[label] == 0, "Isolated cells must have distinct labels");
+					label_seen[label] = 1;
+				}
+			}
+		}
+	}
+	ZN_TEST_ASSERT(label_seen[bar_label] == 0);
+}
+
 } // namespace zylann::tests
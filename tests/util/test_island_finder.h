@@ -4,6 +4,7 @@
 namespace zylann::tests {
 
 void test_island_finder();
+void test_island_finder_many_islands();
 
 } // namespace zylann::tests
 
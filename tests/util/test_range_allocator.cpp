@@ -0,0 +1,94 @@
+#include "test_range_allocator.h"
+#include "../../util/containers/range_allocator.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../testing.h"
+
+namespace zylann::tests {
+
+void test_range_allocator() {
+	struct Allocation {
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	{
+		RangeAllocator allocator(10);
+		const uint32_t a = allocator.allocate(4);
+		const uint32_t b = allocator.allocate(4);
+		ZN_TEST_ASSERT(a == 0);
+		ZN_TEST_ASSERT(b == 4);
+		ZN_TEST_ASSERT(allocator.allocate(4) == RangeAllocator::INVALID_OFFSET);
+		ZN_TEST_ASSERT(allocator.get_used_end() == 8);
+
+		// Freeing the first range leaves a hole that can be reused
+		allocator.free(a, 4);
+		ZN_TEST_ASSERT(allocator.get_used_end() == 8);
+		ZN_TEST_ASSERT(allocator.allocate(3) == 0);
+
+		// Growing extends the free range at the end
+		allocator.grow(16);
+		ZN_TEST_ASSERT(allocator.get_free_range_count() == 2);
+		ZN_TEST_ASSERT(allocator.allocate(8) == 8);
+
+		// Freeing everything merges all ranges back into one
+		allocator.free(0, 3);
+		allocator.free(8, 8);
+		allocator.free(b, 4);
+		ZN_TEST_ASSERT(allocator.get_free_range_count() == 1);
+		ZN_TEST_ASSERT(allocator.get_used_size() == 0);
+		ZN_TEST_ASSERT(allocator.get_used_end() == 0);
+	}
+	{
+		// Random allocations and frees, checked against a list of used slots
+		RandomPCG rng;
+		rng.seed(131183);
+
+		RangeAllocator allocator(64);
+		StdVector<Allocation> allocations;
+		StdVector<uint8_t> used_slots;
+		used_slots.resize(allocator.get_capacity(), 0);
+
+		for (unsigned int iteration = 0; iteration < 10000; ++iteration) {
+			if (allocations.size() > 0 && rng.rand() % 3 == 0) {
+				const unsigned int i = rng.rand() % allocations.size();
+				const Allocation a = allocations[i];
+				allocator.free(a.offset, a.size);
+				for (uint32_t j = a.offset; j < a.offset + a.size; ++j) {
+					used_slots[j] = 0;
+				}
+				allocations[i] = allocations.back();
+				allocations.pop_back();
+
+			} else {
+				const uint32_t size = 1 + rng.rand() % 16;
+				uint32_t offset = allocator.allocate(size);
+				if (offset == RangeAllocator::INVALID_OFFSET) {
+					allocator.grow(allocator.get_capacity() * 2);
+					used_slots.resize(allocator.get_capacity(), 0);
+					offset = allocator.allocate(size);
+					ZN_TEST_ASSERT(offset != RangeAllocator::INVALID_OFFSET);
+				}
+				ZN_TEST_ASSERT(offset + size <= allocator.get_capacity());
+				for (uint32_t j = offset; j < offset + size; ++j) {
+					ZN_TEST_ASSERT(used_slots[j] == 0);
+					used_slots[j] = 1;
+				}
+				allocations.push_back(Allocation{ offset, size });
+			}
+
+			uint32_t used_size = 0;
+			uint32_t used_end = 0;
+			for (uint32_t j = 0; j < used_slots.size(); ++j) {
+				if (used_slots[j] != 0) {
+					++used_size;
+					used_end = j + 1;
+				}
+			}
+			ZN_TEST_ASSERT(allocator.get_used_size() == used_size);
+			ZN_TEST_ASSERT(allocator.get_used_end() == used_end);
+		}
+	}
+}
+
+} // namespace zylann::tests
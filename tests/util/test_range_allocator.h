@@ -0,0 +1,10 @@
+#ifndef ZN_TEST_RANGE_ALLOCATOR_H
+#define ZN_TEST_RANGE_ALLOCATOR_H
+
+namespace zylann::tests {
+
+void test_range_allocator();
+
+} // namespace zylann::tests
+
+#endif // ZN_TEST_RANGE_ALLOCATOR_H
@@ -0,0 +1,112 @@
+#include "test_voxel_raycast.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../../util/hash_funcs.h"
+#include "../../util/voxel_raycast.h"
+#include "../testing.h"
+
+namespace zylann::tests {
+
+void test_voxel_raycast_hierarchical() {
+	// Hierarchical raycasts should hit the same cells as regular raycasts, while skipping blocks that can't be hit.
+
+	struct L {
+		static const unsigned int BLOCK_SIZE_PO2 = 3;
+
+		static bool is_block_empty(Vector3i bpos) {
+			return (hash_murmur3_one_32(bpos.x, hash_murmur3_one_32(bpos.y, hash_murmur3_one_32(bpos.z))) % 3) != 0;
+		}
+
+		static bool is_cell_solid(Vector3i pos) {
+			if (is_block_empty(pos >> BLOCK_SIZE_PO2)) {
+				return false;
+			}
+			return (hash_murmur3_one_32(pos.x, hash_murmur3_one_32(pos.y, hash_murmur3_one_32(pos.z))) % 8) == 0;
+		}
+
+		static float randf_range(RandomPCG &rng, float min_value, float max_value) {
+			return min_value + rng.randf() * (max_value - min_value);
+		}
+	};
+
+	auto cell_predicate = [](const VoxelRaycastState &rs) { //
+		return L::is_cell_solid(rs.hit_position);
+	};
+
+	unsigned int skipped_block_count = 0;
+	auto block_predicate = [&skipped_block_count](Vector3i bpos) {
+		if (L::is_block_empty(bpos)) {
+			++skipped_block_count;
+			return false;
+		}
+		return true;
+	};
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	const float max_distance = 40.f;
+	unsigned int hit_count = 0;
+
+	for (unsigned int i = 0; i < 1000; ++i) {
+		const Vector3 origin(
+				L::randf_range(rng, -20.f, 20.f), L::randf_range(rng, -20.f, 20.f), L::randf_range(rng, -20.f, 20.f)
+		);
+		Vector3 direction(
+				L::randf_range(rng, -1.f, 1.f), L::randf_range(rng, -1.f, 1.f), L::randf_range(rng, -1.f, 1.f)
+		);
+		if (direction.length_squared() < 0.0001f) {
+			continue;
+		}
+		direction.normalize();
+
+		Vector3i expected_hit_pos;
+		Vector3i expected_prev_pos;
+		float expected_distance;
+		float expected_distance_prev;
+		const bool expected_hit = voxel_raycast(
+				origin,
+				direction,
+				cell_predicate,
+				max_distance,
+				expected_hit_pos,
+				expected_prev_pos,
+				expected_distance,
+				expected_distance_prev
+		);
+
+		Vector3i hit_pos;
+		Vector3i prev_pos;
+		float distance;
+		float distance_prev;
+		const bool hit = voxel_raycast_hierarchical(
+				origin,
+				direction,
+				L::BLOCK_SIZE_PO2,
+				block_predicate,
+				cell_predicate,
+				max_distance,
+				hit_pos,
+				prev_pos,
+				distance,
+				distance_prev
+		);
+
+		ZN_TEST_ASSERT(hit == expected_hit);
+
+		if (hit) {
+			++hit_count;
+			// Cells may differ when the ray passes exactly through an edge, but the distance would still be the same
+			ZN_TEST_ASSERT(Math::abs(distance - expected_distance) < 0.01f);
+			if (hit_pos == expected_hit_pos) {
+				ZN_TEST_ASSERT(prev_pos == expected_prev_pos);
+				ZN_TEST_ASSERT(Math::abs(distance_prev - expected_distance_prev) < 0.01f);
+			}
+		}
+	}
+
+	// Make sure the test actually covers both cases
+	ZN_TEST_ASSERT(hit_count > 0);
+	ZN_TEST_ASSERT(skipped_block_count > 0);
+}
+
+} // namespace zylann::tests
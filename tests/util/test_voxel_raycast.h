@@ -0,0 +1,10 @@
+#ifndef ZN_TESTS_VOXEL_RAYCAST_H
+#define ZN_TESTS_VOXEL_RAYCAST_H
+
+namespace zylann::tests {
+
+void test_voxel_raycast_hierarchical();
+
+} // namespace zylann::tests
+
+#endif // ZN_TESTS_VOXEL_RAYCAST_H
@@ -3,6 +3,8 @@
 #include "../../streams/voxel_block_serializer.h"
 #include "../../streams/voxel_block_serializer_gd.h"
 #include "../../util/godot/classes/stream_peer_buffer.h"
+#include "../../util/math/funcs.h"
+#include "../../util/math/vector3f.h"
 #include "../testing.h"
 
 namespace zylann::voxel::tests {
@@ -81,4 +83,105 @@ void test_block_serializer_stream_peer() {
 	ZN_TEST_ASSERT(voxel_buffer2->get_buffer().equals(voxel_buffer->get_buffer()));
 }
 
+void test_block_serializer_diff() {
+	// Simulates a server sending edits of a block to a client, comparing how many bytes are sent using diffs versus
+	// whole blocks.
+
+	const int block_size = 16;
+	const unsigned int sdf_channel = VoxelBuffer::CHANNEL_SDF;
+
+	VoxelBuffer server_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	server_voxels.create(Vector3iUtil::create(block_size));
+	server_voxels.set_channel_depth(sdf_channel, VoxelBuffer::DEPTH_16_BIT);
+	// Slope
+	for (int z = 0; z < block_size; ++z) {
+		for (int x = 0; x < block_size; ++x) {
+			for (int y = 0; y < block_size; ++y) {
+				server_voxels.set_voxel_f(0.5f * (y - 8) + 0.1f * x - 0.05f * z, x, y, z, sdf_channel);
+			}
+		}
+	}
+
+	// The client received the whole block first
+	VoxelBuffer client_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	{
+		BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(server_voxels);
+		ZN_TEST_ASSERT(result.success);
+		ZN_TEST_ASSERT(BlockSerializer::decompress_and_deserialize(to_span(result.data), client_voxels));
+	}
+
+	VoxelBuffer baseline(VoxelBuffer::ALLOCATOR_DEFAULT);
+	server_voxels.copy_to(baseline, true);
+
+	const unsigned int edit_count = 20;
+	size_t total_full_size = 0;
+	size_t total_diff_size = 0;
+
+	for (unsigned int edit_index = 0; edit_index < edit_count; ++edit_index) {
+		// Dig a small sphere, like a player would do
+		const Vector3f center(3 + (edit_index * 5) % 10, 6 + edit_index % 4, 3 + (edit_index * 3) % 10);
+		const float radius = 2.5f;
+		for (int z = 0; z < block_size; ++z) {
+			for (int x = 0; x < block_size; ++x) {
+				for (int y = 0; y < block_size; ++y) {
+					const float d = math::length(Vector3f(x, y, z) - center) - radius;
+					const float v0 = server_voxels.get_voxel_f(x, y, z, sdf_channel);
+					server_voxels.set_voxel_f(math::max(v0, -d), x, y, z, sdf_channel);
+				}
+			}
+		}
+
+		{
+			BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(server_voxels);
+			ZN_TEST_ASSERT(result.success);
+			total_full_size += result.data.size();
+		}
+
+		{
+			BlockSerializer::SerializeResult result =
+					BlockSerializer::serialize_diff_and_compress(baseline, server_voxels);
+			ZN_TEST_ASSERT(result.success);
+			total_diff_size += result.data.size();
+
+			ZN_TEST_ASSERT(BlockSerializer::decompress_and_apply_diff(to_span(result.data), client_voxels));
+		}
+
+		server_voxels.copy_to(baseline, true);
+
+		server_voxels.compress_uniform_channels();
+		ZN_TEST_ASSERT(client_voxels.equals(server_voxels));
+	}
+
+	// Applying the same diff twice must not change the result
+	{
+		VoxelBuffer old_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+		old_voxels.create(Vector3iUtil::create(block_size));
+		old_voxels.set_channel_depth(sdf_channel, VoxelBuffer::DEPTH_16_BIT);
+
+		BlockSerializer::SerializeResult result =
+				BlockSerializer::serialize_diff_and_compress(old_voxels, server_voxels);
+		ZN_TEST_ASSERT(result.success);
+		const StdVector<uint8_t> diff_data = result.data;
+
+		ZN_TEST_ASSERT(BlockSerializer::decompress_and_apply_diff(to_span(diff_data), old_voxels));
+		ZN_TEST_ASSERT(BlockSerializer::decompress_and_apply_diff(to_span(diff_data), old_voxels));
+		old_voxels.compress_uniform_channels();
+		ZN_TEST_ASSERT(old_voxels.equals(server_voxels));
+	}
+
+	// Diffs can't be used if metadata changed
+	{
+		VoxelBuffer edited_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+		server_voxels.copy_to(edited_voxels, true);
+		edited_voxels.get_or_create_voxel_metadata(Vector3i(1, 2, 3))->set_u64(42);
+		BlockSerializer::SerializeResult result =
+				BlockSerializer::serialize_diff_and_compress(server_voxels, edited_voxels);
+		ZN_TEST_ASSERT(result.success == false);
+	}
+
+	print_line(String("Bytes per edit: whole block {0}, diff {1}")
+					   .format(varray(int64_t(total_full_size / edit_count), int64_t(total_diff_size / edit_count))));
+	ZN_TEST_ASSERT(total_diff_size < total_full_size);
+}
+
 } // namespace zylann::voxel::tests
@@ -5,6 +5,7 @@ namespace zylann::voxel::tests {
 
 void test_block_serializer();
 void test_block_serializer_stream_peer();
+void test_block_serializer_diff();
 
 } // namespace zylann::voxel::tests
 
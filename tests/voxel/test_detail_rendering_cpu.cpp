@@ -0,0 +1,158 @@
+#include "test_detail_rendering_cpu.h"
+#include "../../engine/detail_rendering/detail_rendering.h"
+#include "../../generators/graph/voxel_generator_graph.h"
+#include "../../meshers/transvoxel/transvoxel_cell_iterator.h"
+#include "../../meshers/transvoxel/voxel_mesher_transvoxel.h"
+#include "../../util/containers/container_funcs.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+// Yields a single cell, to render tiles one by one like the CPU path used to
+class SingleCellIterator : public ICellIterator {
+public:
+	SingleCellIterator(const CurrentCellInfo &cell) : _cell(cell) {}
+
+	unsigned int get_count() const override {
+		return 1;
+	}
+
+	bool next(CurrentCellInfo &current) override {
+		if (_done) {
+			return false;
+		}
+		current = _cell;
+		_done = true;
+		return true;
+	}
+
+	void rewind() override {
+		_done = false;
+	}
+
+private:
+	CurrentCellInfo _cell;
+	bool _done = false;
+};
+
+} // namespace
+
+void test_detail_rendering_cpu_batched() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	{
+		pg::VoxelGraphFunction &g = **generator->get_main_function();
+
+		// Wavy plane
+		// X --- Sin1 --- Add1 --- Add2 --- Add3 --- OutSDF
+		//               /        /       /
+		//     Z --- Sin2        Y     -1.5
+		//
+		const uint32_t n_x = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_X, Vector2());
+		const uint32_t n_y = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+		const uint32_t n_z = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+		const uint32_t n_add1 = g.create_node(pg::VoxelGraphFunction::NODE_ADD, Vector2());
+		const uint32_t n_add2 = g.create_node(pg::VoxelGraphFunction::NODE_ADD, Vector2());
+		const uint32_t n_add3 = g.create_node(pg::VoxelGraphFunction::NODE_ADD, Vector2());
+		const uint32_t n_sin1 = g.create_node(pg::VoxelGraphFunction::NODE_SIN, Vector2());
+		const uint32_t n_sin2 = g.create_node(pg::VoxelGraphFunction::NODE_SIN, Vector2());
+		const uint32_t n_out_sd = g.create_node(pg::VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+		g.add_connection(n_x, 0, n_sin1, 0);
+		g.add_connection(n_z, 0, n_sin2, 0);
+		g.add_connection(n_sin1, 0, n_add1, 0);
+		g.add_connection(n_sin2, 0, n_add1, 1);
+		g.add_connection(n_add1, 0, n_add2, 0);
+		g.add_connection(n_y, 0, n_add2, 1);
+		g.add_connection(n_add2, 0, n_add3, 0);
+		g.set_node_default_input(n_add3, 1, -1.5f);
+		g.add_connection(n_add3, 0, n_out_sd, 0);
+
+		pg::CompilationResult result = generator->compile(false);
+		ZN_TEST_ASSERT(result.success);
+	}
+
+	Ref<VoxelMesherTransvoxel> mesher;
+	mesher.instantiate();
+
+	const int block_size = 16;
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels.create(Vector3iUtil::create(block_size + mesher->get_minimum_padding() + mesher->get_maximum_padding()));
+
+	const Vector3i origin_in_voxels;
+	const uint8_t lod_index = 0;
+	generator->generate_block(VoxelGenerator::VoxelQueryData{ voxels, origin_in_voxels, 0 });
+
+	const VoxelMesher::Input mesher_input{ voxels, generator.ptr(), origin_in_voxels, lod_index, false, false, true };
+	VoxelMesher::Output mesher_output;
+	mesher->build(mesher_output, mesher_input);
+	ZN_TEST_ASSERT(!VoxelMesher::is_mesh_empty(mesher_output.surfaces));
+
+	// Copy mesh data out of the mesher's thread-local cache
+	const transvoxel::MeshArrays &mesh_arrays = VoxelMesherTransvoxel::get_mesh_cache_from_current_thread();
+	StdVector<Vector3f> mesh_vertices;
+	StdVector<Vector3f> mesh_normals;
+	StdVector<int> mesh_indices;
+	append_array(mesh_vertices, mesh_arrays.vertices);
+	append_array(mesh_normals, mesh_arrays.normals);
+	append_array(mesh_indices, mesh_arrays.indices);
+	TransvoxelCellIterator cell_iterator(VoxelMesherTransvoxel::get_cell_info_from_current_thread());
+	ZN_TEST_ASSERT(cell_iterator.get_count() > 1);
+
+	const unsigned int tile_resolution = 8;
+	const float max_deviation_radians = math::deg_to_rad(60.f);
+
+	auto compute = [&](ICellIterator &it, DetailTextureData &data) {
+		compute_detail_texture_data(
+				it,
+				to_span(mesh_vertices),
+				to_span(mesh_normals),
+				to_span(mesh_indices),
+				data,
+				tile_resolution,
+				**generator,
+				nullptr,
+				origin_in_voxels,
+				voxels.get_size(),
+				lod_index,
+				false,
+				max_deviation_radians,
+				false
+		);
+	};
+
+	// All tiles of the block, which queries the generator with one series
+	DetailTextureData batched_data;
+	compute(cell_iterator, batched_data);
+	ZN_TEST_ASSERT(batched_data.tiles.size() == cell_iterator.get_count());
+
+	// Same tiles rendered one at a time
+	const unsigned int tile_normals_size = math::squared(tile_resolution) * 3;
+	ZN_TEST_ASSERT(batched_data.normals.size() == batched_data.tiles.size() * tile_normals_size);
+
+	cell_iterator.rewind();
+	CurrentCellInfo cell_info;
+	for (unsigned int tile_index = 0; cell_iterator.next(cell_info); ++tile_index) {
+		SingleCellIterator single_cell_iterator(cell_info);
+		DetailTextureData tile_data;
+		compute(single_cell_iterator, tile_data);
+
+		ZN_TEST_ASSERT(tile_data.tiles.size() == 1);
+		const DetailTextureData::Tile &expected_tile = batched_data.tiles[tile_index];
+		const DetailTextureData::Tile &tile = tile_data.tiles[0];
+		ZN_TEST_ASSERT(tile.x == expected_tile.x);
+		ZN_TEST_ASSERT(tile.y == expected_tile.y);
+		ZN_TEST_ASSERT(tile.z == expected_tile.z);
+		ZN_TEST_ASSERT(tile.axis == expected_tile.axis);
+
+		ZN_TEST_ASSERT(tile_data.normals.size() == tile_normals_size);
+		for (unsigned int i = 0; i < tile_normals_size; ++i) {
+			const int expected = batched_data.normals[tile_index * tile_normals_size + i];
+			// Allow rounding differences, the generator may pick different optimizations depending on the area
+			ZN_TEST_ASSERT(Math::abs(tile_data.normals[i] - expected) <= 1);
+		}
+	}
+}
+
+} // namespace zylann::voxel::tests
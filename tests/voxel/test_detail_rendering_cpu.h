@@ -0,0 +1,10 @@
+#ifndef VOXEL_TEST_DETAIL_RENDERING_CPU_H
+#define VOXEL_TEST_DETAIL_RENDERING_CPU_H
+
+namespace zylann::voxel::tests {
+
+void test_detail_rendering_cpu_batched();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_DETAIL_RENDERING_CPU_H
@@ -1,4 +1,5 @@
 #include "test_edition_funcs.h"
+#include "../../constants/voxel_constants.h"
 #include "../../edition/funcs.h"
 #include "../../edition/voxel_tool_terrain.h"
 #include "../../generators/graph/voxel_generator_graph.h"
@@ -134,6 +135,112 @@ void test_run_blocky_random_tick() {
 	}
 }
 
+void test_run_blocky_random_tick_per_block() {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	{
+		Ref<VoxelBlockyModelMesh> air;
+		air.instantiate();
+		library->add_model(air);
+	}
+	{
+		Ref<VoxelBlockyModelCube> non_tickable;
+		non_tickable.instantiate();
+		library->add_model(non_tickable);
+	}
+	int tickable_id = -1;
+	{
+		Ref<VoxelBlockyModel> tickable;
+		tickable.instantiate();
+		tickable->set_random_tickable(true);
+		tickable_id = library->add_model(tickable);
+	}
+	library->bake();
+
+	// Blocks with negative X are uniform air, others contain a mix of all models
+	VoxelData data;
+	// Bounds as large as a volume can be, to check that areas spanning the whole world are handled
+	data.set_bounds(
+			Box3i(Vector3iUtil::create(-constants::MAX_VOLUME_EXTENT), Vector3iUtil::create(constants::MAX_VOLUME_SIZE))
+	);
+	const int block_size = data.get_block_size();
+	const Box3i world_blocks_box(-4, -4, -4, 8, 8, 8);
+	world_blocks_box.for_each_cell_zxy([&data, block_size](Vector3i block_pos) {
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+		if (block_pos.x >= 0) {
+			for (int z = 0; z < block_size; ++z) {
+				for (int x = 0; x < block_size; ++x) {
+					for (int y = 0; y < block_size; ++y) {
+						buffer->set_voxel((x + y + z) % 3, x, y, z, VoxelBuffer::CHANNEL_TYPE);
+					}
+				}
+			}
+		}
+		VoxelDataBlock block(buffer, 0);
+		block.set_edited(true);
+		ZN_TEST_ASSERT(data.try_set_block(block_pos, block));
+	});
+
+	const Box3i voxel_box(Vector3i(-40, -23, -22), Vector3i(90, 40, 40));
+	const unsigned int voxels_per_block = 32;
+	const uint64_t seed = 131183;
+
+	StdVector<Vector3i> positions;
+	StdVector<uint32_t> values;
+	run_blocky_random_tick_per_block(data, voxel_box, **library, seed, voxels_per_block, positions, values);
+
+	ZN_TEST_ASSERT(positions.size() == values.size());
+	ZN_TEST_ASSERT_MSG(positions.size() > 0, "At least one hit is expected, not none");
+
+	Box3i pick_box(positions[0], Vector3i(1, 1, 1));
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		const Vector3i pos = positions[i];
+		ZN_TEST_ASSERT(voxel_box.contains(pos));
+		ZN_TEST_ASSERT(pos.x >= 0);
+		ZN_TEST_ASSERT(int(values[i]) == tickable_id);
+		ZN_TEST_ASSERT(data.get_voxel(pos, VoxelBuffer::CHANNEL_TYPE, VoxelSingleValue()).i == values[i]);
+		pick_box.merge_with(Box3i(pos, Vector3i(1, 1, 1)));
+	}
+
+	// Every block of the area gets sampled, so picks should reach the sides of the area that contain tickable voxels.
+	// There is randomness at play, so we allow a small margin.
+	const Box3i tickable_box = voxel_box.clipped(Box3i::from_min_max(Vector3i(), voxel_box.position + voxel_box.size));
+	const int error_margin = 2;
+	for (int axis_index = 0; axis_index < Vector3iUtil::AXIS_COUNT; ++axis_index) {
+		const int nd = pick_box.position[axis_index] - tickable_box.position[axis_index];
+		const int pd = pick_box.position[axis_index] + pick_box.size[axis_index] -
+				(tickable_box.position[axis_index] + tickable_box.size[axis_index]);
+		ZN_TEST_ASSERT(Math::abs(nd) <= error_margin);
+		ZN_TEST_ASSERT(Math::abs(pd) <= error_margin);
+	}
+
+	// Results only depend on the seed, not on how blocks were distributed on threads
+	StdVector<Vector3i> positions2;
+	StdVector<uint32_t> values2;
+	run_blocky_random_tick_per_block(data, voxel_box, **library, seed, voxels_per_block, positions2, values2);
+	ZN_TEST_ASSERT(positions == positions2);
+	ZN_TEST_ASSERT(values == values2);
+
+	// An area covering the whole world is much larger than what is loaded. Only loaded blocks should get sampled, and
+	// the amount of work should not depend on the size of the area.
+	StdVector<Vector3i> positions3;
+	StdVector<uint32_t> values3;
+	// Volumes larger than what 32-bit integers can hold
+	ZN_TEST_ASSERT(Vector3iUtil::get_volume(Vector3iUtil::create(2048)) == int64_t(1) << 33);
+	StdVector<Vector3i> loaded_blocks;
+	data.get_loaded_blocks(data.get_bounds().downscaled(block_size), 0, loaded_blocks);
+	ZN_TEST_ASSERT(int64_t(loaded_blocks.size()) == Vector3iUtil::get_volume(world_blocks_box.size));
+	run_blocky_random_tick_per_block(data, data.get_bounds(), **library, seed, voxels_per_block, positions3, values3);
+	ZN_TEST_ASSERT(positions3.size() == values3.size());
+	ZN_TEST_ASSERT(positions3.size() > 0);
+	const Box3i world_voxel_box(world_blocks_box.position * block_size, world_blocks_box.size * block_size);
+	for (unsigned int i = 0; i < positions3.size(); ++i) {
+		ZN_TEST_ASSERT(world_voxel_box.contains(positions3[i]));
+		ZN_TEST_ASSERT(int(values3[i]) == tickable_id);
+	}
+}
+
 void test_box_blur() {
 	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
 	voxels.create(64, 64, 64);
@@ -174,6 +281,137 @@ void test_box_blur() {
 	ZN_TEST_ASSERT(sd_equals_approx(voxels_blurred_1, voxels_blurred_2));
 }
 
+void test_box_blur_changed_box() {
+	const int blur_radius = 2;
+
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels.create(40, 40, 40);
+
+	// Uniform voxels don't change when blurred
+	{
+		VoxelBuffer blurred(VoxelBuffer::ALLOCATOR_DEFAULT);
+		Box3i changed_box;
+		ops::box_blur(voxels, blurred, blur_radius, Vector3f(10.f), 8.f, changed_box);
+		ZN_TEST_ASSERT(changed_box.is_empty());
+	}
+
+	Vector3i pos;
+	for (pos.z = 0; pos.z < voxels.get_size().z; ++pos.z) {
+		for (pos.x = 0; pos.x < voxels.get_size().x; ++pos.x) {
+			for (pos.y = 0; pos.y < voxels.get_size().y; ++pos.y) {
+				const float sd = Math::cos(0.53f * pos.x) + Math::sin(0.37f * pos.y) + Math::sin(0.71f * pos.z);
+				voxels.set_voxel_f(sd, pos, VoxelBuffer::CHANNEL_SDF);
+			}
+		}
+	}
+
+	// Sphere covering only part of the area
+	const Vector3f sphere_pos(12.f, 14.f, 16.f);
+	const float sphere_radius = 6.f;
+
+	VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+	ops::box_blur_slow_ref(voxels, expected, blur_radius, sphere_pos, sphere_radius);
+
+	VoxelBuffer blurred(VoxelBuffer::ALLOCATOR_DEFAULT);
+	Box3i changed_box;
+	ops::box_blur(voxels, blurred, blur_radius, sphere_pos, sphere_radius, changed_box);
+
+	ZN_TEST_ASSERT(sd_equals_approx(expected, blurred));
+
+	const Box3i sphere_box = Box3i::from_min_max(
+			to_vec3i(math::floor(sphere_pos - Vector3f(sphere_radius))),
+			to_vec3i(math::ceil(sphere_pos + Vector3f(sphere_radius))) + Vector3i(1, 1, 1)
+	);
+	ZN_TEST_ASSERT(!changed_box.is_empty());
+	ZN_TEST_ASSERT(sphere_box.contains(changed_box));
+
+	// Voxels outside of the changed box must be left untouched
+	for (pos.z = 0; pos.z < blurred.get_size().z; ++pos.z) {
+		for (pos.x = 0; pos.x < blurred.get_size().x; ++pos.x) {
+			for (pos.y = 0; pos.y < blurred.get_size().y; ++pos.y) {
+				if (changed_box.contains(pos)) {
+					continue;
+				}
+				const Vector3i src_pos = pos + Vector3i(blur_radius, blur_radius, blur_radius);
+				ZN_TEST_ASSERT(
+						blurred.get_voxel(pos, VoxelBuffer::CHANNEL_SDF) ==
+						voxels.get_voxel(src_pos, VoxelBuffer::CHANNEL_SDF)
+				);
+			}
+		}
+	}
+}
+
+void test_grow_sphere() {
+	const unsigned int channel = VoxelBuffer::CHANNEL_SDF;
+	const Vector3i size(24, 24, 24);
+
+	// The 16-bit fast path is compared with the generic path, using a 32-bit buffer holding the same values
+	VoxelBuffer voxels_16(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels_16.create(size);
+
+	VoxelBuffer voxels_32(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels_32.set_channel_depth(channel, VoxelBuffer::DEPTH_32_BIT);
+	voxels_32.create(size);
+
+	Vector3i pos;
+	for (pos.z = 0; pos.z < size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < size.y; ++pos.y) {
+				const float sd = Math::cos(0.53f * pos.x) + Math::sin(0.37f * pos.y) + Math::sin(0.71f * pos.z);
+				voxels_16.set_voxel_f(sd, pos, channel);
+				voxels_32.set_voxel_f(voxels_16.get_voxel_f(pos, channel), pos, channel);
+			}
+		}
+	}
+
+	VoxelBuffer original(VoxelBuffer::ALLOCATOR_DEFAULT);
+	voxels_16.copy_to(original, false);
+
+	const Vector3f sphere_pos(10.f, 11.f, 12.f);
+	const float sphere_radius = 5.f;
+	const float strength = 0.5f;
+
+	Box3i changed_box;
+	ops::grow_sphere(voxels_16, strength, sphere_pos, sphere_radius, changed_box);
+	ops::grow_sphere(voxels_32, strength, sphere_pos, sphere_radius);
+
+	const Box3i sphere_box = Box3i::from_min_max(
+			to_vec3i(math::floor(sphere_pos - Vector3f(sphere_radius))),
+			to_vec3i(math::ceil(sphere_pos + Vector3f(sphere_radius))) + Vector3i(1, 1, 1)
+	);
+	ZN_TEST_ASSERT(!changed_box.is_empty());
+	ZN_TEST_ASSERT(sphere_box.contains(changed_box));
+
+	// One quantization step of 16-bit SDF, plus some margin for rounding
+	const float tolerance = 2.f / (constants::QUANTIZED_SDF_16_BITS_SCALE * 32767.f);
+
+	for (pos.z = 0; pos.z < size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < size.y; ++pos.y) {
+				const float sd_16 = voxels_16.get_voxel_f(pos, channel);
+				const float sd_32 = voxels_32.get_voxel_f(pos, channel);
+				ZN_TEST_ASSERT(Math::abs(sd_16 - sd_32) <= tolerance);
+
+				if (!changed_box.contains(pos)) {
+					ZN_TEST_ASSERT(voxels_16.get_voxel(pos, channel) == original.get_voxel(pos, channel));
+				}
+			}
+		}
+	}
+
+	// Growing subtracts the most at the center of the sphere
+	const Vector3i center = to_vec3i(sphere_pos);
+	const float center_offset = original.get_voxel_f(center, channel) - voxels_16.get_voxel_f(center, channel);
+	ZN_TEST_ASSERT(Math::abs(center_offset - strength) <= tolerance);
+
+	// Negative strength shrinks back
+	ops::grow_sphere(voxels_16, -strength, sphere_pos, sphere_radius, changed_box);
+	ZN_TEST_ASSERT(
+			Math::abs(voxels_16.get_voxel_f(center, channel) - original.get_voxel_f(center, channel)) <= tolerance
+	);
+}
+
 void test_discord_soakil_copypaste() {
 	// That was a bug reported on Discord by Soakil.
 	//
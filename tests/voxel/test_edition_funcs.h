@@ -4,7 +4,10 @@
 namespace zylann::voxel::tests {
 
 void test_run_blocky_random_tick();
+void test_run_blocky_random_tick_per_block();
 void test_box_blur();
+void test_box_blur_changed_box();
+void test_grow_sphere();
 void test_discord_soakil_copypaste();
 void test_sdf_hemisphere();
 
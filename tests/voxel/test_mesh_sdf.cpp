@@ -1,5 +1,8 @@
 #include "test_mesh_sdf.h"
+#include "../../edition/mesh_sdf.h"
 #include "../../edition/voxel_mesh_sdf_gd.h"
+#include "../../util/math/conv.h"
+#include "../testing.h"
 
 namespace zylann::voxel::tests {
 
@@ -30,4 +33,68 @@ void test_voxel_mesh_sdf_issue463() {
 	msdf->call("_set_data", d);
 }
 
+void test_voxel_mesh_sdf_bvh() {
+	// Cube from -1 to 1
+	StdVector<Vector3> vertices;
+	for (int i = 0; i < 8; ++i) {
+		vertices.push_back(Vector3((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1));
+	}
+
+	// Corners of each face, in order around the face, in either direction
+	const int quads[6][4] = {
+		{ 0, 2, 6, 4 }, //
+		{ 1, 3, 7, 5 }, //
+		{ 0, 1, 5, 4 }, //
+		{ 2, 3, 7, 6 }, //
+		{ 0, 1, 3, 2 }, //
+		{ 4, 5, 7, 6 }, //
+	};
+
+	StdVector<int> indices;
+	for (const int *quad : quads) {
+		const Vector3 face_center = (vertices[quad[0]] + vertices[quad[2]]) * 0.5;
+		const Vector3 normal = (vertices[quad[1]] - vertices[quad[0]]).cross(vertices[quad[2]] - vertices[quad[0]]);
+		// Triangles must be clockwise seen from outside
+		const bool flip = normal.dot(face_center) > 0.0;
+		const int order[6] = { 0, 1, 2, 0, 2, 3 };
+		for (int i = 0; i < 6; ++i) {
+			indices.push_back(quad[order[flip ? 5 - i : i]]);
+		}
+	}
+
+	StdVector<mesh_sdf::Triangle> triangles;
+	Vector3f mesh_min_pos;
+	Vector3f mesh_max_pos;
+	const bool prepared =
+			mesh_sdf::prepare_triangles(to_span(vertices), to_span(indices), triangles, mesh_min_pos, mesh_max_pos);
+	ZN_TEST_ASSERT(prepared);
+
+	// Leave room around the cube, so there are far cells outside too
+	const Vector3f min_pos(-2.f);
+	const Vector3f max_pos(2.f);
+	const Vector3i res(24, 24, 24);
+
+	StdVector<float> sdf_grid;
+	sdf_grid.resize(Vector3iUtil::get_volume(res));
+	mesh_sdf::generate_mesh_sdf_bvh(to_span(sdf_grid), res, to_span(triangles), min_pos, max_pos);
+
+	const Vector3f cell_size = (max_pos - min_pos) / to_vec3f(res);
+
+	Vector3i grid_pos;
+	for (grid_pos.z = 0; grid_pos.z < res.z; ++grid_pos.z) {
+		for (grid_pos.x = 0; grid_pos.x < res.x; ++grid_pos.x) {
+			for (grid_pos.y = 0; grid_pos.y < res.y; ++grid_pos.y) {
+				const Vector3f pos = min_pos + cell_size * (to_vec3f(grid_pos) + Vector3f(0.5f));
+
+				const Vector3f q = math::abs(pos) - Vector3f(1.f);
+				const float expected_sd = math::length(math::max(q, Vector3f())) +
+						math::min(math::max(q.x, math::max(q.y, q.z)), 0.f);
+
+				const float sd = sdf_grid[Vector3iUtil::get_zxy_index(grid_pos, res)];
+				ZN_TEST_ASSERT(Math::abs(sd - expected_sd) < 0.001f);
+			}
+		}
+	}
+}
+
 } // namespace zylann::voxel::tests
@@ -0,0 +1,255 @@
+#include "test_vox_data.h"
+#include "../../streams/vox/vox_data.h"
+#include "../../streams/vox/vox_model_instances.h"
+#include "../../util/godot/classes/file_access.h"
+#include "../../util/io/serialization.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+void store_vox_string(MemoryWriter &w, const char *s) {
+	const size_t len = strlen(s);
+	w.store_32(len);
+	w.store_buffer(Span<const uint8_t>(reinterpret_cast<const uint8_t *>(s), len));
+}
+
+void store_vox_chunk(MemoryWriter &w, const char *id, Span<const uint8_t> content, Span<const uint8_t> children) {
+	w.store_buffer(Span<const uint8_t>(reinterpret_cast<const uint8_t *>(id), 4));
+	w.store_32(content.size());
+	w.store_32(children.size());
+	w.store_buffer(content);
+	w.store_buffer(children);
+}
+
+unsigned int get_test_height(unsigned int x, unsigned int y) {
+	return 16 + (x * 7 + y * 13) % 48;
+}
+
+// Writes cubic models filled with a heightmap, placed side by side in a grid in the scene graph.
+// Returns how many voxels were written in total.
+uint64_t make_test_vox_file(StdVector<uint8_t> &file_data, unsigned int models_per_side, unsigned int model_size) {
+	// Heights must fit in models, and coordinates are stored in bytes
+	ZN_ASSERT(model_size >= 64 && model_size <= 256);
+	const unsigned int model_count = models_per_side * models_per_side;
+
+	StdVector<uint8_t> children;
+	MemoryWriter cw(children, ENDIANNESS_LITTLE_ENDIAN);
+	StdVector<uint8_t> content;
+	MemoryWriter w(content, ENDIANNESS_LITTLE_ENDIAN);
+
+	uint64_t voxel_count = 0;
+
+	for (unsigned int model_index = 0; model_index < model_count; ++model_index) {
+		content.clear();
+		w.store_32(model_size);
+		w.store_32(model_size);
+		w.store_32(model_size);
+		store_vox_chunk(cw, "SIZE", to_span(content), Span<const uint8_t>());
+
+		content.clear();
+		w.store_32(0);
+		uint32_t model_voxel_count = 0;
+		for (unsigned int y = 0; y < model_size; ++y) {
+			for (unsigned int x = 0; x < model_size; ++x) {
+				const unsigned int height = get_test_height(x + model_index, y);
+				for (unsigned int z = 0; z < height; ++z) {
+					w.store_8(x);
+					w.store_8(y);
+					w.store_8(z);
+					w.store_8(1 + height);
+				}
+				model_voxel_count += height;
+			}
+		}
+		// Patch voxel count
+		ByteSpanWithPosition count_span(to_span(content), 0);
+		MemoryWriterExistingBuffer count_writer(count_span, ENDIANNESS_LITTLE_ENDIAN);
+		count_writer.store_32(model_voxel_count);
+		store_vox_chunk(cw, "XYZI", to_span(content), Span<const uint8_t>());
+
+		voxel_count += model_voxel_count;
+	}
+
+	// Scene graph: root transform -> group -> (transform -> shape) for each model
+	content.clear();
+	w.store_32(0);
+	w.store_32(0);
+	w.store_32(1);
+	w.store_32(-1);
+	w.store_32(-1);
+	w.store_32(1);
+	w.store_32(0);
+	store_vox_chunk(cw, "nTRN", to_span(content), Span<const uint8_t>());
+
+	content.clear();
+	w.store_32(1);
+	w.store_32(0);
+	w.store_32(model_count);
+	for (unsigned int model_index = 0; model_index < model_count; ++model_index) {
+		w.store_32(2 + model_index * 2);
+	}
+	store_vox_chunk(cw, "nGRP", to_span(content), Span<const uint8_t>());
+
+	for (unsigned int model_index = 0; model_index < model_count; ++model_index) {
+		const unsigned int transform_node_id = 2 + model_index * 2;
+		const int tx = (model_index % models_per_side) * model_size;
+		const int ty = (model_index / models_per_side) * model_size;
+
+		content.clear();
+		w.store_32(transform_node_id);
+		w.store_32(0);
+		w.store_32(transform_node_id + 1);
+		w.store_32(-1);
+		w.store_32(-1);
+		w.store_32(1);
+		// Frame attributes
+		w.store_32(model_index % 2 == 0 ? 1 : 2);
+		store_vox_string(w, "_t");
+		store_vox_string(w, format("{} {} {}", tx, ty, model_size / 2).c_str());
+		if (model_index % 2 == 1) {
+			// Rotate every other model by 90 degrees around the vertical axis
+			store_vox_string(w, "_r");
+			store_vox_string(w, "17");
+		}
+		store_vox_chunk(cw, "nTRN", to_span(content), Span<const uint8_t>());
+
+		content.clear();
+		w.store_32(transform_node_id + 1);
+		w.store_32(0);
+		w.store_32(1);
+		w.store_32(model_index);
+		w.store_32(0);
+		store_vox_chunk(cw, "nSHP", to_span(content), Span<const uint8_t>());
+	}
+
+	content.clear();
+	for (unsigned int i = 0; i < 256; ++i) {
+		w.store_8(i);
+		w.store_8(255 - i);
+		w.store_8(i / 2);
+		w.store_8(255);
+	}
+	store_vox_chunk(cw, "RGBA", to_span(content), Span<const uint8_t>());
+
+	file_data.clear();
+	MemoryWriter fw(file_data, ENDIANNESS_LITTLE_ENDIAN);
+	fw.store_buffer(Span<const uint8_t>(reinterpret_cast<const uint8_t *>("VOX "), 4));
+	fw.store_32(150);
+	store_vox_chunk(fw, "MAIN", Span<const uint8_t>(), to_span(children));
+
+	return voxel_count;
+}
+
+uint64_t count_non_empty_voxels(Span<const uint8_t> color_indices) {
+	uint64_t count = 0;
+	for (const uint8_t c : color_indices) {
+		if (c != 0) {
+			++count;
+		}
+	}
+	return count;
+}
+
+struct VoxLoadTimings {
+	uint64_t load_us = 0;
+	uint64_t extract_us = 0;
+	uint64_t grid_us = 0;
+	uint64_t voxel_count = 0;
+};
+
+// Writes a test file with `models_per_side^2` models of `model_size^3`, loads it back and checks the results
+void load_test_vox_file(unsigned int models_per_side, unsigned int model_size, VoxLoadTimings &timings) {
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+	const String file_path = test_dir.get_path().path_join("test.vox");
+
+	uint64_t expected_voxel_count;
+	{
+		StdVector<uint8_t> file_data;
+		expected_voxel_count = make_test_vox_file(file_data, models_per_side, model_size);
+
+		Error open_error;
+		Ref<FileAccess> f = godot::open_file(file_path, FileAccess::WRITE, open_error);
+		ZN_TEST_ASSERT(f.is_valid());
+		godot::store_buffer(**f, to_span(file_data));
+	}
+	timings.voxel_count = expected_voxel_count;
+
+	ProfilingClock profiling_clock;
+
+	magica::Data vox_data;
+	const Error load_error = vox_data.load_from_file(file_path);
+	timings.load_us = profiling_clock.restart();
+
+	ZN_TEST_ASSERT(load_error == OK);
+	ZN_TEST_ASSERT(vox_data.get_model_count() == models_per_side * models_per_side);
+	uint64_t loaded_voxel_count = 0;
+	for (unsigned int model_index = 0; model_index < vox_data.get_model_count(); ++model_index) {
+		const magica::Model &model = vox_data.get_model(model_index);
+		ZN_TEST_ASSERT(model.size == Vector3iUtil::create(model_size));
+		loaded_voxel_count += count_non_empty_voxels(to_span(model.color_indexes));
+	}
+	ZN_TEST_ASSERT(loaded_voxel_count == expected_voxel_count);
+	// First voxel of the first model, at the bottom of a column of height 16
+	ZN_TEST_ASSERT(vox_data.get_model(0).color_indexes[0] == 17);
+
+	profiling_clock.restart();
+
+	StdVector<magica::ModelInstance> instances;
+	magica::extract_model_instances(vox_data, instances);
+	timings.extract_us = profiling_clock.restart();
+
+	ZN_TEST_ASSERT(instances.size() == vox_data.get_model_count());
+
+	const unsigned int padding = 1;
+	Vector3i origin;
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	const bool grid_succeeded = magica::make_single_voxel_grid(to_span_const(instances), padding, origin, voxels);
+	timings.grid_us = profiling_clock.restart();
+
+	ZN_TEST_ASSERT(grid_succeeded);
+	// Models don't overlap, so they are laid out in a grid
+	const Vector3i expected_size(models_per_side * model_size, model_size, models_per_side * model_size);
+	ZN_TEST_ASSERT(voxels.get_size() == expected_size + Vector3iUtil::create(padding * 2));
+
+	Span<const uint8_t> grid_color_indices;
+	ZN_TEST_ASSERT(voxels.get_channel_as_bytes_read_only(VoxelBuffer::CHANNEL_COLOR, grid_color_indices));
+	ZN_TEST_ASSERT(count_non_empty_voxels(grid_color_indices) == expected_voxel_count);
+
+	// Nothing must be written in padding
+	for (int z = 0; z < voxels.get_size().z; ++z) {
+		for (int x = 0; x < voxels.get_size().x; ++x) {
+			ZN_TEST_ASSERT(voxels.get_voxel(x, 0, z, VoxelBuffer::CHANNEL_COLOR) == 0);
+		}
+	}
+}
+
+} // namespace
+
+void test_vox_data_load() {
+	// Kept small so the test suite stays fast, while still covering several models and rotations
+	VoxLoadTimings timings;
+	load_test_vox_file(2, 64, timings);
+}
+
+void test_vox_data_load_benchmark(unsigned int model_size) {
+	const unsigned int models_per_side = 2;
+	VoxLoadTimings timings;
+	load_test_vox_file(models_per_side, model_size, timings);
+
+	print_line(format(
+			"Vox import of {} models of {}^3 with {} voxels: load {} us, extract instances {} us, single grid {} us",
+			models_per_side * models_per_side,
+			model_size,
+			timings.voxel_count,
+			timings.load_us,
+			timings.extract_us,
+			timings.grid_us
+	));
+}
+
+} // namespace zylann::voxel::tests
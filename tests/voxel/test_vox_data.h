@@ -0,0 +1,12 @@
+#ifndef VOXEL_TESTS_VOX_DATA_H
+#define VOXEL_TESTS_VOX_DATA_H
+
+namespace zylann::voxel::tests {
+
+void test_vox_data_load();
+// Model size can go up to 256, the largest supported by the format
+void test_vox_data_load_benchmark(unsigned int model_size = 256);
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOX_DATA_H
@@ -0,0 +1,163 @@
+#include "test_voxel_a_star_grid_3d.h"
+#include "../../storage/voxel_data.h"
+#include "../../terrain/voxel_a_star_grid_3d.h"
+#include "../../terrain/voxel_a_star_grid_3d_hierarchy.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+const int WALL_X = 20;
+const int GAP_MIN_Z = 10;
+const int GAP_MAX_Z = 12;
+
+// Flat ground below Y=0, with a wall too high to jump over at X=20, except in a small gap
+void make_test_world(VoxelData &data) {
+	const int block_size = data.get_block_size();
+	const Box3i blocks_box(-2, -1, -2, 4, 2, 4);
+	// Outside of bounds, voxels always read as air, which would make the wall invisible to checks
+	data.set_bounds(Box3i(blocks_box.position * block_size, blocks_box.size * block_size));
+
+	blocks_box.for_each_cell_zxy([&data, block_size](Vector3i block_pos) {
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+
+		const Vector3i origin = block_pos * block_size;
+		if (origin.y + block_size <= 0) {
+			buffer->fill(1, VoxelBuffer::CHANNEL_TYPE);
+
+		} else {
+			for (int z = 0; z < block_size; ++z) {
+				for (int x = 0; x < block_size; ++x) {
+					const Vector3i pos = origin + Vector3i(x, 0, z);
+					const bool wall = pos.x == WALL_X && (pos.z < GAP_MIN_Z || pos.z > GAP_MAX_Z);
+					for (int y = 0; y < block_size; ++y) {
+						if (wall && origin.y + y < 4) {
+							buffer->set_voxel(1, x, y, z, VoxelBuffer::CHANNEL_TYPE);
+						}
+					}
+				}
+			}
+		}
+
+		VoxelDataBlock block(buffer, 0);
+		ZN_TEST_ASSERT(data.try_set_block(block_pos, block));
+	});
+}
+
+void check_path(const VoxelData &data, Span<const Vector3i> path, Vector3i from_position, Vector3i to_position) {
+	ZN_TEST_ASSERT(path.size() > 0);
+	ZN_TEST_ASSERT(path[0] == from_position);
+
+	VoxelSingleValue defval;
+	defval.i = 0;
+
+	for (unsigned int i = 0; i < path.size(); ++i) {
+		const Vector3i pos = path[i];
+		const Vector3i next_pos = i + 1 < path.size() ? path[i + 1] : to_position;
+		const Vector3i diff = next_pos - pos;
+		ZN_TEST_ASSERT(Math::abs(diff.x) <= 1 && Math::abs(diff.y) <= 1 && Math::abs(diff.z) <= 1);
+		ZN_TEST_ASSERT(data.get_voxel(pos, VoxelBuffer::CHANNEL_TYPE, defval).i == 0);
+		if (pos.x == WALL_X && pos.y < 4) {
+			// The wall can only be crossed through the gap
+			ZN_TEST_ASSERT(pos.z >= GAP_MIN_Z && pos.z <= GAP_MAX_Z);
+		}
+	}
+}
+
+} // namespace
+
+void test_voxel_a_star_grid_3d_hierarchy() {
+	std::shared_ptr<VoxelData> data = make_shared_instance<VoxelData>();
+	make_test_world(*data);
+
+	const Box3i region(Vector3i(-32, -4, -32), Vector3i(64, 16, 64));
+	const Vector3i from_position(0, 0, 0);
+	const Vector3i to_position(30, 0, 0);
+
+	// Reference path using flat A*
+	VoxelAStarGrid3DInternal flat_path_finder;
+	flat_path_finder.data = data;
+	flat_path_finder.set_region(region);
+	flat_path_finder.start(from_position, to_position);
+	flat_path_finder.init_cache();
+	while (flat_path_finder.is_running()) {
+		flat_path_finder.step();
+	}
+	const unsigned int flat_path_length = flat_path_finder.get_path().size();
+	ZN_TEST_ASSERT(flat_path_length > 0);
+
+	VoxelAStarGrid3DHierarchy::Params params;
+	params.region = region;
+	params.agent_size = flat_path_finder.get_agent_size();
+	params.max_fall_height = flat_path_finder.get_max_fall_height();
+	params.max_path_cost = flat_path_finder.get_max_path_cost();
+
+	std::shared_ptr<VoxelAStarGrid3DHierarchy> hierarchy =
+			make_shared_instance<VoxelAStarGrid3DHierarchy>(data, params);
+	data->add_edit_listener(hierarchy);
+	hierarchy->update();
+	ZN_TEST_ASSERT(hierarchy->debug_get_portal_count() > 0);
+
+	VoxelAStarGrid3DHierarchy::SearchContext search_context;
+	StdVector<Vector3i> path;
+	hierarchy->find_path(from_position, to_position, search_context, path);
+	check_path(*data, to_span(path), from_position, to_position);
+
+	// Going through portals can make paths a bit longer, but not by much
+	ZN_TEST_ASSERT(path.size() <= flat_path_length + flat_path_length / 2);
+
+	// The only way is through the gap
+	bool went_through_gap = false;
+	for (const Vector3i pos : path) {
+		if (pos.x == WALL_X) {
+			ZN_TEST_ASSERT(pos.z >= GAP_MIN_Z && pos.z <= GAP_MAX_Z);
+			went_through_gap = true;
+		}
+	}
+	ZN_TEST_ASSERT(went_through_gap);
+
+	const Box3i gap_box = Box3i::from_min_max(Vector3i(WALL_X, 0, GAP_MIN_Z), Vector3i(WALL_X + 1, 4, GAP_MAX_Z + 1));
+
+	// Keep a copy of blocks around the gap, to load them back later
+	const Box3i gap_blocks_box = gap_box.downscaled(data->get_block_size());
+	StdVector<std::shared_ptr<VoxelBuffer>> saved_gap_blocks;
+	gap_blocks_box.for_each_cell_zxy([&data, &saved_gap_blocks](Vector3i bpos) {
+		std::shared_ptr<VoxelBuffer> voxels = data->try_get_block_voxels(bpos);
+		ZN_TEST_ASSERT(voxels != nullptr);
+		std::shared_ptr<VoxelBuffer> saved_voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		voxels->copy_to(*saved_voxels, false);
+		saved_gap_blocks.push_back(saved_voxels);
+	});
+
+	// Close the gap. The edit must invalidate the clusters around it.
+	gap_box.for_each_cell_zxy([&data](Vector3i pos) {
+		ZN_TEST_ASSERT(data->try_set_voxel(1, pos, VoxelBuffer::CHANNEL_TYPE));
+	});
+	data->mark_area_modified(gap_box, nullptr, false);
+
+	hierarchy->update();
+	hierarchy->find_path(from_position, to_position, search_context, path);
+	ZN_TEST_ASSERT(path.size() == 0);
+
+	// Paths on the same side of the wall are still found
+	hierarchy->find_path(from_position, Vector3i(-25, 0, 18), search_context, path);
+	check_path(*data, to_span(path), from_position, Vector3i(-25, 0, 18));
+
+	// Replace blocks around the gap with their saved version, like a stream would load them. Clusters must be
+	// invalidated without any edit.
+	data->unload_blocks(gap_blocks_box, 0, nullptr);
+	unsigned int saved_block_index = 0;
+	gap_blocks_box.for_each_cell_zxy([&data, &saved_gap_blocks, &saved_block_index](Vector3i bpos) {
+		VoxelDataBlock block(saved_gap_blocks[saved_block_index], 0);
+		++saved_block_index;
+		ZN_TEST_ASSERT(data->try_set_block(bpos, block));
+	});
+
+	hierarchy->update();
+	hierarchy->find_path(from_position, to_position, search_context, path);
+	check_path(*data, to_span(path), from_position, to_position);
+}
+
+} // namespace zylann::voxel::tests
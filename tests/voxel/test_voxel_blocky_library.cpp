@@ -0,0 +1,753 @@
+#include "test_voxel_blocky_library.h"
+#include "../../constants/cube_tables.h"
+#include "../../constants/voxel_string_names.h"
+#include "../../meshers/blocky/blocky_library_cache.h"
+#include "../../meshers/blocky/types/voxel_blocky_type_library.h"
+#include "../../meshers/blocky/voxel_blocky_library.h"
+#include "../../meshers/blocky/voxel_blocky_model_cube.h"
+#include "../../meshers/blocky/voxel_blocky_model_empty.h"
+#include "../../meshers/blocky/voxel_blocky_model_mesh.h"
+#include "../../meshers/blocky/voxel_mesher_blocky.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../util/godot/classes/array_mesh.h"
+#include "../../util/godot/classes/standard_material_3d.h"
+#include "../../util/godot/core/packed_arrays.h"
+#include "../../util/math/conv.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
+#include "../testing.h"
+#include <algorithm>
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+// Returns the last model that was added
+Ref<VoxelBlockyModelCube> add_test_models(VoxelBlockyLibrary &library, Ref<Material> material) {
+	Ref<VoxelBlockyModelEmpty> air;
+	air.instantiate();
+	library.add_model(air);
+
+	Ref<VoxelBlockyModelCube> cube;
+	for (unsigned int i = 0; i < 4; ++i) {
+		cube.instantiate();
+		cube->set_tile(VoxelBlockyModel::SIDE_POSITIVE_Y, Vector2i(i, 0));
+		if (i == 2) {
+			cube->set_material_override(0, material);
+		}
+		library.add_model(cube);
+	}
+	return cube;
+}
+
+bool is_same_surface(const VoxelBlockyModel::BakedData::Surface &a, const VoxelBlockyModel::BakedData::Surface &b) {
+	if (a.positions != b.positions || a.normals != b.normals || a.uvs != b.uvs || a.indices != b.indices ||
+		a.tangents != b.tangents || a.material_id != b.material_id || a.collision_enabled != b.collision_enabled) {
+		return false;
+	}
+	for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+		const VoxelBlockyModel::BakedData::SideSurface &as = a.sides[side];
+		const VoxelBlockyModel::BakedData::SideSurface &bs = b.sides[side];
+		if (as.positions != bs.positions || as.uvs != bs.uvs || as.indices != bs.indices ||
+			as.tangents != bs.tangents) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool is_same_baked_data(const VoxelBlockyLibraryBase::BakedData &a, const VoxelBlockyLibraryBase::BakedData &b) {
+	if (a.models.size() != b.models.size() || a.side_pattern_count != b.side_pattern_count ||
+		a.indexed_materials_count != b.indexed_materials_count) {
+		return false;
+	}
+	const unsigned int culling_bit_count = a.side_pattern_count * a.side_pattern_count;
+	for (unsigned int i = 0; i < culling_bit_count; ++i) {
+		if (a.side_pattern_culling.get(i) != b.side_pattern_culling.get(i)) {
+			return false;
+		}
+	}
+	for (unsigned int model_index = 0; model_index < a.models.size(); ++model_index) {
+		const VoxelBlockyModel::BakedData &am = a.models[model_index];
+		const VoxelBlockyModel::BakedData &bm = b.models[model_index];
+		if (am.empty != bm.empty || am.color != bm.color || am.contributes_to_ao != bm.contributes_to_ao ||
+			am.box_collision_aabbs != bm.box_collision_aabbs ||
+			am.model.surface_count != bm.model.surface_count ||
+			am.model.empty_sides_mask != bm.model.empty_sides_mask ||
+			am.model.full_sides_mask != bm.model.full_sides_mask) {
+			return false;
+		}
+		for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+			if (am.model.side_pattern_indices[side] != bm.model.side_pattern_indices[side]) {
+				return false;
+			}
+		}
+		for (unsigned int surface_index = 0; surface_index < am.model.surface_count; ++surface_index) {
+			if (!is_same_surface(am.model.surfaces[surface_index], bm.model.surfaces[surface_index])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Single triangle inside the voxel, so it doesn't touch any side
+void set_test_triangle(ArrayMesh &mesh, float uv_x) {
+	PackedVector3Array positions;
+	positions.push_back(Vector3(0.25, 0.5, 0.25));
+	positions.push_back(Vector3(0.75, 0.5, 0.25));
+	positions.push_back(Vector3(0.25, 0.5, 0.75));
+	PackedVector3Array normals;
+	PackedVector2Array uvs;
+	for (int i = 0; i < positions.size(); ++i) {
+		normals.push_back(Vector3(0, 1, 0));
+		// Not degenerate, so tangents can be generated from UVs
+		uvs.push_back(Vector2(uv_x + positions[i].x, positions[i].z));
+	}
+	PackedInt32Array indices;
+	indices.push_back(0);
+	indices.push_back(1);
+	indices.push_back(2);
+
+	Array arrays;
+	arrays.resize(Mesh::ARRAY_MAX);
+	arrays[Mesh::ARRAY_VERTEX] = positions;
+	arrays[Mesh::ARRAY_NORMAL] = normals;
+	arrays[Mesh::ARRAY_TEX_UV] = uvs;
+	arrays[Mesh::ARRAY_INDEX] = indices;
+
+	mesh.clear_surfaces();
+	mesh.add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, arrays);
+}
+
+// Library with a mix of model configurations: opaque and transparent cubes, a cube that doesn't cull neighbors, an
+// empty model that isn't air, and a mesh with geometry inside the voxel only
+Ref<VoxelBlockyLibrary> make_mixed_test_library() {
+	Ref<StandardMaterial3D> material;
+	material.instantiate();
+
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	add_test_models(**library, material);
+
+	Ref<VoxelBlockyModelCube> transparent_cube;
+	transparent_cube.instantiate();
+	transparent_cube->set_transparency_index(1);
+	transparent_cube->set_material_override(0, material);
+	library->add_model(transparent_cube);
+
+	Ref<VoxelBlockyModelCube> non_culling_cube;
+	non_culling_cube.instantiate();
+	non_culling_cube->set_culls_neighbors(false);
+	non_culling_cube->set_color(Color(0.5, 1.0, 0.5));
+	library->add_model(non_culling_cube);
+
+	Ref<VoxelBlockyModelEmpty> empty;
+	empty.instantiate();
+	library->add_model(empty);
+
+	Ref<ArrayMesh> mesh;
+	mesh.instantiate();
+	set_test_triangle(**mesh, 0.0);
+	Ref<VoxelBlockyModelMesh> inside_model;
+	inside_model.instantiate();
+	inside_model->set_mesh(mesh);
+	library->add_model(inside_model);
+
+	library->set_bake_tangents(true);
+	library->bake();
+	return library;
+}
+
+// Padded block where about a third of voxels are air, and others use any model of the library
+void make_mixed_test_block(VoxelBuffer &voxels, int size, unsigned int model_count) {
+	const int padded_size = size + 2 * VoxelMesherBlocky::PADDING;
+	voxels.create(Vector3iUtil::create(padded_size));
+	voxels.set_channel_depth(VoxelBuffer::CHANNEL_TYPE, VoxelBuffer::DEPTH_8_BIT);
+	Vector3i pos;
+	for (pos.z = 0; pos.z < padded_size; ++pos.z) {
+		for (pos.x = 0; pos.x < padded_size; ++pos.x) {
+			for (pos.y = 0; pos.y < padded_size; ++pos.y) {
+				const uint32_t h = (static_cast<uint32_t>(pos.x) * 73856093u) ^
+						(static_cast<uint32_t>(pos.y) * 19349663u) ^ (static_cast<uint32_t>(pos.z) * 83492791u);
+				const unsigned int id = (h % 3 == 0) ? 0 : 1 + (h / 3) % (model_count - 1);
+				voxels.set_voxel(id, pos, VoxelBuffer::CHANNEL_TYPE);
+			}
+		}
+	}
+}
+
+void append_model_geometry(
+		VoxelMesherBlocky::Arrays &arrays,
+		const VoxelBlockyModel::BakedData &model_data,
+		Span<const Vector3f> positions,
+		Span<const Vector3f> normals,
+		Span<const Vector2f> uvs,
+		Span<const float> tangents,
+		Span<const int> indices,
+		const Vector3f offset
+) {
+	const int index_offset = arrays.positions.size();
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		arrays.positions.push_back(positions[i] + offset);
+		arrays.normals.push_back(normals[i]);
+		arrays.uvs.push_back(uvs[i]);
+		arrays.colors.push_back(model_data.color);
+	}
+	if (tangents.size() > 0) {
+		// Like the mesher, only take as many tangents as there are vertices
+		for (unsigned int i = 0; i < positions.size() * 4; ++i) {
+			arrays.tangents.push_back(tangents[i]);
+		}
+	}
+	for (const int i : indices) {
+		arrays.indices.push_back(index_offset + i);
+	}
+}
+
+void append_side_geometry(
+		VoxelMesherBlocky::Arrays &arrays,
+		const VoxelBlockyModel::BakedData &model_data,
+		const VoxelBlockyModel::BakedData::SideSurface &side_surface,
+		unsigned int side,
+		const Vector3f offset
+) {
+	StdVector<Vector3f> normals;
+	normals.resize(side_surface.positions.size(), to_vec3f(Cube::g_side_normals[side]));
+	append_model_geometry(
+			arrays,
+			model_data,
+			to_span(side_surface.positions),
+			to_span(normals),
+			to_span(side_surface.uvs),
+			to_span(side_surface.tangents),
+			to_span(side_surface.indices),
+			offset
+	);
+}
+
+// Meshes voxels by reading geometry from each baked model, like the mesher did before using the flat layout.
+// Ambient occlusion is not handled.
+void build_mesh_from_models(
+		const VoxelBuffer &voxels,
+		const VoxelBlockyLibraryBase::BakedData &lib,
+		unsigned int lod_index,
+		StdVector<VoxelMesherBlocky::Arrays> &arrays_per_material
+) {
+	arrays_per_material.clear();
+	arrays_per_material.resize(lib.indexed_materials_count);
+
+	const Vector3i size = voxels.get_size();
+	const int pad = VoxelMesherBlocky::PADDING;
+	const Vector3i min = Vector3iUtil::create(pad);
+	const Vector3i max = size - Vector3iUtil::create(pad);
+
+	auto get_id = [&voxels](Vector3i pos) { //
+		return voxels.get_voxel(pos, VoxelBuffer::CHANNEL_TYPE);
+	};
+
+	Vector3i pos;
+	for (pos.z = min.z; pos.z < max.z; ++pos.z) {
+		for (pos.x = min.x; pos.x < max.x; ++pos.x) {
+			for (pos.y = min.y; pos.y < max.y; ++pos.y) {
+				const uint32_t id = get_id(pos);
+				if (id == VoxelBlockyModel::AIR_ID || id >= lib.models.size()) {
+					continue;
+				}
+				const VoxelBlockyModel::BakedData &model_data = lib.models[id];
+				const VoxelBlockyModel::BakedData::Model &model = model_data.model;
+				const Vector3f offset = to_vec3f(pos - min);
+
+				for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+					if ((model.empty_sides_mask & (1 << side)) != 0) {
+						continue;
+					}
+					const uint32_t neighbor_id = get_id(pos + Cube::g_side_normals[side]);
+					if (neighbor_id < lib.models.size()) {
+						const VoxelBlockyModel::BakedData &neighbor = lib.models[neighbor_id];
+						// Sides come in pairs of opposite normals
+						const unsigned int opposite_side = side ^ 1;
+						const bool neighbor_culls = neighbor.culls_neighbors && !neighbor.empty &&
+								neighbor.transparency_index <= model_data.transparency_index;
+						if (neighbor_culls) {
+							const unsigned int ai = model.side_pattern_indices[side];
+							const unsigned int bi = neighbor.model.side_pattern_indices[opposite_side];
+							if (ai == bi || lib.get_side_pattern_occlusion(bi, ai)) {
+								continue;
+							}
+						}
+					}
+					for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+						const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+						append_side_geometry(
+								arrays_per_material[surface.material_id], model_data, surface.sides[side], side, offset
+						);
+					}
+				}
+
+				for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+					const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+					append_model_geometry(
+							arrays_per_material[surface.material_id],
+							model_data,
+							to_span(surface.positions),
+							to_span(surface.normals),
+							to_span(surface.uvs),
+							to_span(surface.tangents),
+							to_span(surface.indices),
+							offset
+					);
+				}
+			}
+		}
+	}
+
+	if (lod_index == 0) {
+		return;
+	}
+
+	// Seams: for each outer voxel exposed to air next to a solid inner voxel, add the outer side of that inner voxel
+	for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+		const Vector3i normal = Cube::g_side_normals[side];
+		const unsigned int axis = normal.x != 0 ? 0 : (normal.y != 0 ? 1 : 2);
+		const unsigned int u_axis = (axis + 1) % Vector3iUtil::AXIS_COUNT;
+		const unsigned int v_axis = (axis + 2) % Vector3iUtil::AXIS_COUNT;
+		const int outer = normal[axis] < 0 ? 0 : size[axis] - 1;
+
+		Vector3i outer_pos;
+		outer_pos[axis] = outer;
+		for (outer_pos[u_axis] = pad; outer_pos[u_axis] < size[u_axis] - pad; ++outer_pos[u_axis]) {
+			for (outer_pos[v_axis] = pad; outer_pos[v_axis] < size[v_axis] - pad; ++outer_pos[v_axis]) {
+				if (get_id(outer_pos) == VoxelBlockyModel::AIR_ID) {
+					continue;
+				}
+				Vector3i du;
+				du[u_axis] = 1;
+				Vector3i dv;
+				dv[v_axis] = 1;
+				if (get_id(outer_pos - du) != VoxelBlockyModel::AIR_ID &&
+					get_id(outer_pos + du) != VoxelBlockyModel::AIR_ID &&
+					get_id(outer_pos - dv) != VoxelBlockyModel::AIR_ID &&
+					get_id(outer_pos + dv) != VoxelBlockyModel::AIR_ID) {
+					continue;
+				}
+				const Vector3i inner_pos = outer_pos - normal;
+				const uint32_t inner_id = get_id(inner_pos);
+				if (inner_id == VoxelBlockyModel::AIR_ID) {
+					continue;
+				}
+				const VoxelBlockyModel::BakedData &model_data = lib.models[inner_id];
+				const VoxelBlockyModel::BakedData::Model &model = model_data.model;
+				for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+					const VoxelBlockyModel::BakedData::Surface &surface = model.surfaces[surface_index];
+					append_side_geometry(
+							arrays_per_material[surface.material_id],
+							model_data,
+							surface.sides[side],
+							side,
+							to_vec3f(inner_pos - min)
+					);
+				}
+			}
+		}
+	}
+
+	const float lod_scale = 1 << lod_index;
+	for (VoxelMesherBlocky::Arrays &arrays : arrays_per_material) {
+		for (Vector3f &p : arrays.positions) {
+			p = p * lod_scale;
+		}
+	}
+}
+
+// All attributes of the 3 vertices of a triangle
+using TestTriangle = FixedArray<float, 3 * 16>;
+
+// Gets triangles of a mesh in a canonical order, so meshes can be compared regardless of the order in which
+// geometry was added
+void get_sorted_triangles(
+		Span<const Vector3f> positions,
+		Span<const Vector3f> normals,
+		Span<const Vector2f> uvs,
+		Span<const Color> colors,
+		Span<const float> tangents,
+		Span<const int> indices,
+		StdVector<TestTriangle> &out_triangles
+) {
+	ZN_TEST_ASSERT(indices.size() % 3 == 0);
+	// Tangents are only compared when all vertices have some
+	const bool has_tangents = tangents.size() == positions.size() * 4;
+	out_triangles.clear();
+	for (unsigned int ii = 0; ii < indices.size(); ii += 3) {
+		TestTriangle t;
+		unsigned int j = 0;
+		for (unsigned int k = 0; k < 3; ++k) {
+			const int vi = indices[ii + k];
+			ZN_TEST_ASSERT(vi >= 0 && vi < static_cast<int>(positions.size()));
+			t[j++] = positions[vi].x;
+			t[j++] = positions[vi].y;
+			t[j++] = positions[vi].z;
+			t[j++] = normals[vi].x;
+			t[j++] = normals[vi].y;
+			t[j++] = normals[vi].z;
+			t[j++] = uvs[vi].x;
+			t[j++] = uvs[vi].y;
+			t[j++] = colors[vi].r;
+			t[j++] = colors[vi].g;
+			t[j++] = colors[vi].b;
+			t[j++] = colors[vi].a;
+			for (unsigned int c = 0; c < 4; ++c) {
+				t[j++] = has_tangents ? tangents[vi * 4 + c] : 0.f;
+			}
+		}
+		out_triangles.push_back(t);
+	}
+	std::sort(out_triangles.begin(), out_triangles.end(), [](const TestTriangle &a, const TestTriangle &b) {
+		for (unsigned int i = 0; i < a.size(); ++i) {
+			if (a[i] != b[i]) {
+				return a[i] < b[i];
+			}
+		}
+		return false;
+	});
+}
+
+void get_sorted_triangles(const VoxelMesherBlocky::Arrays &arrays, StdVector<TestTriangle> &out_triangles) {
+	get_sorted_triangles(
+			to_span(arrays.positions),
+			to_span(arrays.normals),
+			to_span(arrays.uvs),
+			to_span(arrays.colors),
+			to_span(arrays.tangents),
+			to_span(arrays.indices),
+			out_triangles
+	);
+}
+
+void get_sorted_triangles(const Array &surface_arrays, StdVector<TestTriangle> &out_triangles) {
+	const PackedVector3Array positions = surface_arrays[Mesh::ARRAY_VERTEX];
+	const PackedVector3Array normals = surface_arrays[Mesh::ARRAY_NORMAL];
+	const PackedVector2Array uvs = surface_arrays[Mesh::ARRAY_TEX_UV];
+	const PackedColorArray colors = surface_arrays[Mesh::ARRAY_COLOR];
+	const PackedFloat32Array tangents = surface_arrays[Mesh::ARRAY_TANGENT];
+	const PackedInt32Array indices = surface_arrays[Mesh::ARRAY_INDEX];
+
+	// Godot vectors may use doubles
+	StdVector<Vector3f> positions_f;
+	StdVector<Vector3f> normals_f;
+	StdVector<Vector2f> uvs_f;
+	for (int i = 0; i < positions.size(); ++i) {
+		positions_f.push_back(to_vec3f(positions[i]));
+		normals_f.push_back(to_vec3f(normals[i]));
+		uvs_f.push_back(to_vec2f(uvs[i]));
+	}
+
+	get_sorted_triangles(
+			to_span(positions_f),
+			to_span(normals_f),
+			to_span(uvs_f),
+			Span<const Color>(colors.ptr(), colors.size()),
+			to_span(tangents),
+			to_span(indices),
+			out_triangles
+	);
+}
+
+} // namespace
+
+void test_voxel_blocky_library_rebake() {
+	Ref<StandardMaterial3D> material;
+	material.instantiate();
+
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	Ref<VoxelBlockyModelCube> changed_cube = add_test_models(**library, material);
+	library->bake();
+
+	// Change one model and bake again. Only that model gets baked, but results must be the same as a full bake.
+	changed_cube->set_tile(VoxelBlockyModel::SIDE_NEGATIVE_X, Vector2i(5, 5));
+	// Now shares its material with another model
+	changed_cube->set_material_override(0, material);
+	library->bake();
+
+	Ref<VoxelBlockyLibrary> expected_library;
+	expected_library.instantiate();
+	Ref<VoxelBlockyModelCube> expected_cube = add_test_models(**expected_library, material);
+	expected_cube->set_tile(VoxelBlockyModel::SIDE_NEGATIVE_X, Vector2i(5, 5));
+	expected_cube->set_material_override(0, material);
+	expected_library->bake();
+
+	ZN_TEST_ASSERT(is_same_baked_data(library->get_baked_data(), expected_library->get_baked_data()));
+
+	// Tangents affect all models
+	library->set_bake_tangents(!library->get_bake_tangents());
+	expected_library->set_bake_tangents(library->get_bake_tangents());
+	library->bake();
+	expected_library->bake();
+	ZN_TEST_ASSERT(is_same_baked_data(library->get_baked_data(), expected_library->get_baked_data()));
+}
+
+void test_voxel_blocky_library_mesh_rebake() {
+	Ref<ArrayMesh> mesh;
+	mesh.instantiate();
+	set_test_triangle(**mesh, 0.0);
+
+	Ref<VoxelBlockyModelMesh> model;
+	model.instantiate();
+	model->set_mesh(mesh);
+
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	Ref<VoxelBlockyModelEmpty> air;
+	air.instantiate();
+	library->add_model(air);
+	library->add_model(model);
+	library->bake();
+
+	const uint64_t hash_before = model->get_bake_hash();
+	// Same contents, same hash
+	set_test_triangle(**mesh, 0.0);
+	ZN_TEST_ASSERT(model->get_bake_hash() == hash_before);
+
+	// Editing the mesh in memory, even only its UVs, must be noticed without assigning the mesh again
+	set_test_triangle(**mesh, 0.5);
+	ZN_TEST_ASSERT(model->get_bake_hash() != hash_before);
+	library->bake();
+
+	Ref<ArrayMesh> expected_mesh;
+	expected_mesh.instantiate();
+	set_test_triangle(**expected_mesh, 0.5);
+	Ref<VoxelBlockyModelMesh> expected_model;
+	expected_model.instantiate();
+	expected_model->set_mesh(expected_mesh);
+
+	Ref<VoxelBlockyLibrary> expected_library;
+	expected_library.instantiate();
+	expected_library->add_model(air);
+	expected_library->add_model(expected_model);
+	expected_library->bake();
+
+	ZN_TEST_ASSERT(is_same_baked_data(library->get_baked_data(), expected_library->get_baked_data()));
+}
+
+void test_voxel_blocky_type_library_rebake() {
+	Ref<VoxelBlockyTypeLibrary> library;
+	library.instantiate();
+	library->load_default();
+	library->bake();
+
+	const StringName &cube_name = VoxelStringNames::get_singleton().cube;
+	const int model_index = library->get_model_index_default(cube_name);
+	ZN_TEST_ASSERT(model_index >= 0);
+	const Color initial_color = library->get_baked_data().models[model_index].color;
+
+	// Nothing changed, baked data stays the same
+	library->bake();
+	ZN_TEST_ASSERT(library->get_baked_data().models[model_index].color == initial_color);
+
+	// Changing a model of a type must not be skipped
+	Ref<VoxelBlockyType> cube_type = library->get_type_from_name(cube_name);
+	ZN_TEST_ASSERT(cube_type.is_valid());
+	const Color new_color(1, 0, 0);
+	ZN_TEST_ASSERT(new_color != initial_color);
+	cube_type->get_base_model()->set_color(new_color);
+	library->bake();
+	ZN_TEST_ASSERT(library->get_baked_data().models[model_index].color == new_color);
+}
+
+void test_voxel_blocky_library_cache() {
+	Ref<StandardMaterial3D> material;
+	material.instantiate();
+
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	add_test_models(**library, material);
+	library->bake();
+	const VoxelBlockyLibraryBase::BakedData &baked_data = library->get_baked_data();
+
+	const uint64_t content_hash = 42;
+	StdVector<uint8_t> cache_data;
+	BlockyLibraryCache::serialize(baked_data, content_hash, cache_data);
+
+	{
+		VoxelBlockyLibraryBase::BakedData loaded_data;
+		ZN_TEST_ASSERT(BlockyLibraryCache::deserialize(to_span_const(cache_data), content_hash, loaded_data));
+		// Materials are not part of the cache, they get indexed by the library after loading
+		loaded_data.indexed_materials_count = baked_data.indexed_materials_count;
+		for (unsigned int model_index = 0; model_index < loaded_data.models.size(); ++model_index) {
+			VoxelBlockyModel::BakedData::Model &model = loaded_data.models[model_index].model;
+			for (unsigned int surface_index = 0; surface_index < model.surface_count; ++surface_index) {
+				model.surfaces[surface_index].material_id =
+						baked_data.models[model_index].model.surfaces[surface_index].material_id;
+			}
+		}
+		ZN_TEST_ASSERT(is_same_baked_data(baked_data, loaded_data));
+	}
+	{
+		// Data baked from another configuration must not be loaded
+		VoxelBlockyLibraryBase::BakedData loaded_data;
+		ZN_TEST_ASSERT(!BlockyLibraryCache::deserialize(to_span_const(cache_data), content_hash + 1, loaded_data));
+	}
+	{
+		// Truncated data must be rejected
+		VoxelBlockyLibraryBase::BakedData loaded_data;
+		Span<const uint8_t> truncated_data = to_span_const(cache_data).sub(0, cache_data.size() / 2);
+		ZN_TEST_ASSERT(!BlockyLibraryCache::deserialize(truncated_data, content_hash, loaded_data));
+	}
+
+	// Through a library
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+	const String cache_path = test_dir.get_path().path_join("library.vxbl");
+
+	library->set_bake_cache_path(cache_path);
+	library->bake();
+
+	Ref<VoxelBlockyLibrary> cached_library;
+	cached_library.instantiate();
+	add_test_models(**cached_library, material);
+	cached_library->set_bake_cache_path(cache_path);
+	cached_library->bake();
+
+	ZN_TEST_ASSERT(is_same_baked_data(library->get_baked_data(), cached_library->get_baked_data()));
+}
+
+void test_voxel_blocky_library_flat_baked_data() {
+	Ref<StandardMaterial3D> material;
+	material.instantiate();
+
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+	add_test_models(**library, material);
+	library->set_bake_tangents(true);
+	library->bake();
+
+	const VoxelBlockyLibraryBase::BakedData &baked_data = library->get_baked_data();
+	const VoxelBlockyLibraryBase::FlatBakedData &flat = baked_data.flat;
+	ZN_TEST_ASSERT(flat.models.size() == baked_data.models.size());
+
+	// Side geometry in the pool must be the same as in models
+	for (unsigned int model_index = 0; model_index < baked_data.models.size(); ++model_index) {
+		const VoxelBlockyModel::BakedData &model_data = baked_data.models[model_index];
+		const VoxelBlockyLibraryBase::FlatBakedData::Model &flat_model = flat.models[model_index];
+		ZN_TEST_ASSERT(flat_model.surface_count == model_data.model.surface_count);
+		ZN_TEST_ASSERT(flat_model.empty_sides_mask == model_data.model.empty_sides_mask);
+		ZN_TEST_ASSERT(flat_model.culls_neighbors == (model_data.culls_neighbors && !model_data.empty));
+
+		for (unsigned int side = 0; side < Cube::SIDE_COUNT; ++side) {
+			ZN_TEST_ASSERT(
+					flat.side_pattern_indices[flat.get_side_index(model_index, side)] ==
+					model_data.model.side_pattern_indices[side]
+			);
+
+			for (unsigned int surface_index = 0; surface_index < flat_model.surface_count; ++surface_index) {
+				const VoxelBlockyModel::BakedData::Surface &surface = model_data.model.surfaces[surface_index];
+				const VoxelBlockyModel::BakedData::SideSurface &side_surface = surface.sides[side];
+				const VoxelBlockyLibraryBase::FlatBakedData::SideSurface &flat_side_surface =
+						flat.get_side_surface(model_index, side, surface_index);
+
+				ZN_TEST_ASSERT(flat_side_surface.material_id == surface.material_id);
+				ZN_TEST_ASSERT(flat_side_surface.vertex_count == side_surface.positions.size());
+				ZN_TEST_ASSERT(flat_side_surface.index_count == side_surface.indices.size());
+				ZN_TEST_ASSERT(flat_side_surface.has_tangents == (side_surface.tangents.size() > 0));
+
+				for (unsigned int i = 0; i < flat_side_surface.vertex_count; ++i) {
+					const unsigned int vi = flat_side_surface.vertex_begin + i;
+					ZN_TEST_ASSERT(flat.positions[vi] == side_surface.positions[i]);
+					ZN_TEST_ASSERT(flat.uvs[vi] == side_surface.uvs[i]);
+				}
+				for (unsigned int i = 0; i < side_surface.tangents.size(); ++i) {
+					ZN_TEST_ASSERT(flat.tangents[flat_side_surface.vertex_begin * 4 + i] == side_surface.tangents[i]);
+				}
+				for (unsigned int i = 0; i < flat_side_surface.index_count; ++i) {
+					ZN_TEST_ASSERT(flat.indices[flat_side_surface.index_begin + i] == side_surface.indices[i]);
+				}
+			}
+		}
+	}
+}
+
+void test_voxel_blocky_library_flat_meshing() {
+	Ref<VoxelBlockyLibrary> library = make_mixed_test_library();
+	const VoxelBlockyLibraryBase::BakedData &baked_data = library->get_baked_data();
+
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	make_mixed_test_block(voxels, 16, baked_data.models.size());
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+	// The reference doesn't do ambient occlusion
+	mesher->set_occlusion_enabled(false);
+
+	// LOD 1 also adds seams
+	for (unsigned int lod_index = 0; lod_index < 2; ++lod_index) {
+		VoxelMesher::Output output;
+		const VoxelMesher::Input input{ voxels, nullptr, Vector3i(), static_cast<uint8_t>(lod_index), false };
+		mesher->build(output, input);
+
+		StdVector<VoxelMesherBlocky::Arrays> expected_arrays_per_material;
+		build_mesh_from_models(voxels, baked_data, lod_index, expected_arrays_per_material);
+
+		unsigned int expected_surface_count = 0;
+		for (const VoxelMesherBlocky::Arrays &arrays : expected_arrays_per_material) {
+			if (arrays.positions.size() > 0) {
+				++expected_surface_count;
+			}
+		}
+		ZN_TEST_ASSERT(output.surfaces.size() == expected_surface_count);
+
+		StdVector<TestTriangle> triangles;
+		StdVector<TestTriangle> expected_triangles;
+
+		for (const VoxelMesher::Output::Surface &surface : output.surfaces) {
+			ZN_TEST_ASSERT(surface.material_index < expected_arrays_per_material.size());
+			get_sorted_triangles(surface.arrays, triangles);
+			get_sorted_triangles(expected_arrays_per_material[surface.material_index], expected_triangles);
+			ZN_TEST_ASSERT(triangles.size() > 0);
+			ZN_TEST_ASSERT(triangles == expected_triangles);
+		}
+	}
+}
+
+void test_voxel_blocky_library_flat_meshing_benchmark() {
+	Ref<VoxelBlockyLibrary> library = make_mixed_test_library();
+	const VoxelBlockyLibraryBase::BakedData &baked_data = library->get_baked_data();
+
+	VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	make_mixed_test_block(voxels, 32, baked_data.models.size());
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+	mesher->set_occlusion_enabled(false);
+
+	const unsigned int iterations = 20;
+	const VoxelMesher::Input input{ voxels, nullptr, Vector3i(), 0, false };
+
+	ProfilingClock profiling_clock;
+
+	for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+		VoxelMesher::Output output;
+		mesher->build(output, input);
+	}
+
+	const uint64_t flat_time = profiling_clock.restart();
+
+	StdVector<VoxelMesherBlocky::Arrays> arrays_per_material;
+	for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+		build_mesh_from_models(voxels, baked_data, 0, arrays_per_material);
+	}
+
+	const uint64_t per_model_time = profiling_clock.restart();
+
+	// The mesher also converts its arrays to Godot arrays, so it does a bit more work than the reference
+	print_line(format(
+			"VoxelMesherBlocky with {} iterations of a mixed block: flat layout {} us, per-model layout {} us",
+			iterations,
+			flat_time,
+			per_model_time
+	));
+}
+
+} // namespace zylann::voxel::tests
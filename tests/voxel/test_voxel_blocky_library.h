@@ -0,0 +1,16 @@
+#ifndef VOXEL_TESTS_VOXEL_BLOCKY_LIBRARY_H
+#define VOXEL_TESTS_VOXEL_BLOCKY_LIBRARY_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_blocky_library_rebake();
+void test_voxel_blocky_library_mesh_rebake();
+void test_voxel_blocky_type_library_rebake();
+void test_voxel_blocky_library_cache();
+void test_voxel_blocky_library_flat_baked_data();
+void test_voxel_blocky_library_flat_meshing();
+void test_voxel_blocky_library_flat_meshing_benchmark();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_BLOCKY_LIBRARY_H
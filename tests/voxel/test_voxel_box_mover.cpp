@@ -0,0 +1,287 @@
+#include "test_voxel_box_mover.h"
+#include "../../meshers/blocky/voxel_blocky_library.h"
+#include "../../meshers/blocky/voxel_blocky_model_cube.h"
+#include "../../meshers/blocky/voxel_blocky_model_empty.h"
+#include "../../meshers/blocky/voxel_blocky_model_mesh.h"
+#include "../../meshers/blocky/voxel_mesher_blocky.h"
+#include "../../storage/voxel_data.h"
+#include "../../terrain/fixed_lod/voxel_box_mover.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+// Library where voxels with ID 1 are solid. If `full_cube` is false, they use two collision boxes forming a cube, so
+// they can't take the fast path.
+Ref<VoxelMesherBlocky> make_solid_mesher(bool full_cube) {
+	Ref<VoxelBlockyLibrary> library;
+	library.instantiate();
+
+	Ref<VoxelBlockyModelEmpty> air;
+	air.instantiate();
+	library->add_model(air);
+
+	if (full_cube) {
+		Ref<VoxelBlockyModelCube> solid;
+		solid.instantiate();
+		library->add_model(solid);
+	} else {
+		Ref<VoxelBlockyModelMesh> solid;
+		solid.instantiate();
+		const AABB halves[] = {
+			AABB(Vector3(0, 0, 0), Vector3(1, 0.5, 1)), //
+			AABB(Vector3(0, 0.5, 0), Vector3(1, 0.5, 1)) //
+		};
+		solid->set_collision_aabbs(Span<const AABB>(halves, 2));
+		library->add_model(solid);
+	}
+
+	library->bake();
+
+	Ref<VoxelMesherBlocky> mesher;
+	mesher.instantiate();
+	mesher->set_library(library);
+	return mesher;
+}
+
+// Flat ground below Y=0, with a grid of pillars
+void make_test_world(VoxelData &data) {
+	const int block_size = data.get_block_size();
+	const Box3i blocks_box(-4, -2, -4, 8, 4, 8);
+	// Outside of bounds, voxels always read as air
+	data.set_bounds(Box3i(blocks_box.position * block_size, blocks_box.size * block_size));
+
+	blocks_box.for_each_cell_zxy([&data, block_size](Vector3i block_pos) {
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+
+		const Vector3i origin = block_pos * block_size;
+		if (origin.y + block_size <= 0) {
+			buffer->fill(1, VoxelBuffer::CHANNEL_TYPE);
+
+		} else if (origin.y < 8) {
+			for (int z = 0; z < block_size; ++z) {
+				for (int x = 0; x < block_size; ++x) {
+					const Vector3i pos = origin + Vector3i(x, 0, z);
+					const bool pillar = math::wrap(pos.x, 8) < 2 && math::wrap(pos.z, 8) < 2;
+					for (int y = 0; y < block_size; ++y) {
+						if (pillar && origin.y + y < 4) {
+							buffer->set_voxel(1, x, y, z, VoxelBuffer::CHANNEL_TYPE);
+						}
+					}
+				}
+			}
+		}
+
+		VoxelDataBlock block(buffer, 0);
+		ZN_TEST_ASSERT(data.try_set_block(block_pos, block));
+	});
+}
+
+void make_random_boxes(
+		unsigned int count,
+		uint64_t seed,
+		StdVector<Vector3> &out_positions,
+		StdVector<Vector3> &out_motions
+) {
+	RandomPCG rng;
+	rng.seed(seed);
+	for (unsigned int i = 0; i < count; ++i) {
+		// Start above the ground, some of them will go into pillars
+		out_positions.push_back(Vector3(rng.randf() * 40.f - 20.f, rng.randf() * 6.f, rng.randf() * 40.f - 20.f));
+		out_motions.push_back(Vector3(rng.randf() * 4.f - 2.f, rng.randf() * 4.f - 3.f, rng.randf() * 4.f - 2.f));
+	}
+}
+
+// Moves boxes with one call per box
+void get_motions_one_by_one(
+		VoxelBoxMover &mover,
+		VoxelData &data,
+		const Ref<VoxelMesher> &mesher,
+		Span<const Vector3> positions,
+		Span<const Vector3> motions,
+		AABB aabb,
+		Span<Vector3> out_motions
+) {
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		mover.get_motions_in_data(
+				data,
+				mesher,
+				to_single_element_span(positions[i]),
+				to_single_element_span(motions[i]),
+				aabb,
+				to_single_element_span(out_motions[i])
+		);
+	}
+}
+
+} // namespace
+
+void test_voxel_box_mover_full_cubes() {
+	VoxelData data;
+	make_test_world(data);
+
+	const AABB aabb(Vector3(-0.4, 0.0, -0.4), Vector3(0.8, 1.8, 0.8));
+
+	Ref<VoxelBoxMover> mover;
+	mover.instantiate();
+
+	// Falling on the ground
+	{
+		Ref<VoxelMesherBlocky> mesher = make_solid_mesher(true);
+		const Vector3 position(4.5, 2.0, 4.5);
+		const Vector3 motion(0.0, -5.0, 0.0);
+		Vector3 result;
+		mover->get_motions_in_data(
+				data,
+				mesher,
+				to_single_element_span(position),
+				to_single_element_span(motion),
+				aabb,
+				to_single_element_span(result)
+		);
+		ZN_TEST_ASSERT(Math::is_equal_approx(result.x, real_t(0.0)));
+		ZN_TEST_ASSERT(Math::is_equal_approx(result.z, real_t(0.0)));
+		// The box stops right above the ground
+		ZN_TEST_ASSERT(Math::abs(position.y + result.y) < 0.01);
+		ZN_TEST_ASSERT(position.y + result.y >= 0.0);
+	}
+
+	// Step climbing is reported for each box of a batch
+	{
+		Ref<VoxelMesherBlocky> mesher = make_solid_mesher(true);
+		mover->set_step_climbing_enabled(true);
+		mover->set_max_step_height(5.0);
+		// The first box walks into a pillar, the last one moves freely
+		const StdVector<Vector3> positions{ Vector3(3.0, 0.001, 1.0), Vector3(4.5, 0.001, 4.5) };
+		const StdVector<Vector3> motions{ Vector3(-1.5, 0.0, 0.3), Vector3(0.5, 0.0, 0.0) };
+		StdVector<Vector3> results;
+		results.resize(positions.size());
+		StdVector<uint8_t> stepped_up;
+		stepped_up.resize(positions.size());
+		mover->get_motions_in_data(
+				data, mesher, to_span(positions), to_span(motions), aabb, to_span(results), to_span(stepped_up)
+		);
+		ZN_TEST_ASSERT(stepped_up[0] == 1);
+		ZN_TEST_ASSERT(positions[0].y + results[0].y >= 4.0);
+		ZN_TEST_ASSERT(stepped_up[1] == 0);
+		ZN_TEST_ASSERT(results[1].is_equal_approx(motions[1]));
+		// Only the last box is reported here
+		ZN_TEST_ASSERT(mover->has_stepped_up() == false);
+		mover->set_step_climbing_enabled(false);
+	}
+
+	// Full cubes taking the fast path must give the same results as generic collision boxes
+	StdVector<Vector3> positions;
+	StdVector<Vector3> motions;
+	make_random_boxes(1000, 131183, positions, motions);
+
+	StdVector<Vector3> fast_motions;
+	fast_motions.resize(motions.size());
+	mover->get_motions_in_data(
+			data, make_solid_mesher(true), to_span(positions), to_span(motions), aabb, to_span(fast_motions)
+	);
+
+	StdVector<Vector3> generic_motions;
+	generic_motions.resize(motions.size());
+	mover->get_motions_in_data(
+			data, make_solid_mesher(false), to_span(positions), to_span(motions), aabb, to_span(generic_motions)
+	);
+
+	unsigned int collision_count = 0;
+	for (unsigned int i = 0; i < motions.size(); ++i) {
+		ZN_TEST_ASSERT(fast_motions[i].is_equal_approx(generic_motions[i]));
+		if (!fast_motions[i].is_equal_approx(motions[i])) {
+			++collision_count;
+		}
+	}
+	// Many boxes go down into the ground
+	ZN_TEST_ASSERT(collision_count > 0);
+}
+
+void test_voxel_box_mover_batch() {
+	VoxelData data;
+	make_test_world(data);
+
+	const AABB aabb(Vector3(-0.4, 0.0, -0.4), Vector3(0.8, 1.8, 0.8));
+	const unsigned int entity_count = 200;
+
+	StdVector<Vector3> positions;
+	StdVector<Vector3> motions;
+	make_random_boxes(entity_count, 271828, positions, motions);
+
+	Ref<VoxelBoxMover> mover;
+	mover.instantiate();
+
+	// Moving boxes in a batch gives the same results as moving them one by one
+	for (const bool full_cube : { true, false }) {
+		Ref<VoxelMesherBlocky> mesher = make_solid_mesher(full_cube);
+
+		StdVector<Vector3> single_motions;
+		single_motions.resize(entity_count);
+		get_motions_one_by_one(
+				**mover, data, mesher, to_span(positions), to_span(motions), aabb, to_span(single_motions)
+		);
+
+		StdVector<Vector3> batch_motions;
+		batch_motions.resize(entity_count);
+		mover->get_motions_in_data(data, mesher, to_span(positions), to_span(motions), aabb, to_span(batch_motions));
+
+		for (unsigned int i = 0; i < entity_count; ++i) {
+			ZN_TEST_ASSERT(single_motions[i].is_equal_approx(batch_motions[i]));
+		}
+	}
+}
+
+void test_voxel_box_mover_benchmark() {
+	VoxelData data;
+	make_test_world(data);
+
+	const AABB aabb(Vector3(-0.4, 0.0, -0.4), Vector3(0.8, 1.8, 0.8));
+	const unsigned int entity_count = 1000;
+	const unsigned int iterations = 10;
+
+	StdVector<Vector3> positions;
+	StdVector<Vector3> motions;
+	make_random_boxes(entity_count, 271828, positions, motions);
+
+	Ref<VoxelBoxMover> mover;
+	mover.instantiate();
+
+	for (const bool full_cube : { true, false }) {
+		Ref<VoxelMesherBlocky> mesher = make_solid_mesher(full_cube);
+
+		StdVector<Vector3> out_motions;
+		out_motions.resize(entity_count);
+
+		ProfilingClock profiling_clock;
+
+		for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+			get_motions_one_by_one(
+					**mover, data, mesher, to_span(positions), to_span(motions), aabb, to_span(out_motions)
+			);
+		}
+
+		const uint64_t single_time = profiling_clock.restart();
+
+		for (unsigned int iteration = 0; iteration < iterations; ++iteration) {
+			mover->get_motions_in_data(data, mesher, to_span(positions), to_span(motions), aabb, to_span(out_motions));
+		}
+
+		const uint64_t batch_time = profiling_clock.restart();
+
+		print_line(format(
+				"VoxelBoxMover with {} entities, {}: one by one {} us, batched {} us",
+				entity_count,
+				full_cube ? "full cubes" : "collision boxes",
+				single_time / iterations,
+				batch_time / iterations
+		));
+	}
+}
+
+} // namespace zylann::voxel::tests
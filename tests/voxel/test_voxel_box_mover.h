@@ -0,0 +1,12 @@
+#ifndef VOXEL_TESTS_VOXEL_BOX_MOVER_H
+#define VOXEL_TESTS_VOXEL_BOX_MOVER_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_box_mover_full_cubes();
+void test_voxel_box_mover_batch();
+void test_voxel_box_mover_benchmark();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_BOX_MOVER_H
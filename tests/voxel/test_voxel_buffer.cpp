@@ -118,14 +118,13 @@ void test_voxel_buffer_metadata() {
 		VoxelBuffer rvb(VoxelBuffer::ALLOCATOR_DEFAULT);
 		ZN_TEST_ASSERT(BlockSerializer::deserialize(to_span(bytes), rvb));
 
-		const FlatMapMoveOnly<Vector3i, VoxelMetadata> &vb_meta_map = vb.get_voxel_metadata();
-		const FlatMapMoveOnly<Vector3i, VoxelMetadata> &rvb_meta_map = rvb.get_voxel_metadata();
+		const VoxelMetadataMap &vb_meta_map = vb.get_voxel_metadata();
+		const VoxelMetadataMap &rvb_meta_map = rvb.get_voxel_metadata();
 
 		ZN_TEST_ASSERT(vb_meta_map.size() == rvb_meta_map.size());
 
-		for (auto it = vb_meta_map.begin(); it != vb_meta_map.end(); ++it) {
-			const VoxelMetadata &meta = it->value;
-			const VoxelMetadata *rmeta = rvb_meta_map.find(it->key);
+		vb_meta_map.for_each([&rvb_meta_map](Vector3i pos, const VoxelMetadata &meta) {
+			const VoxelMetadata *rmeta = rvb_meta_map.find(pos);
 
 			ZN_TEST_ASSERT(rmeta != nullptr);
 			ZN_TEST_ASSERT(rmeta->get_type() == meta.get_type());
@@ -145,7 +144,7 @@ void test_voxel_buffer_metadata() {
 					ZN_TEST_ASSERT(false);
 					break;
 			}
-		}
+		});
 	}
 }
 
@@ -202,16 +201,15 @@ void test_voxel_buffer_metadata_gd() {
 		// `equals` does not compare metadata at the moment, mainly because it's not trivial and there is no use case
 		// for it apart from this test, so do it manually
 
-		const FlatMapMoveOnly<Vector3i, VoxelMetadata> &vb_meta_map = vb->get_buffer().get_voxel_metadata();
-		const FlatMapMoveOnly<Vector3i, VoxelMetadata> &vb2_meta_map = vb2->get_buffer().get_voxel_metadata();
+		const VoxelMetadataMap &vb_meta_map = vb->get_buffer().get_voxel_metadata();
+		const VoxelMetadataMap &vb2_meta_map = vb2->get_buffer().get_voxel_metadata();
 
 		ZN_TEST_ASSERT(vb_meta_map.size() == vb2_meta_map.size());
 
-		for (auto it = vb_meta_map.begin(); it != vb_meta_map.end(); ++it) {
-			const VoxelMetadata &meta = it->value;
+		vb_meta_map.for_each([&vb2_meta_map](Vector3i pos, const VoxelMetadata &meta) {
 			ZN_TEST_ASSERT(meta.get_type() == godot::METADATA_TYPE_VARIANT);
 
-			const VoxelMetadata *meta2 = vb2_meta_map.find(it->key);
+			const VoxelMetadata *meta2 = vb2_meta_map.find(pos);
 			ZN_TEST_ASSERT(meta2 != nullptr);
 			ZN_TEST_ASSERT(meta2->get_type() == meta.get_type());
 
@@ -220,8 +218,83 @@ void test_voxel_buffer_metadata_gd() {
 			const godot::VoxelMetadataVariant &meta2v =
 					static_cast<const godot::VoxelMetadataVariant &>(meta2->get_custom());
 			ZN_TEST_ASSERT(metav.data == meta2v.data);
+		});
+	}
+}
+
+void test_voxel_buffer_metadata_area() {
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	// Not a multiple of the cell size of the metadata map
+	vb.create(18, 18, 18);
+
+	struct L {
+		static uint64_t get_value(Vector3i pos) {
+			return (pos.x + pos.y + pos.z) % 3;
 		}
+	};
+
+	// Many voxels sharing few distinct values, like a room full of identical containers
+	const Box3i box(Vector3i(2, 5, 1), Vector3i(7, 9, 11));
+	unsigned int count = 0;
+	unsigned int count_in_box = 0;
+	Vector3i vpos;
+	for (vpos.z = 0; vpos.z < vb.get_size().z; vpos.z += 3) {
+		for (vpos.x = 0; vpos.x < vb.get_size().x; vpos.x += 3) {
+			for (vpos.y = 0; vpos.y < vb.get_size().y; vpos.y += 3) {
+				VoxelMetadata *meta = vb.get_or_create_voxel_metadata(vpos);
+				ZN_TEST_ASSERT(meta != nullptr);
+				meta->set_u64(L::get_value(vpos));
+				++count;
+				if (box.contains(vpos)) {
+					++count_in_box;
+				}
+			}
+		}
+	}
+	ZN_TEST_ASSERT(vb.get_voxel_metadata().size() == count);
+
+	unsigned int visited_count = 0;
+	vb.for_each_voxel_metadata_in_area(box, [&box, &visited_count](Vector3i pos, const VoxelMetadata &meta) {
+		ZN_TEST_ASSERT(box.contains(pos));
+		ZN_TEST_ASSERT(meta.get_type() == VoxelMetadata::TYPE_U64);
+		ZN_TEST_ASSERT(meta.get_u64() == L::get_value(pos));
+		++visited_count;
+	});
+	ZN_TEST_ASSERT(visited_count == count_in_box);
+
+	// Serialization
+	{
+		VoxelBuffer empty_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		empty_vb.create(vb.get_size());
+		const size_t size_without_metadata = BlockSerializer::serialize(empty_vb).data.size();
+
+		BlockSerializer::SerializeResult sresult = BlockSerializer::serialize(vb);
+		ZN_TEST_ASSERT(sresult.success);
+		StdVector<uint8_t> bytes = sresult.data;
+
+		// Identical items are stored once, so entries should only take a few bytes each
+		ZN_TEST_ASSERT(bytes.size() - size_without_metadata < 3 * count + 64);
+
+		VoxelBuffer rvb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		ZN_TEST_ASSERT(BlockSerializer::deserialize(to_span(bytes), rvb));
+		ZN_TEST_ASSERT(rvb.get_voxel_metadata().size() == count);
+
+		vb.get_voxel_metadata().for_each([&rvb](Vector3i pos, const VoxelMetadata &meta) {
+			const VoxelMetadata *rmeta = rvb.get_voxel_metadata(pos);
+			ZN_TEST_ASSERT(rmeta != nullptr);
+			ZN_TEST_ASSERT(rmeta->get_type() == VoxelMetadata::TYPE_U64);
+			ZN_TEST_ASSERT(rmeta->get_u64() == meta.get_u64());
+		});
 	}
+
+	vb.clear_voxel_metadata_in_area(box);
+	ZN_TEST_ASSERT(vb.get_voxel_metadata().size() == count - count_in_box);
+
+	visited_count = 0;
+	vb.for_each_voxel_metadata_in_area(box, [&visited_count](Vector3i pos, const VoxelMetadata &meta) { //
+		++visited_count;
+	});
+	ZN_TEST_ASSERT(visited_count == 0);
 }
 
 namespace {
@@ -0,0 +1,87 @@
+#include "test_voxel_edit_journal.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../util/memory/memory.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_edit_journal() {
+	static const unsigned int channel = VoxelBuffer::CHANNEL_TYPE;
+
+	VoxelData data;
+	data.set_edit_journal_max_memory(1024 * 1024);
+
+	const int block_size = data.get_block_size();
+	const Box3i blocks_box(Vector3i(), Vector3i(2, 1, 1));
+	// Outside of bounds, voxels always read as the default value
+	data.set_bounds(Box3i(blocks_box.position * block_size, blocks_box.size * block_size));
+	blocks_box.for_each_cell_zxy([&data, block_size](Vector3i block_pos) {
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+		VoxelDataBlock block(buffer, 0);
+		ZN_TEST_ASSERT(data.try_set_block(block_pos, block));
+	});
+
+	auto get_voxel = [&data](Vector3i pos) { //
+		return data.get_voxel(pos, channel, VoxelSingleValue()).i;
+	};
+
+	VoxelEditJournal::Snapshot snapshot;
+
+	const Vector3i edited_pos(1, 2, 3);
+	const Box3i edited_box(edited_pos, Vector3i(1, 1, 1));
+	data.begin_journaled_edit(edited_box, snapshot);
+	ZN_TEST_ASSERT(data.try_set_voxel(5, edited_pos, channel));
+	data.end_journaled_edit(snapshot);
+	ZN_TEST_ASSERT(data.get_edit_tick() == 1);
+
+	// Changes the journal doesn't know about, like async edits or network sync, must survive undos and redos
+	const Vector3i other_pos(4, 5, 6);
+	ZN_TEST_ASSERT(data.try_set_voxel(7, other_pos, channel));
+
+	Box3i changed_box;
+	ZN_TEST_ASSERT(data.undo_edit(changed_box));
+	ZN_TEST_ASSERT(changed_box.contains(edited_box));
+	ZN_TEST_ASSERT(data.get_edit_tick() == 0);
+	ZN_TEST_ASSERT(get_voxel(edited_pos) == 0);
+	ZN_TEST_ASSERT(get_voxel(other_pos) == 7);
+
+	ZN_TEST_ASSERT(data.redo_edit(changed_box));
+	ZN_TEST_ASSERT(data.get_edit_tick() == 1);
+	ZN_TEST_ASSERT(get_voxel(edited_pos) == 5);
+	ZN_TEST_ASSERT(get_voxel(other_pos) == 7);
+
+	// Metadata edits are recorded too
+	const Vector3i meta_pos(block_size + 1, 1, 1);
+	const Box3i meta_box(meta_pos, Vector3i(1, 1, 1));
+	data.begin_journaled_edit(meta_box, snapshot);
+	data.set_voxel_metadata(meta_pos, 42);
+	data.end_journaled_edit(snapshot);
+	ZN_TEST_ASSERT(data.get_edit_tick() == 2);
+
+	ZN_TEST_ASSERT(data.undo_edit(changed_box));
+	ZN_TEST_ASSERT(data.get_voxel_metadata(meta_pos).get_type() == Variant::NIL);
+	ZN_TEST_ASSERT(data.redo_edit(changed_box));
+	ZN_TEST_ASSERT(data.get_voxel_metadata(meta_pos) == Variant(42));
+
+	// Metadata edits replace the whole block, so they can't be undone once the block changed outside the journal
+	const Vector3i other_pos2(block_size + 2, 1, 1);
+	ZN_TEST_ASSERT(data.try_set_voxel(9, other_pos2, channel));
+	ZN_TEST_ASSERT(data.undo_edit(changed_box) == false);
+	ZN_TEST_ASSERT(data.get_edit_tick() == 2);
+	ZN_TEST_ASSERT(data.get_voxel_metadata(meta_pos) == Variant(42));
+	ZN_TEST_ASSERT(get_voxel(other_pos2) == 9);
+
+	// Seeking stops at the edit that can't be applied
+	ZN_TEST_ASSERT(data.seek_edit_tick(0, changed_box) == false);
+	ZN_TEST_ASSERT(data.get_edit_tick() == 2);
+
+	// Disabling the journal clears it
+	data.set_edit_journal_max_memory(0);
+	ZN_TEST_ASSERT(data.get_edit_tick() == 0);
+	Box3i unused_box;
+	ZN_TEST_ASSERT(data.undo_edit(unused_box) == false);
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,10 @@
+#ifndef VOXEL_TEST_VOXEL_EDIT_JOURNAL_H
+#define VOXEL_TEST_VOXEL_EDIT_JOURNAL_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_edit_journal();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_VOXEL_EDIT_JOURNAL_H
@@ -0,0 +1,261 @@
+#include "test_voxel_generator_multipass.h"
+#include "../../engine/voxel_engine.h"
+#include "../../generators/multipass/generate_column_multipass_task.h"
+#include "../../generators/multipass/multipass_column_cache.h"
+#include "../../generators/multipass/voxel_generator_multipass_cb.h"
+#include "../../util/godot/classes/time.h"
+#include "../../util/hash_funcs.h"
+#include "../../util/math/funcs.h"
+#include "../../util/string/format.h"
+#include "../../util/thread/thread.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+// Generates a simple heightmap in the first pass, and "structures" overlapping neighbor columns in next passes.
+// The workload is small so the benchmark mostly measures scheduling.
+class TestMultipassGenerator : public VoxelGeneratorMultipassCB {
+public:
+	void generate_pass(VoxelGeneratorMultipassCBStructs::PassInput input) override {
+		using namespace VoxelGeneratorMultipassCBStructs;
+
+		const int bs = input.block_size;
+		const Vector3i main_rpos = input.main_block_position - input.grid_origin;
+		const unsigned int channel = VoxelBuffer::CHANNEL_TYPE;
+
+		if (input.pass_index == 0) {
+			for (int rby = 0; rby < input.grid_size.y; ++rby) {
+				Block *block = input.grid[Vector3iUtil::get_zxy_index(
+						Vector3i(main_rpos.x, rby, main_rpos.z), input.grid_size
+				)];
+				const Vector3i origin = (input.grid_origin + Vector3i(main_rpos.x, rby, main_rpos.z)) * bs;
+
+				for (int z = 0; z < bs; ++z) {
+					for (int x = 0; x < bs; ++x) {
+						const int height = (hash_murmur3_one_32(origin.x + x, hash_murmur3_one_32(origin.z + z)) % 8);
+						for (int y = 0; y < bs; ++y) {
+							block->voxels.set_voxel(origin.y + y < height ? 1 : 0, x, y, z, channel);
+						}
+					}
+				}
+			}
+
+		} else {
+			const Vector3i grid_size_voxels = input.grid_size * bs;
+			const Vector3i main_origin_rvoxels = main_rpos * bs;
+			const uint32_t seed = hash_murmur3_one_32(input.main_block_position.x, input.main_block_position.z);
+			const int structure_radius = 2;
+
+			for (unsigned int i = 0; i < 8; ++i) {
+				const uint32_t h = hash_murmur3_one_32(i, seed);
+				// Centers near edges so structures spill into neighbors
+				const Vector3i center = main_origin_rvoxels +
+						Vector3i(h % bs, (h >> 8) % grid_size_voxels.y, (h >> 16) % bs) +
+						Vector3i(i % 2 == 0 ? -1 : 1, 0, i % 4 < 2 ? -1 : 1);
+
+				for (int z = center.z - structure_radius; z <= center.z + structure_radius; ++z) {
+					for (int x = center.x - structure_radius; x <= center.x + structure_radius; ++x) {
+						for (int y = center.y - structure_radius; y <= center.y + structure_radius; ++y) {
+							const Vector3i rpos(x, y, z);
+							if (x < 0 || y < 0 || z < 0 || x >= grid_size_voxels.x || y >= grid_size_voxels.y ||
+								z >= grid_size_voxels.z) {
+								continue;
+							}
+							const Vector3i rbpos = rpos / bs;
+							Block *block = input.grid[Vector3iUtil::get_zxy_index(rbpos, input.grid_size)];
+							const Vector3i lpos = rpos - rbpos * bs;
+							block->voxels.set_voxel(input.pass_index + 1, lpos, channel);
+						}
+					}
+				}
+			}
+		}
+	}
+};
+
+// Gets scheduled back when a column is fully generated
+class ColumnCompletionTask : public IThreadedTask {
+public:
+	ColumnCompletionTask(std::shared_ptr<std::atomic_int> p_completed_count) : _completed_count(p_completed_count) {}
+
+	const char *get_debug_name() const override {
+		return "ColumnCompletionTask";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		++(*_completed_count);
+	}
+
+private:
+	std::shared_ptr<std::atomic_int> _completed_count;
+};
+
+} // namespace
+
+void test_voxel_generator_multipass_cb_threads() {
+	// Generates the same area from scratch with different thread counts, checks every column completed, and reports
+	// the throughput.
+
+	const int block_size = 16;
+	const int area_size_columns = 16;
+	const uint64_t timeout_msec = 60'000;
+
+	VoxelEngine &engine = VoxelEngine::get_singleton();
+	const unsigned int initial_thread_count = engine.get_thread_count();
+
+	const unsigned int thread_counts[] = { 4, 8, 16 };
+
+	for (const unsigned int thread_count : thread_counts) {
+		engine.set_thread_count(thread_count);
+
+		Ref<TestMultipassGenerator> generator;
+		generator.instantiate();
+		generator->set_pass_count(3);
+		generator->set_column_base_y_blocks(-2);
+		generator->set_column_height_blocks(4);
+
+		const int final_subpass_index =
+				VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(generator->get_pass_count()) - 1;
+
+		const Box3i requested_box(
+				Vector3i(-area_size_columns / 2, generator->get_column_base_y_blocks(), -area_size_columns / 2),
+				Vector3i(area_size_columns, generator->get_column_height_blocks(), area_size_columns)
+		);
+		const ViewerID viewer_id;
+		generator->process_viewer_diff(viewer_id, requested_box, Box3i());
+
+		std::shared_ptr<VoxelGeneratorMultipassCBStructs::Internal> internal = generator->get_internal();
+		std::shared_ptr<std::atomic_int> completed_count = make_shared_instance<std::atomic_int>(0);
+
+		const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+
+		StdVector<IThreadedTask *> tasks;
+		for (int z = 0; z < requested_box.size.z; ++z) {
+			for (int x = 0; x < requested_box.size.x; ++x) {
+				const Vector2i column_position(requested_box.position.x + x, requested_box.position.z + z);
+				tasks.push_back(ZN_NEW(GenerateColumnMultipassTask(
+						column_position,
+						block_size,
+						final_subpass_index,
+						internal,
+						generator,
+						TaskPriority(),
+						ZN_NEW(ColumnCompletionTask(completed_count)),
+						make_shared_instance<std::atomic_int>(1)
+				)));
+			}
+		}
+		const int column_count = tasks.size();
+		engine.push_async_tasks(to_span(tasks));
+
+		while (*completed_count < column_count) {
+			Thread::sleep_usec(500);
+			ZN_TEST_ASSERT_MSG(
+					Time::get_singleton()->get_ticks_usec() - time_before < timeout_msec * 1000,
+					"Generation took too long, tasks might be stuck"
+			);
+		}
+
+		const uint64_t time_spent_usec = Time::get_singleton()->get_ticks_usec() - time_before;
+
+		engine.wait_and_clear_all_tasks(false);
+
+		StdVector<VoxelGeneratorMultipassCB::DebugColumnState> column_states;
+		ZN_TEST_ASSERT(generator->debug_try_get_column_states(column_states));
+		unsigned int final_column_count = 0;
+		for (const VoxelGeneratorMultipassCB::DebugColumnState &state : column_states) {
+			if (state.subpass_index == final_subpass_index) {
+				++final_column_count;
+			}
+		}
+		ZN_TEST_ASSERT(int(final_column_count) >= column_count);
+
+		print_line(String("Multipass generation with {0} threads: {1} columns in {2} ms, {3} columns per second")
+						   .format(varray(
+								   int64_t(thread_count),
+								   column_count,
+								   int64_t(time_spent_usec / 1000),
+								   int64_t(column_count * 1'000'000.0 / math::max(time_spent_usec, uint64_t(1)))
+						   )));
+
+		generator->process_viewer_diff(viewer_id, Box3i(), requested_box);
+	}
+
+	engine.set_thread_count(initial_thread_count);
+}
+
+void test_voxel_generator_multipass_persistent_cache() {
+	using namespace VoxelGeneratorMultipassCBStructs;
+
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const unsigned int channel = VoxelBuffer::CHANNEL_TYPE;
+	const unsigned int column_height = 3;
+	const uint64_t params_hash = 0x1234;
+	const Vector2i cpos(-2, 5);
+
+	MultipassColumnCache::ColumnData src;
+	src.subpass_index = 2;
+	src.blocks.resize(column_height);
+	for (unsigned int i = 0; i < src.blocks.size(); ++i) {
+		VoxelBuffer &voxels = src.blocks[i].voxels;
+		voxels.create(Vector3i(16, 16, 16));
+		voxels.set_voxel(static_cast<int>(i) + 1, Vector3i(1, 2, 3), channel);
+		voxels.set_voxel(static_cast<int>(i) + 10, Vector3i(15, 0, 7), channel);
+	}
+
+	{
+		MultipassColumnCache cache(test_dir.get_path(), params_hash);
+		cache.save(cpos, src);
+	}
+
+	// Reload from a different instance, like a new session would
+	MultipassColumnCache cache(test_dir.get_path(), params_hash);
+	{
+		MultipassColumnCache::ColumnData loaded;
+		ZN_TEST_ASSERT(cache.load(cpos, column_height, loaded));
+		ZN_TEST_ASSERT(loaded.subpass_index == src.subpass_index);
+		ZN_TEST_ASSERT(loaded.blocks.size() == src.blocks.size());
+		for (unsigned int i = 0; i < src.blocks.size(); ++i) {
+			ZN_TEST_ASSERT(loaded.blocks[i].voxels.equals(src.blocks[i].voxels));
+		}
+	}
+
+	// Columns that were never saved, or saved with a different height, are not found
+	{
+		MultipassColumnCache::ColumnData loaded;
+		ZN_TEST_ASSERT(cache.load(cpos + Vector2i(1, 0), column_height, loaded) == false);
+		ZN_TEST_ASSERT(cache.load(cpos, column_height + 1, loaded) == false);
+	}
+
+	// Parameters are part of the location, so other parameters don't find the column
+	{
+		MultipassColumnCache other_cache(test_dir.get_path(), params_hash + 1);
+		MultipassColumnCache::ColumnData loaded;
+		ZN_TEST_ASSERT(other_cache.load(cpos, column_height, loaded) == false);
+	}
+
+	// A pending save taken back before being written is not written anymore
+	{
+		const Vector2i pending_cpos(7, 7);
+		std::shared_ptr<MultipassColumnCache::ColumnData> data =
+				make_shared_instance<MultipassColumnCache::ColumnData>();
+		data->subpass_index = 1;
+		data->blocks.resize(column_height);
+		cache.add_pending_save(pending_cpos, data);
+
+		MultipassColumnCache::ColumnData taken;
+		ZN_TEST_ASSERT(cache.take_pending(pending_cpos, taken));
+		ZN_TEST_ASSERT(taken.subpass_index == 1);
+		ZN_TEST_ASSERT(cache.take_pending(pending_cpos, taken) == false);
+
+		cache.save_pending(pending_cpos, data);
+		MultipassColumnCache::ColumnData loaded;
+		ZN_TEST_ASSERT(cache.load(pending_cpos, column_height, loaded) == false);
+	}
+}
+
+} // namespace zylann::voxel::tests
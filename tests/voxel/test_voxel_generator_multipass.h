@@ -0,0 +1,11 @@
+#ifndef VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_H
+#define VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_generator_multipass_cb_threads();
+void test_voxel_generator_multipass_persistent_cache();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_GENERATOR_MULTIPASS_H
@@ -1,13 +1,19 @@
 #include "test_voxel_instancer.h"
 #include "../../streams/instance_data.h"
+#include "../../terrain/instancing/voxel_instance_generator.h"
+#include "../../util/godot/classes/array_mesh.h"
+#include "../../util/godot/classes/fast_noise_lite.h"
+#include "../../util/godot/core/random_pcg.h"
 #include "../../util/math/conv.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
 #include "../testing.h"
 
 namespace zylann::voxel::tests {
 
 void test_instance_data_serialization() {
 	struct L {
-		static InstanceBlockData::InstanceData create_instance(
+		static Transform3f create_instance(
 				const float x,
 				const float y,
 				const float z,
@@ -16,39 +22,50 @@ void test_instance_data_serialization() {
 				const float rotz,
 				const float scale
 		) {
-			InstanceBlockData::InstanceData d;
-			d.transform = to_transform3f(Transform3D(
+			return to_transform3f(Transform3D(
 					Basis().rotated(Vector3(rotx, roty, rotz)).scaled(Vector3(scale, scale, scale)), Vector3(x, y, z)
 			));
-			return d;
 		}
 	};
 
 	// Create some example data
 	InstanceBlockData src_data;
+	StdVector<StdVector<Transform3f>> src_transforms;
 	{
 		src_data.position_range = 30;
 		{
+			StdVector<Transform3f> transforms;
+			transforms.push_back(L::create_instance(0, 0, 0, 0, 0, 0, 1));
+			transforms.push_back(L::create_instance(10, 0, 0, 3.14, 0, 0, 1));
+			transforms.push_back(L::create_instance(0, 20, 0, 0, 3.14, 0, 1));
+			transforms.push_back(L::create_instance(0, 0, 30, 0, 0, 3.14, 1));
+
 			InstanceBlockData::LayerData layer;
 			layer.id = 1;
 			layer.scale_min = 1.f;
 			layer.scale_max = 1.f;
-			layer.instances.push_back(L::create_instance(0, 0, 0, 0, 0, 0, 1));
-			layer.instances.push_back(L::create_instance(10, 0, 0, 3.14, 0, 0, 1));
-			layer.instances.push_back(L::create_instance(0, 20, 0, 0, 3.14, 0, 1));
-			layer.instances.push_back(L::create_instance(0, 0, 30, 0, 0, 3.14, 1));
+			for (const Transform3f &t : transforms) {
+				layer.add_instance(t, src_data.get_quantized_position_range());
+			}
 			src_data.layers.push_back(layer);
+			src_transforms.push_back(transforms);
 		}
 		{
+			StdVector<Transform3f> transforms;
+			transforms.push_back(L::create_instance(0, 1, 0, 0, 0, 0, 1));
+			transforms.push_back(L::create_instance(20, 1, 0, -2.14, 0, 0, 2));
+			transforms.push_back(L::create_instance(0, 20, 0, 0, -2.14, 0, 3));
+			transforms.push_back(L::create_instance(0, 1, 20, -1, 0, 2.14, 4));
+
 			InstanceBlockData::LayerData layer;
 			layer.id = 2;
 			layer.scale_min = 1.f;
 			layer.scale_max = 4.f;
-			layer.instances.push_back(L::create_instance(0, 1, 0, 0, 0, 0, 1));
-			layer.instances.push_back(L::create_instance(20, 1, 0, -2.14, 0, 0, 2));
-			layer.instances.push_back(L::create_instance(0, 20, 0, 0, -2.14, 0, 3));
-			layer.instances.push_back(L::create_instance(0, 1, 20, -1, 0, 2.14, 4));
+			for (const Transform3f &t : transforms) {
+				layer.add_instance(t, src_data.get_quantized_position_range());
+			}
 			src_data.layers.push_back(layer);
+			src_transforms.push_back(transforms);
 		}
 	}
 
@@ -64,8 +81,8 @@ void test_instance_data_serialization() {
 	ZN_TEST_ASSERT(dst_data.position_range >= 0.f);
 	ZN_TEST_ASSERT(dst_data.position_range == src_data.position_range);
 
-	const float distance_error = math::max(src_data.position_range, InstanceBlockData::POSITION_RANGE_MINIMUM) /
-			float(InstanceBlockData::POSITION_RESOLUTION);
+	const float distance_error =
+			src_data.get_quantized_position_range() / float(InstanceBlockData::POSITION_RESOLUTION);
 
 	// Compare layers
 	for (unsigned int layer_index = 0; layer_index < dst_data.layers.size(); ++layer_index) {
@@ -79,7 +96,20 @@ void test_instance_data_serialization() {
 			ZN_TEST_ASSERT(src_layer.scale_min == dst_layer.scale_min);
 			ZN_TEST_ASSERT(src_layer.scale_max == dst_layer.scale_max);
 		}
-		ZN_TEST_ASSERT(src_layer.instances.size() == dst_layer.instances.size());
+
+		// Instances are kept quantized in memory, so they must not change when serialized
+		ZN_TEST_ASSERT(src_layer.get_instance_count() == dst_layer.get_instance_count());
+		ZN_TEST_ASSERT(src_layer.positions_x == dst_layer.positions_x);
+		ZN_TEST_ASSERT(src_layer.positions_y == dst_layer.positions_y);
+		ZN_TEST_ASSERT(src_layer.positions_z == dst_layer.positions_z);
+		ZN_TEST_ASSERT(src_layer.scales == dst_layer.scales);
+		ZN_TEST_ASSERT(src_layer.rotations == dst_layer.rotations);
+
+		StdVector<Transform3f> dst_transforms;
+		dst_transforms.resize(dst_layer.get_instance_count());
+		decode_instances_to_transforms(
+				dst_layer, dst_data.get_quantized_position_range(), Vector3f(), to_span(dst_transforms)
+		);
 
 		const float scale_error =
 				math::max(
@@ -90,19 +120,20 @@ void test_instance_data_serialization() {
 		const float rotation_error = 2.f / float(InstanceBlockData::SIMPLE_11B_V1_QUAT_RESOLUTION);
 
 		// Compare instances
-		for (unsigned int instance_index = 0; instance_index < src_layer.instances.size(); ++instance_index) {
-			const InstanceBlockData::InstanceData &src_instance = src_layer.instances[instance_index];
-			const InstanceBlockData::InstanceData &dst_instance = dst_layer.instances[instance_index];
+		const StdVector<Transform3f> &layer_src_transforms = src_transforms[layer_index];
+		ZN_TEST_ASSERT(layer_src_transforms.size() == dst_transforms.size());
 
-			ZN_TEST_ASSERT(
-					math::distance(src_instance.transform.origin, dst_instance.transform.origin) <= distance_error
-			);
+		for (unsigned int instance_index = 0; instance_index < dst_transforms.size(); ++instance_index) {
+			const Transform3f &src_transform = layer_src_transforms[instance_index];
+			const Transform3f &dst_transform = dst_transforms[instance_index];
+
+			ZN_TEST_ASSERT(math::distance(src_transform.origin, dst_transform.origin) <= distance_error);
 
-			const Basis src_basis = to_basis3(src_instance.transform.basis);
-			const Basis dst_basis = to_basis3(dst_instance.transform.basis);
+			const Basis src_basis = to_basis3(src_transform.basis);
+			const Basis dst_basis = to_basis3(dst_transform.basis);
 
 			const Vector3 src_scale = src_basis.get_scale();
-			const Vector3 dst_scale = src_basis.get_scale();
+			const Vector3 dst_scale = dst_basis.get_scale();
 			ZN_TEST_ASSERT(src_scale.distance_to(dst_scale) <= scale_error);
 
 			// Had to normalize here because Godot doesn't want to give you a Quat if the basis is scaled (even
@@ -121,4 +152,247 @@ void test_instance_data_serialization() {
 	}
 }
 
+void test_instance_data_decode_to_multimesh_buffer() {
+	RandomPCG rng;
+	rng.seed(131183);
+
+	InstanceBlockData::LayerData layer;
+	layer.id = 0;
+	layer.scale_min = 0.5f;
+	layer.scale_max = 2.f;
+
+	const float position_range = 16.f;
+	// Not a multiple of the batch size used internally
+	const unsigned int instance_count = 1000;
+
+	for (unsigned int i = 0; i < instance_count; ++i) {
+		const Vector3 position(rng.randf() * 16.0, rng.randf() * 16.0, rng.randf() * 16.0);
+		const Vector3 euler(rng.randf() * 6.0, rng.randf() * 6.0, rng.randf() * 6.0);
+		const real_t scale = 0.5 + rng.randf() * 1.5;
+		const Transform3D t(Basis().rotated(euler).scaled(Vector3(scale, scale, scale)), position);
+		layer.add_instance(to_transform3f(t), position_range);
+	}
+
+	const Vector3f offset(16.f, 0.f, -16.f);
+
+	StdVector<Transform3f> transforms;
+	transforms.resize(instance_count);
+	decode_instances_to_transforms(layer, position_range, offset, to_span(transforms));
+
+	StdVector<float> buffer;
+	buffer.resize(instance_count * 12);
+	decode_instances_to_multimesh_buffer(layer, position_range, offset, to_span(buffer));
+
+	for (unsigned int i = 0; i < instance_count; ++i) {
+		const Transform3f &t = transforms[i];
+		const float *b = buffer.data() + i * 12;
+
+		ZN_TEST_ASSERT(b[0] == t.basis.rows[0].x);
+		ZN_TEST_ASSERT(b[1] == t.basis.rows[0].y);
+		ZN_TEST_ASSERT(b[2] == t.basis.rows[0].z);
+		ZN_TEST_ASSERT(b[3] == t.origin.x);
+		ZN_TEST_ASSERT(b[4] == t.basis.rows[1].x);
+		ZN_TEST_ASSERT(b[5] == t.basis.rows[1].y);
+		ZN_TEST_ASSERT(b[6] == t.basis.rows[1].z);
+		ZN_TEST_ASSERT(b[7] == t.origin.y);
+		ZN_TEST_ASSERT(b[8] == t.basis.rows[2].x);
+		ZN_TEST_ASSERT(b[9] == t.basis.rows[2].y);
+		ZN_TEST_ASSERT(b[10] == t.basis.rows[2].z);
+		ZN_TEST_ASSERT(b[11] == t.origin.z);
+
+		// Positions are relative to the data block before the offset is applied
+		ZN_TEST_ASSERT(t.origin.x >= offset.x && t.origin.x <= offset.x + position_range);
+		ZN_TEST_ASSERT(t.origin.y >= offset.y && t.origin.y <= offset.y + position_range);
+		ZN_TEST_ASSERT(t.origin.z >= offset.z && t.origin.z <= offset.z + position_range);
+
+		// Basis must be a rotation with uniform scale within the range
+		const float scale = math::length(t.basis.get_column(0));
+		ZN_TEST_ASSERT(scale >= layer.scale_min - 0.01f && scale <= layer.scale_max + 0.01f);
+		ZN_TEST_ASSERT(Math::abs(math::length(t.basis.get_column(1)) - scale) < 0.001f);
+		ZN_TEST_ASSERT(Math::abs(math::length(t.basis.get_column(2)) - scale) < 0.001f);
+	}
+}
+
+namespace {
+
+// Heightmap-like surface covering a whole block, similar to what a smooth terrain mesher would output
+Array make_wavy_surface_arrays(const int resolution, const float block_size) {
+	PackedVector3Array vertices;
+	PackedVector3Array normals;
+	PackedInt32Array indices;
+
+	const float step = block_size / resolution;
+	const int row_size = resolution + 1;
+
+	for (int z = 0; z < row_size; ++z) {
+		for (int x = 0; x < row_size; ++x) {
+			const float px = x * step;
+			const float pz = z * step;
+			const float height = 0.5f * block_size + 4.f * Math::sin(px * 0.3f) * Math::cos(pz * 0.2f);
+			const float dx = 1.2f * Math::cos(px * 0.3f) * Math::cos(pz * 0.2f);
+			const float dz = -0.8f * Math::sin(px * 0.3f) * Math::sin(pz * 0.2f);
+			vertices.push_back(Vector3(px, height, pz));
+			normals.push_back(Vector3(-dx, 1.f, -dz).normalized());
+		}
+	}
+
+	for (int z = 0; z < resolution; ++z) {
+		for (int x = 0; x < resolution; ++x) {
+			const int i00 = x + z * row_size;
+			const int i10 = i00 + 1;
+			const int i01 = i00 + row_size;
+			const int i11 = i01 + 1;
+			indices.push_back(i00);
+			indices.push_back(i11);
+			indices.push_back(i10);
+			indices.push_back(i00);
+			indices.push_back(i01);
+			indices.push_back(i11);
+		}
+	}
+
+	Array arrays;
+	arrays.resize(ArrayMesh::ARRAY_MAX);
+	arrays[ArrayMesh::ARRAY_VERTEX] = vertices;
+	arrays[ArrayMesh::ARRAY_NORMAL] = normals;
+	arrays[ArrayMesh::ARRAY_INDEX] = indices;
+	return arrays;
+}
+
+struct InstanceGeneratorTestLayer {
+	const char *name;
+	Ref<VoxelInstanceGenerator> generator;
+};
+
+void make_instance_generator_test_layers(float block_size, StdVector<InstanceGeneratorTestLayer> &layers) {
+	// Dense, small instances aligned with the ground
+	Ref<VoxelInstanceGenerator> grass;
+	grass.instantiate();
+	grass->set_emit_mode(VoxelInstanceGenerator::EMIT_FROM_FACES);
+	grass->set_density(2.f);
+	grass->set_vertical_alignment(0.f);
+	grass->set_min_scale(0.8f);
+	grass->set_max_scale(1.2f);
+	grass->set_max_slope_degrees(30.f);
+
+	// Sparse, large instances standing up, placed in patches using noise
+	Ref<FastNoiseLite> noise;
+	noise.instantiate();
+	noise->set_frequency(0.05f);
+
+	Ref<VoxelInstanceGenerator> trees;
+	trees.instantiate();
+	trees->set_emit_mode(VoxelInstanceGenerator::EMIT_FROM_FACES_FAST);
+	trees->set_density(0.1f);
+	trees->set_vertical_alignment(1.f);
+	trees->set_min_scale(0.8f);
+	trees->set_max_scale(2.f);
+	trees->set_scale_distribution(VoxelInstanceGenerator::DISTRIBUTION_CUBIC);
+	trees->set_offset_along_normal(-0.5f);
+	trees->set_min_height(block_size * 0.5f - 3.f);
+	trees->set_noise(noise);
+	trees->set_noise_dimension(VoxelInstanceGenerator::DIMENSION_2D);
+	trees->set_noise_on_scale(0.5f);
+
+	layers.push_back({ "grass", grass });
+	layers.push_back({ "trees", trees });
+}
+
+// Generates instances on blocks laid out in rows of 8. Returns the total amount of instances. `transforms` contains
+// those of the last block.
+size_t generate_instance_test_blocks(
+		VoxelInstanceGenerator &generator,
+		const Array &surface_arrays,
+		float block_size,
+		unsigned int block_count,
+		StdVector<Transform3f> &transforms
+) {
+	size_t instance_count = 0;
+	for (unsigned int block_index = 0; block_index < block_count; ++block_index) {
+		const Vector3i grid_position(block_index % 8, 0, block_index / 8);
+		generator.generate_transforms(
+				transforms, grid_position, 0, 0, surface_arrays, UP_MODE_POSITIVE_Y, 0xff, block_size
+		);
+		instance_count += transforms.size();
+	}
+	return instance_count;
+}
+
+} // namespace
+
+void test_voxel_instance_generator() {
+	const float block_size = 32.f;
+	const Array surface_arrays = make_wavy_surface_arrays(32, block_size);
+	// The last block is at (7, 0, 7)
+	const unsigned int block_count = 64;
+
+	StdVector<InstanceGeneratorTestLayer> layers;
+	make_instance_generator_test_layers(block_size, layers);
+
+	for (const InstanceGeneratorTestLayer &layer : layers) {
+		StdVector<Transform3f> transforms;
+		StdVector<Transform3f> transforms2;
+
+		const size_t instance_count =
+				generate_instance_test_blocks(**layer.generator, surface_arrays, block_size, block_count, transforms);
+		ZN_TEST_ASSERT(instance_count > 0);
+
+		// Generation must be deterministic
+		layer.generator->generate_transforms(
+				transforms2, Vector3i(7, 0, 7), 0, 0, surface_arrays, UP_MODE_POSITIVE_Y, 0xff, block_size
+		);
+		ZN_TEST_ASSERT(transforms.size() == transforms2.size());
+
+		const float min_scale = layer.generator->get_min_scale() - 0.01f;
+		const float max_scale = layer.generator->get_max_scale() + 0.01f;
+
+		for (unsigned int i = 0; i < transforms.size(); ++i) {
+			const Transform3f &t = transforms[i];
+			const Transform3f &t2 = transforms2[i];
+			// Rotations and scales come from random numbers, which must be drawn in the same order too
+			ZN_TEST_ASSERT(t.origin == t2.origin);
+			ZN_TEST_ASSERT(t.basis.rows[0] == t2.basis.rows[0]);
+			ZN_TEST_ASSERT(t.basis.rows[1] == t2.basis.rows[1]);
+			ZN_TEST_ASSERT(t.basis.rows[2] == t2.basis.rows[2]);
+
+			const float scale = math::length(t.basis.get_column(1));
+			ZN_TEST_ASSERT(scale >= min_scale && scale <= max_scale);
+		}
+	}
+}
+
+void test_voxel_instance_generator_benchmark() {
+	const float block_size = 32.f;
+	const Array surface_arrays = make_wavy_surface_arrays(32, block_size);
+	const unsigned int block_count = 64;
+	const unsigned int iteration_count = 10;
+
+	StdVector<InstanceGeneratorTestLayer> layers;
+	make_instance_generator_test_layers(block_size, layers);
+
+	for (const InstanceGeneratorTestLayer &layer : layers) {
+		StdVector<Transform3f> transforms;
+		size_t instance_count = 0;
+
+		ProfilingClock profiling_clock;
+		for (unsigned int iteration = 0; iteration < iteration_count; ++iteration) {
+			instance_count = generate_instance_test_blocks(
+					**layer.generator, surface_arrays, block_size, block_count, transforms
+			);
+		}
+		const uint64_t elapsed_us = profiling_clock.restart() / iteration_count;
+
+		const double instances_per_ms = elapsed_us > 0 ? instance_count * 1000.0 / elapsed_us : 0.0;
+
+		print_line(format(
+				"VoxelInstanceGenerator {} layer: {} instances in {} blocks, {} us, {} instances/ms",
+				layer.name,
+				instance_count,
+				block_count,
+				elapsed_us,
+				instances_per_ms
+		));
+	}
+}
+
 } // namespace zylann::voxel::tests
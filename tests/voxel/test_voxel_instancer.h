@@ -4,6 +4,9 @@
 namespace zylann::voxel::tests {
 
 void test_instance_data_serialization();
+void test_instance_data_decode_to_multimesh_buffer();
+void test_voxel_instance_generator();
+void test_voxel_instance_generator_benchmark();
 
 } // namespace zylann::voxel::tests
 
@@ -1,10 +1,115 @@
 #include "test_voxel_mesher_cubes.h"
 #include "../../meshers/cubes/voxel_mesher_cubes.h"
 #include "../../storage/voxel_buffer.h"
+#include "../../util/profiling_clock.h"
+#include "../../util/string/format.h"
 #include "../testing.h"
 
 namespace zylann::voxel::tests {
 
+namespace {
+
+// Terrain of columns with layers of different colors, partially covered with transparent water.
+// `get_value(color_index)` returns the voxel value of one of the colors, where index 0 is air and 5 is water.
+template <typename F>
+void make_test_cubes_block(VoxelBuffer &vb, VoxelBuffer::Depth depth, F get_value) {
+	const int size = 64 + 2 * VoxelMesherCubes::PADDING;
+	const int water_level = 32;
+	vb.create(size, size, size);
+	vb.set_channel_depth(VoxelBuffer::CHANNEL_COLOR, depth);
+	vb.decompress_channel(VoxelBuffer::CHANNEL_COLOR);
+
+	for (int z = 0; z < size; ++z) {
+		for (int x = 0; x < size; ++x) {
+			const int height = 20 + (x * 7 + z * 13) % 24 + ((x / 8 + z / 8) % 2) * 4;
+			for (int y = 0; y < size; ++y) {
+				unsigned int color_index = 0;
+				if (y < height) {
+					color_index = 1 + (y / 4) % 4;
+				} else if (y < water_level) {
+					color_index = 5;
+				}
+				vb.set_voxel(get_value(color_index), x, y, z, VoxelBuffer::CHANNEL_COLOR);
+			}
+		}
+	}
+}
+
+// Sums the area of quads in each surface
+void get_surface_areas(const VoxelMesher::Output &output, FixedArray<float, VoxelMesherCubes::MATERIAL_COUNT> &areas) {
+	fill(areas, 0.f);
+	for (const VoxelMesher::Output::Surface &surface : output.surfaces) {
+		const PackedVector3Array positions = surface.arrays[Mesh::ARRAY_VERTEX];
+		ZN_TEST_ASSERT(positions.size() % 4 == 0);
+		float area = 0.f;
+		for (int i = 0; i < positions.size(); i += 4) {
+			// 2-----3
+			// |     |
+			// |     |
+			// 0-----1
+			area += positions[i].distance_to(positions[i + 1]) * positions[i].distance_to(positions[i + 2]);
+		}
+		areas[surface.material_index] += area;
+	}
+}
+
+// Calls `f(name, mesher, input)` for each combination of color mode and voxel format supported by the mesher, on a
+// 64x64x64 block of terrain.
+template <typename F>
+void for_each_cubes_test_config(F f) {
+	const unsigned int color_count = 6;
+	const Color8 colors[color_count] = {
+		Color8(0, 0, 0, 0), //
+		Color8(80, 160, 40, 255), //
+		Color8(120, 90, 60, 255), //
+		Color8(100, 100, 100, 255), //
+		Color8(200, 180, 120, 255), //
+		Color8(40, 80, 200, 128) //
+	};
+
+	Ref<VoxelColorPalette> palette;
+	palette.instantiate();
+	for (unsigned int i = 0; i < color_count; ++i) {
+		palette->set_color8(i, colors[i]);
+	}
+
+	VoxelBuffer raw_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	make_test_cubes_block(raw_voxels, VoxelBuffer::DEPTH_16_BIT, [&colors](unsigned int i) { //
+		return colors[i].to_u16();
+	});
+
+	VoxelBuffer indexed_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	make_test_cubes_block(indexed_voxels, VoxelBuffer::DEPTH_8_BIT, [](unsigned int i) { //
+		return i;
+	});
+
+	struct Config {
+		const char *name;
+		VoxelMesherCubes::ColorMode color_mode;
+		bool store_colors_in_texture;
+		const VoxelBuffer &voxels;
+	};
+	const Config configs[] = {
+		{ "raw", VoxelMesherCubes::COLOR_RAW, false, raw_voxels },
+		{ "mesher palette", VoxelMesherCubes::COLOR_MESHER_PALETTE, false, indexed_voxels },
+		{ "mesher palette atlas", VoxelMesherCubes::COLOR_MESHER_PALETTE, true, indexed_voxels },
+		{ "shader palette", VoxelMesherCubes::COLOR_SHADER_PALETTE, false, indexed_voxels },
+	};
+
+	for (const Config &config : configs) {
+		Ref<VoxelMesherCubes> mesher;
+		mesher.instantiate();
+		mesher->set_color_mode(config.color_mode);
+		mesher->set_palette(palette);
+		mesher->set_store_colors_in_texture(config.store_colors_in_texture);
+
+		const VoxelMesher::Input input{ config.voxels, nullptr, Vector3i(), 0, false };
+		f(config.name, **mesher, input);
+	}
+}
+
+} // namespace
+
 void test_voxel_mesher_cubes() {
 	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
 	vb.create(8, 8, 8);
@@ -51,4 +156,58 @@ void test_voxel_mesher_cubes() {
 	ZN_TEST_ASSERT(surface1_vertices_count == 20);
 }
 
+void test_voxel_mesher_cubes_greedy() {
+	for_each_cubes_test_config([](const char *, VoxelMesherCubes &mesher, const VoxelMesher::Input &input) {
+		// Greedy meshing must cover exactly the same faces as one quad per face
+		mesher.set_greedy_meshing_enabled(false);
+		VoxelMesher::Output simple_output;
+		mesher.build(simple_output, input);
+		FixedArray<float, VoxelMesherCubes::MATERIAL_COUNT> simple_areas;
+		get_surface_areas(simple_output, simple_areas);
+
+		mesher.set_greedy_meshing_enabled(true);
+		VoxelMesher::Output greedy_output;
+		mesher.build(greedy_output, input);
+		FixedArray<float, VoxelMesherCubes::MATERIAL_COUNT> greedy_areas;
+		get_surface_areas(greedy_output, greedy_areas);
+
+		ZN_TEST_ASSERT(simple_areas[VoxelMesherCubes::MATERIAL_OPAQUE] > 0.f);
+		ZN_TEST_ASSERT(simple_areas[VoxelMesherCubes::MATERIAL_TRANSPARENT] > 0.f);
+		for (unsigned int i = 0; i < VoxelMesherCubes::MATERIAL_COUNT; ++i) {
+			ZN_TEST_ASSERT(Math::is_equal_approx(simple_areas[i], greedy_areas[i]));
+		}
+
+		if (mesher.get_store_colors_in_texture()) {
+			ZN_TEST_ASSERT(greedy_output.atlas_image.is_valid());
+			for (const VoxelMesher::Output::Surface &surface : greedy_output.surfaces) {
+				const PackedVector2Array uvs = surface.arrays[Mesh::ARRAY_TEX_UV];
+				const PackedVector3Array positions = surface.arrays[Mesh::ARRAY_VERTEX];
+				ZN_TEST_ASSERT(uvs.size() == positions.size());
+			}
+		}
+	});
+}
+
+void test_voxel_mesher_cubes_benchmark() {
+	const unsigned int iteration_count = 10;
+
+	for_each_cubes_test_config([](const char *name, VoxelMesherCubes &mesher, const VoxelMesher::Input &input) {
+		mesher.set_greedy_meshing_enabled(true);
+		VoxelMesher::Output output;
+		ProfilingClock profiling_clock;
+		for (unsigned int i = 0; i < iteration_count; ++i) {
+			output = VoxelMesher::Output();
+			mesher.build(output, input);
+		}
+		const uint64_t greedy_time = profiling_clock.restart();
+
+		print_line(format(
+				"VoxelMesherCubes greedy {} on 64^3: {} us per block, {} surfaces",
+				name,
+				greedy_time / iteration_count,
+				output.surfaces.size()
+		));
+	});
+}
+
 } // namespace zylann::voxel::tests
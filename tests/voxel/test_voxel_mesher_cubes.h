@@ -4,6 +4,8 @@
 namespace zylann::voxel::tests {
 
 void test_voxel_mesher_cubes();
+void test_voxel_mesher_cubes_greedy();
+void test_voxel_mesher_cubes_benchmark();
 
 } // namespace zylann::voxel::tests
 
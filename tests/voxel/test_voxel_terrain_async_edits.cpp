@@ -0,0 +1,136 @@
+#include "test_voxel_terrain_async_edits.h"
+#include "../../edition/funcs.h"
+#include "../../engine/voxel_engine.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../storage/voxel_data_grid.h"
+#include "../../terrain/fixed_lod/voxel_terrain_async_edits.h"
+#include "../../util/godot/classes/time.h"
+#include "../../util/memory/memory.h"
+#include "../../util/thread/thread.h"
+#include "../testing.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+const unsigned int channel = VoxelBuffer::CHANNEL_TYPE;
+
+// Sets voxels of a box to `value * multiplier + addend`, so the result depends on the order edits run in
+class AffineAsyncEdit : public IVoxelTerrainAsyncEdit {
+public:
+	AffineAsyncEdit(Box3i p_box, int p_multiplier, int p_addend) :
+			box(p_box), multiplier(p_multiplier), addend(p_addend) {}
+
+	Box3i get_box() const override {
+		return box;
+	}
+
+	void apply(VoxelDataGrid &grid) override {
+		ops::VoxelDataGridAccess block_access;
+		block_access.grid = &grid;
+		ops::process_chunked_storage(
+				box,
+				block_access,
+				[this](VoxelBuffer &voxels, const Box3i local_box, Vector3i origin) {
+					local_box.for_each_cell_zxy([this, &voxels](Vector3i pos) {
+						const int v = voxels.get_voxel(pos, channel);
+						voxels.set_voxel(v * multiplier + addend, pos, channel);
+					});
+				}
+		);
+	}
+
+private:
+	Box3i box;
+	int multiplier;
+	int addend;
+};
+
+} // namespace
+
+void test_voxel_terrain_async_edits() {
+	const uint64_t timeout_msec = 10'000;
+
+	std::shared_ptr<VoxelData> data = make_shared_instance<VoxelData>();
+	const int block_size = data->get_block_size();
+
+	const Box3i blocks_box(Vector3i(), Vector3i(4, 1, 1));
+	data->set_bounds(Box3i(blocks_box.position * block_size, blocks_box.size * block_size));
+	blocks_box.for_each_cell_zxy([&data, block_size](Vector3i block_pos) {
+		std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_DEFAULT);
+		buffer->create(Vector3iUtil::create(block_size));
+		VoxelDataBlock block(buffer, 0);
+		ZN_TEST_ASSERT(data->try_set_block(block_pos, block));
+	});
+
+	// Slab of voxels between two X coordinates, across the whole height and depth of the blocks
+	auto slab = [block_size](int min_x, int max_x) { //
+		return Box3i(Vector3i(min_x, 0, 0), Vector3i(max_x - min_x, block_size, block_size));
+	};
+
+	VoxelTerrainAsyncEditQueue queue;
+
+	// These overlap each other and must run in order
+	queue.push(ZN_NEW(AffineAsyncEdit(slab(0, 24), 0, 1)));
+	queue.push(ZN_NEW(AffineAsyncEdit(slab(16, 40), 2, 3)));
+	queue.push(ZN_NEW(AffineAsyncEdit(slab(8, 20), 0, 7)));
+	// This one doesn't overlap the others, so it can run in parallel
+	queue.push(ZN_NEW(AffineAsyncEdit(slab(52, 60), 0, 9)));
+	const unsigned int first_batch_group_count = 2;
+
+	StdVector<Box3i> edited_boxes;
+	queue.process(data, edited_boxes);
+	ZN_TEST_ASSERT(edited_boxes.size() == 0);
+
+	// Pushed while the first batch may still be running, so it must only run after it
+	queue.push(ZN_NEW(AffineAsyncEdit(slab(0, 4 * block_size), 1, 100)));
+	const unsigned int second_batch_group_count = 1;
+
+	const uint64_t time_before = Time::get_singleton()->get_ticks_msec();
+	while (edited_boxes.size() < first_batch_group_count + second_batch_group_count) {
+		Thread::sleep_usec(500);
+		queue.process(data, edited_boxes);
+		ZN_TEST_ASSERT_MSG(
+				Time::get_singleton()->get_ticks_msec() - time_before < timeout_msec,
+				"Async edits took too long, tasks might be stuck"
+		);
+	}
+	ZN_TEST_ASSERT(edited_boxes.size() == first_batch_group_count + second_batch_group_count);
+
+	VoxelEngine::get_singleton().wait_and_clear_all_tasks(false);
+
+	struct Expected {
+		int min_x;
+		int max_x;
+		int value;
+	};
+	const Expected expected_values[] = {
+		{ 0, 8, 101 }, //
+		{ 8, 20, 107 }, //
+		{ 20, 24, 105 }, //
+		{ 24, 40, 103 }, //
+		{ 40, 52, 100 }, //
+		{ 52, 60, 109 }, //
+		{ 60, 64, 100 }, //
+	};
+
+	for (const Expected &expected : expected_values) {
+		const Box3i box = slab(expected.min_x, expected.max_x);
+		box.for_each_cell_zxy([&data, &expected](Vector3i pos) {
+			const int v = data->get_voxel(pos, channel, VoxelSingleValue()).i;
+			ZN_TEST_ASSERT(v == expected.value);
+		});
+		// Every edited voxel must be covered by the boxes reported for remeshing
+		bool covered = false;
+		for (const Box3i &edited_box : edited_boxes) {
+			if (edited_box.contains(box)) {
+				covered = true;
+				break;
+			}
+		}
+		ZN_TEST_ASSERT(covered);
+	}
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,10 @@
+#ifndef VOXEL_TEST_VOXEL_TERRAIN_ASYNC_EDITS_H
+#define VOXEL_TEST_VOXEL_TERRAIN_ASYNC_EDITS_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_terrain_async_edits();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TEST_VOXEL_TERRAIN_ASYNC_EDITS_H
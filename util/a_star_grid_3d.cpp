@@ -8,6 +8,7 @@ namespace zylann {
 
 AStarGrid3D::AStarGrid3D() {
 	_open_list.sorter.compare.pool = &_points_pool;
+	update_fitting_offset();
 }
 
 void AStarGrid3D::set_region(Box3i region) {
@@ -17,6 +18,15 @@ void AStarGrid3D::set_region(Box3i region) {
 void AStarGrid3D::set_agent_size(Vector3f size) {
 	ZN_ASSERT_RETURN(math::is_valid_size(size));
 	_agent_size = size;
+	update_fitting_offset();
+}
+
+void AStarGrid3D::update_fitting_offset() {
+	_fitting_offset = Vector3f( //
+			(int(_agent_size.x) & 1) == 1 ? 0.5f : 0.f, //
+			(int(_agent_size.y) & 1) == 1 ? 0.5f : 0.f, //
+			(int(_agent_size.z) & 1) == 1 ? 0.5f : 0.f
+	);
 }
 
 void AStarGrid3D::set_max_fall_height(int h) {
@@ -40,12 +50,6 @@ void AStarGrid3D::start(Vector3i from_position, Vector3i target_position) {
 
 	_target_position = target_position;
 
-	_fitting_offset = Vector3f( //
-			(int(_agent_size.x) & 1) == 1 ? 0.5f : 0.f, //
-			(int(_agent_size.y) & 1) == 1 ? 0.5f : 0.f, //
-			(int(_agent_size.z) & 1) == 1 ? 0.5f : 0.f
-	);
-
 	if (!_region.contains(from_position)) {
 		return;
 	}
@@ -45,13 +45,16 @@ public:
 	void debug_get_visited_points(StdVector<Vector3i> &out_positions) const;
 	bool debug_get_next_step_point(Vector3i &out_pos) const;
 
+	// Gets positions an agent standing at the given position can move to in one step.
+	void get_neighbor_positions(Vector3i pos, StdVector<Vector3i> &out_positions);
+
 protected:
 	virtual bool is_solid(Vector3i pos);
 
 private:
 	float evaluate_heuristic(Vector3i pos, Vector3i target_pos) const;
 	void reconstruct_path(uint32_t end_point_index);
-	void get_neighbor_positions(Vector3i pos, StdVector<Vector3i> &out_positions);
+	void update_fitting_offset();
 	bool is_ground_close_enough(Vector3i pos);
 	bool fits(Vector3f pos, Vector3f agent_extents);
 
@@ -0,0 +1,274 @@
+#include "dynamic_aabb_tree.h"
+#include "../math/funcs.h"
+
+namespace zylann {
+
+namespace {
+
+inline real_t get_surface_area(const AABB &aabb) {
+	const Vector3 s = aabb.size;
+	return 2.0 * (s.x * s.y + s.y * s.z + s.z * s.x);
+}
+
+} // namespace
+
+uint32_t DynamicAABBTree::allocate_node() {
+	uint32_t id;
+	if (_free_list != NULL_ID) {
+		id = _free_list;
+		_free_list = _nodes[id].parent;
+	} else {
+		id = _nodes.size();
+		_nodes.push_back(Node());
+	}
+	Node &node = _nodes[id];
+	node.parent = NULL_ID;
+	node.child1 = NULL_ID;
+	node.child2 = NULL_ID;
+	node.height = 0;
+	node.user_data = 0;
+	return id;
+}
+
+void DynamicAABBTree::free_node(uint32_t id) {
+	Node &node = _nodes[id];
+	node.parent = _free_list;
+	node.height = -1;
+	_free_list = id;
+}
+
+uint32_t DynamicAABBTree::add(const AABB &aabb, uint32_t user_data) {
+	const uint32_t id = allocate_node();
+	Node &node = _nodes[id];
+	node.aabb = aabb;
+	node.user_data = user_data;
+	insert_leaf(id);
+	return id;
+}
+
+void DynamicAABBTree::remove(uint32_t id) {
+	ZN_ASSERT_RETURN(id < _nodes.size());
+	ZN_ASSERT_RETURN(_nodes[id].height == 0);
+	remove_leaf(id);
+	free_node(id);
+}
+
+void DynamicAABBTree::set_aabb(uint32_t id, const AABB &aabb) {
+	ZN_ASSERT_RETURN(id < _nodes.size());
+	ZN_ASSERT_RETURN(_nodes[id].height == 0);
+	if (_nodes[id].aabb == aabb) {
+		return;
+	}
+	remove_leaf(id);
+	_nodes[id].aabb = aabb;
+	insert_leaf(id);
+}
+
+void DynamicAABBTree::clear() {
+	_nodes.clear();
+	_root = NULL_ID;
+	_free_list = NULL_ID;
+}
+
+int DynamicAABBTree::get_height() const {
+	if (_root == NULL_ID) {
+		return 0;
+	}
+	return _nodes[_root].height;
+}
+
+void DynamicAABBTree::replace_child(uint32_t parent, uint32_t old_child, uint32_t new_child) {
+	if (parent == NULL_ID) {
+		_root = new_child;
+		return;
+	}
+	Node &parent_node = _nodes[parent];
+	if (parent_node.child1 == old_child) {
+		parent_node.child1 = new_child;
+	} else {
+		ZN_ASSERT(parent_node.child2 == old_child);
+		parent_node.child2 = new_child;
+	}
+}
+
+void DynamicAABBTree::insert_leaf(uint32_t leaf) {
+	if (_root == NULL_ID) {
+		_root = leaf;
+		_nodes[leaf].parent = NULL_ID;
+		return;
+	}
+
+	const AABB leaf_aabb = _nodes[leaf].aabb;
+
+	// Find the best sibling, going down the tree towards the child whose surface area would increase the least
+	uint32_t sibling = _root;
+	while (!_nodes[sibling].is_leaf()) {
+		const Node &node = _nodes[sibling];
+
+		const real_t area = get_surface_area(node.aabb);
+		const real_t combined_area = get_surface_area(node.aabb.merge(leaf_aabb));
+
+		// Cost of creating a new parent for this node and the leaf
+		const real_t cost = 2.0 * combined_area;
+		// Minimum cost of pushing the leaf further down the tree
+		const real_t inheritance_cost = 2.0 * (combined_area - area);
+
+		real_t child_costs[2];
+		const uint32_t children[2] = { node.child1, node.child2 };
+		for (unsigned int i = 0; i < 2; ++i) {
+			const Node &child = _nodes[children[i]];
+			const real_t merged_area = get_surface_area(child.aabb.merge(leaf_aabb));
+			if (child.is_leaf()) {
+				child_costs[i] = merged_area + inheritance_cost;
+			} else {
+				child_costs[i] = merged_area - get_surface_area(child.aabb) + inheritance_cost;
+			}
+		}
+
+		if (cost < child_costs[0] && cost < child_costs[1]) {
+			break;
+		}
+
+		sibling = child_costs[0] < child_costs[1] ? children[0] : children[1];
+	}
+
+	// Create a new parent for the sibling and the leaf.
+	// Allocating may invalidate references to nodes.
+	const uint32_t old_parent = _nodes[sibling].parent;
+	const uint32_t new_parent = allocate_node();
+	{
+		Node &node = _nodes[new_parent];
+		node.parent = old_parent;
+		node.aabb = leaf_aabb.merge(_nodes[sibling].aabb);
+		node.height = _nodes[sibling].height + 1;
+		node.child1 = sibling;
+		node.child2 = leaf;
+	}
+	replace_child(old_parent, sibling, new_parent);
+	_nodes[sibling].parent = new_parent;
+	_nodes[leaf].parent = new_parent;
+
+	refit_ancestors(new_parent);
+}
+
+void DynamicAABBTree::remove_leaf(uint32_t leaf) {
+	if (leaf == _root) {
+		_root = NULL_ID;
+		return;
+	}
+
+	const uint32_t parent = _nodes[leaf].parent;
+	const uint32_t grand_parent = _nodes[parent].parent;
+	const uint32_t sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+	// The sibling takes the place of the parent
+	replace_child(grand_parent, parent, sibling);
+	_nodes[sibling].parent = grand_parent;
+	free_node(parent);
+
+	if (grand_parent != NULL_ID) {
+		refit_ancestors(grand_parent);
+	}
+}
+
+void DynamicAABBTree::refit_ancestors(uint32_t id) {
+	while (id != NULL_ID) {
+		id = balance(id);
+
+		Node &node = _nodes[id];
+		const Node &child1 = _nodes[node.child1];
+		const Node &child2 = _nodes[node.child2];
+		node.height = 1 + math::max(child1.height, child2.height);
+		node.aabb = child1.aabb.merge(child2.aabb);
+
+		id = node.parent;
+	}
+}
+
+// If one child of the node is higher than the other by more than one level, rotates it up to take the place of the
+// node. Returns the node now at the position of the given one.
+uint32_t DynamicAABBTree::balance(uint32_t a_id) {
+	Node &a = _nodes[a_id];
+	if (a.is_leaf() || a.height < 2) {
+		return a_id;
+	}
+
+	const uint32_t b_id = a.child1;
+	const uint32_t c_id = a.child2;
+	Node &b = _nodes[b_id];
+	Node &c = _nodes[c_id];
+
+	const int height_difference = c.height - b.height;
+
+	if (height_difference > 1) {
+		// Rotate C up
+		const uint32_t f_id = c.child1;
+		const uint32_t g_id = c.child2;
+		Node &f = _nodes[f_id];
+		Node &g = _nodes[g_id];
+
+		c.child1 = a_id;
+		c.parent = a.parent;
+		a.parent = c_id;
+		replace_child(c.parent, a_id, c_id);
+
+		// The higher child of C stays with C, the other one goes to A
+		if (f.height > g.height) {
+			c.child2 = f_id;
+			a.child2 = g_id;
+			g.parent = a_id;
+			a.aabb = b.aabb.merge(g.aabb);
+			c.aabb = a.aabb.merge(f.aabb);
+			a.height = 1 + math::max(b.height, g.height);
+			c.height = 1 + math::max(a.height, f.height);
+		} else {
+			c.child2 = g_id;
+			a.child2 = f_id;
+			f.parent = a_id;
+			a.aabb = b.aabb.merge(f.aabb);
+			c.aabb = a.aabb.merge(g.aabb);
+			a.height = 1 + math::max(b.height, f.height);
+			c.height = 1 + math::max(a.height, g.height);
+		}
+
+		return c_id;
+	}
+
+	if (height_difference < -1) {
+		// Rotate B up
+		const uint32_t d_id = b.child1;
+		const uint32_t e_id = b.child2;
+		Node &d = _nodes[d_id];
+		Node &e = _nodes[e_id];
+
+		b.child1 = a_id;
+		b.parent = a.parent;
+		a.parent = b_id;
+		replace_child(b.parent, a_id, b_id);
+
+		// The higher child of B stays with B, the other one goes to A
+		if (d.height > e.height) {
+			b.child2 = d_id;
+			a.child1 = e_id;
+			e.parent = a_id;
+			a.aabb = c.aabb.merge(e.aabb);
+			b.aabb = a.aabb.merge(d.aabb);
+			a.height = 1 + math::max(c.height, e.height);
+			b.height = 1 + math::max(a.height, d.height);
+		} else {
+			b.child2 = e_id;
+			a.child1 = d_id;
+			d.parent = a_id;
+			a.aabb = c.aabb.merge(d.aabb);
+			b.aabb = a.aabb.merge(e.aabb);
+			a.height = 1 + math::max(c.height, d.height);
+			b.height = 1 + math::max(a.height, e.height);
+		}
+
+		return b_id;
+	}
+
+	return a_id;
+}
+
+} // namespace zylann
@@ -0,0 +1,105 @@
+#ifndef ZN_DYNAMIC_AABB_TREE_H
+#define ZN_DYNAMIC_AABB_TREE_H
+
+#include "../errors.h"
+#include "../math/transform_3d.h"
+#include "fixed_array.h"
+#include "std_vector.h"
+#include <cstdint>
+#include <limits>
+
+namespace zylann {
+
+// Bounding volume hierarchy of AABBs, which can be modified one item at a time. Each item is a leaf of the tree,
+// identified by an ID that remains valid until the item is removed.
+// Items are inserted next to the node that increases the surface area of the tree the least, and the tree is
+// rebalanced with rotations, so queries remain logarithmic regardless of insertion order.
+// Not thread-safe.
+class DynamicAABBTree {
+public:
+	static const uint32_t NULL_ID = std::numeric_limits<uint32_t>::max();
+
+	uint32_t add(const AABB &aabb, uint32_t user_data);
+	void remove(uint32_t id);
+	// Changing the AABB of an item moves it in the tree. Does nothing if the AABB is the same.
+	void set_aabb(uint32_t id, const AABB &aabb);
+	void clear();
+
+	inline const AABB &get_aabb(uint32_t id) const {
+		ZN_ASSERT(id < _nodes.size());
+		return _nodes[id].aabb;
+	}
+
+	inline uint32_t get_user_data(uint32_t id) const {
+		ZN_ASSERT(id < _nodes.size());
+		return _nodes[id].user_data;
+	}
+
+	inline bool is_empty() const {
+		return _root == NULL_ID;
+	}
+
+	// Height of the tree. A tree with a single item has height 0.
+	int get_height() const;
+
+	// Calls `f(user_data)` for each item intersecting the given AABB, in no particular order.
+	template <typename F>
+	void query(const AABB &aabb, F f) const {
+		if (_root == NULL_ID) {
+			return;
+		}
+
+		// The tree is balanced, so its height is logarithmic. Traversal pushes at most one node per level, plus one.
+		FixedArray<uint32_t, 64> stack;
+		unsigned int stack_size = 0;
+		stack[stack_size++] = _root;
+
+		while (stack_size > 0) {
+			const Node &node = _nodes[stack[--stack_size]];
+
+			if (!node.aabb.intersects(aabb)) {
+				continue;
+			}
+
+			if (node.is_leaf()) {
+				f(node.user_data);
+			} else {
+				ZN_ASSERT(stack_size + 2 <= stack.size());
+				stack[stack_size++] = node.child1;
+				stack[stack_size++] = node.child2;
+			}
+		}
+	}
+
+private:
+	struct Node {
+		AABB aabb;
+		// When the node is free, index of the next free node
+		uint32_t parent;
+		uint32_t child1;
+		uint32_t child2;
+		// Leaves have height 0, free nodes have height -1
+		int height;
+		uint32_t user_data;
+
+		inline bool is_leaf() const {
+			return child1 == NULL_ID;
+		}
+	};
+
+	uint32_t allocate_node();
+	void free_node(uint32_t id);
+	void insert_leaf(uint32_t leaf);
+	void remove_leaf(uint32_t leaf);
+	void refit_ancestors(uint32_t id);
+	uint32_t balance(uint32_t id);
+	void replace_child(uint32_t parent, uint32_t old_child, uint32_t new_child);
+
+	StdVector<Node> _nodes;
+	uint32_t _root = NULL_ID;
+	uint32_t _free_list = NULL_ID;
+};
+
+} // namespace zylann
+
+#endif // ZN_DYNAMIC_AABB_TREE_H
@@ -2,6 +2,7 @@
 #define ZN_DYNAMIC_BITSET_H
 
 #include "../errors.h"
+#include "span.h"
 #include "std_vector.h"
 #include <cstdint>
 
@@ -57,6 +58,15 @@ public:
 		}
 	}
 
+	// Raw storage, 64 bits per word. Padding bits of the last word have no guaranteed values.
+	inline Span<const uint64_t> get_words() const {
+		return to_span(_bits);
+	}
+
+	inline Span<uint64_t> get_words() {
+		return to_span(_bits);
+	}
+
 private:
 	StdVector<uint64_t> _bits;
 	unsigned int _size = 0;
@@ -0,0 +1,108 @@
+#include "range_allocator.h"
+#include "../errors.h"
+
+namespace zylann {
+
+RangeAllocator::RangeAllocator(uint32_t capacity) {
+	grow(capacity);
+}
+
+uint32_t RangeAllocator::allocate(uint32_t size) {
+	ZN_ASSERT_RETURN_V(size > 0, INVALID_OFFSET);
+
+	for (size_t i = 0; i < _free_ranges.size(); ++i) {
+		Range &range = _free_ranges[i];
+		if (range.size < size) {
+			continue;
+		}
+		const uint32_t offset = range.offset;
+		if (range.size == size) {
+			_free_ranges.erase(_free_ranges.begin() + i);
+		} else {
+			range.offset += size;
+			range.size -= size;
+		}
+		_used_size += size;
+		return offset;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t size) {
+	ZN_ASSERT_RETURN(size > 0);
+	ZN_ASSERT_RETURN(offset + size <= _capacity);
+	ZN_ASSERT_RETURN(size <= _used_size);
+
+	// Find the first free range located after the freed one
+	size_t next_index = 0;
+	while (next_index < _free_ranges.size() && _free_ranges[next_index].offset < offset) {
+		++next_index;
+	}
+
+#ifdef DEBUG_ENABLED
+	// Must not overlap free ranges, which would mean a range got freed twice
+	if (next_index < _free_ranges.size()) {
+		ZN_ASSERT(offset + size <= _free_ranges[next_index].offset);
+	}
+	if (next_index > 0) {
+		const Range &prev = _free_ranges[next_index - 1];
+		ZN_ASSERT(prev.offset + prev.size <= offset);
+	}
+#endif
+
+	_used_size -= size;
+
+	const bool merge_with_prev =
+			next_index > 0 && _free_ranges[next_index - 1].offset + _free_ranges[next_index - 1].size == offset;
+	const bool merge_with_next = next_index < _free_ranges.size() && offset + size == _free_ranges[next_index].offset;
+
+	if (merge_with_prev) {
+		Range &prev = _free_ranges[next_index - 1];
+		prev.size += size;
+		if (merge_with_next) {
+			prev.size += _free_ranges[next_index].size;
+			_free_ranges.erase(_free_ranges.begin() + next_index);
+		}
+
+	} else if (merge_with_next) {
+		Range &next = _free_ranges[next_index];
+		next.offset = offset;
+		next.size += size;
+
+	} else {
+		_free_ranges.insert(_free_ranges.begin() + next_index, Range{ offset, size });
+	}
+}
+
+void RangeAllocator::grow(uint32_t new_capacity) {
+	ZN_ASSERT_RETURN(new_capacity >= _capacity);
+	if (new_capacity == _capacity) {
+		return;
+	}
+	const uint32_t prev_capacity = _capacity;
+	_capacity = new_capacity;
+	// Freeing the new space merges it with a free range at the end if there is one
+	_used_size += new_capacity - prev_capacity;
+	free(prev_capacity, new_capacity - prev_capacity);
+}
+
+void RangeAllocator::clear() {
+	_free_ranges.clear();
+	if (_capacity > 0) {
+		_free_ranges.push_back(Range{ 0, _capacity });
+	}
+	_used_size = 0;
+}
+
+uint32_t RangeAllocator::get_used_end() const {
+	if (_free_ranges.size() > 0) {
+		const Range &last = _free_ranges.back();
+		if (last.offset + last.size == _capacity) {
+			return last.offset;
+		}
+	}
+	return _capacity;
+}
+
+} // namespace zylann
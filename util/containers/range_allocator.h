@@ -0,0 +1,59 @@
+#ifndef ZN_RANGE_ALLOCATOR_H
+#define ZN_RANGE_ALLOCATOR_H
+
+#include "std_vector.h"
+#include <cstdint>
+#include <limits>
+
+namespace zylann {
+
+// Allocates contiguous ranges of slots within a fixed capacity, which can be grown.
+// Free ranges are kept in a list sorted by offset, and adjacent ones are merged when ranges are freed, so the space
+// they leave can be reused by later allocations. Allocation picks the first free range large enough.
+// Only bookkeeping is done here, the slots themselves are stored by the user.
+// Not thread-safe.
+class RangeAllocator {
+public:
+	static const uint32_t INVALID_OFFSET = std::numeric_limits<uint32_t>::max();
+
+	RangeAllocator() {}
+	RangeAllocator(uint32_t capacity);
+
+	// Returns the offset of the allocated range, or `INVALID_OFFSET` if no free range is large enough.
+	uint32_t allocate(uint32_t size);
+	void free(uint32_t offset, uint32_t size);
+
+	// Adds free space at the end. Capacity can't shrink.
+	void grow(uint32_t new_capacity);
+	void clear();
+
+	inline uint32_t get_capacity() const {
+		return _capacity;
+	}
+
+	// Sum of the sizes of all allocated ranges
+	inline uint32_t get_used_size() const {
+		return _used_size;
+	}
+
+	// Offset after which all slots are free
+	uint32_t get_used_end() const;
+
+	inline unsigned int get_free_range_count() const {
+		return _free_ranges.size();
+	}
+
+private:
+	struct Range {
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	StdVector<Range> _free_ranges;
+	uint32_t _capacity = 0;
+	uint32_t _used_size = 0;
+};
+
+} // namespace zylann
+
+#endif // ZN_RANGE_ALLOCATOR_H
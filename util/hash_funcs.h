@@ -3,6 +3,7 @@
 
 #include "math/funcs.h"
 #include <cstdint>
+#include <cstring>
 
 namespace zylann {
 
@@ -17,6 +18,41 @@ inline uint64_t hash_djb2_one_64(uint64_t p_in, uint64_t p_prev = 5381) {
 	return ((p_prev << 5) + p_prev) ^ p_in;
 }
 
+inline uint64_t hash_djb2_one_float(float p_in, uint64_t p_prev = 5381) {
+	// Positive and negative zero must hash the same, since they compare equal
+	if (p_in == 0.f) {
+		p_in = 0.f;
+	}
+	uint32_t bits;
+	memcpy(&bits, &p_in, sizeof(bits));
+	return hash_djb2_one_64(bits, p_prev);
+}
+
+inline uint64_t hash_djb2_one_float(double p_in, uint64_t p_prev = 5381) {
+	if (p_in == 0.0) {
+		p_in = 0.0;
+	}
+	uint64_t bits;
+	memcpy(&bits, &p_in, sizeof(bits));
+	return hash_djb2_one_64(bits, p_prev);
+}
+
+// Hashes raw bytes of a buffer, 8 bytes at a time.
+inline uint64_t hash_djb2_buffer_64(const void *p_data, size_t p_size, uint64_t p_prev = 5381) {
+	const uint8_t *bytes = static_cast<const uint8_t *>(p_data);
+	uint64_t h = hash_djb2_one_64(p_size, p_prev);
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= p_size; i += sizeof(uint64_t)) {
+		uint64_t v;
+		memcpy(&v, bytes + i, sizeof(v));
+		h = hash_djb2_one_64(v, h);
+	}
+	for (; i < p_size; ++i) {
+		h = hash_djb2_one_64(bytes[i], h);
+	}
+	return h;
+}
+
 #define HASH_MURMUR3_SEED 0x7F07C65
 // Murmurhash3 32-bit version.
 // All MurmurHash versions are public domain software, and the author disclaims all copyright to their code.
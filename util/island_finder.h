@@ -3,6 +3,8 @@
 
 #include "containers/fixed_array.h"
 #include "containers/span.h"
+#include "containers/std_vector.h"
+#include "errors.h"
 #include "math/box3i.h"
 
 namespace zylann {
@@ -212,6 +214,264 @@ private:
 	FixedArray<uint8_t, MAX_ISLANDS> _equivalences;
 };
 
+// Labels contiguous islands of a grid of binary values like `IslandFinder`, but using union-find with 32-bit labels,
+// so the number of islands is not limited in practice.
+//
+// The grid is split into blocks which are labeled independently, so they can be scanned by multiple threads. Islands
+// are then merged across block faces, and labels are made consecutive starting from 1.
+// Blocks in which all cells are empty or all cells are solid are detected, so they don't need unions between their
+// cells, and faces touching an empty block are not merged.
+//
+// Usage: call `begin`, then `scan_block` for every block index below `get_block_count()` (in any order, possibly
+// from different threads), then `finish`.
+//
+class BlockIslandFinder {
+public:
+	// `output` must have the volume of the grid and remain valid until `finish` is called. Cells are indexed in ZXY
+	// order.
+	void begin(const Vector3i grid_size, const unsigned int block_size, Span<uint32_t> output) {
+		ZN_ASSERT(block_size > 0);
+		ZN_ASSERT(static_cast<int64_t>(output.size()) == Vector3iUtil::get_volume(grid_size));
+		// Cell indices are stored with an offset of 1 in 32-bit integers
+		ZN_ASSERT(uint64_t(grid_size.x) * uint64_t(grid_size.y) * uint64_t(grid_size.z) < 0xffffffffull);
+
+		_grid_size = grid_size;
+		_block_size = block_size;
+		_block_grid_size = (grid_size + Vector3iUtil::create(block_size - 1)) / block_size;
+		_output = output;
+		_block_states.clear();
+		_block_states.resize(Vector3iUtil::get_volume(_block_grid_size), BLOCK_EMPTY);
+	}
+
+	unsigned int get_block_count() const {
+		return _block_states.size();
+	}
+
+	// Labels islands within one block. Can be called from multiple threads, as long as they scan different blocks.
+	// `predicate_func(Vector3i pos) -> bool` tells if a cell of the grid is solid.
+	template <typename Predicate_F>
+	void scan_block(const unsigned int block_index, Predicate_F predicate_func) {
+		ZN_ASSERT(block_index < _block_states.size());
+		const Box3i box = get_block_box(block_index);
+		const uint32_t dx = get_index_stride(Vector3i::AXIS_X);
+		const uint32_t dz = get_index_stride(Vector3i::AXIS_Z);
+
+		// During the scan, a solid cell holds the index of its parent plus 1, and an empty cell holds 0.
+		// A parent always has a lower index than its children, which is used in `finish`.
+
+		unsigned int solid_count = 0;
+		Vector3i pos;
+		for (pos.z = box.position.z; pos.z < box.position.z + box.size.z; ++pos.z) {
+			for (pos.x = box.position.x; pos.x < box.position.x + box.size.x; ++pos.x) {
+				pos.y = box.position.y;
+				uint32_t i = Vector3iUtil::get_zxy_index(pos, _grid_size);
+				for (; pos.y < box.position.y + box.size.y; ++pos.y, ++i) {
+					if (predicate_func(pos)) {
+						_output[i] = i + 1;
+						++solid_count;
+					} else {
+						_output[i] = 0;
+					}
+				}
+			}
+		}
+
+		if (solid_count == 0) {
+			_block_states[block_index] = BLOCK_EMPTY;
+			return;
+		}
+
+		if (static_cast<int64_t>(solid_count) == Vector3iUtil::get_volume(box.size)) {
+			// The whole block is one island, no need for unions
+			const uint32_t root_index = Vector3iUtil::get_zxy_index(box.position, _grid_size);
+			for_each_cell_index(box, [this, root_index](uint32_t i) { //
+				_output[i] = root_index + 1;
+			});
+			_block_states[block_index] = BLOCK_FULL;
+			return;
+		}
+
+		// Unions are done with previous neighbors inside the block only, so other blocks can be scanned concurrently
+		for (pos.z = box.position.z; pos.z < box.position.z + box.size.z; ++pos.z) {
+			for (pos.x = box.position.x; pos.x < box.position.x + box.size.x; ++pos.x) {
+				pos.y = box.position.y;
+				uint32_t i = Vector3iUtil::get_zxy_index(pos, _grid_size);
+				for (; pos.y < box.position.y + box.size.y; ++pos.y, ++i) {
+					if (_output[i] == 0) {
+						continue;
+					}
+					if (pos.y > box.position.y && _output[i - 1] != 0) {
+						unite(i, i - 1);
+					}
+					if (pos.x > box.position.x && _output[i - dx] != 0) {
+						unite(i, i - dx);
+					}
+					if (pos.z > box.position.z && _output[i - dz] != 0) {
+						unite(i, i - dz);
+					}
+				}
+			}
+		}
+
+		_block_states[block_index] = BLOCK_MIXED;
+	}
+
+	// Merges islands across blocks and writes final labels into the output, starting from 1. Empty cells get 0.
+	// Returns the number of islands.
+	unsigned int finish() {
+		merge_block_faces();
+
+		// Parents have lower indices than their children, so iterating in index order guarantees a cell's parent
+		// already holds its final label when the cell is reached. This both flattens trees and compacts labels.
+		uint32_t label_count = 0;
+		for (uint32_t i = 0; i < _output.size(); ++i) {
+			const uint32_t v = _output[i];
+			if (v == 0) {
+				continue;
+			}
+			const uint32_t parent = v - 1;
+			if (parent == i) {
+				++label_count;
+				_output[i] = label_count;
+			} else {
+				_output[i] = _output[parent];
+			}
+		}
+
+		return label_count;
+	}
+
+	// Single-threaded convenience.
+	template <typename Predicate_F>
+	unsigned int scan_3d(
+			const Vector3i grid_size,
+			const unsigned int block_size,
+			Predicate_F predicate_func,
+			Span<uint32_t> output
+	) {
+		begin(grid_size, block_size, output);
+		for (unsigned int block_index = 0; block_index < get_block_count(); ++block_index) {
+			scan_block(block_index, predicate_func);
+		}
+		return finish();
+	}
+
+private:
+	enum BlockState : uint8_t {
+		BLOCK_EMPTY,
+		BLOCK_FULL,
+		BLOCK_MIXED
+	};
+
+	Box3i get_block_box(const unsigned int block_index) const {
+		const Vector3i bpos = Vector3iUtil::from_zxy_index(block_index, _block_grid_size);
+		Box3i box(bpos * _block_size, Vector3iUtil::create(_block_size));
+		box.clip(_grid_size);
+		return box;
+	}
+
+	// Difference of index between two neighbor cells along an axis, in ZXY order
+	uint32_t get_index_stride(const int axis) const {
+		switch (axis) {
+			case Vector3i::AXIS_X:
+				return _grid_size.y;
+			case Vector3i::AXIS_Y:
+				return 1;
+			case Vector3i::AXIS_Z:
+				return _grid_size.x * _grid_size.y;
+			default:
+				ZN_CRASH();
+				return 0;
+		}
+	}
+
+	template <typename F>
+	void for_each_cell_index(const Box3i box, F f) {
+		Vector3i pos;
+		for (pos.z = box.position.z; pos.z < box.position.z + box.size.z; ++pos.z) {
+			for (pos.x = box.position.x; pos.x < box.position.x + box.size.x; ++pos.x) {
+				pos.y = box.position.y;
+				uint32_t i = Vector3iUtil::get_zxy_index(pos, _grid_size);
+				for (; pos.y < box.position.y + box.size.y; ++pos.y, ++i) {
+					f(i);
+				}
+			}
+		}
+	}
+
+	uint32_t find_root(uint32_t i) {
+		uint32_t parent = _output[i] - 1;
+		while (parent != i) {
+			// Path halving
+			const uint32_t grand_parent = _output[parent] - 1;
+			_output[i] = grand_parent + 1;
+			i = grand_parent;
+			parent = _output[i] - 1;
+		}
+		return i;
+	}
+
+	void unite(uint32_t a, uint32_t b) {
+		a = find_root(a);
+		b = find_root(b);
+		// Keep the lowest index as root
+		if (a < b) {
+			_output[b] = a + 1;
+		} else if (b < a) {
+			_output[a] = b + 1;
+		}
+	}
+
+	void merge_block_faces() {
+		for (unsigned int block_index = 0; block_index < _block_states.size(); ++block_index) {
+			const BlockState state = _block_states[block_index];
+			if (state == BLOCK_EMPTY) {
+				continue;
+			}
+			const Vector3i bpos = Vector3iUtil::from_zxy_index(block_index, _block_grid_size);
+			const Box3i box = get_block_box(block_index);
+
+			for (int axis = 0; axis < Vector3iUtil::AXIS_COUNT; ++axis) {
+				if (bpos[axis] == 0) {
+					continue;
+				}
+				Vector3i neighbor_bpos = bpos;
+				--neighbor_bpos[axis];
+				const BlockState neighbor_state =
+						_block_states[Vector3iUtil::get_zxy_index(neighbor_bpos, _block_grid_size)];
+				if (neighbor_state == BLOCK_EMPTY) {
+					continue;
+				}
+
+				const uint32_t neighbor_di = get_index_stride(axis);
+
+				Box3i face = box;
+				face.size[axis] = 1;
+
+				if (state == BLOCK_FULL && neighbor_state == BLOCK_FULL) {
+					// Each block is a single island, one union is enough
+					const uint32_t i = Vector3iUtil::get_zxy_index(face.position, _grid_size);
+					unite(i, i - neighbor_di);
+					continue;
+				}
+
+				for_each_cell_index(face, [this, neighbor_di](uint32_t i) {
+					const uint32_t ni = i - neighbor_di;
+					if (_output[i] != 0 && _output[ni] != 0) {
+						unite(i, ni);
+					}
+				});
+			}
+		}
+	}
+
+	Vector3i _grid_size;
+	Vector3i _block_grid_size;
+	unsigned int _block_size = 16;
+	Span<uint32_t> _output;
+	StdVector<BlockState> _block_states;
+};
+
 } // namespace zylann
 
 #endif // ISLAND_FINDER_H
@@ -90,7 +90,8 @@ void ThreadedTaskRunner::set_thread_count(uint32_t count) {
 		count = MAX_THREADS;
 	}
 	destroy_all_threads();
-	for (uint32_t i = _thread_count; i < count; ++i) {
+	// All threads were stopped, so they all have to be started again
+	for (uint32_t i = 0; i < count; ++i) {
 		ThreadData &d = _threads[i];
 		create_thread(d, i);
 	}
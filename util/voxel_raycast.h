@@ -201,4 +201,186 @@ bool voxel_raycast(
 	return true;
 }
 
+namespace voxel_raycast_detail {
+
+// Gets the cell a DDA starts from. Same as flooring, except on cell boundaries when going backwards.
+template <typename Vec3f_T>
+inline Vector3i get_start_cell(Vec3f_T ray_origin, Vec3f_T ray_direction) {
+	Vector3i cell = math::floor_to_int(ray_origin);
+	if (ray_direction.x < 0 && cell.x == ray_origin.x) {
+		cell.x -= 1;
+	}
+	if (ray_direction.y < 0 && cell.y == ray_origin.y) {
+		cell.y -= 1;
+	}
+	if (ray_direction.z < 0 && cell.z == ray_origin.z) {
+		cell.z -= 1;
+	}
+	return cell;
+}
+
+// Gets the distance along the ray at which it enters or exits a box.
+template <typename Vec3f_T>
+inline void get_box_entry_exit_distances(
+		Vec3f_T ray_origin,
+		Vec3f_T ray_direction,
+		Vector3i box_min,
+		Vector3i box_max,
+		float &out_entry_distance,
+		float &out_exit_distance
+) {
+	float entry = 0.f;
+	float exit = 9999999.f;
+	for (int i = 0; i < Vector3iUtil::AXIS_COUNT; ++i) {
+		if (ray_direction[i] > 0) {
+			entry = math::max(entry, float((box_min[i] - ray_origin[i]) / ray_direction[i]));
+			exit = math::min(exit, float((box_max[i] - ray_origin[i]) / ray_direction[i]));
+		} else if (ray_direction[i] < 0) {
+			entry = math::max(entry, float((box_max[i] - ray_origin[i]) / ray_direction[i]));
+			exit = math::min(exit, float((box_min[i] - ray_origin[i]) / ray_direction[i]));
+		}
+	}
+	out_entry_distance = entry;
+	out_exit_distance = exit;
+}
+
+} // namespace voxel_raycast_detail
+
+// Runs the DDA algorithm on two levels: blocks of `2^block_size_po2` cells are traversed first, and cells are only
+// traversed inside blocks that may contain a hit. This is much faster than `voxel_raycast` when many blocks can be
+// skipped at once, for example when they are uniformly empty.
+// `block_predicate(Vector3i block_position) -> bool` returns `true` if cells of the block have to be tested. It is
+// called before any cell of that block gets tested, so it can also be used to fetch block data.
+// `cell_predicate(VoxelRaycastState) -> bool` works the same as the predicate of `voxel_raycast`.
+// Like `voxel_raycast`, the cell containing the origin of the ray is not tested.
+template <typename Vec3f_T, typename BlockPredicate_F, typename CellPredicate_F>
+bool voxel_raycast_hierarchical(
+		Vec3f_T ray_origin,
+		Vec3f_T ray_direction,
+		const unsigned int block_size_po2,
+		BlockPredicate_F block_predicate,
+		CellPredicate_F cell_predicate,
+		real_t max_distance,
+		Vector3i &out_hit_pos,
+		Vector3i &out_prev_pos,
+		float &out_distance_along_ray,
+		float &out_distance_along_ray_prev
+) {
+	ZN_ASSERT_RETURN_V(!math::has_nan(ray_origin), false);
+	ZN_ASSERT_RETURN_V(!math::has_nan(ray_direction), false);
+	ZN_ASSERT_RETURN_V(!math::is_nan(max_distance), false);
+	ZN_ASSERT_RETURN_V(math::is_normalized(ray_direction), false);
+
+	const int block_size = 1 << block_size_po2;
+	const real_t inv_block_size = 1.0 / block_size;
+
+	// Tests cells of one block. `entry_distance` is where the ray enters the block, and `prev_bpos` is the block it
+	// comes from.
+	auto test_block = [&](const Vector3i bpos, const float entry_distance, const Vector3i prev_bpos) {
+		if (!block_predicate(bpos)) {
+			return false;
+		}
+
+		const Vector3i block_min = bpos << block_size_po2;
+		const Vector3i block_max = block_min + Vector3iUtil::create(block_size);
+
+		float unused_entry_distance;
+		float exit_distance;
+		voxel_raycast_detail::get_box_entry_exit_distances(
+				ray_origin, ray_direction, block_min, block_max, unused_entry_distance, exit_distance
+		);
+		exit_distance = math::min(exit_distance, float(max_distance));
+
+		const Vec3f_T entry_pos = ray_origin + ray_direction * entry_distance;
+
+		if (bpos != prev_bpos) {
+			// The cell where the ray enters the block would be skipped by a DDA starting from there, so test it first.
+			// Clamp, because the entry position is on the boundary of the block.
+			const Vector3i cell = math::clamp(math::floor_to_int(entry_pos), block_min, block_max - Vector3i(1, 1, 1));
+			const Vector3i prev_cell = cell - (bpos - prev_bpos);
+
+			float prev_cell_entry_distance;
+			float unused_exit_distance;
+			voxel_raycast_detail::get_box_entry_exit_distances(
+					ray_origin,
+					ray_direction,
+					prev_cell,
+					prev_cell + Vector3i(1, 1, 1),
+					prev_cell_entry_distance,
+					unused_exit_distance
+			);
+
+			if (cell_predicate(VoxelRaycastState{ prev_cell, prev_cell_entry_distance, cell, entry_distance })) {
+				out_hit_pos = cell;
+				out_prev_pos = prev_cell;
+				out_distance_along_ray = entry_distance;
+				out_distance_along_ray_prev = prev_cell_entry_distance;
+				return true;
+			}
+		}
+
+		// Cells of the block, with distances relative to the ray origin
+		auto local_cell_predicate = [&](const VoxelRaycastState &rs) {
+			const Vector3i p = rs.hit_position;
+			if (p.x < block_min.x || p.y < block_min.y || p.z < block_min.z || p.x >= block_max.x ||
+				p.y >= block_max.y || p.z >= block_max.z) {
+				// Can happen at the exit due to precision
+				return false;
+			}
+			return cell_predicate(VoxelRaycastState{
+					rs.hit_prev_position,
+					rs.prev_distance + entry_distance,
+					rs.hit_position,
+					rs.distance + entry_distance //
+			});
+		};
+
+		if (voxel_raycast(
+					entry_pos,
+					ray_direction,
+					local_cell_predicate,
+					exit_distance - entry_distance,
+					out_hit_pos,
+					out_prev_pos,
+					out_distance_along_ray,
+					out_distance_along_ray_prev
+			)) {
+			out_distance_along_ray += entry_distance;
+			out_distance_along_ray_prev += entry_distance;
+			return true;
+		}
+
+		return false;
+	};
+
+	const Vec3f_T block_ray_origin = ray_origin * inv_block_size;
+
+	// `voxel_raycast` doesn't test the block containing the origin, so do it first
+	const Vector3i origin_block_position = voxel_raycast_detail::get_start_cell(block_ray_origin, ray_direction);
+	if (test_block(origin_block_position, 0.f, origin_block_position)) {
+		return true;
+	}
+
+	auto block_raycast_predicate = [&](const VoxelRaycastState &rs) {
+		return test_block(rs.hit_position, rs.distance * block_size, rs.hit_prev_position);
+	};
+
+	Vector3i unused_hit_block_position;
+	Vector3i unused_prev_block_position;
+	float unused_block_distance;
+	float unused_prev_block_distance;
+
+	// Outputs are set by `test_block` when it returns `true`
+	return voxel_raycast(
+			block_ray_origin,
+			ray_direction,
+			block_raycast_predicate,
+			max_distance * inv_block_size,
+			unused_hit_block_position,
+			unused_prev_block_position,
+			unused_block_distance,
+			unused_prev_block_distance
+	);
+}
+
 } // namespace zylann